@@ -0,0 +1,175 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * drmaa_job_monitor.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * The DrmaaJobMonitor is a single background thread per process that
+ * tracks the jobs submitted through the process's DRMAA session. It
+ * reaps finished jobs with drmaa_wait () and stores their statuses in
+ * a table keyed by job id so that status requests can be answered
+ * without asking the scheduler. Jobs that are still queued are checked
+ * with a single drmaa_job_ps () call each per poll interval, regardless
+ * of how many times their statuses are requested.
+ *
+ * The monitor reaps every job in the session, so whilst it is running
+ * nothing else may call drmaa_wait () or drmaa_synchronize (). Use
+ * WaitForDrmaaJobMonitorStatus () instead.
+ */
+
+#ifndef DRMAA_JOB_MONITOR_H_
+#define DRMAA_JOB_MONITOR_H_
+
+#include "drmaa_library.h"
+#include "typedefs.h"
+#include "operation.h"
+
+
+/**
+ * The default number of milliseconds between checks on
+ * jobs that are still queued.
+ *
+ * @ingroup drmaa_group
+ */
+#define DRMAA_JOB_MONITOR_DEFAULT_POLL_INTERVAL_MS (2000)
+
+
+/**
+ * The number of seconds that the status of a finished job
+ * is kept for before it is removed from the table.
+ *
+ * @ingroup drmaa_group
+ */
+#define DRMAA_JOB_MONITOR_RETENTION_S (3600)
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Start the DrmaaJobMonitor. This must be called after
+ * drmaa_init () has succeeded and is called by InitDrmaa ().
+ *
+ * @param poll_interval_ms The number of milliseconds between checks on
+ * jobs that are still queued. If this is 0, then
+ * DRMAA_JOB_MONITOR_DEFAULT_POLL_INTERVAL_MS will be used.
+ * @return <code>true</code> if the monitor was started successfully
+ * or was already running, <code>false</code> upon error.
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API bool StartDrmaaJobMonitor (const uint32 poll_interval_ms);
+
+
+/**
+ * Stop the DrmaaJobMonitor and clear its table. This must be called
+ * before drmaa_exit () and is called by ExitDrmaa ().
+ *
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API void StopDrmaaJobMonitor (void);
+
+
+/**
+ * Check whether the DrmaaJobMonitor is running.
+ *
+ * @return <code>true</code> if the monitor is running, <code>false</code> otherwise.
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API bool IsDrmaaJobMonitorRunning (void);
+
+
+/**
+ * Register a newly-submitted job with the DrmaaJobMonitor.
+ *
+ * @param job_id_s The DRMAA id of the job.
+ * @return <code>true</code> if the job was registered successfully,
+ * <code>false</code> upon error.
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API bool AddJobToDrmaaJobMonitor (const char *job_id_s);
+
+
+/**
+ * Register a job that was submitted earlier, possibly by another process,
+ * such as when a DrmaaTool is recreated from its JSON. The job's current
+ * status is got from the scheduler first and, since drmaa_wait () may not
+ * be able to reap it, it is checked every poll interval until it finishes.
+ *
+ * @param job_id_s The DRMAA id of the job.
+ * @return <code>true</code> if the job was registered successfully or was
+ * already known, <code>false</code> if the scheduler could not give its
+ * status or upon error.
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API bool RestoreJobInDrmaaJobMonitor (const char *job_id_s);
+
+
+/**
+ * Get the latest status of a job from the DrmaaJobMonitor. This
+ * does not make any calls to the scheduler.
+ *
+ * @param job_id_s The DRMAA id of the job.
+ * @param status_p If the job is known, its status will be stored here.
+ * @param exit_code_p If this is not <code>NULL</code> and the job has
+ * finished, its exit code will be stored here. If the job has not finished or
+ * was killed by a signal, this will be set to -1.
+ * @return <code>true</code> if the job is in the monitor's table,
+ * <code>false</code> otherwise.
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API bool GetDrmaaJobMonitorStatus (const char *job_id_s, OperationStatus *status_p, int *exit_code_p);
+
+
+/**
+ * Block until the DrmaaJobMonitor has seen a job finish.
+ *
+ * @param job_id_s The DRMAA id of the job.
+ * @param status_p The final status of the job will be stored here.
+ * @param exit_code_p If this is not <code>NULL</code>, the job's exit
+ * code will be stored here.
+ * @return <code>true</code> if the job finished, <code>false</code> if
+ * the job is not known or the monitor was stopped before it finished.
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API bool WaitForDrmaaJobMonitorStatus (const char *job_id_s, OperationStatus *status_p, int *exit_code_p);
+
+
+/**
+ * Convert a DRMAA program status, as returned by drmaa_job_ps (),
+ * into the equivalent OperationStatus.
+ *
+ * @param drmaa_status The DRMAA_PS_* value.
+ * @return The OperationStatus.
+ * @ingroup drmaa_group
+ */
+GRASSROOTS_DRMAA_API OperationStatus ConvertDrmaaProgramStatus (const int drmaa_status);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRMAA_JOB_MONITOR_H_ */
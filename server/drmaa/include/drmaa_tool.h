@@ -40,6 +40,22 @@
  */
 #define DRMAA_ID_BUFFER_SIZE (256)
 
+
+/**
+ * When a DrmaaTool runs a job array, DRMAA replaces this placeholder
+ * with each task's index. This is the standard DRMAA_PLACEHOLDER_INCR
+ * value so that it can be used without including drmaa.h.
+ *
+ * DRMAA only guarantees the replacement in the input, output and error
+ * paths and the working directory. Whether it happens in the program's
+ * arguments depends on the DRMAA implementation, so a task should get
+ * its index from the scheduler's environment, e.g. SGE_TASK_ID or
+ * SLURM_ARRAY_TASK_ID, rather than from an argument.
+ *
+ * @ingroup drmaa_group
+ */
+#define DRMAA_TOOL_TASK_INDEX_PLACEHOLDER_S "$drmaa_incr_ph$"
+
 /* forward declaration */
 struct drmaa_job_template_s;
 
@@ -78,6 +94,32 @@ typedef struct DrmaaTool
 
 	char *dt_environment_s;
 
+	/**
+	 * If this DrmaaTool runs a job array, these are the first and last
+	 * task indexes and the increment between them. For a single job,
+	 * dt_array_end is 0.
+	 */
+	uint32 dt_array_start;
+	uint32 dt_array_end;
+	uint32 dt_array_step;
+
+	/** The DRMAA ids for each task of a submitted job array. */
+	char **dt_task_ids_ss;
+
+	/** The number of entries in dt_task_ids_ss. */
+	uint32 dt_num_tasks;
+
+	/**
+	 * The status of a single job once it has finished, OS_IDLE until then.
+	 * The DrmaaJobMonitor forgets finished jobs after DRMAA_JOB_MONITOR_RETENTION_S
+	 * and the scheduler can't report on jobs that have been reaped, so this
+	 * is what GetDrmaaToolStatus () returns from then on.
+	 */
+	OperationStatus dt_final_status;
+
+	/** The final statuses of each task of a job array, as for dt_final_status. */
+	OperationStatus *dt_final_task_statuses_p;
+
 	bool (*dt_run_fn) (struct DrmaaTool *tool_p, const bool async_flag);
 
 	OperationStatus (*dt_get_status_fn) (struct DrmaaTool *tool_p);
@@ -291,6 +333,59 @@ GRASSROOTS_DRMAA_API bool SetDrmaaToolOutputFilename (DrmaaTool *tool_p, const c
 GRASSROOTS_DRMAA_API bool AddDrmaaToolArgument (DrmaaTool *tool_p, const char *arg_s);
 
 
+/**
+ * Make a DrmaaTool run its program as a job array with a task for
+ * each index from start to end inclusive, stepping by step. This
+ * uses a single submission to the scheduler rather than one per task.
+ *
+ * If an output filename is set, each task writes to the output filename
+ * with ".<task index>" appended. Any DRMAA_TOOL_TASK_INDEX_PLACEHOLDER_S in
+ * the arguments is passed to the scheduler unchanged and is only replaced
+ * if the DRMAA implementation does so, see DRMAA_TOOL_TASK_INDEX_PLACEHOLDER_S.
+ *
+ * @param tool_p The DrmaaTool to set the job array for.
+ * @param start The first task index. This must be at least 1.
+ * @param end The last task index. If this is 0, then the DrmaaTool will run a single job.
+ * @param step The increment between consecutive task indexes. This must be at least 1.
+ * @return <code>true</code> if the job array was set successfully, <code>false</code> otherwise.
+ * @memberof DrmaaTool
+ */
+GRASSROOTS_DRMAA_API bool SetDrmaaToolJobArray (DrmaaTool *tool_p, const uint32 start, const uint32 end, const uint32 step);
+
+
+/**
+ * Check whether a DrmaaTool runs a job array.
+ *
+ * @param tool_p The DrmaaTool to check.
+ * @return <code>true</code> if the DrmaaTool runs a job array, <code>false</code> otherwise.
+ * @memberof DrmaaTool
+ */
+GRASSROOTS_DRMAA_API bool IsDrmaaToolJobArray (const DrmaaTool *tool_p);
+
+
+/**
+ * Get the number of tasks that were submitted for a DrmaaTool's job array.
+ *
+ * @param tool_p The DrmaaTool to check.
+ * @return The number of tasks or 0 if the job array has not been submitted
+ * or the DrmaaTool runs a single job.
+ * @memberof DrmaaTool
+ */
+GRASSROOTS_DRMAA_API uint32 GetDrmaaToolNumTasks (const DrmaaTool *tool_p);
+
+
+/**
+ * Get the status of a single task in a DrmaaTool's job array.
+ *
+ * @param tool_p The DrmaaTool to get the task status for.
+ * @param task_index The 0-based position of the task within the submitted
+ * tasks, not its job array index.
+ * @return The current status of the task.
+ * @memberof DrmaaTool
+ */
+GRASSROOTS_DRMAA_API OperationStatus GetDrmaaToolTaskStatus (DrmaaTool *tool_p, const uint32 task_index);
+
+
 /**
  * Run a DrmaaTool.
  *
@@ -310,6 +405,15 @@ GRASSROOTS_DRMAA_API bool RunDrmaaTool (DrmaaTool *tool_p, const bool async_flag
 /**
  * Get the status of job for a DrmaaTool
  *
+ * If the job is being tracked by the DrmaaJobMonitor, its status
+ * is taken from there without querying the scheduler.
+ *
+ * For a job array, the statuses of the tasks are combined. While any
+ * task is still to finish, this is OS_STARTED if any task has started
+ * and OS_PENDING otherwise. Once all of the tasks have finished, this is
+ * OS_SUCCEEDED if they all succeeded, OS_FAILED if none of them did and
+ * OS_PARTIALLY_SUCCEEDED for anything in between.
+ *
  * @param tool_p The DrmaaTool to get the job status for.
  * @return The current status of the job for this DrmaaTool.
  * @memberof DrmaaTool
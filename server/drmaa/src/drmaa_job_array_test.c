@@ -0,0 +1,328 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * drmaa_job_array_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Test for DrmaaTool job arrays using the stand-in DRMAA library. A job
+ *  array is run and the test checks each task's command line and status,
+ *  that the statuses survive a round trip through JSON without asking the
+ *  scheduler again, that each task's empty output file is removed and that
+ *  restored jobs which are still running or unknown are tracked correctly.
+ *
+ *  Usage: drmaa_job_array_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "drmaa_stub.h"
+#include "drmaa_job_monitor.h"
+#include "drmaa_tool.h"
+#include "json_util.h"
+#include "schema_keys.h"
+#include "unit_test.h"
+
+
+#define NUM_TASKS (4)
+
+#define ARRAY_START (1)
+
+#define ARRAY_END (10)
+
+#define ARRAY_STEP (3)
+
+
+static char s_dir_s [] = "/tmp/drmaa_job_array_test_XXXXXX";
+
+
+static DrmaaTool *CreateEchoTool (const char *arg_s, const char *output_filename_s)
+{
+	DrmaaTool *tool_p;
+	uuid_t id;
+
+	uuid_generate (id);
+
+	tool_p = AllocateDrmaaTool ("/bin/echo", id, NULL);
+
+	if (tool_p)
+		{
+			if (AddDrmaaToolArgument (tool_p, arg_s) && SetDrmaaToolOutputFilename (tool_p, output_filename_s))
+				{
+					return tool_p;
+				}
+
+			FreeDrmaaTool (tool_p);
+		}
+
+	return NULL;
+}
+
+
+static void GetTaskFilename (char *filename_s, const size_t length, const uint32 task_index)
+{
+	snprintf (filename_s, length, "%s/out." UINT32_FMT, s_dir_s, task_index);
+}
+
+
+static bool CreateTaskFile (const uint32 task_index, const char *contents_s)
+{
+	char filename_s [256];
+	FILE *out_f;
+
+	GetTaskFilename (filename_s, sizeof (filename_s), task_index);
+	out_f = fopen (filename_s, "w");
+
+	if (out_f)
+		{
+			fputs (contents_s, out_f);
+			return (fclose (out_f) == 0);
+		}
+
+	return false;
+}
+
+
+static bool DoesTaskFileExist (const uint32 task_index)
+{
+	char filename_s [256];
+
+	GetTaskFilename (filename_s, sizeof (filename_s), task_index);
+
+	return (access (filename_s, F_OK) == 0);
+}
+
+
+static void TestJobArray (const char *output_filename_s)
+{
+	DrmaaTool *tool_p = CreateEchoTool (DRMAA_PLACEHOLDER_INCR, output_filename_s);
+
+	if (tool_p)
+		{
+			Check (SetDrmaaToolJobArray (tool_p, ARRAY_START, ARRAY_END, ARRAY_STEP) && IsDrmaaToolJobArray (tool_p), "set the job array range");
+			Check (RunDrmaaTool (tool_p, false, NULL), "run the job array and wait for it");
+
+			if (GetDrmaaToolNumTasks (tool_p) == NUM_TASKS)
+				{
+					json_t *tool_json_p;
+					bool command_lines_flag = true;
+					bool statuses_flag = true;
+					uint32 i;
+
+					for (i = 0; i < NUM_TASKS; ++ i)
+						{
+							const uint32 task_index = ARRAY_START + (i * ARRAY_STEP);
+							char expected_s [64];
+							char command_line_s [256];
+
+							/* Every third job that the stand-in library runs fails */
+							const OperationStatus expected_status = (((i + 1) % 3) == 0) ? OS_FAILED : OS_SUCCEEDED;
+
+							snprintf (expected_s, sizeof (expected_s), "/bin/echo " UINT32_FMT, task_index);
+
+							if ((drmaa_stub_get_job_command_line (* ((tool_p -> dt_task_ids_ss) + i), command_line_s, sizeof (command_line_s)) != DRMAA_ERRNO_SUCCESS) || (strcmp (command_line_s, expected_s) != 0))
+								{
+									command_lines_flag = false;
+								}
+
+							if (GetDrmaaToolTaskStatus (tool_p, i) != expected_status)
+								{
+									statuses_flag = false;
+								}
+						}
+
+					Check (command_lines_flag, "substitute each task's index into its arguments");
+					Check (statuses_flag, "get each task's status");
+					Check (GetDrmaaToolStatus (tool_p) == OS_PARTIALLY_SUCCEEDED, "combine the task statuses");
+
+					tool_json_p = ConvertDrmaaToolToJSON (tool_p);
+
+					if (tool_json_p)
+						{
+							const json_t *array_json_p = json_object_get (tool_json_p, DRMAA_ARRAY_S);
+							DrmaaTool *restored_tool_p;
+
+							Check (json_object_get (array_json_p, DRMAA_ARRAY_TASK_ID_PREFIX_S) && !json_object_get (array_json_p, DRMAA_ARRAY_TASK_IDS_S), "store the task ids as a pattern");
+							Check (json_array_size (json_object_get (array_json_p, DRMAA_ARRAY_TASK_FINAL_STATUSES_S)) == NUM_TASKS, "store the final task statuses");
+
+							restored_tool_p = ConvertDrmaaToolFromJSON (tool_json_p, NULL);
+
+							if (restored_tool_p)
+								{
+									const unsigned long num_ps_calls = drmaa_stub_get_num_job_ps_calls ();
+									bool ids_flag = (GetDrmaaToolNumTasks (restored_tool_p) == NUM_TASKS);
+
+									for (i = 0; ids_flag && (i < NUM_TASKS); ++ i)
+										{
+											ids_flag = (strcmp (* ((restored_tool_p -> dt_task_ids_ss) + i), * ((tool_p -> dt_task_ids_ss) + i)) == 0);
+										}
+
+									Check (ids_flag, "restore the task ids");
+									Check (GetDrmaaToolStatus (restored_tool_p) == OS_PARTIALLY_SUCCEEDED, "restore the job array's status");
+									Check (drmaa_stub_get_num_job_ps_calls () == num_ps_calls, "don't ask the scheduler about tasks that have finished");
+
+									/* The stand-in library doesn't write any output so make some */
+									CreateTaskFile (1, "");
+									CreateTaskFile (4, "some output\n");
+									CreateTaskFile (7, "");
+									CreateTaskFile (10, "");
+
+									FreeDrmaaTool (restored_tool_p);
+
+									Check (!DoesTaskFileExist (1) && DoesTaskFileExist (4) && !DoesTaskFileExist (7) && !DoesTaskFileExist (10), "remove the tasks' empty output files");
+								}
+							else
+								{
+									Check (false, "restore the job array from JSON");
+								}
+
+							json_decref (tool_json_p);
+						}
+					else
+						{
+							Check (false, "convert the job array to JSON");
+						}
+				}
+			else
+				{
+					Check (false, "submit one job for each task");
+				}
+
+			FreeDrmaaTool (tool_p);
+		}
+	else
+		{
+			Check (false, "create the job array");
+		}
+}
+
+
+/*
+ * Simulate a job submitted by an earlier server process by running it
+ * whilst the monitor is stopped, so that the monitor only learns about
+ * it when it is restored from JSON.
+ */
+static void TestRestoredJobs (const char *output_filename_s)
+{
+	DrmaaTool *tool_p = CreateEchoTool ("restored", output_filename_s);
+
+	if (tool_p)
+		{
+			json_t *tool_json_p = NULL;
+
+			StopDrmaaJobMonitor ();
+
+			Check (RunDrmaaTool (tool_p, true, NULL), "submit a job whilst the monitor is stopped");
+
+			tool_json_p = ConvertDrmaaToolToJSON (tool_p);
+
+			Check (StartDrmaaJobMonitor (DRMAA_JOB_MONITOR_DEFAULT_POLL_INTERVAL_MS / 20), "restart the monitor");
+
+			if (tool_json_p)
+				{
+					DrmaaTool *restored_tool_p = ConvertDrmaaToolFromJSON (tool_json_p, NULL);
+
+					if (restored_tool_p)
+						{
+							OperationStatus status = OS_IDLE;
+							int i;
+
+							Check (GetDrmaaJobMonitorStatus (restored_tool_p -> dt_id_s, &status, NULL) && (status != OS_ERROR) && (status != OS_IDLE), "seed a restored job's status from the scheduler");
+
+							for (i = 0; (i < 100) && !((status == OS_SUCCEEDED) || (status == OS_FAILED)); ++ i)
+								{
+									usleep (20000);
+									status = GetDrmaaToolStatus (restored_tool_p);
+								}
+
+							Check (status == OS_SUCCEEDED, "follow a restored job until it finishes");
+
+							FreeDrmaaTool (restored_tool_p);
+						}
+					else
+						{
+							Check (false, "restore the job from JSON");
+						}
+
+					/* A job that the scheduler has never heard of */
+					json_object_set_new (tool_json_p, DRMAA_ID_S, json_string ("unknown.1"));
+					json_object_del (tool_json_p, DRMAA_FINAL_STATUS_S);
+
+					restored_tool_p = ConvertDrmaaToolFromJSON (tool_json_p, NULL);
+
+					if (restored_tool_p)
+						{
+							OperationStatus status;
+
+							Check (!GetDrmaaJobMonitorStatus ("unknown.1", &status, NULL), "don't track a restored job that the scheduler doesn't know");
+							Check (GetDrmaaToolStatus (restored_tool_p) == OS_ERROR, "report an error for an unknown job");
+
+							FreeDrmaaTool (restored_tool_p);
+						}
+
+					json_decref (tool_json_p);
+				}
+			else
+				{
+					Check (false, "convert the job to JSON");
+				}
+
+			FreeDrmaaTool (tool_p);
+		}
+	else
+		{
+			Check (false, "create the job");
+		}
+}
+
+
+int main (int UNUSED_PARAM (argc), char ** UNUSED_PARAM (argv))
+{
+	setenv ("DRMAA_STUB_QUEUE_MS", "50", 0);
+	setenv ("DRMAA_STUB_RUN_MS", "100", 0);
+	setenv ("DRMAA_STUB_FAIL_EVERY", "3", 1);
+
+	if (mkdtemp (s_dir_s))
+		{
+			if (InitDrmaa ())
+				{
+					char output_filename_s [256];
+
+					snprintf (output_filename_s, sizeof (output_filename_s), "%s/out", s_dir_s);
+
+					TestJobArray (output_filename_s);
+					TestRestoredJobs (output_filename_s);
+
+					ExitDrmaa ();
+				}
+			else
+				{
+					Check (false, "initialise DRMAA");
+				}
+
+			rmdir (s_dir_s);
+		}
+	else
+		{
+			Check (false, "create the output directory");
+		}
+
+	return GetTestResult ();
+}
@@ -0,0 +1,848 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * drmaa_job_monitor.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "drmaa.h"
+#include "drmaa_job_monitor.h"
+#include "hash_map.h"
+#include "memory_allocations.h"
+#include "streams.h"
+#include "string_utils.h"
+
+
+#ifdef _DEBUG
+	#define DRMAA_JOB_MONITOR_DEBUG (STM_LEVEL_FINE)
+#else
+	#define DRMAA_JOB_MONITOR_DEBUG (STM_LEVEL_NONE)
+#endif
+
+
+/**
+ * How long, in seconds, each call to drmaa_wait () blocks for. This
+ * bounds how long StopDrmaaJobMonitor () can take.
+ */
+#define S_WAIT_TIMEOUT_S (1)
+
+
+/**
+ * The initial capacity of the table of jobs.
+ */
+#define S_INITIAL_NUM_JOBS (256)
+
+
+typedef struct DrmaaJobNode
+{
+	OperationStatus djn_status;
+	int djn_exit_code;
+	time_t djn_updated;
+
+	/**
+	 * Set for jobs that drmaa_wait () may not be able to reap, such as
+	 * those submitted by an earlier server process, so that the poller
+	 * gets their final statuses too.
+	 */
+	bool djn_polled_flag;
+} DrmaaJobNode;
+
+
+static pthread_mutex_t s_monitor_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_monitor_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_wait_thread;
+static pthread_t s_poll_thread;
+
+static bool s_running_flag = false;
+static bool s_stop_flag = false;
+static uint32 s_poll_interval_ms = DRMAA_JOB_MONITOR_DEFAULT_POLL_INTERVAL_MS;
+
+/** The DrmaaJobNodes keyed by their job ids */
+static HashMap *s_jobs_p = NULL;
+
+/** The number of jobs in s_jobs_p that have not finished yet */
+static uint32 s_num_active_jobs = 0;
+
+/** Set when drmaa_wait () reports that there are no jobs left in the session to reap */
+static bool s_session_empty_flag = false;
+
+
+static void *RunDrmaaJobWaiter (void *data_p);
+
+static void *RunDrmaaJobPoller (void *data_p);
+
+static DrmaaJobNode *AddDrmaaJobNode (const char *job_id_s);
+
+static void FreeDrmaaJobNode (void *node_p);
+
+static DrmaaJobNode *FindDrmaaJobNode (const char *job_id_s);
+
+static void SetDrmaaJobNodeStatus (DrmaaJobNode *node_p, const OperationStatus status, const int exit_code);
+
+static bool IsFinishedStatus (const OperationStatus status);
+
+static void ReapFinishedJob (const char *job_id_s, const int stat);
+
+static void CheckQueuedJobs (const bool accept_finished_flag);
+
+static void PruneFinishedJobs (void);
+
+static void GetTimeoutFromNow (struct timespec *time_p, const uint32 interval_ms);
+
+
+/*
+ * API FUNCTIONS
+ */
+
+
+bool StartDrmaaJobMonitor (const uint32 poll_interval_ms)
+{
+	bool success_flag = true;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	if (!s_running_flag)
+		{
+			int res = ENOMEM;
+
+			s_jobs_p = AllocateHashMap (S_INITIAL_NUM_JOBS, 75, HMKT_STRING, MF_DEEP_COPY, MF_SHALLOW_COPY);
+			s_num_active_jobs = 0;
+
+			s_poll_interval_ms = (poll_interval_ms > 0) ? poll_interval_ms : DRMAA_JOB_MONITOR_DEFAULT_POLL_INTERVAL_MS;
+			s_session_empty_flag = false;
+			s_stop_flag = false;
+
+			if (s_jobs_p)
+				{
+					SetHashMapValueFunctions (s_jobs_p, NULL, FreeDrmaaJobNode);
+
+					res = pthread_create (&s_wait_thread, NULL, RunDrmaaJobWaiter, NULL);
+
+					if (res == 0)
+						{
+							res = pthread_create (&s_poll_thread, NULL, RunDrmaaJobPoller, NULL);
+
+							if (res == 0)
+								{
+									s_running_flag = true;
+								}
+							else
+								{
+									s_stop_flag = true;
+									pthread_mutex_unlock (&s_monitor_mutex);
+									pthread_join (s_wait_thread, NULL);
+									pthread_mutex_lock (&s_monitor_mutex);
+								}
+						}
+
+					if (res != 0)
+						{
+							FreeHashMap (s_jobs_p);
+							s_jobs_p = NULL;
+						}
+				}
+
+			if (res != 0)
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to start DRMAA job monitor threads, error %d", res);
+					success_flag = false;
+				}
+		}
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+
+	return success_flag;
+}
+
+
+void StopDrmaaJobMonitor (void)
+{
+	bool join_flag = false;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	if (s_running_flag)
+		{
+			s_stop_flag = true;
+			join_flag = true;
+			pthread_cond_broadcast (&s_monitor_cond);
+		}
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+
+	if (join_flag)
+		{
+			pthread_join (s_wait_thread, NULL);
+			pthread_join (s_poll_thread, NULL);
+
+			pthread_mutex_lock (&s_monitor_mutex);
+
+			FreeHashMap (s_jobs_p);
+			s_jobs_p = NULL;
+			s_num_active_jobs = 0;
+			s_running_flag = false;
+
+			/* wake up anyone still in WaitForDrmaaJobMonitorStatus () */
+			pthread_cond_broadcast (&s_monitor_cond);
+
+			pthread_mutex_unlock (&s_monitor_mutex);
+		}
+}
+
+
+bool IsDrmaaJobMonitorRunning (void)
+{
+	bool running_flag;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+	running_flag = s_running_flag && !s_stop_flag;
+	pthread_mutex_unlock (&s_monitor_mutex);
+
+	return running_flag;
+}
+
+
+bool AddJobToDrmaaJobMonitor (const char *job_id_s)
+{
+	bool success_flag = false;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	if (s_running_flag && !s_stop_flag)
+		{
+			/*
+			 * The monitor thread may already have reaped the job
+			 * if it finished very quickly, so only add it if it
+			 * isn't there already.
+			 */
+			if (FindDrmaaJobNode (job_id_s))
+				{
+					success_flag = true;
+				}
+			else if (AddDrmaaJobNode (job_id_s))
+				{
+					pthread_cond_broadcast (&s_monitor_cond);
+					success_flag = true;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add job \"%s\" to DRMAA job monitor", job_id_s);
+				}
+		}
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+
+	return success_flag;
+}
+
+
+bool RestoreJobInDrmaaJobMonitor (const char *job_id_s)
+{
+	bool success_flag = false;
+
+	if (IsDrmaaJobMonitorRunning ())
+		{
+			char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
+			int drmaa_status;
+			int res = drmaa_job_ps (job_id_s, &drmaa_status, error_s, DRMAA_ERROR_STRING_BUFFER - 1);
+
+			if (res == DRMAA_ERRNO_SUCCESS)
+				{
+					const OperationStatus status = ConvertDrmaaProgramStatus (drmaa_status);
+
+					if (status != OS_ERROR)
+						{
+							pthread_mutex_lock (&s_monitor_mutex);
+
+							if (s_running_flag && !s_stop_flag)
+								{
+									/* Keep the status of a job that this process has already seen */
+									if (FindDrmaaJobNode (job_id_s))
+										{
+											success_flag = true;
+										}
+									else
+										{
+											DrmaaJobNode *node_p = AddDrmaaJobNode (job_id_s);
+
+											if (node_p)
+												{
+													node_p -> djn_polled_flag = true;
+													SetDrmaaJobNodeStatus (node_p, status, -1);
+
+													pthread_cond_broadcast (&s_monitor_cond);
+													success_flag = true;
+												}
+											else
+												{
+													PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add job \"%s\" to DRMAA job monitor", job_id_s);
+												}
+										}
+								}
+
+							pthread_mutex_unlock (&s_monitor_mutex);
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get drmaa ps for %s: %d, error: %s", job_id_s, res, error_s);
+				}
+		}
+
+	return success_flag;
+}
+
+
+bool GetDrmaaJobMonitorStatus (const char *job_id_s, OperationStatus *status_p, int *exit_code_p)
+{
+	bool found_flag = false;
+	DrmaaJobNode *node_p;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	node_p = s_running_flag ? FindDrmaaJobNode (job_id_s) : NULL;
+
+	if (node_p)
+		{
+			*status_p = node_p -> djn_status;
+
+			if (exit_code_p)
+				{
+					*exit_code_p = node_p -> djn_exit_code;
+				}
+
+			found_flag = true;
+		}
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+
+	return found_flag;
+}
+
+
+bool WaitForDrmaaJobMonitorStatus (const char *job_id_s, OperationStatus *status_p, int *exit_code_p)
+{
+	bool finished_flag = false;
+	bool loop_flag = true;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	while (loop_flag)
+		{
+			DrmaaJobNode *node_p = s_running_flag ? FindDrmaaJobNode (job_id_s) : NULL;
+
+			if (node_p)
+				{
+					if (IsFinishedStatus (node_p -> djn_status))
+						{
+							*status_p = node_p -> djn_status;
+
+							if (exit_code_p)
+								{
+									*exit_code_p = node_p -> djn_exit_code;
+								}
+
+							finished_flag = true;
+							loop_flag = false;
+						}
+					else if (s_stop_flag)
+						{
+							loop_flag = false;
+						}
+					else
+						{
+							pthread_cond_wait (&s_monitor_cond, &s_monitor_mutex);
+						}
+				}
+			else
+				{
+					loop_flag = false;
+				}
+		}
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+
+	return finished_flag;
+}
+
+
+OperationStatus ConvertDrmaaProgramStatus (const int drmaa_status)
+{
+	OperationStatus status = OS_ERROR;
+
+	switch (drmaa_status)
+		{
+			case DRMAA_PS_QUEUED_ACTIVE:
+			case DRMAA_PS_SYSTEM_ON_HOLD:
+			case DRMAA_PS_USER_ON_HOLD:
+			case DRMAA_PS_USER_SYSTEM_ON_HOLD:
+				status = OS_PENDING;
+				break;
+
+			case DRMAA_PS_UNDETERMINED:
+				status = OS_ERROR;
+				break;
+
+			case DRMAA_PS_RUNNING:
+				status = OS_STARTED;
+				break;
+
+			case DRMAA_PS_FAILED:
+				status = OS_FAILED;
+				break;
+
+			case DRMAA_PS_DONE:
+				status = OS_SUCCEEDED;
+				break;
+
+			case DRMAA_PS_SYSTEM_SUSPENDED:
+			case DRMAA_PS_USER_SUSPENDED:
+			case DRMAA_PS_USER_SYSTEM_SUSPENDED:
+				status = OS_PENDING;
+				break;
+
+			default:
+				break;
+		}
+
+	return status;
+}
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+
+/*
+ * drmaa_wait () with DRMAA_JOB_IDS_SESSION_ANY returns as soon as any
+ * job in the session finishes so finished jobs are picked up straight
+ * away without any polling. Since this reaps every job in the session,
+ * nothing else may call drmaa_wait () or drmaa_synchronize () whilst
+ * the monitor is running.
+ */
+static void *RunDrmaaJobWaiter (void * UNUSED_PARAM (data_p))
+{
+	bool loop_flag = true;
+
+	while (loop_flag)
+		{
+			bool wait_flag = false;
+
+			pthread_mutex_lock (&s_monitor_mutex);
+
+			if (s_stop_flag)
+				{
+					loop_flag = false;
+				}
+			else if ((s_num_active_jobs == 0) || s_session_empty_flag)
+				{
+					struct timespec timeout;
+
+					GetTimeoutFromNow (&timeout, s_poll_interval_ms);
+					pthread_cond_timedwait (&s_monitor_cond, &s_monitor_mutex, &timeout);
+
+					/* A new job may have been submitted so try drmaa_wait () again */
+					s_session_empty_flag = false;
+				}
+			else
+				{
+					wait_flag = true;
+				}
+
+			pthread_mutex_unlock (&s_monitor_mutex);
+
+			if (wait_flag)
+				{
+					char job_id_s [DRMAA_JOBNAME_BUFFER] = { 0 };
+					char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
+					int stat = 0;
+					int res = drmaa_wait (DRMAA_JOB_IDS_SESSION_ANY, job_id_s, DRMAA_JOBNAME_BUFFER - 1, &stat, S_WAIT_TIMEOUT_S, NULL, error_s, DRMAA_ERROR_STRING_BUFFER - 1);
+
+					switch (res)
+						{
+							case DRMAA_ERRNO_SUCCESS:
+								ReapFinishedJob (job_id_s, stat);
+								break;
+
+							case DRMAA_ERRNO_EXIT_TIMEOUT:
+								break;
+
+							case DRMAA_ERRNO_INVALID_JOB:
+								/*
+								 * There are no jobs left in the session to wait on, so
+								 * any that we think are active must have been reaped
+								 * elsewhere. Let the poller pick up their final statuses.
+								 */
+								pthread_mutex_lock (&s_monitor_mutex);
+								s_session_empty_flag = true;
+								pthread_mutex_unlock (&s_monitor_mutex);
+								break;
+
+							default:
+								PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "drmaa_wait failed in DRMAA job monitor with code %d, \"%s\"", res, error_s);
+								break;
+						}
+				}
+		}
+
+	return NULL;
+}
+
+
+/*
+ * There is no DRMAA notification for a job moving from queued to
+ * running, so each unfinished job gets a single drmaa_job_ps () per
+ * poll interval regardless of how often its status is requested.
+ */
+static void *RunDrmaaJobPoller (void * UNUSED_PARAM (data_p))
+{
+	bool loop_flag = true;
+
+	while (loop_flag)
+		{
+			struct timespec timeout;
+			bool accept_finished_flag;
+
+			pthread_mutex_lock (&s_monitor_mutex);
+
+			GetTimeoutFromNow (&timeout, s_poll_interval_ms);
+
+			while ((!s_stop_flag) && (pthread_cond_timedwait (&s_monitor_cond, &s_monitor_mutex, &timeout) != ETIMEDOUT))
+				{
+					/* woken by a status change rather than the timeout, so keep waiting */
+				}
+
+			loop_flag = !s_stop_flag;
+			accept_finished_flag = s_session_empty_flag;
+
+			pthread_mutex_unlock (&s_monitor_mutex);
+
+			if (loop_flag)
+				{
+					CheckQueuedJobs (accept_finished_flag);
+					PruneFinishedJobs ();
+				}
+		}
+
+	return NULL;
+}
+
+
+static void ReapFinishedJob (const char *job_id_s, const int stat)
+{
+	char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
+	OperationStatus status = OS_FAILED;
+	int exit_code = -1;
+	int exited = 0;
+	DrmaaJobNode *node_p;
+
+	if (drmaa_wifexited (&exited, stat, error_s, DRMAA_ERROR_STRING_BUFFER - 1) == DRMAA_ERRNO_SUCCESS)
+		{
+			if (exited)
+				{
+					if (drmaa_wexitstatus (&exit_code, stat, error_s, DRMAA_ERROR_STRING_BUFFER - 1) == DRMAA_ERRNO_SUCCESS)
+						{
+							if (exit_code == 0)
+								{
+									status = OS_SUCCEEDED;
+								}
+						}
+				}
+		}
+
+	#if DRMAA_JOB_MONITOR_DEBUG >= STM_LEVEL_FINE
+	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "DRMAA job monitor reaped \"%s\" with status %d and exit code %d", job_id_s, status, exit_code);
+	#endif
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	node_p = FindDrmaaJobNode (job_id_s);
+
+	if (!node_p)
+		{
+			/*
+			 * The job finished before RunDrmaaTool () had a chance
+			 * to register it, so add it now.
+			 */
+			node_p = AddDrmaaJobNode (job_id_s);
+
+			if (!node_p)
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to store status for job \"%s\" in DRMAA job monitor", job_id_s);
+				}
+		}
+
+	if (node_p)
+		{
+			SetDrmaaJobNodeStatus (node_p, status, exit_code);
+		}
+
+	pthread_cond_broadcast (&s_monitor_cond);
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+}
+
+
+/*
+ * Get the ids of the jobs that need checking whilst holding
+ * the lock, then query the scheduler for each of them without
+ * holding it so that status readers aren't blocked.
+ *
+ * Normally only the move from queued to running is taken from
+ * drmaa_job_ps () since drmaa_wait () gives us the exit code for
+ * finished jobs. If accept_finished_flag is true, there is nothing
+ * left for drmaa_wait () to reap so finished statuses are stored too.
+ * Jobs restored with RestoreJobInDrmaaJobMonitor () might never be
+ * reaped by drmaa_wait () so they are always checked and are removed
+ * if the scheduler no longer knows about them.
+ */
+static void CheckQueuedJobs (const bool accept_finished_flag)
+{
+	char **ids_ss = NULL;
+	uint32 num_ids = 0;
+	uint32 i;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	if (s_num_active_jobs > 0)
+		{
+			ids_ss = (char **) AllocMemory (s_num_active_jobs * sizeof (char *));
+
+			if (ids_ss)
+				{
+					uint32 index = 0;
+					const void *key_p;
+					void *value_p;
+
+					while ((num_ids < s_num_active_jobs) && GetNextHashMapEntry (s_jobs_p, &index, &key_p, &value_p))
+						{
+							const DrmaaJobNode *node_p = (const DrmaaJobNode *) value_p;
+
+							/*
+							 * Running jobs only need checking if drmaa_wait () can't
+							 * tell us when they finish.
+							 */
+							if ((node_p -> djn_status == OS_PENDING) || ((accept_finished_flag || node_p -> djn_polled_flag) && !IsFinishedStatus (node_p -> djn_status)))
+								{
+									ids_ss [num_ids] = EasyCopyToNewString ((const char *) key_p);
+
+									if (ids_ss [num_ids])
+										{
+											++ num_ids;
+										}
+								}
+						}
+				}
+		}
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+
+	for (i = 0; i < num_ids; ++ i)
+		{
+			char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
+			OperationStatus status = OS_ERROR;
+			int drmaa_status;
+			int res = drmaa_job_ps (ids_ss [i], &drmaa_status, error_s, DRMAA_ERROR_STRING_BUFFER - 1);
+			DrmaaJobNode *node_p;
+
+			if (res == DRMAA_ERRNO_SUCCESS)
+				{
+					status = ConvertDrmaaProgramStatus (drmaa_status);
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get drmaa ps for %s: %d, error: %s", ids_ss [i], res, error_s);
+				}
+
+			pthread_mutex_lock (&s_monitor_mutex);
+
+			node_p = FindDrmaaJobNode (ids_ss [i]);
+
+			/* Don't overwrite a status that drmaa_wait () has set in the meantime */
+			if (node_p && !IsFinishedStatus (node_p -> djn_status))
+				{
+					if (status != OS_ERROR)
+						{
+							if (accept_finished_flag || node_p -> djn_polled_flag || !IsFinishedStatus (status))
+								{
+									SetDrmaaJobNodeStatus (node_p, status, -1);
+								}
+						}
+					else if (node_p -> djn_polled_flag)
+						{
+							/*
+							 * Nothing will ever update this job's status so remove it
+							 * and let status requests go to the scheduler instead.
+							 */
+							if (s_num_active_jobs > 0)
+								{
+									-- s_num_active_jobs;
+								}
+
+							RemoveFromHashMap (s_jobs_p, ids_ss [i]);
+						}
+				}
+
+			pthread_cond_broadcast (&s_monitor_cond);
+
+			pthread_mutex_unlock (&s_monitor_mutex);
+
+			FreeCopiedString (ids_ss [i]);
+		}
+
+	if (ids_ss)
+		{
+			FreeMemory (ids_ss);
+		}
+}
+
+
+static void PruneFinishedJobs (void)
+{
+	const time_t cutoff = time (NULL) - DRMAA_JOB_MONITOR_RETENTION_S;
+	uint32 num_jobs;
+
+	pthread_mutex_lock (&s_monitor_mutex);
+
+	num_jobs = GetHashMapSize (s_jobs_p);
+
+	if (num_jobs > s_num_active_jobs)
+		{
+			const char **ids_ss = (const char **) AllocMemoryArray (num_jobs - s_num_active_jobs, sizeof (const char *));
+
+			if (ids_ss)
+				{
+					uint32 num_expired = 0;
+					uint32 index = 0;
+					const void *key_p;
+					void *value_p;
+
+					/* The HashMap can't be changed whilst stepping through it so remove the entries afterwards */
+					while ((num_expired < num_jobs - s_num_active_jobs) && GetNextHashMapEntry (s_jobs_p, &index, &key_p, &value_p))
+						{
+							const DrmaaJobNode *node_p = (const DrmaaJobNode *) value_p;
+
+							if (IsFinishedStatus (node_p -> djn_status) && (node_p -> djn_updated < cutoff))
+								{
+									ids_ss [num_expired] = (const char *) key_p;
+									++ num_expired;
+								}
+						}
+
+					while (num_expired > 0)
+						{
+							-- num_expired;
+							RemoveFromHashMap (s_jobs_p, ids_ss [num_expired]);
+						}
+
+					FreeMemory (ids_ss);
+				}
+		}
+
+	pthread_mutex_unlock (&s_monitor_mutex);
+}
+
+
+/*
+ * This must be called with s_monitor_mutex held
+ */
+static DrmaaJobNode *AddDrmaaJobNode (const char *job_id_s)
+{
+	DrmaaJobNode *node_p = (DrmaaJobNode *) AllocMemory (sizeof (DrmaaJobNode));
+
+	if (node_p)
+		{
+			node_p -> djn_status = OS_PENDING;
+			node_p -> djn_exit_code = -1;
+			node_p -> djn_updated = time (NULL);
+			node_p -> djn_polled_flag = false;
+
+			if (PutInHashMap (s_jobs_p, job_id_s, node_p))
+				{
+					++ s_num_active_jobs;
+					return node_p;
+				}
+
+			FreeMemory (node_p);
+		}
+
+	return NULL;
+}
+
+
+static void FreeDrmaaJobNode (void *node_p)
+{
+	FreeMemory (node_p);
+}
+
+
+/*
+ * This must be called with s_monitor_mutex held
+ */
+static DrmaaJobNode *FindDrmaaJobNode (const char *job_id_s)
+{
+	return (DrmaaJobNode *) GetFromHashMap (s_jobs_p, job_id_s);
+}
+
+
+/*
+ * This must be called with s_monitor_mutex held
+ */
+static void SetDrmaaJobNodeStatus (DrmaaJobNode *node_p, const OperationStatus status, const int exit_code)
+{
+	const bool was_finished_flag = IsFinishedStatus (node_p -> djn_status);
+
+	node_p -> djn_status = status;
+	node_p -> djn_exit_code = exit_code;
+	node_p -> djn_updated = time (NULL);
+
+	if (!was_finished_flag && IsFinishedStatus (status))
+		{
+			if (s_num_active_jobs > 0)
+				{
+					-- s_num_active_jobs;
+				}
+		}
+}
+
+
+static bool IsFinishedStatus (const OperationStatus status)
+{
+	return ((status == OS_SUCCEEDED) || (status == OS_FAILED) || (status == OS_PARTIALLY_SUCCEEDED) || (status == OS_FINISHED));
+}
+
+
+static void GetTimeoutFromNow (struct timespec *time_p, const uint32 interval_ms)
+{
+	clock_gettime (CLOCK_REALTIME, time_p);
+
+	time_p -> tv_sec += interval_ms / 1000;
+	time_p -> tv_nsec += (interval_ms % 1000) * 1000000L;
+
+	if (time_p -> tv_nsec >= 1000000000L)
+		{
+			++ (time_p -> tv_sec);
+			time_p -> tv_nsec -= 1000000000L;
+		}
+}
@@ -0,0 +1,197 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * drmaa_job_monitor_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Test for the DrmaaJobMonitor using the stand-in DRMAA library. A
+ *  number of jobs are submitted and their statuses are repeatedly read
+ *  until they have all finished. The test checks that every job ends
+ *  with the status that the stand-in library gave it and that the
+ *  number of scheduler queries doesn't grow with the number of reads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "drmaa_stub.h"
+#include "drmaa_job_monitor.h"
+#include "memory_allocations.h"
+
+
+#define JOB_ID_BUFFER_SIZE (256)
+
+
+int main (int argc, char *argv [])
+{
+	int num_jobs = 200;
+	int fail_every = 7;
+	uint32 poll_interval_ms = 250;
+	char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
+	int ret = 1;
+
+	if (argc > 1)
+		{
+			num_jobs = atoi (argv [1]);
+		}
+
+	setenv ("DRMAA_STUB_QUEUE_MS", "300", 0);
+	setenv ("DRMAA_STUB_RUN_MS", "500", 0);
+	setenv ("DRMAA_STUB_FAIL_EVERY", "7", 1);
+
+	if (drmaa_init (NULL, error_s, DRMAA_ERROR_STRING_BUFFER - 1) == DRMAA_ERRNO_SUCCESS)
+		{
+			if (StartDrmaaJobMonitor (poll_interval_ms))
+				{
+					drmaa_job_template_t *jt_p = NULL;
+
+					if (drmaa_allocate_job_template (&jt_p, error_s, DRMAA_ERROR_STRING_BUFFER - 1) == DRMAA_ERRNO_SUCCESS)
+						{
+							char *ids_p = (char *) AllocMemory (num_jobs * JOB_ID_BUFFER_SIZE);
+
+							drmaa_set_attribute (jt_p, DRMAA_REMOTE_COMMAND, "/bin/true", error_s, DRMAA_ERROR_STRING_BUFFER - 1);
+
+							if (ids_p)
+								{
+									int num_submitted = 0;
+									int i;
+
+									for (i = 0; i < num_jobs; ++ i)
+										{
+											char *id_s = ids_p + (i * JOB_ID_BUFFER_SIZE);
+
+											if (drmaa_run_job (id_s, JOB_ID_BUFFER_SIZE - 1, jt_p, error_s, DRMAA_ERROR_STRING_BUFFER - 1) == DRMAA_ERRNO_SUCCESS)
+												{
+													AddJobToDrmaaJobMonitor (id_s);
+													++ num_submitted;
+												}
+										}
+
+									if (num_submitted == num_jobs)
+										{
+											unsigned long num_reads = 0;
+											int num_started_seen = 0;
+											int num_finished = 0;
+											int num_failed = 0;
+											int num_wrong = 0;
+											bool *started_p = (bool *) AllocMemory (num_jobs * sizeof (bool));
+
+											for (i = 0; i < num_jobs; ++ i)
+												{
+													started_p [i] = false;
+												}
+
+											/* Simulate clients polling every job's status every 20 ms */
+											while (num_finished < num_jobs)
+												{
+													num_finished = 0;
+
+													for (i = 0; i < num_jobs; ++ i)
+														{
+															OperationStatus status = OS_ERROR;
+
+															if (GetDrmaaJobMonitorStatus (ids_p + (i * JOB_ID_BUFFER_SIZE), &status, NULL))
+																{
+																	if (status == OS_STARTED)
+																		{
+																			started_p [i] = true;
+																		}
+																	else if ((status == OS_SUCCEEDED) || (status == OS_FAILED))
+																		{
+																			++ num_finished;
+																		}
+																}
+
+															++ num_reads;
+														}
+
+													usleep (20000);
+												}
+
+											for (i = 0; i < num_jobs; ++ i)
+												{
+													OperationStatus status = OS_ERROR;
+													int exit_code = -1;
+													const bool expect_failure = (((i + 1) % fail_every) == 0);
+
+													if (started_p [i])
+														{
+															++ num_started_seen;
+														}
+
+													if (WaitForDrmaaJobMonitorStatus (ids_p + (i * JOB_ID_BUFFER_SIZE), &status, &exit_code))
+														{
+															if (status == OS_FAILED)
+																{
+																	++ num_failed;
+																}
+
+															if (expect_failure != (status == OS_FAILED))
+																{
+																	++ num_wrong;
+																}
+														}
+													else
+														{
+															++ num_wrong;
+														}
+												}
+
+											printf ("jobs: %d, status reads: %lu, drmaa_job_ps calls: %lu\n", num_jobs, num_reads, drmaa_stub_get_num_job_ps_calls ());
+											printf ("seen running: %d, failed: %d, wrong status: %d\n", num_started_seen, num_failed, num_wrong);
+
+											if ((num_wrong == 0) && (num_started_seen > 0) && (drmaa_stub_get_num_job_ps_calls () < num_reads / 4))
+												{
+													puts ("PASSED");
+													ret = 0;
+												}
+											else
+												{
+													puts ("FAILED");
+												}
+
+											FreeMemory (started_p);
+										}
+									else
+										{
+											printf ("Only submitted %d out of %d jobs\n", num_submitted, num_jobs);
+										}
+
+									FreeMemory (ids_p);
+								}
+
+							drmaa_delete_job_template (jt_p, error_s, DRMAA_ERROR_STRING_BUFFER - 1);
+						}
+
+					StopDrmaaJobMonitor ();
+				}
+			else
+				{
+					puts ("Failed to start DRMAA job monitor");
+				}
+
+			drmaa_exit (error_s, DRMAA_ERROR_STRING_BUFFER - 1);
+		}
+	else
+		{
+			printf ("drmaa_init failed: %s\n", error_s);
+		}
+
+	return ret;
+}
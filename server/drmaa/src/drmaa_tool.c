@@ -17,6 +17,7 @@
 
 #include "drmaa.h"
 #include "drmaa_tool.h"
+#include "drmaa_job_monitor.h"
 #include "streams.h"
 #include "string_utils.h"
 #include "memory_allocations.h"
@@ -45,6 +46,8 @@
 	static const char * const S_QUEUE_KEY_S = "-p ";
 #elif HTCONDOR_DRMAA_ENABLED
 	static const char * const S_QUEUE_KEY_S = NULL;
+#elif STUB_DRMAA_ENABLED
+	static const char * const S_QUEUE_KEY_S = NULL;
 #endif
 
 
@@ -70,6 +73,44 @@ static bool SetUpDrmaaToolValue (const json_t * const json_p, const char * const
 
 static bool InitDrmaaToolEnvVars (DrmaaTool *tool_p, GrassrootsServer *grassroots_p);
 
+static int SubmitDrmaaToolJobs (DrmaaTool *tool_p, char *error_s);
+
+static int SubmitDrmaaToolJobArray (DrmaaTool *tool_p, char *error_s);
+
+static bool AddDrmaaToolJobsToMonitor (const DrmaaTool *tool_p);
+
+static void RestoreDrmaaToolJobsInMonitor (const DrmaaTool *tool_p);
+
+static bool WriteDrmaaToolJobIds (const DrmaaTool *tool_p, FILE *log_f);
+
+static bool WaitForDrmaaToolJobArray (DrmaaTool *tool_p, const bool monitored_flag);
+
+static OperationStatus GetDrmaaJobStatus (const char *job_id_s);
+
+static OperationStatus GetFinalDrmaaJobStatus (const char *job_id_s, OperationStatus *final_status_p);
+
+static OperationStatus *GetDrmaaToolFinalTaskStatus (DrmaaTool *tool_p, const uint32 task_index);
+
+static bool IsFinalDrmaaJobStatus (const OperationStatus status);
+
+static OperationStatus GetDrmaaToolJobArrayStatus (DrmaaTool *tool_p);
+
+static void ClearDrmaaToolTaskIds (DrmaaTool *tool_p);
+
+static void RemoveEmptyOutputFile (const char *filename_s);
+
+static void RemoveEmptyOutputFiles (const DrmaaTool *tool_p);
+
+static bool AddDrmaaToolJobArrayToJSON (const DrmaaTool *tool_p, json_t *drmaa_json_p);
+
+static bool GetDrmaaToolJobArrayFromJSON (DrmaaTool *tool_p, const json_t *drmaa_json_p);
+
+static bool GetTaskIdPattern (const DrmaaTool *tool_p, char **prefix_ss, char **suffix_ss);
+
+static bool AddDrmaaToolFinalTaskStatusesToJSON (const DrmaaTool *tool_p, json_t *array_json_p);
+
+static bool GetDrmaaToolFinalTaskStatusesFromJSON (DrmaaTool *tool_p, const json_t *array_json_p);
+
 /*
  * API FUNCTIONS
  */
@@ -90,6 +131,15 @@ bool InitDrmaa (void)
 	if (res == DRMAA_ERRNO_SUCCESS)
 		{
 			success_flag = true;
+
+			/*
+			 * If the monitor fails to start, statuses will fall back
+			 * to being got directly from the scheduler.
+			 */
+			if (!StartDrmaaJobMonitor (DRMAA_JOB_MONITOR_DEFAULT_POLL_INTERVAL_MS))
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to start DRMAA job monitor");
+				}
 		}
 
 	#if DRMAA_UTIL_DEBUG >= STM_LEVEL_FINEST
@@ -110,6 +160,8 @@ bool ExitDrmaa (void)
 	PrintLog (STM_LEVEL_FINEST, __FILE__, __LINE__, "About to Exit Drmaa");
 	#endif
 
+	StopDrmaaJobMonitor ();
+
 	res = drmaa_exit (error_diagnosis_s, DRMAA_ERROR_STRING_BUFFER - 1);
 
 	if (res == DRMAA_ERRNO_SUCCESS)
@@ -248,8 +300,6 @@ bool InitDrmaaTool (DrmaaTool *tool_p, const char *program_name_s, const uuid_t
 
 void ClearDrmaaTool (DrmaaTool *tool_p)
 {
-	FileInformation fi;
-
 	#if DRMAA_TOOL_DEBUG >= STM_LEVEL_FINEST
 	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "entering ClearDrmaaTool");
 	#endif
@@ -293,43 +343,12 @@ void ClearDrmaaTool (DrmaaTool *tool_p)
 			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "deleting dt_email_addresses_ss");
 			#endif
 
-			FreeStringArray (tool_p -> dt_email_addresses_ss);
+			FreeStringArray (tool_p -> dt_email_addresses_ss, 0);
 		}
 
 	if (tool_p -> dt_output_filename_s)
 		{
-			const char *filename_s = tool_p -> dt_output_filename_s;
-
-			/*
-			 * Drmaa can require the filename to have a ":" prefix,
-			 * so if this value has, let's scroll past it.
-			 */
-			if (*filename_s == ':')
-				{
-					++ filename_s;
-				}
-
-			InitFileInformation (&fi);
-
-			if (CalculateFileInformation (filename_s, &fi))
-				{
-					/* If the stdout/stderr file is empty, then delete it */
-					if (fi.fi_size == 0)
-						{
-							#if DRMAA_TOOL_DEBUG >= STM_LEVEL_FINEST
-							PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "removing file \"%s\"", tool_p -> dt_output_filename_s);
-							#endif
-
-							if (!RemoveFile (tool_p -> dt_output_filename_s))
-								{
-									PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to delete file \"%s\"", tool_p -> dt_output_filename_s);
-								}
-						}
-				}
-			else
-				{
-					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get file size for \"%s\"", tool_p -> dt_output_filename_s);
-				}
+			RemoveEmptyOutputFiles (tool_p);
 
 			#if DRMAA_TOOL_DEBUG >= STM_LEVEL_FINEST
 			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "deleting dt_output_filename_s");
@@ -343,6 +362,8 @@ void ClearDrmaaTool (DrmaaTool *tool_p)
 			FreeLinkedList (tool_p -> dt_args_p);
 		}
 
+	ClearDrmaaToolTaskIds (tool_p);
+
 	#if DRMAA_TOOL_DEBUG >= STM_LEVEL_FINEST
 	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "exiting ClearDrmaaTool");
 	#endif
@@ -422,7 +443,7 @@ bool SetDrmaaToolEmailNotifications (DrmaaTool *tool_p, const char **email_addre
 						{
 							if (tool_p -> dt_email_addresses_ss)
 								{
-									FreeStringArray (tool_p -> dt_email_addresses_ss);
+									FreeStringArray (tool_p -> dt_email_addresses_ss, 0);
 								}
 
 							tool_p -> dt_email_addresses_ss = copied_email_addresses_ss;
@@ -466,7 +487,7 @@ bool SetDrmaaToolEmailNotifications (DrmaaTool *tool_p, const char **email_addre
 				{
 					const char *addresses_s = NULL;
 
-					FreeStringArray (tool_p -> dt_email_addresses_ss);
+					FreeStringArray (tool_p -> dt_email_addresses_ss, 0);
 					tool_p -> dt_email_addresses_ss = NULL;
 					success_flag = SetDrmaaVectorAttribute (tool_p, DRMAA_V_EMAIL, &addresses_s);
 				}
@@ -593,57 +614,76 @@ bool AddDrmaaToolArgument (DrmaaTool *tool_p, const char *arg_s)
 
 OperationStatus GetDrmaaToolStatus (DrmaaTool *tool_p)
 {
-	OperationStatus status = OS_ERROR;
-	char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
-	int drmaa_status;
-	int res = drmaa_job_ps (tool_p -> dt_id_s, &drmaa_status, error_s, DRMAA_ERROR_STRING_BUFFER);
+	OperationStatus status;
 
-	if (res == DRMAA_ERRNO_SUCCESS)
+	if (tool_p -> dt_num_tasks > 0)
 		{
-			switch (drmaa_status)
-				{
-					case DRMAA_PS_QUEUED_ACTIVE:
-					case DRMAA_PS_SYSTEM_ON_HOLD:
-					case DRMAA_PS_USER_ON_HOLD:
-					case DRMAA_PS_USER_SYSTEM_ON_HOLD:
-						status = OS_PENDING;
-						break;
+			status = GetDrmaaToolJobArrayStatus (tool_p);
+		}
+	else
+		{
+			status = GetFinalDrmaaJobStatus (tool_p -> dt_id_s, & (tool_p -> dt_final_status));
+		}
 
-					case DRMAA_PS_UNDETERMINED:
-						status = OS_ERROR;
-						break;
+	return status;
+}
 
-					case DRMAA_PS_RUNNING:
-						status = OS_STARTED;
-						break;
 
-					case DRMAA_PS_FAILED:
-						status = OS_FAILED;
-						break;
+OperationStatus GetDrmaaToolTaskStatus (DrmaaTool *tool_p, const uint32 task_index)
+{
+	OperationStatus status = OS_ERROR;
 
-					case DRMAA_PS_DONE:
-						status = OS_SUCCEEDED;
-						break;
+	if (task_index < tool_p -> dt_num_tasks)
+		{
+			status = GetFinalDrmaaJobStatus (* ((tool_p -> dt_task_ids_ss) + task_index), GetDrmaaToolFinalTaskStatus (tool_p, task_index));
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Task index " UINT32_FMT " is out of range for %s, which has " UINT32_FMT " tasks", task_index, tool_p -> dt_id_s, tool_p -> dt_num_tasks);
+		}
 
-					case DRMAA_PS_SYSTEM_SUSPENDED:
-					case DRMAA_PS_USER_SUSPENDED:
-					case DRMAA_PS_USER_SYSTEM_SUSPENDED:
-						status = OS_PENDING;
-						break;
+	return status;
+}
 
-					default:
-						break;
-				}
 
-			PrintLog (STM_LEVEL_SEVERE, __FILE__, __LINE__, "drmaa ps for %s: (%d = %d)", tool_p -> dt_id_s, drmaa_status, status);
+bool SetDrmaaToolJobArray (DrmaaTool *tool_p, const uint32 start, const uint32 end, const uint32 step)
+{
+	bool success_flag = false;
+
+	if (end == 0)
+		{
+			tool_p -> dt_array_start = 0;
+			tool_p -> dt_array_end = 0;
+			tool_p -> dt_array_step = 0;
+
+			success_flag = true;
+		}
+	else if ((start >= 1) && (end >= start) && (step >= 1))
+		{
+			tool_p -> dt_array_start = start;
+			tool_p -> dt_array_end = end;
+			tool_p -> dt_array_step = step;
 
+			success_flag = true;
 		}
 	else
 		{
-			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to get drmaa ps for %s: %d, error: %s", tool_p -> dt_id_s, res, error_s);
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Invalid job array range " UINT32_FMT "-" UINT32_FMT ":" UINT32_FMT " for %s", start, end, step, tool_p -> dt_program_name_s);
 		}
 
-	return status;
+	return success_flag;
+}
+
+
+bool IsDrmaaToolJobArray (const DrmaaTool *tool_p)
+{
+	return (tool_p -> dt_array_end > 0);
+}
+
+
+uint32 GetDrmaaToolNumTasks (const DrmaaTool *tool_p)
+{
+	return tool_p -> dt_num_tasks;
 }
 
 
@@ -670,14 +710,26 @@ bool RunDrmaaTool (DrmaaTool *tool_p, const bool async_flag, const char * const
 
 					if (result == 0)
 						{
-							/*run a job*/
-							result = drmaa_run_job (tool_p -> dt_id_s, DRMAA_ID_BUFFER_SIZE - 1, tool_p -> dt_job_p, error_s, DRMAA_ERROR_STRING_BUFFER);
+							/* run a job or a job array */
+							result = SubmitDrmaaToolJobs (tool_p, error_s);
 
 							/* Now the job has started we can delete its template */
 							DeleteJobTemplate (tool_p);
 
 							if (result == DRMAA_ERRNO_SUCCESS)
 								{
+									/*
+									 * Whilst the job monitor is running, it reaps every job in
+									 * the session so we must wait via it rather than calling
+									 * drmaa_wait () or drmaa_synchronize () ourselves.
+									 */
+									const bool monitored_flag = IsDrmaaJobMonitorRunning ();
+
+									if (monitored_flag && !AddDrmaaToolJobsToMonitor (tool_p))
+										{
+											PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to register job <%s> with the DRMAA job monitor", tool_p -> dt_id_s);
+										}
+
 									/* Log the job id if requested */
 									if (log_s)
 										{
@@ -687,7 +739,7 @@ bool RunDrmaaTool (DrmaaTool *tool_p, const bool async_flag, const char * const
 												{
 													int res;
 
-													if (fprintf (log_f, "job id: \"%s\"\n", tool_p -> dt_id_s) < 0)
+													if (!WriteDrmaaToolJobIds (tool_p, log_f))
 														{
 															PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to write job id %s to %s", tool_p -> dt_id_s, log_s);
 														}
@@ -712,6 +764,38 @@ bool RunDrmaaTool (DrmaaTool *tool_p, const bool async_flag, const char * const
 										{
 											success_flag = true;
 										}
+									else if (tool_p -> dt_num_tasks > 0)
+										{
+											success_flag = WaitForDrmaaToolJobArray (tool_p, monitored_flag);
+										}
+									else if (monitored_flag)
+										{
+											OperationStatus status;
+											int exit_code;
+
+											if (WaitForDrmaaJobMonitorStatus (tool_p -> dt_id_s, &status, &exit_code))
+												{
+													success_flag = true;
+
+													if (IsFinalDrmaaJobStatus (status))
+														{
+															tool_p -> dt_final_status = status;
+														}
+
+													if (exit_code >= 0)
+														{
+															PrintLog (STM_LEVEL_INFO, __FILE__, __LINE__, "job <%s> finished with exit code %d\n", tool_p -> dt_id_s, exit_code);
+														}
+													else
+														{
+															PrintLog (STM_LEVEL_SEVERE, __FILE__, __LINE__, "job <%s> was aborted or killed by a signal\n", tool_p -> dt_id_s);
+														}
+												}
+											else
+												{
+													PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to wait for job <%s> to finish", tool_p -> dt_id_s);
+												}
+										}
 									else
 										{
 											int stat;
@@ -767,7 +851,7 @@ bool RunDrmaaTool (DrmaaTool *tool_p, const bool async_flag, const char * const
 								}		/* if (result == DRMAA_ERRNO_SUCCESS) */
 							else
 								{
-									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "drmaa_run_job failed with code %d, \"%s", result, error_s);
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "drmaa job submission failed with code %d, \"%s", result, error_s);
 								}
 
 						}		/* if (result == 0) */
@@ -817,6 +901,7 @@ bool SetDrmaaToolJobId (DrmaaTool *tool_p, const char *id_s)
 			if (strlen (id_s) < DRMAA_ID_BUFFER_SIZE)
 				{
 					strcpy (tool_p -> dt_id_s, id_s);
+					tool_p -> dt_final_status = OS_IDLE;
 					success_flag = true;
 				}
 			else
@@ -1097,6 +1182,23 @@ json_t *ConvertDrmaaToolToJSON (const DrmaaTool * const tool_p)
 																										}
 																								}
 
+																							if (continue_flag)
+																								{
+																									if (IsFinalDrmaaJobStatus (tool_p -> dt_final_status))
+																										{
+																											if (json_object_set_new (drmaa_json_p, DRMAA_FINAL_STATUS_S, json_integer (tool_p -> dt_final_status)) != 0)
+																												{
+																													continue_flag = false;
+																													PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add dt_final_status %d to drmaa tool json", tool_p -> dt_final_status);
+																												}
+																										}
+																								}
+
+																							if (continue_flag)
+																								{
+																									continue_flag = AddDrmaaToolJobArrayToJSON (tool_p, drmaa_json_p);
+																								}
+
 																							if (continue_flag)
 																								{
 																									if (tool_p -> dt_args_p -> ll_size > 0)
@@ -1330,6 +1432,26 @@ DrmaaTool *ConvertDrmaaToolFromJSON (const json_t * const json_p, GrassrootsServ
 
 																											drmaa_p -> dt_email_addresses_ss = GetEmailAddresses (json_p);
 
+																											if (!GetDrmaaToolJobArrayFromJSON (drmaa_p, json_p))
+																												{
+																													PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get job array for %s", drmaa_p -> dt_program_name_s);
+																												}
+
+																											if (GetJSONInteger (json_p, DRMAA_FINAL_STATUS_S, &i))
+																												{
+																													drmaa_p -> dt_final_status = (OperationStatus) i;
+																												}
+
+																											/*
+																											 * Track the restored job, or each of its unfinished tasks, so that its
+																											 * status comes from the job monitor rather than polling the scheduler. If
+																											 * the monitor isn't running, GetDrmaaToolStatus () falls back to polling.
+																											 */
+																											if (* (drmaa_p -> dt_id_s) != '\0')
+																												{
+																													RestoreDrmaaToolJobsInMonitor (drmaa_p);
+																												}
+
 
 																											return drmaa_p;
 																										}		/* if (drmaa_p -> dt_args_p) */
@@ -1511,3 +1633,829 @@ static bool InitDrmaaToolEnvVars (DrmaaTool *tool_p, GrassrootsServer *grassroot
 }
 
 
+
+
+static int SubmitDrmaaToolJobs (DrmaaTool *tool_p, char *error_s)
+{
+	int result;
+
+	ClearDrmaaToolTaskIds (tool_p);
+
+	if (tool_p -> dt_array_end > 0)
+		{
+			result = SubmitDrmaaToolJobArray (tool_p, error_s);
+		}
+	else
+		{
+			result = drmaa_run_job (tool_p -> dt_id_s, DRMAA_ID_BUFFER_SIZE - 1, tool_p -> dt_job_p, error_s, DRMAA_ERROR_STRING_BUFFER);
+		}
+
+	return result;
+}
+
+
+static int SubmitDrmaaToolJobArray (DrmaaTool *tool_p, char *error_s)
+{
+	int result = DRMAA_ERRNO_SUCCESS;
+
+	/* Give each task its own output file */
+	if (tool_p -> dt_output_filename_s)
+		{
+			char *path_s = ConcatenateVarargsStrings (tool_p -> dt_output_filename_s, ".", DRMAA_PLACEHOLDER_INCR, NULL);
+
+			if (path_s)
+				{
+					if (!SetDrmaaAttribute (tool_p, DRMAA_OUTPUT_PATH, path_s))
+						{
+							result = DRMAA_ERRNO_INVALID_ATTRIBUTE_VALUE;
+						}
+
+					FreeCopiedString (path_s);
+				}
+			else
+				{
+					result = DRMAA_ERRNO_NO_MEMORY;
+				}
+		}
+
+	if (result == DRMAA_ERRNO_SUCCESS)
+		{
+			drmaa_job_ids_t *ids_p = NULL;
+
+			result = drmaa_run_bulk_jobs (&ids_p, tool_p -> dt_job_p, (int) (tool_p -> dt_array_start), (int) (tool_p -> dt_array_end), (int) (tool_p -> dt_array_step), error_s, DRMAA_ERROR_STRING_BUFFER);
+
+			if (result == DRMAA_ERRNO_SUCCESS)
+				{
+					const uint32 max_num_tasks = (((tool_p -> dt_array_end) - (tool_p -> dt_array_start)) / (tool_p -> dt_array_step)) + 1;
+
+					/* Allow for the terminating NULL */
+					tool_p -> dt_task_ids_ss = (char **) AllocMemoryArray (max_num_tasks + 1, sizeof (char *));
+
+					if (tool_p -> dt_task_ids_ss)
+						{
+							char id_s [DRMAA_ID_BUFFER_SIZE];
+							bool loop_flag = true;
+
+							while (loop_flag && (tool_p -> dt_num_tasks < max_num_tasks))
+								{
+									if (drmaa_get_next_job_id (ids_p, id_s, DRMAA_ID_BUFFER_SIZE - 1) == DRMAA_ERRNO_SUCCESS)
+										{
+											char *copied_id_s = EasyCopyToNewString (id_s);
+
+											if (copied_id_s)
+												{
+													* ((tool_p -> dt_task_ids_ss) + (tool_p -> dt_num_tasks)) = copied_id_s;
+													++ (tool_p -> dt_num_tasks);
+												}
+											else
+												{
+													PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to copy task id \"%s\" for %s", id_s, tool_p -> dt_program_name_s);
+													result = DRMAA_ERRNO_NO_MEMORY;
+													loop_flag = false;
+												}
+										}
+									else
+										{
+											loop_flag = false;
+										}
+								}
+
+							if (tool_p -> dt_num_tasks > 0)
+								{
+									/* Use the first task's id as the id for the whole DrmaaTool */
+									strcpy (tool_p -> dt_id_s, *(tool_p -> dt_task_ids_ss));
+								}
+							else if (result == DRMAA_ERRNO_SUCCESS)
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "No task ids returned for job array for %s", tool_p -> dt_program_name_s);
+									result = DRMAA_ERRNO_INTERNAL_ERROR;
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate " UINT32_FMT " task ids for %s", max_num_tasks, tool_p -> dt_program_name_s);
+							result = DRMAA_ERRNO_NO_MEMORY;
+						}
+
+					drmaa_release_job_ids (ids_p);
+				}		/* if (result == DRMAA_ERRNO_SUCCESS) */
+
+		}		/* if (result == DRMAA_ERRNO_SUCCESS) */
+
+	return result;
+}
+
+
+static bool AddDrmaaToolJobsToMonitor (const DrmaaTool *tool_p)
+{
+	bool success_flag = true;
+
+	if (tool_p -> dt_num_tasks > 0)
+		{
+			uint32 i;
+
+			for (i = 0; i < tool_p -> dt_num_tasks; ++ i)
+				{
+					if (!AddJobToDrmaaJobMonitor (* ((tool_p -> dt_task_ids_ss) + i)))
+						{
+							success_flag = false;
+						}
+				}
+		}
+	else
+		{
+			success_flag = AddJobToDrmaaJobMonitor (tool_p -> dt_id_s);
+		}
+
+	return success_flag;
+}
+
+
+/*
+ * Jobs that are known to have finished don't need tracking. Any
+ * others may have been submitted by an earlier server process, so
+ * they are registered with their current statuses from the scheduler.
+ */
+static void RestoreDrmaaToolJobsInMonitor (const DrmaaTool *tool_p)
+{
+	if (tool_p -> dt_num_tasks > 0)
+		{
+			uint32 i;
+
+			for (i = 0; i < tool_p -> dt_num_tasks; ++ i)
+				{
+					if (! ((tool_p -> dt_final_task_statuses_p) && (IsFinalDrmaaJobStatus (* ((tool_p -> dt_final_task_statuses_p) + i)))))
+						{
+							RestoreJobInDrmaaJobMonitor (* ((tool_p -> dt_task_ids_ss) + i));
+						}
+				}
+		}
+	else if (!IsFinalDrmaaJobStatus (tool_p -> dt_final_status))
+		{
+			RestoreJobInDrmaaJobMonitor (tool_p -> dt_id_s);
+		}
+}
+
+
+static bool WriteDrmaaToolJobIds (const DrmaaTool *tool_p, FILE *log_f)
+{
+	bool success_flag = true;
+
+	if (tool_p -> dt_num_tasks > 0)
+		{
+			uint32 i;
+
+			for (i = 0; i < tool_p -> dt_num_tasks; ++ i)
+				{
+					if (fprintf (log_f, "job id: \"%s\"\n", * ((tool_p -> dt_task_ids_ss) + i)) < 0)
+						{
+							success_flag = false;
+						}
+				}
+		}
+	else
+		{
+			success_flag = (fprintf (log_f, "job id: \"%s\"\n", tool_p -> dt_id_s) >= 0);
+		}
+
+	return success_flag;
+}
+
+
+static bool WaitForDrmaaToolJobArray (DrmaaTool *tool_p, const bool monitored_flag)
+{
+	bool success_flag = true;
+
+	if (monitored_flag)
+		{
+			uint32 num_failed = 0;
+			uint32 i;
+
+			for (i = 0; i < tool_p -> dt_num_tasks; ++ i)
+				{
+					const char *task_id_s = * ((tool_p -> dt_task_ids_ss) + i);
+					OperationStatus status;
+
+					if (WaitForDrmaaJobMonitorStatus (task_id_s, &status, NULL))
+						{
+							if (status != OS_SUCCEEDED)
+								{
+									++ num_failed;
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to wait for task <%s> to finish", task_id_s);
+							success_flag = false;
+						}
+				}
+
+			PrintLog (STM_LEVEL_INFO, __FILE__, __LINE__, "job array <%s> finished with " UINT32_FMT " of " UINT32_FMT " tasks failing\n", tool_p -> dt_id_s, num_failed, tool_p -> dt_num_tasks);
+		}
+	else
+		{
+			char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
+
+			/* Don't dispose of the tasks' statuses so that drmaa_job_ps () can still get them */
+			int result = drmaa_synchronize ((const char **) (tool_p -> dt_task_ids_ss), DRMAA_TIMEOUT_WAIT_FOREVER, 0, error_s, DRMAA_ERROR_STRING_BUFFER);
+
+			if (result == DRMAA_ERRNO_SUCCESS)
+				{
+					PrintLog (STM_LEVEL_INFO, __FILE__, __LINE__, "job array <%s> with " UINT32_FMT " tasks finished\n", tool_p -> dt_id_s, tool_p -> dt_num_tasks);
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "drmaa_synchronize failed with code %d, \"%s\"", result, error_s);
+					success_flag = false;
+				}
+		}
+
+	return success_flag;
+}
+
+
+static OperationStatus GetDrmaaJobStatus (const char *job_id_s)
+{
+	OperationStatus status = OS_ERROR;
+
+	/*
+	 * If the job monitor is tracking the job, we can get its
+	 * status without querying the scheduler.
+	 */
+	if (!GetDrmaaJobMonitorStatus (job_id_s, &status, NULL))
+		{
+			char error_s [DRMAA_ERROR_STRING_BUFFER] = { 0 };
+			int drmaa_status;
+			int res = drmaa_job_ps (job_id_s, &drmaa_status, error_s, DRMAA_ERROR_STRING_BUFFER);
+
+			if (res == DRMAA_ERRNO_SUCCESS)
+				{
+					status = ConvertDrmaaProgramStatus (drmaa_status);
+
+					PrintLog (STM_LEVEL_SEVERE, __FILE__, __LINE__, "drmaa ps for %s: (%d = %d)", job_id_s, drmaa_status, status);
+				}
+			else
+				{
+					status = OS_ERROR;
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to get drmaa ps for %s: %d, error: %s", job_id_s, res, error_s);
+				}
+		}
+
+	return status;
+}
+
+
+/*
+ * Once a job has finished, keep its status in final_status_p since
+ * neither the DrmaaJobMonitor nor the scheduler will be able to report
+ * it indefinitely. If final_status_p is NULL, the status isn't kept.
+ */
+static OperationStatus GetFinalDrmaaJobStatus (const char *job_id_s, OperationStatus *final_status_p)
+{
+	OperationStatus status;
+
+	if (final_status_p && IsFinalDrmaaJobStatus (*final_status_p))
+		{
+			status = *final_status_p;
+		}
+	else
+		{
+			status = GetDrmaaJobStatus (job_id_s);
+
+			if (final_status_p && IsFinalDrmaaJobStatus (status))
+				{
+					*final_status_p = status;
+				}
+		}
+
+	return status;
+}
+
+
+static OperationStatus *GetDrmaaToolFinalTaskStatus (DrmaaTool *tool_p, const uint32 task_index)
+{
+	if (!tool_p -> dt_final_task_statuses_p)
+		{
+			/* OS_IDLE is 0 so the zeroed array marks every task as unfinished */
+			tool_p -> dt_final_task_statuses_p = (OperationStatus *) AllocMemoryArray (tool_p -> dt_num_tasks, sizeof (OperationStatus));
+
+			if (!tool_p -> dt_final_task_statuses_p)
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to allocate final task statuses for %s", tool_p -> dt_id_s);
+					return NULL;
+				}
+		}
+
+	return (tool_p -> dt_final_task_statuses_p) + task_index;
+}
+
+
+static bool IsFinalDrmaaJobStatus (const OperationStatus status)
+{
+	return ((status == OS_SUCCEEDED) || (status == OS_FAILED) || (status == OS_PARTIALLY_SUCCEEDED) || (status == OS_FINISHED));
+}
+
+
+static OperationStatus GetDrmaaToolJobArrayStatus (DrmaaTool *tool_p)
+{
+	OperationStatus status;
+	uint32 num_pending = 0;
+	uint32 num_started = 0;
+	uint32 num_succeeded = 0;
+	uint32 num_failed = 0;
+	uint32 i;
+
+	for (i = 0; i < tool_p -> dt_num_tasks; ++ i)
+		{
+			switch (GetFinalDrmaaJobStatus (* ((tool_p -> dt_task_ids_ss) + i), GetDrmaaToolFinalTaskStatus (tool_p, i)))
+				{
+					case OS_IDLE:
+					case OS_PENDING:
+						++ num_pending;
+						break;
+
+					case OS_STARTED:
+						++ num_started;
+						break;
+
+					case OS_SUCCEEDED:
+						++ num_succeeded;
+						break;
+
+					default:
+						++ num_failed;
+						break;
+				}
+		}
+
+	if (num_started > 0)
+		{
+			status = OS_STARTED;
+		}
+	else if (num_pending > 0)
+		{
+			status = OS_PENDING;
+		}
+	else if (num_failed == 0)
+		{
+			status = OS_SUCCEEDED;
+		}
+	else if (num_succeeded == 0)
+		{
+			status = OS_FAILED;
+		}
+	else
+		{
+			status = OS_PARTIALLY_SUCCEEDED;
+		}
+
+	return status;
+}
+
+
+static void ClearDrmaaToolTaskIds (DrmaaTool *tool_p)
+{
+	if (tool_p -> dt_task_ids_ss)
+		{
+			FreeStringArray (tool_p -> dt_task_ids_ss, tool_p -> dt_num_tasks);
+			tool_p -> dt_task_ids_ss = NULL;
+		}
+
+	if (tool_p -> dt_final_task_statuses_p)
+		{
+			FreeMemory (tool_p -> dt_final_task_statuses_p);
+			tool_p -> dt_final_task_statuses_p = NULL;
+		}
+
+	tool_p -> dt_num_tasks = 0;
+	tool_p -> dt_final_status = OS_IDLE;
+}
+
+
+/*
+ * If a stdout/stderr file is empty, then delete it.
+ */
+static void RemoveEmptyOutputFile (const char *filename_s)
+{
+	FileInformation fi;
+
+	InitFileInformation (&fi);
+
+	if (CalculateFileInformation (filename_s, &fi))
+		{
+			if (fi.fi_size == 0)
+				{
+					#if DRMAA_TOOL_DEBUG >= STM_LEVEL_FINEST
+					PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "removing file \"%s\"", filename_s);
+					#endif
+
+					if (!RemoveFile (filename_s))
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to delete file \"%s\"", filename_s);
+						}
+				}
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get file size for \"%s\"", filename_s);
+		}
+}
+
+
+/*
+ * Each task of a submitted job array writes to its own file, the
+ * output filename with its task index appended as set up by
+ * SubmitDrmaaToolJobArray ().
+ */
+static void RemoveEmptyOutputFiles (const DrmaaTool *tool_p)
+{
+	const char *filename_s = tool_p -> dt_output_filename_s;
+
+	/*
+	 * Drmaa can require the filename to have a ":" prefix,
+	 * so if this value has, let's scroll past it.
+	 */
+	if (*filename_s == ':')
+		{
+			++ filename_s;
+		}
+
+	if (tool_p -> dt_num_tasks > 0)
+		{
+			uint32 task_index = tool_p -> dt_array_start;
+			uint32 i;
+
+			for (i = 0; i < tool_p -> dt_num_tasks; ++ i, task_index += tool_p -> dt_array_step)
+				{
+					char index_s [16];
+					char *task_filename_s;
+
+					sprintf (index_s, UINT32_FMT, task_index);
+					task_filename_s = ConcatenateVarargsStrings (filename_s, ".", index_s, NULL);
+
+					if (task_filename_s)
+						{
+							RemoveEmptyOutputFile (task_filename_s);
+							FreeCopiedString (task_filename_s);
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get output filename for task " UINT32_FMT " of %s", task_index, tool_p -> dt_id_s);
+						}
+				}
+		}
+	else
+		{
+			RemoveEmptyOutputFile (filename_s);
+		}
+}
+
+
+/*
+ * Store the job array's range along with its task ids. Since the ids
+ * are nearly always the same apart from the task index, e.g. "1234.1",
+ * "1234.2", ..., they are stored as a prefix and suffix where possible
+ * rather than as a potentially very long array.
+ */
+static bool AddDrmaaToolJobArrayToJSON (const DrmaaTool *tool_p, json_t *drmaa_json_p)
+{
+	bool success_flag = true;
+
+	if (tool_p -> dt_array_end > 0)
+		{
+			json_t *array_json_p = json_object ();
+
+			success_flag = false;
+
+			if (array_json_p)
+				{
+					if (SetJSONInteger (array_json_p, DRMAA_ARRAY_START_S, tool_p -> dt_array_start))
+						{
+							if (SetJSONInteger (array_json_p, DRMAA_ARRAY_END_S, tool_p -> dt_array_end))
+								{
+									if (SetJSONInteger (array_json_p, DRMAA_ARRAY_STEP_S, tool_p -> dt_array_step))
+										{
+											bool added_ids_flag = true;
+
+											if (tool_p -> dt_num_tasks > 0)
+												{
+													char *prefix_s = NULL;
+													char *suffix_s = NULL;
+
+													if (GetTaskIdPattern (tool_p, &prefix_s, &suffix_s))
+														{
+															added_ids_flag = (SetJSONString (array_json_p, DRMAA_ARRAY_TASK_ID_PREFIX_S, prefix_s)) && (SetJSONString (array_json_p, DRMAA_ARRAY_TASK_ID_SUFFIX_S, suffix_s));
+
+															FreeCopiedString (prefix_s);
+															FreeCopiedString (suffix_s);
+														}
+													else
+														{
+															added_ids_flag = AddStringArrayToJSON (array_json_p, (const char ** const) (tool_p -> dt_task_ids_ss), DRMAA_ARRAY_TASK_IDS_S);
+														}
+
+													if (added_ids_flag)
+														{
+															added_ids_flag = AddDrmaaToolFinalTaskStatusesToJSON (tool_p, array_json_p);
+														}
+												}
+
+											if (added_ids_flag)
+												{
+													if (json_object_set_new (drmaa_json_p, DRMAA_ARRAY_S, array_json_p) == 0)
+														{
+															return true;
+														}
+													else
+														{
+															PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add job array to drmaa tool json");
+														}
+												}
+											else
+												{
+													PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add " UINT32_FMT " task ids to drmaa tool json", tool_p -> dt_num_tasks);
+												}
+
+										}		/* if (SetJSONInteger (array_json_p, DRMAA_ARRAY_STEP_S, tool_p -> dt_array_step)) */
+
+								}		/* if (SetJSONInteger (array_json_p, DRMAA_ARRAY_END_S, tool_p -> dt_array_end)) */
+
+						}		/* if (SetJSONInteger (array_json_p, DRMAA_ARRAY_START_S, tool_p -> dt_array_start)) */
+
+					json_decref (array_json_p);
+				}		/* if (array_json_p) */
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate job array json");
+				}
+
+		}		/* if (tool_p -> dt_array_end > 0) */
+
+	return success_flag;
+}
+
+
+static bool GetDrmaaToolJobArrayFromJSON (DrmaaTool *tool_p, const json_t *drmaa_json_p)
+{
+	bool success_flag = true;
+	const json_t *array_json_p = json_object_get (drmaa_json_p, DRMAA_ARRAY_S);
+
+	if (array_json_p)
+		{
+			json_int_t start = 0;
+			json_int_t end = 0;
+			json_int_t step = 1;
+
+			success_flag = false;
+
+			if (GetJSONInteger (array_json_p, DRMAA_ARRAY_START_S, &start) && GetJSONInteger (array_json_p, DRMAA_ARRAY_END_S, &end))
+				{
+					GetJSONInteger (array_json_p, DRMAA_ARRAY_STEP_S, &step);
+
+					if ((start > 0) && (end > 0) && (step > 0) && SetDrmaaToolJobArray (tool_p, (uint32) start, (uint32) end, (uint32) step))
+						{
+							const char *prefix_s = GetJSONString (array_json_p, DRMAA_ARRAY_TASK_ID_PREFIX_S);
+
+							ClearDrmaaToolTaskIds (tool_p);
+
+							if (prefix_s)
+								{
+									const char *suffix_s = GetJSONString (array_json_p, DRMAA_ARRAY_TASK_ID_SUFFIX_S);
+									const uint32 num_tasks = (((tool_p -> dt_array_end) - (tool_p -> dt_array_start)) / (tool_p -> dt_array_step)) + 1;
+
+									tool_p -> dt_task_ids_ss = (char **) AllocMemoryArray (num_tasks + 1, sizeof (char *));
+
+									if (tool_p -> dt_task_ids_ss)
+										{
+											uint32 task_index = tool_p -> dt_array_start;
+
+											success_flag = true;
+
+											while (success_flag && (tool_p -> dt_num_tasks < num_tasks))
+												{
+													char index_s [16];
+													char *id_s;
+
+													sprintf (index_s, UINT32_FMT, task_index);
+													id_s = ConcatenateVarargsStrings (prefix_s, index_s, suffix_s ? suffix_s : "", NULL);
+
+													if (id_s)
+														{
+															* ((tool_p -> dt_task_ids_ss) + (tool_p -> dt_num_tasks)) = id_s;
+															++ (tool_p -> dt_num_tasks);
+															task_index += tool_p -> dt_array_step;
+														}
+													else
+														{
+															success_flag = false;
+														}
+												}
+										}
+								}
+							else
+								{
+									const json_t *ids_json_p = json_object_get (array_json_p, DRMAA_ARRAY_TASK_IDS_S);
+
+									if (ids_json_p)
+										{
+											if (json_is_array (ids_json_p) && (json_array_size (ids_json_p) > 0))
+												{
+													tool_p -> dt_task_ids_ss = GetStringArrayFromJSON (ids_json_p, true);
+
+													if (tool_p -> dt_task_ids_ss)
+														{
+															tool_p -> dt_num_tasks = (uint32) json_array_size (ids_json_p);
+															success_flag = true;
+														}
+												}
+										}
+									else
+										{
+											/* The job array hasn't been submitted yet */
+											success_flag = true;
+										}
+								}
+
+							if (success_flag)
+								{
+									if (!GetDrmaaToolFinalTaskStatusesFromJSON (tool_p, array_json_p))
+										{
+											PrintJSONToErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, array_json_p, "Failed to get final task statuses");
+										}
+								}
+							else
+								{
+									PrintJSONToErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, array_json_p, "Failed to get task ids");
+								}
+
+						}
+					else
+						{
+							PrintJSONToErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, array_json_p, "Invalid job array range");
+						}
+				}
+			else
+				{
+					PrintJSONToErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, array_json_p, "Failed to get job array range");
+				}
+
+		}		/* if (array_json_p) */
+
+	return success_flag;
+}
+
+
+/*
+ * Check whether every task id is the same prefix and suffix
+ * around the task's index and if so, get copies of them.
+ */
+static bool GetTaskIdPattern (const DrmaaTool *tool_p, char **prefix_ss, char **suffix_ss)
+{
+	const uint32 expected_num_tasks = (((tool_p -> dt_array_end) - (tool_p -> dt_array_start)) / (tool_p -> dt_array_step)) + 1;
+
+	if (tool_p -> dt_num_tasks == expected_num_tasks)
+		{
+			const char *first_id_s = *(tool_p -> dt_task_ids_ss);
+			const char *index_p = NULL;
+			const char *match_p = first_id_s;
+			char index_s [16];
+			size_t index_length;
+
+			sprintf (index_s, UINT32_FMT, tool_p -> dt_array_start);
+			index_length = strlen (index_s);
+
+			/* The task index is most likely to be towards the end of the id */
+			while ((match_p = strstr (match_p, index_s)) != NULL)
+				{
+					index_p = match_p;
+					++ match_p;
+				}
+
+			if (index_p)
+				{
+					const size_t prefix_length = index_p - first_id_s;
+					const char *suffix_s = index_p + index_length;
+					const size_t suffix_length = strlen (suffix_s);
+					uint32 task_index = tool_p -> dt_array_start;
+					uint32 i;
+
+					for (i = 0; i < tool_p -> dt_num_tasks; ++ i, task_index += tool_p -> dt_array_step)
+						{
+							const char *id_s = * ((tool_p -> dt_task_ids_ss) + i);
+							const size_t id_length = strlen (id_s);
+
+							sprintf (index_s, UINT32_FMT, task_index);
+							index_length = strlen (index_s);
+
+							if ((id_length != prefix_length + index_length + suffix_length) ||
+									(strncmp (id_s, first_id_s, prefix_length) != 0) ||
+									(strncmp (id_s + prefix_length, index_s, index_length) != 0) ||
+									(strcmp (id_s + prefix_length + index_length, suffix_s) != 0))
+								{
+									return false;
+								}
+						}
+
+					/* CopyToNewString copies the whole string for a length of 0 */
+					*prefix_ss = (prefix_length > 0) ? CopyToNewString (first_id_s, prefix_length, false) : EasyCopyToNewString ("");
+
+					if (*prefix_ss)
+						{
+							*suffix_ss = EasyCopyToNewString (suffix_s);
+
+							if (*suffix_ss)
+								{
+									return true;
+								}
+
+							FreeCopiedString (*prefix_ss);
+							*prefix_ss = NULL;
+						}
+				}
+		}
+
+	return false;
+}
+
+
+/*
+ * Keep the statuses of the tasks that have finished, since neither the
+ * DrmaaJobMonitor nor the scheduler will be able to report them indefinitely.
+ */
+static bool AddDrmaaToolFinalTaskStatusesToJSON (const DrmaaTool *tool_p, json_t *array_json_p)
+{
+	bool success_flag = true;
+
+	if (tool_p -> dt_final_task_statuses_p)
+		{
+			json_t *statuses_json_p = json_array ();
+
+			success_flag = false;
+
+			if (statuses_json_p)
+				{
+					uint32 i;
+
+					for (i = 0; i < tool_p -> dt_num_tasks; ++ i)
+						{
+							if (json_array_append_new (statuses_json_p, json_integer (* ((tool_p -> dt_final_task_statuses_p) + i))) != 0)
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add final status for task " UINT32_FMT " of %s", i, tool_p -> dt_id_s);
+									json_decref (statuses_json_p);
+									return false;
+								}
+						}
+
+					if (json_object_set_new (array_json_p, DRMAA_ARRAY_TASK_FINAL_STATUSES_S, statuses_json_p) == 0)
+						{
+							success_flag = true;
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add final task statuses to drmaa tool json");
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate final task statuses json");
+				}
+		}
+
+	return success_flag;
+}
+
+
+static bool GetDrmaaToolFinalTaskStatusesFromJSON (DrmaaTool *tool_p, const json_t *array_json_p)
+{
+	bool success_flag = true;
+	const json_t *statuses_json_p = json_object_get (array_json_p, DRMAA_ARRAY_TASK_FINAL_STATUSES_S);
+
+	if (statuses_json_p)
+		{
+			success_flag = false;
+
+			if (json_is_array (statuses_json_p) && (json_array_size (statuses_json_p) == tool_p -> dt_num_tasks) && (tool_p -> dt_num_tasks > 0))
+				{
+					OperationStatus *statuses_p = GetDrmaaToolFinalTaskStatus (tool_p, 0);
+
+					if (statuses_p)
+						{
+							uint32 i;
+
+							for (i = 0; i < tool_p -> dt_num_tasks; ++ i)
+								{
+									const json_t *status_json_p = json_array_get (statuses_json_p, i);
+
+									if (json_is_integer (status_json_p))
+										{
+											* (statuses_p + i) = (OperationStatus) json_integer_value (status_json_p);
+										}
+								}
+
+							success_flag = true;
+						}
+				}
+		}
+
+	return success_flag;
+}
@@ -0,0 +1,85 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * drmaa_stub.h
+ *
+ * Extra calls provided by the stand-in DRMAA library so that tests
+ * can see how much work the "scheduler" has been asked to do.
+ *
+ * The simulated job lifecycle is controlled by these environment
+ * variables which are read by drmaa_init ():
+ *
+ *   DRMAA_STUB_QUEUE_MS   How long each job stays queued, default 100.
+ *   DRMAA_STUB_RUN_MS     How long each job runs for, default 200.
+ *   DRMAA_STUB_FAIL_EVERY If greater than 0, every nth job submitted
+ *                         finishes with an exit code of 1, default 0.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef DRMAA_STUB_H_
+#define DRMAA_STUB_H_
+
+#include "drmaa.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Get the number of times that drmaa_job_ps () has been called
+ * since drmaa_init ().
+ */
+unsigned long drmaa_stub_get_num_job_ps_calls (void);
+
+
+/**
+ * Get the number of submission calls, i.e. drmaa_run_job () and
+ * drmaa_run_bulk_jobs (), since drmaa_init ().
+ */
+unsigned long drmaa_stub_get_num_submissions (void);
+
+
+/**
+ * Get the number of jobs, including each task of a job array,
+ * that have been created since drmaa_init ().
+ */
+unsigned long drmaa_stub_get_num_jobs (void);
+
+
+/**
+ * Get the argv of a job as a single space-separated string with
+ * any DRMAA_PLACEHOLDER_INCR values replaced by the job's task index.
+ *
+ * @return 0 on success or DRMAA_ERRNO_INVALID_JOB if the job is unknown.
+ */
+int drmaa_stub_get_job_command_line (const char *job_id, char *value, size_t value_len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRMAA_STUB_H_ */
@@ -0,0 +1,1143 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * drmaa_stub.c
+ *
+ * A stand-in DRMAA library that does not talk to any scheduler. Jobs
+ * are never actually run, instead each one is simulated as being queued
+ * and then running for a configurable time before finishing. This lets
+ * the DRMAA code be exercised and measured on a machine without a
+ * cluster. See drmaa_stub.h for the settings.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "drmaa_stub.h"
+
+
+#define STUB_MAX_ATTRS (32)
+
+
+typedef struct StubAttribute
+{
+	char *sa_name_s;
+	char *sa_value_s;
+	char **sa_values_ss;
+} StubAttribute;
+
+
+struct drmaa_job_template_s
+{
+	StubAttribute jt_attrs [STUB_MAX_ATTRS];
+	size_t jt_num_attrs;
+};
+
+
+struct drmaa_job_ids_s
+{
+	char **ji_ids_ss;
+	size_t ji_num_ids;
+	size_t ji_next;
+};
+
+
+typedef struct StubJob
+{
+	char sj_id_s [64];
+	char *sj_command_line_s;
+	long long sj_submit_ms;
+	long long sj_start_ms;
+	long long sj_end_ms;
+	int sj_exit_code;
+	int sj_aborted;
+	int sj_reaped;
+} StubJob;
+
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+
+static int s_active_flag = 0;
+
+static StubJob *s_jobs_p = NULL;
+static size_t s_num_jobs = 0;
+static size_t s_jobs_capacity = 0;
+
+static unsigned long s_next_id = 1;
+static unsigned long s_num_ps_calls = 0;
+static unsigned long s_num_submissions = 0;
+
+static long s_queue_ms = 100;
+static long s_run_ms = 200;
+static long s_fail_every = 0;
+
+
+static long long GetNowMs (void);
+
+static long GetEnvLong (const char *name_s, const long def);
+
+static void SetError (char *error_s, size_t error_len, const char *message_s);
+
+static StubAttribute *GetAttribute (drmaa_job_template_t *jt, const char *name_s, const int create_flag);
+
+static const StubAttribute *FindAttribute (const drmaa_job_template_t *jt, const char *name_s);
+
+static StubJob *AddJob (const drmaa_job_template_t *jt, const unsigned long id, const int task, const int bulk_flag);
+
+static StubJob *FindJob (const char *job_id);
+
+static int GetJobState (const StubJob *job_p, const long long now);
+
+static StubJob *FindFinishedJob (const char *job_id, int *any_pending_p, long long *next_end_p);
+
+static char *CreateCommandLine (const drmaa_job_template_t *jt, const int task);
+
+static void FreeAttribute (StubAttribute *attr_p);
+
+static int WaitOnCond (const long long deadline_ms, const long long until_ms);
+
+
+
+int drmaa_init (const char * contact, char *error_diagnosis, size_t error_diag_len)
+{
+	int res = DRMAA_ERRNO_SUCCESS;
+
+	(void) contact;
+
+	pthread_mutex_lock (&s_mutex);
+
+	if (!s_active_flag)
+		{
+			s_queue_ms = GetEnvLong ("DRMAA_STUB_QUEUE_MS", 100);
+			s_run_ms = GetEnvLong ("DRMAA_STUB_RUN_MS", 200);
+			s_fail_every = GetEnvLong ("DRMAA_STUB_FAIL_EVERY", 0);
+
+			s_num_ps_calls = 0;
+			s_num_submissions = 0;
+			s_active_flag = 1;
+		}
+	else
+		{
+			SetError (error_diagnosis, error_diag_len, "session already active");
+			res = DRMAA_ERRNO_ALREADY_ACTIVE_SESSION;
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	return res;
+}
+
+
+int drmaa_exit (char *error_diagnosis, size_t error_diag_len)
+{
+	int res = DRMAA_ERRNO_SUCCESS;
+
+	pthread_mutex_lock (&s_mutex);
+
+	if (s_active_flag)
+		{
+			size_t i;
+
+			for (i = 0; i < s_num_jobs; ++ i)
+				{
+					free ((s_jobs_p + i) -> sj_command_line_s);
+				}
+
+			free (s_jobs_p);
+			s_jobs_p = NULL;
+			s_num_jobs = 0;
+			s_jobs_capacity = 0;
+			s_active_flag = 0;
+
+			pthread_cond_broadcast (&s_cond);
+		}
+	else
+		{
+			SetError (error_diagnosis, error_diag_len, "no active session");
+			res = DRMAA_ERRNO_NO_ACTIVE_SESSION;
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	return res;
+}
+
+
+int drmaa_allocate_job_template (drmaa_job_template_t **jt, char *error_diagnosis, size_t error_diag_len)
+{
+	*jt = (drmaa_job_template_t *) calloc (1, sizeof (drmaa_job_template_t));
+
+	if (*jt)
+		{
+			return DRMAA_ERRNO_SUCCESS;
+		}
+
+	SetError (error_diagnosis, error_diag_len, "out of memory");
+	return DRMAA_ERRNO_NO_MEMORY;
+}
+
+
+int drmaa_delete_job_template (drmaa_job_template_t *jt, char * error_diagnosis, size_t error_diag_len)
+{
+	size_t i;
+
+	(void) error_diagnosis;
+	(void) error_diag_len;
+
+	for (i = 0; i < jt -> jt_num_attrs; ++ i)
+		{
+			FreeAttribute (jt -> jt_attrs + i);
+		}
+
+	free (jt);
+
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+int drmaa_set_attribute (drmaa_job_template_t *jt, const char *name, const char *value, char *error_diagnosis, size_t error_diag_len)
+{
+	StubAttribute *attr_p = GetAttribute (jt, name, 1);
+
+	if (attr_p)
+		{
+			char *copied_value_s = value ? strdup (value) : NULL;
+
+			if (copied_value_s || !value)
+				{
+					free (attr_p -> sa_value_s);
+					attr_p -> sa_value_s = copied_value_s;
+
+					return DRMAA_ERRNO_SUCCESS;
+				}
+		}
+
+	SetError (error_diagnosis, error_diag_len, "failed to set attribute");
+	return DRMAA_ERRNO_NO_MEMORY;
+}
+
+
+int drmaa_get_attribute (drmaa_job_template_t *jt, const char *name, char *value, size_t value_len, char *error_diagnosis, size_t error_diag_len)
+{
+	const StubAttribute *attr_p = FindAttribute (jt, name);
+
+	if (attr_p && attr_p -> sa_value_s)
+		{
+			snprintf (value, value_len, "%s", attr_p -> sa_value_s);
+			return DRMAA_ERRNO_SUCCESS;
+		}
+
+	SetError (error_diagnosis, error_diag_len, "unknown attribute");
+	return DRMAA_ERRNO_INVALID_ARGUMENT;
+}
+
+
+int drmaa_set_vector_attribute (drmaa_job_template_t *jt, const char *name, const char *value [], char *error_diagnosis, size_t error_diag_len)
+{
+	StubAttribute *attr_p = GetAttribute (jt, name, 1);
+
+	if (attr_p)
+		{
+			size_t num_values = 0;
+			char **values_ss;
+
+			while (value && value [num_values])
+				{
+					++ num_values;
+				}
+
+			values_ss = (char **) calloc (num_values + 1, sizeof (char *));
+
+			if (values_ss)
+				{
+					size_t i;
+
+					for (i = 0; i < num_values; ++ i)
+						{
+							values_ss [i] = strdup (value [i]);
+						}
+
+					if (attr_p -> sa_values_ss)
+						{
+							for (i = 0; attr_p -> sa_values_ss [i]; ++ i)
+								{
+									free (attr_p -> sa_values_ss [i]);
+								}
+
+							free (attr_p -> sa_values_ss);
+						}
+
+					attr_p -> sa_values_ss = values_ss;
+
+					return DRMAA_ERRNO_SUCCESS;
+				}
+		}
+
+	SetError (error_diagnosis, error_diag_len, "failed to set vector attribute");
+	return DRMAA_ERRNO_NO_MEMORY;
+}
+
+
+int drmaa_run_job (char *job_id, size_t job_id_len, const drmaa_job_template_t *jt, char *error_diagnosis, size_t error_diag_len)
+{
+	int res = DRMAA_ERRNO_NO_ACTIVE_SESSION;
+
+	pthread_mutex_lock (&s_mutex);
+
+	if (s_active_flag)
+		{
+			StubJob *job_p = AddJob (jt, s_next_id ++, 1, 0);
+
+			if (job_p)
+				{
+					++ s_num_submissions;
+					snprintf (job_id, job_id_len, "%s", job_p -> sj_id_s);
+					res = DRMAA_ERRNO_SUCCESS;
+				}
+			else
+				{
+					res = DRMAA_ERRNO_NO_MEMORY;
+				}
+
+			pthread_cond_broadcast (&s_cond);
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	if (res != DRMAA_ERRNO_SUCCESS)
+		{
+			SetError (error_diagnosis, error_diag_len, drmaa_strerror (res));
+		}
+
+	return res;
+}
+
+
+int drmaa_run_bulk_jobs (drmaa_job_ids_t **jobids, const drmaa_job_template_t *jt, int start, int end, int incr, char *error_diagnosis, size_t error_diag_len)
+{
+	int res = DRMAA_ERRNO_SUCCESS;
+
+	if ((start < 1) || (end < start) || (incr < 1))
+		{
+			SetError (error_diagnosis, error_diag_len, "invalid array range");
+			return DRMAA_ERRNO_INVALID_ARGUMENT;
+		}
+
+	*jobids = (drmaa_job_ids_t *) calloc (1, sizeof (drmaa_job_ids_t));
+
+	if (! (*jobids))
+		{
+			SetError (error_diagnosis, error_diag_len, "out of memory");
+			return DRMAA_ERRNO_NO_MEMORY;
+		}
+
+	(*jobids) -> ji_ids_ss = (char **) calloc (((end - start) / incr) + 1, sizeof (char *));
+
+	if (! ((*jobids) -> ji_ids_ss))
+		{
+			free (*jobids);
+			*jobids = NULL;
+			SetError (error_diagnosis, error_diag_len, "out of memory");
+			return DRMAA_ERRNO_NO_MEMORY;
+		}
+
+	pthread_mutex_lock (&s_mutex);
+
+	if (s_active_flag)
+		{
+			const unsigned long id = s_next_id ++;
+			int task;
+
+			for (task = start; (task <= end) && (res == DRMAA_ERRNO_SUCCESS); task += incr)
+				{
+					StubJob *job_p = AddJob (jt, id, task, 1);
+
+					if (job_p)
+						{
+							(*jobids) -> ji_ids_ss [(*jobids) -> ji_num_ids ++] = strdup (job_p -> sj_id_s);
+						}
+					else
+						{
+							res = DRMAA_ERRNO_NO_MEMORY;
+						}
+				}
+
+			++ s_num_submissions;
+			pthread_cond_broadcast (&s_cond);
+		}
+	else
+		{
+			res = DRMAA_ERRNO_NO_ACTIVE_SESSION;
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	if (res != DRMAA_ERRNO_SUCCESS)
+		{
+			drmaa_release_job_ids (*jobids);
+			*jobids = NULL;
+			SetError (error_diagnosis, error_diag_len, drmaa_strerror (res));
+		}
+
+	return res;
+}
+
+
+int drmaa_control (const char *jobid, int action, char *error_diagnosis, size_t error_diag_len)
+{
+	int res = DRMAA_ERRNO_INVALID_JOB;
+
+	pthread_mutex_lock (&s_mutex);
+
+	if (action == DRMAA_CONTROL_TERMINATE)
+		{
+			const long long now = GetNowMs ();
+			size_t i;
+
+			for (i = 0; i < s_num_jobs; ++ i)
+				{
+					StubJob *job_p = s_jobs_p + i;
+
+					if ((strcmp (jobid, DRMAA_JOB_IDS_SESSION_ALL) == 0) || (strcmp (jobid, job_p -> sj_id_s) == 0))
+						{
+							if (job_p -> sj_end_ms > now)
+								{
+									job_p -> sj_end_ms = now;
+									job_p -> sj_aborted = (job_p -> sj_start_ms > now);
+
+									if (job_p -> sj_start_ms > now)
+										{
+											job_p -> sj_start_ms = now;
+										}
+
+									job_p -> sj_exit_code = 143;
+								}
+
+							res = DRMAA_ERRNO_SUCCESS;
+						}
+				}
+
+			pthread_cond_broadcast (&s_cond);
+		}
+	else
+		{
+			res = (FindJob (jobid) != NULL) ? DRMAA_ERRNO_SUCCESS : DRMAA_ERRNO_INVALID_JOB;
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	if (res != DRMAA_ERRNO_SUCCESS)
+		{
+			SetError (error_diagnosis, error_diag_len, drmaa_strerror (res));
+		}
+
+	return res;
+}
+
+
+int drmaa_synchronize (const char *job_ids [], signed long timeout, int dispose, char *error_diagnosis, size_t error_diag_len)
+{
+	const long long deadline_ms = (timeout == DRMAA_TIMEOUT_WAIT_FOREVER) ? -1 : GetNowMs () + (timeout * 1000);
+	int res = DRMAA_ERRNO_SUCCESS;
+	int loop_flag = 1;
+
+	pthread_mutex_lock (&s_mutex);
+
+	while (loop_flag)
+		{
+			const long long now = GetNowMs ();
+			long long next_end_ms = -1;
+			int all_done_flag = 1;
+			size_t i;
+
+			for (i = 0; i < s_num_jobs; ++ i)
+				{
+					StubJob *job_p = s_jobs_p + i;
+					int wanted_flag = 0;
+					const char **id_ss = job_ids;
+
+					while (*id_ss && !wanted_flag)
+						{
+							if ((strcmp (*id_ss, DRMAA_JOB_IDS_SESSION_ALL) == 0) || (strcmp (*id_ss, job_p -> sj_id_s) == 0))
+								{
+									wanted_flag = 1;
+								}
+
+							++ id_ss;
+						}
+
+					if (wanted_flag && !job_p -> sj_reaped)
+						{
+							if (job_p -> sj_end_ms > now)
+								{
+									all_done_flag = 0;
+
+									if ((next_end_ms < 0) || (job_p -> sj_end_ms < next_end_ms))
+										{
+											next_end_ms = job_p -> sj_end_ms;
+										}
+								}
+						}
+				}
+
+			if (all_done_flag)
+				{
+					if (dispose)
+						{
+							for (i = 0; i < s_num_jobs; ++ i)
+								{
+									const char **id_ss = job_ids;
+
+									while (*id_ss)
+										{
+											if ((strcmp (*id_ss, DRMAA_JOB_IDS_SESSION_ALL) == 0) || (strcmp (*id_ss, (s_jobs_p + i) -> sj_id_s) == 0))
+												{
+													(s_jobs_p + i) -> sj_reaped = 1;
+												}
+
+											++ id_ss;
+										}
+								}
+						}
+
+					loop_flag = 0;
+				}
+			else if (WaitOnCond (deadline_ms, next_end_ms) == ETIMEDOUT)
+				{
+					res = DRMAA_ERRNO_EXIT_TIMEOUT;
+					loop_flag = 0;
+				}
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	if (res != DRMAA_ERRNO_SUCCESS)
+		{
+			SetError (error_diagnosis, error_diag_len, drmaa_strerror (res));
+		}
+
+	return res;
+}
+
+
+int drmaa_wait (const char *job_id, char *job_id_out, size_t job_id_out_len, int *stat, signed long timeout, drmaa_attr_values_t **rusage, char *error_diagnosis, size_t error_diag_len)
+{
+	const long long deadline_ms = (timeout == DRMAA_TIMEOUT_WAIT_FOREVER) ? -1 : GetNowMs () + (timeout * 1000);
+	int res = DRMAA_ERRNO_SUCCESS;
+	int loop_flag = 1;
+
+	if (rusage)
+		{
+			*rusage = NULL;
+		}
+
+	pthread_mutex_lock (&s_mutex);
+
+	while (loop_flag)
+		{
+			int any_pending_flag = 0;
+			long long next_end_ms = -1;
+			StubJob *job_p = FindFinishedJob (job_id, &any_pending_flag, &next_end_ms);
+
+			if (job_p)
+				{
+					job_p -> sj_reaped = 1;
+
+					if (job_id_out)
+						{
+							snprintf (job_id_out, job_id_out_len, "%s", job_p -> sj_id_s);
+						}
+
+					*stat = job_p -> sj_aborted ? -1 : job_p -> sj_exit_code;
+					loop_flag = 0;
+				}
+			else if (!any_pending_flag)
+				{
+					res = DRMAA_ERRNO_INVALID_JOB;
+					loop_flag = 0;
+				}
+			else if (WaitOnCond (deadline_ms, next_end_ms) == ETIMEDOUT)
+				{
+					res = DRMAA_ERRNO_EXIT_TIMEOUT;
+					loop_flag = 0;
+				}
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	if (res != DRMAA_ERRNO_SUCCESS)
+		{
+			SetError (error_diagnosis, error_diag_len, drmaa_strerror (res));
+		}
+
+	return res;
+}
+
+
+int drmaa_wifexited (int *exited, int stat, char * error_diagnosis, size_t error_diag_len)
+{
+	(void) error_diagnosis;
+	(void) error_diag_len;
+
+	*exited = (stat >= 0);
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+int drmaa_wexitstatus (int *exit_status, int stat, char * error_diagnosis, size_t error_diag_len)
+{
+	(void) error_diagnosis;
+	(void) error_diag_len;
+
+	*exit_status = (stat >= 0) ? stat : 0;
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+int drmaa_wifsignaled (int *signaled, int stat, char * error_diagnosis, size_t error_diag_len)
+{
+	(void) stat;
+	(void) error_diagnosis;
+	(void) error_diag_len;
+
+	*signaled = 0;
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+int drmaa_wtermsig (char *signal, size_t signal_len, int stat, char * error_diagnosis, size_t error_diag_len)
+{
+	(void) stat;
+	(void) error_diagnosis;
+	(void) error_diag_len;
+
+	snprintf (signal, signal_len, "%s", "");
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+int drmaa_wcoredump (int *core_dumped, int stat, char * error_diagnosis, size_t error_diag_len)
+{
+	(void) stat;
+	(void) error_diagnosis;
+	(void) error_diag_len;
+
+	*core_dumped = 0;
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+int drmaa_wifaborted (int *aborted, int stat, char * error_diagnosis, size_t error_diag_len)
+{
+	(void) error_diagnosis;
+	(void) error_diag_len;
+
+	*aborted = (stat < 0);
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+int drmaa_job_ps (const char *job_id, int *remote_ps, char *error_diagnosis, size_t error_diag_len)
+{
+	int res = DRMAA_ERRNO_INVALID_JOB;
+	StubJob *job_p;
+
+	pthread_mutex_lock (&s_mutex);
+
+	++ s_num_ps_calls;
+
+	job_p = FindJob (job_id);
+
+	if (job_p)
+		{
+			*remote_ps = GetJobState (job_p, GetNowMs ());
+			res = DRMAA_ERRNO_SUCCESS;
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	if (res != DRMAA_ERRNO_SUCCESS)
+		{
+			SetError (error_diagnosis, error_diag_len, drmaa_strerror (res));
+		}
+
+	return res;
+}
+
+
+int drmaa_get_next_job_id (drmaa_job_ids_t *values, char *value, size_t value_len)
+{
+	if (values -> ji_next < values -> ji_num_ids)
+		{
+			snprintf (value, value_len, "%s", values -> ji_ids_ss [values -> ji_next ++]);
+			return DRMAA_ERRNO_SUCCESS;
+		}
+
+	return DRMAA_ERRNO_NO_MORE_ELEMENTS;
+}
+
+
+int drmaa_get_num_job_ids (drmaa_job_ids_t *values, size_t *size)
+{
+	*size = values -> ji_num_ids;
+	return DRMAA_ERRNO_SUCCESS;
+}
+
+
+void drmaa_release_job_ids (drmaa_job_ids_t *values)
+{
+	if (values)
+		{
+			size_t i;
+
+			for (i = 0; i < values -> ji_num_ids; ++ i)
+				{
+					free (values -> ji_ids_ss [i]);
+				}
+
+			free (values -> ji_ids_ss);
+			free (values);
+		}
+}
+
+
+void drmaa_release_attr_values (drmaa_attr_values_t * values)
+{
+	(void) values;
+}
+
+
+const char *drmaa_strerror (int drmaa_errno)
+{
+	switch (drmaa_errno)
+		{
+			case DRMAA_ERRNO_SUCCESS:
+				return "success";
+
+			case DRMAA_ERRNO_INVALID_ARGUMENT:
+				return "invalid argument";
+
+			case DRMAA_ERRNO_NO_ACTIVE_SESSION:
+				return "no active session";
+
+			case DRMAA_ERRNO_NO_MEMORY:
+				return "out of memory";
+
+			case DRMAA_ERRNO_ALREADY_ACTIVE_SESSION:
+				return "session already active";
+
+			case DRMAA_ERRNO_INVALID_JOB:
+				return "invalid job";
+
+			case DRMAA_ERRNO_EXIT_TIMEOUT:
+				return "timed out";
+
+			case DRMAA_ERRNO_NO_MORE_ELEMENTS:
+				return "no more elements";
+
+			default:
+				return "internal error";
+		}
+}
+
+
+unsigned long drmaa_stub_get_num_job_ps_calls (void)
+{
+	unsigned long num_calls;
+
+	pthread_mutex_lock (&s_mutex);
+	num_calls = s_num_ps_calls;
+	pthread_mutex_unlock (&s_mutex);
+
+	return num_calls;
+}
+
+
+unsigned long drmaa_stub_get_num_submissions (void)
+{
+	unsigned long num_submissions;
+
+	pthread_mutex_lock (&s_mutex);
+	num_submissions = s_num_submissions;
+	pthread_mutex_unlock (&s_mutex);
+
+	return num_submissions;
+}
+
+
+unsigned long drmaa_stub_get_num_jobs (void)
+{
+	unsigned long num_jobs;
+
+	pthread_mutex_lock (&s_mutex);
+	num_jobs = (unsigned long) s_num_jobs;
+	pthread_mutex_unlock (&s_mutex);
+
+	return num_jobs;
+}
+
+
+int drmaa_stub_get_job_command_line (const char *job_id, char *value, size_t value_len)
+{
+	int res = DRMAA_ERRNO_INVALID_JOB;
+	StubJob *job_p;
+
+	pthread_mutex_lock (&s_mutex);
+
+	job_p = FindJob (job_id);
+
+	if (job_p)
+		{
+			snprintf (value, value_len, "%s", job_p -> sj_command_line_s ? job_p -> sj_command_line_s : "");
+			res = DRMAA_ERRNO_SUCCESS;
+		}
+
+	pthread_mutex_unlock (&s_mutex);
+
+	return res;
+}
+
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+
+static long long GetNowMs (void)
+{
+	struct timespec t;
+
+	clock_gettime (CLOCK_REALTIME, &t);
+
+	return (((long long) t.tv_sec) * 1000) + (t.tv_nsec / 1000000);
+}
+
+
+static long GetEnvLong (const char *name_s, const long def)
+{
+	const char *value_s = getenv (name_s);
+
+	if (value_s)
+		{
+			char *end_s = NULL;
+			long l = strtol (value_s, &end_s, 10);
+
+			if ((end_s != value_s) && (l >= 0))
+				{
+					return l;
+				}
+		}
+
+	return def;
+}
+
+
+static void SetError (char *error_s, size_t error_len, const char *message_s)
+{
+	if (error_s && (error_len > 0))
+		{
+			snprintf (error_s, error_len, "%s", message_s);
+		}
+}
+
+
+static StubAttribute *GetAttribute (drmaa_job_template_t *jt, const char *name_s, const int create_flag)
+{
+	size_t i;
+
+	for (i = 0; i < jt -> jt_num_attrs; ++ i)
+		{
+			if (strcmp (jt -> jt_attrs [i].sa_name_s, name_s) == 0)
+				{
+					return jt -> jt_attrs + i;
+				}
+		}
+
+	if (create_flag && (jt -> jt_num_attrs < STUB_MAX_ATTRS))
+		{
+			StubAttribute *attr_p = jt -> jt_attrs + jt -> jt_num_attrs;
+
+			attr_p -> sa_name_s = strdup (name_s);
+
+			if (attr_p -> sa_name_s)
+				{
+					++ (jt -> jt_num_attrs);
+					return attr_p;
+				}
+		}
+
+	return NULL;
+}
+
+
+static const StubAttribute *FindAttribute (const drmaa_job_template_t *jt, const char *name_s)
+{
+	return GetAttribute ((drmaa_job_template_t *) jt, name_s, 0);
+}
+
+
+static void FreeAttribute (StubAttribute *attr_p)
+{
+	free (attr_p -> sa_name_s);
+	free (attr_p -> sa_value_s);
+
+	if (attr_p -> sa_values_ss)
+		{
+			size_t i;
+
+			for (i = 0; attr_p -> sa_values_ss [i]; ++ i)
+				{
+					free (attr_p -> sa_values_ss [i]);
+				}
+
+			free (attr_p -> sa_values_ss);
+		}
+}
+
+
+/*
+ * This must be called with s_mutex held
+ */
+static StubJob *AddJob (const drmaa_job_template_t *jt, const unsigned long id, const int task, const int bulk_flag)
+{
+	StubJob *job_p;
+
+	if (s_num_jobs == s_jobs_capacity)
+		{
+			const size_t new_capacity = (s_jobs_capacity > 0) ? (s_jobs_capacity << 1) : 64;
+			StubJob *new_jobs_p = (StubJob *) realloc (s_jobs_p, new_capacity * sizeof (StubJob));
+
+			if (!new_jobs_p)
+				{
+					return NULL;
+				}
+
+			s_jobs_p = new_jobs_p;
+			s_jobs_capacity = new_capacity;
+		}
+
+	job_p = s_jobs_p + s_num_jobs;
+	memset (job_p, 0, sizeof (StubJob));
+
+	if (bulk_flag)
+		{
+			snprintf (job_p -> sj_id_s, sizeof (job_p -> sj_id_s), "%lu.%d", id, task);
+		}
+	else
+		{
+			snprintf (job_p -> sj_id_s, sizeof (job_p -> sj_id_s), "%lu", id);
+		}
+
+	job_p -> sj_command_line_s = CreateCommandLine (jt, task);
+	job_p -> sj_submit_ms = GetNowMs ();
+	job_p -> sj_start_ms = job_p -> sj_submit_ms + s_queue_ms;
+	job_p -> sj_end_ms = job_p -> sj_start_ms + s_run_ms;
+
+	++ s_num_jobs;
+
+	if ((s_fail_every > 0) && ((s_num_jobs % s_fail_every) == 0))
+		{
+			job_p -> sj_exit_code = 1;
+		}
+
+	return job_p;
+}
+
+
+/*
+ * This must be called with s_mutex held
+ */
+static StubJob *FindJob (const char *job_id)
+{
+	size_t i;
+
+	for (i = 0; i < s_num_jobs; ++ i)
+		{
+			if (strcmp ((s_jobs_p + i) -> sj_id_s, job_id) == 0)
+				{
+					return s_jobs_p + i;
+				}
+		}
+
+	return NULL;
+}
+
+
+static int GetJobState (const StubJob *job_p, const long long now)
+{
+	if (now < job_p -> sj_start_ms)
+		{
+			return DRMAA_PS_QUEUED_ACTIVE;
+		}
+	else if (now < job_p -> sj_end_ms)
+		{
+			return DRMAA_PS_RUNNING;
+		}
+	else if ((job_p -> sj_exit_code == 0) && (!job_p -> sj_aborted))
+		{
+			return DRMAA_PS_DONE;
+		}
+
+	return DRMAA_PS_FAILED;
+}
+
+
+/*
+ * This must be called with s_mutex held
+ */
+static StubJob *FindFinishedJob (const char *job_id, int *any_pending_p, long long *next_end_p)
+{
+	const int any_flag = (strcmp (job_id, DRMAA_JOB_IDS_SESSION_ANY) == 0);
+	const long long now = GetNowMs ();
+	size_t i;
+
+	for (i = 0; i < s_num_jobs; ++ i)
+		{
+			StubJob *job_p = s_jobs_p + i;
+
+			if ((!job_p -> sj_reaped) && (any_flag || (strcmp (job_p -> sj_id_s, job_id) == 0)))
+				{
+					if (job_p -> sj_end_ms <= now)
+						{
+							return job_p;
+						}
+
+					*any_pending_p = 1;
+
+					if ((*next_end_p < 0) || (job_p -> sj_end_ms < *next_end_p))
+						{
+							*next_end_p = job_p -> sj_end_ms;
+						}
+				}
+		}
+
+	return NULL;
+}
+
+
+static char *CreateCommandLine (const drmaa_job_template_t *jt, const int task)
+{
+	const StubAttribute *command_p = FindAttribute (jt, DRMAA_REMOTE_COMMAND);
+	const StubAttribute *args_p = FindAttribute (jt, DRMAA_V_ARGV);
+	size_t length = 1;
+	char *command_line_s;
+	char task_s [16];
+	size_t i;
+
+	snprintf (task_s, sizeof (task_s), "%d", task);
+
+	if (command_p && command_p -> sa_value_s)
+		{
+			length += strlen (command_p -> sa_value_s);
+		}
+
+	if (args_p && args_p -> sa_values_ss)
+		{
+			for (i = 0; args_p -> sa_values_ss [i]; ++ i)
+				{
+					/* allow for every character to be a placeholder */
+					length += 1 + (strlen (args_p -> sa_values_ss [i]) * strlen (task_s));
+				}
+		}
+
+	command_line_s = (char *) calloc (length, sizeof (char));
+
+	if (command_line_s)
+		{
+			char *dest_s = command_line_s;
+
+			if (command_p && command_p -> sa_value_s)
+				{
+					strcpy (dest_s, command_p -> sa_value_s);
+					dest_s += strlen (dest_s);
+				}
+
+			if (args_p && args_p -> sa_values_ss)
+				{
+					for (i = 0; args_p -> sa_values_ss [i]; ++ i)
+						{
+							const char *src_s = args_p -> sa_values_ss [i];
+							const size_t ph_length = strlen (DRMAA_PLACEHOLDER_INCR);
+
+							*dest_s ++ = ' ';
+
+							while (*src_s)
+								{
+									if (strncmp (src_s, DRMAA_PLACEHOLDER_INCR, ph_length) == 0)
+										{
+											strcpy (dest_s, task_s);
+											dest_s += strlen (task_s);
+											src_s += ph_length;
+										}
+									else
+										{
+											*dest_s ++ = *src_s ++;
+										}
+								}
+						}
+				}
+
+			*dest_s = '\0';
+		}
+
+	return command_line_s;
+}
+
+
+/*
+ * Wait on s_cond until either the deadline passes, in which case
+ * ETIMEDOUT is returned, or until the next job is due to finish or
+ * someone signals a change. This must be called with s_mutex held.
+ */
+static int WaitOnCond (const long long deadline_ms, const long long until_ms)
+{
+	long long wake_ms = until_ms;
+	struct timespec t;
+	int res;
+
+	if ((deadline_ms >= 0) && ((wake_ms < 0) || (deadline_ms < wake_ms)))
+		{
+			wake_ms = deadline_ms;
+		}
+
+	if (wake_ms < 0)
+		{
+			pthread_cond_wait (&s_cond, &s_mutex);
+			return 0;
+		}
+
+	t.tv_sec = wake_ms / 1000;
+	t.tv_nsec = (wake_ms % 1000) * 1000000;
+
+	res = pthread_cond_timedwait (&s_cond, &s_mutex, &t);
+
+	if ((res == ETIMEDOUT) && ((deadline_ms < 0) || (GetNowMs () < deadline_ms)))
+		{
+			/* We woke up for a job finishing rather than the deadline */
+			res = 0;
+		}
+
+	return res;
+}
@@ -33,6 +33,8 @@
 #include "mongo_client_manager.h"
 #include "string_utils.h"
 #include "time_util.h"
+#include "metrics.h"
+#include "tracing.h"
 
 
 static bool AddSimpleTypeToQuery (bson_t *query_p, const char *key_s, const json_t *value_p);
@@ -50,6 +52,8 @@ static bson_t *MakeQuery (const char **keys_ss, const size_t num_keys, const jso
 
 static bool AddCollectionIndex (MongoTool *tool_p, const char *database_s, const char * const collection_s, bson_t *keys_p, const bool unique_flag, const bool sparse_flag);
 
+static void RecordMongoMetric (const MongoTool *tool_p, const char *op_s, const uint64 start_time, const bool success_flag);
+
 
 #ifdef _DEBUG
 #define MONGODB_TOOL_DEBUG	(STM_LEVEL_INFO)
@@ -550,7 +554,10 @@ bson_oid_t *InsertJSONIntoMongoCollection (MongoTool *tool_p, json_t *json_p)
 							if (BSON_APPEND_OID (bson_p, MONGO_ID_S, id_p))
 								{
 									bson_error_t error;
+									const uint64 start_time = GetMetricsTime ();
+
 									success_flag = mongoc_collection_insert (tool_p -> mt_collection_p, MONGOC_INSERT_NONE, bson_p, NULL, &error);
+									RecordMongoMetric (tool_p, "insert", start_time, success_flag);
 
 									if (!success_flag)
 										{
@@ -818,6 +825,7 @@ bool UpdateMongoDocumentsByBSON (MongoTool *tool_p, const bson_t *query_p, const
 							if (bson_append_document (update_statement_p, "$set", -1, data_p))
 								{
 									bson_error_t error;
+									const uint64 start_time = GetMetricsTime ();
 
 #if MONGODB_TOOL_DEBUG >= STM_LEVEL_FINE
 									PrintBSONToLog (STM_LEVEL_FINE, __FILE__, __LINE__, query_p, "UpdateMongoDocument query_p");
@@ -833,6 +841,8 @@ bool UpdateMongoDocumentsByBSON (MongoTool *tool_p, const bson_t *query_p, const
 											success_flag = mongoc_collection_update_one (tool_p -> mt_collection_p, query_p, update_statement_p, NULL, NULL, &error);
 										}
 
+									RecordMongoMetric (tool_p, "update", start_time, success_flag);
+
 								}		/* if (bson_append_document (update_statement_p, "$set", -1, bson_p)) */
 
 							bson_destroy (update_statement_p);
@@ -872,12 +882,15 @@ bool RemoveMongoDocumentsByBSON (MongoTool *tool_p, const bson_t *selector_p, co
 		{
 			bson_error_t error;
 			mongoc_remove_flags_t flags = remove_first_match_only_flag ? MONGOC_REMOVE_SINGLE_REMOVE : MONGOC_REMOVE_NONE;
+			const uint64 start_time = GetMetricsTime ();
 
 			if (mongoc_collection_remove (tool_p -> mt_collection_p, flags, selector_p, NULL, &error))
 				{
 					success_flag = true;
 				}		/* if (mongoc_collection_update (tool_p -> mt_collection_p, MONGOC_UPDATE_NONE, query_p, update_statement_p, NULL, &error)) */
 
+			RecordMongoMetric (tool_p, "remove", start_time, success_flag);
+
 		}		/* if (tool_p -> mt_collection_p) */
 
 	return success_flag;
@@ -1403,19 +1416,27 @@ bool FindMatchingMongoDocumentsByBSON (MongoTool *tool_p, const bson_t *query_p,
 #endif
 
 
-			cursor_p = mongoc_collection_find_with_opts (tool_p -> mt_collection_p, query_p, extra_opts_p, NULL);
+			{
+				const uint64 start_time = GetMetricsTime ();
 
-			if (cursor_p)
-				{
-					if (tool_p -> mt_cursor_p)
-						{
-							mongoc_cursor_destroy (tool_p -> mt_cursor_p);
-						}
+				cursor_p = mongoc_collection_find_with_opts (tool_p -> mt_collection_p, query_p, extra_opts_p, NULL);
 
-					tool_p -> mt_cursor_p = cursor_p;
-					success_flag = HasMongoQueryResults (tool_p);
-					//success_flag = true;
-				}
+				if (cursor_p)
+					{
+						if (tool_p -> mt_cursor_p)
+							{
+								mongoc_cursor_destroy (tool_p -> mt_cursor_p);
+							}
+
+						tool_p -> mt_cursor_p = cursor_p;
+
+						/* The query is only sent to the server once the cursor is first used */
+						success_flag = HasMongoQueryResults (tool_p);
+						//success_flag = true;
+					}
+
+				RecordMongoMetric (tool_p, "find", start_time, cursor_p != NULL);
+			}
 
 
 			if (fields_p)
@@ -1723,8 +1744,11 @@ int32 IsKeyValuePairInCollection (MongoTool *tool_p, const char *database_s, con
 int64 GetNumberOfMongoResults (MongoTool *tool_p, bson_t *query_p, bson_t *extra_opts_p)
 {
 	bson_error_t error;
+	const uint64 start_time = GetMetricsTime ();
 	int64_t count = mongoc_collection_count_documents (tool_p -> mt_collection_p, query_p, extra_opts_p, NULL, NULL, &error);
 
+	RecordMongoMetric (tool_p, "count", start_time, count != -1);
+
 	if (count == -1)
 		{
 			PrintBSONToErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, query_p, "failed to count documents: %s", error.message);
@@ -1930,9 +1954,12 @@ bool InsertMongoDataAsBSON (MongoTool *tool_p, const bson_t *doc_p, bson_t **rep
 	bson_t *opts_p = NULL;
 	bson_t reply;
 
+	const uint64 start_time = GetMetricsTime ();
+
 	*reply_pp = NULL;
 
 	success_flag = mongoc_collection_insert_one (tool_p -> mt_collection_p, doc_p, opts_p, &reply, error_p);
+	RecordMongoMetric (tool_p, "insert", start_time, success_flag);
 
 	if (success_flag)
 		{
@@ -2096,7 +2123,10 @@ bool UpdateMongoDataAsBSON (MongoTool *tool_p, const char * const update_s, bson
 #endif
 
 
+					const uint64 start_time = GetMetricsTime ();
+
 					success_flag = mongoc_collection_update_one (tool_p -> mt_collection_p, selector_p, update_p, opts_p, &reply, &error);
+					RecordMongoMetric (tool_p, "update", start_time, success_flag);
 
 					if (success_flag)
 						{
@@ -2144,8 +2174,10 @@ bool RunMongoCommand (MongoTool *tool_p, bson_t *command_p, bson_t **reply_pp)
 	bool success_flag = false;
 	bson_t reply;
 	bson_error_t error;
+	const uint64 start_time = GetMetricsTime ();
 
 	success_flag = mongoc_collection_command_simple (tool_p -> mt_collection_p, command_p, NULL, &reply, &error);
+	RecordMongoMetric (tool_p, "command", start_time, success_flag);
 
 	if (success_flag)
 		{
@@ -2757,3 +2789,25 @@ bool AddQueryTerm (bson_t *query_p, const char *key_s, const char *value_s, bool
 
 	return success_flag;
 }
+
+
+/*
+ * Record the time taken by a call on the current collection
+ * under a label such as "fields.find".
+ */
+static void RecordMongoMetric (const MongoTool *tool_p, const char *op_s, const uint64 start_time, const bool success_flag)
+{
+	char label_s [METRICS_LABEL_SIZE];
+	const char *collection_s = (tool_p -> mt_collection_p) ? mongoc_collection_get_name (tool_p -> mt_collection_p) : NULL;
+
+	snprintf (label_s, sizeof (label_s), "%s.%s", collection_s ? collection_s : "", op_s);
+	RecordMetric (METRICS_MONGODB_S, label_s, start_time, success_flag);
+
+	if (IsTracingEnabled ())
+		{
+			char span_name_s [SPAN_NAME_SIZE];
+
+			snprintf (span_name_s, sizeof (span_name_s), "mongodb %s", label_s);
+			RecordCompletedSpan (span_name_s, SK_CLIENT, start_time, success_flag);
+		}
+}
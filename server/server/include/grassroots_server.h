@@ -40,6 +40,7 @@ struct JobsManager;
 struct ServersManager;
 struct MongoClientManager;
 struct Service;
+struct RequestCoalescer;
 
 
 typedef struct GrassrootsServer
@@ -104,6 +105,30 @@ typedef struct GrassrootsServer
 
 	struct MongoClientManager *gs_mongo_manager_p;
 
+	/**
+	 * Has the Server replaced the default OutputStreams with
+	 * the ones from its logging configuration?
+	 */
+	bool gs_custom_logging_flag;
+
+	/**
+	 * Has the Server started writing trace Spans from
+	 * its tracing configuration?
+	 */
+	bool gs_tracing_flag;
+
+	/**
+	 * The RequestCoalescer for sharing the responses of identical
+	 * concurrent requests or <code>NULL</code> if it isn't configured.
+	 */
+	struct RequestCoalescer *gs_request_coalescer_p;
+
+	/**
+	 * The RawConnectionServer serving requests from RawConnection
+	 * Clients or <code>NULL</code> if it isn't configured.
+	 */
+	struct RawConnectionServer *gs_raw_connection_server_p;
+
 //	struct PersistentServiceData *gs_persistent_service_data_p;
 } GrassrootsServer;
 
@@ -218,6 +243,21 @@ GRASSROOTS_SERVICE_MANAGER_API void LoadKeywordServices (GrassrootsServer *grass
 GRASSROOTS_SERVICE_MANAGER_API json_t *ProcessServerJSONMessage (GrassrootsServer *grassroots_p, json_t *json_req_p, User *user_p, const char **error_ss);
 
 
+/**
+ * Process a request received by a RawConnectionServer. This can be used
+ * as the RawConnectionRequestHandler for a RawConnectionServer so that it
+ * serves requests in the same way as ProcessServerJSONMessage ().
+ *
+ * @param req_p The incoming JSON request.
+ * @param grassroots_p The GrassrootsServer that will process the request.
+ * @return The response from the server. If the request failed, this
+ * will contain the error message.
+ * @memberof GrassrootsServer
+ * @ingroup server_group
+ */
+GRASSROOTS_SERVICE_MANAGER_API json_t *ProcessServerRawConnectionRequest (json_t *req_p, void *grassroots_p);
+
+
 /**
  * Create a response object with a valid header and a given key and value.
  *
@@ -0,0 +1,147 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * keyword_search.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A KeywordSearch runs a keyword against a number of Services at the same
+ * time rather than one after another, so that a search takes about as long
+ * as the slowest Service rather than the sum of them all. The Services are
+ * run by a bounded number of worker threads and their results are merged
+ * as each one finishes. If the search's deadline passes before every
+ * Service has finished, the results that are ready are returned and the
+ * rest are discarded when they eventually complete.
+ */
+
+#ifndef KEYWORD_SEARCH_H
+#define KEYWORD_SEARCH_H
+
+#include "jansson.h"
+
+#include "grassroots_service_manager_library.h"
+#include "service.h"
+#include "user_details.h"
+
+
+/**
+ * The default number of Services that a KeywordSearch will run at once.
+ *
+ * @ingroup server_group
+ */
+#define KEYWORD_SEARCH_DEFAULT_MAX_WORKERS (8)
+
+
+/**
+ * The default time in milliseconds that a KeywordSearch will wait for its
+ * Services to finish.
+ *
+ * @ingroup server_group
+ */
+#define KEYWORD_SEARCH_DEFAULT_TIMEOUT (30000)
+
+
+/**
+ * @brief A keyword search that runs its Services in parallel.
+ *
+ * @ingroup server_group
+ */
+typedef struct KeywordSearch KeywordSearch;
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Create a KeywordSearch.
+ *
+ * The deadline for the search starts from when this is called.
+ *
+ * @param keyword_s The keyword to search for.
+ * @param user_p The User running the search. The KeywordSearch takes ownership
+ * of this and frees it once all of its Services have finished.
+ * @param paired_servers_p The paired Servers from the request, used to create
+ * a ProvidersStateTable for each Service. This can be <code>NULL</code>.
+ * @param results_p The JSON array that the Services' results will be added to.
+ * @param max_num_services The most Services that will be added to the search.
+ * @param max_num_workers The most Services that will be run at the same time.
+ * @param timeout The time in milliseconds to wait for the Services to finish.
+ * @return The new KeywordSearch or <code>NULL</code> upon error.
+ * @memberof KeywordSearch
+ */
+GRASSROOTS_SERVICE_MANAGER_API KeywordSearch *AllocateKeywordSearch (const char *keyword_s, User *user_p, const json_t *paired_servers_p, json_t *results_p, const uint32 max_num_services, const uint32 max_num_workers, const uint32 timeout);
+
+
+/**
+ * Add a Service to a KeywordSearch and start running it as soon as there is
+ * a free worker.
+ *
+ * @param search_p The KeywordSearch to add the Service to.
+ * @param service_p The Service to run. The KeywordSearch takes ownership of this.
+ * @return <code>true</code> if the Service was added successfully, <code>false</code>
+ * otherwise in which case the caller still owns the Service.
+ * @memberof KeywordSearch
+ */
+GRASSROOTS_SERVICE_MANAGER_API bool AddServiceToKeywordSearch (KeywordSearch *search_p, Service *service_p);
+
+
+/**
+ * Wait until either all of the Services in a KeywordSearch have finished or its
+ * deadline has passed. After this has been called, no more results will be added
+ * to the KeywordSearch's results array.
+ *
+ * @param search_p The KeywordSearch to wait for.
+ * @param incomplete_services_p If this is not <code>NULL</code>, the names of any
+ * Services that hadn't finished by the deadline are appended to this JSON array.
+ * @return The number of Services that hadn't finished.
+ * @memberof KeywordSearch
+ */
+GRASSROOTS_SERVICE_MANAGER_API uint32 WaitForKeywordSearch (KeywordSearch *search_p, json_t *incomplete_services_p);
+
+
+/**
+ * Free a KeywordSearch. Any of its Services that are still running keep it
+ * alive until they finish, after which it is freed.
+ *
+ * @param search_p The KeywordSearch to free.
+ * @memberof KeywordSearch
+ */
+GRASSROOTS_SERVICE_MANAGER_API void FreeKeywordSearch (KeywordSearch *search_p);
+
+
+/**
+ * Wait for the worker threads of every KeywordSearch to finish, including
+ * those that are still running Services for searches that have already
+ * returned. This must be called before the Services' plugins are unloaded.
+ *
+ * @ingroup server_group
+ */
+GRASSROOTS_SERVICE_MANAGER_API void WaitForKeywordSearchWorkers (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* KEYWORD_SEARCH_H */
@@ -0,0 +1,147 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * request_coalescer.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * Clients often send identical read-only requests, such as listing the
+ * available Services, at the same moment, e.g. when a portal restarts.
+ * A RequestCoalescer lets the first of these requests do the work while
+ * any identical ones that arrive before it finishes wait for it and get
+ * copies of its response. Responses can also be kept for a short time
+ * afterwards so that requests arriving just after it has finished can
+ * use them too.
+ *
+ * Requests are identical if they are for the same Operation, come from
+ * the same User and have the same JSON once their keys are sorted.
+ * Requests from a User that has neither an id nor an email address are
+ * never coalesced since there is no way to tell which User they are from.
+ */
+
+#ifndef REQUEST_COALESCER_H
+#define REQUEST_COALESCER_H
+
+#include "jansson.h"
+
+#include "grassroots_service_manager_library.h"
+#include "grassroots_server.h"
+#include "operation.h"
+#include "user_details.h"
+
+
+/**
+ * The default time in milliseconds that a RequestCoalescer keeps
+ * a response for after its request has finished.
+ *
+ * @ingroup server_group
+ */
+#define REQUEST_COALESCER_DEFAULT_TTL (1000)
+
+
+/**
+ * @brief Share the responses of identical concurrent read-only requests.
+ *
+ * @ingroup server_group
+ */
+typedef struct RequestCoalescer RequestCoalescer;
+
+
+/**
+ * The function that does the work for a request that a RequestCoalescer
+ * hasn't got a response for.
+ *
+ * @param grassroots_p The GrassrootsServer that the request is for.
+ * @param op The Operation to run.
+ * @param req_p The request.
+ * @param user_p The User making the request. This can be <code>NULL</code>.
+ * @return The response or <code>NULL</code> upon error.
+ * @ingroup server_group
+ */
+typedef json_t *(*CoalescedOperationFn) (GrassrootsServer *grassroots_p, const Operation op, const json_t *req_p, User *user_p);
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Create a RequestCoalescer from the Server's configuration.
+ *
+ * @param config_p The ::REQUEST_COALESCING_S object from the Server's configuration.
+ * Its ::REQUEST_COALESCING_OPERATIONS_S array lists the Operations to coalesce and
+ * its optional ::REQUEST_COALESCING_TTL_S value is the time in milliseconds to keep
+ * each response for.
+ * @return The new RequestCoalescer or <code>NULL</code> if no Operations were
+ * enabled or upon error.
+ * @memberof RequestCoalescer
+ */
+GRASSROOTS_SERVICE_MANAGER_API RequestCoalescer *AllocateRequestCoalescer (const json_t *config_p);
+
+
+/**
+ * Free a RequestCoalescer. This must only be called once no requests
+ * are using it.
+ *
+ * @param coalescer_p The RequestCoalescer to free.
+ * @memberof RequestCoalescer
+ */
+GRASSROOTS_SERVICE_MANAGER_API void FreeRequestCoalescer (RequestCoalescer *coalescer_p);
+
+
+/**
+ * Check whether a RequestCoalescer has been configured to coalesce
+ * requests for a given Operation.
+ *
+ * @param coalescer_p The RequestCoalescer to check. This can be <code>NULL</code>.
+ * @param op The Operation to check.
+ * @return <code>true</code> if requests for the Operation are coalesced,
+ * <code>false</code> otherwise.
+ * @memberof RequestCoalescer
+ */
+GRASSROOTS_SERVICE_MANAGER_API bool IsOperationCoalesced (const RequestCoalescer *coalescer_p, const Operation op);
+
+
+/**
+ * Get the response for a request, either by running it or by sharing
+ * the response of an identical request that is already running or that
+ * finished within the RequestCoalescer's time to live.
+ *
+ * @param coalescer_p The RequestCoalescer to use.
+ * @param grassroots_p The GrassrootsServer that the request is for.
+ * @param op The Operation to run.
+ * @param req_p The request.
+ * @param user_p The User making the request. This can be <code>NULL</code>.
+ * @param run_fn The function to call if the request needs to be run.
+ * @return The response, which the caller is responsible for freeing, or
+ * <code>NULL</code> upon error.
+ * @memberof RequestCoalescer
+ */
+GRASSROOTS_SERVICE_MANAGER_API json_t *RunCoalescedOperation (RequestCoalescer *coalescer_p, GrassrootsServer *grassroots_p, const Operation op, const json_t *req_p, User *user_p, CoalescedOperationFn run_fn);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* REQUEST_COALESCER_H */
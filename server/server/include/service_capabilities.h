@@ -0,0 +1,110 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * service_capabilities.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * The Services are loaded afresh from their plugins for each request, so
+ * the keyword and resource ServiceMatchers would otherwise have to work
+ * out the same details every time. The capability index stores these
+ * details the first time that each Service needs them so that matching
+ * becomes a lookup. Matching by name, alias or plugin name is already
+ * cheap so those ServiceMatchers don't use the index.
+ */
+
+#ifndef SERVICE_CAPABILITIES_H
+#define SERVICE_CAPABILITIES_H
+
+#include "grassroots_service_manager_library.h"
+#include "service.h"
+
+
+/**
+ * @brief The details of a Service that the ServiceMatchers use.
+ *
+ * @ingroup services_group
+ */
+typedef struct ServiceCapabilities
+{
+	/** Does the Service have a Parameter of type PT_KEYWORD? */
+	bool sc_keyword_flag;
+
+	/**
+	 * Has sc_keyword_flag been worked out yet? This is only done when a
+	 * keyword search first needs it.
+	 */
+	bool sc_keyword_known_flag;
+
+	/** Can the Service check whether it can run on a given DataResource? */
+	bool sc_resource_match_flag;
+} ServiceCapabilities;
+
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Get the ServiceCapabilities for a Service, adding them to the
+ * capability index the first time that the Service is seen.
+ *
+ * @param service_p The Service to get the ServiceCapabilities for.
+ * @return The ServiceCapabilities or <code>NULL</code> upon error. These
+ * stay valid until FreeServiceCapabilitiesIndex () is called.
+ * @memberof ServiceCapabilities
+ */
+GRASSROOTS_SERVICE_MANAGER_API const ServiceCapabilities *GetServiceCapabilities (Service *service_p);
+
+
+/**
+ * Check whether a Service has a Parameter of type PT_KEYWORD. The answer
+ * is worked out from the Service's ParameterSetTemplate or cached
+ * description if it has either, only falling back to getting the
+ * Service's Parameters if not, and is then stored in the capability
+ * index.
+ *
+ * @param service_p The Service to check.
+ * @return <code>true</code> if the Service has a keyword Parameter,
+ * <code>false</code> otherwise.
+ * @memberof ServiceCapabilities
+ */
+GRASSROOTS_SERVICE_MANAGER_API bool IsKeywordService (Service *service_p);
+
+
+/**
+ * Free the capability index. This should only be called when nothing is
+ * still using any of its ServiceCapabilities, e.g. when the Grassroots
+ * Server is shutting down.
+ *
+ * @ingroup services_group
+ */
+GRASSROOTS_SERVICE_MANAGER_API void FreeServiceCapabilitiesIndex (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* SERVICE_CAPABILITIES_H */
@@ -25,16 +25,32 @@
 
 #include "grassroots_server.h"
 #include "memory_allocations.h"
+#include "memory_arena.h"
 #include "streams.h"
 
 #include "service_matcher.h"
 #include "jobs_manager.h"
 #include "mongo_client_manager.h"
 #include "key_value_pair.h"
+#include "raw_connection_server.h"
 #include "handler_utils.h"
 #include "time_util.h"
 #include "provider.h"
 #include "string_parameter.h"
+#include "parameter_set_template.h"
+#include "service_description_cache.h"
+#include "file_output_stream.h"
+#include "json_output_stream.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "service_capabilities.h"
+#include "keyword_search.h"
+#include "request_coalescer.h"
+#include "string_intern.h"
+
+#ifndef _WIN32
+#include "async_output_stream.h"
+#endif
 #include "uuid_util.h"
 
 #include "service_util.h"
@@ -55,6 +71,12 @@ static json_t *GetAllModifiedData(const json_t *const req_p,
 #endif
 
 
+/* The metrics labels for requests that aren't a single Operation */
+static const char * const S_RUN_SERVICES_METRIC_S = "run_services";
+
+static const char * const S_PROXY_METRIC_S = "proxy";
+
+
 static json_t *LoadConfig (const char *root_path_s, const char *config_filename_s);
 
 
@@ -68,7 +90,7 @@ static json_t *GetInterestedServices (GrassrootsServer *grassroots_p, const json
 
 static json_t *GetAllServices (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p);
 
-static json_t *RunKeywordServices (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p, const char *keyword_s);
+static json_t *RunKeywordServices (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p);
 
 static json_t *GetServiceResultsAsJSON (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p);
 
@@ -93,6 +115,8 @@ static bool AddServiceDataToJSON (GrassrootsServer *grassroots_p, json_t *result
 
 static json_t *GetServerStatus (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p);
 
+static json_t *GetServerMetrics (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p);
+
 static json_t *GetRequestedResource (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p);
 
 static json_t *GenerateNamedServices (GrassrootsServer *grassroots_p, LinkedList *services_p, const json_t * const req_p, User *user_p, ProvidersStateTable *providers_p);
@@ -113,12 +137,28 @@ static const char *GetProviderElement (const GrassrootsServer *grassroots_p, con
 
 static struct MongoClientManager *GetMongoClientManager (const json_t *config_p);
 
+static bool InitLogging (const json_t *config_p);
+
+static void ExitLogging (void);
+
+static bool InitTracingFromConfig (const GrassrootsServer *grassroots_p);
+
+static RequestCoalescer *GetRequestCoalescerFromConfig (const json_t *config_p);
+
+static RawConnectionServer *StartRawConnectionServerFromConfig (GrassrootsServer *grassroots_p);
+
+static json_t *RunOperation (GrassrootsServer *grassroots_p, const Operation op, const json_t *req_p, User *user_p);
+
+static OutputStream *AllocateLoggingStream (const json_t *logging_config_p, const char *filename_key_s, FILE *default_f, const uint32 level, const bool json_flag);
+
 static DataResource *GetResourceFromRequest (const json_t *req_p);
 
 static void ProcessServiceRequest (const json_t *service_req_p, json_t *services_res_p, GrassrootsServer *grassroots_p, ProvidersStateTable *providers_p, const char *server_s, User *user_p, Operation op);
 
 static int8 RunServiceFromJSON (GrassrootsServer *grassroots_p, Service *service_p, const json_t *service_req_p, const json_t *paired_servers_req_p, User *user_p, json_t *res_p);
 
+static bool ValidateServiceParameters (Service *service_p, const ParameterValidator *validator_p, const ParameterSet *params_p, json_t *res_p);
+
 static int8 RefreshServiceFromJSON (GrassrootsServer *grassroots_p, Service *service_p, json_t *service_req_p, const json_t *paired_servers_req_p, User *user_p, json_t *res_p);
 
 static int8 GetServiceIndexingInformation (GrassrootsServer *grassroots_p, Service *service_p, const json_t *service_req_p, const json_t *paired_servers_req_p, User *user_p, json_t *res_p);
@@ -225,6 +265,10 @@ GrassrootsServer *AllocateGrassrootsServer (const char *grassroots_path_s, const
 
 																							grassroots_p -> gs_mongo_manager_p = mongo_manager_p;
 
+																							grassroots_p -> gs_custom_logging_flag = InitLogging (config_p);
+																							grassroots_p -> gs_tracing_flag = InitTracingFromConfig (grassroots_p);
+																							grassroots_p -> gs_request_coalescer_p = GetRequestCoalescerFromConfig (config_p);
+
 																							/*
 																							 * Load the jobs manager
 																							 */
@@ -260,6 +304,9 @@ GrassrootsServer *AllocateGrassrootsServer (const char *grassroots_path_s, const
 																									ConnectToExternalServers (grassroots_p);
 																								}
 
+																							/* This serves requests straight away so it needs everything else to be ready */
+																							grassroots_p -> gs_raw_connection_server_p = StartRawConnectionServerFromConfig (grassroots_p);
+
 
 
 																							/*
@@ -367,6 +414,20 @@ GrassrootsServer *AllocateGrassrootsServer (const char *grassroots_path_s, const
 
 void FreeGrassrootsServer (GrassrootsServer *server_p)
 {
+	/* Stop taking requests before anything that they use is freed */
+	if (server_p -> gs_raw_connection_server_p)
+		{
+			#ifdef LINUX
+			FreeRawConnectionServer (server_p -> gs_raw_connection_server_p);
+			#endif
+		}
+
+	/*
+	 * Any late keyword search workers may still be running Services, so let
+	 * them finish before anything that they use is freed or unloaded.
+	 */
+	WaitForKeywordSearchWorkers ();
+
 	if (server_p -> gs_jobs_manager_p)
 		{
 			switch (server_p -> gs_jobs_manager_mem)
@@ -384,6 +445,21 @@ void FreeGrassrootsServer (GrassrootsServer *server_p)
 
 	DisconnectFromExternalServers (server_p);
 
+	if (server_p -> gs_custom_logging_flag)
+		{
+			ExitLogging ();
+		}
+
+	if (server_p -> gs_tracing_flag)
+		{
+			ExitTracing ();
+		}
+
+	if (server_p -> gs_request_coalescer_p)
+		{
+			FreeRequestCoalescer (server_p -> gs_request_coalescer_p);
+		}
+
 
 	if (server_p -> gs_servers_manager_p)
 		{
@@ -419,6 +495,13 @@ void FreeGrassrootsServer (GrassrootsServer *server_p)
 
 	FreeSchemaVersion (server_p -> gs_schema_version_p);
 
+	FreeParameterSetTemplates ();
+	FreeServiceDescriptions ();
+	FreeServiceCapabilitiesIndex ();
+
+	/* Every Parameter that used the interned names has now been freed */
+	FreeStringInternPool ();
+
 	FreeMemory (server_p);
 }
 
@@ -574,6 +657,57 @@ json_t *ProcessServerJSONMessage (GrassrootsServer *grassroots_p, json_t *json_r
 {
 	json_t *res_p = NULL;
 
+	/*
+	 * Any transient data for this request that is allocated from
+	 * the arena will be released in one go once we have finished.
+	 */
+	MemoryArena *arena_p = BeginRequestMemoryArena ();
+
+	/*
+	 * Tag every message logged whilst processing this request, including
+	 * those from any ServiceJobs and AsyncTasks that it starts, with the
+	 * same id. Nested requests keep the id of the outermost one.
+	 */
+	const bool set_correlation_id_flag = (GetLogCorrelationId () == NULL);
+
+	/* The label that the time taken by this request is recorded under */
+	const uint64 start_time = GetMetricsTime ();
+	const char *metric_label_s = NULL;
+
+	/*
+	 * If this request came from a paired Server, carry on its trace.
+	 * As with the correlation id, nested requests stay in the outer trace.
+	 */
+	bool set_trace_parent_flag = false;
+	Span *span_p = NULL;
+
+	if (set_correlation_id_flag)
+		{
+			uuid_t correlation_id;
+			char correlation_id_s [UUID_STRING_BUFFER_SIZE];
+
+			uuid_generate (correlation_id);
+			ConvertUUIDToString (correlation_id, correlation_id_s);
+			SetLogCorrelationId (correlation_id_s);
+		}
+
+	if (IsTracingEnabled ())
+		{
+			char trace_parent_s [TRACE_PARENT_BUFFER_SIZE];
+
+			if (!GetTraceParent (trace_parent_s))
+				{
+					const char *remote_trace_parent_s = GetJSONString (json_req_p, TRACE_PARENT_S);
+
+					if (remote_trace_parent_s)
+						{
+							set_trace_parent_flag = SetTraceParent (remote_trace_parent_s);
+						}
+				}
+
+			span_p = StartSpan ("grassroots request", SK_SERVER);
+		}
+
 	if (json_req_p)
 		{
 			if (json_is_object (json_req_p))
@@ -622,6 +756,8 @@ json_t *ProcessServerJSONMessage (GrassrootsServer *grassroots_p, json_t *json_r
 																	/* we can now proxy the request off to the given server */
 																	json_t *response_p = MakeRemoteJSONCallToExternalServer (external_server_p, json_req_p);
 
+																	metric_label_s = S_PROXY_METRIC_S;
+
 																	if (response_p)
 																		{
 																			/*
@@ -661,50 +797,24 @@ json_t *ProcessServerJSONMessage (GrassrootsServer *grassroots_p, json_t *json_r
 
 					if (op != OP_NONE)
 						{
-							switch (op)
-							{
-								case OP_LIST_ALL_SERVICES:
-									res_p = GetAllServices (grassroots_p, json_req_p, user_p);
-									break;
-
-									//									case OP_IRODS_MODIFIED_DATA:
-									//										{
-									//											#if IRODS_ENABLED == 1
-									//											res_p = GetAllModifiedData (req_p, user_p);
-									//											#endif
-									//										}
-									//										break;
-
-								case OP_LIST_INTERESTED_SERVICES:
-									res_p = GetInterestedServices (grassroots_p, json_req_p, user_p);
-									break;
-
-								case OP_GET_NAMED_SERVICES:
-								case OP_GET_SERVICE_INFO:
-									res_p = GetNamedServicesFunctionality (grassroots_p, json_req_p, user_p, op);
-									break;
-
-								case OP_GET_SERVICE_RESULTS:
-									res_p = GetServiceResultsAsJSON (grassroots_p, json_req_p, user_p);
-									break;
-
-								case OP_GET_RESOURCE:
-									res_p = GetRequestedResource (grassroots_p, json_req_p, user_p);
-									break;
-
-								case OP_SERVER_STATUS:
-									res_p = GetServerStatus (grassroots_p, json_req_p, user_p);
-									break;
-
-								default:
-									break;
-							}		/* switch (op) */
+							metric_label_s = GetOperationAsString (op);
+
+							if (IsOperationCoalesced (grassroots_p -> gs_request_coalescer_p, op))
+								{
+									res_p = RunCoalescedOperation (grassroots_p -> gs_request_coalescer_p, grassroots_p, op, json_req_p, user_p, RunOperation);
+								}
+							else
+								{
+									res_p = RunOperation (grassroots_p, op, json_req_p, user_p);
+								}
 
 						}		/* if (op != OP_NONE) */
 					else if ((op_p = json_object_get (json_req_p, SERVICES_NAME_S)) != NULL)
 						{
 							json_t *service_results_p = json_array ();
 
+							metric_label_s = S_RUN_SERVICES_METRIC_S;
+
 							if (service_results_p)
 								{
 									const char *key_s = NULL;
@@ -806,6 +916,57 @@ json_t *ProcessServerJSONMessage (GrassrootsServer *grassroots_p, json_t *json_r
 				}
 		}
 
+	if (arena_p)
+		{
+#if SERVER_DEBUG >= STM_LEVEL_FINER
+			MemoryArenaStatistics stats;
+
+			GetMemoryArenaStatistics (arena_p, &stats);
+			PrintLog (STM_LEVEL_FINER, __FILE__, __LINE__, "request arena: %u allocations, " SIZET_FMT " bytes, %u chunks, %u cleanups", stats.mas_num_allocations, stats.mas_num_bytes, stats.mas_num_chunks, stats.mas_num_cleanups);
+#endif
+
+			EndRequestMemoryArena ();
+		}
+
+	if (metric_label_s)
+		{
+			RecordMetric (METRICS_OPERATION_S, metric_label_s, start_time, res_p != NULL);
+		}
+
+	if (span_p)
+		{
+			if (metric_label_s)
+				{
+					AddSpanAttribute (span_p, "grassroots.operation", metric_label_s);
+				}
+
+			EndSpan (span_p, res_p != NULL);
+		}
+
+	if (set_trace_parent_flag)
+		{
+			SetTraceParent (NULL);
+		}
+
+	if (set_correlation_id_flag)
+		{
+			SetLogCorrelationId (NULL);
+		}
+
+	return res_p;
+}
+
+
+json_t *ProcessServerRawConnectionRequest (json_t *req_p, void *grassroots_p)
+{
+	const char *error_s = NULL;
+	json_t *res_p = ProcessServerJSONMessage ((GrassrootsServer *) grassroots_p, req_p, NULL, &error_s);
+
+	if (!res_p)
+		{
+			res_p = json_pack ("{s:s}", RAW_CONNECTION_SERVER_ERROR_S, error_s ? error_s : "Failed to process request");
+		}
+
 	return res_p;
 }
 
@@ -816,6 +977,7 @@ json_t *GetGlobalServiceConfig (GrassrootsServer *grassroots_p, const char * con
 	json_t *res_p = NULL;
 	char *conf_s = NULL;
 	char sep_s [2];
+	MemoryArena *arena_p = GetCurrentMemoryArena ();
 	const char *config_s = grassroots_p -> gs_config_path_s ? grassroots_p -> gs_config_path_s : "config";
 
 	*sep_s = GetFileSeparatorChar ();
@@ -823,7 +985,14 @@ json_t *GetGlobalServiceConfig (GrassrootsServer *grassroots_p, const char * con
 
 	*alloc_flag_p = false;
 
-	conf_s = ConcatenateVarargsStrings (config_s, sep_s, service_name_s, NULL);
+	if (arena_p)
+		{
+			conf_s = ConcatenateVarargsStringsInArena (arena_p, config_s, sep_s, service_name_s, NULL);
+		}
+	else
+		{
+			conf_s = ConcatenateVarargsStrings (config_s, sep_s, service_name_s, NULL);
+		}
 
 	if (conf_s)
 		{
@@ -856,7 +1025,10 @@ json_t *GetGlobalServiceConfig (GrassrootsServer *grassroots_p, const char * con
 					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to create full config filename for %s", conf_s);
 				}
 
-			FreeCopiedString (conf_s);
+			if (!arena_p)
+				{
+					FreeCopiedString (conf_s);
+				}
 		}		/* if (conf_s) */
 	else
 		{
@@ -1595,6 +1767,7 @@ static int8 RefreshServiceFromJSON (GrassrootsServer *grassroots_p, Service *ser
 static int8 RunServiceFromJSON (GrassrootsServer *grassroots_p, Service *service_p, const json_t *service_req_p, const json_t *paired_servers_req_p, User *user_p, json_t *res_p)
 {
 	int res = 0;
+	const uint64 start_time = GetMetricsTime ();
 	const char *server_uri_s = GetServerProviderURI (grassroots_p);
 	const char *service_name_s = GetServiceName (service_p);
 	ProvidersStateTable *providers_p = GetInitialisedProvidersStateTableForSingleService (paired_servers_req_p, server_uri_s, service_name_s);
@@ -1603,6 +1776,12 @@ static int8 RunServiceFromJSON (GrassrootsServer *grassroots_p, Service *service
 		{
 			ParameterSet *params_p = NULL;
 			bool delete_service_flag = true;
+			bool rejected_flag = false;
+			MemoryArena *arena_p = GetCurrentMemoryArena ();
+			const ParameterSetTemplate *template_p = GetServiceParameterSetTemplate (service_p);
+			Span *span_p = StartSpan (service_name_s, SK_INTERNAL);
+
+			AddSpanAttribute (span_p, "grassroots.service", service_name_s);
 
 			AddPairedServices (grassroots_p, service_p, user_p, providers_p);
 
@@ -1620,7 +1799,19 @@ static int8 RunServiceFromJSON (GrassrootsServer *grassroots_p, Service *service
 			 * Convert the json parameter set into a ParameterSet
 			 * to run the Service with.
 			 */
-			params_p = CreateParameterSetFromJSON (service_req_p, service_p, true);
+			if (template_p)
+				{
+					/* Only the values from the request need applying to the cached defaults */
+					params_p = CreateParameterSetFromTemplate (template_p, service_req_p, service_p, true);
+				}
+			else if (arena_p)
+				{
+					params_p = CreateParameterSetFromJSONInArena (service_req_p, service_p, true, arena_p);
+				}
+			else
+				{
+					params_p = CreateParameterSetFromJSON (service_req_p, service_p, true);
+				}
 
 			if (params_p)
 				{
@@ -1630,10 +1821,19 @@ static int8 RunServiceFromJSON (GrassrootsServer *grassroots_p, Service *service
 					PrintLog (STM_LEVEL_FINER, __FILE__, __LINE__, "about to run service \"%s\"\n", service_name_s);
 #endif
 
+					if (template_p && (template_p -> pst_validator_p) && (!ValidateServiceParameters (service_p, template_p -> pst_validator_p, params_p, res_p)))
+						{
+							/*
+							 * The job has been rejected without running anything. Its failed
+							 * job is still a result but the run itself hasn't succeeded.
+							 */
+							rejected_flag = true;
+							++ res;
+						}
 					/*
 					 * Now we reset the providers table back to its initial state
 					 */
-					if (ReinitProvidersStateTable (providers_p, paired_servers_req_p, server_uri_s, service_name_s))
+					else if (ReinitProvidersStateTable (providers_p, paired_servers_req_p, server_uri_s, service_name_s))
 						{
 							if ((!IsServiceLockable (service_p)) || LockService (service_p))
 								{
@@ -1680,13 +1880,20 @@ static int8 RunServiceFromJSON (GrassrootsServer *grassroots_p, Service *service
 						}		/* if (ReinitProvidersStateTable (providers_p, req_p, server_uri_s, service_name_s)) */
 
 
-					FreeParameterSet  (params_p);
+					/* If the ParameterSet is in the request arena, it is freed along with that */
+					if (template_p || (!arena_p))
+						{
+							FreeParameterSet  (params_p);
+						}
 				}		/* if (params_p) */
 			else
 				{
 					PrintJSONToErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, service_req_p, "Failed to get params");
 				}
 
+			/* Record this before the Service, and so its name, might be freed */
+			RecordMetric (METRICS_SERVICE_S, service_name_s, start_time, (res > 0) && (!rejected_flag));
+			EndSpan (span_p, (res > 0) && (!rejected_flag));
 
 			if (delete_service_flag)
 				{
@@ -1710,6 +1917,64 @@ static int8 RunServiceFromJSON (GrassrootsServer *grassroots_p, Service *service
 
 
 
+/*
+ * Check the request's Parameters against the Service's compiled constraints
+ * and, if any are invalid, add a failed job with the details of each one
+ * to the results.
+ */
+static bool ValidateServiceParameters (Service *service_p, const ParameterValidator *validator_p, const ParameterSet *params_p, json_t *res_p)
+{
+	bool valid_flag = true;
+	Vector *errors_p = AllocateVector (sizeof (ParameterValidationError), 0, NULL);
+
+	if (errors_p)
+		{
+			if (ValidateParameterSet (validator_p, params_p, errors_p) > 0)
+				{
+					const char *service_name_s = GetServiceName (service_p);
+					ServiceJobSet *jobs_p = AllocateSimpleServiceJobSet (service_p, service_name_s, "Invalid parameters");
+
+					valid_flag = false;
+
+					if (jobs_p)
+						{
+							ServiceJob *job_p = GetServiceJobFromServiceJobSet (jobs_p, 0);
+							const ParameterValidationError *error_p;
+							uint32 i = 0;
+
+							while ((error_p = (const ParameterValidationError *) GetNextVectorElement (errors_p, &i)) != NULL)
+								{
+									if (!AddParameterErrorMessageToServiceJob (job_p, error_p -> pve_param_s, error_p -> pve_type, error_p -> pve_error_s))
+										{
+											PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to add error \"%s\" for \"%s\" to job for %s", error_p -> pve_error_s, error_p -> pve_param_s, service_name_s);
+										}
+								}
+
+							SetServiceJobStatus (job_p, OS_FAILED_TO_START);
+
+							if (!ProcessServiceJobSet (jobs_p, res_p))
+								{
+									PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to add invalid parameters job for %s to results", service_name_s);
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate job for invalid parameters for %s", service_name_s);
+						}
+				}
+
+			FreeVector (errors_p);
+		}
+	else
+		{
+			/* Leave the Service to check its own Parameters */
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to allocate Vector to validate parameters for %s", GetServiceName (service_p));
+		}
+
+	return valid_flag;
+}
+
+
 
 static int8 GetServiceIndexingInformation (GrassrootsServer *grassroots_p, Service *service_p, const json_t *service_req_p, const json_t *paired_servers_req_p, User *user_p, json_t *res_p)
 {
@@ -2032,10 +2297,34 @@ static json_t *GetAllServices (GrassrootsServer *grassroots_p, const json_t * co
 }
 
 
-static json_t *RunKeywordServices (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p, const char *keyword_s)
+static json_t *RunKeywordServices (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p)
 {
 	json_t *res_p = NULL;
-	json_t *results_p = json_array ();
+	json_t *results_p = NULL;
+	const char *keyword_s = GetJSONString (req_p, KEYWORDS_QUERY_S);
+
+	if (!keyword_s)
+		{
+			PrintJSONToErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, req_p, "No \"%s\" to run keyword services with", KEYWORDS_QUERY_S);
+			return NULL;
+		}
+
+	/*
+	 * The keyword Services may still be running after we stop waiting
+	 * for them, so they are given their own copy of the User rather than
+	 * the one that belongs to our caller.
+	 */
+	if (user_p)
+		{
+			user_p = CopyUser (user_p);
+
+			if (!user_p)
+				{
+					return NULL;
+				}
+		}
+
+	results_p = json_array ();
 
 	if (results_p)
 		{
@@ -2060,115 +2349,117 @@ static json_t *RunKeywordServices (GrassrootsServer *grassroots_p, const json_t
 
 											if (matcher_p)
 												{
-													/* For each service, set its keyword parameter */
-													ServiceNode *service_node_p = (ServiceNode *) (services_p -> ll_head_p);
+													/*
+													 * The keyword Services are run in parallel and take
+													 * ownership of the User so that it outlives any that
+													 * are still running once we stop waiting for them.
+													 */
+													const json_t *keyword_config_p = json_object_get (grassroots_p -> gs_config_p, KEYWORD_SEARCH_S);
+													uint32 max_num_workers = KEYWORD_SEARCH_DEFAULT_MAX_WORKERS;
+													uint32 timeout = KEYWORD_SEARCH_DEFAULT_TIMEOUT;
+													json_t *interested_services_p = json_array ();
+													json_t *incomplete_services_p = json_array ();
+													KeywordSearch *search_p = NULL;
+
+													GetJSONUnsignedInteger (keyword_config_p, KEYWORD_SEARCH_MAX_WORKERS_S, &max_num_workers);
+													GetJSONUnsignedInteger (keyword_config_p, KEYWORD_SEARCH_TIMEOUT_S, &timeout);
+
+													if (interested_services_p && incomplete_services_p)
+														{
+															search_p = AllocateKeywordSearch (keyword_s, user_p, paired_servers_p, results_p, services_p -> ll_size, max_num_workers, timeout);
+														}
 
-													while (service_node_p)
+													if (search_p)
 														{
-															Service *service_p = service_node_p -> sn_service_p;
+															ServiceNode *service_node_p = (ServiceNode *) (services_p -> ll_head_p);
 
-															if (RunServiceMatcher (matcher_p, service_p))
-																{
-																	ParameterSet *params_p = NULL;
-																	bool param_flag = true;
+															user_p = NULL;
 
-																	params_p = GetServiceParameters (service_p, NULL, user_p);
+															while (service_node_p)
+																{
+																	Service *service_p = service_node_p -> sn_service_p;
 
-																	if (params_p)
+																	if (RunServiceMatcher (matcher_p, service_p))
 																		{
-																			ParameterNode *param_node_p = (ParameterNode *) params_p -> ps_params_p -> ll_head_p;
-
-																			param_flag = false;
+																			if (AddServiceToKeywordSearch (search_p, service_p))
+																				{
+																					service_node_p -> sn_service_p = NULL;
+																				}
+																			else
+																				{
+																					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to run service \"%s\" with keyword \"%s\"", GetServiceName (service_p), keyword_s);
+																				}
+																		}		/* if (RunServiceMatcher (matcher_p, service_p)) */
+																	else
+																		{
+																			ParameterSet *params_p = IsServiceMatch (service_p, resource_p, NULL);
 
-																			while (param_node_p)
+																			/*
+																			 * Does the service match for running against this keyword?
+																			 */
+																			if (params_p)
 																				{
-																					Parameter *param_p = param_node_p -> pn_parameter_p;
+																					/*
+																					 * Add the information that the service is interested in this keyword
+																					 * and can be ran.
+																					 */
+																					json_t *interested_app_p = GetInterestedServiceJSON (service_p, keyword_s, params_p, true);
 
-																					/* set the keyword parameter */
-																					if (param_p -> pa_type == PT_KEYWORD)
+																					if (interested_app_p)
 																						{
-																							if (IsStringParameter (param_p))
+																							if (json_array_append_new (interested_services_p, interested_app_p) != 0)
 																								{
-																									if (SetStringParameterCurrentValue ((StringParameter *) param_p, keyword_s))
-																										{
-																											param_flag = true;
-																										}
-																									else
-																										{
-																											PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to set service param \"%s\" - \"%s\" to \"%s\"", GetServiceName (service_p), param_p -> pa_name_s, keyword_s);
-																											param_flag = false;
-																										}
-																								}
-																							else
-																								{
-																									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Parameter is keyword but not a string param for service \"%s\" - \"%s\" to \"%s\"", GetServiceName (service_p), param_p -> pa_name_s, keyword_s);
-																									param_flag = false;
-																								}
-																						}
-
-																					param_node_p = (ParameterNode *) (param_node_p -> pn_node.ln_next_p);
-																				}		/* while (param_node_p) */
+																									json_decref (interested_app_p);
+																									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add interested service \"%s\" for keyword \"%s\" to results", GetServiceName (service_p), keyword_s);
+																								}		/* if (json_array_append_new (interested_services_p, interested_app_p) != 0) */
 
-																			/* Now run the service */
-																			if (param_flag)
-																				{
-																					ServiceJobSet *jobs_set_p = RunService (service_p, params_p, user_p, providers_p);
-
-																					if (jobs_set_p)
-																						{
-																							ProcessServiceJobSet (jobs_set_p, results_p);
-																						}
+																						}		/* if (interested_app_p) */
 																					else
 																						{
-																							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to run service \"%s\" with keyword \"%s\"", GetServiceName (service_p), keyword_s);
+																							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create JSON for interested service \"%s\" for keyword \"%s\" to results", GetServiceName (service_p), keyword_s);
 																						}
-																				}
 
-																			ReleaseServiceParameters (service_p, params_p);
+																					ReleaseServiceParameters (service_p, params_p);
+																				}		/* if (params_p) */
 
-																		}		/* if (params_p) */
-																	else
-																		{
-																			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to get parameters for service \"%s\" to run with keyword \"%s\"", GetServiceName (service_p), keyword_s);
-																		}
+																		}		/* if (RunServiceMatcher (matcher_p, service_p)) else */
 
-																}		/* if (RunServiceMatcher (matcher_p, service_p)) */
-															else
-																{
-																	ParameterSet *params_p = IsServiceMatch (service_p, resource_p, NULL);
+																	service_node_p = (ServiceNode *) (service_node_p -> sn_node.ln_next_p);
+																}		/* while (service_node_p) */
 
-																	/*
-																	 * Does the service match for running against this keyword?
-																	 */
-																	if (params_p)
+															/*
+															 * Once we have finished waiting, the workers no longer
+															 * touch the results so we can add the interested services.
+															 */
+															if (WaitForKeywordSearch (search_p, incomplete_services_p) > 0)
+																{
+																	if (json_object_set (res_p, KEYWORD_SEARCH_INCOMPLETE_SERVICES_S, incomplete_services_p) != 0)
 																		{
-																			/*
-																			 * Add the information that the service is interested in this keyword
-																			 * and can be ran.
-																			 */
-																			json_t *interested_app_p = GetInterestedServiceJSON (service_p, keyword_s, params_p, true);
-
-																			if (interested_app_p)
-																				{
-																					if (json_array_append_new (results_p, interested_app_p) != 0)
-																						{
-																							json_decref (interested_app_p);
-																							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add interested service \"%s\" for keyword \"%s\" to results", GetServiceName (service_p), keyword_s);
-																						}		/* if (json_array_append_new (res_p, interested_app_p) != 0) */
+																			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to add incomplete services for keyword \"%s\"", keyword_s);
+																		}
+																}
 
-																				}		/* if (interested_app_p) */
-																			else
-																				{
-																					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create JSON for interested service \"%s\" for keyword \"%s\" to results", GetServiceName (service_p), keyword_s);
-																				}
+															if (json_array_extend (results_p, interested_services_p) != 0)
+																{
+																	PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add interested services for keyword \"%s\" to results", keyword_s);
+																}
 
-																			ReleaseServiceParameters (service_p, params_p);
-																		}		/* if (params_p) */
+															FreeKeywordSearch (search_p);
+														}		/* if (search_p) */
+													else
+														{
+															PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate keyword search for \"%s\"", keyword_s);
+														}
 
-																}		/* if (RunServiceMatcher (matcher_p, service_p)) else */
+													if (interested_services_p)
+														{
+															json_decref (interested_services_p);
+														}
 
-															service_node_p = (ServiceNode *) (service_node_p -> sn_node.ln_next_p);
-														}		/* while (service_node_p) */
+													if (incomplete_services_p)
+														{
+															json_decref (incomplete_services_p);
+														}
 
 													FreeServiceMatcher (matcher_p);
 												}		/* if (matcher_p) */
@@ -2179,11 +2470,6 @@ static json_t *RunKeywordServices (GrassrootsServer *grassroots_p, const json_t
 									FreeProvidersStateTable (providers_p);
 								}		/* if (providers_p) */
 
-							if (user_p)
-								{
-									FreeUser (user_p);
-								}
-
 							FreeDataResource (resource_p);
 						}		/* if (resource_p) */
 
@@ -2191,6 +2477,12 @@ static json_t *RunKeywordServices (GrassrootsServer *grassroots_p, const json_t
 
 		}		/* if (results_p) */
 
+	/* Free our copy of the User unless the KeywordSearch has taken it */
+	if (user_p)
+		{
+			FreeUser (user_p);
+		}
+
 	return res_p;
 }
 
@@ -2738,6 +3030,66 @@ static json_t *GetServerStatus (GrassrootsServer *grassroots_p, const json_t * c
 
 
 
+static json_t *GetServerMetrics (GrassrootsServer * UNUSED_PARAM (grassroots_p), const json_t * const req_p, User * UNUSED_PARAM (user_p))
+{
+	json_t *res_p = json_object ();
+
+	if (res_p)
+		{
+			const char *format_s = GetJSONString (req_p, METRICS_FORMAT_S);
+			bool success_flag = false;
+
+			if ((format_s != NULL) && (strcmp (format_s, METRICS_FORMAT_PROMETHEUS_S) == 0))
+				{
+					char *text_s = GetMetricsAsPrometheusText ();
+
+					if (text_s)
+						{
+							if (SetJSONString (res_p, METRICS_FORMAT_PROMETHEUS_S, text_s))
+								{
+									success_flag = true;
+								}
+
+							FreeMetricsText (text_s);
+						}		/* if (text_s) */
+
+				}		/* if ((format_s != NULL) && (strcmp (format_s, METRICS_FORMAT_PROMETHEUS_S) == 0)) */
+			else
+				{
+					json_t *metrics_p = GetMetricsAsJSON ();
+
+					if (metrics_p)
+						{
+							if (json_object_set_new (res_p, METRICS_S, metrics_p) == 0)
+								{
+									if (SetJSONInteger (res_p, METRICS_DROPPED_S, (json_int_t) GetNumberOfDroppedMetrics ()))
+										{
+											success_flag = true;
+										}
+								}
+							else
+								{
+									json_decref (metrics_p);
+								}
+
+						}		/* if (metrics_p) */
+
+				}
+
+			if (!success_flag)
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get server metrics");
+					json_decref (res_p);
+					res_p = NULL;
+				}
+
+		}		/* if (res_p) */
+
+	return res_p;
+}
+
+
+
 static json_t *GetRequestedResource (GrassrootsServer *grassroots_p, const json_t * const req_p, User *user_p)
 {
 	json_t *res_p = NULL;
@@ -3134,6 +3486,275 @@ static struct MongoClientManager *GetMongoClientManager (const json_t *config_p)
 }
 
 
+/*
+ * Replace the default OutputStreams with AsyncOutputStreams if the Server's
+ * configuration asks for them, e.g.
+ *
+ * "logging": { "async": true, "log_file": "/var/log/grassroots.log", "level": "info" }
+ */
+static bool InitLogging (const json_t *config_p)
+{
+	bool success_flag = false;
+	const json_t *logging_config_p = json_object_get (config_p, LOGGING_S);
+
+	if (logging_config_p)
+		{
+			const char *format_s = GetJSONString (logging_config_p, LOGGING_FORMAT_S);
+			const bool json_flag = (format_s != NULL) && (strcmp (format_s, LOGGING_FORMAT_JSON_S) == 0);
+			bool async_flag = false;
+
+			GetJSONBoolean (logging_config_p, LOGGING_ASYNC_S, &async_flag);
+
+			if (json_flag || async_flag)
+				{
+					const char *level_s = GetJSONString (logging_config_p, LOGGING_LEVEL_S);
+					uint32 level = STM_LEVEL_ALL;
+					OutputStream *log_stream_p;
+
+					if (level_s && (!GetStreamLevelFromString (level_s, &level)))
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Unknown logging level \"%s\", writing all messages", level_s);
+						}
+
+					log_stream_p = AllocateLoggingStream (logging_config_p, LOGGING_LOG_FILE_S, stdout, level, json_flag);
+
+					if (log_stream_p)
+						{
+							OutputStream *errors_stream_p = AllocateLoggingStream (logging_config_p, LOGGING_ERRORS_FILE_S, stderr, level, json_flag);
+
+							if (errors_stream_p)
+								{
+									SetDefaultLogStream (log_stream_p);
+									SetDefaultErrorStream (errors_stream_p);
+
+									success_flag = true;
+								}
+							else
+								{
+									FreeOutputStream (log_stream_p);
+								}
+						}
+
+					if (!success_flag)
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to set up logging from the \"%s\" configuration", LOGGING_S);
+						}
+				}
+		}
+
+	return success_flag;
+}
+
+
+/*
+ * JSON logging takes precedence over asynchronous logging as
+ * structured messages can be longer than an AsyncOutputStream's slots.
+ */
+static OutputStream *AllocateLoggingStream (const json_t *logging_config_p, const char *filename_key_s, FILE *default_f, const uint32 level, const bool json_flag)
+{
+	OutputStream *stream_p = NULL;
+	const char *filename_s = GetJSONString (logging_config_p, filename_key_s);
+
+	if (json_flag)
+		{
+			uint32 max_payload_size = 4096;
+			uint32 payload_sample_rate = 100;
+
+			GetJSONUnsignedInteger (logging_config_p, LOGGING_MAX_PAYLOAD_SIZE_S, &max_payload_size);
+			GetJSONUnsignedInteger (logging_config_p, LOGGING_PAYLOAD_SAMPLE_RATE_S, &payload_sample_rate);
+
+			stream_p = AllocateJSONOutputStream (filename_s, default_f, level, max_payload_size, payload_sample_rate);
+		}
+	else
+		{
+#ifndef _WIN32
+			uint32 buffer_size = 0;
+
+			GetJSONUnsignedInteger (logging_config_p, LOGGING_BUFFER_SIZE_S, &buffer_size);
+
+			stream_p = AllocateAsyncOutputStream (filename_s, default_f, level, buffer_size);
+#else
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Asynchronous logging is not available on this platform");
+#endif
+		}
+
+	return stream_p;
+}
+
+
+static void ExitLogging (void)
+{
+	/* Freeing the configured OutputStreams writes out any waiting messages */
+	SetDefaultLogStream (AllocateFileOutputStream (NULL));
+	SetDefaultErrorStream (AllocateFileOutputStream (NULL));
+}
+
+
+static bool InitTracingFromConfig (const GrassrootsServer *grassroots_p)
+{
+	bool success_flag = false;
+	const json_t *tracing_config_p = json_object_get (grassroots_p -> gs_config_p, TRACING_S);
+
+	if (tracing_config_p)
+		{
+			const char *filename_s = GetJSONString (tracing_config_p, TRACING_FILE_S);
+
+			if (filename_s)
+				{
+					const char *service_name_s = GetJSONString (tracing_config_p, TRACING_SERVICE_NAME_S);
+
+					if (!service_name_s)
+						{
+							service_name_s = GetServerProviderName (grassroots_p);
+						}
+
+					if (InitTracing (filename_s, service_name_s))
+						{
+							success_flag = true;
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to start tracing to \"%s\"", filename_s);
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "No \"%s\" set in the \"%s\" configuration", TRACING_FILE_S, TRACING_S);
+				}
+		}
+
+	return success_flag;
+}
+
+
+static RequestCoalescer *GetRequestCoalescerFromConfig (const json_t *config_p)
+{
+	RequestCoalescer *coalescer_p = NULL;
+	const json_t *coalescing_config_p = json_object_get (config_p, REQUEST_COALESCING_S);
+
+	if (coalescing_config_p)
+		{
+			coalescer_p = AllocateRequestCoalescer (coalescing_config_p);
+
+			if (!coalescer_p)
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to set up request coalescing, identical requests will be run separately");
+				}
+		}
+
+	return coalescer_p;
+}
+
+
+static RawConnectionServer *StartRawConnectionServerFromConfig (GrassrootsServer *grassroots_p)
+{
+	RawConnectionServer *raw_server_p = NULL;
+	const json_t *raw_server_config_p = json_object_get (grassroots_p -> gs_config_p, RAW_CONNECTION_SERVER_CONFIG_S);
+
+	if (raw_server_config_p)
+		{
+			#ifdef LINUX
+			uint32 port = 0;
+
+			if (GetJSONUnsignedInteger (raw_server_config_p, RAW_CONNECTION_SERVER_PORT_S, &port) && (port > 0) && (port <= UINT16_MAX))
+				{
+					uint32 num_threads = 0;
+					uint32 num_handler_threads = 0;
+					char port_s [8];
+
+					GetJSONUnsignedInteger (raw_server_config_p, RAW_CONNECTION_SERVER_NUM_THREADS_S, &num_threads);
+					GetJSONUnsignedInteger (raw_server_config_p, RAW_CONNECTION_SERVER_NUM_HANDLER_THREADS_S, &num_handler_threads);
+
+					sprintf (port_s, UINT32_FMT, port);
+
+					raw_server_p = AllocateRawConnectionServer (port_s, num_threads, num_handler_threads, ProcessServerRawConnectionRequest, grassroots_p);
+
+					if (raw_server_p)
+						{
+							if (StartRawConnectionServer (raw_server_p))
+								{
+									PrintLog (STM_LEVEL_INFO, __FILE__, __LINE__, "Serving RawConnections on port " UINT32_FMT, port);
+								}
+							else
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to start RawConnectionServer on port " UINT32_FMT, port);
+									FreeRawConnectionServer (raw_server_p);
+									raw_server_p = NULL;
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate RawConnectionServer on port " UINT32_FMT, port);
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "No valid \"%s\" in \"%s\" config", RAW_CONNECTION_SERVER_PORT_S, RAW_CONNECTION_SERVER_CONFIG_S);
+				}
+			#else
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "RawConnectionServer is not available on this platform, ignoring \"%s\" config", RAW_CONNECTION_SERVER_CONFIG_S);
+			#endif
+		}
+
+	return raw_server_p;
+}
+
+
+static json_t *RunOperation (GrassrootsServer *grassroots_p, const Operation op, const json_t *req_p, User *user_p)
+{
+	json_t *res_p = NULL;
+
+	switch (op)
+	{
+		case OP_LIST_ALL_SERVICES:
+			res_p = GetAllServices (grassroots_p, req_p, user_p);
+			break;
+
+			//	case OP_IRODS_MODIFIED_DATA:
+			//		{
+			//			#if IRODS_ENABLED == 1
+			//			res_p = GetAllModifiedData (req_p, user_p);
+			//			#endif
+			//		}
+			//		break;
+
+		case OP_LIST_INTERESTED_SERVICES:
+			res_p = GetInterestedServices (grassroots_p, req_p, user_p);
+			break;
+
+		case OP_GET_NAMED_SERVICES:
+		case OP_GET_SERVICE_INFO:
+			res_p = GetNamedServicesFunctionality (grassroots_p, req_p, user_p, op);
+			break;
+
+		case OP_GET_SERVICE_RESULTS:
+			res_p = GetServiceResultsAsJSON (grassroots_p, req_p, user_p);
+			break;
+
+		case OP_GET_RESOURCE:
+			res_p = GetRequestedResource (grassroots_p, req_p, user_p);
+			break;
+
+		case OP_SERVER_STATUS:
+			res_p = GetServerStatus (grassroots_p, req_p, user_p);
+			break;
+
+		case OP_GET_SERVER_METRICS:
+			res_p = GetServerMetrics (grassroots_p, req_p, user_p);
+			break;
+
+		case OP_RUN_KEYWORD_SERVICES:
+			res_p = RunKeywordServices (grassroots_p, req_p, user_p);
+			break;
+
+		default:
+			break;
+	}		/* switch (op) */
+
+	return res_p;
+}
+
+
 
 static uint32 GetMatchingReferrableServices (GrassrootsServer *grassroots_p, ServiceMatcher *matcher_p, User *user_p, const json_t *reference_config_p, LinkedList *services_list_p, bool multiple_match_flag)
 {
@@ -0,0 +1,748 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * keyword_search.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <string.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <time.h>
+#endif
+
+#include "keyword_search.h"
+#include "memory_allocations.h"
+#include "metrics.h"
+#include "providers_state_table.h"
+#include "service_job.h"
+#include "streams.h"
+#include "string_parameter.h"
+#include "string_utils.h"
+#include "tracing.h"
+
+
+#ifdef _WIN32
+	typedef SRWLOCK KeywordSearchLock;
+	typedef CONDITION_VARIABLE KeywordSearchCondition;
+#else
+	typedef pthread_mutex_t KeywordSearchLock;
+	typedef pthread_cond_t KeywordSearchCondition;
+#endif
+
+
+/*
+ * The number of workers that are still running across every KeywordSearch.
+ * The workers are detached and may still be running Services after their
+ * searches have returned, so the server waits for this to reach 0 before
+ * it shuts down and unloads the Services' plugins.
+ */
+static uint32 s_num_active_workers = 0;
+
+#ifdef _WIN32
+	static SRWLOCK s_workers_lock = SRWLOCK_INIT;
+	static CONDITION_VARIABLE s_workers_condition = CONDITION_VARIABLE_INIT;
+#else
+	static pthread_mutex_t s_workers_lock = PTHREAD_MUTEX_INITIALIZER;
+	static pthread_cond_t s_workers_condition = PTHREAD_COND_INITIALIZER;
+#endif
+
+
+/* The states of each Service in a KeywordSearch */
+typedef enum KeywordSearchTaskState
+{
+	KSTS_PENDING,
+	KSTS_RUNNING,
+	KSTS_FINISHED
+} KeywordSearchTaskState;
+
+
+typedef struct KeywordSearchTask
+{
+	Service *kst_service_p;
+
+	/* A copy of the Service's name so it can be reported after the Service is freed */
+	char *kst_service_name_s;
+
+	/* Each Service gets its own table as they can be updated whilst the Service runs */
+	ProvidersStateTable *kst_providers_p;
+
+	KeywordSearchTaskState kst_state;
+} KeywordSearchTask;
+
+
+struct KeywordSearch
+{
+	KeywordSearchLock ks_lock;
+
+	/* Signalled each time that a Service finishes */
+	KeywordSearchCondition ks_finished_condition;
+
+	char *ks_keyword_s;
+
+	User *ks_user_p;
+
+	const json_t *ks_paired_servers_p;
+
+	/* This is set to NULL once the caller has stopped waiting for results */
+	json_t *ks_results_p;
+
+	KeywordSearchTask *ks_tasks_p;
+
+	uint32 ks_max_num_tasks;
+
+	uint32 ks_num_tasks;
+
+	/* The index of the next task for a worker to run */
+	uint32 ks_next_task;
+
+	uint32 ks_num_finished_tasks;
+
+	uint32 ks_max_num_workers;
+
+	uint32 ks_num_workers;
+
+	/* The caller and each running worker each hold a reference */
+	uint32 ks_num_references;
+
+	uint64 ks_deadline;
+
+	char ks_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE];
+
+	char ks_trace_parent_s [TRACE_PARENT_BUFFER_SIZE];
+};
+
+
+static bool StartKeywordSearchWorker (KeywordSearch *search_p);
+
+#ifdef _WIN32
+static DWORD WINAPI RunKeywordSearchWorker (LPVOID data_p);
+#else
+static void *RunKeywordSearchWorker (void *data_p);
+#endif
+
+static void RunKeywordSearchTask (KeywordSearch *search_p, KeywordSearchTask *task_p);
+
+static bool SetKeywordParameters (ParameterSet *params_p, const char *keyword_s, const char *service_name_s);
+
+static void ReleaseKeywordSearch (KeywordSearch *search_p);
+
+static void LockKeywordSearch (KeywordSearch *search_p);
+
+static void UnlockKeywordSearch (KeywordSearch *search_p);
+
+static bool WaitForKeywordSearchTask (KeywordSearch *search_p);
+
+static void SignalKeywordSearch (KeywordSearch *search_p);
+
+static void ChangeNumberOfActiveWorkers (const bool increment_flag);
+
+
+
+KeywordSearch *AllocateKeywordSearch (const char *keyword_s, User *user_p, const json_t *paired_servers_p, json_t *results_p, const uint32 max_num_services, const uint32 max_num_workers, const uint32 timeout)
+{
+	char *copied_keyword_s = EasyCopyToNewString (keyword_s);
+
+	if (copied_keyword_s)
+		{
+			KeywordSearchTask *tasks_p = (KeywordSearchTask *) AllocMemoryArray ((max_num_services > 0) ? max_num_services : 1, sizeof (KeywordSearchTask));
+
+			if (tasks_p)
+				{
+					KeywordSearch *search_p = (KeywordSearch *) AllocMemory (sizeof (KeywordSearch));
+
+					if (search_p)
+						{
+							const char *correlation_id_s = GetLogCorrelationId ();
+
+#ifdef _WIN32
+							InitializeSRWLock (& (search_p -> ks_lock));
+							InitializeConditionVariable (& (search_p -> ks_finished_condition));
+#else
+							pthread_mutex_init (& (search_p -> ks_lock), NULL);
+							pthread_cond_init (& (search_p -> ks_finished_condition), NULL);
+#endif
+
+							search_p -> ks_keyword_s = copied_keyword_s;
+							search_p -> ks_user_p = user_p;
+							search_p -> ks_paired_servers_p = paired_servers_p;
+							search_p -> ks_results_p = results_p;
+							search_p -> ks_tasks_p = tasks_p;
+							search_p -> ks_max_num_tasks = max_num_services;
+							search_p -> ks_num_tasks = 0;
+							search_p -> ks_next_task = 0;
+							search_p -> ks_num_finished_tasks = 0;
+							search_p -> ks_max_num_workers = (max_num_workers > 0) ? max_num_workers : 1;
+							search_p -> ks_num_workers = 0;
+							search_p -> ks_num_references = 1;
+							search_p -> ks_deadline = GetMetricsTime () + 1000 * (uint64) timeout;
+
+							/* The workers' log messages and Spans belong to the calling request */
+							if (correlation_id_s)
+								{
+									strncpy (search_p -> ks_correlation_id_s, correlation_id_s, LOG_CORRELATION_ID_BUFFER_SIZE - 1);
+									search_p -> ks_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE - 1] = '\0';
+								}
+							else
+								{
+									* (search_p -> ks_correlation_id_s) = '\0';
+								}
+
+							if (!GetTraceParent (search_p -> ks_trace_parent_s))
+								{
+									* (search_p -> ks_trace_parent_s) = '\0';
+								}
+
+							return search_p;
+						}
+
+					FreeMemory (tasks_p);
+				}
+
+			FreeCopiedString (copied_keyword_s);
+		}
+
+	return NULL;
+}
+
+
+bool AddServiceToKeywordSearch (KeywordSearch *search_p, Service *service_p)
+{
+	bool success_flag = false;
+
+	if (search_p -> ks_num_tasks < search_p -> ks_max_num_tasks)
+		{
+			char *service_name_s = EasyCopyToNewString (GetServiceName (service_p));
+
+			if (service_name_s)
+				{
+					/*
+					 * The paired servers JSON belongs to the request, which may have
+					 * been freed by the time that a late Service runs, so create the
+					 * ProvidersStateTable now.
+					 */
+					ProvidersStateTable *providers_p = AllocateProvidersStateTable (search_p -> ks_paired_servers_p);
+
+					if (providers_p)
+						{
+							bool start_worker_flag;
+
+							LockKeywordSearch (search_p);
+
+							if (search_p -> ks_results_p)
+								{
+									KeywordSearchTask *task_p = search_p -> ks_tasks_p + (search_p -> ks_num_tasks);
+
+									task_p -> kst_service_p = service_p;
+									task_p -> kst_service_name_s = service_name_s;
+									task_p -> kst_providers_p = providers_p;
+									task_p -> kst_state = KSTS_PENDING;
+
+									++ (search_p -> ks_num_tasks);
+									success_flag = true;
+								}
+
+							start_worker_flag = success_flag && (search_p -> ks_num_workers < search_p -> ks_max_num_workers);
+
+							if (start_worker_flag)
+								{
+									++ (search_p -> ks_num_workers);
+									++ (search_p -> ks_num_references);
+								}
+
+							UnlockKeywordSearch (search_p);
+
+							if (start_worker_flag)
+								{
+									if (!StartKeywordSearchWorker (search_p))
+										{
+											PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to start keyword search worker for \"%s\"", service_name_s);
+
+											LockKeywordSearch (search_p);
+											-- (search_p -> ks_num_workers);
+											-- (search_p -> ks_num_references);
+
+											/*
+											 * With no workers at all, nothing would run the Service, unless an
+											 * earlier worker has already picked it up before exiting.
+											 */
+											if ((search_p -> ks_num_workers == 0) && (search_p -> ks_tasks_p [search_p -> ks_num_tasks - 1].kst_state == KSTS_PENDING))
+												{
+													-- (search_p -> ks_num_tasks);
+													success_flag = false;
+												}
+
+											UnlockKeywordSearch (search_p);
+										}
+								}
+
+							if (!success_flag)
+								{
+									FreeProvidersStateTable (providers_p);
+								}
+
+						}		/* if (providers_p) */
+
+					if (!success_flag)
+						{
+							FreeCopiedString (service_name_s);
+						}
+
+				}		/* if (service_name_s) */
+
+		}		/* if (search_p -> ks_num_tasks < search_p -> ks_max_num_tasks) */
+
+	return success_flag;
+}
+
+
+uint32 WaitForKeywordSearch (KeywordSearch *search_p, json_t *incomplete_services_p)
+{
+	uint32 num_incomplete_tasks;
+	uint32 i;
+	KeywordSearchTask *task_p;
+
+	LockKeywordSearch (search_p);
+
+	while ((search_p -> ks_num_finished_tasks < search_p -> ks_num_tasks) && WaitForKeywordSearchTask (search_p))
+		{
+		}
+
+	/* Stop adding results and don't start any more Services */
+	search_p -> ks_results_p = NULL;
+	search_p -> ks_next_task = search_p -> ks_num_tasks;
+
+	num_incomplete_tasks = search_p -> ks_num_tasks - search_p -> ks_num_finished_tasks;
+
+	for (i = search_p -> ks_num_tasks, task_p = search_p -> ks_tasks_p; i > 0; -- i, ++ task_p)
+		{
+			if (task_p -> kst_state != KSTS_FINISHED)
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "\"%s\" didn't finish in time for keyword search \"%s\"", task_p -> kst_service_name_s, search_p -> ks_keyword_s);
+
+					if (incomplete_services_p)
+						{
+							if (json_array_append_new (incomplete_services_p, json_string (task_p -> kst_service_name_s)) != 0)
+								{
+									PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to add \"%s\" to incomplete services", task_p -> kst_service_name_s);
+								}
+						}
+				}
+		}
+
+	UnlockKeywordSearch (search_p);
+
+	return num_incomplete_tasks;
+}
+
+
+void FreeKeywordSearch (KeywordSearch *search_p)
+{
+	ReleaseKeywordSearch (search_p);
+}
+
+
+void WaitForKeywordSearchWorkers (void)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive (&s_workers_lock);
+#else
+	pthread_mutex_lock (&s_workers_lock);
+#endif
+
+	if (s_num_active_workers > 0)
+		{
+			PrintLog (STM_LEVEL_INFO, __FILE__, __LINE__, "Waiting for " UINT32_FMT " keyword search workers to finish", s_num_active_workers);
+		}
+
+	while (s_num_active_workers > 0)
+		{
+#ifdef _WIN32
+			SleepConditionVariableSRW (&s_workers_condition, &s_workers_lock, INFINITE, 0);
+#else
+			pthread_cond_wait (&s_workers_condition, &s_workers_lock);
+#endif
+		}
+
+#ifdef _WIN32
+	ReleaseSRWLockExclusive (&s_workers_lock);
+#else
+	pthread_mutex_unlock (&s_workers_lock);
+#endif
+}
+
+
+static void ReleaseKeywordSearch (KeywordSearch *search_p)
+{
+	bool free_flag;
+
+	LockKeywordSearch (search_p);
+	free_flag = (-- (search_p -> ks_num_references) == 0);
+	UnlockKeywordSearch (search_p);
+
+	if (free_flag)
+		{
+			uint32 i;
+			KeywordSearchTask *task_p = search_p -> ks_tasks_p;
+
+			for (i = search_p -> ks_num_tasks; i > 0; -- i, ++ task_p)
+				{
+					/* Any Service that never started is still ours to free */
+					if (task_p -> kst_service_p)
+						{
+							FreeService (task_p -> kst_service_p);
+						}
+
+					FreeProvidersStateTable (task_p -> kst_providers_p);
+					FreeCopiedString (task_p -> kst_service_name_s);
+				}
+
+			if (search_p -> ks_user_p)
+				{
+					FreeUser (search_p -> ks_user_p);
+				}
+
+#ifndef _WIN32
+			pthread_cond_destroy (& (search_p -> ks_finished_condition));
+			pthread_mutex_destroy (& (search_p -> ks_lock));
+#endif
+
+			FreeMemory (search_p -> ks_tasks_p);
+			FreeCopiedString (search_p -> ks_keyword_s);
+			FreeMemory (search_p);
+		}
+}
+
+
+static bool StartKeywordSearchWorker (KeywordSearch *search_p)
+{
+	bool success_flag = false;
+
+	/* Count the worker before it starts so that it can't finish before it is counted */
+	ChangeNumberOfActiveWorkers (true);
+
+#ifdef _WIN32
+	HANDLE thread_handle = CreateThread (NULL, 0, RunKeywordSearchWorker, search_p, 0, NULL);
+
+	if (thread_handle)
+		{
+			CloseHandle (thread_handle);
+			success_flag = true;
+		}
+#else
+	pthread_t thread;
+
+	if (pthread_create (&thread, NULL, RunKeywordSearchWorker, search_p) == 0)
+		{
+			pthread_detach (thread);
+			success_flag = true;
+		}
+#endif
+
+	if (!success_flag)
+		{
+			ChangeNumberOfActiveWorkers (false);
+		}
+
+	return success_flag;
+}
+
+
+/*
+ * Each worker keeps taking the next Service that hasn't been started
+ * until there are none left.
+ */
+#ifdef _WIN32
+static DWORD WINAPI RunKeywordSearchWorker (LPVOID data_p)
+#else
+static void *RunKeywordSearchWorker (void *data_p)
+#endif
+{
+	KeywordSearch *search_p = (KeywordSearch *) data_p;
+	bool loop_flag = true;
+
+	SetLogCorrelationId ((* (search_p -> ks_correlation_id_s) != '\0') ? search_p -> ks_correlation_id_s : NULL);
+	SetTraceParent ((* (search_p -> ks_trace_parent_s) != '\0') ? search_p -> ks_trace_parent_s : NULL);
+
+	while (loop_flag)
+		{
+			KeywordSearchTask *task_p = NULL;
+
+			LockKeywordSearch (search_p);
+
+			if (search_p -> ks_next_task < search_p -> ks_num_tasks)
+				{
+					task_p = search_p -> ks_tasks_p + (search_p -> ks_next_task);
+					task_p -> kst_state = KSTS_RUNNING;
+
+					++ (search_p -> ks_next_task);
+				}
+			else
+				{
+					-- (search_p -> ks_num_workers);
+					loop_flag = false;
+				}
+
+			UnlockKeywordSearch (search_p);
+
+			if (task_p)
+				{
+					RunKeywordSearchTask (search_p, task_p);
+				}
+		}
+
+	SetTraceParent (NULL);
+	SetLogCorrelationId (NULL);
+
+	ReleaseKeywordSearch (search_p);
+
+	/* This must be the last thing that the worker does */
+	ChangeNumberOfActiveWorkers (false);
+
+#ifdef _WIN32
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+
+static void RunKeywordSearchTask (KeywordSearch *search_p, KeywordSearchTask *task_p)
+{
+	Service *service_p = task_p -> kst_service_p;
+	const char *service_name_s = task_p -> kst_service_name_s;
+	json_t *task_results_p = json_array ();
+	const uint64 start_time = GetMetricsTime ();
+	Span *span_p = StartSpan (service_name_s, SK_INTERNAL);
+	bool success_flag = false;
+
+	AddSpanAttribute (span_p, "grassroots.service", service_name_s);
+
+	if (task_results_p)
+		{
+			ParameterSet *params_p = GetServiceParameters (service_p, NULL, search_p -> ks_user_p);
+
+			if (params_p)
+				{
+					if (SetKeywordParameters (params_p, search_p -> ks_keyword_s, service_name_s))
+						{
+							ServiceJobSet *jobs_set_p = RunService (service_p, params_p, search_p -> ks_user_p, task_p -> kst_providers_p);
+
+							if (jobs_set_p)
+								{
+									success_flag = ProcessServiceJobSet (jobs_set_p, task_results_p);
+								}
+							else
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to run service \"%s\" with keyword \"%s\"", service_name_s, search_p -> ks_keyword_s);
+								}
+						}
+
+					ReleaseServiceParameters (service_p, params_p);
+				}		/* if (params_p) */
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to get parameters for service \"%s\" to run with keyword \"%s\"", service_name_s, search_p -> ks_keyword_s);
+				}
+
+		}		/* if (task_results_p) */
+
+	RecordMetric (METRICS_SERVICE_S, service_name_s, start_time, success_flag);
+	EndSpan (span_p, success_flag);
+
+	LockKeywordSearch (search_p);
+
+	/* If the caller has stopped waiting, these results are too late to use */
+	if (task_results_p && (search_p -> ks_results_p))
+		{
+			if (json_array_extend (search_p -> ks_results_p, task_results_p) != 0)
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add results for service \"%s\" with keyword \"%s\"", service_name_s, search_p -> ks_keyword_s);
+				}
+		}
+
+	/* The results share their values with ks_results_p so release them whilst it is locked */
+	if (task_results_p)
+		{
+			json_decref (task_results_p);
+		}
+
+	task_p -> kst_state = KSTS_FINISHED;
+	++ (search_p -> ks_num_finished_tasks);
+
+	SignalKeywordSearch (search_p);
+	UnlockKeywordSearch (search_p);
+
+	/* The same check as FreeServiceNode () so that attached asynchronous Services are kept */
+	if ((service_p -> se_synchronous != SY_ASYNCHRONOUS_ATTACHED) || (!IsServiceRunning (service_p)))
+		{
+			FreeService (service_p);
+		}
+
+	task_p -> kst_service_p = NULL;
+}
+
+
+static bool SetKeywordParameters (ParameterSet *params_p, const char *keyword_s, const char *service_name_s)
+{
+	bool param_flag = false;
+	ParameterNode *param_node_p = (ParameterNode *) params_p -> ps_params_p -> ll_head_p;
+
+	while (param_node_p)
+		{
+			Parameter *param_p = param_node_p -> pn_parameter_p;
+
+			/* set the keyword parameter */
+			if (param_p -> pa_type == PT_KEYWORD)
+				{
+					/* Don't change the value of a Parameter that is shared with a ParameterSetTemplate */
+					param_p = GetWritableParameterFromParameterNode (params_p, param_node_p);
+
+					if (!param_p)
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to get writable keyword parameter \"%s\" for service \"%s\"", param_node_p -> pn_parameter_p -> pa_name_s, service_name_s);
+							return false;
+						}
+
+					if (IsStringParameter (param_p))
+						{
+							if (SetStringParameterCurrentValue ((StringParameter *) param_p, keyword_s))
+								{
+									param_flag = true;
+								}
+							else
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to set service param \"%s\" - \"%s\" to \"%s\"", service_name_s, param_p -> pa_name_s, keyword_s);
+									return false;
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Parameter is keyword but not a string param for service \"%s\" - \"%s\" to \"%s\"", service_name_s, param_p -> pa_name_s, keyword_s);
+							return false;
+						}
+				}
+
+			param_node_p = (ParameterNode *) (param_node_p -> pn_node.ln_next_p);
+		}		/* while (param_node_p) */
+
+	return param_flag;
+}
+
+
+static void LockKeywordSearch (KeywordSearch *search_p)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive (& (search_p -> ks_lock));
+#else
+	pthread_mutex_lock (& (search_p -> ks_lock));
+#endif
+}
+
+
+static void UnlockKeywordSearch (KeywordSearch *search_p)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive (& (search_p -> ks_lock));
+#else
+	pthread_mutex_unlock (& (search_p -> ks_lock));
+#endif
+}
+
+
+/*
+ * Wait, with the lock held, for a Service to finish. This returns false
+ * once the search's deadline has passed.
+ */
+static bool WaitForKeywordSearchTask (KeywordSearch *search_p)
+{
+	const uint64 now = GetMetricsTime ();
+	uint64 remaining;
+
+	if (now >= search_p -> ks_deadline)
+		{
+			return false;
+		}
+
+	remaining = search_p -> ks_deadline - now;
+
+#ifdef _WIN32
+	SleepConditionVariableSRW (& (search_p -> ks_finished_condition), & (search_p -> ks_lock), (DWORD) ((remaining + 999) / 1000), 0);
+#else
+	{
+		struct timespec wake_time;
+
+		clock_gettime (CLOCK_REALTIME, &wake_time);
+
+		wake_time.tv_sec += (time_t) (remaining / 1000000);
+		wake_time.tv_nsec += (long) ((remaining % 1000000) * 1000);
+
+		if (wake_time.tv_nsec >= 1000000000L)
+			{
+				++ wake_time.tv_sec;
+				wake_time.tv_nsec -= 1000000000L;
+			}
+
+		pthread_cond_timedwait (& (search_p -> ks_finished_condition), & (search_p -> ks_lock), &wake_time);
+	}
+#endif
+
+	return true;
+}
+
+
+static void SignalKeywordSearch (KeywordSearch *search_p)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable (& (search_p -> ks_finished_condition));
+#else
+	pthread_cond_broadcast (& (search_p -> ks_finished_condition));
+#endif
+}
+
+
+static void ChangeNumberOfActiveWorkers (const bool increment_flag)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive (&s_workers_lock);
+#else
+	pthread_mutex_lock (&s_workers_lock);
+#endif
+
+	if (increment_flag)
+		{
+			++ s_num_active_workers;
+		}
+	else if (-- s_num_active_workers == 0)
+		{
+#ifdef _WIN32
+			WakeAllConditionVariable (&s_workers_condition);
+#else
+			pthread_cond_broadcast (&s_workers_condition);
+#endif
+		}
+
+#ifdef _WIN32
+	ReleaseSRWLockExclusive (&s_workers_lock);
+#else
+	pthread_mutex_unlock (&s_workers_lock);
+#endif
+}
@@ -0,0 +1,297 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * keyword_search_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the KeywordSearch using stand-in Services that sleep for a
+ *  fixed time before returning a single result. It checks that the
+ *  Services run in parallel, that each one is given the keyword and that
+ *  a search which passes its deadline returns the results that are ready
+ *  and lists the Services that aren't.
+ *
+ *  Usage: keyword_search_test
+ */
+
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "jansson.h"
+
+#include "keyword_search.h"
+#include "memory_allocations.h"
+#include "service_job.h"
+#include "string_parameter.h"
+#include "unit_test.h"
+
+
+#define NUM_SERVICES (16)
+
+#define NUM_WORKERS (8)
+
+/* The time in milliseconds that each stand-in Service takes */
+#define RUN_TIME (100)
+
+#define SLOW_RUN_TIME (1000)
+
+
+static const char * const S_KEYWORD_S = "wheat";
+
+
+typedef struct SleepingService
+{
+	Service ss_base;
+
+	ServiceData ss_data;
+
+	char ss_name_s [32];
+
+	uint32 ss_run_time;
+} SleepingService;
+
+
+static uint32 s_num_keywords_matched = 0;
+
+
+static uint64 GetTimeInMilliseconds (void)
+{
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+
+	return (((uint64) tv.tv_sec) * 1000) + (tv.tv_usec / 1000);
+}
+
+
+static const char *GetSleepingServiceName (const Service *service_p)
+{
+	return ((const SleepingService *) service_p) -> ss_name_s;
+}
+
+
+static const char *GetSleepingServiceAlias (const Service * UNUSED_PARAM (service_p))
+{
+	return NULL;
+}
+
+
+static ParameterSet *GetSleepingServiceParameters (Service *service_p, DataResource * UNUSED_PARAM (resource_p), User * UNUSED_PARAM (user_p))
+{
+	ParameterSet *params_p = AllocateParameterSet ("sleeping parameters", NULL);
+
+	if (params_p)
+		{
+			if (!EasyCreateAndAddStringParameterToParameterSet (& (((SleepingService *) service_p) -> ss_data), params_p, NULL, PT_KEYWORD, "query", NULL, NULL, NULL, PL_ALL))
+				{
+					FreeParameterSet (params_p);
+					params_p = NULL;
+				}
+		}
+
+	return params_p;
+}
+
+
+static void ReleaseSleepingServiceParameters (Service * UNUSED_PARAM (service_p), ParameterSet *params_p)
+{
+	FreeParameterSet (params_p);
+}
+
+
+static ServiceJobSet *RunSleepingService (Service *service_p, ParameterSet *param_set_p, User * UNUSED_PARAM (user_p), ProvidersStateTable * UNUSED_PARAM (providers_p))
+{
+	SleepingService *sleeping_service_p = (SleepingService *) service_p;
+	const char *keyword_s = NULL;
+	ServiceJobSet *jobs_p;
+
+	if (GetCurrentStringParameterValueFromParameterSet (param_set_p, "query", &keyword_s) && keyword_s && (strcmp (keyword_s, S_KEYWORD_S) == 0))
+		{
+			__atomic_add_fetch (&s_num_keywords_matched, 1, __ATOMIC_SEQ_CST);
+		}
+
+	usleep (sleeping_service_p -> ss_run_time * 1000);
+
+	jobs_p = AllocateSimpleServiceJobSet (service_p, sleeping_service_p -> ss_name_s, NULL);
+
+	if (jobs_p)
+		{
+			ServiceJob *job_p = ((ServiceJobNode *) (jobs_p -> sjs_jobs_p -> ll_head_p)) -> sjn_job_p;
+
+			SetServiceJobStatus (job_p, OS_SUCCEEDED);
+		}
+
+	return jobs_p;
+}
+
+
+static bool CloseSleepingService (Service * UNUSED_PARAM (service_p))
+{
+	return true;
+}
+
+
+/*
+ * The KeywordSearch frees its Services with FreeService () so they are
+ * allocated in the same way as those from a plugin.
+ */
+static Service *AllocateSleepingService (const uint32 index, const uint32 run_time)
+{
+	SleepingService *sleeping_service_p = (SleepingService *) AllocMemory (sizeof (SleepingService));
+
+	if (sleeping_service_p)
+		{
+			Service *service_p = & (sleeping_service_p -> ss_base);
+
+			memset (sleeping_service_p, 0, sizeof (SleepingService));
+
+			snprintf (sleeping_service_p -> ss_name_s, sizeof (sleeping_service_p -> ss_name_s), "sleeping service " UINT32_FMT, index);
+			sleeping_service_p -> ss_run_time = run_time;
+			sleeping_service_p -> ss_data.sd_service_p = service_p;
+
+			service_p -> se_get_service_name_fn = GetSleepingServiceName;
+			service_p -> se_get_service_alias_fn = GetSleepingServiceAlias;
+			service_p -> se_get_params_fn = GetSleepingServiceParameters;
+			service_p -> se_release_params_fn = ReleaseSleepingServiceParameters;
+			service_p -> se_run_fn = RunSleepingService;
+			service_p -> se_close_fn = CloseSleepingService;
+			service_p -> se_synchronous = SY_SYNCHRONOUS;
+
+			InitLinkedList (& (service_p -> se_paired_services));
+			InitLinkedList (& (service_p -> se_linked_services));
+
+			return service_p;
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Run a KeywordSearch over num_services Services with the given run times
+ * and return how many results it got back.
+ */
+static uint32 RunSearch (const uint32 * const run_times_p, const uint32 num_services, const uint32 timeout, uint32 *num_incomplete_p, uint64 *duration_p)
+{
+	json_t *results_p = json_array ();
+	json_t *incomplete_services_p = json_array ();
+	uint32 num_results = 0;
+
+	*num_incomplete_p = 0;
+
+	if (results_p && incomplete_services_p)
+		{
+			const uint64 start_time = GetTimeInMilliseconds ();
+			KeywordSearch *search_p = AllocateKeywordSearch (S_KEYWORD_S, NULL, NULL, results_p, num_services, NUM_WORKERS, timeout);
+
+			if (search_p)
+				{
+					uint32 i;
+
+					for (i = 0; i < num_services; ++ i)
+						{
+							Service *service_p = AllocateSleepingService (i, run_times_p [i]);
+
+							if (service_p)
+								{
+									if (!AddServiceToKeywordSearch (search_p, service_p))
+										{
+											FreeService (service_p);
+										}
+								}
+						}
+
+					*num_incomplete_p = WaitForKeywordSearch (search_p, incomplete_services_p);
+					*duration_p = GetTimeInMilliseconds () - start_time;
+
+					Check (json_array_size (incomplete_services_p) == *num_incomplete_p, "list each incomplete Service");
+
+					num_results = (uint32) json_array_size (results_p);
+
+					FreeKeywordSearch (search_p);
+				}
+			else
+				{
+					Check (false, "allocate the KeywordSearch");
+				}
+		}
+
+	if (results_p)
+		{
+			json_decref (results_p);
+		}
+
+	if (incomplete_services_p)
+		{
+			json_decref (incomplete_services_p);
+		}
+
+	return num_results;
+}
+
+
+static void TestParallelSearch (void)
+{
+	uint32 run_times [NUM_SERVICES];
+	uint32 num_incomplete;
+	uint64 duration = 0;
+	uint32 num_results;
+	uint32 i;
+
+	for (i = 0; i < NUM_SERVICES; ++ i)
+		{
+			run_times [i] = RUN_TIME;
+		}
+
+	num_results = RunSearch (run_times, NUM_SERVICES, 10 * NUM_SERVICES * RUN_TIME, &num_incomplete, &duration);
+
+	printf ("ran " UINT32_FMT " Services of %d ms with %d workers in " UINT32_FMT " ms\n", (uint32) NUM_SERVICES, RUN_TIME, NUM_WORKERS, (uint32) duration);
+
+	Check ((num_results == NUM_SERVICES) && (num_incomplete == 0), "get the results from every Service");
+	Check (__atomic_load_n (&s_num_keywords_matched, __ATOMIC_SEQ_CST) == NUM_SERVICES, "give each Service the keyword");
+
+	/* Running them one after another would take NUM_SERVICES * RUN_TIME */
+	Check (duration < ((NUM_SERVICES / NUM_WORKERS) + 2) * RUN_TIME, "run the Services in parallel");
+}
+
+
+static void TestDeadline (void)
+{
+	const uint32 run_times [] = { RUN_TIME, RUN_TIME, SLOW_RUN_TIME, RUN_TIME };
+	const uint32 num_services = sizeof (run_times) / sizeof (run_times [0]);
+	uint32 num_incomplete;
+	uint64 duration = 0;
+	uint32 num_results;
+
+	num_results = RunSearch (run_times, num_services, 3 * RUN_TIME, &num_incomplete, &duration);
+
+	Check ((num_results == num_services - 1) && (num_incomplete == 1), "return the results that are ready by the deadline");
+	Check (duration < SLOW_RUN_TIME, "stop waiting at the deadline");
+}
+
+
+int main (void)
+{
+	TestParallelSearch ();
+	TestDeadline ();
+
+	/* Let the slow Service finish before exiting */
+	WaitForKeywordSearchWorkers ();
+
+	return GetTestResult ();
+}
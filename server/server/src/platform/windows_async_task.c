@@ -247,6 +247,22 @@ OperationStatus ActualRunSystemAsyncTask (SystemAsyncTask *task_p)
 	return RunProcess (task_p -> std_command_line_s);
 }
 
+
+bool ActualStartSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	/* There's no process supervisor on this platform so a thread waits for the command line */
+	return RunBlockingSystemAsyncTask (task_p);
+}
+
+
+bool CancelSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	/* The command line is run with system () on this platform so it can't be stopped */
+	PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Cancelling \"%s\" is not supported on this platform", task_p -> std_command_line_s);
+
+	return false;
+}
+
 static DWORD WINAPI DoAsyncTaskRun (LPVOID data_p)
 {
 	WindowsAsyncTask *win_task_p = (WindowsAsyncTask *) data_p;
@@ -0,0 +1,485 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * request_coalescer.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <string.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+#include "request_coalescer.h"
+#include "hash_map.h"
+#include "json_util.h"
+#include "memory_allocations.h"
+#include "metrics.h"
+#include "schema_keys.h"
+#include "streams.h"
+#include "string_utils.h"
+
+
+#ifdef _WIN32
+	typedef SRWLOCK RequestCoalescerLock;
+	typedef CONDITION_VARIABLE RequestCoalescerCondition;
+#else
+	typedef pthread_mutex_t RequestCoalescerLock;
+	typedef pthread_cond_t RequestCoalescerCondition;
+#endif
+
+
+typedef struct CoalescedRequest
+{
+	/* A copy of the response to share. This is NULL until the request has finished or if it failed */
+	json_t *cr_response_p;
+
+	/* The value of GetMetricsTime () when the request finished */
+	uint64 cr_finish_time;
+
+	bool cr_finished_flag;
+
+	/* The HashMap and each request using this one each hold a reference */
+	uint32 cr_num_references;
+} CoalescedRequest;
+
+
+struct RequestCoalescer
+{
+	RequestCoalescerLock rc_lock;
+
+	/* Signalled each time that a request finishes */
+	RequestCoalescerCondition rc_finished_condition;
+
+	/* The CoalescedRequests keyed by their canonical requests */
+	HashMap *rc_requests_p;
+
+	bool rc_operations [OP_NUM_OPERATIONS];
+
+	/* The time in microseconds to keep each response for */
+	uint64 rc_ttl;
+};
+
+
+static bool SetCoalescedOperation (RequestCoalescer *coalescer_p, const char *op_s);
+
+static char *GetCoalescedRequestKey (const Operation op, const json_t *req_p, const User *user_p);
+
+static CoalescedRequest *AllocateCoalescedRequest (void);
+
+static void ReleaseCoalescedRequest (void *request_p);
+
+static void RemoveExpiredCoalescedRequests (RequestCoalescer *coalescer_p, const uint64 now);
+
+static bool HasCoalescedRequestExpired (const RequestCoalescer *coalescer_p, const CoalescedRequest *request_p, const uint64 now);
+
+static void LockRequestCoalescer (RequestCoalescer *coalescer_p);
+
+static void UnlockRequestCoalescer (RequestCoalescer *coalescer_p);
+
+
+
+RequestCoalescer *AllocateRequestCoalescer (const json_t *config_p)
+{
+	const json_t *ops_p = json_object_get (config_p, REQUEST_COALESCING_OPERATIONS_S);
+
+	if (json_is_array (ops_p) && (json_array_size (ops_p) > 0))
+		{
+			RequestCoalescer *coalescer_p = (RequestCoalescer *) AllocMemory (sizeof (RequestCoalescer));
+
+			if (coalescer_p)
+				{
+					coalescer_p -> rc_requests_p = AllocateHashMap (64, 75, HMKT_STRING, MF_DEEP_COPY, MF_SHALLOW_COPY);
+
+					if (coalescer_p -> rc_requests_p)
+						{
+							uint32 ttl = REQUEST_COALESCER_DEFAULT_TTL;
+							bool enabled_flag = false;
+							size_t i;
+							const json_t *op_p;
+
+							SetHashMapValueFunctions (coalescer_p -> rc_requests_p, NULL, ReleaseCoalescedRequest);
+							memset (coalescer_p -> rc_operations, 0, sizeof (coalescer_p -> rc_operations));
+
+							json_array_foreach (ops_p, i, op_p)
+								{
+									const char *op_s = json_string_value (op_p);
+
+									if (op_s && SetCoalescedOperation (coalescer_p, op_s))
+										{
+											enabled_flag = true;
+										}
+									else
+										{
+											PrintJSONToErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, op_p, "Can't coalesce requests for this operation");
+										}
+								}
+
+							if (enabled_flag)
+								{
+									GetJSONUnsignedInteger (config_p, REQUEST_COALESCING_TTL_S, &ttl);
+									coalescer_p -> rc_ttl = 1000 * (uint64) ttl;
+
+#ifdef _WIN32
+									InitializeSRWLock (& (coalescer_p -> rc_lock));
+									InitializeConditionVariable (& (coalescer_p -> rc_finished_condition));
+#else
+									pthread_mutex_init (& (coalescer_p -> rc_lock), NULL);
+									pthread_cond_init (& (coalescer_p -> rc_finished_condition), NULL);
+#endif
+
+									return coalescer_p;
+								}
+
+							FreeHashMap (coalescer_p -> rc_requests_p);
+						}		/* if (coalescer_p -> rc_requests_p) */
+
+					FreeMemory (coalescer_p);
+				}		/* if (coalescer_p) */
+
+		}		/* if (json_is_array (ops_p) && (json_array_size (ops_p) > 0)) */
+	else
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "No \"%s\" set in the \"%s\" configuration", REQUEST_COALESCING_OPERATIONS_S, REQUEST_COALESCING_S);
+		}
+
+	return NULL;
+}
+
+
+void FreeRequestCoalescer (RequestCoalescer *coalescer_p)
+{
+	FreeHashMap (coalescer_p -> rc_requests_p);
+
+#ifndef _WIN32
+	pthread_cond_destroy (& (coalescer_p -> rc_finished_condition));
+	pthread_mutex_destroy (& (coalescer_p -> rc_lock));
+#endif
+
+	FreeMemory (coalescer_p);
+}
+
+
+bool IsOperationCoalesced (const RequestCoalescer *coalescer_p, const Operation op)
+{
+	return (coalescer_p != NULL) && (op > OP_NONE) && (op < OP_NUM_OPERATIONS) && (coalescer_p -> rc_operations [op]);
+}
+
+
+json_t *RunCoalescedOperation (RequestCoalescer *coalescer_p, GrassrootsServer *grassroots_p, const Operation op, const json_t *req_p, User *user_p, CoalescedOperationFn run_fn)
+{
+	json_t *res_p = NULL;
+	char *key_s = NULL;
+
+	/*
+	 * A User without an id or email address can't be told apart from any
+	 * other such User, so their requests are never shared.
+	 */
+	if (user_p && (! (user_p -> us_id_p)) && (! (user_p -> us_email_s)))
+		{
+			return run_fn (grassroots_p, op, req_p, user_p);
+		}
+
+	key_s = GetCoalescedRequestKey (op, req_p, user_p);
+
+	if (key_s)
+		{
+			const uint64 now = GetMetricsTime ();
+			CoalescedRequest *request_p;
+			bool run_flag = false;
+
+			LockRequestCoalescer (coalescer_p);
+
+			request_p = (CoalescedRequest *) GetFromHashMap (coalescer_p -> rc_requests_p, key_s);
+
+			if (request_p && HasCoalescedRequestExpired (coalescer_p, request_p, now))
+				{
+					RemoveFromHashMap (coalescer_p -> rc_requests_p, key_s);
+					request_p = NULL;
+				}
+
+			if (request_p)
+				{
+					/* Share the response of the identical request */
+					++ (request_p -> cr_num_references);
+
+					while (! (request_p -> cr_finished_flag))
+						{
+#ifdef _WIN32
+							SleepConditionVariableSRW (& (coalescer_p -> rc_finished_condition), & (coalescer_p -> rc_lock), INFINITE, 0);
+#else
+							pthread_cond_wait (& (coalescer_p -> rc_finished_condition), & (coalescer_p -> rc_lock));
+#endif
+						}
+
+					if (request_p -> cr_response_p)
+						{
+							res_p = json_deep_copy (request_p -> cr_response_p);
+						}
+
+					ReleaseCoalescedRequest (request_p);
+
+					PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Shared the response for an identical \"%s\" request", GetOperationAsString (op));
+				}
+			else
+				{
+					RemoveExpiredCoalescedRequests (coalescer_p, now);
+
+					request_p = AllocateCoalescedRequest ();
+
+					if (request_p)
+						{
+							if (PutInHashMap (coalescer_p -> rc_requests_p, key_s, request_p))
+								{
+									/* Keep our own reference as the HashMap's one may go before we finish */
+									++ (request_p -> cr_num_references);
+									run_flag = true;
+								}
+							else
+								{
+									ReleaseCoalescedRequest (request_p);
+									request_p = NULL;
+								}
+						}
+				}
+
+			UnlockRequestCoalescer (coalescer_p);
+
+			if (run_flag)
+				{
+					json_t *shared_res_p;
+
+					res_p = run_fn (grassroots_p, op, req_p, user_p);
+
+					/* Give the waiting requests a copy that the caller can't change */
+					shared_res_p = res_p ? json_deep_copy (res_p) : NULL;
+
+					LockRequestCoalescer (coalescer_p);
+
+					request_p -> cr_response_p = shared_res_p;
+					request_p -> cr_finish_time = GetMetricsTime ();
+					request_p -> cr_finished_flag = true;
+
+					/* Any waiting requests already hold references so failed responses needn't be kept */
+					if ((!shared_res_p) || (coalescer_p -> rc_ttl == 0))
+						{
+							if (GetFromHashMap (coalescer_p -> rc_requests_p, key_s) == request_p)
+								{
+									RemoveFromHashMap (coalescer_p -> rc_requests_p, key_s);
+								}
+						}
+
+					ReleaseCoalescedRequest (request_p);
+
+#ifdef _WIN32
+					WakeAllConditionVariable (& (coalescer_p -> rc_finished_condition));
+#else
+					pthread_cond_broadcast (& (coalescer_p -> rc_finished_condition));
+#endif
+
+					UnlockRequestCoalescer (coalescer_p);
+				}
+			else if (!request_p)
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to coalesce \"%s\" request", GetOperationAsString (op));
+					res_p = run_fn (grassroots_p, op, req_p, user_p);
+				}
+
+			FreeCopiedString (key_s);
+		}		/* if (key_s) */
+	else
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get key for \"%s\" request", GetOperationAsString (op));
+			res_p = run_fn (grassroots_p, op, req_p, user_p);
+		}
+
+	return res_p;
+}
+
+
+/*
+ * Only the Operations that just read data can be coalesced as the
+ * others have side effects that each request needs to have.
+ */
+static bool SetCoalescedOperation (RequestCoalescer *coalescer_p, const char *op_s)
+{
+	const Operation op = GetOperationFromString (op_s);
+
+	switch (op)
+		{
+			case OP_LIST_ALL_SERVICES:
+			case OP_LIST_INTERESTED_SERVICES:
+			case OP_GET_NAMED_SERVICES:
+			case OP_GET_SERVICE_INFO:
+				coalescer_p -> rc_operations [op] = true;
+				return true;
+
+			default:
+				break;
+		}
+
+	return false;
+}
+
+
+static char *GetCoalescedRequestKey (const Operation op, const json_t *req_p, const User *user_p)
+{
+	char *key_s = NULL;
+	json_t *copied_req_p = json_copy ((json_t *) req_p);
+
+	if (copied_req_p)
+		{
+			char *req_s;
+
+			/* Each request has its own traceparent so it mustn't stop identical requests from matching */
+			json_object_del (copied_req_p, TRACE_PARENT_S);
+
+			req_s = json_dumps (copied_req_p, JSON_COMPACT | JSON_SORT_KEYS);
+
+			if (req_s)
+				{
+					/* The user part is marked so that ids, email addresses and anonymous requests can't match each other */
+					char user_id_s [25];
+					const char *user_type_s = "anonymous:";
+					const char *user_s = "";
+
+					if (user_p)
+						{
+							if (user_p -> us_id_p)
+								{
+									bson_oid_to_string (user_p -> us_id_p, user_id_s);
+									user_type_s = "id:";
+									user_s = user_id_s;
+								}
+							else
+								{
+									user_type_s = "email:";
+									user_s = user_p -> us_email_s;
+								}
+						}
+
+					key_s = ConcatenateVarargsStrings (GetOperationAsString (op), " ", user_type_s, user_s, " ", req_s, NULL);
+
+					free (req_s);
+				}
+
+			json_decref (copied_req_p);
+		}
+
+	return key_s;
+}
+
+
+static CoalescedRequest *AllocateCoalescedRequest (void)
+{
+	CoalescedRequest *request_p = (CoalescedRequest *) AllocMemory (sizeof (CoalescedRequest));
+
+	if (request_p)
+		{
+			request_p -> cr_response_p = NULL;
+			request_p -> cr_finish_time = 0;
+			request_p -> cr_finished_flag = false;
+			request_p -> cr_num_references = 1;
+		}
+
+	return request_p;
+}
+
+
+/* This must be called with the lock held */
+static void ReleaseCoalescedRequest (void *data_p)
+{
+	CoalescedRequest *request_p = (CoalescedRequest *) data_p;
+
+	if (-- (request_p -> cr_num_references) == 0)
+		{
+			if (request_p -> cr_response_p)
+				{
+					json_decref (request_p -> cr_response_p);
+				}
+
+			FreeMemory (request_p);
+		}
+}
+
+
+/* This must be called with the lock held */
+static void RemoveExpiredCoalescedRequests (RequestCoalescer *coalescer_p, const uint64 now)
+{
+	const uint32 num_requests = GetHashMapSize (coalescer_p -> rc_requests_p);
+
+	if (num_requests > 0)
+		{
+			const char **keys_ss = (const char **) AllocMemoryArray (num_requests, sizeof (const char *));
+
+			if (keys_ss)
+				{
+					uint32 num_expired = 0;
+					uint32 index = 0;
+					const void *key_p;
+					void *value_p;
+
+					/* The HashMap can't be changed whilst stepping through it so remove the entries afterwards */
+					while (GetNextHashMapEntry (coalescer_p -> rc_requests_p, &index, &key_p, &value_p))
+						{
+							if (HasCoalescedRequestExpired (coalescer_p, (const CoalescedRequest *) value_p, now))
+								{
+									keys_ss [num_expired] = (const char *) key_p;
+									++ num_expired;
+								}
+						}
+
+					while (num_expired > 0)
+						{
+							-- num_expired;
+							RemoveFromHashMap (coalescer_p -> rc_requests_p, keys_ss [num_expired]);
+						}
+
+					FreeMemory (keys_ss);
+				}
+		}
+}
+
+
+static bool HasCoalescedRequestExpired (const RequestCoalescer *coalescer_p, const CoalescedRequest *request_p, const uint64 now)
+{
+	return (request_p -> cr_finished_flag) && (now >= request_p -> cr_finish_time + coalescer_p -> rc_ttl);
+}
+
+
+static void LockRequestCoalescer (RequestCoalescer *coalescer_p)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive (& (coalescer_p -> rc_lock));
+#else
+	pthread_mutex_lock (& (coalescer_p -> rc_lock));
+#endif
+}
+
+
+static void UnlockRequestCoalescer (RequestCoalescer *coalescer_p)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive (& (coalescer_p -> rc_lock));
+#else
+	pthread_mutex_unlock (& (coalescer_p -> rc_lock));
+#endif
+}
@@ -0,0 +1,254 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * request_coalescer_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the RequestCoalescer. Concurrent clients send identical
+ *  requests to a stand-in backend that counts how many times it runs,
+ *  to check that in-flight requests are shared, that responses expire
+ *  after their time to live, that failed responses aren't kept and that
+ *  requests from different or unidentifiable Users aren't shared.
+ *
+ *  Usage: request_coalescer_test
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "jansson.h"
+
+#include "request_coalescer.h"
+#include "schema_keys.h"
+#include "unit_test.h"
+
+
+#define NUM_CLIENTS (8)
+
+/* The time in milliseconds that a response is kept for */
+#define TTL (200)
+
+
+typedef struct Client
+{
+	RequestCoalescer *cl_coalescer_p;
+
+	const json_t *cl_req_p;
+
+	User *cl_user_p;
+
+	json_t *cl_res_p;
+} Client;
+
+
+static uint32 s_num_runs = 0;
+
+
+/*
+ * Stand in for a slow backend such as building the list of Services.
+ */
+static json_t *RunBackend (GrassrootsServer * UNUSED_PARAM (grassroots_p), const Operation UNUSED_PARAM (op), const json_t *req_p, User * UNUSED_PARAM (user_p))
+{
+	__atomic_add_fetch (&s_num_runs, 1, __ATOMIC_SEQ_CST);
+
+	usleep (100000);
+
+	if (json_object_get (req_p, "fail"))
+		{
+			return NULL;
+		}
+
+	return json_pack ("{s:s}", "services", "listed");
+}
+
+
+static uint32 GetNumRuns (void)
+{
+	return __atomic_load_n (&s_num_runs, __ATOMIC_SEQ_CST);
+}
+
+
+static void *RunClient (void *data_p)
+{
+	Client *client_p = (Client *) data_p;
+
+	client_p -> cl_res_p = RunCoalescedOperation (client_p -> cl_coalescer_p, NULL, OP_LIST_ALL_SERVICES, client_p -> cl_req_p, client_p -> cl_user_p, RunBackend);
+
+	return NULL;
+}
+
+
+/*
+ * Send the same request from NUM_CLIENTS threads at once and return how
+ * many times the backend ran. If users_pp is given, each client uses
+ * the User at the same index.
+ */
+static uint32 RunConcurrentClients (RequestCoalescer *coalescer_p, const json_t *req_p, User **users_pp, bool *all_responses_flag_p)
+{
+	pthread_t threads [NUM_CLIENTS];
+	Client clients [NUM_CLIENTS];
+	const uint32 num_runs = GetNumRuns ();
+	uint32 i;
+
+	*all_responses_flag_p = true;
+
+	for (i = 0; i < NUM_CLIENTS; ++ i)
+		{
+			clients [i].cl_coalescer_p = coalescer_p;
+			clients [i].cl_req_p = req_p;
+			clients [i].cl_user_p = users_pp ? users_pp [i] : NULL;
+			clients [i].cl_res_p = NULL;
+
+			pthread_create (threads + i, NULL, RunClient, clients + i);
+		}
+
+	for (i = 0; i < NUM_CLIENTS; ++ i)
+		{
+			pthread_join (threads [i], NULL);
+
+			if (clients [i].cl_res_p)
+				{
+					if (strcmp (json_string_value (json_object_get (clients [i].cl_res_p, "services")), "listed") != 0)
+						{
+							*all_responses_flag_p = false;
+						}
+
+					json_decref (clients [i].cl_res_p);
+				}
+			else
+				{
+					*all_responses_flag_p = false;
+				}
+		}
+
+	return GetNumRuns () - num_runs;
+}
+
+
+static void TestSharing (RequestCoalescer *coalescer_p)
+{
+	json_t *req_p = json_pack ("{s:s,s:s}", "operation", "list all", TRACE_PARENT_S, "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01");
+	json_t *other_req_p = json_pack ("{s:s,s:s}", TRACE_PARENT_S, "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b8-01", "operation", "list all");
+	bool all_responses_flag;
+	uint32 num_runs;
+
+	num_runs = RunConcurrentClients (coalescer_p, req_p, NULL, &all_responses_flag);
+	Check ((num_runs == 1) && all_responses_flag, "run concurrent identical requests once and share the response");
+
+	num_runs = GetNumRuns ();
+	json_decref (RunCoalescedOperation (coalescer_p, NULL, OP_LIST_ALL_SERVICES, other_req_p, NULL, RunBackend));
+	Check (GetNumRuns () == num_runs, "share a finished response within its time to live, ignoring the traceparent");
+
+	usleep (2 * TTL * 1000);
+
+	json_decref (RunCoalescedOperation (coalescer_p, NULL, OP_LIST_ALL_SERVICES, req_p, NULL, RunBackend));
+	Check (GetNumRuns () == num_runs + 1, "run the request again once its response has expired");
+
+	json_decref (other_req_p);
+	json_decref (req_p);
+}
+
+
+static void TestFailures (RequestCoalescer *coalescer_p)
+{
+	json_t *req_p = json_pack ("{s:s,s:b}", "operation", "list all", "fail", 1);
+	const uint32 num_runs = GetNumRuns ();
+	json_t *res_p;
+
+	res_p = RunCoalescedOperation (coalescer_p, NULL, OP_LIST_ALL_SERVICES, req_p, NULL, RunBackend);
+	Check (res_p == NULL, "return the failed response");
+
+	res_p = RunCoalescedOperation (coalescer_p, NULL, OP_LIST_ALL_SERVICES, req_p, NULL, RunBackend);
+	Check ((res_p == NULL) && (GetNumRuns () == num_runs + 2), "don't keep failed responses");
+
+	json_decref (req_p);
+}
+
+
+static void TestUsers (RequestCoalescer *coalescer_p)
+{
+	json_t *req_p = json_pack ("{s:s,s:s}", "operation", "list all", "user", "specific");
+	User named_users [NUM_CLIENTS];
+	User unnamed_user;
+	User *users_pp [NUM_CLIENTS];
+	char emails [NUM_CLIENTS][32];
+	bool all_responses_flag;
+	uint32 num_runs;
+	uint32 i;
+
+	memset (named_users, 0, sizeof (named_users));
+	memset (&unnamed_user, 0, sizeof (unnamed_user));
+
+	for (i = 0; i < NUM_CLIENTS; ++ i)
+		{
+			snprintf (emails [i], sizeof (emails [i]), "user%u@example.org", i & 1);
+			named_users [i].us_email_s = emails [i];
+			users_pp [i] = named_users + i;
+		}
+
+	num_runs = RunConcurrentClients (coalescer_p, req_p, users_pp, &all_responses_flag);
+	Check ((num_runs == 2) && all_responses_flag, "share responses only between requests from the same User");
+
+	usleep (2 * TTL * 1000);
+
+	for (i = 0; i < NUM_CLIENTS; ++ i)
+		{
+			users_pp [i] = &unnamed_user;
+		}
+
+	num_runs = RunConcurrentClients (coalescer_p, req_p, users_pp, &all_responses_flag);
+	Check ((num_runs == NUM_CLIENTS) && all_responses_flag, "never share requests from a User without an id or email address");
+
+	num_runs = GetNumRuns ();
+	json_decref (RunCoalescedOperation (coalescer_p, NULL, OP_LIST_ALL_SERVICES, req_p, NULL, RunBackend));
+	json_decref (RunCoalescedOperation (coalescer_p, NULL, OP_LIST_ALL_SERVICES, req_p, users_pp [0], RunBackend));
+	Check (GetNumRuns () == num_runs + 2, "don't share anonymous responses with an unidentifiable User");
+
+	json_decref (req_p);
+}
+
+
+int main (void)
+{
+	json_t *config_p = json_pack ("{s:[s],s:i}", REQUEST_COALESCING_OPERATIONS_S, GetOperationAsString (OP_LIST_ALL_SERVICES), REQUEST_COALESCING_TTL_S, TTL);
+	RequestCoalescer *coalescer_p = config_p ? AllocateRequestCoalescer (config_p) : NULL;
+
+	if (coalescer_p)
+		{
+			Check (IsOperationCoalesced (coalescer_p, OP_LIST_ALL_SERVICES) && !IsOperationCoalesced (coalescer_p, OP_GET_SERVICE_RESULTS), "coalesce only the configured operations");
+
+			TestSharing (coalescer_p);
+			TestFailures (coalescer_p);
+			TestUsers (coalescer_p);
+
+			FreeRequestCoalescer (coalescer_p);
+		}
+	else
+		{
+			Check (false, "allocate RequestCoalescer");
+		}
+
+	if (config_p)
+		{
+			json_decref (config_p);
+		}
+
+	return GetTestResult ();
+}
@@ -480,6 +480,17 @@ ExternalServer *CreateExternalServerFromJSON (const json_t *json_p)
 
 					if (server_p)
 						{
+							const char *accept_encoding_s = GetJSONString (json_p, SERVER_ACCEPT_ENCODING_S);
+
+							/* Compress requests to servers that accept it but never send an Accept-Encoding header */
+							if (accept_encoding_s)
+								{
+									if (!SetConnectionAcceptedRequestEncodings (server_p -> es_connection_p, accept_encoding_s))
+										{
+											PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Can't set accepted request encodings \"%s\" for server \"%s\"", accept_encoding_s, name_s);
+										}
+								}
+
 							json_t *paired_services_json_p = json_object_get (json_p, SERVER_PAIRED_SERVICES_S);
 
 							if (paired_services_json_p)
@@ -0,0 +1,287 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * service_capabilities.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+#include "service_capabilities.h"
+#include "hash_map.h"
+#include "memory_allocations.h"
+#include "parameter_set_template.h"
+#include "schema_keys.h"
+#include "service_description_cache.h"
+#include "streams.h"
+
+
+#ifdef _WIN32
+	static SRWLOCK s_capabilities_lock = SRWLOCK_INIT;
+	#define LockCapabilities() AcquireSRWLockExclusive (&s_capabilities_lock)
+	#define UnlockCapabilities() ReleaseSRWLockExclusive (&s_capabilities_lock)
+#else
+	static pthread_mutex_t s_capabilities_lock = PTHREAD_MUTEX_INITIALIZER;
+	#define LockCapabilities() pthread_mutex_lock (&s_capabilities_lock)
+	#define UnlockCapabilities() pthread_mutex_unlock (&s_capabilities_lock)
+#endif
+
+
+/* The ServiceCapabilities keyed by Service name */
+static HashMap *s_capabilities_p = NULL;
+
+
+static ServiceCapabilities *AllocateServiceCapabilities (Service *service_p);
+
+static void FreeServiceCapabilities (ServiceCapabilities *capabilities_p);
+
+static void FreeIndexedServiceCapabilities (void *capabilities_p);
+
+static bool HasKeywordParameter (Service *service_p);
+
+static bool HasKeywordParameterInDescription (const json_t *description_p);
+
+
+
+const ServiceCapabilities *GetServiceCapabilities (Service *service_p)
+{
+	ServiceCapabilities *capabilities_p = NULL;
+	const char *service_name_s = GetServiceName (service_p);
+	bool have_index_flag = false;
+
+	LockCapabilities ();
+
+	if (!s_capabilities_p)
+		{
+			s_capabilities_p = AllocateHashMap (64, 75, HMKT_STRING, MF_DEEP_COPY, MF_SHALLOW_COPY);
+
+			if (s_capabilities_p)
+				{
+					SetHashMapValueFunctions (s_capabilities_p, NULL, FreeIndexedServiceCapabilities);
+				}
+		}
+
+	if (s_capabilities_p)
+		{
+			capabilities_p = (ServiceCapabilities *) GetFromHashMap (s_capabilities_p, service_name_s);
+			have_index_flag = true;
+		}
+
+	UnlockCapabilities ();
+
+	if ((!capabilities_p) && have_index_flag)
+		{
+			/*
+			 * Getting a Service's Parameters may be slow so work out its
+			 * capabilities without holding the lock. If another thread
+			 * gets there first, use its entry and discard ours.
+			 */
+			ServiceCapabilities *new_capabilities_p = AllocateServiceCapabilities (service_p);
+
+			if (new_capabilities_p)
+				{
+					LockCapabilities ();
+
+					capabilities_p = s_capabilities_p ? (ServiceCapabilities *) GetFromHashMap (s_capabilities_p, service_name_s) : NULL;
+
+					if ((!capabilities_p) && s_capabilities_p)
+						{
+							if (PutInHashMap (s_capabilities_p, service_name_s, new_capabilities_p))
+								{
+									capabilities_p = new_capabilities_p;
+									new_capabilities_p = NULL;
+								}
+						}
+
+					UnlockCapabilities ();
+
+					if (new_capabilities_p)
+						{
+							FreeServiceCapabilities (new_capabilities_p);
+						}
+				}
+		}
+
+	return capabilities_p;
+}
+
+
+bool IsKeywordService (Service *service_p)
+{
+	ServiceCapabilities *capabilities_p = (ServiceCapabilities *) GetServiceCapabilities (service_p);
+	bool keyword_flag = false;
+	bool known_flag = false;
+
+	if (capabilities_p)
+		{
+			LockCapabilities ();
+			known_flag = capabilities_p -> sc_keyword_known_flag;
+			keyword_flag = capabilities_p -> sc_keyword_flag;
+			UnlockCapabilities ();
+		}
+
+	if (!known_flag)
+		{
+			/*
+			 * As with GetServiceCapabilities (), don't hold the lock whilst
+			 * working this out. If two threads race, they'll store the same
+			 * answer.
+			 */
+			keyword_flag = HasKeywordParameter (service_p);
+
+			if (capabilities_p)
+				{
+					LockCapabilities ();
+					capabilities_p -> sc_keyword_flag = keyword_flag;
+					capabilities_p -> sc_keyword_known_flag = true;
+					UnlockCapabilities ();
+				}
+		}
+
+	return keyword_flag;
+}
+
+
+void FreeServiceCapabilitiesIndex (void)
+{
+	LockCapabilities ();
+
+	if (s_capabilities_p)
+		{
+			FreeHashMap (s_capabilities_p);
+			s_capabilities_p = NULL;
+		}
+
+	UnlockCapabilities ();
+}
+
+
+static ServiceCapabilities *AllocateServiceCapabilities (Service *service_p)
+{
+	ServiceCapabilities *capabilities_p = (ServiceCapabilities *) AllocMemory (sizeof (ServiceCapabilities));
+
+	if (capabilities_p)
+		{
+			capabilities_p -> sc_keyword_flag = false;
+			capabilities_p -> sc_keyword_known_flag = false;
+			capabilities_p -> sc_resource_match_flag = (service_p -> se_match_fn != NULL);
+
+			return capabilities_p;
+		}
+
+	PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to get capabilities for \"%s\"", GetServiceName (service_p));
+
+	return NULL;
+}
+
+
+static void FreeServiceCapabilities (ServiceCapabilities *capabilities_p)
+{
+	FreeMemory (capabilities_p);
+}
+
+
+static void FreeIndexedServiceCapabilities (void *capabilities_p)
+{
+	FreeServiceCapabilities ((ServiceCapabilities *) capabilities_p);
+}
+
+
+/*
+ * Use whatever the Service already has to hand before asking it to
+ * build its ParameterSet.
+ */
+static bool HasKeywordParameter (Service *service_p)
+{
+	bool keyword_flag = false;
+	const ParameterSetTemplate *template_p = GetServiceParameterSetTemplate (service_p);
+	ParameterSet *params_p = NULL;
+
+	if (template_p)
+		{
+			params_p = template_p -> pst_params_p;
+		}
+	else
+		{
+			json_t *description_p = IsServiceDescriptionCachingEnabled (service_p) ? GetCachedServiceDescription (GetServiceName (service_p), service_p -> se_data_p -> sd_config_p) : NULL;
+
+			if (description_p)
+				{
+					keyword_flag = HasKeywordParameterInDescription (description_p);
+					json_decref (description_p);
+
+					return keyword_flag;
+				}
+
+			params_p = GetServiceParameters (service_p, NULL, NULL);
+		}
+
+	if (params_p)
+		{
+			ParameterNode *param_node_p = (ParameterNode *) (params_p -> ps_params_p -> ll_head_p);
+
+			while (param_node_p && (!keyword_flag))
+				{
+					if (param_node_p -> pn_parameter_p -> pa_type == PT_KEYWORD)
+						{
+							keyword_flag = true;
+						}
+					else
+						{
+							param_node_p = (ParameterNode *) (param_node_p -> pn_node.ln_next_p);
+						}
+				}		/* while (param_node_p && (!keyword_flag)) */
+
+			if (!template_p)
+				{
+					ReleaseServiceParameters (service_p, params_p);
+				}
+		}		/* if (params_p) */
+
+	return keyword_flag;
+}
+
+
+static bool HasKeywordParameterInDescription (const json_t *description_p)
+{
+	const json_t *op_p = json_object_get (description_p, SERVER_OPERATION_S);
+	const json_t *param_set_p = op_p ? json_object_get (op_p, PARAM_SET_KEY_S) : NULL;
+	const json_t *params_p = param_set_p ? json_object_get (param_set_p, PARAM_SET_PARAMS_S) : NULL;
+
+	if (params_p)
+		{
+			size_t i;
+			const json_t *param_p;
+
+			json_array_foreach (params_p, i, param_p)
+				{
+					ParameterType param_type;
+
+					if (GetParameterTypeFromJSON (param_p, &param_type) && (param_type == PT_KEYWORD))
+						{
+							return true;
+						}
+				}
+		}
+
+	return false;
+}
@@ -17,6 +17,7 @@
 
 #include "service_matcher.h"
 #include "memory_allocations.h"
+#include "service_capabilities.h"
 
 
 
@@ -196,7 +197,7 @@ bool MatchServiceByNameOrAlias (ServiceMatcher *matcher_p, Service *service_p)
 				{
 					const char *service_s = GetServiceAlias (service_p);
 
-					if (strcmp (service_s, name_matcher_p -> nsm_service_alias_s) == 0)
+					if (service_s && (strcmp (service_s, name_matcher_p -> nsm_service_alias_s) == 0))
 						{
 							match_flag = true;
 						}
@@ -210,8 +211,9 @@ bool MatchServiceByNameOrAlias (ServiceMatcher *matcher_p, Service *service_p)
 bool MatchServiceByPluginName (ServiceMatcher *matcher_p, Service *service_p)
 {
 	PluginNameServiceMatcher *name_matcher_p = (PluginNameServiceMatcher *) matcher_p;	
-	
-	return (strcmp (service_p -> se_plugin_p -> pl_name_s, name_matcher_p -> pnsm_plugin_name_s) == 0);
+	const char *plugin_name_s = (service_p -> se_plugin_p) ? (service_p -> se_plugin_p -> pl_name_s) : NULL;
+
+	return (plugin_name_s && (strcmp (plugin_name_s, name_matcher_p -> pnsm_plugin_name_s) == 0));
 }
 
 
@@ -238,12 +240,18 @@ bool MatchServiceByResource (ServiceMatcher *matcher_p, Service *service_p)
 	
 	if ((resource_matcher_p -> rsm_resource_p) && (resource_matcher_p -> rsm_handler_p))
 		{
-			ParameterSet *params_p =  IsServiceMatch (service_p, resource_matcher_p -> rsm_resource_p, resource_matcher_p -> rsm_handler_p);
+			const ServiceCapabilities *capabilities_p = GetServiceCapabilities (service_p);
 
-			if (params_p)
+			/* There's no point asking a Service that can't check resources */
+			if ((!capabilities_p) || (capabilities_p -> sc_resource_match_flag))
 				{
-					ReleaseServiceParameters (service_p, params_p);
-					match_flag = true;
+					ParameterSet *params_p =  IsServiceMatch (service_p, resource_matcher_p -> rsm_resource_p, resource_matcher_p -> rsm_handler_p);
+
+					if (params_p)
+						{
+							ReleaseServiceParameters (service_p, params_p);
+							match_flag = true;
+						}
 				}
 		}
 		
@@ -253,35 +261,7 @@ bool MatchServiceByResource (ServiceMatcher *matcher_p, Service *service_p)
 
 bool MatchServiceByKeyword (ServiceMatcher *matcher_p, Service *service_p)
 {
-	bool match_flag = false;
-	KeywordServiceMatcher *keyword_matcher_p = (KeywordServiceMatcher *) matcher_p;
-
-	ParameterSet *params_p = GetServiceParameters (service_p, NULL, NULL);
-
-	if (params_p)
-		{
-			ParameterNode *param_node_p = (ParameterNode *) (params_p -> ps_params_p -> ll_head_p);
-
-			while (param_node_p)
-				{
-					Parameter *param_p = param_node_p -> pn_parameter_p;
-
-					if (param_p -> pa_type == PT_KEYWORD)
-						{
-							match_flag = true;
-							param_node_p = NULL;
-						}
-					else
-						{
-							param_node_p = (ParameterNode *) (param_node_p -> pn_node.ln_next_p);
-						}
-
-				}		/* while (param_node_p && (match_flag == false)) */
-
-			ReleaseServiceParameters (service_p, params_p);
-		}		/* if (params_p) */
-
-	return match_flag;
+	return IsKeywordService (service_p);
 }
 
 
@@ -0,0 +1,248 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * service_matcher_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the ServiceMatchers using stand-in Services that count how
+ *  often they are asked for their Parameters. Matching by name, alias or
+ *  plugin name must never need them, and keyword matching must need them
+ *  at most once per Service and not at all when the Service's description
+ *  is cached.
+ *
+ *  Usage: service_matcher_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jansson.h"
+
+#include "plugin.h"
+#include "schema_keys.h"
+#include "service_capabilities.h"
+#include "service_description_cache.h"
+#include "service_matcher.h"
+#include "string_parameter.h"
+#include "unit_test.h"
+
+
+#define NUM_MATCHES (10)
+
+
+typedef struct TestService
+{
+	Service ts_base;
+
+	ServiceData ts_data;
+
+	const char *ts_name_s;
+
+	bool ts_keyword_flag;
+
+	uint32 ts_num_params_calls;
+} TestService;
+
+
+static const char *GetTestServiceName (const Service *service_p)
+{
+	return ((const TestService *) service_p) -> ts_name_s;
+}
+
+
+static const char *GetTestServiceAlias (const Service * UNUSED_PARAM (service_p))
+{
+	return NULL;
+}
+
+
+static ParameterSet *GetTestServiceParameters (Service *service_p, DataResource * UNUSED_PARAM (resource_p), User * UNUSED_PARAM (user_p))
+{
+	TestService *test_service_p = (TestService *) service_p;
+	ParameterSet *params_p = AllocateParameterSet ("test parameters", NULL);
+
+	++ (test_service_p -> ts_num_params_calls);
+
+	if (params_p)
+		{
+			const ParameterType pt = (test_service_p -> ts_keyword_flag) ? PT_KEYWORD : PT_STRING;
+
+			if (!EasyCreateAndAddStringParameterToParameterSet (& (test_service_p -> ts_data), params_p, NULL, pt, "query", NULL, NULL, NULL, PL_ALL))
+				{
+					FreeParameterSet (params_p);
+					params_p = NULL;
+				}
+		}
+
+	return params_p;
+}
+
+
+static void ReleaseTestServiceParameters (Service * UNUSED_PARAM (service_p), ParameterSet *params_p)
+{
+	FreeParameterSet (params_p);
+}
+
+
+static void InitTestService (TestService *test_service_p, Plugin *plugin_p, const char *name_s, const bool keyword_flag, json_t *config_p)
+{
+	memset (test_service_p, 0, sizeof (TestService));
+
+	test_service_p -> ts_name_s = name_s;
+	test_service_p -> ts_keyword_flag = keyword_flag;
+
+	test_service_p -> ts_data.sd_service_p = & (test_service_p -> ts_base);
+	test_service_p -> ts_data.sd_config_p = config_p;
+
+	test_service_p -> ts_base.se_plugin_p = plugin_p;
+	test_service_p -> ts_base.se_data_p = & (test_service_p -> ts_data);
+	test_service_p -> ts_base.se_get_service_name_fn = GetTestServiceName;
+	test_service_p -> ts_base.se_get_service_alias_fn = GetTestServiceAlias;
+	test_service_p -> ts_base.se_get_params_fn = GetTestServiceParameters;
+	test_service_p -> ts_base.se_release_params_fn = ReleaseTestServiceParameters;
+}
+
+
+/*
+ * Run a ServiceMatcher NUM_MATCHES times and return whether it matched
+ * every time.
+ */
+static bool RunMatches (ServiceMatcher *matcher_p, TestService *test_service_p)
+{
+	bool match_flag = true;
+	int i;
+
+	for (i = 0; i < NUM_MATCHES; ++ i)
+		{
+			if (!RunServiceMatcher (matcher_p, & (test_service_p -> ts_base)))
+				{
+					match_flag = false;
+				}
+		}
+
+	return match_flag;
+}
+
+
+static void TestNameMatchers (TestService *services_p, const uint32 num_services)
+{
+	ServiceMatcher *name_matcher_p = AllocateOperationNameServiceMatcher ("keyword service", "no such alias");
+	ServiceMatcher *plugin_matcher_p = AllocatePluginNameServiceMatcher ("test plugin");
+	ServiceMatcher *plugin_op_matcher_p = AllocatePluginOperationNameServiceMatcher ("test plugin", "plain service");
+	uint32 i;
+
+	if (name_matcher_p && plugin_matcher_p && plugin_op_matcher_p)
+		{
+			bool calls_flag = true;
+
+			Check (RunMatches (name_matcher_p, services_p) && !RunServiceMatcher (name_matcher_p, & (services_p [1].ts_base)), "match by name or alias");
+			Check (RunMatches (plugin_matcher_p, services_p) && RunMatches (plugin_matcher_p, services_p + 1), "match by plugin name");
+			Check (RunMatches (plugin_op_matcher_p, services_p + 1) && !RunServiceMatcher (plugin_op_matcher_p, & (services_p [0].ts_base)), "match by plugin and service name");
+
+			for (i = 0; i < num_services; ++ i)
+				{
+					if (services_p [i].ts_num_params_calls != 0)
+						{
+							calls_flag = false;
+						}
+				}
+
+			Check (calls_flag, "match by name without getting the Parameters");
+		}
+	else
+		{
+			Check (false, "allocate the name ServiceMatchers");
+		}
+
+	if (name_matcher_p)
+		{
+			FreeServiceMatcher (name_matcher_p);
+		}
+
+	if (plugin_matcher_p)
+		{
+			FreeServiceMatcher (plugin_matcher_p);
+		}
+
+	if (plugin_op_matcher_p)
+		{
+			FreeServiceMatcher (plugin_op_matcher_p);
+		}
+}
+
+
+static void TestKeywordMatcher (TestService *services_p)
+{
+	ServiceMatcher *matcher_p = AllocateKeywordServiceMatcher ();
+
+	if (matcher_p)
+		{
+			Check (RunMatches (matcher_p, services_p) && (services_p [0].ts_num_params_calls == 1), "match a keyword Service, getting its Parameters once");
+			Check (!RunServiceMatcher (matcher_p, & (services_p [1].ts_base)) && !RunServiceMatcher (matcher_p, & (services_p [1].ts_base)) && (services_p [1].ts_num_params_calls == 1), "don't match a Service without a keyword Parameter");
+			Check (RunMatches (matcher_p, services_p + 2) && (services_p [2].ts_num_params_calls == 0), "match a keyword Service from its cached description");
+
+			FreeServiceMatcher (matcher_p);
+		}
+	else
+		{
+			Check (false, "allocate the keyword ServiceMatcher");
+		}
+}
+
+
+int main (void)
+{
+	json_t *config_p = json_pack ("{s:b}", SERVICE_CACHE_DESCRIPTION_S, 1);
+	json_t *description_p = json_pack ("{s:{s:{s:[{s:s,s:s}]}}}", SERVER_OPERATION_S, PARAM_SET_KEY_S, PARAM_SET_PARAMS_S, PARAM_NAME_S, "query", PARAM_GRASSROOTS_TYPE_INFO_TEXT_S, GetGrassrootsTypeAsString (PT_KEYWORD));
+	Plugin plugin;
+	TestService services [3];
+
+	memset (&plugin, 0, sizeof (plugin));
+	plugin.pl_name_s = (char *) "test plugin";
+
+	InitTestService (services, &plugin, "keyword service", true, NULL);
+	InitTestService (services + 1, &plugin, "plain service", false, NULL);
+
+	/* This Service says that it has no keyword Parameter but its cached description does */
+	InitTestService (services + 2, &plugin, "cached service", false, config_p);
+
+	if (config_p && description_p && CacheServiceDescription ("cached service", config_p, description_p))
+		{
+			TestNameMatchers (services, 3);
+			TestKeywordMatcher (services);
+
+			FreeServiceCapabilitiesIndex ();
+			FreeServiceDescriptions ();
+		}
+	else
+		{
+			Check (false, "cache the test description");
+		}
+
+	if (description_p)
+		{
+			json_decref (description_p);
+		}
+
+	if (config_p)
+		{
+			json_decref (config_p);
+		}
+
+	return GetTestResult ();
+}
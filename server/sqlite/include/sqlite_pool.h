@@ -0,0 +1,226 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * sqlite_pool.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SQLITE_POOL_H_
+#define SQLITE_POOL_H_
+
+#include <pthread.h>
+
+#include "typedefs.h"
+#include "jansson.h"
+#include "sqlite_library.h"
+#include "sqlite_tool.h"
+
+
+/**
+ * The default number of milliseconds that a pooled connection
+ * will keep retrying for when the database is locked before
+ * giving up with SQLITE_BUSY.
+ *
+ * @ingroup sqlite_group
+ */
+#define SQLITE_POOL_DEFAULT_BUSY_TIMEOUT_MS (5000)
+
+
+/**
+ * The counters that a SQLitePool keeps about how it
+ * has been used.
+ *
+ * @ingroup sqlite_group
+ */
+typedef struct SQLitePoolMetrics
+{
+	/** The number of reader connections that have been opened. */
+	uint64 sqpm_readers_opened;
+
+	/** The number of reader connections that have been closed. */
+	uint64 sqpm_readers_closed;
+
+	/** The number of times that a thread has asked for its reader connection. */
+	uint64 sqpm_read_acquisitions;
+
+	/** The number of times that the writer connection has been acquired. */
+	uint64 sqpm_write_acquisitions;
+
+	/**
+	 * The total number of microseconds that threads have spent waiting
+	 * to acquire the writer connection.
+	 */
+	uint64 sqpm_write_wait_us;
+
+	/** The longest time in microseconds that a thread waited for the writer connection. */
+	uint64 sqpm_max_write_wait_us;
+
+	/** The number of times that SQLite reported the database as busy and the call was retried. */
+	uint64 sqpm_busy_retries;
+
+	/** The number of times that the busy timeout expired and SQLITE_BUSY was returned. */
+	uint64 sqpm_busy_timeouts;
+} SQLitePoolMetrics;
+
+
+/**
+ * A SQLitePool gives threads shared access to a single SQLite
+ * database. The database is put into WAL mode so that any number of
+ * readers can run alongside a single writer. Each thread that asks for
+ * a reader is given its own read-only connection which is kept for
+ * the lifetime of that thread, whilst all writes are serialised through
+ * one read-write connection.
+ *
+ * @ingroup sqlite_group
+ */
+typedef struct SQLitePool
+{
+	/** @private The filename of the database. */
+	char *sqp_database_s;
+
+	/** @private The number of milliseconds to keep retrying on a locked database. */
+	uint32 sqp_busy_timeout_ms;
+
+	/** @private The single read-write connection. */
+	SQLiteTool *sqp_writer_p;
+
+	/** @private The lock used to serialise access to sqp_writer_p. */
+	pthread_mutex_t sqp_writer_mutex;
+
+	/** @private The key used to store each thread's reader connection. */
+	pthread_key_t sqp_reader_key;
+
+	/** @private The lock used to guard sqp_readers_pp and the metrics. */
+	pthread_mutex_t sqp_mutex;
+
+	/** @private All of the currently open reader connections. */
+	struct SQLitePoolReader **sqp_readers_pp;
+
+	/** @private The number of entries in sqp_readers_pp. */
+	uint32 sqp_num_readers;
+
+	/** @private The number of entries that sqp_readers_pp can hold. */
+	uint32 sqp_readers_capacity;
+
+	/** @private The usage counters. */
+	SQLitePoolMetrics sqp_metrics;
+} SQLitePool;
+
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Allocate a SQLitePool for a given database. If the database does not
+ * exist, it will be created and in either case it will be switched
+ * into WAL mode.
+ *
+ * @param db_s The filename of the database to use.
+ * @param busy_timeout_ms The number of milliseconds that a pooled connection
+ * will wait on a locked database before failing. If this is 0 then
+ * SQLITE_POOL_DEFAULT_BUSY_TIMEOUT_MS will be used.
+ * @return The newly-allocated SQLitePool or <code>NULL</code> upon error.
+ * @memberof SQLitePool
+ */
+GRASSROOTS_SQLITE_API SQLitePool *AllocateSQLitePool (const char *db_s, const uint32 busy_timeout_ms);
+
+
+/**
+ * Free a SQLitePool and close all of its connections. No thread
+ * may be using any of the pool's connections when this is called.
+ *
+ * @param pool_p The SQLitePool to free.
+ * @memberof SQLitePool
+ */
+GRASSROOTS_SQLITE_API void FreeSQLitePool (SQLitePool *pool_p);
+
+
+/**
+ * Get the read-only connection for the calling thread, opening it
+ * if this is the first time that this thread has asked for one.
+ * The connection belongs to the pool and must not be freed by the caller.
+ * It will be closed either when the thread exits or when the pool is freed.
+ *
+ * @param pool_p The SQLitePool to get the connection from.
+ * @return The SQLiteTool for the calling thread or <code>NULL</code> upon error.
+ * @memberof SQLitePool
+ */
+GRASSROOTS_SQLITE_API SQLiteTool *GetSQLitePoolReader (SQLitePool *pool_p);
+
+
+/**
+ * Get exclusive access to the pool's read-write connection. This will block
+ * until any other thread has called ReleaseSQLitePoolWriter().
+ *
+ * @param pool_p The SQLitePool to get the connection from.
+ * @return The SQLiteTool to write with or <code>NULL</code> upon error.
+ * @memberof SQLitePool
+ */
+GRASSROOTS_SQLITE_API SQLiteTool *AcquireSQLitePoolWriter (SQLitePool *pool_p);
+
+
+/**
+ * Give up exclusive access to the pool's read-write connection.
+ *
+ * @param pool_p The SQLitePool that the writer was acquired from.
+ * @param writer_p The SQLiteTool that was returned by AcquireSQLitePoolWriter().
+ * @return <code>true</code> if the writer was released successfully,
+ * <code>false</code> otherwise.
+ * @memberof SQLitePool
+ */
+GRASSROOTS_SQLITE_API bool ReleaseSQLitePoolWriter (SQLitePool *pool_p, SQLiteTool *writer_p);
+
+
+/**
+ * Get a snapshot of the usage counters for a SQLitePool.
+ *
+ * @param pool_p The SQLitePool to get the counters for.
+ * @param metrics_p The SQLitePoolMetrics where the values will be copied to.
+ * @return <code>true</code> if the metrics were copied successfully,
+ * <code>false</code> otherwise.
+ * @memberof SQLitePool
+ */
+GRASSROOTS_SQLITE_API bool GetSQLitePoolMetrics (SQLitePool *pool_p, SQLitePoolMetrics *metrics_p);
+
+
+/**
+ * Get the usage counters for a SQLitePool as JSON.
+ *
+ * @param pool_p The SQLitePool to get the counters for.
+ * @return The newly-allocated JSON object containing the counters or
+ * <code>NULL</code> upon error.
+ * @memberof SQLitePool
+ */
+GRASSROOTS_SQLITE_API json_t *GetSQLitePoolMetricsAsJSON (SQLitePool *pool_p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* SQLITE_POOL_H_ */
@@ -0,0 +1,551 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * sqlite_pool.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "sqlite_pool.h"
+#include "memory_allocations.h"
+#include "streams.h"
+#include "string_utils.h"
+
+
+#ifdef _DEBUG
+	#define SQLITE_POOL_DEBUG	(STM_LEVEL_FINER)
+#else
+	#define SQLITE_POOL_DEBUG	(STM_LEVEL_NONE)
+#endif
+
+
+/*
+ * Each reader connection is stored as thread-specific data so
+ * we need to know which pool it came from when the thread exits.
+ */
+typedef struct SQLitePoolReader
+{
+	SQLitePool *sqpr_pool_p;
+	SQLiteTool *sqpr_tool_p;
+} SQLitePoolReader;
+
+
+/*
+ * The pauses, in milliseconds, between retries on a busy database.
+ * These are the same as the ones that SQLite uses for its own
+ * default busy handler.
+ */
+static const uint32 S_BUSY_DELAYS_MS [] = { 1, 2, 5, 10, 15, 20, 25, 25, 25, 50, 50, 100 };
+
+static const size_t S_NUM_BUSY_DELAYS = sizeof (S_BUSY_DELAYS_MS) / sizeof (S_BUSY_DELAYS_MS [0]);
+
+
+static SQLiteTool *OpenPooledConnection (SQLitePool *pool_p, const int flags);
+
+static bool SetWALMode (SQLiteTool *tool_p);
+
+static int GetJournalModeCallback (void *data_p, int num_columns, char **values_ss, char **column_names_ss);
+
+static int PooledBusyHandler (void *data_p, int num_previous_calls);
+
+static bool AddReader (SQLitePool *pool_p, SQLitePoolReader *reader_p);
+
+static void RemoveReader (SQLitePool *pool_p, SQLitePoolReader *reader_p);
+
+static void FreeSQLitePoolReader (void *data_p);
+
+static uint64 GetElapsedMicroseconds (const struct timespec *start_p, const struct timespec *end_p);
+
+
+
+SQLitePool *AllocateSQLitePool (const char *db_s, const uint32 busy_timeout_ms)
+{
+	char *copied_db_s = EasyCopyToNewString (db_s);
+
+	if (copied_db_s)
+		{
+			SQLitePool *pool_p = (SQLitePool *) AllocMemory (sizeof (SQLitePool));
+
+			if (pool_p)
+				{
+					memset (pool_p, 0, sizeof (SQLitePool));
+
+					pool_p -> sqp_database_s = copied_db_s;
+					pool_p -> sqp_busy_timeout_ms = (busy_timeout_ms > 0) ? busy_timeout_ms : SQLITE_POOL_DEFAULT_BUSY_TIMEOUT_MS;
+
+					if (pthread_mutex_init (& (pool_p -> sqp_mutex), NULL) == 0)
+						{
+							if (pthread_mutex_init (& (pool_p -> sqp_writer_mutex), NULL) == 0)
+								{
+									if (pthread_key_create (& (pool_p -> sqp_reader_key), FreeSQLitePoolReader) == 0)
+										{
+											pool_p -> sqp_writer_p = OpenPooledConnection (pool_p, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX);
+
+											if (pool_p -> sqp_writer_p)
+												{
+													if (SetWALMode (pool_p -> sqp_writer_p))
+														{
+															return pool_p;
+														}
+													else
+														{
+															PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to set WAL mode for \"%s\"", db_s);
+														}
+
+													FreeSQLiteTool (pool_p -> sqp_writer_p);
+												}
+											else
+												{
+													PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to open writer connection for \"%s\"", db_s);
+												}
+
+											pthread_key_delete (pool_p -> sqp_reader_key);
+										}		/* if (pthread_key_create (& (pool_p -> sqp_reader_key), FreeSQLitePoolReader) == 0) */
+
+									pthread_mutex_destroy (& (pool_p -> sqp_writer_mutex));
+								}		/* if (pthread_mutex_init (& (pool_p -> sqp_writer_mutex), NULL) == 0) */
+
+							pthread_mutex_destroy (& (pool_p -> sqp_mutex));
+						}		/* if (pthread_mutex_init (& (pool_p -> sqp_mutex), NULL) == 0) */
+
+					FreeMemory (pool_p);
+				}		/* if (pool_p) */
+
+			FreeCopiedString (copied_db_s);
+		}		/* if (copied_db_s) */
+
+	return NULL;
+}
+
+
+void FreeSQLitePool (SQLitePool *pool_p)
+{
+	uint32 i;
+
+	/*
+	 * Once the key has been deleted, no thread-exit destructors
+	 * will be called so we can safely close the remaining readers.
+	 */
+	pthread_key_delete (pool_p -> sqp_reader_key);
+
+	for (i = 0; i < pool_p -> sqp_num_readers; ++ i)
+		{
+			SQLitePoolReader *reader_p = * ((pool_p -> sqp_readers_pp) + i);
+
+			FreeSQLiteTool (reader_p -> sqpr_tool_p);
+			FreeMemory (reader_p);
+		}
+
+	if (pool_p -> sqp_readers_pp)
+		{
+			FreeMemory (pool_p -> sqp_readers_pp);
+		}
+
+	if (pool_p -> sqp_writer_p)
+		{
+			FreeSQLiteTool (pool_p -> sqp_writer_p);
+		}
+
+	pthread_mutex_destroy (& (pool_p -> sqp_writer_mutex));
+	pthread_mutex_destroy (& (pool_p -> sqp_mutex));
+
+	FreeCopiedString (pool_p -> sqp_database_s);
+	FreeMemory (pool_p);
+}
+
+
+SQLiteTool *GetSQLitePoolReader (SQLitePool *pool_p)
+{
+	SQLitePoolReader *reader_p = (SQLitePoolReader *) pthread_getspecific (pool_p -> sqp_reader_key);
+
+	if (!reader_p)
+		{
+			reader_p = (SQLitePoolReader *) AllocMemory (sizeof (SQLitePoolReader));
+
+			if (reader_p)
+				{
+					reader_p -> sqpr_pool_p = pool_p;
+					reader_p -> sqpr_tool_p = OpenPooledConnection (pool_p, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX);
+
+					if (reader_p -> sqpr_tool_p)
+						{
+							if (AddReader (pool_p, reader_p))
+								{
+									if (pthread_setspecific (pool_p -> sqp_reader_key, reader_p) != 0)
+										{
+											PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to store reader connection for \"%s\"", pool_p -> sqp_database_s);
+
+											RemoveReader (pool_p, reader_p);
+											reader_p = NULL;
+										}
+								}
+							else
+								{
+									FreeSQLiteTool (reader_p -> sqpr_tool_p);
+									FreeMemory (reader_p);
+									reader_p = NULL;
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to open reader connection for \"%s\"", pool_p -> sqp_database_s);
+							FreeMemory (reader_p);
+							reader_p = NULL;
+						}
+
+				}		/* if (reader_p) */
+
+		}		/* if (!reader_p) */
+
+	if (reader_p)
+		{
+			if (pthread_mutex_lock (& (pool_p -> sqp_mutex)) == 0)
+				{
+					++ (pool_p -> sqp_metrics.sqpm_read_acquisitions);
+					pthread_mutex_unlock (& (pool_p -> sqp_mutex));
+				}
+
+			return reader_p -> sqpr_tool_p;
+		}
+
+	return NULL;
+}
+
+
+SQLiteTool *AcquireSQLitePoolWriter (SQLitePool *pool_p)
+{
+	struct timespec start;
+	struct timespec end;
+
+	clock_gettime (CLOCK_MONOTONIC, &start);
+
+	if (pthread_mutex_lock (& (pool_p -> sqp_writer_mutex)) == 0)
+		{
+			uint64 wait_us;
+
+			clock_gettime (CLOCK_MONOTONIC, &end);
+			wait_us = GetElapsedMicroseconds (&start, &end);
+
+			if (pthread_mutex_lock (& (pool_p -> sqp_mutex)) == 0)
+				{
+					SQLitePoolMetrics *metrics_p = & (pool_p -> sqp_metrics);
+
+					++ (metrics_p -> sqpm_write_acquisitions);
+					metrics_p -> sqpm_write_wait_us += wait_us;
+
+					if (wait_us > metrics_p -> sqpm_max_write_wait_us)
+						{
+							metrics_p -> sqpm_max_write_wait_us = wait_us;
+						}
+
+					pthread_mutex_unlock (& (pool_p -> sqp_mutex));
+				}
+
+			return pool_p -> sqp_writer_p;
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to lock writer connection for \"%s\"", pool_p -> sqp_database_s);
+		}
+
+	return NULL;
+}
+
+
+bool ReleaseSQLitePoolWriter (SQLitePool *pool_p, SQLiteTool *writer_p)
+{
+	bool success_flag = false;
+
+	if (writer_p == pool_p -> sqp_writer_p)
+		{
+			if (pthread_mutex_unlock (& (pool_p -> sqp_writer_mutex)) == 0)
+				{
+					success_flag = true;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to unlock writer connection for \"%s\"", pool_p -> sqp_database_s);
+				}
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "SQLiteTool %p is not the writer for pool \"%s\"", writer_p, pool_p -> sqp_database_s);
+		}
+
+	return success_flag;
+}
+
+
+bool GetSQLitePoolMetrics (SQLitePool *pool_p, SQLitePoolMetrics *metrics_p)
+{
+	bool success_flag = false;
+
+	if (pthread_mutex_lock (& (pool_p -> sqp_mutex)) == 0)
+		{
+			memcpy (metrics_p, & (pool_p -> sqp_metrics), sizeof (SQLitePoolMetrics));
+			pthread_mutex_unlock (& (pool_p -> sqp_mutex));
+
+			success_flag = true;
+		}
+
+	return success_flag;
+}
+
+
+json_t *GetSQLitePoolMetricsAsJSON (SQLitePool *pool_p)
+{
+	SQLitePoolMetrics metrics;
+
+	if (GetSQLitePoolMetrics (pool_p, &metrics))
+		{
+			json_t *metrics_json_p = json_pack ("{s:s,s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I}",
+				"database", pool_p -> sqp_database_s,
+				"readers_opened", (json_int_t) metrics.sqpm_readers_opened,
+				"readers_closed", (json_int_t) metrics.sqpm_readers_closed,
+				"read_acquisitions", (json_int_t) metrics.sqpm_read_acquisitions,
+				"write_acquisitions", (json_int_t) metrics.sqpm_write_acquisitions,
+				"write_wait_us", (json_int_t) metrics.sqpm_write_wait_us,
+				"max_write_wait_us", (json_int_t) metrics.sqpm_max_write_wait_us,
+				"busy_retries", (json_int_t) metrics.sqpm_busy_retries,
+				"busy_timeouts", (json_int_t) metrics.sqpm_busy_timeouts);
+
+			if (metrics_json_p)
+				{
+					return metrics_json_p;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create metrics JSON for \"%s\"", pool_p -> sqp_database_s);
+				}
+		}
+
+	return NULL;
+}
+
+
+
+static SQLiteTool *OpenPooledConnection (SQLitePool *pool_p, const int flags)
+{
+	SQLiteTool *tool_p = AllocateSQLiteTool (pool_p -> sqp_database_s, flags);
+
+	if (tool_p)
+		{
+			if (sqlite3_busy_handler (tool_p -> sqlt_database_p, PooledBusyHandler, pool_p) == SQLITE_OK)
+				{
+					return tool_p;
+				}
+
+			FreeSQLiteTool (tool_p);
+		}
+
+	return NULL;
+}
+
+
+static bool SetWALMode (SQLiteTool *tool_p)
+{
+	char mode_s [8];
+	char *error_s;
+
+	*mode_s = '\0';
+	error_s = RunSQLiteToolStatement (tool_p, "PRAGMA journal_mode=WAL;", GetJournalModeCallback, mode_s);
+
+	if (!error_s)
+		{
+			if (Stricmp (mode_s, "wal") == 0)
+				{
+					/*
+					 * With WAL, NORMAL is safe from corruption and avoids
+					 * an fsync on every commit.
+					 */
+					error_s = EasyRunSQLiteToolStatement (tool_p, "PRAGMA synchronous=NORMAL;");
+
+					if (!error_s)
+						{
+							return true;
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Journal mode is \"%s\" rather than \"wal\"", mode_s);
+				}
+		}
+
+	if (error_s)
+		{
+			FreeCopiedString (error_s);
+		}
+
+	return false;
+}
+
+
+static int GetJournalModeCallback (void *data_p, int num_columns, char **values_ss, char ** UNUSED_PARAM (column_names_ss))
+{
+	char *mode_s = (char *) data_p;
+
+	if ((num_columns > 0) && (*values_ss))
+		{
+			strncpy (mode_s, *values_ss, 7);
+			mode_s [7] = '\0';
+		}
+
+	return 0;
+}
+
+
+static int PooledBusyHandler (void *data_p, int num_previous_calls)
+{
+	SQLitePool *pool_p = (SQLitePool *) data_p;
+	uint32 total_ms = 0;
+	uint32 delay_ms;
+	int i;
+	int retry = 0;
+
+	/* Work out how long we have already waited */
+	for (i = 0; i < num_previous_calls; ++ i)
+		{
+			total_ms += S_BUSY_DELAYS_MS [((size_t) i < S_NUM_BUSY_DELAYS) ? (size_t) i : S_NUM_BUSY_DELAYS - 1];
+		}
+
+	delay_ms = S_BUSY_DELAYS_MS [((size_t) num_previous_calls < S_NUM_BUSY_DELAYS) ? (size_t) num_previous_calls : S_NUM_BUSY_DELAYS - 1];
+
+	if (total_ms < pool_p -> sqp_busy_timeout_ms)
+		{
+			if (total_ms + delay_ms > pool_p -> sqp_busy_timeout_ms)
+				{
+					delay_ms = pool_p -> sqp_busy_timeout_ms - total_ms;
+				}
+
+			retry = 1;
+		}
+
+	if (pthread_mutex_lock (& (pool_p -> sqp_mutex)) == 0)
+		{
+			if (retry)
+				{
+					++ (pool_p -> sqp_metrics.sqpm_busy_retries);
+				}
+			else
+				{
+					++ (pool_p -> sqp_metrics.sqpm_busy_timeouts);
+				}
+
+			pthread_mutex_unlock (& (pool_p -> sqp_mutex));
+		}
+
+	if (retry)
+		{
+			sqlite3_sleep ((int) delay_ms);
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "\"%s\" was still busy after " UINT32_FMT " ms", pool_p -> sqp_database_s, total_ms);
+		}
+
+	return retry;
+}
+
+
+static bool AddReader (SQLitePool *pool_p, SQLitePoolReader *reader_p)
+{
+	bool success_flag = false;
+
+	if (pthread_mutex_lock (& (pool_p -> sqp_mutex)) == 0)
+		{
+			if (pool_p -> sqp_num_readers == pool_p -> sqp_readers_capacity)
+				{
+					const uint32 new_capacity = (pool_p -> sqp_readers_capacity > 0) ? (pool_p -> sqp_readers_capacity << 1) : 8;
+					SQLitePoolReader **new_readers_pp = (SQLitePoolReader **) ReallocMemory (pool_p -> sqp_readers_pp, new_capacity * sizeof (SQLitePoolReader *), pool_p -> sqp_readers_capacity * sizeof (SQLitePoolReader *));
+
+					if (new_readers_pp)
+						{
+							pool_p -> sqp_readers_pp = new_readers_pp;
+							pool_p -> sqp_readers_capacity = new_capacity;
+						}
+				}
+
+			if (pool_p -> sqp_num_readers < pool_p -> sqp_readers_capacity)
+				{
+					* ((pool_p -> sqp_readers_pp) + (pool_p -> sqp_num_readers)) = reader_p;
+					++ (pool_p -> sqp_num_readers);
+					++ (pool_p -> sqp_metrics.sqpm_readers_opened);
+
+					success_flag = true;
+				}
+
+			pthread_mutex_unlock (& (pool_p -> sqp_mutex));
+		}
+
+	return success_flag;
+}
+
+
+static void RemoveReader (SQLitePool *pool_p, SQLitePoolReader *reader_p)
+{
+	if (pthread_mutex_lock (& (pool_p -> sqp_mutex)) == 0)
+		{
+			uint32 i;
+
+			for (i = 0; i < pool_p -> sqp_num_readers; ++ i)
+				{
+					if (* ((pool_p -> sqp_readers_pp) + i) == reader_p)
+						{
+							-- (pool_p -> sqp_num_readers);
+
+							/* Move the last entry into the vacated slot */
+							* ((pool_p -> sqp_readers_pp) + i) = * ((pool_p -> sqp_readers_pp) + (pool_p -> sqp_num_readers));
+							++ (pool_p -> sqp_metrics.sqpm_readers_closed);
+
+							i = pool_p -> sqp_num_readers;
+						}
+				}
+
+			pthread_mutex_unlock (& (pool_p -> sqp_mutex));
+		}
+
+	FreeSQLiteTool (reader_p -> sqpr_tool_p);
+	FreeMemory (reader_p);
+}
+
+
+/*
+ * This is called when a thread that has a reader connection exits.
+ */
+static void FreeSQLitePoolReader (void *data_p)
+{
+	SQLitePoolReader *reader_p = (SQLitePoolReader *) data_p;
+
+	#if SQLITE_POOL_DEBUG >= STM_LEVEL_FINER
+	PrintLog (STM_LEVEL_FINER, __FILE__, __LINE__, "Closing reader connection for \"%s\"", reader_p -> sqpr_pool_p -> sqp_database_s);
+	#endif
+
+	RemoveReader (reader_p -> sqpr_pool_p, reader_p);
+}
+
+
+static uint64 GetElapsedMicroseconds (const struct timespec *start_p, const struct timespec *end_p)
+{
+	int64 us = ((int64) (end_p -> tv_sec - start_p -> tv_sec)) * 1000000;
+
+	us += (end_p -> tv_nsec - start_p -> tv_nsec) / 1000;
+
+	return (us > 0) ? (uint64) us : 0;
+}
@@ -0,0 +1,251 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * sqlite_pool_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Stress test for SQLitePool. A number of threads hammer a temporary
+ *  database with a mix of reads and writes and the test checks that
+ *  none of them fail and that every write is visible at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "sqlite_pool.h"
+#include "string_utils.h"
+
+
+typedef struct TestThreadData
+{
+	SQLitePool *ttd_pool_p;
+	int ttd_id;
+	int ttd_num_iterations;
+	int ttd_write_every;
+	int ttd_num_failures;
+	int ttd_num_writes;
+} TestThreadData;
+
+
+static void *RunTestThread (void *data_p);
+
+static int64 CountRows (SQLiteTool *tool_p);
+
+
+
+int main (int argc, char *argv [])
+{
+	int num_threads = 32;
+	int num_iterations = 500;
+	int write_every = 10;
+	char db_s [] = "/tmp/sqlite_pool_test_XXXXXX";
+	int fd;
+	int ret = 1;
+
+	if (argc > 1)
+		{
+			num_threads = atoi (argv [1]);
+		}
+
+	if (argc > 2)
+		{
+			num_iterations = atoi (argv [2]);
+		}
+
+	if (argc > 3)
+		{
+			write_every = atoi (argv [3]);
+		}
+
+	fd = mkstemp (db_s);
+
+	if (fd != -1)
+		{
+			SQLitePool *pool_p;
+
+			close (fd);
+
+			pool_p = AllocateSQLitePool (db_s, 0);
+
+			if (pool_p)
+				{
+					SQLiteTool *writer_p = AcquireSQLitePoolWriter (pool_p);
+					char *error_s = EasyRunSQLiteToolStatement (writer_p, "CREATE TABLE test (id INTEGER PRIMARY KEY, thread INTEGER, value TEXT);");
+
+					ReleaseSQLitePoolWriter (pool_p, writer_p);
+
+					if (!error_s)
+						{
+							TestThreadData *data_p = (TestThreadData *) calloc (num_threads, sizeof (TestThreadData));
+							pthread_t *threads_p = (pthread_t *) calloc (num_threads, sizeof (pthread_t));
+
+							if (data_p && threads_p)
+								{
+									int i;
+									int num_failures = 0;
+									int64 num_writes = 0;
+									int64 num_rows;
+									SQLitePoolMetrics metrics;
+
+									for (i = 0; i < num_threads; ++ i)
+										{
+											(data_p + i) -> ttd_pool_p = pool_p;
+											(data_p + i) -> ttd_id = i;
+											(data_p + i) -> ttd_num_iterations = num_iterations;
+											(data_p + i) -> ttd_write_every = write_every;
+
+											pthread_create (threads_p + i, NULL, RunTestThread, data_p + i);
+										}
+
+									for (i = 0; i < num_threads; ++ i)
+										{
+											pthread_join (* (threads_p + i), NULL);
+
+											num_failures += (data_p + i) -> ttd_num_failures;
+											num_writes += (data_p + i) -> ttd_num_writes;
+										}
+
+									writer_p = AcquireSQLitePoolWriter (pool_p);
+									num_rows = CountRows (writer_p);
+									ReleaseSQLitePoolWriter (pool_p, writer_p);
+
+									GetSQLitePoolMetrics (pool_p, &metrics);
+
+									printf ("threads: %d, iterations: %d, failures: %d\n", num_threads, num_iterations, num_failures);
+									printf ("writes: " INT64_FMT ", rows: " INT64_FMT "\n", num_writes, num_rows);
+									printf ("readers opened: " INT64_FMT ", closed: " INT64_FMT "\n", (int64) metrics.sqpm_readers_opened, (int64) metrics.sqpm_readers_closed);
+									printf ("read acquisitions: " INT64_FMT ", write acquisitions: " INT64_FMT "\n", (int64) metrics.sqpm_read_acquisitions, (int64) metrics.sqpm_write_acquisitions);
+									printf ("write wait total: " INT64_FMT " us, max: " INT64_FMT " us\n", (int64) metrics.sqpm_write_wait_us, (int64) metrics.sqpm_max_write_wait_us);
+									printf ("busy retries: " INT64_FMT ", busy timeouts: " INT64_FMT "\n", (int64) metrics.sqpm_busy_retries, (int64) metrics.sqpm_busy_timeouts);
+
+									if ((num_failures == 0) && (num_rows == num_writes) && (metrics.sqpm_readers_closed == metrics.sqpm_readers_opened))
+										{
+											puts ("PASSED");
+											ret = 0;
+										}
+									else
+										{
+											puts ("FAILED");
+										}
+								}
+
+							if (threads_p)
+								{
+									free (threads_p);
+								}
+
+							if (data_p)
+								{
+									free (data_p);
+								}
+						}
+					else
+						{
+							printf ("Failed to create table: \"%s\"\n", error_s);
+							FreeCopiedString (error_s);
+						}
+
+					FreeSQLitePool (pool_p);
+				}
+			else
+				{
+					printf ("Failed to allocate pool for \"%s\"\n", db_s);
+				}
+
+			unlink (db_s);
+		}
+	else
+		{
+			puts ("Failed to create temporary database file");
+		}
+
+	return ret;
+}
+
+
+static void *RunTestThread (void *data_p)
+{
+	TestThreadData *thread_data_p = (TestThreadData *) data_p;
+	int i;
+
+	for (i = 0; i < thread_data_p -> ttd_num_iterations; ++ i)
+		{
+			if ((thread_data_p -> ttd_write_every > 0) && ((i % thread_data_p -> ttd_write_every) == 0))
+				{
+					SQLiteTool *writer_p = AcquireSQLitePoolWriter (thread_data_p -> ttd_pool_p);
+
+					if (writer_p)
+						{
+							char sql_s [128];
+							char *error_s;
+
+							sprintf (sql_s, "INSERT INTO test (thread, value) VALUES (%d, 'row %d');", thread_data_p -> ttd_id, i);
+							error_s = EasyRunSQLiteToolStatement (writer_p, sql_s);
+
+							if (error_s)
+								{
+									++ (thread_data_p -> ttd_num_failures);
+									FreeCopiedString (error_s);
+								}
+							else
+								{
+									++ (thread_data_p -> ttd_num_writes);
+								}
+
+							ReleaseSQLitePoolWriter (thread_data_p -> ttd_pool_p, writer_p);
+						}
+					else
+						{
+							++ (thread_data_p -> ttd_num_failures);
+						}
+				}
+			else
+				{
+					SQLiteTool *reader_p = GetSQLitePoolReader (thread_data_p -> ttd_pool_p);
+
+					if (! (reader_p && (CountRows (reader_p) >= 0)))
+						{
+							++ (thread_data_p -> ttd_num_failures);
+						}
+				}
+		}
+
+	return NULL;
+}
+
+
+static int64 CountRows (SQLiteTool *tool_p)
+{
+	int64 count = -1;
+	sqlite3_stmt *statement_p = NULL;
+
+	if (PrepareStatement (tool_p, &statement_p, "SELECT COUNT(*) FROM test;"))
+		{
+			if (sqlite3_step (statement_p) == SQLITE_ROW)
+				{
+					count = sqlite3_column_int64 (statement_p, 0);
+				}
+
+			sqlite3_finalize (statement_p);
+		}
+
+	return count;
+}
@@ -35,6 +35,8 @@
 #include "string_utils.h"
 #include "key_value_pair.h"
 #include "sqlite_column.h"
+#include "metrics.h"
+#include "tracing.h"
 
 
 static int ConvertSQLiteRowToJSON (void *data_p, int num_columns, char **values_ss, char **column_names_ss);
@@ -48,6 +50,8 @@ static bool AddJSONObjectToByteBuffer (ByteBuffer *buffer_p, json_t *value_p);
 
 static bool DoInsert (json_t *value_p, const char * const table_s, const char * const primary_key_s, ByteBuffer *buffer_p);
 
+static void RecordSQLiteMetric (const SQLiteTool *tool_p, const char *op_s, const uint64 start_time, const bool success_flag);
+
 
 #ifdef _DEBUG
 	#define SQLITE_TOOL_DEBUG	(STM_LEVEL_FINER)
@@ -232,9 +236,12 @@ json_t *FindMatchingSQLiteDocuments (SQLiteTool *tool_p, LinkedList *where_claus
 						{
 							char *error_s = NULL;
 							const char *sql_s = GetByteBufferData (buffer_p);
+							const uint64 start_time = GetMetricsTime ();
 
 							int res = sqlite3_exec (tool_p -> sqlt_database_p, sql_s, ConvertSQLiteRowToJSON, results_p, &error_s);
 
+							RecordSQLiteMetric (tool_p, "select", start_time, res == SQLITE_OK);
+
 							if (res == SQLITE_OK)
 								{
 									return results_p;
@@ -461,8 +468,11 @@ char *RunSQLiteToolStatement (SQLiteTool *tool_p, const char *sql_s, int (*callb
 {
 	char *error_s = NULL;
 	char *sql_error_s = NULL;
+	const uint64 start_time = GetMetricsTime ();
 	int res = sqlite3_exec (tool_p -> sqlt_database_p, sql_s, callback_fn, data_p, &sql_error_s);
 
+	RecordSQLiteMetric (tool_p, "exec", start_time, res == SQLITE_OK);
+
 	if (res != SQLITE_OK)
 		{
 			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "SQLite exec returned %d for \"%s\": error \"%s\"", res, sql_s, sql_error_s);
@@ -995,3 +1005,24 @@ static int ConvertSQLiteRowToJSON (void *data_p, int num_columns, char **values_
 
 	return res;
 }
+
+
+/*
+ * Record the time taken by a statement on the current table
+ * under a label such as "fields.select".
+ */
+static void RecordSQLiteMetric (const SQLiteTool *tool_p, const char *op_s, const uint64 start_time, const bool success_flag)
+{
+	char label_s [METRICS_LABEL_SIZE];
+
+	snprintf (label_s, sizeof (label_s), "%s.%s", (tool_p -> sqlt_table_s) ? (tool_p -> sqlt_table_s) : "", op_s);
+	RecordMetric (METRICS_SQLITE_S, label_s, start_time, success_flag);
+
+	if (IsTracingEnabled ())
+		{
+			char span_name_s [SPAN_NAME_SIZE];
+
+			snprintf (span_name_s, sizeof (span_name_s), "sqlite %s", label_s);
+			RecordCompletedSpan (span_name_s, SK_CLIENT, start_time, success_flag);
+		}
+}
@@ -15,6 +15,8 @@
 #include "memory_allocations.h"
 #include "event_consumer.h"
 #include "operation.h"
+#include "streams.h"
+#include "tracing.h"
 
 struct AsyncTasksManager;
 
@@ -64,6 +66,18 @@ typedef struct AsyncTask
 	 */
 	struct AsyncTasksManager *at_manager_p;
 
+	/**
+	 * The correlation id of the request that started this AsyncTask,
+	 * which the AsyncTask's thread uses for its log messages.
+	 */
+	char at_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE];
+
+	/**
+	 * The traceparent value of the request that started this AsyncTask,
+	 * so that any Spans on the AsyncTask's thread are part of its trace.
+	 */
+	char at_trace_parent_s [TRACE_PARENT_BUFFER_SIZE];
+
 } AsyncTask;
 
 
@@ -248,6 +262,53 @@ GRASSROOTS_TASK_API	void FreeAsyncTaskNode (ListItem *node_p);
 GRASSROOTS_TASK_API void SetAsyncTaskConsumer (AsyncTask *task_p, EventConsumer *consumer_p, MEM_FLAG mem);
 
 
+/**
+ * Set the correlation id that an AsyncTask will use for its log messages.
+ *
+ * RunAsyncTask calls this with the correlation id of the calling thread
+ * so the task's messages are tied to the request that started it.
+ *
+ * @param task_p The AsyncTask to adjust.
+ * @param id_s The correlation id or <code>NULL</code> to clear it.
+ * @memberof AsyncTask
+ * @see SetLogCorrelationId
+ */
+GRASSROOTS_TASK_API void SetAsyncTaskCorrelationId (AsyncTask *task_p, const char * const id_s);
+
+
+/**
+ * Get the correlation id that an AsyncTask uses for its log messages.
+ *
+ * @param task_p The AsyncTask to query.
+ * @return The correlation id or <code>NULL</code> if it doesn't have one.
+ * @memberof AsyncTask
+ */
+GRASSROOTS_TASK_API const char *GetAsyncTaskCorrelationId (const AsyncTask *task_p);
+
+
+/**
+ * Store the calling thread's current trace context in an AsyncTask.
+ *
+ * RunAsyncTask calls this so that the task's thread carries on the
+ * trace of the request that started it.
+ *
+ * @param task_p The AsyncTask to adjust.
+ * @memberof AsyncTask
+ * @see GetTraceParent
+ */
+GRASSROOTS_TASK_API void SetAsyncTaskTraceParent (AsyncTask *task_p);
+
+
+/**
+ * Get the traceparent value that an AsyncTask uses for its Spans.
+ *
+ * @param task_p The AsyncTask to query.
+ * @return The traceparent value or <code>NULL</code> if it doesn't have one.
+ * @memberof AsyncTask
+ */
+GRASSROOTS_TASK_API const char *GetAsyncTaskTraceParent (const AsyncTask *task_p);
+
+
 /**
  * Run the EventConsumer for the given AsyncTask.
  *
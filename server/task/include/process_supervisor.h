@@ -0,0 +1,257 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * process_supervisor.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * The ProcessSupervisor runs external programs without going through
+ * system (). Each program is started with posix_spawn () and its stdout
+ * and stderr are captured into fixed-size ring buffers that keep the
+ * most recent output. A single background thread watches every child's
+ * pipes and exit using epoll, so there is no thread blocked per child.
+ * Callers can either block in WaitForSupervisedProcess () or be called
+ * back by that thread when a child finishes. Children can be given a
+ * timeout, be cancelled and have resource limits applied to them.
+ *
+ * This is currently only available on Linux.
+ */
+
+#ifndef PROCESS_SUPERVISOR_H_
+#define PROCESS_SUPERVISOR_H_
+
+#include "grassroots_task_library.h"
+#include "typedefs.h"
+#include "operation.h"
+
+
+/**
+ * The default number of bytes kept from each of a SupervisedProcess's
+ * stdout and stderr.
+ *
+ * @ingroup task_group
+ */
+#define PROCESS_SUPERVISOR_DEFAULT_OUTPUT_BUFFER_SIZE (16384)
+
+
+/**
+ * The number of milliseconds that a SupervisedProcess is given to exit
+ * after being sent SIGTERM before it is sent SIGKILL.
+ *
+ * @ingroup task_group
+ */
+#define PROCESS_SUPERVISOR_KILL_GRACE_PERIOD_MS (5000)
+
+
+/**
+ * The limits to apply to a SupervisedProcess. Any value of 0
+ * means that the corresponding limit is not applied.
+ *
+ * @ingroup task_group
+ */
+typedef struct ProcessLimits
+{
+	/**
+	 * The number of milliseconds that the process may run for before
+	 * it is stopped.
+	 */
+	uint32 pl_timeout_ms;
+
+	/** The maximum number of seconds of CPU time, set as RLIMIT_CPU. */
+	uint32 pl_max_cpu_time_s;
+
+	/** The maximum number of open file descriptors, set as RLIMIT_NOFILE. */
+	uint32 pl_max_open_files;
+
+	/** The maximum size in bytes of the address space, set as RLIMIT_AS. */
+	uint64 pl_max_memory;
+
+	/** The maximum size in bytes of any file written, set as RLIMIT_FSIZE. */
+	uint64 pl_max_file_size;
+
+	/**
+	 * If this is not <code>NULL</code>, the process will be moved into
+	 * the cgroup at this path, e.g. "/sys/fs/cgroup/grassroots/blast",
+	 * which must already exist and be writable.
+	 */
+	const char *pl_cgroup_path_s;
+} ProcessLimits;
+
+
+/**
+ * The datatype for a program started by the ProcessSupervisor.
+ *
+ * @ingroup task_group
+ */
+typedef struct SupervisedProcess SupervisedProcess;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Start the ProcessSupervisor's background thread. This is called
+ * automatically by SpawnSupervisedProcess () if needed.
+ *
+ * @return <code>true</code> if the ProcessSupervisor was started successfully
+ * or was already running, <code>false</code> upon error.
+ * @ingroup task_group
+ */
+GRASSROOTS_TASK_API bool StartProcessSupervisor (void);
+
+
+/**
+ * Stop the ProcessSupervisor. Any children that are still running
+ * will be killed and reaped before this returns.
+ *
+ * @ingroup task_group
+ */
+GRASSROOTS_TASK_API void StopProcessSupervisor (void);
+
+
+/**
+ * Start running a program.
+ *
+ * The command line is split into arguments on whitespace, with double
+ * quotes grouping words, and run directly. If it contains any shell
+ * syntax such as redirections, pipes or variables, it is run with
+ * "/bin/sh -c" instead.
+ *
+ * @param command_line_s The command line to run.
+ * @param limits_p The limits to apply to the process. This can be <code>NULL</code>.
+ * @param output_buffer_size The number of bytes to keep from each of stdout
+ * and stderr. If this is 0, PROCESS_SUPERVISOR_DEFAULT_OUTPUT_BUFFER_SIZE will
+ * be used.
+ * @return The newly-started SupervisedProcess or <code>NULL</code> upon error.
+ * This must be freed with FreeSupervisedProcess ().
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API SupervisedProcess *SpawnSupervisedProcess (const char *command_line_s, const ProcessLimits *limits_p, const size_t output_buffer_size);
+
+
+/**
+ * Start running a program and have a function called when it finishes,
+ * rather than having a thread wait for it.
+ *
+ * The function is called on the ProcessSupervisor's thread once the
+ * process has finished, including if it is killed by StopProcessSupervisor (),
+ * so it must not block for long since no other children are watched
+ * whilst it runs. It may call any of the SupervisedProcess functions,
+ * including FreeSupervisedProcess (), but the process must not be freed
+ * anywhere else before the function has been called.
+ *
+ * @param command_line_s The command line to run, as for SpawnSupervisedProcess ().
+ * @param limits_p The limits to apply to the process. This can be <code>NULL</code>.
+ * @param output_buffer_size The number of bytes to keep from each of stdout
+ * and stderr. If this is 0, PROCESS_SUPERVISOR_DEFAULT_OUTPUT_BUFFER_SIZE will
+ * be used.
+ * @param on_exit_fn The function to call with the finished process, its final
+ * status and exit code as given by WaitForSupervisedProcess () and data_p.
+ * @param data_p The custom data to pass to on_exit_fn.
+ * @return The newly-started SupervisedProcess or <code>NULL</code> upon error,
+ * in which case on_exit_fn will not be called.
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API SupervisedProcess *SpawnSupervisedProcessWithCallback (const char *command_line_s, const ProcessLimits *limits_p, const size_t output_buffer_size,
+	void (*on_exit_fn) (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p), void *data_p);
+
+
+/**
+ * Free a SupervisedProcess. If the process is still running, it will
+ * be cancelled and waited for first.
+ *
+ * @param process_p The SupervisedProcess to free.
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API void FreeSupervisedProcess (SupervisedProcess *process_p);
+
+
+/**
+ * Get the current status of a SupervisedProcess.
+ *
+ * @param process_p The SupervisedProcess to check.
+ * @return OS_STARTED if the process is still running, OS_SUCCEEDED if it
+ * exited with 0 and OS_FAILED otherwise, including if it timed out or
+ * was cancelled.
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API OperationStatus GetSupervisedProcessStatus (SupervisedProcess *process_p);
+
+
+/**
+ * Block until a SupervisedProcess has finished.
+ *
+ * @param process_p The SupervisedProcess to wait for.
+ * @param exit_code_p If this is not <code>NULL</code>, the process's exit code
+ * will be stored here. If the process was killed by a signal, this will be set
+ * to -1.
+ * @return The final status of the process as given by GetSupervisedProcessStatus ().
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API OperationStatus WaitForSupervisedProcess (SupervisedProcess *process_p, int *exit_code_p);
+
+
+/**
+ * Cancel a SupervisedProcess. The process will be sent SIGTERM and then,
+ * if it hasn't exited after PROCESS_SUPERVISOR_KILL_GRACE_PERIOD_MS,
+ * SIGKILL. This does not wait for the process to finish.
+ *
+ * @param process_p The SupervisedProcess to cancel.
+ * @return <code>true</code> if the process was still running and has been
+ * signalled, <code>false</code> if it had already finished.
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API bool CancelSupervisedProcess (SupervisedProcess *process_p);
+
+
+/**
+ * Check whether a SupervisedProcess was stopped because it
+ * ran for longer than its timeout.
+ *
+ * @param process_p The SupervisedProcess to check.
+ * @return <code>true</code> if the process timed out, <code>false</code> otherwise.
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API bool HasSupervisedProcessTimedOut (SupervisedProcess *process_p);
+
+
+/**
+ * Get the most recent output that a SupervisedProcess has written.
+ *
+ * @param process_p The SupervisedProcess to get the output from.
+ * @param stderr_flag If this is <code>true</code> then the process's stderr will
+ * be returned, otherwise its stdout will be.
+ * @return A newly-allocated copy of the output, which must be freed with
+ * FreeCopiedString (), or <code>NULL</code> upon error.
+ * @memberof SupervisedProcess
+ */
+GRASSROOTS_TASK_API char *GetSupervisedProcessOutput (SupervisedProcess *process_p, const bool stderr_flag);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROCESS_SUPERVISOR_H_ */
@@ -35,6 +35,7 @@
 #include "jobs_manager.h"
 #include "async_task.h"
 #include "memory_allocations.h"
+#include "process_supervisor.h"
 
 
 /**
@@ -69,6 +70,30 @@ typedef struct SystemAsyncTask
 	 * be ignored.
 	 */
 	void (*std_on_success_callback_fn) (ServiceJob *job_p);
+
+	/**
+	 * The limits to apply to the command line when it is run.
+	 * By default, no limits are applied.
+	 */
+	ProcessLimits std_limits;
+
+	/**
+	 * The most recent output that the command line wrote to stdout,
+	 * available once it has finished running. This may be <code>NULL</code>.
+	 */
+	char *std_stdout_s;
+
+	/**
+	 * The most recent output that the command line wrote to stderr,
+	 * available once it has finished running. This may be <code>NULL</code>.
+	 */
+	char *std_stderr_s;
+
+	/** The running process, if the platform supports supervising it. */
+	SupervisedProcess *std_process_p;
+
+	/** Has CancelSystemAsyncTask () been called? */
+	bool std_cancelled_flag;
 } SystemAsyncTask;
 
 
@@ -114,6 +139,46 @@ GRASSROOTS_TASK_API	SystemAsyncTask *AllocateSystemAsyncTask (ServiceJob *job_p,
 GRASSROOTS_TASK_API bool SetSystemAsyncTaskCommand (SystemAsyncTask *task_p, const char *command_s);
 
 
+/**
+ * Set the limits to apply when a SystemAsyncTask's command line is run.
+ * This must be called before RunSystemAsyncTask ().
+ *
+ * @param task_p The SystemAsyncTask to alter.
+ * @param limits_p The limits to use. These are copied apart from pl_cgroup_path_s,
+ * which must remain valid until the SystemAsyncTask has finished. If this is
+ * <code>NULL</code>, then any existing limits are removed.
+ * @memberof SystemAsyncTask
+ */
+GRASSROOTS_TASK_API void SetSystemAsyncTaskLimits (SystemAsyncTask *task_p, const ProcessLimits *limits_p);
+
+
+/**
+ * Get the most recent output that a SystemAsyncTask's command line
+ * wrote. This is only available once the SystemAsyncTask has finished
+ * and only on platforms that support process supervision.
+ *
+ * @param task_p The SystemAsyncTask to query.
+ * @param stderr_flag If this is <code>true</code> then the output to stderr will
+ * be returned, otherwise the output to stdout will be.
+ * @return The output or <code>NULL</code> if it isn't available.
+ * @memberof SystemAsyncTask
+ */
+GRASSROOTS_TASK_API const char *GetSystemAsyncTaskOutput (const SystemAsyncTask *task_p, const bool stderr_flag);
+
+
+/**
+ * Stop a running SystemAsyncTask's command line. The SystemAsyncTask
+ * will then finish with a status of OS_FAILED.
+ *
+ * @param task_p The SystemAsyncTask to cancel.
+ * @return <code>true</code> if the SystemAsyncTask was cancelled,
+ * <code>false</code> if it had already finished or cancellation isn't
+ * supported on this platform.
+ * @memberof SystemAsyncTask
+ */
+GRASSROOTS_TASK_API bool CancelSystemAsyncTask (SystemAsyncTask *task_p);
+
+
 /**
  * Free a SystemAsyncTask.
  *
@@ -126,6 +191,10 @@ GRASSROOTS_TASK_API	void FreeSystemAsyncTask (SystemAsyncTask *task_p);
 /**
  * Run a SystemAsyncTask.
  *
+ * This returns once the command line has been started. When it finishes,
+ * the ServiceJob's status is set to OS_SUCCEEDED if the command line exited
+ * with 0, OS_FAILED if it was cancelled or timed out and OS_ERROR otherwise.
+ *
  * @param task_p The SystemAsyncTask to run.
  * @return <code>true</code> if the ServiceJob was started successfully,
  * <code>false</code> otherwise.
@@ -149,8 +218,55 @@ GRASSROOTS_TASK_LOCAL void RunSystemAsyncTaskSuccess (SystemAsyncTask *task_p, S
 
 
 
+/**
+ * Run a SystemAsyncTask's command line and wait for it to finish. This is
+ * implemented for each platform.
+ *
+ * @param task_p The SystemAsyncTask to run.
+ * @return The status of the finished command line.
+ * @memberof SystemAsyncTask
+ */
 GRASSROOTS_TASK_LOCAL OperationStatus ActualRunSystemAsyncTask (SystemAsyncTask *task_p);
 
+
+/**
+ * Start a SystemAsyncTask's command line and arrange for
+ * FinishSystemAsyncTask () to be called when it has finished. This is
+ * implemented for each platform, either by watching the process or by
+ * calling RunBlockingSystemAsyncTask ().
+ *
+ * @param task_p The SystemAsyncTask to start.
+ * @return <code>true</code> if the command line was started or was
+ * cancelled before it could be, <code>false</code> otherwise.
+ * @memberof SystemAsyncTask
+ */
+GRASSROOTS_TASK_LOCAL bool ActualStartSystemAsyncTask (SystemAsyncTask *task_p);
+
+
+/**
+ * Run ActualRunSystemAsyncTask () and then FinishSystemAsyncTask () in
+ * the SystemAsyncTask's AsyncTask, for platforms that can only wait for
+ * a command line by blocking a thread.
+ *
+ * @param task_p The SystemAsyncTask to run.
+ * @return <code>true</code> if the AsyncTask was started successfully,
+ * <code>false</code> otherwise.
+ * @memberof SystemAsyncTask
+ */
+GRASSROOTS_TASK_LOCAL bool RunBlockingSystemAsyncTask (SystemAsyncTask *task_p);
+
+
+/**
+ * Update a SystemAsyncTask's ServiceJob once its command line has finished,
+ * running its on-success callback if appropriate and storing the ServiceJob
+ * in the JobsManager.
+ *
+ * @param task_p The finished SystemAsyncTask.
+ * @param status The status of the command line.
+ * @memberof SystemAsyncTask
+ */
+GRASSROOTS_TASK_LOCAL void FinishSystemAsyncTask (SystemAsyncTask *task_p, const OperationStatus status);
+
 #ifdef __cplusplus
 }
 #endif
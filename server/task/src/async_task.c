@@ -128,6 +128,41 @@ void SetAsyncTaskConsumer (AsyncTask *task_p, EventConsumer *consumer_p, MEM_FLA
 }
 
 
+void SetAsyncTaskCorrelationId (AsyncTask *task_p, const char * const id_s)
+{
+	if (id_s)
+		{
+			strncpy (task_p -> at_correlation_id_s, id_s, LOG_CORRELATION_ID_BUFFER_SIZE - 1);
+			task_p -> at_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE - 1] = '\0';
+		}
+	else
+		{
+			* (task_p -> at_correlation_id_s) = '\0';
+		}
+}
+
+
+const char *GetAsyncTaskCorrelationId (const AsyncTask *task_p)
+{
+	return (* (task_p -> at_correlation_id_s) != '\0') ? task_p -> at_correlation_id_s : NULL;
+}
+
+
+void SetAsyncTaskTraceParent (AsyncTask *task_p)
+{
+	if (!GetTraceParent (task_p -> at_trace_parent_s))
+		{
+			* (task_p -> at_trace_parent_s) = '\0';
+		}
+}
+
+
+const char *GetAsyncTaskTraceParent (const AsyncTask *task_p)
+{
+	return (* (task_p -> at_trace_parent_s) != '\0') ? task_p -> at_trace_parent_s : NULL;
+}
+
+
 
 AsyncTaskNode *AllocateAsyncTaskNode (AsyncTask *task_p, MEM_FLAG mem)
 {
@@ -33,6 +33,7 @@
 
 #include "async_task.h"
 #include "async_tasks_manager.h"
+#include "process_supervisor.h"
 #include "memory_allocations.h"
 #include "string_utils.h"
 
@@ -51,6 +52,18 @@ typedef struct UnixAsyncTask
 
 static void *DoAsyncTaskRun (void *data_p);
 
+static void LogProcessResult (const char *command_line_s, SupervisedProcess *process_p, const OperationStatus status, const int exit_code, const char *stderr_s);
+
+static void OnSystemAsyncTaskExit (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p);
+
+static OperationStatus StoreSystemAsyncTaskResult (SystemAsyncTask *task_p, SupervisedProcess *process_p, OperationStatus status, const int exit_code);
+
+static OperationStatus GetUnstartedSystemAsyncTaskStatus (SystemAsyncTask *task_p);
+
+
+/* Guards each SystemAsyncTask's std_process_p against being cancelled as it finishes */
+static pthread_mutex_t s_system_tasks_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 #ifdef _DEBUG
 	#define UNIX_ASYNC_TASK_DEBUG	(STM_LEVEL_FINEST)
@@ -154,7 +167,13 @@ bool RunAsyncTask (AsyncTask *task_p)
 {
 	bool success_flag = true;
 	UnixAsyncTask *unix_task_p = (UnixAsyncTask *) task_p;
-	int res = pthread_create (& (unix_task_p -> uat_thread), & (unix_task_p -> uat_attributes), DoAsyncTaskRun, task_p);
+	int res;
+
+	/* The task's thread logs under the id of the request that started it */
+	SetAsyncTaskCorrelationId (task_p, GetLogCorrelationId ());
+	SetAsyncTaskTraceParent (task_p);
+
+	res = pthread_create (& (unix_task_p -> uat_thread), & (unix_task_p -> uat_attributes), DoAsyncTaskRun, task_p);
 
 	if (res == 0)
 		{
@@ -173,62 +192,225 @@ bool RunAsyncTask (AsyncTask *task_p)
 
 OperationStatus ActualRunSystemAsyncTask (SystemAsyncTask *task_p)
 {
-	OperationStatus status = OS_STARTED;
-	int res = system (task_p -> std_command_line_s);
+	OperationStatus status = OS_FAILED_TO_START;
+	SupervisedProcess *process_p = NULL;
 
-	if (res != -1)
+	pthread_mutex_lock (&s_system_tasks_mutex);
+
+	if (!task_p -> std_cancelled_flag)
 		{
-			int process_exit_code = WEXITSTATUS (res);
+			process_p = SpawnSupervisedProcess (task_p -> std_command_line_s, & (task_p -> std_limits), 0);
+			task_p -> std_process_p = process_p;
+		}
 
-			if (process_exit_code == 0)
-				{
-					status = OS_SUCCEEDED;
-					PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "\"%s\" ran successfully", task_p -> std_command_line_s);
-				}
-			else
-				{
-					status = OS_ERROR;
-					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "\"%s\" failed with return code %d", task_p -> std_command_line_s, process_exit_code);
-				}
+	pthread_mutex_unlock (&s_system_tasks_mutex);
+
+	if (process_p)
+		{
+			int exit_code;
+
+			status = WaitForSupervisedProcess (process_p, &exit_code);
+			status = StoreSystemAsyncTaskResult (task_p, process_p, status, exit_code);
 		}
 	else
 		{
-			status = OS_ERROR;
-			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed running \"%s\" with return code %d", task_p -> std_command_line_s, res);
+			status = GetUnstartedSystemAsyncTaskStatus (task_p);
 		}
 
 	return status;
 }
 
 
-OperationStatus RunProcess (const char * const command_line_s)
+bool ActualStartSystemAsyncTask (SystemAsyncTask *task_p)
 {
-	OperationStatus status = OS_FAILED;
-	int res = system (command_line_s);
+	bool success_flag = true;
+	SupervisedProcess *process_p = NULL;
+	AsyncTask *async_task_p = task_p -> std_async_task_p;
+
+	/* The supervisor thread logs the result under the id of the request that started it */
+	SetAsyncTaskCorrelationId (async_task_p, GetLogCorrelationId ());
+	SetAsyncTaskTraceParent (async_task_p);
+
+	pthread_mutex_lock (&s_system_tasks_mutex);
+
+	if (!task_p -> std_cancelled_flag)
+		{
+			process_p = SpawnSupervisedProcessWithCallback (task_p -> std_command_line_s, & (task_p -> std_limits), 0, OnSystemAsyncTaskExit, task_p);
+			task_p -> std_process_p = process_p;
+		}
+
+	pthread_mutex_unlock (&s_system_tasks_mutex);
+
+	if (!process_p)
+		{
+			const OperationStatus status = GetUnstartedSystemAsyncTaskStatus (task_p);
+
+			success_flag = (status != OS_FAILED_TO_START);
+			FinishSystemAsyncTask (task_p, status);
+		}
+
+	return success_flag;
+}
 
-	if (res != -1)
+
+bool CancelSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	bool cancelled_flag = false;
+
+	pthread_mutex_lock (&s_system_tasks_mutex);
+
+	if (!task_p -> std_cancelled_flag)
 		{
-			int process_exit_code = WEXITSTATUS (res);
+			task_p -> std_cancelled_flag = true;
 
-			if (process_exit_code == 0)
+			if (task_p -> std_process_p)
 				{
-					status = OS_SUCCEEDED;
-					PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "\"%s\" ran successfully", command_line_s);
+					cancelled_flag = CancelSupervisedProcess (task_p -> std_process_p);
 				}
 			else
 				{
-					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "\"%s\" failed with return code %d", command_line_s, process_exit_code);
+					/* It hasn't started yet, so it never will */
+					cancelled_flag = true;
 				}
 		}
+
+	pthread_mutex_unlock (&s_system_tasks_mutex);
+
+	return cancelled_flag;
+}
+
+
+OperationStatus RunProcess (const char * const command_line_s)
+{
+	OperationStatus status = OS_FAILED;
+	SupervisedProcess *process_p = SpawnSupervisedProcess (command_line_s, NULL, 0);
+
+	if (process_p)
+		{
+			int exit_code;
+			char *stderr_s;
+
+			status = WaitForSupervisedProcess (process_p, &exit_code);
+			stderr_s = GetSupervisedProcessOutput (process_p, true);
+
+			LogProcessResult (command_line_s, process_p, status, exit_code, stderr_s);
+
+			if (stderr_s)
+				{
+					FreeCopiedString (stderr_s);
+				}
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to start \"%s\"", command_line_s);
+		}
+
+	return status;
+}
+
+
+/*
+ * Called on the process supervisor's thread, without any threads
+ * waiting for the process, once a SystemAsyncTask's command line has
+ * finished.
+ */
+static void OnSystemAsyncTaskExit (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p)
+{
+	SystemAsyncTask *task_p = (SystemAsyncTask *) data_p;
+	AsyncTask *async_task_p = task_p -> std_async_task_p;
+	OperationStatus task_status;
+
+	SetLogCorrelationId (GetAsyncTaskCorrelationId (async_task_p));
+	SetTraceParent (GetAsyncTaskTraceParent (async_task_p));
+
+	task_status = StoreSystemAsyncTaskResult (task_p, process_p, status, exit_code);
+
+	FinishSystemAsyncTask (task_p, task_status);
+
+	if (async_task_p -> at_consumer_p)
+		{
+			RunEventConsumerFromAsyncTask (async_task_p);
+		}
+}
+
+
+/*
+ * Keep the output of a SystemAsyncTask's finished command line and free
+ * its process. A non-zero exit gives OS_ERROR as it did when the command
+ * line was run with system (), leaving OS_FAILED for command lines that
+ * were cancelled or timed out.
+ */
+static OperationStatus StoreSystemAsyncTaskResult (SystemAsyncTask *task_p, SupervisedProcess *process_p, OperationStatus status, const int exit_code)
+{
+	pthread_mutex_lock (&s_system_tasks_mutex);
+
+	task_p -> std_process_p = NULL;
+
+	if ((status == OS_FAILED) && (!task_p -> std_cancelled_flag) && (!HasSupervisedProcessTimedOut (process_p)))
+		{
+			status = OS_ERROR;
+		}
+
+	pthread_mutex_unlock (&s_system_tasks_mutex);
+
+	if (task_p -> std_stdout_s)
+		{
+			FreeCopiedString (task_p -> std_stdout_s);
+		}
+
+	if (task_p -> std_stderr_s)
+		{
+			FreeCopiedString (task_p -> std_stderr_s);
+		}
+
+	task_p -> std_stdout_s = GetSupervisedProcessOutput (process_p, false);
+	task_p -> std_stderr_s = GetSupervisedProcessOutput (process_p, true);
+
+	LogProcessResult (task_p -> std_command_line_s, process_p, status, exit_code, task_p -> std_stderr_s);
+
+	FreeSupervisedProcess (process_p);
+
+	return status;
+}
+
+
+static OperationStatus GetUnstartedSystemAsyncTaskStatus (SystemAsyncTask *task_p)
+{
+	OperationStatus status = OS_FAILED_TO_START;
+
+	if (task_p -> std_cancelled_flag)
+		{
+			status = OS_FAILED;
+			PrintLog (STM_LEVEL_INFO, __FILE__, __LINE__, "\"%s\" was cancelled before it started", task_p -> std_command_line_s);
+		}
 	else
 		{
-			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed running \"%s\" with return code %d", command_line_s, res);
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to start \"%s\"", task_p -> std_command_line_s);
 		}
 
 	return status;
 }
 
 
+static void LogProcessResult (const char *command_line_s, SupervisedProcess *process_p, const OperationStatus status, const int exit_code, const char *stderr_s)
+{
+	if (status == OS_SUCCEEDED)
+		{
+			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "\"%s\" ran successfully", command_line_s);
+		}
+	else if (HasSupervisedProcessTimedOut (process_p))
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "\"%s\" timed out, stderr: \"%s\"", command_line_s, stderr_s ? stderr_s : "");
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "\"%s\" failed with return code %d, stderr: \"%s\"", command_line_s, exit_code, stderr_s ? stderr_s : "");
+		}
+}
+
+
 
 static void *DoAsyncTaskRun (void *data_p)
 {
@@ -239,6 +421,9 @@ static void *DoAsyncTaskRun (void *data_p)
 	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "DoAsyncTaskRun about to run for \"%s\" at %.16X", async_task_p -> at_name_s, async_task_p);
 	#endif
 
+	SetLogCorrelationId (GetAsyncTaskCorrelationId (async_task_p));
+	SetTraceParent (GetAsyncTaskTraceParent (async_task_p));
+
 	res_p = async_task_p -> at_run_fn (async_task_p -> at_data_p);
 
 	#if UNIX_ASYNC_TASK_DEBUG >= STM_LEVEL_FINEST
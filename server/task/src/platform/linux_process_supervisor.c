@@ -0,0 +1,1296 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * linux_process_supervisor.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Children are watched through pidfds rather than a SIGCHLD signalfd.
+ *  A signalfd only works if SIGCHLD is blocked in every thread of the
+ *  process, which we can't guarantee when running inside httpd, and
+ *  reaping with waitpid (-1) would steal the exit statuses of children
+ *  that aren't ours. If pidfd_open () isn't available, those children
+ *  are checked with waitpid (pid, WNOHANG) on a short interval instead.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "process_supervisor.h"
+#include "memory_allocations.h"
+#include "string_utils.h"
+#include "streams.h"
+#include "linked_list.h"
+#include "string_linked_list.h"
+
+
+#ifdef _DEBUG
+	#define PROCESS_SUPERVISOR_DEBUG	(STM_LEVEL_FINE)
+#else
+	#define PROCESS_SUPERVISOR_DEBUG	(STM_LEVEL_NONE)
+#endif
+
+
+/** The maximum number of epoll events handled per wakeup */
+#define S_MAX_EVENTS (64)
+
+/** How often children without a pidfd are checked, in milliseconds */
+#define S_FALLBACK_POLL_INTERVAL_MS (100)
+
+/** The size of the buffer used when reading a child's output */
+#define S_READ_BUFFER_SIZE (4096)
+
+
+/**
+ * The characters that mean that a command line needs to be
+ * run by a shell rather than being split into arguments. Quotes
+ * and tabs are included since the command line is only split
+ * on spaces.
+ */
+static const char * const S_SHELL_CHARACTERS_S = "|&;<>()$`\\'\"*?[]#~{}\t\n";
+
+
+extern char **environ;
+
+
+typedef enum ProcessWatchType
+{
+	PWT_STDOUT,
+	PWT_STDERR,
+	PWT_EXIT,
+	PWT_NUM_TYPES
+} ProcessWatchType;
+
+
+typedef struct ProcessWatch
+{
+	struct SupervisedProcess *pw_process_p;
+	ProcessWatchType pw_type;
+} ProcessWatch;
+
+
+typedef struct RingBuffer
+{
+	char *rb_data_p;
+	size_t rb_size;
+	size_t rb_start;
+	size_t rb_length;
+} RingBuffer;
+
+
+struct SupervisedProcess
+{
+	/* This must be first so that the SupervisedProcess can be in s_processes */
+	ListItem sp_node;
+
+	char *sp_command_line_s;
+	pid_t sp_pid;
+
+	/* The descriptors being watched, or -1 once they have been closed */
+	int sp_fds [PWT_NUM_TYPES];
+	ProcessWatch sp_watches [PWT_NUM_TYPES];
+
+	RingBuffer sp_stdout_buffer;
+	RingBuffer sp_stderr_buffer;
+
+	/* Times are in milliseconds from CLOCK_MONOTONIC and are 0 if not set */
+	uint64 sp_deadline_ms;
+	uint64 sp_kill_time_ms;
+
+	/* Called on the supervisor thread once the child has finished, if set */
+	void (*sp_on_exit_fn) (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p);
+	void *sp_on_exit_data_p;
+
+	int sp_wait_status;
+	bool sp_exited_flag;
+	bool sp_finished_flag;
+	bool sp_timed_out_flag;
+	bool sp_cancelled_flag;
+};
+
+
+static pthread_mutex_t s_supervisor_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_supervisor_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_supervisor_thread;
+
+static bool s_running_flag = false;
+static bool s_stop_flag = false;
+
+static int s_epoll_fd = -1;
+
+/* Used to wake the supervisor thread when a child is added or signalled */
+static int s_wake_fd = -1;
+
+/* The children that haven't finished yet */
+static LinkedList s_processes;
+
+/* The finished children whose exit callbacks haven't been called yet */
+static LinkedList s_finished_processes;
+
+
+static void *RunProcessSupervisor (void *data_p);
+
+static SupervisedProcess *SpawnProcess (const char *command_line_s, const ProcessLimits *limits_p, const size_t output_buffer_size,
+	void (*on_exit_fn) (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p), void *data_p);
+
+static void RunExitCallbacks (void);
+
+static bool DoesCommandLineNeedShell (const char *command_line_s);
+
+static char **GetProcessArguments (const char *command_line_s);
+
+static void FreeProcessArguments (char **args_ss);
+
+static bool ApplyProcessLimits (const pid_t pid, const ProcessLimits *limits_p);
+
+static bool SetProcessLimit (const pid_t pid, const int resource, const uint64 value);
+
+static bool AddProcessToCgroup (const pid_t pid, const char *cgroup_path_s);
+
+static bool WatchProcess (SupervisedProcess *process_p);
+
+static void CloseProcessFd (SupervisedProcess *process_p, const ProcessWatchType watch_type);
+
+static void ReadProcessOutput (SupervisedProcess *process_p, const ProcessWatchType watch_type);
+
+static bool ReapProcess (SupervisedProcess *process_p, const int options);
+
+static void FinishProcess (SupervisedProcess *process_p);
+
+static int CheckProcesses (const uint64 now_ms);
+
+static void SignalProcess (SupervisedProcess *process_p, const int signal_number);
+
+static void WakeProcessSupervisor (void);
+
+static uint64 GetCurrentTimeInMillis (void);
+
+static bool InitRingBuffer (RingBuffer *buffer_p, const size_t size);
+
+static void ClearRingBuffer (RingBuffer *buffer_p);
+
+static void WriteToRingBuffer (RingBuffer *buffer_p, const char *data_p, size_t length);
+
+static char *GetRingBufferContents (const RingBuffer *buffer_p);
+
+
+/*
+ * API FUNCTIONS
+ */
+
+
+bool StartProcessSupervisor (void)
+{
+	bool success_flag = false;
+
+	pthread_mutex_lock (&s_supervisor_mutex);
+
+	if (s_running_flag)
+		{
+			success_flag = true;
+		}
+	else
+		{
+			s_epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+
+			if (s_epoll_fd != -1)
+				{
+					s_wake_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+					if (s_wake_fd != -1)
+						{
+							struct epoll_event event;
+
+							memset (&event, 0, sizeof (event));
+							event.events = EPOLLIN;
+							event.data.ptr = NULL;
+
+							if (epoll_ctl (s_epoll_fd, EPOLL_CTL_ADD, s_wake_fd, &event) == 0)
+								{
+									int res;
+
+									InitLinkedList (&s_processes);
+									InitLinkedList (&s_finished_processes);
+									s_stop_flag = false;
+
+									res = pthread_create (&s_supervisor_thread, NULL, RunProcessSupervisor, NULL);
+
+									if (res == 0)
+										{
+											s_running_flag = true;
+											success_flag = true;
+										}
+									else
+										{
+											PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to start process supervisor thread, error %d", res);
+										}
+								}
+							else
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add wake descriptor to epoll, %s", strerror (errno));
+								}
+
+							if (!success_flag)
+								{
+									close (s_wake_fd);
+									s_wake_fd = -1;
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create eventfd, %s", strerror (errno));
+						}
+
+					if (!success_flag)
+						{
+							close (s_epoll_fd);
+							s_epoll_fd = -1;
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create epoll descriptor, %s", strerror (errno));
+				}
+		}
+
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	return success_flag;
+}
+
+
+void StopProcessSupervisor (void)
+{
+	bool join_flag = false;
+
+	pthread_mutex_lock (&s_supervisor_mutex);
+
+	if (s_running_flag && !s_stop_flag)
+		{
+			s_stop_flag = true;
+			join_flag = true;
+			WakeProcessSupervisor ();
+		}
+
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	if (join_flag)
+		{
+			ListItem *node_p;
+
+			pthread_join (s_supervisor_thread, NULL);
+
+			pthread_mutex_lock (&s_supervisor_mutex);
+
+			/* Kill off any remaining children */
+			while ((node_p = LinkedListRemHead (&s_processes)) != NULL)
+				{
+					SupervisedProcess *process_p = (SupervisedProcess *) node_p;
+
+					if (!process_p -> sp_exited_flag)
+						{
+							process_p -> sp_cancelled_flag = true;
+							SignalProcess (process_p, SIGKILL);
+							ReapProcess (process_p, 0);
+						}
+
+					/* It's no longer in s_processes so FinishProcess () mustn't remove it */
+					InitListItem (node_p);
+					FinishProcess (process_p);
+				}
+
+			close (s_wake_fd);
+			s_wake_fd = -1;
+
+			close (s_epoll_fd);
+			s_epoll_fd = -1;
+
+			s_running_flag = false;
+			s_stop_flag = false;
+
+			pthread_cond_broadcast (&s_supervisor_cond);
+
+			pthread_mutex_unlock (&s_supervisor_mutex);
+
+			RunExitCallbacks ();
+		}
+}
+
+
+SupervisedProcess *SpawnSupervisedProcess (const char *command_line_s, const ProcessLimits *limits_p, const size_t output_buffer_size)
+{
+	return SpawnProcess (command_line_s, limits_p, output_buffer_size, NULL, NULL);
+}
+
+
+SupervisedProcess *SpawnSupervisedProcessWithCallback (const char *command_line_s, const ProcessLimits *limits_p, const size_t output_buffer_size,
+	void (*on_exit_fn) (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p), void *data_p)
+{
+	return SpawnProcess (command_line_s, limits_p, output_buffer_size, on_exit_fn, data_p);
+}
+
+
+void FreeSupervisedProcess (SupervisedProcess *process_p)
+{
+	int i;
+
+	if (!process_p -> sp_finished_flag)
+		{
+			CancelSupervisedProcess (process_p);
+			WaitForSupervisedProcess (process_p, NULL);
+		}
+
+	for (i = 0; i < PWT_NUM_TYPES; ++ i)
+		{
+			if (process_p -> sp_fds [i] != -1)
+				{
+					close (process_p -> sp_fds [i]);
+				}
+		}
+
+	ClearRingBuffer (& (process_p -> sp_stdout_buffer));
+	ClearRingBuffer (& (process_p -> sp_stderr_buffer));
+
+	if (process_p -> sp_command_line_s)
+		{
+			FreeCopiedString (process_p -> sp_command_line_s);
+		}
+
+	FreeMemory (process_p);
+}
+
+
+OperationStatus GetSupervisedProcessStatus (SupervisedProcess *process_p)
+{
+	OperationStatus status = OS_STARTED;
+
+	pthread_mutex_lock (&s_supervisor_mutex);
+
+	if (process_p -> sp_finished_flag)
+		{
+			if ((process_p -> sp_exited_flag) && (!process_p -> sp_timed_out_flag) && (!process_p -> sp_cancelled_flag) &&
+					(WIFEXITED (process_p -> sp_wait_status)) && (WEXITSTATUS (process_p -> sp_wait_status) == 0))
+				{
+					status = OS_SUCCEEDED;
+				}
+			else
+				{
+					status = OS_FAILED;
+				}
+		}
+
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	return status;
+}
+
+
+OperationStatus WaitForSupervisedProcess (SupervisedProcess *process_p, int *exit_code_p)
+{
+	pthread_mutex_lock (&s_supervisor_mutex);
+
+	while (!process_p -> sp_finished_flag)
+		{
+			pthread_cond_wait (&s_supervisor_cond, &s_supervisor_mutex);
+		}
+
+	if (exit_code_p)
+		{
+			if ((process_p -> sp_exited_flag) && (WIFEXITED (process_p -> sp_wait_status)))
+				{
+					*exit_code_p = WEXITSTATUS (process_p -> sp_wait_status);
+				}
+			else
+				{
+					*exit_code_p = -1;
+				}
+		}
+
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	return GetSupervisedProcessStatus (process_p);
+}
+
+
+bool CancelSupervisedProcess (SupervisedProcess *process_p)
+{
+	bool cancelled_flag = false;
+
+	pthread_mutex_lock (&s_supervisor_mutex);
+
+	if (!process_p -> sp_exited_flag)
+		{
+			process_p -> sp_cancelled_flag = true;
+
+			if (process_p -> sp_kill_time_ms == 0)
+				{
+					SignalProcess (process_p, SIGTERM);
+					process_p -> sp_kill_time_ms = GetCurrentTimeInMillis () + PROCESS_SUPERVISOR_KILL_GRACE_PERIOD_MS;
+					WakeProcessSupervisor ();
+				}
+
+			cancelled_flag = true;
+		}
+
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	return cancelled_flag;
+}
+
+
+bool HasSupervisedProcessTimedOut (SupervisedProcess *process_p)
+{
+	bool timed_out_flag;
+
+	pthread_mutex_lock (&s_supervisor_mutex);
+	timed_out_flag = process_p -> sp_timed_out_flag;
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	return timed_out_flag;
+}
+
+
+char *GetSupervisedProcessOutput (SupervisedProcess *process_p, const bool stderr_flag)
+{
+	char *output_s;
+
+	pthread_mutex_lock (&s_supervisor_mutex);
+	output_s = GetRingBufferContents (stderr_flag ? & (process_p -> sp_stderr_buffer) : & (process_p -> sp_stdout_buffer));
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	return output_s;
+}
+
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+
+static SupervisedProcess *SpawnProcess (const char *command_line_s, const ProcessLimits *limits_p, const size_t output_buffer_size,
+	void (*on_exit_fn) (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p), void *data_p)
+{
+	const size_t buffer_size = (output_buffer_size > 0) ? output_buffer_size : PROCESS_SUPERVISOR_DEFAULT_OUTPUT_BUFFER_SIZE;
+	SupervisedProcess *process_p = NULL;
+	char **args_ss;
+
+	if (!StartProcessSupervisor ())
+		{
+			return NULL;
+		}
+
+	args_ss = GetProcessArguments (command_line_s);
+
+	if (args_ss)
+		{
+			process_p = (SupervisedProcess *) AllocMemory (sizeof (SupervisedProcess));
+
+			if (process_p)
+				{
+					int i;
+
+					memset (process_p, 0, sizeof (SupervisedProcess));
+					InitListItem (& (process_p -> sp_node));
+
+					process_p -> sp_on_exit_fn = on_exit_fn;
+					process_p -> sp_on_exit_data_p = data_p;
+
+					for (i = 0; i < PWT_NUM_TYPES; ++ i)
+						{
+							process_p -> sp_fds [i] = -1;
+							process_p -> sp_watches [i].pw_process_p = process_p;
+							process_p -> sp_watches [i].pw_type = (ProcessWatchType) i;
+						}
+
+					process_p -> sp_command_line_s = EasyCopyToNewString (command_line_s);
+
+					if ((process_p -> sp_command_line_s) && InitRingBuffer (& (process_p -> sp_stdout_buffer), buffer_size) && InitRingBuffer (& (process_p -> sp_stderr_buffer), buffer_size))
+						{
+							int stdout_fds [2];
+
+							if (pipe2 (stdout_fds, O_CLOEXEC) == 0)
+								{
+									int stderr_fds [2];
+
+									if (pipe2 (stderr_fds, O_CLOEXEC) == 0)
+										{
+											posix_spawn_file_actions_t actions;
+											posix_spawnattr_t attributes;
+											sigset_t signals;
+											int res;
+
+											posix_spawn_file_actions_init (&actions);
+											posix_spawn_file_actions_addopen (&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+											posix_spawn_file_actions_adddup2 (&actions, stdout_fds [1], STDOUT_FILENO);
+											posix_spawn_file_actions_adddup2 (&actions, stderr_fds [1], STDERR_FILENO);
+
+											/*
+											 * Put the child in its own process group so that cancelling it
+											 * also stops anything that it has started, and don't let it
+											 * inherit our signal mask or handlers.
+											 */
+											posix_spawnattr_init (&attributes);
+											posix_spawnattr_setpgroup (&attributes, 0);
+
+											sigemptyset (&signals);
+											posix_spawnattr_setsigmask (&attributes, &signals);
+
+											sigfillset (&signals);
+											posix_spawnattr_setsigdefault (&attributes, &signals);
+
+											posix_spawnattr_setflags (&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+											res = posix_spawnp (& (process_p -> sp_pid), *args_ss, &actions, &attributes, args_ss, environ);
+
+											posix_spawnattr_destroy (&attributes);
+											posix_spawn_file_actions_destroy (&actions);
+
+											close (stdout_fds [1]);
+											close (stderr_fds [1]);
+
+											process_p -> sp_fds [PWT_STDOUT] = stdout_fds [0];
+											process_p -> sp_fds [PWT_STDERR] = stderr_fds [0];
+
+											if (res == 0)
+												{
+													#if PROCESS_SUPERVISOR_DEBUG >= STM_LEVEL_FINE
+													PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Spawned %d for \"%s\"", process_p -> sp_pid, command_line_s);
+													#endif
+
+													/*
+													 * posix_spawn () can't set resource limits, so they are applied
+													 * straight after the child has started.
+													 */
+													if (ApplyProcessLimits (process_p -> sp_pid, limits_p))
+														{
+															if ((limits_p != NULL) && (limits_p -> pl_timeout_ms > 0))
+																{
+																	process_p -> sp_deadline_ms = GetCurrentTimeInMillis () + limits_p -> pl_timeout_ms;
+																}
+
+															if (WatchProcess (process_p))
+																{
+																	FreeProcessArguments (args_ss);
+
+																	return process_p;
+																}
+														}
+
+													/* Don't leave the child running unsupervised */
+													kill (- (process_p -> sp_pid), SIGKILL);
+													ReapProcess (process_p, 0);
+												}
+											else
+												{
+													PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to spawn \"%s\", %s", command_line_s, strerror (res));
+												}
+
+										}		/* if (pipe2 (stderr_fds, O_CLOEXEC) == 0) */
+									else
+										{
+											PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create stderr pipe for \"%s\", %s", command_line_s, strerror (errno));
+											close (stdout_fds [0]);
+											close (stdout_fds [1]);
+										}
+
+								}		/* if (pipe2 (stdout_fds, O_CLOEXEC) == 0) */
+							else
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create stdout pipe for \"%s\", %s", command_line_s, strerror (errno));
+								}
+						}
+
+					process_p -> sp_finished_flag = true;
+					FreeSupervisedProcess (process_p);
+					process_p = NULL;
+				}		/* if (process_p) */
+
+			FreeProcessArguments (args_ss);
+		}		/* if (args_ss) */
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to get arguments from \"%s\"", command_line_s);
+		}
+
+	return process_p;
+}
+
+
+static void *RunProcessSupervisor (void * UNUSED_PARAM (data_p))
+{
+	struct epoll_event events [S_MAX_EVENTS];
+	int timeout_ms = -1;
+	bool loop_flag = true;
+
+	while (loop_flag)
+		{
+			int num_events = epoll_wait (s_epoll_fd, events, S_MAX_EVENTS, timeout_ms);
+
+			pthread_mutex_lock (&s_supervisor_mutex);
+
+			if (num_events > 0)
+				{
+					int i;
+
+					for (i = 0; i < num_events; ++ i)
+						{
+							ProcessWatch *watch_p = (ProcessWatch *) (events [i].data.ptr);
+
+							if (watch_p)
+								{
+									if (watch_p -> pw_type == PWT_EXIT)
+										{
+											ReapProcess (watch_p -> pw_process_p, WNOHANG);
+										}
+									else
+										{
+											ReadProcessOutput (watch_p -> pw_process_p, watch_p -> pw_type);
+										}
+								}
+							else
+								{
+									uint64 value;
+
+									/* Just clear the wakeup, we recheck everything below anyway */
+									if (read (s_wake_fd, &value, sizeof (value)) < 0)
+										{
+											#if PROCESS_SUPERVISOR_DEBUG >= STM_LEVEL_FINE
+											PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Failed to read from wake descriptor, %s", strerror (errno));
+											#endif
+										}
+								}
+						}
+				}
+			else if ((num_events == -1) && (errno != EINTR))
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "epoll_wait failed in process supervisor, %s", strerror (errno));
+				}
+
+			if (s_stop_flag)
+				{
+					loop_flag = false;
+				}
+			else
+				{
+					timeout_ms = CheckProcesses (GetCurrentTimeInMillis ());
+				}
+
+			pthread_mutex_unlock (&s_supervisor_mutex);
+
+			RunExitCallbacks ();
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Go through the children, enforcing their deadlines and finishing any
+ * that have exited. This returns the timeout for the next epoll_wait ().
+ */
+static int CheckProcesses (const uint64 now_ms)
+{
+	uint64 next_event_ms = 0;
+	bool poll_flag = false;
+	ListItem *node_p = s_processes.ll_head_p;
+
+	while (node_p)
+		{
+			SupervisedProcess *process_p = (SupervisedProcess *) node_p;
+
+			/* FinishProcess () removes the node from the list so move along first */
+			node_p = node_p -> ln_next_p;
+
+			if ((!process_p -> sp_exited_flag) && (process_p -> sp_fds [PWT_EXIT] == -1))
+				{
+					ReapProcess (process_p, WNOHANG);
+					poll_flag = true;
+				}
+
+			if (process_p -> sp_exited_flag)
+				{
+					FinishProcess (process_p);
+				}
+			else
+				{
+					if ((process_p -> sp_deadline_ms > 0) && (now_ms >= process_p -> sp_deadline_ms))
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "\"%s\" timed out, stopping it", process_p -> sp_command_line_s);
+
+							process_p -> sp_timed_out_flag = true;
+							process_p -> sp_deadline_ms = 0;
+
+							if (process_p -> sp_kill_time_ms == 0)
+								{
+									SignalProcess (process_p, SIGTERM);
+									process_p -> sp_kill_time_ms = now_ms + PROCESS_SUPERVISOR_KILL_GRACE_PERIOD_MS;
+								}
+						}
+
+					if ((process_p -> sp_kill_time_ms > 0) && (now_ms >= process_p -> sp_kill_time_ms))
+						{
+							SignalProcess (process_p, SIGKILL);
+							process_p -> sp_kill_time_ms = 0;
+						}
+
+					if ((process_p -> sp_deadline_ms > 0) && ((next_event_ms == 0) || (process_p -> sp_deadline_ms < next_event_ms)))
+						{
+							next_event_ms = process_p -> sp_deadline_ms;
+						}
+
+					if ((process_p -> sp_kill_time_ms > 0) && ((next_event_ms == 0) || (process_p -> sp_kill_time_ms < next_event_ms)))
+						{
+							next_event_ms = process_p -> sp_kill_time_ms;
+						}
+				}
+		}
+
+	if (next_event_ms > 0)
+		{
+			uint64 diff = (next_event_ms > now_ms) ? next_event_ms - now_ms : 0;
+
+			if (poll_flag && (diff > S_FALLBACK_POLL_INTERVAL_MS))
+				{
+					diff = S_FALLBACK_POLL_INTERVAL_MS;
+				}
+
+			/* Make sure that we wake up at or after the deadline rather than just before it */
+			return (int) (diff + 1);
+		}
+	else if (poll_flag)
+		{
+			return S_FALLBACK_POLL_INTERVAL_MS;
+		}
+
+	return -1;
+}
+
+
+static bool WatchProcess (SupervisedProcess *process_p)
+{
+	bool success_flag = true;
+	int i;
+
+	/* pidfd_open () doesn't have a glibc wrapper on older systems */
+	#ifdef SYS_pidfd_open
+	process_p -> sp_fds [PWT_EXIT] = (int) syscall (SYS_pidfd_open, process_p -> sp_pid, 0);
+	#endif
+
+	pthread_mutex_lock (&s_supervisor_mutex);
+
+	if (!s_running_flag || s_stop_flag)
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Process supervisor stopped before \"%s\" could be watched", process_p -> sp_command_line_s);
+			success_flag = false;
+		}
+
+	for (i = 0; (i < PWT_NUM_TYPES) && success_flag; ++ i)
+		{
+			const int fd = process_p -> sp_fds [i];
+
+			if (fd != -1)
+				{
+					struct epoll_event event;
+
+					memset (&event, 0, sizeof (event));
+					event.events = EPOLLIN;
+					event.data.ptr = & (process_p -> sp_watches [i]);
+
+					if (i != PWT_EXIT)
+						{
+							fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+						}
+
+					if (epoll_ctl (s_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to watch descriptor %d for \"%s\", %s", fd, process_p -> sp_command_line_s, strerror (errno));
+							success_flag = false;
+						}
+				}
+		}
+
+	if (success_flag)
+		{
+			LinkedListAddTail (&s_processes, & (process_p -> sp_node));
+			WakeProcessSupervisor ();
+		}
+	else
+		{
+			for (i = 0; i < PWT_NUM_TYPES; ++ i)
+				{
+					CloseProcessFd (process_p, (ProcessWatchType) i);
+				}
+		}
+
+	pthread_mutex_unlock (&s_supervisor_mutex);
+
+	return success_flag;
+}
+
+
+static void CloseProcessFd (SupervisedProcess *process_p, const ProcessWatchType watch_type)
+{
+	int *fd_p = & (process_p -> sp_fds [watch_type]);
+
+	if (*fd_p != -1)
+		{
+			/* Closing the descriptor removes it from the epoll set too */
+			close (*fd_p);
+			*fd_p = -1;
+		}
+}
+
+
+static void ReadProcessOutput (SupervisedProcess *process_p, const ProcessWatchType watch_type)
+{
+	const int fd = process_p -> sp_fds [watch_type];
+
+	if (fd != -1)
+		{
+			RingBuffer *buffer_p = (watch_type == PWT_STDERR) ? & (process_p -> sp_stderr_buffer) : & (process_p -> sp_stdout_buffer);
+			char buffer_s [S_READ_BUFFER_SIZE];
+			bool loop_flag = true;
+
+			while (loop_flag)
+				{
+					ssize_t num_read = read (fd, buffer_s, S_READ_BUFFER_SIZE);
+
+					if (num_read > 0)
+						{
+							WriteToRingBuffer (buffer_p, buffer_s, (size_t) num_read);
+						}
+					else
+						{
+							/* Anything other than "no data yet" means the pipe is finished with */
+							if ((num_read == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)))
+								{
+									CloseProcessFd (process_p, watch_type);
+								}
+
+							if ((num_read == 0) || (errno != EINTR))
+								{
+									loop_flag = false;
+								}
+						}
+				}
+		}
+}
+
+
+static bool ReapProcess (SupervisedProcess *process_p, const int options)
+{
+	if (!process_p -> sp_exited_flag)
+		{
+			pid_t res;
+
+			do
+				{
+					res = waitpid (process_p -> sp_pid, & (process_p -> sp_wait_status), options);
+				}
+			while ((res == -1) && (errno == EINTR));
+
+			if (res == process_p -> sp_pid)
+				{
+					process_p -> sp_exited_flag = true;
+				}
+			else if (res == -1)
+				{
+					/* Someone else has reaped it so we have no exit status */
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to get exit status of %d for \"%s\", %s", process_p -> sp_pid, process_p -> sp_command_line_s, strerror (errno));
+
+					process_p -> sp_wait_status = -1;
+					process_p -> sp_exited_flag = true;
+				}
+		}
+
+	return process_p -> sp_exited_flag;
+}
+
+
+/*
+ * Called with the mutex held once a child has exited. Any output still
+ * sitting in the pipes is collected but we don't wait for the pipes to
+ * close, since anything the child started in the background may still
+ * have them open.
+ */
+static void FinishProcess (SupervisedProcess *process_p)
+{
+	ReadProcessOutput (process_p, PWT_STDOUT);
+	ReadProcessOutput (process_p, PWT_STDERR);
+
+	CloseProcessFd (process_p, PWT_STDOUT);
+	CloseProcessFd (process_p, PWT_STDERR);
+	CloseProcessFd (process_p, PWT_EXIT);
+
+	if ((process_p -> sp_node.ln_prev_p) || (process_p -> sp_node.ln_next_p) || (s_processes.ll_head_p == & (process_p -> sp_node)))
+		{
+			LinkedListRemove (&s_processes, & (process_p -> sp_node));
+		}
+
+	process_p -> sp_finished_flag = true;
+
+	/* Its callback is run once the mutex has been released */
+	if (process_p -> sp_on_exit_fn)
+		{
+			LinkedListAddTail (&s_finished_processes, & (process_p -> sp_node));
+		}
+
+	#if PROCESS_SUPERVISOR_DEBUG >= STM_LEVEL_FINE
+	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "%d for \"%s\" finished with status %d", process_p -> sp_pid, process_p -> sp_command_line_s, process_p -> sp_wait_status);
+	#endif
+
+	pthread_cond_broadcast (&s_supervisor_cond);
+}
+
+
+/*
+ * Called without the mutex held so that the callbacks can use the
+ * SupervisedProcess functions. A callback may free its process so
+ * the process mustn't be touched once its callback has been called.
+ */
+static void RunExitCallbacks (void)
+{
+	bool loop_flag = true;
+
+	while (loop_flag)
+		{
+			ListItem *node_p;
+
+			pthread_mutex_lock (&s_supervisor_mutex);
+			node_p = LinkedListRemHead (&s_finished_processes);
+			pthread_mutex_unlock (&s_supervisor_mutex);
+
+			if (node_p)
+				{
+					SupervisedProcess *process_p = (SupervisedProcess *) node_p;
+					int exit_code;
+					OperationStatus status;
+
+					InitListItem (node_p);
+					status = WaitForSupervisedProcess (process_p, &exit_code);
+
+					process_p -> sp_on_exit_fn (process_p, status, exit_code, process_p -> sp_on_exit_data_p);
+				}
+			else
+				{
+					loop_flag = false;
+				}
+		}
+}
+
+
+static void SignalProcess (SupervisedProcess *process_p, const int signal_number)
+{
+	/*
+	 * The child leads its own process group so signal the whole group.
+	 * It hasn't been reaped yet, so its pid can't have been reused.
+	 */
+	if (kill (- (process_p -> sp_pid), signal_number) != 0)
+		{
+			kill (process_p -> sp_pid, signal_number);
+		}
+}
+
+
+static void WakeProcessSupervisor (void)
+{
+	const uint64 value = 1;
+
+	if (write (s_wake_fd, &value, sizeof (value)) < 0)
+		{
+			#if PROCESS_SUPERVISOR_DEBUG >= STM_LEVEL_FINE
+			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Failed to wake process supervisor, %s", strerror (errno));
+			#endif
+		}
+}
+
+
+static bool DoesCommandLineNeedShell (const char *command_line_s)
+{
+	bool shell_flag = (strpbrk (command_line_s, S_SHELL_CHARACTERS_S) != NULL);
+
+	if (!shell_flag)
+		{
+			/* Leading "NAME=value" environment variable assignments need a shell too */
+			const char *space_p = command_line_s + strcspn (command_line_s, " \t");
+			const char *equals_p = strchr (command_line_s, '=');
+
+			shell_flag = (equals_p != NULL) && (equals_p < space_p);
+		}
+
+	return shell_flag;
+}
+
+
+static char **GetProcessArguments (const char *command_line_s)
+{
+	char **args_ss = NULL;
+
+	if (DoesCommandLineNeedShell (command_line_s))
+		{
+			args_ss = (char **) AllocMemoryArray (4, sizeof (char *));
+
+			if (args_ss)
+				{
+					*args_ss = EasyCopyToNewString ("/bin/sh");
+					* (args_ss + 1) = EasyCopyToNewString ("-c");
+					* (args_ss + 2) = EasyCopyToNewString (command_line_s);
+
+					if (! ((*args_ss) && (* (args_ss + 1)) && (* (args_ss + 2))))
+						{
+							FreeProcessArguments (args_ss);
+							args_ss = NULL;
+						}
+				}
+		}
+	else
+		{
+			LinkedList *tokens_p = ParseStringToStringLinkedList (command_line_s, NULL, true);
+
+			if (tokens_p)
+				{
+					if (tokens_p -> ll_size > 0)
+						{
+							args_ss = (char **) AllocMemoryArray ((tokens_p -> ll_size) + 1, sizeof (char *));
+
+							if (args_ss)
+								{
+									StringListNode *node_p = (StringListNode *) (tokens_p -> ll_head_p);
+									char **arg_ss = args_ss;
+
+									while (node_p)
+										{
+											*arg_ss = DetachStringFromStringListNode (node_p);
+											++ arg_ss;
+
+											node_p = (StringListNode *) (node_p -> sln_node.ln_next_p);
+										}
+								}
+						}
+
+					FreeLinkedList (tokens_p);
+				}
+		}
+
+	return args_ss;
+}
+
+
+static void FreeProcessArguments (char **args_ss)
+{
+	char **arg_ss = args_ss;
+
+	while (*arg_ss)
+		{
+			FreeCopiedString (*arg_ss);
+			++ arg_ss;
+		}
+
+	FreeMemory (args_ss);
+}
+
+
+static bool ApplyProcessLimits (const pid_t pid, const ProcessLimits *limits_p)
+{
+	bool success_flag = true;
+
+	if (limits_p)
+		{
+			success_flag = SetProcessLimit (pid, RLIMIT_CPU, limits_p -> pl_max_cpu_time_s) &&
+				SetProcessLimit (pid, RLIMIT_NOFILE, limits_p -> pl_max_open_files) &&
+				SetProcessLimit (pid, RLIMIT_AS, limits_p -> pl_max_memory) &&
+				SetProcessLimit (pid, RLIMIT_FSIZE, limits_p -> pl_max_file_size);
+
+			if (success_flag && (limits_p -> pl_cgroup_path_s))
+				{
+					success_flag = AddProcessToCgroup (pid, limits_p -> pl_cgroup_path_s);
+				}
+		}
+
+	return success_flag;
+}
+
+
+static bool SetProcessLimit (const pid_t pid, const int resource, const uint64 value)
+{
+	bool success_flag = true;
+
+	if (value > 0)
+		{
+			struct rlimit limit;
+
+			limit.rlim_cur = (rlim_t) value;
+			limit.rlim_max = (rlim_t) value;
+
+			if (prlimit (pid, resource, &limit, NULL) != 0)
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to set resource limit %d to %llu for %d, %s", resource, (unsigned long long) value, pid, strerror (errno));
+					success_flag = false;
+				}
+		}
+
+	return success_flag;
+}
+
+
+static bool AddProcessToCgroup (const pid_t pid, const char *cgroup_path_s)
+{
+	bool success_flag = false;
+	char *procs_path_s = ConcatenateVarargsStrings (cgroup_path_s, "/cgroup.procs", NULL);
+
+	if (procs_path_s)
+		{
+			FILE *procs_f = fopen (procs_path_s, "w");
+
+			if (procs_f)
+				{
+					if (fprintf (procs_f, "%d\n", pid) > 0)
+						{
+							success_flag = true;
+						}
+
+					if (fclose (procs_f) != 0)
+						{
+							success_flag = false;
+						}
+				}
+
+			if (!success_flag)
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add %d to cgroup \"%s\", %s", pid, procs_path_s, strerror (errno));
+				}
+
+			FreeCopiedString (procs_path_s);
+		}
+
+	return success_flag;
+}
+
+
+static uint64 GetCurrentTimeInMillis (void)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return ((uint64) now.tv_sec) * 1000 + ((uint64) now.tv_nsec) / 1000000;
+}
+
+
+static bool InitRingBuffer (RingBuffer *buffer_p, const size_t size)
+{
+	buffer_p -> rb_data_p = (char *) AllocMemory (size);
+
+	if (buffer_p -> rb_data_p)
+		{
+			buffer_p -> rb_size = size;
+			buffer_p -> rb_start = 0;
+			buffer_p -> rb_length = 0;
+
+			return true;
+		}
+
+	return false;
+}
+
+
+static void ClearRingBuffer (RingBuffer *buffer_p)
+{
+	if (buffer_p -> rb_data_p)
+		{
+			FreeMemory (buffer_p -> rb_data_p);
+			buffer_p -> rb_data_p = NULL;
+		}
+
+	buffer_p -> rb_size = 0;
+	buffer_p -> rb_start = 0;
+	buffer_p -> rb_length = 0;
+}
+
+
+/*
+ * Append data to a RingBuffer, overwriting the oldest
+ * data if there isn't enough space.
+ */
+static void WriteToRingBuffer (RingBuffer *buffer_p, const char *data_p, size_t length)
+{
+	const size_t size = buffer_p -> rb_size;
+
+	if (length >= size)
+		{
+			memcpy (buffer_p -> rb_data_p, data_p + (length - size), size);
+			buffer_p -> rb_start = 0;
+			buffer_p -> rb_length = size;
+		}
+	else
+		{
+			size_t end = (buffer_p -> rb_start + buffer_p -> rb_length) % size;
+			const size_t first_chunk = (end + length <= size) ? length : size - end;
+
+			memcpy (buffer_p -> rb_data_p + end, data_p, first_chunk);
+
+			if (first_chunk < length)
+				{
+					memcpy (buffer_p -> rb_data_p, data_p + first_chunk, length - first_chunk);
+				}
+
+			buffer_p -> rb_length += length;
+
+			if (buffer_p -> rb_length > size)
+				{
+					buffer_p -> rb_start = (buffer_p -> rb_start + (buffer_p -> rb_length - size)) % size;
+					buffer_p -> rb_length = size;
+				}
+		}
+}
+
+
+static char *GetRingBufferContents (const RingBuffer *buffer_p)
+{
+	char *contents_s = (char *) AllocMemory ((buffer_p -> rb_length) + 1);
+
+	if (contents_s)
+		{
+			const size_t first_chunk = (buffer_p -> rb_start + buffer_p -> rb_length <= buffer_p -> rb_size) ? buffer_p -> rb_length : buffer_p -> rb_size - buffer_p -> rb_start;
+
+			memcpy (contents_s, buffer_p -> rb_data_p + buffer_p -> rb_start, first_chunk);
+
+			if (first_chunk < buffer_p -> rb_length)
+				{
+					memcpy (contents_s + first_chunk, buffer_p -> rb_data_p, buffer_p -> rb_length - first_chunk);
+				}
+
+			* (contents_s + buffer_p -> rb_length) = '\0';
+		}
+
+	return contents_s;
+}
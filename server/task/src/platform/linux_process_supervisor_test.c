@@ -0,0 +1,450 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * linux_process_supervisor_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the ProcessSupervisor using standard command line tools
+ *  as dummy executables.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "process_supervisor.h"
+#include "memory_allocations.h"
+#include "string_utils.h"
+#include "unit_test.h"
+
+
+#define NUM_CONCURRENT_PROCESSES (200)
+
+
+/* What the exit callbacks have seen, guarded by s_callbacks_mutex */
+typedef struct CallbackResults
+{
+	int cr_num_called;
+	int cr_num_correct;
+	bool cr_same_thread_flag;
+	pthread_t cr_thread;
+} CallbackResults;
+
+
+static pthread_mutex_t s_callbacks_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_cond_t s_callbacks_cond = PTHREAD_COND_INITIALIZER;
+
+static CallbackResults s_callback_results;
+
+
+static double GetElapsedSeconds (const struct timespec *start_p)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start_p -> tv_sec) + ((now.tv_nsec - start_p -> tv_nsec) / 1e9);
+}
+
+
+static bool CheckOutput (SupervisedProcess *process_p, const bool stderr_flag, const char *expected_s)
+{
+	bool match_flag = false;
+	char *output_s = GetSupervisedProcessOutput (process_p, stderr_flag);
+
+	if (output_s)
+		{
+			match_flag = (expected_s ? (strcmp (output_s, expected_s) == 0) : (*output_s != '\0'));
+			FreeCopiedString (output_s);
+		}
+
+	return match_flag;
+}
+
+
+/*
+ * Wait for a process to write something to stdout so that we know
+ * that it has got past any setup such as installing signal handlers.
+ */
+static bool WaitForOutput (SupervisedProcess *process_p)
+{
+	int i;
+
+	for (i = 0; i < 500; ++ i)
+		{
+			if (CheckOutput (process_p, false, NULL))
+				{
+					return true;
+				}
+
+			usleep (10000);
+		}
+
+	return false;
+}
+
+
+static void TestExitCodes (void)
+{
+	SupervisedProcess *process_p = SpawnSupervisedProcess ("echo \"hello world\"", NULL, 0);
+
+	if (process_p)
+		{
+			int exit_code = -1;
+
+			Check (WaitForSupervisedProcess (process_p, &exit_code) == OS_SUCCEEDED, "echo succeeds");
+			Check (exit_code == 0, "echo exit code is 0");
+			Check (CheckOutput (process_p, false, "hello world\n"), "echo output is captured");
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			Check (false, "spawn echo");
+		}
+
+	process_p = SpawnSupervisedProcess ("/bin/sh -c \"echo oops >&2; exit 3\"", NULL, 0);
+
+	if (process_p)
+		{
+			int exit_code = -1;
+
+			Check (WaitForSupervisedProcess (process_p, &exit_code) == OS_FAILED, "non-zero exit fails");
+			Check (exit_code == 3, "exit code is 3");
+			Check (CheckOutput (process_p, true, "oops\n"), "stderr is captured");
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			Check (false, "spawn sh");
+		}
+
+	process_p = SpawnSupervisedProcess ("/no/such/program", NULL, 0);
+
+	if (process_p)
+		{
+			Check (WaitForSupervisedProcess (process_p, NULL) == OS_FAILED, "missing program fails");
+			FreeSupervisedProcess (process_p);
+		}
+}
+
+
+static void TestShellCommandLine (void)
+{
+	SupervisedProcess *process_p = SpawnSupervisedProcess ("echo one two | wc -w", NULL, 0);
+
+	if (process_p)
+		{
+			char *output_s;
+
+			Check (WaitForSupervisedProcess (process_p, NULL) == OS_SUCCEEDED, "pipeline succeeds");
+
+			output_s = GetSupervisedProcessOutput (process_p, false);
+			Check ((output_s != NULL) && (atoi (output_s) == 2), "pipeline is run by a shell");
+
+			if (output_s)
+				{
+					FreeCopiedString (output_s);
+				}
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			Check (false, "spawn pipeline");
+		}
+}
+
+
+static void TestRingBuffer (void)
+{
+	SupervisedProcess *process_p = SpawnSupervisedProcess ("seq 1 100000", NULL, 1024);
+
+	if (process_p)
+		{
+			char *output_s;
+
+			Check (WaitForSupervisedProcess (process_p, NULL) == OS_SUCCEEDED, "seq succeeds");
+
+			output_s = GetSupervisedProcessOutput (process_p, false);
+
+			if (output_s)
+				{
+					const size_t l = strlen (output_s);
+
+					Check (l == 1024, "output is limited to the buffer size");
+					Check ((l > 7) && (strcmp (output_s + l - 7, "100000\n") == 0), "most recent output is kept");
+
+					FreeCopiedString (output_s);
+				}
+			else
+				{
+					Check (false, "get seq output");
+				}
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			Check (false, "spawn seq");
+		}
+}
+
+
+static void TestTimeoutAndCancel (void)
+{
+	ProcessLimits limits;
+	SupervisedProcess *process_p;
+	struct timespec start;
+
+	memset (&limits, 0, sizeof (limits));
+	limits.pl_timeout_ms = 200;
+
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	process_p = SpawnSupervisedProcess ("sleep 10", &limits, 0);
+
+	if (process_p)
+		{
+			Check (WaitForSupervisedProcess (process_p, NULL) == OS_FAILED, "timed out process fails");
+			Check (HasSupervisedProcessTimedOut (process_p), "process is marked as timed out");
+			Check (GetElapsedSeconds (&start) < 2.0, "timeout is enforced promptly");
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			Check (false, "spawn sleep for timeout");
+		}
+
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	process_p = SpawnSupervisedProcess ("sleep 10", NULL, 0);
+
+	if (process_p)
+		{
+			Check (GetSupervisedProcessStatus (process_p) == OS_STARTED, "process is running");
+			Check (CancelSupervisedProcess (process_p), "cancel running process");
+			Check (WaitForSupervisedProcess (process_p, NULL) == OS_FAILED, "cancelled process fails");
+			Check (!HasSupervisedProcessTimedOut (process_p), "cancelled process is not marked as timed out");
+			Check (GetElapsedSeconds (&start) < 2.0, "cancel is prompt");
+			Check (!CancelSupervisedProcess (process_p), "cancel finished process");
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			Check (false, "spawn sleep for cancel");
+		}
+
+	/* A process that ignores SIGTERM gets SIGKILL after the grace period */
+	process_p = SpawnSupervisedProcess ("trap '' TERM; echo ready; while true; do sleep 0.1; done", NULL, 0);
+
+	if (process_p)
+		{
+			/* Cancelling before the trap is in place would stop it straight away */
+			Check (WaitForOutput (process_p), "process ignoring SIGTERM is ready");
+
+			clock_gettime (CLOCK_MONOTONIC, &start);
+
+			CancelSupervisedProcess (process_p);
+			Check (WaitForSupervisedProcess (process_p, NULL) == OS_FAILED, "process ignoring SIGTERM is killed");
+			Check (GetElapsedSeconds (&start) >= (PROCESS_SUPERVISOR_KILL_GRACE_PERIOD_MS / 1000.0) - 0.5, "SIGTERM is ignored");
+			Check (GetElapsedSeconds (&start) < (PROCESS_SUPERVISOR_KILL_GRACE_PERIOD_MS / 1000.0) + 2.0, "kill follows the grace period");
+
+			FreeSupervisedProcess (process_p);
+		}
+}
+
+
+static void TestLimits (void)
+{
+	ProcessLimits limits;
+	SupervisedProcess *process_p;
+
+	memset (&limits, 0, sizeof (limits));
+	limits.pl_max_open_files = 17;
+
+	/*
+	 * The limits are applied to the child just after it starts, so give
+	 * them time to be in place before the shell reports them. This mustn't
+	 * start another shell since that could be forked before then.
+	 */
+	process_p = SpawnSupervisedProcess ("sleep 0.2; ulimit -n", &limits, 0);
+
+	if (process_p)
+		{
+			Check (WaitForSupervisedProcess (process_p, NULL) == OS_SUCCEEDED, "limited process succeeds");
+			Check (CheckOutput (process_p, false, "17\n"), "open file limit is applied");
+
+			FreeSupervisedProcess (process_p);
+		}
+	else
+		{
+			Check (false, "spawn limited process");
+		}
+}
+
+
+/*
+ * The expected exit code is passed as the callback data. Each process
+ * is freed by its callback.
+ */
+static void OnProcessExit (SupervisedProcess *process_p, const OperationStatus status, const int exit_code, void *data_p)
+{
+	const int expected_exit_code = (int) (intptr_t) data_p;
+	const bool correct_flag = (exit_code == expected_exit_code) && (status == ((expected_exit_code == 0) ? OS_SUCCEEDED : OS_FAILED)) && CheckOutput (process_p, false, "done\n");
+
+	FreeSupervisedProcess (process_p);
+
+	pthread_mutex_lock (&s_callbacks_mutex);
+
+	if (s_callback_results.cr_num_called == 0)
+		{
+			s_callback_results.cr_thread = pthread_self ();
+		}
+	else if (!pthread_equal (s_callback_results.cr_thread, pthread_self ()))
+		{
+			s_callback_results.cr_same_thread_flag = false;
+		}
+
+	++ s_callback_results.cr_num_called;
+
+	if (correct_flag)
+		{
+			++ s_callback_results.cr_num_correct;
+		}
+
+	pthread_cond_signal (&s_callbacks_cond);
+	pthread_mutex_unlock (&s_callbacks_mutex);
+}
+
+
+static void TestExitCallbacks (void)
+{
+	struct timespec start;
+	int num_spawned = 0;
+	int i;
+
+	memset (&s_callback_results, 0, sizeof (s_callback_results));
+	s_callback_results.cr_same_thread_flag = true;
+
+	clock_gettime (CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < NUM_CONCURRENT_PROCESSES; ++ i)
+		{
+			const int exit_code = i % 3;
+			char command_line_s [64];
+
+			snprintf (command_line_s, sizeof (command_line_s), "sleep 0.5; echo done; exit %d", exit_code);
+
+			if (SpawnSupervisedProcessWithCallback (command_line_s, NULL, 256, OnProcessExit, (void *) (intptr_t) exit_code))
+				{
+					++ num_spawned;
+				}
+		}
+
+	Check (num_spawned == NUM_CONCURRENT_PROCESSES, "spawn processes with exit callbacks");
+
+	pthread_mutex_lock (&s_callbacks_mutex);
+
+	while ((s_callback_results.cr_num_called < num_spawned) && (GetElapsedSeconds (&start) < 10.0))
+		{
+			struct timespec deadline;
+
+			clock_gettime (CLOCK_REALTIME, &deadline);
+			deadline.tv_sec += 1;
+			pthread_cond_timedwait (&s_callbacks_cond, &s_callbacks_mutex, &deadline);
+		}
+
+	Check (s_callback_results.cr_num_called == num_spawned, "call every exit callback once");
+	Check (s_callback_results.cr_num_correct == num_spawned, "pass each callback its process's status, exit code and output");
+	Check (s_callback_results.cr_same_thread_flag && !pthread_equal (s_callback_results.cr_thread, pthread_self ()), "call back from the supervisor thread rather than one thread per process");
+
+	pthread_mutex_unlock (&s_callbacks_mutex);
+
+	printf ("%d processes with callbacks took %.2f s\n", num_spawned, GetElapsedSeconds (&start));
+
+	Check (GetElapsedSeconds (&start) < 5.0, "processes with callbacks run in parallel");
+}
+
+
+static void TestConcurrency (void)
+{
+	SupervisedProcess **processes_pp = (SupervisedProcess **) AllocMemoryArray (NUM_CONCURRENT_PROCESSES, sizeof (SupervisedProcess *));
+
+	if (processes_pp)
+		{
+			struct timespec start;
+			int num_succeeded = 0;
+			int i;
+
+			clock_gettime (CLOCK_MONOTONIC, &start);
+
+			for (i = 0; i < NUM_CONCURRENT_PROCESSES; ++ i)
+				{
+					processes_pp [i] = SpawnSupervisedProcess ("sleep 0.5", NULL, 256);
+				}
+
+			for (i = 0; i < NUM_CONCURRENT_PROCESSES; ++ i)
+				{
+					if (processes_pp [i])
+						{
+							if (WaitForSupervisedProcess (processes_pp [i], NULL) == OS_SUCCEEDED)
+								{
+									++ num_succeeded;
+								}
+
+							FreeSupervisedProcess (processes_pp [i]);
+						}
+				}
+
+			printf ("%d concurrent processes took %.2f s\n", NUM_CONCURRENT_PROCESSES, GetElapsedSeconds (&start));
+
+			Check (num_succeeded == NUM_CONCURRENT_PROCESSES, "all concurrent processes succeed");
+			Check (GetElapsedSeconds (&start) < 5.0, "concurrent processes run in parallel");
+
+			FreeMemory (processes_pp);
+		}
+}
+
+
+int main (int UNUSED_PARAM (argc), char ** UNUSED_PARAM (argv))
+{
+	if (StartProcessSupervisor ())
+		{
+			TestExitCodes ();
+			TestShellCommandLine ();
+			TestRingBuffer ();
+			TestTimeoutAndCancel ();
+			TestLimits ();
+			TestConcurrency ();
+			TestExitCallbacks ();
+
+			StopProcessSupervisor ();
+		}
+	else
+		{
+			Check (false, "start process supervisor");
+		}
+
+	return GetTestResult ();
+}
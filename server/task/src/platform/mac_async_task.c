@@ -154,7 +154,13 @@ bool RunAsyncTask (AsyncTask *task_p)
 {
 	bool success_flag = true;
 	UnixAsyncTask *unix_task_p = (UnixAsyncTask *) task_p;
-	int res = pthread_create (& (unix_task_p -> uat_thread), & (unix_task_p -> uat_attributes), DoAsyncTaskRun, task_p);
+	int res;
+
+	/* The task's thread logs under the id of the request that started it */
+	SetAsyncTaskCorrelationId (task_p, GetLogCorrelationId ());
+	SetAsyncTaskTraceParent (task_p);
+
+	res = pthread_create (& (unix_task_p -> uat_thread), & (unix_task_p -> uat_attributes), DoAsyncTaskRun, task_p);
 
 	if (res == 0)
 		{
@@ -201,6 +207,22 @@ OperationStatus ActualRunSystemAsyncTask (SystemAsyncTask *task_p)
 }
 
 
+bool CancelSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	/* The command line is run with system () on this platform so it can't be stopped */
+	PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Cancelling \"%s\" is not supported on this platform", task_p -> std_command_line_s);
+
+	return false;
+}
+
+
+bool ActualStartSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	/* There's no process supervisor on this platform so a thread waits for the command line */
+	return RunBlockingSystemAsyncTask (task_p);
+}
+
+
 OperationStatus RunProcess (const char * const command_line_s)
 {
 	OperationStatus status = OS_FAILED;
@@ -239,6 +261,9 @@ static void *DoAsyncTaskRun (void *data_p)
 	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "DoAsyncTaskRun about to run for \"%s\" at %.16X", async_task_p -> at_name_s, async_task_p);
 	#endif
 
+	SetLogCorrelationId (GetAsyncTaskCorrelationId (async_task_p));
+	SetTraceParent (GetAsyncTaskTraceParent (async_task_p));
+
 	res_p = async_task_p -> at_run_fn (async_task_p -> at_data_p);
 
 	#if UNIX_ASYNC_TASK_DEBUG >= STM_LEVEL_FINEST
@@ -153,6 +153,10 @@ bool RunAsyncTask (AsyncTask *task_p)
 	bool success_flag = true;
 	WindowsAsyncTask *win_task_p = (WindowsAsyncTask *) task_p;
 
+	/* The task's thread logs under the id of the request that started it */
+	SetAsyncTaskCorrelationId (task_p, GetLogCorrelationId ());
+	SetAsyncTaskTraceParent (task_p);
+
 	win_task_p -> wat_thread_handle = CreateThread (
 		NULL,																// default security attributes
 		0,																	// use default stack size  
@@ -247,6 +251,22 @@ OperationStatus ActualRunSystemAsyncTask (SystemAsyncTask *task_p)
 	return RunProcess (task_p -> std_command_line_s);
 }
 
+bool CancelSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	/* The command line is run with system () on this platform so it can't be stopped */
+	PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Cancelling \"%s\" is not supported on this platform", task_p -> std_command_line_s);
+
+	return false;
+}
+
+
+bool ActualStartSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	/* There's no process supervisor on this platform so a thread waits for the command line */
+	return RunBlockingSystemAsyncTask (task_p);
+}
+
+
 static DWORD WINAPI DoAsyncTaskRun (LPVOID data_p)
 {
 	WindowsAsyncTask *win_task_p = (WindowsAsyncTask *) data_p;
@@ -257,6 +277,9 @@ static DWORD WINAPI DoAsyncTaskRun (LPVOID data_p)
 	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "DoAsyncTaskRun about to run for \"%s\" at %.16X", async_task_p -> at_name_s, async_task_p);
 	#endif
 
+	SetLogCorrelationId (GetAsyncTaskCorrelationId (base_task_p));
+	SetTraceParent (GetAsyncTaskTraceParent (base_task_p));
+
 	res_p = base_task_p-> at_run_fn (base_task_p -> at_data_p);
 
 	#if WINDOWS_ASYNC_TASK_DEBUG >= STM_LEVEL_FINEST
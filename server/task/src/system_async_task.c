@@ -5,6 +5,8 @@
  *      Author: billy
  */
 
+#include <string.h>
+
 #include "system_async_task.h"
 #include "async_tasks_manager.h"
 #include "memory_allocations.h"
@@ -21,6 +23,8 @@
 
 static void *RunAsyncSystemTaskHook (void *data_p);
 
+static bool UpdateSystemAsyncTaskJob (SystemAsyncTask *task_p);
+
 
 SystemAsyncTask *AllocateSystemAsyncTask (ServiceJob *job_p, const char *name_s, AsyncTasksManager *manager_p, bool add_flag, const char *command_s, void (*on_success_callback_fn) (ServiceJob *job_p))
 {
@@ -33,6 +37,11 @@ SystemAsyncTask *AllocateSystemAsyncTask (ServiceJob *job_p, const char *name_s,
 			if (system_task_p)
 				{
 					system_task_p -> std_command_line_s = NULL;
+					system_task_p -> std_stdout_s = NULL;
+					system_task_p -> std_stderr_s = NULL;
+					system_task_p -> std_process_p = NULL;
+					system_task_p -> std_cancelled_flag = false;
+					memset (& (system_task_p -> std_limits), 0, sizeof (ProcessLimits));
 
 					if (SetSystemAsyncTaskCommand (system_task_p, command_s))
 						{
@@ -106,6 +115,25 @@ bool SetSystemAsyncTaskCommand (SystemAsyncTask *task_p, const char *command_s)
 }
 
 
+void SetSystemAsyncTaskLimits (SystemAsyncTask *task_p, const ProcessLimits *limits_p)
+{
+	if (limits_p)
+		{
+			memcpy (& (task_p -> std_limits), limits_p, sizeof (ProcessLimits));
+		}
+	else
+		{
+			memset (& (task_p -> std_limits), 0, sizeof (ProcessLimits));
+		}
+}
+
+
+const char *GetSystemAsyncTaskOutput (const SystemAsyncTask *task_p, const bool stderr_flag)
+{
+	return stderr_flag ? task_p -> std_stderr_s : task_p -> std_stdout_s;
+}
+
+
 void FreeSystemAsyncTask (SystemAsyncTask *system_task_p)
 {
 	#if ASYNC_SYSTEM_BLAST_TOOL_DEBUG >= STM_LEVEL_FINE
@@ -134,12 +162,46 @@ void FreeSystemAsyncTask (SystemAsyncTask *system_task_p)
 			FreeCopiedString (system_task_p -> std_command_line_s);
 		}
 
+	if (system_task_p -> std_stdout_s)
+		{
+			FreeCopiedString (system_task_p -> std_stdout_s);
+		}
+
+	if (system_task_p -> std_stderr_s)
+		{
+			FreeCopiedString (system_task_p -> std_stderr_s);
+		}
+
 
 	FreeMemory (system_task_p);
 }
 
 
 bool RunSystemAsyncTask (SystemAsyncTask *task_p)
+{
+	bool success_flag = false;
+	ServiceJob *job_p = task_p -> std_service_job_p;
+
+	/* Set the job to having started */
+	/* Windows complains that it can't find the function as it's a cicular
+	 * dependency*/
+	// SetServiceJobStatus (job_p, OS_STARTED);
+	job_p -> sj_status = OS_STARTED;
+
+	if (UpdateSystemAsyncTaskJob (task_p))
+		{
+			success_flag = ActualStartSystemAsyncTask (task_p);
+		}
+	else
+		{
+			FinishSystemAsyncTask (task_p, OS_FAILED_TO_START);
+		}
+
+	return success_flag;
+}
+
+
+bool RunBlockingSystemAsyncTask (SystemAsyncTask *task_p)
 {
 	SetAsyncTaskRunData (task_p -> std_async_task_p, RunAsyncSystemTaskHook, task_p);
 
@@ -147,9 +209,44 @@ bool RunSystemAsyncTask (SystemAsyncTask *task_p)
 }
 
 
+void FinishSystemAsyncTask (SystemAsyncTask *task_p, const OperationStatus status)
+{
+	ServiceJob *job_p = task_p -> std_service_job_p;
+
+	/* Windows complains that it can't find the function as
+	 * it's a cicular dependency*/
+	// SetServiceJobStatus (job_p, status);
+	job_p -> sj_status = status;
+
+	/* If the job ran successfully, run any specified callbacks to update the results */
+	if ((status == OS_SUCCEEDED) || (status == OS_PARTIALLY_SUCCEEDED))
+		{
+			RunSystemAsyncTaskSuccess (task_p, job_p);
+		}
+
+	UpdateSystemAsyncTaskJob (task_p);
+
+	#if ASYNC_SYSTEM_BLAST_TOOL_DEBUG >= STM_LEVEL_FINE
+	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Finished SystemAsyncTask for \"%s\" with status %d", task_p -> std_command_line_s, status);
+	#endif
+}
+
+
 static void *RunAsyncSystemTaskHook (void *data_p)
 {
 	SystemAsyncTask *task_p = ((SystemAsyncTask *) data_p);
+
+	FinishSystemAsyncTask (task_p, ActualRunSystemAsyncTask (task_p));
+
+	return NULL;
+}
+
+
+/*
+ * Store the SystemAsyncTask's ServiceJob, with its current status, in the JobsManager.
+ */
+static bool UpdateSystemAsyncTaskJob (SystemAsyncTask *task_p)
+{
 	ServiceJob *job_p = task_p -> std_service_job_p;
 
 	/* Windows complains that it can't find the function as it's a cicular dependency*/
@@ -169,68 +266,19 @@ static void *RunAsyncSystemTaskHook (void *data_p)
 		}
 	#endif
 
-	OperationStatus status = OS_STARTED;
-	char uuid_s [UUID_STRING_BUFFER_SIZE];
-
-	ConvertUUIDToString (job_p -> sj_id, uuid_s);
-
-	/* Set the job to having started */
-  /* Windows complains that it can't find the function as it's a cicular
-    * dependency*/
-	// SetServiceJobStatus (job_p, status);
-  job_p -> sj_status = status;
-
-
 	if (add_job_fn (jobs_manager_p, job_p -> sj_id, job_p))
 		{
-			status = ActualRunSystemAsyncTask (task_p);
+			return true;
 		}
 	else
 		{
-			status = OS_FAILED_TO_START;
-			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add job %s with status %d to jobs manager", uuid_s, status);
-		}
-
-	/* has the job status changed? */
-	if (status != OS_STARTED)
-		{
-      /* Windows complains that it can't find the function as
-        * it's a cicular dependency*/
-      // SetServiceJobStatus (job_p, status);
-      job_p -> sj_status = status;
+			char uuid_s [UUID_STRING_BUFFER_SIZE];
 
-			/* If the job ran successfully, run any specified callbacks to update the results */
-			if ((status == OS_SUCCEEDED) || (status == OS_PARTIALLY_SUCCEEDED))
-				{
-					if (task_p -> std_on_success_callback_fn)
-						{
-							task_p -> std_on_success_callback_fn (job_p);
-						}
-				}
-
-			if (! (add_job_fn (jobs_manager_p, job_p -> sj_id, job_p)))
-				{
-					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add job %s with status %d to jobs manager", uuid_s, status);
-				}
-
-/*
-			if (task_p -> std_async_task_p -> at_consumer_p)
-				{
-					#if ASYNC_SYSTEM_BLAST_TOOL_DEBUG >= STM_LEVEL_FINE
-					PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Sending message to EventConsumer for %s", uuid_s);
-					#endif
-
-					RunEventConsumerFromAsyncTask (task_p -> std_async_task_p);
-					//SendSyncData (task_data_p -> std_async_task_p -> at_sync_data_p);
-				}
-*/
+			ConvertUUIDToString (job_p -> sj_id, uuid_s);
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add job %s with status %d to jobs manager", uuid_s, job_p -> sj_status);
 		}
 
-	#if ASYNC_SYSTEM_BLAST_TOOL_DEBUG >= STM_LEVEL_FINE
-	PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Leaving RunAsyncSystemTaskHook for %s with status %d", uuid_s, status);
-	#endif
-
-	return NULL;
+	return false;
 }
 
 
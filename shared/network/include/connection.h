@@ -168,6 +168,21 @@ GRASSROOTS_NETWORK_API void ReleaseConnection (Connection *connection_p);
 GRASSROOTS_NETWORK_API bool AddConnectionHeader (Connection *connection_p, const char *key_s, const char *value_s);
 
 
+/**
+ * Set the encodings that the server at the other end of a web Connection
+ * accepts for compressed request bodies, before it has said so itself.
+ *
+ * @param connection_p The Connection to adjust.
+ * @param accept_encoding_s The encodings in the same form as the value
+ * of an Accept-Encoding header, e.g. "gzip".
+ * @return <code>true</code> if the Connection is a web Connection and the
+ * encodings were set, <code>false</code> otherwise.
+ * @memberof Connection
+ * @see SetCurlToolAcceptedRequestEncodings
+ */
+GRASSROOTS_NETWORK_API bool SetConnectionAcceptedRequestEncodings (Connection *connection_p, const char *accept_encoding_s);
+
+
 /** @} */
 
 
@@ -31,6 +31,7 @@
 #include "typedefs.h"
 #include "network_library.h"
 #include "byte_buffer.h"
+#include "rope_buffer.h"
 
 
 /**
@@ -51,6 +52,41 @@ typedef enum CurlMode
 } CurlMode;
 
 
+/**
+ * The default size in bytes below which request bodies
+ * are sent uncompressed.
+ *
+ * @ingroup network_group
+ */
+#define CURL_TOOL_DEFAULT_COMPRESSION_THRESHOLD (1024)
+
+
+/**
+ * The content codings that a CurlTool can compress request
+ * bodies with. These are bit flags so that the set of codings
+ * that a server accepts can be stored together.
+ *
+ * @ingroup network_group
+ */
+typedef enum RequestEncoding
+{
+	/** The body is sent uncompressed. */
+	RE_IDENTITY = 0,
+
+	/** The body is gzip-compressed. */
+	RE_GZIP = 1 << 0,
+
+	/**
+	 * The body is zstd-compressed. This is only used if the
+	 * library was built with ZSTD_ENABLED.
+	 */
+	RE_ZSTD = 1 << 1
+} RequestEncoding;
+
+
+struct CompressedRequestBody;
+
+
 typedef struct TemporaryFile
 {
 	/** @private */
@@ -102,6 +138,26 @@ typedef struct CurlTool
 	/** @private */
 	struct curl_slist *ct_headers_list_p;
 
+	/** @private */
+	RopeBuffer *ct_request_body_p;
+
+	/** @private */
+	struct CompressedRequestBody *ct_compressed_body_p;
+
+	/** @private */
+	size_t ct_compression_threshold;
+
+	/** @private */
+	bool ct_compress_requests_flag;
+
+	/**
+	 * @private
+	 * The RequestEncodings that the server accepts for request bodies,
+	 * either from an Accept-Encoding response header or from
+	 * SetCurlToolAcceptedRequestEncodings ().
+	 */
+	uint32 ct_accepted_encodings;
+
 	bool ct_verbose_flag;
 
 } CurlTool;
@@ -329,6 +385,43 @@ GRASSROOTS_NETWORK_API void ClearCurlToolData (CurlTool *tool_p);
 GRASSROOTS_NETWORK_API void SetCurlToolVerbose (CurlTool *tool_p, const bool verbose_flag);
 
 
+/**
+ * Set whether a CurlTool compresses the bodies of its JSON requests.
+ *
+ * Servers don't say which encodings they accept for requests until they
+ * have responded, so until a response from the server includes gzip or zstd
+ * in an Accept-Encoding header, as described in RFC 7694, requests are sent
+ * uncompressed unless the encodings have been set with
+ * SetCurlToolAcceptedRequestEncodings (). After that, any request bodies
+ * that are at least the given size are compressed as they are sent, using
+ * zstd if both sides support it and gzip otherwise. Responses are always
+ * requested with every encoding that curl supports.
+ *
+ * @param tool_p The CurlTool to adjust.
+ * @param compress_flag <code>true</code> to compress request bodies once the
+ * server accepts them, <code>false</code> to always send them uncompressed.
+ * @param threshold The size in bytes below which request bodies are sent
+ * uncompressed.
+ * @memberof CurlTool
+ */
+GRASSROOTS_NETWORK_API void SetCurlToolRequestCompression (CurlTool *tool_p, const bool compress_flag, const size_t threshold);
+
+
+/**
+ * Set the encodings that a CurlTool's server accepts for request bodies
+ * without waiting for it to send an Accept-Encoding header. This is for
+ * servers that are known to accept compressed requests but never say so.
+ * An Accept-Encoding header in a later response replaces these.
+ *
+ * @param tool_p The CurlTool to adjust.
+ * @param accept_encoding_s The encodings in the same form as the value
+ * of an Accept-Encoding header, e.g. "zstd, gzip;q=0.5".
+ * @memberof CurlTool
+ * @see SetCurlToolRequestCompression
+ */
+GRASSROOTS_NETWORK_API void SetCurlToolAcceptedRequestEncodings (CurlTool *tool_p, const char *accept_encoding_s);
+
+
 
 GRASSROOTS_NETWORK_API bool DownloadFile (CurlTool * const curl_p, const char * const url_s, const char * const output_filename_s);
 
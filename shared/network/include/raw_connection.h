@@ -40,6 +40,7 @@
 /* forward declarations */
 struct RawConnection;
 struct Connection;
+struct RopeBuffer;
 
 
 #ifdef __cplusplus
@@ -104,6 +105,22 @@ GRASSROOTS_NETWORK_API int AtomicSendStringViaRawConnection (const char *data_s,
 GRASSROOTS_NETWORK_API int AtomicSendViaRawConnection (const char *buffer_p, uint32 num_to_send, struct RawConnection *connection_p);
 
 
+/**
+ * Send the contents of a RopeBuffer over a network connection. The fragments
+ * of the RopeBuffer are sent directly with writev () so they are not copied
+ * into a single block first.
+ *
+ * @param buffer_p The RopeBuffer to send.
+ * @param connection_p The RawConnection to use to send the data with.
+ * @return A positive integer for the number of bytes sent upon success. When negative,
+ * it indicates that there was an error with this value being -(num bytes sent) that were
+ * sent successfully before the error occurred. If this is zero, it means that there was
+ * an error sending the initial message containing the length header.
+ * @memberof RawConnection
+ */
+GRASSROOTS_NETWORK_API int AtomicSendRopeBufferViaRawConnection (const struct RopeBuffer *buffer_p, struct RawConnection *connection_p);
+
+
 GRASSROOTS_NETWORK_LOCAL int SendJsonRequestViaRawConnection (struct RawConnection *connection_p, const json_t *json_p);
 
 
@@ -0,0 +1,198 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * raw_connection_server.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * @brief An event-driven Server for RawConnection Clients.
+ *
+ * A RawConnectionServer accepts RawConnections on a port and serves
+ * them from a small, fixed number of worker threads. Each worker uses
+ * epoll to wait on its share of the connections, all of which are
+ * non-blocking, so the number of Clients isn't bounded by the number
+ * of threads. Messages use the same framing as AtomicSendViaRawConnection (),
+ * i.e. a 4-byte length and a 4-byte id, both in network byte order,
+ * followed by the JSON message. Frames are reassembled as their data
+ * arrives and each complete request is passed to a handler function
+ * whose response is sent back with the id of the request.
+ *
+ * The handlers are run on a separate, fixed-size pool of handler threads
+ * so that a slow request, such as running a Service, doesn't stop the
+ * worker threads from serving the other connections. Once a handler has
+ * finished, its response is passed back to the worker that owns the
+ * connection to be sent. Each connection has at most one request being
+ * handled at a time, so its responses are sent in the order that its
+ * requests arrived and no more of its input is read until its current
+ * request has been answered. The number of requests that can be processed
+ * at once is the number of handler threads and any others wait for one
+ * of them to become free.
+ *
+ * This is currently only available on Linux.
+ *
+ * @addtogroup network_group
+ * @{
+ */
+
+#ifndef RAW_CONNECTION_SERVER_H_
+#define RAW_CONNECTION_SERVER_H_
+
+#include "jansson.h"
+
+#include "network_library.h"
+#include "typedefs.h"
+
+
+/**
+ * The default number of worker threads used by a RawConnectionServer.
+ */
+#define RAW_CONNECTION_SERVER_DEFAULT_NUM_THREADS (4)
+
+
+/**
+ * The default number of handler threads used by a RawConnectionServer.
+ */
+#define RAW_CONNECTION_SERVER_DEFAULT_NUM_HANDLER_THREADS (16)
+
+
+/**
+ * The largest message, in bytes, that a RawConnectionServer will accept.
+ * Any Client that sends a larger one is disconnected.
+ */
+#define RAW_CONNECTION_SERVER_MAX_MESSAGE_SIZE (64 * 1024 * 1024)
+
+
+/**
+ * The key used for the error message in the response sent when a request
+ * can't be parsed or the handler doesn't return a response.
+ */
+#define RAW_CONNECTION_SERVER_ERROR_S "error"
+
+
+/**
+ * A function that processes a request received by a RawConnectionServer.
+ *
+ * This is called from the RawConnectionServer's handler threads so it must
+ * be thread-safe. While it is running, the handler thread isn't available
+ * for any other requests.
+ *
+ * @param req_p The request.
+ * @param data_p The custom data that was passed to AllocateRawConnectionServer ().
+ * @return The response, which the RawConnectionServer will take ownership of, or
+ * <code>NULL</code> upon error.
+ */
+typedef json_t *(*RawConnectionRequestHandler) (json_t *req_p, void *data_p);
+
+
+/* forward declaration */
+struct RawConnectionServer;
+
+/**
+ * @brief An event-driven Server for RawConnections.
+ */
+typedef struct RawConnectionServer RawConnectionServer;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Allocate a RawConnectionServer. It will be listening for connections
+ * when this returns but they will not be served until StartRawConnectionServer ()
+ * has been called.
+ *
+ * @param port_s The port to listen on. If this is "0", a free port will
+ * be chosen which can be got with GetRawConnectionServerPort ().
+ * @param num_threads The number of worker threads to use. If this is 0,
+ * RAW_CONNECTION_SERVER_DEFAULT_NUM_THREADS will be used.
+ * @param num_handler_threads The number of threads to run handler_fn on. If
+ * this is 0, RAW_CONNECTION_SERVER_DEFAULT_NUM_HANDLER_THREADS will be used.
+ * @param handler_fn The function to process each request with.
+ * @param handler_data_p Custom data that will be passed to handler_fn.
+ * @return The new RawConnectionServer or <code>NULL</code> upon error.
+ * @memberof RawConnectionServer
+ */
+GRASSROOTS_NETWORK_API RawConnectionServer *AllocateRawConnectionServer (const char *port_s, const uint32 num_threads, const uint32 num_handler_threads, RawConnectionRequestHandler handler_fn, void *handler_data_p);
+
+
+/**
+ * Free a RawConnectionServer. If it is still running, it will be stopped first.
+ *
+ * @param server_p The RawConnectionServer to free.
+ * @memberof RawConnectionServer
+ */
+GRASSROOTS_NETWORK_API void FreeRawConnectionServer (RawConnectionServer *server_p);
+
+
+/**
+ * Start the worker and handler threads of a RawConnectionServer.
+ *
+ * @param server_p The RawConnectionServer to start.
+ * @return <code>true</code> if the RawConnectionServer was started successfully,
+ * <code>false</code> upon error.
+ * @memberof RawConnectionServer
+ */
+GRASSROOTS_NETWORK_API bool StartRawConnectionServer (RawConnectionServer *server_p);
+
+
+/**
+ * Stop a RawConnectionServer and close all of its connections. Any requests
+ * that are being processed will finish first and any that are waiting for a
+ * handler thread will be dropped.
+ *
+ * @param server_p The RawConnectionServer to stop.
+ * @memberof RawConnectionServer
+ */
+GRASSROOTS_NETWORK_API void StopRawConnectionServer (RawConnectionServer *server_p);
+
+
+/**
+ * Get the port that a RawConnectionServer is listening on.
+ *
+ * @param server_p The RawConnectionServer to query.
+ * @return The port number.
+ * @memberof RawConnectionServer
+ */
+GRASSROOTS_NETWORK_API uint16 GetRawConnectionServerPort (const RawConnectionServer *server_p);
+
+
+/**
+ * Get the number of Clients that are currently connected to a RawConnectionServer.
+ *
+ * @param server_p The RawConnectionServer to query.
+ * @return The number of open connections.
+ * @memberof RawConnectionServer
+ */
+GRASSROOTS_NETWORK_API uint32 GetRawConnectionServerNumConnections (RawConnectionServer *server_p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+/** @} */
+
+#endif		/* #ifndef RAW_CONNECTION_SERVER_H_ */
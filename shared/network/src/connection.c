@@ -27,6 +27,9 @@
 #include "json_tools.h"
 #include "request_tools.h"
 #include "streams.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "schema_keys.h"
 
 
 #include "raw_connection.h"
@@ -39,6 +42,11 @@
 #endif
 
 
+/* The metrics labels for connections without a URI */
+static const char * const S_RAW_CONNECTION_METRIC_S = "raw";
+
+static const char * const S_WEB_CONNECTION_METRIC_S = "web";
+
 
 static void FreeWebConnection (WebConnection *connection_p);
 
@@ -104,6 +112,9 @@ Connection *AllocateWebServerConnection (const char * const full_uri_s, CurlMode
 								{
 									if (SetCurlToolForJSONPost (curl_p))
 										{
+											/* Compress large requests once the server says that it accepts them */
+											SetCurlToolRequestCompression (curl_p, true, CURL_TOOL_DEFAULT_COMPRESSION_THRESHOLD);
+
 											if (InitConnection (& (connection_p -> wc_base), CT_WEB))
 												{
 													connection_p -> wc_curl_p = curl_p;
@@ -182,25 +193,65 @@ void FreeConnection (Connection *connection_p)
 const char *MakeRemoteJsonCallViaConnection (Connection *connection_p, const json_t *req_p)
 {
 	bool success_flag = false;
+	const uint64 start_time = GetMetricsTime ();
+	Span *span_p = StartSpan ("grassroots remote call", SK_CLIENT);
+	json_t *traced_req_p = NULL;
+
+	/*
+	 * Pass the trace context on in the request so that the other Server
+	 * carries on the same trace. The request is const, so add it to a
+	 * shallow copy.
+	 */
+	if (span_p)
+		{
+			char trace_parent_s [TRACE_PARENT_BUFFER_SIZE];
+
+			if (GetTraceParent (trace_parent_s))
+				{
+					traced_req_p = json_copy ((json_t *) req_p);
+
+					if (traced_req_p)
+						{
+							if (json_object_set_new (traced_req_p, TRACE_PARENT_S, json_string (trace_parent_s)) == 0)
+								{
+									req_p = traced_req_p;
+								}
+						}
+				}
+		}
 
 	if (connection_p -> co_type == CT_RAW)
 		{
+			AddSpanAttribute (span_p, "grassroots.connection", S_RAW_CONNECTION_METRIC_S);
+
 #ifdef WINDOWS 
 
 #else
 		success_flag = MakeRemoteJsonCallViaRawConnection (connection_p, req_p);
 #endif	
+
+		RecordMetric (METRICS_REMOTE_CALL_S, S_RAW_CONNECTION_METRIC_S, start_time, success_flag);
 		}
 	else if (connection_p -> co_type == CT_WEB)
 		{
 			WebConnection *web_connection_p = (WebConnection *) connection_p;
 
+			AddSpanAttribute (span_p, "url.full", web_connection_p -> wc_uri_s);
+
 			if (MakeRemoteJSONCallFromCurlTool (web_connection_p -> wc_curl_p, req_p))
 				{
 					success_flag = true;
 				}		/* if (MakeRemoteJSONCallFromCurlTool (web_connection_p -> wc_curl_p, req_p)) */
+
+			RecordMetric (METRICS_REMOTE_CALL_S, (web_connection_p -> wc_uri_s) ? (web_connection_p -> wc_uri_s) : S_WEB_CONNECTION_METRIC_S, start_time, success_flag);
 		}
 
+	if (traced_req_p)
+		{
+			json_decref (traced_req_p);
+		}
+
+	EndSpan (span_p, success_flag);
 
 	return (success_flag ? GetConnectionData (connection_p) : NULL);
 }
@@ -271,3 +322,19 @@ bool AddConnectionHeader (Connection *connection_p, const char *key_s, const cha
 	return success_flag;
 }
 
+
+bool SetConnectionAcceptedRequestEncodings (Connection *connection_p, const char *accept_encoding_s)
+{
+	bool success_flag = false;
+
+	if (connection_p -> co_type == CT_WEB)
+		{
+			WebConnection *web_conn_p = (WebConnection *) connection_p;
+
+			SetCurlToolAcceptedRequestEncodings (web_conn_p -> wc_curl_p, accept_encoding_s);
+			success_flag = true;
+		}
+
+	return success_flag;
+}
+
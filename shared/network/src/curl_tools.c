@@ -63,6 +63,12 @@
 #include <curl/curl.h>
 #include <curl/easy.h>
 
+#include <zlib.h>
+
+#if ZSTD_ENABLED == 1
+	#include <zstd.h>
+#endif
+
 #include "jansson.h"
 
 #include "curl_tools.h"
@@ -70,6 +76,7 @@
 #include "memory_allocations.h"
 
 #include "string_utils.h"
+#include "tracing.h"
 #include "streams.h"
 
 
@@ -87,6 +94,53 @@ typedef struct CURLParam
 } CURLParam;
 
 
+/* The amount of the request body that is compressed at a time */
+#define COMPRESSED_REQUEST_BODY_INPUT_SIZE (16384)
+
+
+/*
+ * A request body that is compressed as curl reads it, so
+ * the compressed copy is never held in memory all at once.
+ */
+typedef struct CompressedRequestBody
+{
+	RopeBuffer *crb_body_p;
+
+	/* Either RE_GZIP or RE_ZSTD */
+	RequestEncoding crb_encoding;
+
+	z_stream crb_gzip_stream;
+
+	bool crb_gzip_initialised_flag;
+
+#if ZSTD_ENABLED == 1
+	ZSTD_CCtx *crb_zstd_context_p;
+
+	ZSTD_inBuffer crb_zstd_input;
+#endif
+
+	Bytef crb_input [COMPRESSED_REQUEST_BODY_INPUT_SIZE];
+
+	/* The amount of compressed data passed to curl so far */
+	size_t crb_compressed_size;
+
+	/* Has all of the request body been passed to the compressor? */
+	bool crb_input_finished_flag;
+
+	/* Has all of the compressed data been passed to curl? */
+	bool crb_output_finished_flag;
+} CompressedRequestBody;
+
+
+static const char * const S_GZIP_CONTENT_ENCODING_HEADER_S = "Content-Encoding: gzip";
+
+static const char * const S_ZSTD_CONTENT_ENCODING_HEADER_S = "Content-Encoding: zstd";
+
+static const char * const S_CHUNKED_TRANSFER_ENCODING_HEADER_S = "Transfer-Encoding: chunked";
+
+static const char * const S_ACCEPT_ENCODING_HEADER_S = "Accept-Encoding:";
+
+
 static size_t WriteMemoryCallback (char *response_data_p, size_t block_size, size_t num_blocks, void *store_p);
 
 static size_t WriteTempFileCallback (char *response_data_p, size_t block_size, size_t num_blocks, void *store_p);
@@ -99,6 +153,38 @@ static bool SetupCurlForMemoryCallback (CurlTool *tool_p, const size_t size);
 
 static bool SetupCurlForFileCallback (CurlTool *tool_p, const char * const filename_s);
 
+static size_t ReadRequestBodyCallback (char *dest_p, size_t block_size, size_t num_blocks, void *store_p);
+
+static int SeekRequestBodyCallback (void *store_p, curl_off_t offset, int origin);
+
+static bool SetCurlToolJSONRequestBody (CurlTool *tool_p, const json_t *req_p, RequestEncoding *encoding_p);
+
+static RequestEncoding GetCurlToolRequestEncoding (const CurlTool *tool_p);
+
+static bool SetCurlToolCompressedRequestBody (CurlTool *tool_p, const RequestEncoding encoding);
+
+static bool ResetCompressedRequestBody (CompressedRequestBody *body_p);
+
+static void FreeCompressedRequestBody (CompressedRequestBody *body_p);
+
+static size_t ReadCompressedRequestBodyCallback (char *dest_p, size_t block_size, size_t num_blocks, void *store_p);
+
+static size_t ReadCompressedRequestBodyInput (CompressedRequestBody *body_p);
+
+static size_t ReadGzipRequestBody (CompressedRequestBody *body_p, char *dest_p, const size_t max_length);
+
+#if ZSTD_ENABLED == 1
+static size_t ReadZstdRequestBody (CompressedRequestBody *body_p, char *dest_p, const size_t max_length);
+#endif
+
+static int SeekCompressedRequestBodyCallback (void *store_p, curl_off_t offset, int origin);
+
+static size_t ReadHeaderCallback (char *header_p, size_t block_size, size_t num_blocks, void *store_p);
+
+static uint32 GetAcceptedEncodings (const char *value_p, const size_t length);
+
+static bool HasZeroWeight (const char *param_p, const char *end_p);
+
 
 /**
  * Allocate a CurlTool.
@@ -153,6 +239,31 @@ void SetCurlToolVerbose (CurlTool *tool_p, const bool verbose_flag)
 }
 
 
+void SetCurlToolRequestCompression (CurlTool *tool_p, const bool compress_flag, const size_t threshold)
+{
+	tool_p -> ct_compress_requests_flag = compress_flag;
+	tool_p -> ct_compression_threshold = threshold;
+
+	/* Watch the response headers for the encodings that the server accepts */
+	if (compress_flag)
+		{
+			curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_HEADERFUNCTION, ReadHeaderCallback);
+			curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_HEADERDATA, tool_p);
+		}
+	else
+		{
+			curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_HEADERFUNCTION, NULL);
+			curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_HEADERDATA, NULL);
+		}
+}
+
+
+void SetCurlToolAcceptedRequestEncodings (CurlTool *tool_p, const char *accept_encoding_s)
+{
+	tool_p -> ct_accepted_encodings = GetAcceptedEncodings (accept_encoding_s, strlen (accept_encoding_s));
+}
+
+
 static CurlTool *AllocateCurlTool (CurlMode mode)
 {
 	CURL *curl_p = curl_easy_init ();
@@ -168,6 +279,11 @@ static CurlTool *AllocateCurlTool (CurlMode mode)
 					curl_tool_p -> ct_form_p = NULL;
 					curl_tool_p -> ct_last_field_p = NULL;
 					curl_tool_p -> ct_headers_list_p = NULL;
+					curl_tool_p -> ct_request_body_p = NULL;
+					curl_tool_p -> ct_compressed_body_p = NULL;
+					curl_tool_p -> ct_compression_threshold = CURL_TOOL_DEFAULT_COMPRESSION_THRESHOLD;
+					curl_tool_p -> ct_compress_requests_flag = false;
+					curl_tool_p -> ct_accepted_encodings = RE_IDENTITY;
 					curl_tool_p -> ct_temp_file_p = NULL;
 					curl_tool_p -> ct_mode = mode;
 					curl_tool_p -> ct_username_s = NULL;
@@ -193,6 +309,16 @@ void FreeCurlTool (CurlTool *curl_tool_p)
 			curl_slist_free_all (curl_tool_p -> ct_headers_list_p);
 		}
 
+	if (curl_tool_p -> ct_request_body_p)
+		{
+			FreeRopeBuffer (curl_tool_p -> ct_request_body_p);
+		}
+
+	if (curl_tool_p -> ct_compressed_body_p)
+		{
+			FreeCompressedRequestBody (curl_tool_p -> ct_compressed_body_p);
+		}
+
 	switch (curl_tool_p -> ct_mode)
 		{
 			case CM_MEMORY:
@@ -386,33 +512,103 @@ void ClearCurlToolData (CurlTool *tool_p)
 bool MakeRemoteJSONCallFromCurlTool (CurlTool *tool_p, const json_t *req_p)
 {
 	bool success_flag = false;
-	char *dump_s = json_dumps (req_p, 0);
+	RequestEncoding encoding = RE_IDENTITY;
 
-	if (dump_s)
+	if (SetCurlToolJSONRequestBody (tool_p, req_p, &encoding))
 		{
-			if (curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_POSTFIELDS, dump_s) == CURLE_OK)
+			CURLcode res;
+
+			/*
+			 * If the call is part of a trace, send the trace context in a
+			 * traceparent header and if the body is compressed, say so. These
+			 * are only for this call, so rather than adding them to the CurlTool's
+			 * headers, which are kept between calls on the same connection,
+			 * temporarily link them onto their end.
+			 */
+			char trace_parent_header_s [sizeof (TRACE_PARENT_HEADER_S) + 2 + TRACE_PARENT_BUFFER_SIZE];
+			struct curl_slist extra_headers [3];
+			uint32 num_extra_headers = 0;
+			struct curl_slist *last_header_p = NULL;
+			const bool had_headers_flag = (tool_p -> ct_headers_list_p != NULL);
+			bool extra_headers_flag = false;
+
+			strcpy (trace_parent_header_s, TRACE_PARENT_HEADER_S ": ");
+
+			if (GetTraceParent (trace_parent_header_s + sizeof (TRACE_PARENT_HEADER_S) + 1))
 				{
-					CURLcode res;
+					extra_headers [num_extra_headers ++].data = trace_parent_header_s;
+				}
 
-					/* if the buffer isn't empty, clear it */
-					ClearCurlToolData (tool_p);
+			if (encoding != RE_IDENTITY)
+				{
+					/* The compressed size isn't known until it has all been sent */
+					extra_headers [num_extra_headers ++].data = (char *) ((encoding == RE_ZSTD) ? S_ZSTD_CONTENT_ENCODING_HEADER_S : S_GZIP_CONTENT_ENCODING_HEADER_S);
+					extra_headers [num_extra_headers ++].data = (char *) S_CHUNKED_TRANSFER_ENCODING_HEADER_S;
+				}
 
-					res = RunCurlTool (tool_p);
+			if (num_extra_headers > 0)
+				{
+					uint32 i;
 
-					if (res == CURLE_OK)
+					for (i = 0; i < num_extra_headers; ++ i)
 						{
-							success_flag = true;
+							extra_headers [i].next = (i + 1 < num_extra_headers) ? (extra_headers + i + 1) : NULL;
+						}
+
+					if (had_headers_flag)
+						{
+							last_header_p = tool_p -> ct_headers_list_p;
+
+							while (last_header_p -> next)
+								{
+									last_header_p = last_header_p -> next;
+								}
+
+							last_header_p -> next = extra_headers;
 						}
 					else
 						{
-							const char *error_s = curl_easy_strerror (res);
+							tool_p -> ct_headers_list_p = extra_headers;
+						}
+
+					extra_headers_flag = true;
+				}
+
+			/* if the buffer isn't empty, clear it */
+			ClearCurlToolData (tool_p);
+
+			res = RunCurlTool (tool_p);
+
+			if (encoding != RE_IDENTITY)
+				{
+					PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Compressed request body from " SIZET_FMT " to " SIZET_FMT " bytes", GetRopeBufferSize (tool_p -> ct_request_body_p), tool_p -> ct_compressed_body_p -> crb_compressed_size);
+				}
 
-							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "RunCurlTool failed with code " UINT32_FMT ": %s\n", res, error_s ? error_s : "NULL");
+			if (extra_headers_flag)
+				{
+					if (last_header_p)
+						{
+							last_header_p -> next = NULL;
+						}
+					else
+						{
+							/* Don't leave curl pointing at the stack */
+							tool_p -> ct_headers_list_p = NULL;
+							curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_HTTPHEADER, NULL);
 						}
 				}
 
-			free (dump_s);
-		}		/* if (dump_s) */
+			if (res == CURLE_OK)
+				{
+					success_flag = true;
+				}
+			else
+				{
+					const char *error_s = curl_easy_strerror (res);
+
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "RunCurlTool failed with code " UINT32_FMT ": %s\n", res, error_s ? error_s : "NULL");
+				}
+		}		/* if (SetCurlToolJSONRequestBody (tool_p, req_p)) */
 
 	return success_flag;
 }
@@ -846,28 +1042,524 @@ static size_t WriteTempFileCallback (char *response_data_p, size_t block_size, s
 static size_t WriteMemoryCallback (char *response_data_p, size_t block_size, size_t num_blocks, void *store_p)
 {
 	size_t total_size = block_size * num_blocks;
-	size_t result = CURLE_OK;
 	ByteBuffer *buffer_p = (ByteBuffer *) store_p;
 
-	size_t remaining_space = GetRemainingSpaceInByteBuffer (buffer_p);
+	/*
+	 * AppendToByteBuffer () grows the buffer geometrically, so a response
+	 * that arrives in many chunks is not copied again for each one.
+	 * Returning anything other than total_size tells curl to abort.
+	 */
+	return AppendToByteBuffer (buffer_p, response_data_p, total_size) ? total_size : 0;
+}
+
+
+/*
+ * Serialise the request into the CurlTool's RopeBuffer and have curl
+ * read the body from it, rather than dumping the whole request into
+ * a single string for CURLOPT_POSTFIELDS.
+ */
+static bool SetCurlToolJSONRequestBody (CurlTool *tool_p, const json_t *req_p, RequestEncoding *encoding_p)
+{
+	bool success_flag = false;
+
+	*encoding_p = RE_IDENTITY;
+
+	if (tool_p -> ct_request_body_p)
+		{
+			ResetRopeBuffer (tool_p -> ct_request_body_p);
+		}
+	else
+		{
+			tool_p -> ct_request_body_p = AllocateRopeBuffer (0);
+		}
+
+	if (tool_p -> ct_request_body_p)
+		{
+			if (AppendJSONToRopeBuffer (tool_p -> ct_request_body_p, req_p, 0))
+				{
+					CURL *curl_p = tool_p -> ct_curl_p;
+
+					/*
+					 * Only compress the body if the server has said that it accepts
+					 * an encoding that we support and the body is big enough for it
+					 * to be worth doing.
+					 */
+					const RequestEncoding encoding = GetCurlToolRequestEncoding (tool_p);
+
+					if ((tool_p -> ct_compress_requests_flag) && (encoding != RE_IDENTITY) && (GetRopeBufferSize (tool_p -> ct_request_body_p) >= tool_p -> ct_compression_threshold))
+						{
+							if (SetCurlToolCompressedRequestBody (tool_p, encoding))
+								{
+									*encoding_p = encoding;
+									return true;
+								}
+
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to set up compressed request body, sending it uncompressed");
+						}
+
+					/* Make sure that any previous POSTFIELDS don't take precedence over the read callback */
+					if ((curl_easy_setopt (curl_p, CURLOPT_POSTFIELDS, NULL) == CURLE_OK) &&
+							(curl_easy_setopt (curl_p, CURLOPT_POST, 1L) == CURLE_OK) &&
+							(curl_easy_setopt (curl_p, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t) GetRopeBufferSize (tool_p -> ct_request_body_p)) == CURLE_OK) &&
+							(curl_easy_setopt (curl_p, CURLOPT_READFUNCTION, ReadRequestBodyCallback) == CURLE_OK) &&
+							(curl_easy_setopt (curl_p, CURLOPT_READDATA, tool_p -> ct_request_body_p) == CURLE_OK) &&
+							(curl_easy_setopt (curl_p, CURLOPT_SEEKFUNCTION, SeekRequestBodyCallback) == CURLE_OK) &&
+							(curl_easy_setopt (curl_p, CURLOPT_SEEKDATA, tool_p -> ct_request_body_p) == CURLE_OK))
+						{
+							success_flag = true;
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to set curl request body options");
+						}
+				}
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate RopeBuffer for request body");
+		}
+
+	return success_flag;
+}
+
+
+/*
+ * Choose the RequestEncoding for the next request body from
+ * those that the server accepts, preferring zstd.
+ */
+static RequestEncoding GetCurlToolRequestEncoding (const CurlTool *tool_p)
+{
+#if ZSTD_ENABLED == 1
+	if ((tool_p -> ct_accepted_encodings) & RE_ZSTD)
+		{
+			return RE_ZSTD;
+		}
+#endif
+
+	if ((tool_p -> ct_accepted_encodings) & RE_GZIP)
+		{
+			return RE_GZIP;
+		}
+
+	return RE_IDENTITY;
+}
+
 
-	if (remaining_space < total_size)
+static bool SetCurlToolCompressedRequestBody (CurlTool *tool_p, const RequestEncoding encoding)
+{
+	CompressedRequestBody *body_p = tool_p -> ct_compressed_body_p;
+
+	if (!body_p)
 		{
-			if (!ExtendByteBuffer (buffer_p, total_size - remaining_space + 1))
+			body_p = (CompressedRequestBody *) AllocMemory (sizeof (CompressedRequestBody));
+
+			if (!body_p)
 				{
-					result = CURLE_OUT_OF_MEMORY;
+					return false;
 				}
+
+			memset (body_p, 0, sizeof (CompressedRequestBody));
+			tool_p -> ct_compressed_body_p = body_p;
 		}
 
-	if (result == CURLE_OK)
+	body_p -> crb_body_p = tool_p -> ct_request_body_p;
+	body_p -> crb_encoding = encoding;
+
+	if (!ResetCompressedRequestBody (body_p))
 		{
-			if (AppendToByteBuffer (buffer_p, response_data_p, total_size))
+			return false;
+		}
+
+	if ((curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_POSTFIELDS, NULL) == CURLE_OK) &&
+			(curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_POST, 1L) == CURLE_OK) &&
+			(curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t) -1) == CURLE_OK) &&
+			(curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_READFUNCTION, ReadCompressedRequestBodyCallback) == CURLE_OK) &&
+			(curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_READDATA, body_p) == CURLE_OK) &&
+			(curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_SEEKFUNCTION, SeekCompressedRequestBodyCallback) == CURLE_OK) &&
+			(curl_easy_setopt (tool_p -> ct_curl_p, CURLOPT_SEEKDATA, body_p) == CURLE_OK))
+		{
+			return true;
+		}
+
+	return false;
+}
+
+
+/*
+ * Get the compressor for the body's RequestEncoding ready to
+ * start again from the beginning of the body.
+ */
+static bool ResetCompressedRequestBody (CompressedRequestBody *body_p)
+{
+	bool success_flag = false;
+
+	if (body_p -> crb_encoding == RE_GZIP)
+		{
+			z_stream *stream_p = & (body_p -> crb_gzip_stream);
+
+			if (body_p -> crb_gzip_initialised_flag)
+				{
+					success_flag = (deflateReset (stream_p) == Z_OK);
+				}
+			else
 				{
-					result = total_size;
+					memset (stream_p, 0, sizeof (z_stream));
+
+					/* Adding 16 to the window bits writes a gzip header and trailer rather than a zlib one */
+					if (deflateInit2 (stream_p, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+						{
+							body_p -> crb_gzip_initialised_flag = true;
+							success_flag = true;
+						}
 				}
+
+			stream_p -> next_in = body_p -> crb_input;
+			stream_p -> avail_in = 0;
 		}
-	
-	return result;
+#if ZSTD_ENABLED == 1
+	else if (body_p -> crb_encoding == RE_ZSTD)
+		{
+			if (body_p -> crb_zstd_context_p)
+				{
+					success_flag = !ZSTD_isError (ZSTD_CCtx_reset (body_p -> crb_zstd_context_p, ZSTD_reset_session_only));
+				}
+			else
+				{
+					body_p -> crb_zstd_context_p = ZSTD_createCCtx ();
+					success_flag = (body_p -> crb_zstd_context_p != NULL);
+				}
+
+			body_p -> crb_zstd_input.src = body_p -> crb_input;
+			body_p -> crb_zstd_input.size = 0;
+			body_p -> crb_zstd_input.pos = 0;
+		}
+#endif
+
+	if (success_flag)
+		{
+			RewindRopeBuffer (body_p -> crb_body_p);
+
+			body_p -> crb_compressed_size = 0;
+			body_p -> crb_input_finished_flag = false;
+			body_p -> crb_output_finished_flag = false;
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to reset the compressor for request encoding %d", body_p -> crb_encoding);
+		}
+
+	return success_flag;
+}
+
+
+static void FreeCompressedRequestBody (CompressedRequestBody *body_p)
+{
+	if (body_p -> crb_gzip_initialised_flag)
+		{
+			deflateEnd (& (body_p -> crb_gzip_stream));
+		}
+
+#if ZSTD_ENABLED == 1
+	ZSTD_freeCCtx (body_p -> crb_zstd_context_p);
+#endif
+
+	FreeMemory (body_p);
+}
+
+
+/*
+ * Compress the next part of the request body straight into curl's
+ * buffer, reading more of the body whenever the compressor needs it.
+ */
+static size_t ReadCompressedRequestBodyCallback (char *dest_p, size_t block_size, size_t num_blocks, void *store_p)
+{
+	CompressedRequestBody *body_p = (CompressedRequestBody *) store_p;
+	const size_t max_length = block_size * num_blocks;
+	size_t length = CURL_READFUNC_ABORT;
+
+	if (body_p -> crb_encoding == RE_GZIP)
+		{
+			length = ReadGzipRequestBody (body_p, dest_p, max_length);
+		}
+#if ZSTD_ENABLED == 1
+	else if (body_p -> crb_encoding == RE_ZSTD)
+		{
+			length = ReadZstdRequestBody (body_p, dest_p, max_length);
+		}
+#endif
+
+	if (length != CURL_READFUNC_ABORT)
+		{
+			body_p -> crb_compressed_size += length;
+		}
+
+	return length;
+}
+
+
+static size_t ReadCompressedRequestBodyInput (CompressedRequestBody *body_p)
+{
+	const size_t input_length = ReadFromRopeBuffer (body_p -> crb_body_p, body_p -> crb_input, COMPRESSED_REQUEST_BODY_INPUT_SIZE);
+
+	if (input_length == 0)
+		{
+			body_p -> crb_input_finished_flag = true;
+		}
+
+	return input_length;
+}
+
+
+static size_t ReadGzipRequestBody (CompressedRequestBody *body_p, char *dest_p, const size_t max_length)
+{
+	z_stream *stream_p = & (body_p -> crb_gzip_stream);
+
+	stream_p -> next_out = (Bytef *) dest_p;
+	stream_p -> avail_out = (uInt) max_length;
+
+	while ((stream_p -> avail_out > 0) && (! (body_p -> crb_output_finished_flag)))
+		{
+			int res;
+
+			if ((stream_p -> avail_in == 0) && (! (body_p -> crb_input_finished_flag)))
+				{
+					stream_p -> avail_in = (uInt) ReadCompressedRequestBodyInput (body_p);
+					stream_p -> next_in = body_p -> crb_input;
+				}
+
+			res = deflate (stream_p, (body_p -> crb_input_finished_flag) ? Z_FINISH : Z_NO_FLUSH);
+
+			if (res == Z_STREAM_END)
+				{
+					body_p -> crb_output_finished_flag = true;
+				}
+			else if ((res != Z_OK) && (res != Z_BUF_ERROR))
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "deflate () failed with %d", res);
+					return CURL_READFUNC_ABORT;
+				}
+		}
+
+	return max_length - (stream_p -> avail_out);
+}
+
+
+#if ZSTD_ENABLED == 1
+static size_t ReadZstdRequestBody (CompressedRequestBody *body_p, char *dest_p, const size_t max_length)
+{
+	ZSTD_inBuffer *input_p = & (body_p -> crb_zstd_input);
+	ZSTD_outBuffer output;
+
+	output.dst = dest_p;
+	output.size = max_length;
+	output.pos = 0;
+
+	while ((output.pos < output.size) && (! (body_p -> crb_output_finished_flag)))
+		{
+			size_t res;
+
+			if ((input_p -> pos == input_p -> size) && (! (body_p -> crb_input_finished_flag)))
+				{
+					input_p -> size = ReadCompressedRequestBodyInput (body_p);
+					input_p -> pos = 0;
+				}
+
+			/* With ZSTD_e_end, the result is the amount still to be flushed */
+			res = ZSTD_compressStream2 (body_p -> crb_zstd_context_p, &output, input_p, (body_p -> crb_input_finished_flag) ? ZSTD_e_end : ZSTD_e_continue);
+
+			if (ZSTD_isError (res))
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "ZSTD_compressStream2 () failed: %s", ZSTD_getErrorName (res));
+					return CURL_READFUNC_ABORT;
+				}
+			else if ((res == 0) && (body_p -> crb_input_finished_flag))
+				{
+					body_p -> crb_output_finished_flag = true;
+				}
+		}
+
+	return output.pos;
+}
+#endif
+
+
+static int SeekCompressedRequestBodyCallback (void *store_p, curl_off_t offset, int origin)
+{
+	int res = CURL_SEEKFUNC_CANTSEEK;
+
+	if ((origin == SEEK_SET) && (offset == 0))
+		{
+			CompressedRequestBody *body_p = (CompressedRequestBody *) store_p;
+
+			res = ResetCompressedRequestBody (body_p) ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+		}
+
+	return res;
+}
+
+
+static size_t ReadHeaderCallback (char *header_p, size_t block_size, size_t num_blocks, void *store_p)
+{
+	const size_t length = block_size * num_blocks;
+	const size_t key_length = strlen (S_ACCEPT_ENCODING_HEADER_S);
+
+	if ((length > key_length) && (Strnicmp (header_p, S_ACCEPT_ENCODING_HEADER_S, key_length) == 0))
+		{
+			CurlTool *tool_p = (CurlTool *) store_p;
+
+			tool_p -> ct_accepted_encodings = GetAcceptedEncodings (header_p + key_length, length - key_length);
+
+#if CURL_TOOLS_DEBUG >= STM_LEVEL_FINE
+			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Server accepts request encodings %x", tool_p -> ct_accepted_encodings);
+#endif
+		}
+
+	return length;
+}
+
+
+/*
+ * Get the RequestEncodings in an Accept-Encoding value, which isn't
+ * NULL-terminated, that haven't been given a weight of 0. A "*" coding
+ * accepts any encoding that isn't listed separately.
+ */
+static uint32 GetAcceptedEncodings (const char *value_p, const size_t length)
+{
+	const char *end_p = value_p + length;
+	uint32 accepted_encodings = RE_IDENTITY;
+	uint32 listed_encodings = RE_IDENTITY;
+	bool wildcard_flag = false;
+
+	while (value_p < end_p)
+		{
+			const char *coding_end_p;
+			size_t coding_length;
+			uint32 encoding = RE_IDENTITY;
+			bool wildcard_coding_flag = false;
+
+			while ((value_p < end_p) && ((*value_p == ' ') || (*value_p == '\t') || (*value_p == ',')))
+				{
+					++ value_p;
+				}
+
+			coding_end_p = value_p;
+
+			while ((coding_end_p < end_p) && (*coding_end_p != ',') && (*coding_end_p != ';') && (*coding_end_p != ' ') && (*coding_end_p != '\t') && (*coding_end_p != '\r') && (*coding_end_p != '\n'))
+				{
+					++ coding_end_p;
+				}
+
+			coding_length = coding_end_p - value_p;
+
+			if ((coding_length == 4) && (Strnicmp (value_p, "gzip", 4) == 0))
+				{
+					encoding = RE_GZIP;
+				}
+			else if ((coding_length == 4) && (Strnicmp (value_p, "zstd", 4) == 0))
+				{
+					encoding = RE_ZSTD;
+				}
+			else if ((coding_length == 1) && (*value_p == '*'))
+				{
+					wildcard_coding_flag = true;
+				}
+
+			if ((encoding != RE_IDENTITY) || wildcard_coding_flag)
+				{
+					const bool accepted_flag = !HasZeroWeight (coding_end_p, end_p);
+
+					if (wildcard_coding_flag)
+						{
+							wildcard_flag = accepted_flag;
+						}
+					else
+						{
+							listed_encodings |= encoding;
+
+							if (accepted_flag)
+								{
+									accepted_encodings |= encoding;
+								}
+						}
+				}
+
+			value_p = coding_end_p;
+
+			while ((value_p < end_p) && (*value_p != ','))
+				{
+					++ value_p;
+				}
+		}
+
+	if (wildcard_flag)
+		{
+			accepted_encodings |= (RE_GZIP | RE_ZSTD) & ~listed_encodings;
+		}
+
+	return accepted_encodings;
+}
+
+
+/*
+ * Look through the parameters of a coding in an Accept-Encoding value
+ * for a weight of q=0, q=0.0, etc.
+ */
+static bool HasZeroWeight (const char *param_p, const char *end_p)
+{
+	bool zero_weight_flag = false;
+
+	while ((param_p < end_p) && (*param_p != ','))
+		{
+			if (((*param_p == 'q') || (*param_p == 'Q')) && (param_p + 2 < end_p) && (param_p [1] == '=') && (param_p [2] == '0'))
+				{
+					const char *digit_p = param_p + 3;
+
+					zero_weight_flag = true;
+
+					if ((digit_p < end_p) && (*digit_p == '.'))
+						{
+							++ digit_p;
+
+							while ((digit_p < end_p) && (*digit_p >= '0') && (*digit_p <= '9'))
+								{
+									if (*digit_p != '0')
+										{
+											zero_weight_flag = false;
+										}
+
+									++ digit_p;
+								}
+						}
+				}
+
+			++ param_p;
+		}
+
+	return zero_weight_flag;
+}
+
+
+static size_t ReadRequestBodyCallback (char *dest_p, size_t block_size, size_t num_blocks, void *store_p)
+{
+	return ReadFromRopeBuffer ((RopeBuffer *) store_p, dest_p, block_size * num_blocks);
+}
+
+
+/*
+ * curl may need to send the body again, e.g. after an authentication
+ * challenge or a redirect, so let it go back to the start.
+ */
+static int SeekRequestBodyCallback (void *store_p, curl_off_t offset, int origin)
+{
+	int res = CURL_SEEKFUNC_CANTSEEK;
+
+	if ((origin == SEEK_SET) && (offset == 0))
+		{
+			RewindRopeBuffer ((RopeBuffer *) store_p);
+			res = CURL_SEEKFUNC_OK;
+		}
+
+	return res;
 }
 
 
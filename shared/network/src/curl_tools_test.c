@@ -0,0 +1,1005 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * curl_tools_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the compression of CurlTool request bodies against a stub
+ *  http server on localhost. The stub records the Content-Encoding and
+ *  size of each request body, decodes it and sends back an Accept-Encoding
+ *  header of the test's choosing. The tests check the parsing of
+ *  Accept-Encoding values, that requests are only compressed once the
+ *  server accepts it and when they are over the threshold, that compressed
+ *  bodies are sent again intact after a redirect and that compressed
+ *  responses are decoded.
+ *
+ *  Usage: curl_tools_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <zlib.h>
+
+#if ZSTD_ENABLED == 1
+	#include <zstd.h>
+#endif
+
+#include "jansson.h"
+
+#include "curl_tools.h"
+#include "unit_test.h"
+
+
+/* The number of entries in the large test request */
+#define NUM_LARGE_REQUEST_ENTRIES (500)
+
+#define THRESHOLD (1024)
+
+
+/* The encoding that is used when the server accepts both gzip and zstd */
+#if ZSTD_ENABLED == 1
+	#define PREFERRED_ENCODING_S "zstd"
+#else
+	#define PREFERRED_ENCODING_S "gzip"
+#endif
+
+
+/*
+ * What the stub server saw in the last request that it was sent and
+ * how it should respond.
+ */
+typedef struct StubServer
+{
+	int ss_listen_fd;
+
+	int ss_port;
+
+	pthread_t ss_thread;
+
+	pthread_mutex_t ss_mutex;
+
+	/* The value of the Accept-Encoding header to send or NULL for none */
+	const char *ss_accept_encoding_s;
+
+	/* Should responses be gzip-compressed if the client accepts it? */
+	bool ss_compress_responses_flag;
+
+	uint32 ss_num_requests;
+
+	char ss_content_encoding_s [32];
+
+	/* The size of the body as it was sent */
+	size_t ss_body_size;
+
+	/* The decoded body */
+	char *ss_body_s;
+
+	bool ss_decoded_flag;
+
+	bool ss_response_compressed_flag;
+} StubServer;
+
+
+static StubServer s_server;
+
+
+static char *ReadRequest (int fd, size_t *header_length_p, size_t *length_p);
+
+static char *GetHeaderValue (const char *headers_s, const char *key_s, char *value_s, const size_t value_size);
+
+static bool ReadBody (int fd, char **buffer_ss, size_t *length_p, const size_t header_length, unsigned char **body_pp, size_t *body_size_p);
+
+static bool Decode (const char *encoding_s, const unsigned char *data_p, const size_t size, char **decoded_ss);
+
+
+
+static bool SendAll (int fd, const void *data_p, size_t length)
+{
+	const char *buffer_p = (const char *) data_p;
+
+	while (length > 0)
+		{
+			ssize_t res = send (fd, buffer_p, length, MSG_NOSIGNAL);
+
+			if (res <= 0)
+				{
+					return false;
+				}
+
+			buffer_p += res;
+			length -= (size_t) res;
+		}
+
+	return true;
+}
+
+
+static bool GzipData (const char *data_s, const size_t length, unsigned char **compressed_pp, size_t *compressed_size_p)
+{
+	z_stream stream;
+	bool success_flag = false;
+
+	memset (&stream, 0, sizeof (stream));
+
+	if (deflateInit2 (&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+		{
+			const size_t bound = deflateBound (&stream, length);
+			unsigned char *compressed_p = (unsigned char *) malloc (bound);
+
+			if (compressed_p)
+				{
+					stream.next_in = (Bytef *) data_s;
+					stream.avail_in = (uInt) length;
+					stream.next_out = compressed_p;
+					stream.avail_out = (uInt) bound;
+
+					if (deflate (&stream, Z_FINISH) == Z_STREAM_END)
+						{
+							*compressed_pp = compressed_p;
+							*compressed_size_p = stream.total_out;
+							success_flag = true;
+						}
+					else
+						{
+							free (compressed_p);
+						}
+				}
+
+			deflateEnd (&stream);
+		}
+
+	return success_flag;
+}
+
+
+static void SendResponse (int fd, const char *path_s, const char *request_accept_encoding_s)
+{
+	char headers_s [1024];
+	char accept_encoding_s [128];
+	char body_s [4096];
+	const char *response_p = body_s;
+	size_t response_size;
+	unsigned char *compressed_p = NULL;
+	bool compressed_flag = false;
+	int i;
+
+	/* A response that is worth compressing */
+	strcpy (body_s, "{\"status\": \"ok\", \"padding\": \"");
+
+	for (i = strlen (body_s); i < (int) sizeof (body_s) - 4; ++ i)
+		{
+			body_s [i] = 'a' + (i % 4);
+		}
+
+	strcpy (body_s + i, "\"}");
+	response_size = strlen (body_s);
+
+	pthread_mutex_lock (& (s_server.ss_mutex));
+
+	if (s_server.ss_accept_encoding_s)
+		{
+			snprintf (accept_encoding_s, sizeof (accept_encoding_s), "Accept-Encoding: %s\r\n", s_server.ss_accept_encoding_s);
+		}
+	else
+		{
+			*accept_encoding_s = '\0';
+		}
+
+	if (s_server.ss_compress_responses_flag && request_accept_encoding_s && strstr (request_accept_encoding_s, "gzip"))
+		{
+			compressed_flag = GzipData (body_s, response_size, &compressed_p, &response_size);
+
+			if (compressed_flag)
+				{
+					response_p = (const char *) compressed_p;
+				}
+		}
+
+	s_server.ss_response_compressed_flag = compressed_flag;
+
+	pthread_mutex_unlock (& (s_server.ss_mutex));
+
+	if (strcmp (path_s, "/redirect") == 0)
+		{
+			snprintf (headers_s, sizeof (headers_s), "HTTP/1.1 307 Temporary Redirect\r\nLocation: /echo\r\n%sContent-Length: 0\r\nConnection: close\r\n\r\n", accept_encoding_s);
+			SendAll (fd, headers_s, strlen (headers_s));
+		}
+	else
+		{
+			snprintf (headers_s, sizeof (headers_s), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n%s%sContent-Length: " UINT32_FMT "\r\nConnection: close\r\n\r\n", accept_encoding_s, compressed_flag ? "Content-Encoding: gzip\r\n" : "", (uint32) response_size);
+
+			if (SendAll (fd, headers_s, strlen (headers_s)))
+				{
+					SendAll (fd, response_p, response_size);
+				}
+		}
+
+	if (compressed_p)
+		{
+			free (compressed_p);
+		}
+}
+
+
+static void HandleConnection (int fd)
+{
+	size_t header_length;
+	size_t length;
+	char *buffer_s = ReadRequest (fd, &header_length, &length);
+
+	if (buffer_s)
+		{
+			unsigned char *body_p = NULL;
+			size_t body_size = 0;
+			char path_s [64];
+			char content_encoding_s [32];
+			char request_accept_encoding_s [128];
+			char *decoded_s = NULL;
+			bool decoded_flag = false;
+
+			if (sscanf (buffer_s, "POST %63s", path_s) != 1)
+				{
+					*path_s = '\0';
+				}
+
+			GetHeaderValue (buffer_s, "Content-Encoding", content_encoding_s, sizeof (content_encoding_s));
+			GetHeaderValue (buffer_s, "Accept-Encoding", request_accept_encoding_s, sizeof (request_accept_encoding_s));
+
+			if (ReadBody (fd, &buffer_s, &length, header_length, &body_p, &body_size))
+				{
+					decoded_flag = Decode (content_encoding_s, body_p, body_size, &decoded_s);
+				}
+
+			pthread_mutex_lock (& (s_server.ss_mutex));
+
+			++ (s_server.ss_num_requests);
+			strcpy (s_server.ss_content_encoding_s, content_encoding_s);
+			s_server.ss_body_size = body_size;
+			s_server.ss_decoded_flag = decoded_flag;
+
+			if (s_server.ss_body_s)
+				{
+					free (s_server.ss_body_s);
+				}
+
+			s_server.ss_body_s = decoded_s;
+
+			pthread_mutex_unlock (& (s_server.ss_mutex));
+
+			SendResponse (fd, path_s, request_accept_encoding_s);
+
+			if (body_p)
+				{
+					free (body_p);
+				}
+
+			free (buffer_s);
+		}
+}
+
+
+static void *RunStubServer (void * UNUSED_PARAM (data_p))
+{
+	int fd;
+
+	while ((fd = accept (s_server.ss_listen_fd, NULL, NULL)) >= 0)
+		{
+			HandleConnection (fd);
+			close (fd);
+		}
+
+	return NULL;
+}
+
+
+static bool StartStubServer (void)
+{
+	memset (&s_server, 0, sizeof (s_server));
+	pthread_mutex_init (& (s_server.ss_mutex), NULL);
+
+	s_server.ss_listen_fd = socket (AF_INET, SOCK_STREAM, 0);
+
+	if (s_server.ss_listen_fd >= 0)
+		{
+			struct sockaddr_in addr;
+			socklen_t addr_length = sizeof (addr);
+
+			memset (&addr, 0, sizeof (addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+			addr.sin_port = 0;
+
+			if ((bind (s_server.ss_listen_fd, (struct sockaddr *) &addr, sizeof (addr)) == 0) &&
+					(listen (s_server.ss_listen_fd, 8) == 0) &&
+					(getsockname (s_server.ss_listen_fd, (struct sockaddr *) &addr, &addr_length) == 0))
+				{
+					s_server.ss_port = ntohs (addr.sin_port);
+
+					if (pthread_create (& (s_server.ss_thread), NULL, RunStubServer, NULL) == 0)
+						{
+							return true;
+						}
+				}
+
+			close (s_server.ss_listen_fd);
+		}
+
+	return false;
+}
+
+
+static void StopStubServer (void)
+{
+	shutdown (s_server.ss_listen_fd, SHUT_RDWR);
+	close (s_server.ss_listen_fd);
+	pthread_join (s_server.ss_thread, NULL);
+
+	if (s_server.ss_body_s)
+		{
+			free (s_server.ss_body_s);
+		}
+
+	pthread_mutex_destroy (& (s_server.ss_mutex));
+}
+
+
+static void SetStubServerAcceptEncoding (const char *accept_encoding_s, const bool compress_responses_flag)
+{
+	pthread_mutex_lock (& (s_server.ss_mutex));
+	s_server.ss_accept_encoding_s = accept_encoding_s;
+	s_server.ss_compress_responses_flag = compress_responses_flag;
+	pthread_mutex_unlock (& (s_server.ss_mutex));
+}
+
+
+/*
+ * Read from the socket until the end of the headers and return
+ * everything read so far.
+ */
+static char *ReadRequest (int fd, size_t *header_length_p, size_t *length_p)
+{
+	size_t size = 4096;
+	size_t length = 0;
+	char *buffer_s = (char *) malloc (size + 1);
+
+	while (buffer_s)
+		{
+			ssize_t res;
+			char *end_s;
+
+			buffer_s [length] = '\0';
+			end_s = strstr (buffer_s, "\r\n\r\n");
+
+			if (end_s)
+				{
+					*header_length_p = (end_s + 4) - buffer_s;
+					*length_p = length;
+					return buffer_s;
+				}
+
+			if (length == size)
+				{
+					char *new_buffer_s = (char *) realloc (buffer_s, (size *= 2) + 1);
+
+					if (!new_buffer_s)
+						{
+							break;
+						}
+
+					buffer_s = new_buffer_s;
+				}
+
+			res = recv (fd, buffer_s + length, size - length, 0);
+
+			if (res <= 0)
+				{
+					break;
+				}
+
+			length += (size_t) res;
+		}
+
+	if (buffer_s)
+		{
+			free (buffer_s);
+		}
+
+	return NULL;
+}
+
+
+static char *GetHeaderValue (const char *headers_s, const char *key_s, char *value_s, const size_t value_size)
+{
+	const size_t key_length = strlen (key_s);
+	const char *line_s = strstr (headers_s, "\r\n");
+
+	*value_s = '\0';
+
+	while (line_s && (strncmp (line_s, "\r\n\r\n", 4) != 0))
+		{
+			line_s += 2;
+
+			if ((strncasecmp (line_s, key_s, key_length) == 0) && (line_s [key_length] == ':'))
+				{
+					const char *start_s = line_s + key_length + 1;
+					const char *end_s = strstr (start_s, "\r\n");
+					size_t length;
+
+					while (*start_s == ' ')
+						{
+							++ start_s;
+						}
+
+					length = end_s - start_s;
+
+					if (length >= value_size)
+						{
+							length = value_size - 1;
+						}
+
+					memcpy (value_s, start_s, length);
+					value_s [length] = '\0';
+
+					return value_s;
+				}
+
+			line_s = strstr (line_s, "\r\n");
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Make sure that the buffer holds at least required_length bytes
+ * after the headers, reading more from the socket if needed.
+ */
+static bool FillBuffer (int fd, char **buffer_ss, size_t *length_p, const size_t required_length)
+{
+	while (*length_p < required_length)
+		{
+			ssize_t res;
+			char *new_buffer_s = (char *) realloc (*buffer_ss, required_length + 1);
+
+			if (!new_buffer_s)
+				{
+					return false;
+				}
+
+			*buffer_ss = new_buffer_s;
+
+			res = recv (fd, *buffer_ss + *length_p, required_length - *length_p, 0);
+
+			if (res <= 0)
+				{
+					return false;
+				}
+
+			*length_p += (size_t) res;
+		}
+
+	return true;
+}
+
+
+static bool ReadBody (int fd, char **buffer_ss, size_t *length_p, const size_t header_length, unsigned char **body_pp, size_t *body_size_p)
+{
+	char value_s [64];
+	unsigned char *body_p = NULL;
+	size_t body_size = 0;
+
+	if (GetHeaderValue (*buffer_ss, "Content-Length", value_s, sizeof (value_s)))
+		{
+			body_size = strtoul (value_s, NULL, 10);
+
+			if (FillBuffer (fd, buffer_ss, length_p, header_length + body_size))
+				{
+					body_p = (unsigned char *) malloc (body_size + 1);
+
+					if (body_p)
+						{
+							memcpy (body_p, *buffer_ss + header_length, body_size);
+						}
+				}
+		}
+	else if (GetHeaderValue (*buffer_ss, "Transfer-Encoding", value_s, sizeof (value_s)) && (strcmp (value_s, "chunked") == 0))
+		{
+			size_t offset = header_length;
+
+			body_p = (unsigned char *) malloc (1);
+
+			while (body_p)
+				{
+					char *end_s;
+					size_t chunk_size;
+
+					/* Read at least the chunk size line */
+					(*buffer_ss) [*length_p] = '\0';
+
+					while ((end_s = strstr (*buffer_ss + offset, "\r\n")) == NULL)
+						{
+							if (!FillBuffer (fd, buffer_ss, length_p, *length_p + 1))
+								{
+									free (body_p);
+									return false;
+								}
+
+							(*buffer_ss) [*length_p] = '\0';
+						}
+
+					chunk_size = strtoul (*buffer_ss + offset, NULL, 16);
+					offset = (end_s + 2) - *buffer_ss;
+
+					if (!FillBuffer (fd, buffer_ss, length_p, offset + chunk_size + 2))
+						{
+							free (body_p);
+							return false;
+						}
+
+					if (chunk_size == 0)
+						{
+							break;
+						}
+					else
+						{
+							unsigned char *new_body_p = (unsigned char *) realloc (body_p, body_size + chunk_size + 1);
+
+							if (!new_body_p)
+								{
+									free (body_p);
+									return false;
+								}
+
+							body_p = new_body_p;
+							memcpy (body_p + body_size, *buffer_ss + offset, chunk_size);
+							body_size += chunk_size;
+							offset += chunk_size + 2;
+						}
+				}
+		}
+
+	*body_pp = body_p;
+	*body_size_p = body_size;
+
+	return (body_p != NULL);
+}
+
+
+static bool Decode (const char *encoding_s, const unsigned char *data_p, const size_t size, char **decoded_ss)
+{
+	if (*encoding_s == '\0')
+		{
+			char *decoded_s = (char *) malloc (size + 1);
+
+			if (decoded_s)
+				{
+					memcpy (decoded_s, data_p, size);
+					decoded_s [size] = '\0';
+					*decoded_ss = decoded_s;
+
+					return true;
+				}
+		}
+	else if (strcmp (encoding_s, "gzip") == 0)
+		{
+			z_stream stream;
+			size_t decoded_size = 4 * size + 1;
+			char *decoded_s = (char *) malloc (decoded_size);
+			int res = Z_OK;
+
+			memset (&stream, 0, sizeof (stream));
+
+			if (decoded_s && (inflateInit2 (&stream, 15 + 16) == Z_OK))
+				{
+					stream.next_in = (Bytef *) data_p;
+					stream.avail_in = (uInt) size;
+
+					while (res == Z_OK)
+						{
+							if (stream.total_out + 1 >= decoded_size)
+								{
+									char *new_decoded_s = (char *) realloc (decoded_s, decoded_size *= 2);
+
+									if (!new_decoded_s)
+										{
+											break;
+										}
+
+									decoded_s = new_decoded_s;
+								}
+
+							stream.next_out = (Bytef *) (decoded_s + stream.total_out);
+							stream.avail_out = (uInt) (decoded_size - 1 - stream.total_out);
+
+							res = inflate (&stream, Z_NO_FLUSH);
+						}
+
+					inflateEnd (&stream);
+
+					if (res == Z_STREAM_END)
+						{
+							decoded_s [stream.total_out] = '\0';
+							*decoded_ss = decoded_s;
+
+							return true;
+						}
+				}
+
+			if (decoded_s)
+				{
+					free (decoded_s);
+				}
+		}
+#if ZSTD_ENABLED == 1
+	else if (strcmp (encoding_s, "zstd") == 0)
+		{
+			ZSTD_DCtx *context_p = ZSTD_createDCtx ();
+			ZSTD_inBuffer input = { data_p, size, 0 };
+			ZSTD_outBuffer output = { NULL, 4 * size, 0 };
+			size_t res = 1;
+
+			output.dst = malloc (output.size + 1);
+
+			if (context_p && output.dst)
+				{
+					/* Stop when the frame has been decoded or the input has run out */
+					while ((res != 0) && !ZSTD_isError (res) && ((input.pos < input.size) || (output.pos == output.size)))
+						{
+							if (output.pos == output.size)
+								{
+									void *new_dst_p = realloc (output.dst, (output.size *= 2) + 1);
+
+									if (!new_dst_p)
+										{
+											break;
+										}
+
+									output.dst = new_dst_p;
+								}
+
+							res = ZSTD_decompressStream (context_p, &output, &input);
+						}
+
+					if (res == 0)
+						{
+							((char *) output.dst) [output.pos] = '\0';
+							*decoded_ss = (char *) output.dst;
+							output.dst = NULL;
+						}
+				}
+
+			if (output.dst)
+				{
+					free (output.dst);
+				}
+
+			ZSTD_freeDCtx (context_p);
+
+			return (res == 0);
+		}
+#endif
+
+	return false;
+}
+
+
+static json_t *CreateRequest (const uint32 num_entries)
+{
+	json_t *req_p = json_object ();
+
+	if (req_p)
+		{
+			json_t *entries_p = json_array ();
+
+			if (entries_p)
+				{
+					if (json_object_set_new (req_p, "entries", entries_p) == 0)
+						{
+							uint32 i;
+
+							for (i = 0; i < num_entries; ++ i)
+								{
+									if (json_array_append_new (entries_p, json_pack ("{s:i,s:s}", "index", i, "text", "a result that is repeated in every entry")) != 0)
+										{
+											json_decref (req_p);
+											return NULL;
+										}
+								}
+
+							return req_p;
+						}
+
+					json_decref (entries_p);
+				}
+
+			json_decref (req_p);
+		}
+
+	return NULL;
+}
+
+
+static CurlTool *CreateCurlTool (const char *path_s)
+{
+	CurlTool *tool_p = AllocateMemoryCurlTool (0);
+
+	if (tool_p)
+		{
+			char uri_s [128];
+
+			snprintf (uri_s, sizeof (uri_s), "http://127.0.0.1:%d%s", s_server.ss_port, path_s);
+
+			if (SetUriForCurlTool (tool_p, uri_s) && SetCurlToolForJSONPost (tool_p))
+				{
+					SetCurlToolRequestCompression (tool_p, true, THRESHOLD);
+
+					return tool_p;
+				}
+
+			FreeCurlTool (tool_p);
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Send a request and check that the stub server got it intact with
+ * the expected Content-Encoding.
+ */
+static bool SendRequest (CurlTool *tool_p, const json_t *req_p, const char *expected_encoding_s, const uint32 expected_num_requests)
+{
+	bool success_flag = false;
+
+	pthread_mutex_lock (& (s_server.ss_mutex));
+	s_server.ss_num_requests = 0;
+	pthread_mutex_unlock (& (s_server.ss_mutex));
+
+	if (MakeRemoteJSONCallFromCurlTool (tool_p, req_p))
+		{
+			pthread_mutex_lock (& (s_server.ss_mutex));
+
+			if ((s_server.ss_num_requests == expected_num_requests) && (strcmp (s_server.ss_content_encoding_s, expected_encoding_s) == 0) && (s_server.ss_decoded_flag))
+				{
+					json_t *received_p = json_loads (s_server.ss_body_s, 0, NULL);
+
+					if (received_p)
+						{
+							success_flag = (json_equal (received_p, (json_t *) req_p) != 0);
+							json_decref (received_p);
+						}
+				}
+			else
+				{
+					printf ("got " UINT32_FMT " requests with Content-Encoding \"%s\"\n", s_server.ss_num_requests, s_server.ss_content_encoding_s);
+				}
+
+			pthread_mutex_unlock (& (s_server.ss_mutex));
+		}
+
+	return success_flag;
+}
+
+
+static void TestAcceptEncodingParsing (void)
+{
+	CurlTool *tool_p = AllocateMemoryCurlTool (0);
+
+	if (tool_p)
+		{
+			SetCurlToolAcceptedRequestEncodings (tool_p, "gzip");
+			Check (tool_p -> ct_accepted_encodings == RE_GZIP, "accept gzip");
+
+			SetCurlToolAcceptedRequestEncodings (tool_p, "br, GZIP;q=0.5");
+			Check (tool_p -> ct_accepted_encodings == RE_GZIP, "accept gzip with a weight");
+
+			SetCurlToolAcceptedRequestEncodings (tool_p, "gzip;q=0");
+			Check (tool_p -> ct_accepted_encodings == RE_IDENTITY, "don't accept gzip with a weight of 0");
+
+			SetCurlToolAcceptedRequestEncodings (tool_p, "deflate, gzip; q=0.000");
+			Check (tool_p -> ct_accepted_encodings == RE_IDENTITY, "don't accept gzip with a weight of 0.000");
+
+			SetCurlToolAcceptedRequestEncodings (tool_p, "gzip;q=0.01, zstd");
+			Check (tool_p -> ct_accepted_encodings == (RE_GZIP | RE_ZSTD), "accept gzip and zstd");
+
+			SetCurlToolAcceptedRequestEncodings (tool_p, "*, zstd;q=0");
+			Check (tool_p -> ct_accepted_encodings == RE_GZIP, "accept everything but zstd");
+
+			SetCurlToolAcceptedRequestEncodings (tool_p, "*;q=0");
+			Check (tool_p -> ct_accepted_encodings == RE_IDENTITY, "accept nothing");
+
+			FreeCurlTool (tool_p);
+		}
+	else
+		{
+			Check (false, "allocate the CurlTool");
+		}
+}
+
+
+static void TestNegotiation (const json_t *small_req_p, const json_t *large_req_p)
+{
+	CurlTool *tool_p = CreateCurlTool ("/echo");
+
+	if (tool_p)
+		{
+			SetStubServerAcceptEncoding (NULL, false);
+			Check (SendRequest (tool_p, large_req_p, "", 1) && SendRequest (tool_p, large_req_p, "", 1), "send requests uncompressed until the server accepts it");
+
+			SetStubServerAcceptEncoding ("gzip;q=0", false);
+			Check (SendRequest (tool_p, large_req_p, "", 1) && SendRequest (tool_p, large_req_p, "", 1), "send requests uncompressed when the server gives gzip a weight of 0");
+
+			SetStubServerAcceptEncoding ("gzip", false);
+			Check (SendRequest (tool_p, large_req_p, "", 1), "send the request that finds out that the server accepts gzip uncompressed");
+			Check (SendRequest (tool_p, small_req_p, "", 1), "send requests under the threshold uncompressed");
+
+			if (SendRequest (tool_p, large_req_p, "gzip", 1))
+				{
+					char *req_s = json_dumps (large_req_p, 0);
+
+					if (req_s)
+						{
+							printf ("gzip compressed a request from " UINT32_FMT " to " UINT32_FMT " bytes\n", (uint32) strlen (req_s), (uint32) s_server.ss_body_size);
+							Check (s_server.ss_body_size < strlen (req_s) / 4, "make the compressed request smaller");
+							free (req_s);
+						}
+				}
+			else
+				{
+					Check (false, "gzip-compress requests over the threshold");
+				}
+
+			FreeCurlTool (tool_p);
+		}
+	else
+		{
+			Check (false, "create the CurlTool");
+		}
+}
+
+
+static void TestRedirect (const json_t *large_req_p)
+{
+	CurlTool *tool_p = CreateCurlTool ("/redirect");
+
+	if (tool_p)
+		{
+			SetStubServerAcceptEncoding ("gzip", false);
+			SetCurlToolAcceptedRequestEncodings (tool_p, "gzip");
+
+			/* The stub server records the request that the redirect led to */
+			Check (SendRequest (tool_p, large_req_p, "gzip", 2), "send a compressed request again after a redirect");
+
+			FreeCurlTool (tool_p);
+		}
+	else
+		{
+			Check (false, "create the CurlTool");
+		}
+}
+
+
+static void TestPresetEncodings (const json_t *large_req_p)
+{
+	CurlTool *tool_p = CreateCurlTool ("/echo");
+
+	if (tool_p)
+		{
+			SetStubServerAcceptEncoding (NULL, false);
+
+			SetCurlToolAcceptedRequestEncodings (tool_p, "gzip, zstd");
+
+			Check (SendRequest (tool_p, large_req_p, PREFERRED_ENCODING_S, 1), "compress the first request with the preset encodings, using zstd if it is built in");
+			Check (SendRequest (tool_p, large_req_p, PREFERRED_ENCODING_S, 1), "keep the preset encodings if the server doesn't send any");
+
+			SetStubServerAcceptEncoding ("identity", false);
+			Check (SendRequest (tool_p, large_req_p, PREFERRED_ENCODING_S, 1) && SendRequest (tool_p, large_req_p, "", 1), "replace the preset encodings with the server's");
+
+			FreeCurlTool (tool_p);
+		}
+	else
+		{
+			Check (false, "create the CurlTool");
+		}
+}
+
+
+static void TestCompressedResponse (const json_t *small_req_p)
+{
+	CurlTool *tool_p = CreateCurlTool ("/echo");
+
+	if (tool_p)
+		{
+			SetStubServerAcceptEncoding (NULL, true);
+
+			if (SendRequest (tool_p, small_req_p, "", 1))
+				{
+					json_t *res_p = json_loads (GetCurlToolData (tool_p), 0, NULL);
+
+					Check (s_server.ss_response_compressed_flag && res_p && json_is_string (json_object_get (res_p, "padding")), "decode a gzip-compressed response");
+
+					if (res_p)
+						{
+							json_decref (res_p);
+						}
+				}
+			else
+				{
+					Check (false, "send the request for a compressed response");
+				}
+
+			FreeCurlTool (tool_p);
+		}
+	else
+		{
+			Check (false, "create the CurlTool");
+		}
+}
+
+
+int main (void)
+{
+	json_t *small_req_p = CreateRequest (2);
+	json_t *large_req_p = CreateRequest (NUM_LARGE_REQUEST_ENTRIES);
+
+	curl_global_init (CURL_GLOBAL_DEFAULT);
+
+	TestAcceptEncodingParsing ();
+
+	if (small_req_p && large_req_p)
+		{
+			if (StartStubServer ())
+				{
+					TestNegotiation (small_req_p, large_req_p);
+					TestRedirect (large_req_p);
+					TestPresetEncodings (large_req_p);
+					TestCompressedResponse (small_req_p);
+
+					StopStubServer ();
+				}
+			else
+				{
+					Check (false, "start the stub server");
+				}
+		}
+	else
+		{
+			Check (false, "create the test requests");
+		}
+
+	if (small_req_p)
+		{
+			json_decref (small_req_p);
+		}
+
+	if (large_req_p)
+		{
+			json_decref (large_req_p);
+		}
+
+	curl_global_cleanup ();
+
+	return GetTestResult ();
+}
@@ -26,11 +26,14 @@
 #include <sys/socket.h>
 
 #include <arpa/inet.h>
+#include <sys/uio.h>
 
 #include "raw_connection.h"
 #include "string_utils.h"
 #include "math_utils.h"
 #include "memory_allocations.h"
+#include "rope_buffer.h"
+#include "streams.h"
 
 #include "connection.h"
 
@@ -80,6 +83,12 @@ static int ReceiveData (int socket_fd, void *buffer_p, const size_t num_to_recei
 
 static int ReceiveDataIntoByteBuffer (int socket_fd, ByteBuffer *buffer_p, const size_t num_to_receive, bool append_flag);
 
+static int SendRopeBuffer (int socket_fd, const char *header_p, const size_t header_size, const RopeBuffer *buffer_p);
+
+
+/** The maximum number of blocks of data passed to each call to writev () */
+#define S_MAX_IOVECS (64)
+
 
 /******************************/
 /***** METHOD DEFINITIONS *****/
@@ -466,15 +475,43 @@ int AtomicSendViaRawConnection (const char *buffer_p, const uint32 num_to_send,
 }
 
 
+int AtomicSendRopeBufferViaRawConnection (const RopeBuffer *buffer_p, RawConnection *connection_p)
+{
+	int res = 0;
+	const size_t num_to_send = GetRopeBufferSize (buffer_p);
+
+	if (num_to_send <= UINT32_MAX)
+		{
+			uint32 header [2];
+
+			header [0] = htonl ((uint32) num_to_send);
+			header [1] = htonl (connection_p -> rc_base.co_id);
+
+			res = SendRopeBuffer (connection_p -> rc_sock_fd, (const char *) header, sizeof (header), buffer_p);
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Message of " SIZET_FMT " bytes is too large to send", num_to_send);
+		}
+
+	return res;
+}
+
+
 int SendJsonRequestViaRawConnection (struct RawConnection *connection_p, const json_t *json_p)
 {
 	int res = -1;
-	char *req_s = json_dumps (json_p, 0);
+	RopeBuffer *buffer_p = AllocateRopeBuffer (0);
 
-	if (req_s)
+	if (buffer_p)
 		{
-			res = AtomicSendStringViaRawConnection (req_s, connection_p);
-			free (req_s);
+			/* Serialise the request straight into the fragments that will be sent */
+			if (AppendJSONToRopeBuffer (buffer_p, json_p, 0))
+				{
+					res = AtomicSendRopeBufferViaRawConnection (buffer_p, connection_p);
+				}
+
+			FreeRopeBuffer (buffer_p);
 		}
 
 	return res;
@@ -503,7 +540,7 @@ static int SendData (int socket_fd, const void *buffer_p, const size_t num_to_se
 
 	while (loop_flag)
 		{
-			i = send (socket_fd, buffer_p, num_to_send, 0);
+			i = send (socket_fd, buffer_p, num_to_send - num_sent, 0);
 
 			if (i != -1)
 				{
@@ -515,14 +552,127 @@ static int SendData (int socket_fd, const void *buffer_p, const size_t num_to_se
 			else
 				{
 					loop_flag = false;
-					res = -num_sent;
 				}
 		}
 
+	res = (num_sent == num_to_send) ? (int) num_sent : - (int) num_sent;
+
 	return res;
 }
 
 
+/**
+ * Send a header followed by all of the fragments of a RopeBuffer
+ * using as few system calls as possible.
+ *
+ * @param socket_fd The socket to send to.
+ * @param header_p The header to send before the RopeBuffer's data.
+ * @param header_size The length of the header.
+ * @param buffer_p The RopeBuffer to send.
+ * @return The number of bytes of the RopeBuffer's data that were sent upon success. When negative,
+ * it indicates that there was an error with this value being -(num bytes sent) that were
+ * sent successfully before the error occurred. If this is zero, it means that there was
+ * an error sending the header.
+ */
+static int SendRopeBuffer (int socket_fd, const char *header_p, const size_t header_size, const RopeBuffer *buffer_p)
+{
+	const size_t num_fragments = GetRopeBufferNumFragments (buffer_p);
+	const size_t total_size = header_size + GetRopeBufferSize (buffer_p);
+	size_t num_sent = 0;
+
+	/* Index 0 is the header and index n is the RopeBuffer's (n - 1)th fragment */
+	size_t index = 0;
+	size_t offset = 0;
+	bool loop_flag = (total_size > 0);
+
+	while (loop_flag)
+		{
+			struct iovec vecs [S_MAX_IOVECS];
+			int num_vecs = 0;
+			size_t i = index;
+			ssize_t res;
+
+			while ((num_vecs < S_MAX_IOVECS) && (i <= num_fragments))
+				{
+					size_t l = header_size;
+					const char *data_p = (i == 0) ? header_p : GetRopeBufferFragment (buffer_p, i - 1, &l);
+
+					if (i == index)
+						{
+							data_p += offset;
+							l -= offset;
+						}
+
+					if (l > 0)
+						{
+							vecs [num_vecs].iov_base = (void *) data_p;
+							vecs [num_vecs].iov_len = l;
+							++ num_vecs;
+						}
+
+					++ i;
+				}
+
+			res = writev (socket_fd, vecs, num_vecs);
+
+			if (res > 0)
+				{
+					size_t remaining = (size_t) res;
+
+					num_sent += remaining;
+
+					/* Move past everything that has been sent */
+					while (remaining > 0)
+						{
+							size_t l = header_size;
+
+							if (index > 0)
+								{
+									GetRopeBufferFragment (buffer_p, index - 1, &l);
+								}
+
+							l -= offset;
+
+							if (remaining >= l)
+								{
+									remaining -= l;
+									++ index;
+									offset = 0;
+								}
+							else
+								{
+									offset += remaining;
+									remaining = 0;
+								}
+						}
+
+					loop_flag = (num_sent < total_size);
+				}
+			else if ((res == -1) && (errno == EINTR))
+				{
+					/* try again */
+				}
+			else
+				{
+					loop_flag = false;
+				}
+		}
+
+	if (num_sent == total_size)
+		{
+			return (int) (num_sent - header_size);
+		}
+	else if (num_sent <= header_size)
+		{
+			return 0;
+		}
+	else
+		{
+			return - (int) (num_sent - header_size);
+		}
+}
+
+
 /**
  * Make sure that we keep sending until the complete message has been
  * transferred.
@@ -543,7 +693,7 @@ static int ReceiveData (int socket_fd, void *buffer_p, const size_t num_to_recei
 
 	while (loop_flag)
 		{
-			i = recv (socket_fd, buffer_p, num_to_receive, 0);
+			i = recv (socket_fd, buffer_p, num_to_receive - num_received, 0);
 
 			if (i != -1)
 				{
@@ -0,0 +1,1328 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * raw_connection_server.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  The listening socket is added to every worker's epoll set with
+ *  EPOLLEXCLUSIVE so that each new Client wakes a single worker, which
+ *  accepts it and then owns the connection for its whole lifetime. A
+ *  connection's unprocessed input and unsent output are kept in
+ *  ByteBuffers. While a connection has output waiting to be sent, no
+ *  more of its input is read, which stops a Client that doesn't read
+ *  its responses from using up the Server's memory.
+ *
+ *  Complete requests are queued for the handler threads. When a handler
+ *  has finished, its request is added to the owning worker's list of
+ *  finished requests and the worker is woken through its eventfd to send
+ *  the response, so a connection is only ever touched by its worker. A
+ *  connection whose Client disconnects whilst its request is being
+ *  handled is kept until the request comes back.
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netdb.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "raw_connection_server.h"
+#include "byte_buffer.h"
+#include "json_writer.h"
+#include "linked_list.h"
+#include "memory_allocations.h"
+#include "streams.h"
+
+
+#ifdef _DEBUG
+	#define RAW_CONNECTION_SERVER_DEBUG	(STM_LEVEL_FINE)
+#else
+	#define RAW_CONNECTION_SERVER_DEBUG	(STM_LEVEL_NONE)
+#endif
+
+
+/** The size of each frame's header, its length followed by its id */
+#define S_HEADER_SIZE (2 * sizeof (uint32))
+
+/** The maximum number of epoll events handled per wakeup */
+#define S_MAX_EVENTS (256)
+
+/** The maximum number of Clients accepted per wakeup, so that the other workers get some */
+#define S_MAX_ACCEPTS (64)
+
+/** The amount of free space to make available in the input buffer before each read */
+#define S_READ_SIZE (16384)
+
+/** The size of the backlog for the listening socket */
+#define S_LISTEN_BACKLOG (4096)
+
+
+typedef struct RawConnectionServerWorker RawConnectionServerWorker;
+
+
+/*
+ * A Client connected to a RawConnectionServer. The input buffer holds
+ * data that has been received but not processed yet, starting at
+ * ec_input_offset, and the output buffer holds the responses that haven't
+ * been sent yet, starting at ec_output_offset.
+ */
+typedef struct EventConnection
+{
+	/* This must be first so that the EventConnection can be in rcsw_connections */
+	ListItem ec_node;
+
+	int ec_fd;
+
+	ByteBuffer *ec_input_p;
+	size_t ec_input_offset;
+
+	ByteBuffer *ec_output_p;
+	size_t ec_output_offset;
+
+	/* The epoll events that are currently being waited for */
+	uint32 ec_events;
+
+	/* Is one of this connection's requests with the handler threads? */
+	bool ec_busy_flag;
+
+	/* Has the connection been closed whilst its request was being handled? */
+	bool ec_closed_flag;
+} EventConnection;
+
+
+/*
+ * A request that is waiting for, or has been run by, a handler thread.
+ */
+typedef struct RawConnectionRequest
+{
+	/* This must be first so that the RawConnectionRequest can be in the request lists */
+	ListItem rcr_node;
+
+	RawConnectionServerWorker *rcr_worker_p;
+	EventConnection *rcr_connection_p;
+
+	uint32 rcr_id;
+	json_t *rcr_req_p;
+	json_t *rcr_res_p;
+} RawConnectionRequest;
+
+
+struct RawConnectionServerWorker
+{
+	RawConnectionServer *rcsw_server_p;
+
+	pthread_t rcsw_thread;
+	bool rcsw_valid_thread_flag;
+
+	int rcsw_epoll_fd;
+
+	/* Used to wake the worker when it needs to stop or a request has finished */
+	int rcsw_wake_fd;
+	bool rcsw_stop_flag;
+
+	LinkedList rcsw_connections;
+
+	/* The requests whose responses are ready to send, guarded by rcsw_mutex */
+	LinkedList rcsw_finished_requests;
+	pthread_mutex_t rcsw_mutex;
+};
+
+
+struct RawConnectionServer
+{
+	int rcs_listen_fd;
+	uint16 rcs_port;
+
+	RawConnectionServerWorker *rcs_workers_p;
+	uint32 rcs_num_workers;
+
+	RawConnectionRequestHandler rcs_handler_fn;
+	void *rcs_handler_data_p;
+
+	pthread_t *rcs_handler_threads_p;
+	uint32 rcs_num_handler_threads;
+	uint32 rcs_num_running_handler_threads;
+
+	bool rcs_running_flag;
+
+	/* This guards the connection count and the pending requests */
+	pthread_mutex_t rcs_mutex;
+	uint32 rcs_num_connections;
+
+	/* The requests waiting for a handler thread */
+	LinkedList rcs_pending_requests;
+	pthread_cond_t rcs_pending_requests_cond;
+	bool rcs_stop_handlers_flag;
+};
+
+
+/*****************************/
+/***** STATIC PROTOTYPES *****/
+/*****************************/
+
+static int CreateListeningSocket (const char *port_s, uint16 *port_p);
+
+static bool InitRawConnectionServerWorker (RawConnectionServerWorker *worker_p, RawConnectionServer *server_p);
+
+static void ClearRawConnectionServerWorker (RawConnectionServerWorker *worker_p);
+
+static void *RunRawConnectionServerWorker (void *data_p);
+
+static void *RunRawConnectionRequestHandler (void *data_p);
+
+static bool SubmitRequest (RawConnectionServerWorker *worker_p, EventConnection *connection_p, const uint32 id, json_t *req_p);
+
+static void ProcessFinishedRequests (RawConnectionServerWorker *worker_p);
+
+static void FreeRawConnectionRequest (RawConnectionRequest *request_p);
+
+static void DropRequests (LinkedList *requests_p);
+
+static void ServeConnection (RawConnectionServerWorker *worker_p, EventConnection *connection_p, bool open_flag);
+
+static void FreeEventConnection (EventConnection *connection_p);
+
+static void AcceptConnections (RawConnectionServerWorker *worker_p);
+
+static EventConnection *AllocateEventConnection (const int fd);
+
+static void CloseEventConnection (RawConnectionServerWorker *worker_p, EventConnection *connection_p);
+
+static void HandleConnectionEvent (RawConnectionServerWorker *worker_p, EventConnection *connection_p, const uint32 events);
+
+static bool ReadFromConnection (EventConnection *connection_p);
+
+static bool ProcessConnectionInput (RawConnectionServerWorker *worker_p, EventConnection *connection_p);
+
+static bool AddResponseToConnection (EventConnection *connection_p, const uint32 id, json_t *res_p);
+
+static bool WriteToConnection (EventConnection *connection_p);
+
+static bool SetConnectionEvents (RawConnectionServerWorker *worker_p, EventConnection *connection_p, const uint32 events);
+
+static bool UpdateConnectionEvents (RawConnectionServerWorker *worker_p, EventConnection *connection_p);
+
+static void ChangeNumConnections (RawConnectionServer *server_p, const int change);
+
+
+/******************************/
+/***** METHOD DEFINITIONS *****/
+/******************************/
+
+
+RawConnectionServer *AllocateRawConnectionServer (const char *port_s, const uint32 num_threads, const uint32 num_handler_threads, RawConnectionRequestHandler handler_fn, void *handler_data_p)
+{
+	RawConnectionServer *server_p = (RawConnectionServer *) AllocMemory (sizeof (RawConnectionServer));
+
+	if (server_p)
+		{
+			const uint32 num_workers = (num_threads > 0) ? num_threads : RAW_CONNECTION_SERVER_DEFAULT_NUM_THREADS;
+			const uint32 num_handlers = (num_handler_threads > 0) ? num_handler_threads : RAW_CONNECTION_SERVER_DEFAULT_NUM_HANDLER_THREADS;
+
+			memset (server_p, 0, sizeof (RawConnectionServer));
+
+			server_p -> rcs_workers_p = (RawConnectionServerWorker *) AllocMemoryArray (num_workers, sizeof (RawConnectionServerWorker));
+			server_p -> rcs_handler_threads_p = (pthread_t *) AllocMemoryArray (num_handlers, sizeof (pthread_t));
+
+			if ((server_p -> rcs_workers_p) && (server_p -> rcs_handler_threads_p))
+				{
+					server_p -> rcs_listen_fd = CreateListeningSocket (port_s, & (server_p -> rcs_port));
+
+					if (server_p -> rcs_listen_fd != -1)
+						{
+							uint32 i;
+							bool success_flag = true;
+
+							server_p -> rcs_handler_fn = handler_fn;
+							server_p -> rcs_handler_data_p = handler_data_p;
+							server_p -> rcs_num_handler_threads = num_handlers;
+							pthread_mutex_init (& (server_p -> rcs_mutex), NULL);
+							pthread_cond_init (& (server_p -> rcs_pending_requests_cond), NULL);
+							InitLinkedList (& (server_p -> rcs_pending_requests));
+
+							for (i = 0; (i < num_workers) && success_flag; ++ i)
+								{
+									if (InitRawConnectionServerWorker ((server_p -> rcs_workers_p) + i, server_p))
+										{
+											++ (server_p -> rcs_num_workers);
+										}
+									else
+										{
+											success_flag = false;
+										}
+								}
+
+							if (success_flag)
+								{
+									return server_p;
+								}
+
+							FreeRawConnectionServer (server_p);
+							return NULL;
+						}		/* if (server_p -> rcs_listen_fd != -1) */
+				}		/* if ((server_p -> rcs_workers_p) && (server_p -> rcs_handler_threads_p)) */
+
+			if (server_p -> rcs_workers_p)
+				{
+					FreeMemory (server_p -> rcs_workers_p);
+				}
+
+			if (server_p -> rcs_handler_threads_p)
+				{
+					FreeMemory (server_p -> rcs_handler_threads_p);
+				}
+
+			FreeMemory (server_p);
+		}		/* if (server_p) */
+
+	return NULL;
+}
+
+
+void FreeRawConnectionServer (RawConnectionServer *server_p)
+{
+	uint32 i;
+
+	StopRawConnectionServer (server_p);
+
+	for (i = 0; i < server_p -> rcs_num_workers; ++ i)
+		{
+			ClearRawConnectionServerWorker ((server_p -> rcs_workers_p) + i);
+		}
+
+	close (server_p -> rcs_listen_fd);
+	pthread_mutex_destroy (& (server_p -> rcs_mutex));
+	pthread_cond_destroy (& (server_p -> rcs_pending_requests_cond));
+
+	FreeMemory (server_p -> rcs_workers_p);
+	FreeMemory (server_p -> rcs_handler_threads_p);
+	FreeMemory (server_p);
+}
+
+
+bool StartRawConnectionServer (RawConnectionServer *server_p)
+{
+	bool success_flag = true;
+
+	if (!server_p -> rcs_running_flag)
+		{
+			uint32 i;
+
+			server_p -> rcs_stop_handlers_flag = false;
+
+			for (i = 0; (i < server_p -> rcs_num_handler_threads) && success_flag; ++ i)
+				{
+					int res = pthread_create ((server_p -> rcs_handler_threads_p) + i, NULL, RunRawConnectionRequestHandler, server_p);
+
+					if (res == 0)
+						{
+							++ (server_p -> rcs_num_running_handler_threads);
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to start RawConnectionServer handler " UINT32_FMT ", error %d", i, res);
+							success_flag = false;
+						}
+				}
+
+			for (i = 0; (i < server_p -> rcs_num_workers) && success_flag; ++ i)
+				{
+					RawConnectionServerWorker *worker_p = (server_p -> rcs_workers_p) + i;
+					int res;
+
+					worker_p -> rcsw_stop_flag = false;
+					res = pthread_create (& (worker_p -> rcsw_thread), NULL, RunRawConnectionServerWorker, worker_p);
+
+					if (res == 0)
+						{
+							worker_p -> rcsw_valid_thread_flag = true;
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to start RawConnectionServer worker " UINT32_FMT ", error %d", i, res);
+							success_flag = false;
+						}
+				}
+
+			server_p -> rcs_running_flag = true;
+
+			if (!success_flag)
+				{
+					StopRawConnectionServer (server_p);
+				}
+		}
+
+	return success_flag;
+}
+
+
+void StopRawConnectionServer (RawConnectionServer *server_p)
+{
+	if (server_p -> rcs_running_flag)
+		{
+			uint32 i;
+
+			/*
+			 * Stop the handlers first so that every request that is being
+			 * handled is back with its worker before the workers stop.
+			 */
+			pthread_mutex_lock (& (server_p -> rcs_mutex));
+			server_p -> rcs_stop_handlers_flag = true;
+			pthread_cond_broadcast (& (server_p -> rcs_pending_requests_cond));
+			pthread_mutex_unlock (& (server_p -> rcs_mutex));
+
+			for (i = 0; i < server_p -> rcs_num_running_handler_threads; ++ i)
+				{
+					pthread_join (server_p -> rcs_handler_threads_p [i], NULL);
+				}
+
+			server_p -> rcs_num_running_handler_threads = 0;
+
+			for (i = 0; i < server_p -> rcs_num_workers; ++ i)
+				{
+					RawConnectionServerWorker *worker_p = (server_p -> rcs_workers_p) + i;
+
+					if (worker_p -> rcsw_valid_thread_flag)
+						{
+							const uint64 value = 1;
+
+							__atomic_store_n (& (worker_p -> rcsw_stop_flag), true, __ATOMIC_RELEASE);
+
+							if (write (worker_p -> rcsw_wake_fd, &value, sizeof (value)) < 0)
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to wake RawConnectionServer worker " UINT32_FMT ", %s", i, strerror (errno));
+								}
+						}
+				}
+
+			for (i = 0; i < server_p -> rcs_num_workers; ++ i)
+				{
+					RawConnectionServerWorker *worker_p = (server_p -> rcs_workers_p) + i;
+
+					if (worker_p -> rcsw_valid_thread_flag)
+						{
+							ListItem *node_p;
+
+							pthread_join (worker_p -> rcsw_thread, NULL);
+							worker_p -> rcsw_valid_thread_flag = false;
+
+							DropRequests (& (worker_p -> rcsw_finished_requests));
+
+							/* Disconnect the worker's Clients */
+							while ((node_p = worker_p -> rcsw_connections.ll_head_p) != NULL)
+								{
+									CloseEventConnection (worker_p, (EventConnection *) node_p);
+								}
+						}
+				}
+
+			/* Nothing is waiting for these any more */
+			DropRequests (& (server_p -> rcs_pending_requests));
+
+			server_p -> rcs_running_flag = false;
+		}
+}
+
+
+uint16 GetRawConnectionServerPort (const RawConnectionServer *server_p)
+{
+	return server_p -> rcs_port;
+}
+
+
+uint32 GetRawConnectionServerNumConnections (RawConnectionServer *server_p)
+{
+	uint32 num_connections;
+
+	pthread_mutex_lock (& (server_p -> rcs_mutex));
+	num_connections = server_p -> rcs_num_connections;
+	pthread_mutex_unlock (& (server_p -> rcs_mutex));
+
+	return num_connections;
+}
+
+
+/******************************/
+/***** STATIC DEFINITIONS *****/
+/******************************/
+
+
+static int CreateListeningSocket (const char *port_s, uint16 *port_p)
+{
+	struct addrinfo hints;
+	struct addrinfo *addresses_p = NULL;
+	int sock_fd = -1;
+	int res;
+
+	memset (&hints, 0, sizeof (hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+
+	res = getaddrinfo (NULL, port_s, &hints, &addresses_p);
+
+	if (res == 0)
+		{
+			struct addrinfo *addr_p = addresses_p;
+
+			/* loop through all the results and bind to the first we can */
+			while (addr_p && (sock_fd == -1))
+				{
+					sock_fd = socket (addr_p -> ai_family, (addr_p -> ai_socktype) | SOCK_NONBLOCK | SOCK_CLOEXEC, addr_p -> ai_protocol);
+
+					if (sock_fd != -1)
+						{
+							const int on = 1;
+
+							setsockopt (sock_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+
+							if ((bind (sock_fd, addr_p -> ai_addr, addr_p -> ai_addrlen) != 0) || (listen (sock_fd, S_LISTEN_BACKLOG) != 0))
+								{
+									close (sock_fd);
+									sock_fd = -1;
+								}
+						}
+
+					addr_p = addr_p -> ai_next;
+				}
+
+			freeaddrinfo (addresses_p);
+
+			if (sock_fd != -1)
+				{
+					struct sockaddr_storage address;
+					socklen_t address_length = sizeof (address);
+
+					if (getsockname (sock_fd, (struct sockaddr *) &address, &address_length) == 0)
+						{
+							if (address.ss_family == AF_INET6)
+								{
+									*port_p = ntohs (((struct sockaddr_in6 *) &address) -> sin6_port);
+								}
+							else
+								{
+									*port_p = ntohs (((struct sockaddr_in *) &address) -> sin_port);
+								}
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to listen on port %s, %s", port_s, strerror (errno));
+				}
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "getaddrinfo failed for port %s, %s", port_s, gai_strerror (res));
+		}
+
+	return sock_fd;
+}
+
+
+static bool InitRawConnectionServerWorker (RawConnectionServerWorker *worker_p, RawConnectionServer *server_p)
+{
+	worker_p -> rcsw_server_p = server_p;
+	worker_p -> rcsw_valid_thread_flag = false;
+	worker_p -> rcsw_stop_flag = false;
+	InitLinkedList (& (worker_p -> rcsw_connections));
+	InitLinkedList (& (worker_p -> rcsw_finished_requests));
+
+	worker_p -> rcsw_epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+
+	if (worker_p -> rcsw_epoll_fd != -1)
+		{
+			worker_p -> rcsw_wake_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+			if (worker_p -> rcsw_wake_fd != -1)
+				{
+					struct epoll_event event;
+
+					memset (&event, 0, sizeof (event));
+					event.events = EPOLLIN;
+					event.data.ptr = worker_p;
+
+					if (epoll_ctl (worker_p -> rcsw_epoll_fd, EPOLL_CTL_ADD, worker_p -> rcsw_wake_fd, &event) == 0)
+						{
+							/* Only wake one worker for each new Client */
+							event.events = EPOLLIN;
+
+							#ifdef EPOLLEXCLUSIVE
+							event.events |= EPOLLEXCLUSIVE;
+							#endif
+
+							event.data.ptr = NULL;
+
+							if (epoll_ctl (worker_p -> rcsw_epoll_fd, EPOLL_CTL_ADD, server_p -> rcs_listen_fd, &event) == 0)
+								{
+									pthread_mutex_init (& (worker_p -> rcsw_mutex), NULL);
+									return true;
+								}
+						}
+
+					close (worker_p -> rcsw_wake_fd);
+				}
+
+			close (worker_p -> rcsw_epoll_fd);
+		}
+
+	PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to initialise RawConnectionServer worker, %s", strerror (errno));
+
+	return false;
+}
+
+
+static void ClearRawConnectionServerWorker (RawConnectionServerWorker *worker_p)
+{
+	close (worker_p -> rcsw_wake_fd);
+	close (worker_p -> rcsw_epoll_fd);
+	pthread_mutex_destroy (& (worker_p -> rcsw_mutex));
+}
+
+
+static void *RunRawConnectionServerWorker (void *data_p)
+{
+	RawConnectionServerWorker *worker_p = (RawConnectionServerWorker *) data_p;
+	struct epoll_event events [S_MAX_EVENTS];
+
+	while (!__atomic_load_n (& (worker_p -> rcsw_stop_flag), __ATOMIC_ACQUIRE))
+		{
+			int num_events = epoll_wait (worker_p -> rcsw_epoll_fd, events, S_MAX_EVENTS, -1);
+
+			if (num_events > 0)
+				{
+					int i;
+
+					for (i = 0; i < num_events; ++ i)
+						{
+							void *ptr = events [i].data.ptr;
+
+							if (ptr == NULL)
+								{
+									AcceptConnections (worker_p);
+								}
+							else if (ptr == worker_p)
+								{
+									uint64 value;
+
+									/* Clear the wakeup before collecting the responses so that none are missed */
+									if (read (worker_p -> rcsw_wake_fd, &value, sizeof (value)) < 0)
+										{
+											#if RAW_CONNECTION_SERVER_DEBUG >= STM_LEVEL_FINE
+											PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Failed to read from RawConnectionServer worker's wake descriptor, %s", strerror (errno));
+											#endif
+										}
+
+									ProcessFinishedRequests (worker_p);
+								}
+							else
+								{
+									HandleConnectionEvent (worker_p, (EventConnection *) ptr, events [i].events);
+								}
+						}
+				}
+			else if ((num_events == -1) && (errno != EINTR))
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "epoll_wait failed for RawConnectionServer worker, %s", strerror (errno));
+				}
+		}
+
+	return NULL;
+}
+
+
+static void AcceptConnections (RawConnectionServerWorker *worker_p)
+{
+	RawConnectionServer *server_p = worker_p -> rcsw_server_p;
+	uint32 num_accepted = 0;
+	bool loop_flag = true;
+
+	while (loop_flag)
+		{
+			int fd = accept4 (server_p -> rcs_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+			if (fd != -1)
+				{
+					EventConnection *connection_p = AllocateEventConnection (fd);
+
+					if (connection_p)
+						{
+							const int on = 1;
+
+							/* Responses are written in one go so don't wait to coalesce them */
+							setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof (on));
+
+							LinkedListAddTail (& (worker_p -> rcsw_connections), & (connection_p -> ec_node));
+
+							if (SetConnectionEvents (worker_p, connection_p, EPOLLIN))
+								{
+									ChangeNumConnections (server_p, 1);
+								}
+							else
+								{
+									CloseEventConnection (worker_p, connection_p);
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate connection for Client");
+							close (fd);
+						}
+
+					++ num_accepted;
+					loop_flag = (num_accepted < S_MAX_ACCEPTS);
+				}
+			else
+				{
+					if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR) && (errno != ECONNABORTED))
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to accept Client, %s", strerror (errno));
+						}
+
+					loop_flag = (errno == EINTR) || (errno == ECONNABORTED);
+				}
+		}
+}
+
+
+static EventConnection *AllocateEventConnection (const int fd)
+{
+	EventConnection *connection_p = (EventConnection *) AllocMemory (sizeof (EventConnection));
+
+	if (connection_p)
+		{
+			connection_p -> ec_input_p = AllocateByteBuffer (S_READ_SIZE);
+
+			if (connection_p -> ec_input_p)
+				{
+					connection_p -> ec_output_p = AllocateByteBuffer (1024);
+
+					if (connection_p -> ec_output_p)
+						{
+							InitListItem (& (connection_p -> ec_node));
+							connection_p -> ec_fd = fd;
+							connection_p -> ec_input_offset = 0;
+							connection_p -> ec_output_offset = 0;
+							connection_p -> ec_events = 0;
+							connection_p -> ec_busy_flag = false;
+							connection_p -> ec_closed_flag = false;
+
+							return connection_p;
+						}
+
+					FreeByteBuffer (connection_p -> ec_input_p);
+				}
+
+			FreeMemory (connection_p);
+		}
+
+	return NULL;
+}
+
+
+static void CloseEventConnection (RawConnectionServerWorker *worker_p, EventConnection *connection_p)
+{
+	LinkedListRemove (& (worker_p -> rcsw_connections), & (connection_p -> ec_node));
+
+	if (connection_p -> ec_events != 0)
+		{
+			ChangeNumConnections (worker_p -> rcsw_server_p, -1);
+		}
+
+	/* Closing the socket removes it from the epoll set too */
+	close (connection_p -> ec_fd);
+	connection_p -> ec_fd = -1;
+
+	if (connection_p -> ec_busy_flag)
+		{
+			/* Its request still refers to it so it is freed once the request comes back */
+			connection_p -> ec_closed_flag = true;
+		}
+	else
+		{
+			FreeEventConnection (connection_p);
+		}
+}
+
+
+static void FreeEventConnection (EventConnection *connection_p)
+{
+	FreeByteBuffer (connection_p -> ec_input_p);
+	FreeByteBuffer (connection_p -> ec_output_p);
+	FreeMemory (connection_p);
+}
+
+
+static void HandleConnectionEvent (RawConnectionServerWorker *worker_p, EventConnection *connection_p, const uint32 events)
+{
+	bool open_flag = true;
+
+	if (events & EPOLLOUT)
+		{
+			open_flag = WriteToConnection (connection_p);
+		}
+
+	if (open_flag && (events & EPOLLIN))
+		{
+			open_flag = ReadFromConnection (connection_p);
+		}
+	else if (events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP))
+		{
+			open_flag = false;
+		}
+
+	ServeConnection (worker_p, connection_p, open_flag);
+}
+
+
+/*
+ * Pass the next complete request to the handler threads as long as there
+ * isn't one there already or a backlog of responses waiting to be sent,
+ * and then wait for whatever the connection needs next.
+ */
+static void ServeConnection (RawConnectionServerWorker *worker_p, EventConnection *connection_p, bool open_flag)
+{
+	if (open_flag && (!connection_p -> ec_busy_flag) && (GetByteBufferSize (connection_p -> ec_output_p) == 0))
+		{
+			open_flag = ProcessConnectionInput (worker_p, connection_p);
+
+			if (open_flag)
+				{
+					open_flag = WriteToConnection (connection_p);
+				}
+		}
+
+	if (open_flag)
+		{
+			open_flag = UpdateConnectionEvents (worker_p, connection_p);
+		}
+
+	if (!open_flag)
+		{
+			CloseEventConnection (worker_p, connection_p);
+		}
+}
+
+
+/*
+ * Read whatever is available on the socket. This returns false if the
+ * Client has disconnected or there was an error.
+ */
+static bool ReadFromConnection (EventConnection *connection_p)
+{
+	ByteBuffer *buffer_p = connection_p -> ec_input_p;
+	bool open_flag = true;
+	ssize_t num_read;
+
+	/* Reclaim the space used by the requests that have been processed */
+	if (connection_p -> ec_input_offset > 0)
+		{
+			const size_t remaining = (buffer_p -> bb_current_index) - (connection_p -> ec_input_offset);
+
+			memmove (buffer_p -> bb_data_p, (buffer_p -> bb_data_p) + (connection_p -> ec_input_offset), remaining);
+			buffer_p -> bb_current_index = remaining;
+			connection_p -> ec_input_offset = 0;
+		}
+
+	/*
+	 * If we're part way through a large request, make room for all of it
+	 * in one go rather than growing the buffer a read at a time.
+	 */
+	if (buffer_p -> bb_current_index >= S_HEADER_SIZE)
+		{
+			uint32 message_size;
+
+			memcpy (&message_size, buffer_p -> bb_data_p, sizeof (uint32));
+			message_size = ntohl (message_size);
+
+			if (message_size <= RAW_CONNECTION_SERVER_MAX_MESSAGE_SIZE)
+				{
+					const size_t required_size = S_HEADER_SIZE + message_size + 1;
+
+					if (buffer_p -> bb_size < required_size)
+						{
+							if (!ResizeByteBuffer (buffer_p, required_size))
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to resize input buffer to " SIZET_FMT " bytes", required_size);
+									return false;
+								}
+						}
+				}
+		}
+
+	if (GetRemainingSpaceInByteBuffer (buffer_p) <= 1)
+		{
+			if (!ExtendByteBuffer (buffer_p, S_READ_SIZE))
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to extend input buffer to " SIZET_FMT " bytes", (buffer_p -> bb_size) + S_READ_SIZE);
+					return false;
+				}
+		}
+
+	do
+		{
+			num_read = recv (connection_p -> ec_fd, (buffer_p -> bb_data_p) + (buffer_p -> bb_current_index), GetRemainingSpaceInByteBuffer (buffer_p) - 1, 0);
+		}
+	while ((num_read == -1) && (errno == EINTR));
+
+	if (num_read > 0)
+		{
+			buffer_p -> bb_current_index += num_read;
+		}
+	else if (num_read == 0)
+		{
+			/* The Client has disconnected */
+			open_flag = false;
+		}
+	else if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+		{
+			#if RAW_CONNECTION_SERVER_DEBUG >= STM_LEVEL_FINE
+			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Failed to read from Client, %s", strerror (errno));
+			#endif
+
+			open_flag = false;
+		}
+
+	return open_flag;
+}
+
+
+/*
+ * Pass the first complete request in the input buffer to the handler
+ * threads. Any requests before it that can't be parsed are answered
+ * straight away. This returns false if the Client has sent something
+ * invalid and should be disconnected.
+ */
+static bool ProcessConnectionInput (RawConnectionServerWorker *worker_p, EventConnection *connection_p)
+{
+	ByteBuffer *buffer_p = connection_p -> ec_input_p;
+	bool loop_flag = true;
+	bool success_flag = true;
+
+	while (loop_flag)
+		{
+			const char *frame_p = (buffer_p -> bb_data_p) + (connection_p -> ec_input_offset);
+			const size_t available = (buffer_p -> bb_current_index) - (connection_p -> ec_input_offset);
+
+			if (available >= S_HEADER_SIZE)
+				{
+					uint32 message_size;
+					uint32 id;
+
+					memcpy (&message_size, frame_p, sizeof (uint32));
+					memcpy (&id, frame_p + sizeof (uint32), sizeof (uint32));
+
+					message_size = ntohl (message_size);
+					id = ntohl (id);
+
+					if (message_size <= RAW_CONNECTION_SERVER_MAX_MESSAGE_SIZE)
+						{
+							if (available >= S_HEADER_SIZE + message_size)
+								{
+									json_error_t error;
+									json_t *req_p = json_loadb (frame_p + S_HEADER_SIZE, message_size, 0, &error);
+
+									connection_p -> ec_input_offset += S_HEADER_SIZE + message_size;
+
+									if (req_p)
+										{
+											/* The response will come back through ProcessFinishedRequests () */
+											loop_flag = false;
+
+											if (!SubmitRequest (worker_p, connection_p, id, req_p))
+												{
+													success_flag = false;
+												}
+										}
+									else
+										{
+											json_t *res_p = json_pack ("{s:s}", RAW_CONNECTION_SERVER_ERROR_S, error.text);
+
+											if (!AddResponseToConnection (connection_p, id, res_p))
+												{
+													loop_flag = false;
+													success_flag = false;
+												}
+
+											if (res_p)
+												{
+													json_decref (res_p);
+												}
+										}
+								}
+							else
+								{
+									/* Wait for the rest of the message */
+									loop_flag = false;
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Disconnecting Client that sent a message of " UINT32_FMT " bytes", message_size);
+							loop_flag = false;
+							success_flag = false;
+						}
+				}
+			else
+				{
+					loop_flag = false;
+				}
+		}
+
+	/* If all of the input has been used, just reset the buffer */
+	if (connection_p -> ec_input_offset == buffer_p -> bb_current_index)
+		{
+			/*
+			 * There's no need to clear the old data, which ResetByteBuffer ()
+			 * would do, as it will be overwritten.
+			 */
+			buffer_p -> bb_current_index = 0;
+			connection_p -> ec_input_offset = 0;
+		}
+
+	return success_flag;
+}
+
+
+static bool AddResponseToConnection (EventConnection *connection_p, const uint32 id, json_t *res_p)
+{
+	bool success_flag = false;
+
+	if (res_p)
+		{
+			ByteBuffer *buffer_p = connection_p -> ec_output_p;
+			const size_t header_offset = GetByteBufferSize (buffer_p);
+			uint32 header [2];
+
+			header [0] = 0;
+			header [1] = htonl (id);
+
+			/*
+			 * Serialise the response straight into the output buffer rather than
+			 * dumping it to a separate string and copying that in. The length in
+			 * the header is filled in once it is known.
+			 */
+			if (AppendToByteBuffer (buffer_p, header, S_HEADER_SIZE))
+				{
+					if (json_dump_callback (res_p, ByteBufferJSONWriterSink, buffer_p, JSON_COMPACT) == 0)
+						{
+							const size_t res_length = GetByteBufferSize (buffer_p) - header_offset - S_HEADER_SIZE;
+
+							header [0] = htonl ((uint32) res_length);
+							memcpy ((buffer_p -> bb_data_p) + header_offset, header, sizeof (uint32));
+
+							success_flag = true;
+						}
+					else
+						{
+							/* Remove the partial response */
+							buffer_p -> bb_current_index = header_offset;
+						}
+				}
+		}
+
+	if (!success_flag)
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add response to output buffer");
+		}
+
+	return success_flag;
+}
+
+
+/*
+ * Send as much of the output buffer as the socket will take. This
+ * returns false if the Client has disconnected or there was an error.
+ */
+static bool WriteToConnection (EventConnection *connection_p)
+{
+	ByteBuffer *buffer_p = connection_p -> ec_output_p;
+	bool loop_flag = (GetByteBufferSize (buffer_p) > 0);
+	bool open_flag = true;
+
+	while (loop_flag)
+		{
+			const size_t remaining = (buffer_p -> bb_current_index) - (connection_p -> ec_output_offset);
+			ssize_t num_sent = send (connection_p -> ec_fd, (buffer_p -> bb_data_p) + (connection_p -> ec_output_offset), remaining, MSG_NOSIGNAL);
+
+			if (num_sent >= 0)
+				{
+					connection_p -> ec_output_offset += num_sent;
+
+					if ((size_t) num_sent == remaining)
+						{
+							buffer_p -> bb_current_index = 0;
+							connection_p -> ec_output_offset = 0;
+							loop_flag = false;
+						}
+				}
+			else if (errno != EINTR)
+				{
+					if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+						{
+							open_flag = false;
+						}
+
+					loop_flag = false;
+				}
+		}
+
+	return open_flag;
+}
+
+
+static bool SetConnectionEvents (RawConnectionServerWorker *worker_p, EventConnection *connection_p, const uint32 events)
+{
+	bool success_flag = true;
+
+	if (connection_p -> ec_events != events)
+		{
+			struct epoll_event event;
+			const int op = (connection_p -> ec_events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+			memset (&event, 0, sizeof (event));
+			event.events = events;
+			event.data.ptr = connection_p;
+
+			if (epoll_ctl (worker_p -> rcsw_epoll_fd, op, connection_p -> ec_fd, &event) == 0)
+				{
+					connection_p -> ec_events = events;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to update epoll events for Client, %s", strerror (errno));
+					success_flag = false;
+				}
+		}
+
+	return success_flag;
+}
+
+
+static void ChangeNumConnections (RawConnectionServer *server_p, const int change)
+{
+	pthread_mutex_lock (& (server_p -> rcs_mutex));
+	server_p -> rcs_num_connections += change;
+	pthread_mutex_unlock (& (server_p -> rcs_mutex));
+}
+
+
+/*
+ * Wait for whatever the connection needs next: for its responses to be
+ * sent, for its current request to come back from the handler threads,
+ * during which we only want to know if the Client disconnects, or for
+ * more requests.
+ */
+static bool UpdateConnectionEvents (RawConnectionServerWorker *worker_p, EventConnection *connection_p)
+{
+	uint32 wanted_events = EPOLLIN;
+
+	if (GetByteBufferSize (connection_p -> ec_output_p) > 0)
+		{
+			wanted_events = EPOLLOUT;
+		}
+	else if (connection_p -> ec_busy_flag)
+		{
+			wanted_events = EPOLLRDHUP;
+		}
+
+	return SetConnectionEvents (worker_p, connection_p, wanted_events);
+}
+
+
+static bool SubmitRequest (RawConnectionServerWorker *worker_p, EventConnection *connection_p, const uint32 id, json_t *req_p)
+{
+	RawConnectionServer *server_p = worker_p -> rcsw_server_p;
+	RawConnectionRequest *request_p = (RawConnectionRequest *) AllocMemory (sizeof (RawConnectionRequest));
+
+	if (request_p)
+		{
+			InitListItem (& (request_p -> rcr_node));
+			request_p -> rcr_worker_p = worker_p;
+			request_p -> rcr_connection_p = connection_p;
+			request_p -> rcr_id = id;
+			request_p -> rcr_req_p = req_p;
+			request_p -> rcr_res_p = NULL;
+
+			connection_p -> ec_busy_flag = true;
+
+			pthread_mutex_lock (& (server_p -> rcs_mutex));
+			LinkedListAddTail (& (server_p -> rcs_pending_requests), & (request_p -> rcr_node));
+			pthread_cond_signal (& (server_p -> rcs_pending_requests_cond));
+			pthread_mutex_unlock (& (server_p -> rcs_mutex));
+
+			return true;
+		}
+
+	PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate request " UINT32_FMT " for Client", id);
+	json_decref (req_p);
+
+	return false;
+}
+
+
+static void *RunRawConnectionRequestHandler (void *data_p)
+{
+	RawConnectionServer *server_p = (RawConnectionServer *) data_p;
+	bool loop_flag = true;
+
+	while (loop_flag)
+		{
+			RawConnectionRequest *request_p = NULL;
+
+			pthread_mutex_lock (& (server_p -> rcs_mutex));
+
+			while ((!server_p -> rcs_stop_handlers_flag) && (server_p -> rcs_pending_requests.ll_size == 0))
+				{
+					pthread_cond_wait (& (server_p -> rcs_pending_requests_cond), & (server_p -> rcs_mutex));
+				}
+
+			if (server_p -> rcs_stop_handlers_flag)
+				{
+					loop_flag = false;
+				}
+			else
+				{
+					request_p = (RawConnectionRequest *) LinkedListRemHead (& (server_p -> rcs_pending_requests));
+				}
+
+			pthread_mutex_unlock (& (server_p -> rcs_mutex));
+
+			if (request_p)
+				{
+					RawConnectionServerWorker *worker_p = request_p -> rcr_worker_p;
+					const uint64 value = 1;
+
+					request_p -> rcr_res_p = server_p -> rcs_handler_fn (request_p -> rcr_req_p, server_p -> rcs_handler_data_p);
+
+					if (! (request_p -> rcr_res_p))
+						{
+							request_p -> rcr_res_p = json_pack ("{s:s}", RAW_CONNECTION_SERVER_ERROR_S, "Failed to process request");
+						}
+
+					InitListItem (& (request_p -> rcr_node));
+
+					pthread_mutex_lock (& (worker_p -> rcsw_mutex));
+					LinkedListAddTail (& (worker_p -> rcsw_finished_requests), & (request_p -> rcr_node));
+					pthread_mutex_unlock (& (worker_p -> rcsw_mutex));
+
+					if (write (worker_p -> rcsw_wake_fd, &value, sizeof (value)) < 0)
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to wake RawConnectionServer worker for request " UINT32_FMT ", %s", request_p -> rcr_id, strerror (errno));
+						}
+				}
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Send the responses that the handler threads have finished with
+ * and move on to each connection's next request.
+ */
+static void ProcessFinishedRequests (RawConnectionServerWorker *worker_p)
+{
+	LinkedList finished_requests;
+	ListItem *node_p;
+
+	InitLinkedList (&finished_requests);
+
+	/* Take them all in one go so that the handlers aren't held up */
+	pthread_mutex_lock (& (worker_p -> rcsw_mutex));
+
+	while ((node_p = LinkedListRemHead (& (worker_p -> rcsw_finished_requests))) != NULL)
+		{
+			LinkedListAddTail (&finished_requests, node_p);
+		}
+
+	pthread_mutex_unlock (& (worker_p -> rcsw_mutex));
+
+	while ((node_p = LinkedListRemHead (&finished_requests)) != NULL)
+		{
+			RawConnectionRequest *request_p = (RawConnectionRequest *) node_p;
+			EventConnection *connection_p = request_p -> rcr_connection_p;
+
+			connection_p -> ec_busy_flag = false;
+
+			if (connection_p -> ec_closed_flag)
+				{
+					FreeEventConnection (connection_p);
+				}
+			else
+				{
+					const bool open_flag = AddResponseToConnection (connection_p, request_p -> rcr_id, request_p -> rcr_res_p);
+
+					ServeConnection (worker_p, connection_p, open_flag);
+				}
+
+			FreeRawConnectionRequest (request_p);
+		}
+}
+
+
+static void FreeRawConnectionRequest (RawConnectionRequest *request_p)
+{
+	if (request_p -> rcr_req_p)
+		{
+			json_decref (request_p -> rcr_req_p);
+		}
+
+	if (request_p -> rcr_res_p)
+		{
+			json_decref (request_p -> rcr_res_p);
+		}
+
+	FreeMemory (request_p);
+}
+
+
+/*
+ * Free requests that won't be answered because the RawConnectionServer
+ * has stopped, along with any connections that were only being kept
+ * for them.
+ */
+static void DropRequests (LinkedList *requests_p)
+{
+	ListItem *node_p;
+
+	while ((node_p = LinkedListRemHead (requests_p)) != NULL)
+		{
+			RawConnectionRequest *request_p = (RawConnectionRequest *) node_p;
+			EventConnection *connection_p = request_p -> rcr_connection_p;
+
+			connection_p -> ec_busy_flag = false;
+
+			if (connection_p -> ec_closed_flag)
+				{
+					FreeEventConnection (connection_p);
+				}
+
+			FreeRawConnectionRequest (request_p);
+		}
+}
@@ -0,0 +1,683 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * raw_connection_server_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the RawConnectionServer along with a local load generator
+ *  that opens many simultaneous Client connections to it.
+ *
+ *  Usage: raw_connection_server_test [<number of clients>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "raw_connection_server.h"
+#include "connection.h"
+#include "raw_connection.h"
+#include "memory_allocations.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_CLIENTS (2000)
+
+#define NUM_PIPELINED_REQUESTS (100)
+
+/* How long, in milliseconds, the handler takes for a slow request */
+#define SLOW_REQUEST_MS (500)
+
+
+static double GetElapsedSeconds (const struct timespec *start_p)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start_p -> tv_sec) + ((now.tv_nsec - start_p -> tv_nsec) / 1e9);
+}
+
+
+/* Reply with the request wrapped in an object */
+static json_t *EchoRequest (json_t *req_p, void * UNUSED_PARAM (data_p))
+{
+	if (json_is_object (req_p) && json_object_get (req_p, "fail"))
+		{
+			return NULL;
+		}
+
+	if (json_is_object (req_p) && json_object_get (req_p, "slow"))
+		{
+			usleep (SLOW_REQUEST_MS * 1000);
+		}
+
+	return json_pack ("{s:O}", "echo", req_p);
+}
+
+
+static int ConnectToServer (const uint16 port)
+{
+	int fd = socket (AF_INET, SOCK_STREAM, 0);
+
+	if (fd != -1)
+		{
+			struct sockaddr_in address;
+
+			memset (&address, 0, sizeof (address));
+			address.sin_family = AF_INET;
+			address.sin_port = htons (port);
+			address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+			if (connect (fd, (struct sockaddr *) &address, sizeof (address)) == 0)
+				{
+					return fd;
+				}
+
+			close (fd);
+		}
+
+	return -1;
+}
+
+
+static bool SendAll (const int fd, const char *data_p, size_t length, const size_t chunk_size)
+{
+	while (length > 0)
+		{
+			const size_t to_send = ((chunk_size > 0) && (chunk_size < length)) ? chunk_size : length;
+			ssize_t num_sent = send (fd, data_p, to_send, MSG_NOSIGNAL);
+
+			if (num_sent <= 0)
+				{
+					return false;
+				}
+
+			data_p += num_sent;
+			length -= num_sent;
+		}
+
+	return true;
+}
+
+
+static bool ReceiveAll (const int fd, char *data_p, size_t length)
+{
+	while (length > 0)
+		{
+			ssize_t num_read = recv (fd, data_p, length, 0);
+
+			if (num_read <= 0)
+				{
+					return false;
+				}
+
+			data_p += num_read;
+			length -= num_read;
+		}
+
+	return true;
+}
+
+
+/*
+ * Build a frame for the given message. The frame is written to buffer_s
+ * which must be at least 8 bytes longer than the message.
+ */
+static size_t MakeFrame (char *buffer_s, const char *message_s, const size_t message_length, const uint32 id)
+{
+	uint32 header [2];
+
+	header [0] = htonl ((uint32) message_length);
+	header [1] = htonl (id);
+
+	memcpy (buffer_s, header, sizeof (header));
+	memcpy (buffer_s + sizeof (header), message_s, message_length);
+
+	return sizeof (header) + message_length;
+}
+
+
+static bool SendRequest (const int fd, const char *message_s, const uint32 id, const size_t chunk_size)
+{
+	bool success_flag = false;
+	const size_t l = strlen (message_s);
+	char *frame_s = (char *) AllocMemory (l + 8);
+
+	if (frame_s)
+		{
+			const size_t frame_length = MakeFrame (frame_s, message_s, l, id);
+
+			success_flag = SendAll (fd, frame_s, frame_length, chunk_size);
+			FreeMemory (frame_s);
+		}
+
+	return success_flag;
+}
+
+
+static json_t *ReceiveResponse (const int fd, uint32 *id_p)
+{
+	json_t *res_p = NULL;
+	uint32 header [2];
+
+	if (ReceiveAll (fd, (char *) header, sizeof (header)))
+		{
+			const uint32 l = ntohl (header [0]);
+			char *message_s = (char *) AllocMemory (l);
+
+			*id_p = ntohl (header [1]);
+
+			if (message_s)
+				{
+					if (ReceiveAll (fd, message_s, l))
+						{
+							res_p = json_loadb (message_s, l, 0, NULL);
+						}
+
+					FreeMemory (message_s);
+				}
+		}
+
+	return res_p;
+}
+
+
+static bool IsEchoOf (const json_t *res_p, const char *key_s, const json_int_t value)
+{
+	const json_t *echo_p = json_object_get (res_p, "echo");
+
+	return (echo_p && (json_integer_value (json_object_get (echo_p, key_s)) == value));
+}
+
+
+static bool WaitForNumConnections (RawConnectionServer *server_p, const uint32 num_connections)
+{
+	int i;
+
+	for (i = 0; i < 500; ++ i)
+		{
+			if (GetRawConnectionServerNumConnections (server_p) == num_connections)
+				{
+					return true;
+				}
+
+			usleep (10000);
+		}
+
+	return false;
+}
+
+
+static void TestFragmentedRequest (RawConnectionServer *server_p)
+{
+	int fd = ConnectToServer (GetRawConnectionServerPort (server_p));
+
+	if (fd != -1)
+		{
+			json_t *res_p;
+			uint32 id = 0;
+
+			/* Send the request a byte at a time to check that it is reassembled */
+			Check (SendRequest (fd, "{\"value\": 42}", 7, 1), "send fragmented request");
+
+			res_p = ReceiveResponse (fd, &id);
+			Check (res_p != NULL, "receive response to fragmented request");
+			Check (id == 7, "response has the request's id");
+			Check (IsEchoOf (res_p, "value", 42), "response to fragmented request is correct");
+
+			if (res_p)
+				{
+					json_decref (res_p);
+				}
+
+			Check (SendRequest (fd, "{\"fail\": true}", 8, 0), "send failing request");
+			res_p = ReceiveResponse (fd, &id);
+			Check ((res_p != NULL) && (json_object_get (res_p, RAW_CONNECTION_SERVER_ERROR_S) != NULL), "failed request gets an error");
+
+			if (res_p)
+				{
+					json_decref (res_p);
+				}
+
+			Check (SendRequest (fd, "{not json", 9, 0), "send invalid request");
+			res_p = ReceiveResponse (fd, &id);
+			Check ((res_p != NULL) && (json_object_get (res_p, RAW_CONNECTION_SERVER_ERROR_S) != NULL) && (id == 9), "invalid request gets an error");
+
+			if (res_p)
+				{
+					json_decref (res_p);
+				}
+
+			close (fd);
+		}
+	else
+		{
+			Check (false, "connect for fragmented request");
+		}
+}
+
+
+static void TestPipelinedRequests (RawConnectionServer *server_p)
+{
+	int fd = ConnectToServer (GetRawConnectionServerPort (server_p));
+
+	if (fd != -1)
+		{
+			char *frames_s = (char *) AllocMemory (NUM_PIPELINED_REQUESTS * 64);
+
+			if (frames_s)
+				{
+					size_t l = 0;
+					int num_correct = 0;
+					uint32 i;
+
+					for (i = 0; i < NUM_PIPELINED_REQUESTS; ++ i)
+						{
+							char message_s [32];
+							const int message_length = sprintf (message_s, "{\"value\": " UINT32_FMT "}", i);
+
+							l += MakeFrame (frames_s + l, message_s, message_length, i);
+						}
+
+					/* Send them all in one go and split at odd places */
+					Check (SendAll (fd, frames_s, l, 1000), "send pipelined requests");
+
+					for (i = 0; i < NUM_PIPELINED_REQUESTS; ++ i)
+						{
+							uint32 id = 0;
+							json_t *res_p = ReceiveResponse (fd, &id);
+
+							if (res_p)
+								{
+									if ((id == i) && IsEchoOf (res_p, "value", i))
+										{
+											++ num_correct;
+										}
+
+									json_decref (res_p);
+								}
+						}
+
+					Check (num_correct == NUM_PIPELINED_REQUESTS, "pipelined responses are correct and in order");
+
+					FreeMemory (frames_s);
+				}
+
+			close (fd);
+		}
+	else
+		{
+			Check (false, "connect for pipelined requests");
+		}
+}
+
+
+/*
+ * With a single worker thread, every connection belongs to the same
+ * worker, so check that a slow request on one of them doesn't hold up
+ * the others and that a Client can disconnect whilst its request is
+ * still being handled.
+ */
+static void TestSlowRequest (void)
+{
+	RawConnectionServer *server_p = AllocateRawConnectionServer ("0", 1, 3, EchoRequest, NULL);
+
+	if (server_p)
+		{
+			if (StartRawConnectionServer (server_p))
+				{
+					const uint16 port = GetRawConnectionServerPort (server_p);
+					int slow_fd = ConnectToServer (port);
+					int abandoned_fd = ConnectToServer (port);
+					int fast_fd = ConnectToServer (port);
+
+					if ((slow_fd != -1) && (abandoned_fd != -1) && (fast_fd != -1))
+						{
+							struct timespec start;
+							json_t *res_p;
+							uint32 id = 0;
+
+							Check (SendRequest (abandoned_fd, "{\"slow\": true}", 1, 0), "send slow request and disconnect");
+							close (abandoned_fd);
+							abandoned_fd = -1;
+
+							Check (SendRequest (slow_fd, "{\"slow\": true, \"value\": 1}", 2, 0), "send slow request");
+
+							/* Give the worker time to pass the slow requests on */
+							usleep (50000);
+							clock_gettime (CLOCK_MONOTONIC, &start);
+
+							Check (SendRequest (fast_fd, "{\"value\": 3}", 3, 0), "send fast request");
+							res_p = ReceiveResponse (fast_fd, &id);
+							Check ((res_p != NULL) && (id == 3) && IsEchoOf (res_p, "value", 3), "receive fast response");
+							Check (GetElapsedSeconds (&start) < (SLOW_REQUEST_MS / 2000.0), "slow request doesn't hold up the worker's other connections");
+
+							if (res_p)
+								{
+									json_decref (res_p);
+								}
+
+							res_p = ReceiveResponse (slow_fd, &id);
+							Check ((res_p != NULL) && (id == 2) && IsEchoOf (res_p, "value", 1), "receive slow response");
+
+							if (res_p)
+								{
+									json_decref (res_p);
+								}
+
+							Check (WaitForNumConnections (server_p, 2), "disconnected Client is closed whilst its request is handled");
+						}
+					else
+						{
+							Check (false, "connect for slow request");
+						}
+
+					if (slow_fd != -1)
+						{
+							close (slow_fd);
+						}
+
+					if (abandoned_fd != -1)
+						{
+							close (abandoned_fd);
+						}
+
+					if (fast_fd != -1)
+						{
+							close (fast_fd);
+						}
+
+					/* Leave a slow request with the handlers as the Server stops */
+					slow_fd = ConnectToServer (port);
+
+					if (slow_fd != -1)
+						{
+							SendRequest (slow_fd, "{\"slow\": true}", 4, 0);
+							usleep (50000);
+						}
+
+					StopRawConnectionServer (server_p);
+
+					if (slow_fd != -1)
+						{
+							close (slow_fd);
+						}
+				}
+			else
+				{
+					Check (false, "start Server for slow request");
+				}
+
+			FreeRawConnectionServer (server_p);
+		}
+	else
+		{
+			Check (false, "allocate Server for slow request");
+		}
+}
+
+
+static void TestLargeRequest (RawConnectionServer *server_p)
+{
+	int fd = ConnectToServer (GetRawConnectionServerPort (server_p));
+
+	if (fd != -1)
+		{
+			const size_t l = 4 * 1024 * 1024;
+			char *message_s = (char *) AllocMemory (l + 32);
+
+			if (message_s)
+				{
+					json_t *res_p;
+					uint32 id = 0;
+
+					strcpy (message_s, "{\"value\": 1, \"data\": \"");
+					memset (message_s + strlen (message_s), 'x', l);
+					strcpy (message_s + l + 22, "\"}");
+
+					Check (SendRequest (fd, message_s, 1, 65536), "send large request");
+
+					res_p = ReceiveResponse (fd, &id);
+					Check ((res_p != NULL) && IsEchoOf (res_p, "value", 1), "response to large request is correct");
+
+					if (res_p)
+						{
+							json_decref (res_p);
+						}
+
+					FreeMemory (message_s);
+				}
+
+			close (fd);
+		}
+	else
+		{
+			Check (false, "connect for large request");
+		}
+
+	fd = ConnectToServer (GetRawConnectionServerPort (server_p));
+
+	if (fd != -1)
+		{
+			uint32 header [2];
+			char c;
+
+			header [0] = htonl (RAW_CONNECTION_SERVER_MAX_MESSAGE_SIZE + 1);
+			header [1] = 0;
+
+			Check (SendAll (fd, (const char *) header, sizeof (header), 0), "send oversized header");
+			Check (recv (fd, &c, 1, 0) == 0, "oversized request disconnects the Client");
+
+			close (fd);
+		}
+}
+
+
+/* Check that a RawConnection Client can talk to the Server */
+static void TestRawConnectionClient (RawConnectionServer *server_p)
+{
+	char port_s [16];
+	Connection *connection_p;
+
+	sprintf (port_s, "%u", (unsigned int) GetRawConnectionServerPort (server_p));
+	connection_p = AllocateRawServerConnection ("localhost", port_s);
+
+	if (connection_p)
+		{
+			json_t *req_p = json_pack ("{s:i,s:s}", "value", 99, "name", "rope");
+
+			if (req_p)
+				{
+					const char *res_s = MakeRemoteJsonCallViaConnection (connection_p, req_p);
+					json_t *res_p = res_s ? json_loads (res_s, 0, NULL) : NULL;
+
+					Check ((res_p != NULL) && IsEchoOf (res_p, "value", 99), "RawConnection Client gets the correct response");
+
+					if (res_p)
+						{
+							json_decref (res_p);
+						}
+
+					json_decref (req_p);
+				}
+
+			FreeConnection (connection_p);
+		}
+	else
+		{
+			Check (false, "connect RawConnection Client");
+		}
+}
+
+
+static void RunLoadGenerator (RawConnectionServer *server_p, const uint32 num_clients)
+{
+	int *fds_p = (int *) AllocMemoryArray (num_clients, sizeof (int));
+
+	if (fds_p)
+		{
+			const uint16 port = GetRawConnectionServerPort (server_p);
+			struct timespec start;
+			uint32 num_connected = 0;
+			uint32 num_correct = 0;
+			uint32 i;
+			char message [32];
+
+			clock_gettime (CLOCK_MONOTONIC, &start);
+
+			for (i = 0; i < num_clients; ++ i)
+				{
+					fds_p [i] = ConnectToServer (port);
+
+					if (fds_p [i] != -1)
+						{
+							++ num_connected;
+						}
+				}
+
+			printf ("connected " UINT32_FMT " Clients in %.2f s\n", num_connected, GetElapsedSeconds (&start));
+			Check (num_connected == num_clients, "all Clients connect");
+			Check (WaitForNumConnections (server_p, num_connected), "Server has all of the connections");
+
+			clock_gettime (CLOCK_MONOTONIC, &start);
+
+			/* Every Client sends its request before any of the responses are read */
+			for (i = 0; i < num_clients; ++ i)
+				{
+					if (fds_p [i] != -1)
+						{
+							sprintf (message, "{\"client\": " UINT32_FMT "}", i);
+
+							if (!SendRequest (fds_p [i], message, i, 5))
+								{
+									close (fds_p [i]);
+									fds_p [i] = -1;
+								}
+						}
+				}
+
+			for (i = 0; i < num_clients; ++ i)
+				{
+					if (fds_p [i] != -1)
+						{
+							uint32 id = 0;
+							json_t *res_p = ReceiveResponse (fds_p [i], &id);
+
+							if (res_p)
+								{
+									if ((id == i) && IsEchoOf (res_p, "client", i))
+										{
+											++ num_correct;
+										}
+
+									json_decref (res_p);
+								}
+						}
+				}
+
+			printf ("served " UINT32_FMT " simultaneous requests in %.2f s\n", num_correct, GetElapsedSeconds (&start));
+			Check (num_correct == num_clients, "all Clients get the correct response");
+
+			for (i = 0; i < num_clients; ++ i)
+				{
+					if (fds_p [i] != -1)
+						{
+							close (fds_p [i]);
+						}
+				}
+
+			Check (WaitForNumConnections (server_p, 0), "Server closes disconnected Clients");
+
+			FreeMemory (fds_p);
+		}
+}
+
+
+/* Make sure that we can have enough sockets open for both ends of every Client */
+static uint32 RaiseFileLimit (uint32 num_clients)
+{
+	struct rlimit limit;
+
+	if (getrlimit (RLIMIT_NOFILE, &limit) == 0)
+		{
+			const rlim_t required = (2 * num_clients) + 64;
+
+			if (limit.rlim_cur < required)
+				{
+					limit.rlim_cur = (limit.rlim_max < required) ? limit.rlim_max : required;
+					setrlimit (RLIMIT_NOFILE, &limit);
+					getrlimit (RLIMIT_NOFILE, &limit);
+				}
+
+			if (limit.rlim_cur < required)
+				{
+					num_clients = (uint32) ((limit.rlim_cur - 64) / 2);
+					printf ("open file limit only allows " UINT32_FMT " Clients\n", num_clients);
+				}
+		}
+
+	return num_clients;
+}
+
+
+int main (int argc, char *argv [])
+{
+	uint32 num_clients = (argc > 1) ? (uint32) atoi (argv [1]) : DEFAULT_NUM_CLIENTS;
+	RawConnectionServer *server_p;
+
+	num_clients = RaiseFileLimit (num_clients);
+
+	server_p = AllocateRawConnectionServer ("0", 0, 0, EchoRequest, NULL);
+
+	if (server_p)
+		{
+			Check (GetRawConnectionServerPort (server_p) != 0, "Server has a port");
+
+			if (StartRawConnectionServer (server_p))
+				{
+					TestFragmentedRequest (server_p);
+					TestPipelinedRequests (server_p);
+					TestLargeRequest (server_p);
+					TestSlowRequest ();
+					TestRawConnectionClient (server_p);
+					RunLoadGenerator (server_p, num_clients);
+
+					StopRawConnectionServer (server_p);
+				}
+			else
+				{
+					Check (false, "start Server");
+				}
+
+			FreeRawConnectionServer (server_p);
+		}
+	else
+		{
+			Check (false, "allocate Server");
+		}
+
+	return GetTestResult ();
+}
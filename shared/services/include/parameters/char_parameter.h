@@ -103,7 +103,7 @@ GRASSROOTS_SERVICE_API bool IsCharParameterBounded (const CharParameter *param_p
 GRASSROOTS_SERVICE_API bool GetCharParameterBounds (const CharParameter *param_p, char *min_p, char *max_p);
 
 
-GRASSROOTS_SERVICE_API bool IsCharParameter (Parameter *param_p);
+GRASSROOTS_SERVICE_API bool IsCharParameter (const Parameter *param_p);
 
 
 GRASSROOTS_SERVICE_API bool GetCurrentCharParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const char **value_pp);
@@ -114,7 +114,7 @@ GRASSROOTS_SERVICE_API const json_t *GetJSONParameterDefaultValue (const JSONPar
 GRASSROOTS_SERVICE_API bool SetJSONParameterDefaultValue (JSONParameter *param_p, const json_t *value_p);
 
 
-GRASSROOTS_SERVICE_API bool IsJSONParameter (Parameter *param_p);
+GRASSROOTS_SERVICE_API bool IsJSONParameter (const Parameter *param_p);
 
 
 GRASSROOTS_SERVICE_API bool GetCurrentJSONParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const json_t **value_pp);
@@ -138,8 +138,11 @@ struct Parameter
 	/** The type of the parameter. */
 	ParameterType pa_type;
 
-	/** The name of the parameter. */
-	char *pa_name_s;
+	/**
+	 * The name of the parameter. This is an interned string so
+	 * Parameters with the same name share the same pointer.
+	 */
+	const char *pa_name_s;
 
 	/** An optional user-friendly name of the parameter to use for client user interfaces. */
 	char *pa_display_name_s;
@@ -238,6 +241,12 @@ typedef struct ParameterNode
 
 	/** Pointer to the associated Parameter. */
 	Parameter *pn_parameter_p;
+
+	/**
+	 * If this is <code>true</code>, then pn_parameter_p is borrowed from
+	 * a ParameterSetTemplate and will not be freed along with this node.
+	 */
+	bool pn_shared_flag;
 } ParameterNode;
 
 
@@ -593,6 +602,18 @@ GRASSROOTS_SERVICE_API const char *GetGrassrootsTypeAsString (const ParameterTyp
 GRASSROOTS_SERVICE_API bool GetGrassrootsTypeFromString (const char *param_type_s, ParameterType *param_type_p);
 
 
+/**
+ * Get the ParameterType from the JSON definition of a Parameter. This
+ * copes with the definitions from any schema version.
+ *
+ * @param json_p The JSON definition of the Parameter.
+ * @param param_type_p Pointer to where the ParameterType will be set.
+ * @return <code>true</code> if the ParameterType was set successfully, <code>false</code> otherwise.
+ * @memberof Parameter
+ */
+GRASSROOTS_SERVICE_API bool GetParameterTypeFromJSON (const json_t * const json_p, ParameterType *param_type_p);
+
+
 /**
  * Get the configured visibility value for a given ParameterGroup.
  *
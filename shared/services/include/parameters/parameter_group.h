@@ -144,6 +144,14 @@ typedef struct ParameterGroup
 	 */
 	const struct ServiceData *pg_service_data_p;
 
+
+	/**
+	 * The ParameterSet that this ParameterGroup belongs to. This is
+	 * used to copy any Parameters that the ParameterSet shares with
+	 * a ParameterSetTemplate before handing them out.
+	 */
+	struct ParameterSet *pg_param_set_p;
+
 } ParameterGroup;
 
 
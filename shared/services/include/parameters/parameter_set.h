@@ -29,10 +29,21 @@ L** Copyright 2014-2016 The Earlham Institute
 #include "linked_list.h"
 #include "parameter.h"
 #include "json_util.h"
+#include "memory_arena.h"
+#include "hash_map.h"
 
 
 struct ServiceData;
-struct Service;
+struct Service;
+
+
+/**
+ * Once a ParameterSet has this many Parameters, lookups by name
+ * use a hashed index rather than walking the list of Parameters.
+ *
+ * @ingroup parameters_group
+ */
+#define PARAMETER_SET_INDEX_THRESHOLD (8)
 
 #include "parameter_group.h"
 
@@ -59,7 +70,10 @@ typedef struct ParameterSet
 
 	/**
 	 * A LinkedList of ParameterNodes containing the
-	 * Parameters.
+	 * Parameters. Any node whose pn_shared_flag is set
+	 * has a Parameter that belongs to a ParameterSetTemplate,
+	 * so use GetWritableParameterFromParameterNode () before
+	 * changing a Parameter found by going through this list.
 	 */
 	LinkedList *ps_params_p;
 
@@ -69,6 +83,15 @@ typedef struct ParameterSet
 	 */
 	LinkedList *ps_grouped_params_p;
 
+	/**
+	 * A HashMap from the Parameter names to their
+	 * ParameterNodes in ps_params_p. This is NULL until the
+	 * ParameterSet has PARAMETER_SET_INDEX_THRESHOLD Parameters.
+	 * If more than one Parameter has the same name, the index
+	 * refers to the first one, as a search of the list would.
+	 */
+	HashMap *ps_name_index_p;
+
 	/**
 	 * This is used when responding to parameters sent by another Grassroots
 	 * Server or Client if there are two different run routines depending upon
@@ -129,6 +152,20 @@ GRASSROOTS_SERVICE_API void FreeParameterSet (ParameterSet *params_p);
  */
 GRASSROOTS_SERVICE_API bool AddParameterToParameterSet (ParameterSet *params_p, Parameter *param_p);
 
+
+/**
+ * Add a Parameter that belongs to a ParameterSetTemplate to a ParameterSet.
+ * The ParameterSet will not free the Parameter and the accessors that return
+ * a Parameter that can be changed, such as GetParameterFromParameterSetByName (),
+ * replace it with a copy first.
+ *
+ * @param params_p The ParameterSet to amend.
+ * @param param_p The Parameter to share.
+ * @return <code>true</code> if the Parameter was added successfully, <code>false</code> otherwise.
+ * @memberof ParameterSet
+ */
+GRASSROOTS_SERVICE_API bool AddSharedParameterToParameterSet (ParameterSet *params_p, Parameter *param_p);
+
 
 /**
  * Replace a Parameter in a ParameterSet.
@@ -204,30 +241,126 @@ GRASSROOTS_SERVICE_API json_t *GetParameterSetSelectionAsJSON (const ParameterSe
  * @see CreateParameterFromJSON
  */
 GRASSROOTS_SERVICE_API ParameterSet *CreateParameterSetFromJSON (const json_t * const json_p, struct Service *service_p, const bool concise_flag);
+
+
+/**
+ * Create a new ParameterSet from a json-based description whose lifetime
+ * is tied to a MemoryArena. This is for ParameterSets that are only needed
+ * whilst a single request is processed.
+ *
+ * @param json_p The json-based representation of the ParameterSet.
+ * @param service_p The Service that the ParameterSet is for.
+ * @param concise_flag This has the same meaning as for CreateParameterSetFromJSON().
+ * @param arena_p The MemoryArena that owns the new ParameterSet. The ParameterSet will
+ * be freed when this is reset or freed so FreeParameterSet() must not be called on it.
+ * @return  The newly-generated ParameterSet or <code>NULL</code> if there was
+ * an error.
+ * @memberof ParameterSet
+ * @see CreateParameterSetFromJSON
+ */
+GRASSROOTS_SERVICE_API ParameterSet *CreateParameterSetFromJSONInArena (const json_t * const json_p, struct Service *service_p, const bool concise_flag, MemoryArena *arena_p);
 
 
 /**
  * Get the Parameter with a given name from a ParameterSet.
  *
+ * If the Parameter is shared with a ParameterSetTemplate, it is replaced
+ * in this ParameterSet by a copy which is returned instead, so the
+ * Parameter can always be changed. To just read a Parameter's value,
+ * use the relevant GetCurrent...ParameterValueFromParameterSet ()
+ * function which doesn't need to copy it.
+ *
  * @param params_p The ParameterSet to search.
  * @param name_s The Parameter name to try and match.
  * @return  The Parameter with the matching name or <code>NULL</code> if it could not
- * be found
+ * be found or copied.
  * @memberof ParameterSet
  */
 GRASSROOTS_SERVICE_API Parameter *GetParameterFromParameterSetByName (const ParameterSet * const params_p, const char * const name_s);
+
+
+/**
+ * Get the ParameterNode for a Parameter with a given name from a ParameterSet.
+ * As with GetParameterFromParameterSetByName (), a Parameter shared with a
+ * ParameterSetTemplate is copied first.
+ *
+ * @param params_p The ParameterSet to search.
+ * @param name_s The Parameter name to try and match.
+ * @return  The ParameterNode with the matching Parameter name or <code>NULL</code> if it could not
+ * be found or copied.
+ * @memberof ParameterSet
+ */
+GRASSROOTS_SERVICE_API ParameterNode *GetParameterNodeFromParameterSetByName (const ParameterSet * const params_p, const char * const name_s);
+
+
+/**
+ * Find the ParameterNode for a Parameter with a given name in a ParameterSet
+ * without copying a Parameter that is shared with a ParameterSetTemplate.
+ * If the node's pn_shared_flag is set, its Parameter must not be changed.
+ *
+ * @param params_p The ParameterSet to search.
+ * @param name_s The Parameter name to try and match.
+ * @return  The ParameterNode with the matching Parameter name or <code>NULL</code> if it could not
+ * be found
+ * @memberof ParameterSet
+ */
+GRASSROOTS_SERVICE_LOCAL ParameterNode *FindParameterNodeInParameterSet (const ParameterSet * const params_p, const char * const name_s);
+
+
+/**
+ * Find the Parameter with a given name in a ParameterSet so that it can be
+ * read without copying it if it is shared with a ParameterSetTemplate.
+ *
+ * @param params_p The ParameterSet to search.
+ * @param name_s The Parameter name to try and match.
+ * @return  The Parameter with the matching name or <code>NULL</code> if it could not
+ * be found
+ * @memberof ParameterSet
+ */
+GRASSROOTS_SERVICE_LOCAL const Parameter *FindParameterInParameterSet (const ParameterSet * const params_p, const char * const name_s);
+
+
+/**
+ * Get a Parameter with a given name from a ParameterSet so that its value
+ * can be changed. If the Parameter is shared with a ParameterSetTemplate,
+ * it is replaced in this ParameterSet by a copy which is returned instead.
+ *
+ * @param params_p The ParameterSet to search.
+ * @param name_s The Parameter name to try and match.
+ * @return  The Parameter with the matching name or <code>NULL</code> if it could not
+ * be found or copied.
+ * @memberof ParameterSet
+ */
+GRASSROOTS_SERVICE_API Parameter *GetWritableParameterFromParameterSet (ParameterSet *params_p, const char * const name_s);
+
+
+/**
+ * Get the Parameter from one of a ParameterSet's ParameterNodes so that its
+ * value can be changed. This is for code that goes through the ParameterSet's
+ * ps_params_p list directly and, as with GetWritableParameterFromParameterSet (),
+ * a Parameter that is shared with a ParameterSetTemplate is replaced by a copy.
+ *
+ * @param params_p The ParameterSet that the ParameterNode belongs to.
+ * @param node_p The ParameterNode.
+ * @return  The Parameter or <code>NULL</code> if it could not be copied.
+ * @memberof ParameterSet
+ */
+GRASSROOTS_SERVICE_API Parameter *GetWritableParameterFromParameterNode (ParameterSet *params_p, ParameterNode *node_p);
 
 
 /**
- * Get the ParameterNode for a Parameter with a given name from a ParameterSet.
+ * Get the Parameter with a given name from a given ParameterGroup
+ * within a ParameterSet. As with GetParameterFromParameterSetByName (),
+ * a Parameter shared with a ParameterSetTemplate is copied first.
  *
  * @param params_p The ParameterSet to search.
+ * @param group_p The ParameterGroup that the Parameter belongs to.
  * @param name_s The Parameter name to try and match.
- * @return  The ParameterNode with the matching Parameter name or <code>NULL</code> if it could not
- * be found
+ * @return  The Parameter with the matching name and ParameterGroup or <code>NULL</code>
+ * if it could not be found
  * @memberof ParameterSet
  */
-GRASSROOTS_SERVICE_API ParameterNode *GetParameterNodeFromParameterSetByName (const ParameterSet * const params_p, const char * const name_s);
+GRASSROOTS_SERVICE_API Parameter *GetParameterFromParameterSetByGroupAndName (const ParameterSet * const params_p, const ParameterGroup * const group_p, const char * const name_s);
 
 
 
@@ -0,0 +1,164 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * parameter_set_template.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A ParameterSetTemplate holds a Service's default ParameterSet so that it
+ * only needs to be built once. ParameterSets created from a template borrow
+ * its Parameters and a Parameter is only copied when its value is changed
+ * from the values in a request or when it is got from the ParameterSet by
+ * any of the functions that return a Parameter that can be changed, such as
+ * GetParameterFromParameterSetByName (). Reading values with the
+ * GetCurrent...ParameterValueFromParameterSet () functions doesn't copy them.
+ *
+ * Services opt in to having their templates cached by setting
+ * ::SERVICE_CACHE_PARAMETERS_S to true in their configuration, since the
+ * cached defaults won't reflect any later changes to e.g. the options
+ * that the Service would offer.
+ */
+
+#ifndef PARAMETER_SET_TEMPLATE_H
+#define PARAMETER_SET_TEMPLATE_H
+
+#include "jansson.h"
+
+#include "grassroots_service_library.h"
+#include "parameter_set.h"
+#include "parameter_validator.h"
+
+
+struct Service;
+
+
+/**
+ * A read-only ParameterSet that other ParameterSets can share
+ * Parameters with.
+ *
+ * @ingroup parameters_group
+ */
+typedef struct ParameterSetTemplate
+{
+	/**
+	 * The default Parameters. These must not be changed once
+	 * the template has been created.
+	 */
+	ParameterSet *pst_params_p;
+
+	/** The name of the Service that the template is for. */
+	char *pst_service_name_s;
+
+	/**
+	 * The compiled constraints of the default Parameters that requests
+	 * can be checked against before they are run. This is <code>NULL</code>
+	 * if they couldn't be compiled.
+	 */
+	ParameterValidator *pst_validator_p;
+} ParameterSetTemplate;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Create a ParameterSetTemplate from a Service's default Parameters.
+ *
+ * The template is built from the JSON definition of the Service's ParameterSet
+ * so it doesn't refer to any data belonging to the Service and can outlive it.
+ *
+ * @param service_p The Service to get the Parameters from.
+ * @return The new ParameterSetTemplate or <code>NULL</code> upon error.
+ * @memberof ParameterSetTemplate
+ */
+GRASSROOTS_SERVICE_API ParameterSetTemplate *AllocateParameterSetTemplate (struct Service *service_p);
+
+
+/**
+ * Free a ParameterSetTemplate. Any ParameterSets that were created from
+ * it must have been freed first.
+ *
+ * @param template_p The ParameterSetTemplate to free.
+ * @memberof ParameterSetTemplate
+ */
+GRASSROOTS_SERVICE_API void FreeParameterSetTemplate (ParameterSetTemplate *template_p);
+
+
+/**
+ * Create a ParameterSet that shares the Parameters of a ParameterSetTemplate
+ * and then apply the values from a request to it.
+ *
+ * For each Parameter in the request that is also in the template, only
+ * the current value is taken from the request and set on a private copy
+ * of the template's Parameter. Parameters that aren't in the template are
+ * created from the request in the same way as CreateParameterSetFromJSON ()
+ * does. Any Parameters that the request doesn't mention keep sharing the
+ * template's default values.
+ *
+ * The new ParameterSet doesn't have any ParameterGroups of its own but its
+ * Parameters still refer to the template's groups.
+ *
+ * @param template_p The ParameterSetTemplate to use.
+ * @param json_p The request to get the values from. This can be <code>NULL</code>
+ * to get a ParameterSet with all of the default values.
+ * @param service_p The Service that the ParameterSet is for.
+ * @param concise_flag If <code>true</code>, any Parameters that are created from
+ * the request use its concise form.
+ * @return The new ParameterSet or <code>NULL</code> upon error. This should be
+ * freed with FreeParameterSet ().
+ * @memberof ParameterSetTemplate
+ * @see CreateParameterSetFromJSON
+ */
+GRASSROOTS_SERVICE_API ParameterSet *CreateParameterSetFromTemplate (const ParameterSetTemplate * const template_p, const json_t * const json_p, struct Service *service_p, const bool concise_flag);
+
+
+/**
+ * Get the cached ParameterSetTemplate for a Service, creating it on first
+ * use.
+ *
+ * @param service_p The Service to get the ParameterSetTemplate for.
+ * @return The ParameterSetTemplate or <code>NULL</code> if the Service hasn't
+ * enabled ::SERVICE_CACHE_PARAMETERS_S in its configuration or upon error.
+ * The template stays valid until FreeParameterSetTemplates () is called.
+ * @memberof ParameterSetTemplate
+ */
+GRASSROOTS_SERVICE_API const ParameterSetTemplate *GetServiceParameterSetTemplate (struct Service *service_p);
+
+
+/**
+ * Free all of the cached ParameterSetTemplates. This should only be
+ * called when no ParameterSets created from them are still in use,
+ * e.g. when the Grassroots Server is shutting down.
+ *
+ * @ingroup parameters_group
+ */
+GRASSROOTS_SERVICE_API void FreeParameterSetTemplates (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef PARAMETER_SET_TEMPLATE_H */
@@ -0,0 +1,126 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * parameter_validator.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A ParameterValidator holds the constraints declared by a Service's
+ * Parameters, i.e. whether they are required, their bounds and their
+ * allowed options, compiled into a sorted array so that the values of a
+ * whole ParameterSet can be checked in a single pass before a job is run.
+ */
+
+#ifndef PARAMETER_VALIDATOR_H
+#define PARAMETER_VALIDATOR_H
+
+#include "grassroots_service_library.h"
+#include "parameter_set.h"
+#include "vector.h"
+
+
+struct ParameterConstraint;
+
+
+/**
+ * The compiled constraints for a set of Parameters.
+ *
+ * @ingroup parameters_group
+ */
+typedef struct ParameterValidator
+{
+	/** @privatesection */
+
+	/* Sorted by the addresses of their interned Parameter names */
+	struct ParameterConstraint *pv_constraints_p;
+
+	uint32 pv_num_constraints;
+
+	uint32 pv_num_required;
+} ParameterValidator;
+
+
+/**
+ * The details of a Parameter that failed validation.
+ *
+ * @ingroup parameters_group
+ */
+typedef struct ParameterValidationError
+{
+	/** The name of the Parameter. */
+	const char *pve_param_s;
+
+	/** The type of the Parameter. */
+	ParameterType pve_type;
+
+	/** A description of the constraint that the value broke. */
+	const char *pve_error_s;
+} ParameterValidationError;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Compile the constraints of a ParameterSet's Parameters into a ParameterValidator.
+ *
+ * The constraints are copied so the ParameterValidator doesn't depend upon
+ * the ParameterSet once it has been created.
+ *
+ * @param params_p The ParameterSet with the Parameters' default definitions.
+ * @return The new ParameterValidator or <code>NULL</code> upon error.
+ * @memberof ParameterValidator
+ */
+GRASSROOTS_SERVICE_API ParameterValidator *AllocateParameterValidator (const ParameterSet * const params_p);
+
+
+/**
+ * Free a ParameterValidator.
+ *
+ * @param validator_p The ParameterValidator to free.
+ * @memberof ParameterValidator
+ */
+GRASSROOTS_SERVICE_API void FreeParameterValidator (ParameterValidator *validator_p);
+
+
+/**
+ * Check the current values of a ParameterSet against a ParameterValidator.
+ *
+ * @param validator_p The ParameterValidator to use.
+ * @param params_p The ParameterSet to check.
+ * @param errors_p If this is not <code>NULL</code>, a ParameterValidationError is
+ * appended to this Vector for every failure. If it is <code>NULL</code>, the
+ * checking stops at the first failure.
+ * @return The number of failures, so 0 if the ParameterSet is valid.
+ * @memberof ParameterValidator
+ */
+GRASSROOTS_SERVICE_API uint32 ValidateParameterSet (const ParameterValidator * const validator_p, const ParameterSet * const params_p, Vector *errors_p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef PARAMETER_VALIDATOR_H */
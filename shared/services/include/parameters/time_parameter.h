@@ -103,7 +103,7 @@ GRASSROOTS_SERVICE_API const struct tm *GetTimeParameterDefaultValue (const Time
 GRASSROOTS_SERVICE_API bool SetTimeParameterDefaultValue (TimeParameter *param_p, const struct tm *value_p);
 
 
-GRASSROOTS_SERVICE_API bool IsTimeParameter (Parameter *param_p);
+GRASSROOTS_SERVICE_API bool IsTimeParameter (const Parameter *param_p);
 
 
 GRASSROOTS_SERVICE_API bool GetCurrentTimeParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const struct tm **value_pp);
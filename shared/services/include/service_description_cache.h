@@ -0,0 +1,124 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * service_description_cache.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * Listing the available Services is the first thing that most Clients do
+ * and building the description of a Service, with its Parameters, metadata
+ * and provider details, is repeated in full for every request. Services
+ * whose descriptions don't depend upon the User or DataResource can set
+ * ::SERVICE_CACHE_DESCRIPTION_S to true in their configuration so that
+ * their descriptions are only built once and copied after that.
+ *
+ * Each description is cached along with the Service configuration that it
+ * was built from. Since a Service's configuration file is read afresh each
+ * time that the Service is loaded, editing it invalidates the description
+ * the next time that it is requested.
+ */
+
+#ifndef SERVICE_DESCRIPTION_CACHE_H
+#define SERVICE_DESCRIPTION_CACHE_H
+
+#include "jansson.h"
+
+#include "grassroots_service_library.h"
+#include "typedefs.h"
+
+
+struct Service;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Check whether a Service has enabled ::SERVICE_CACHE_DESCRIPTION_S
+ * in its configuration.
+ *
+ * @param service_p The Service to check.
+ * @return <code>true</code> if the Service's description can be cached,
+ * <code>false</code> otherwise.
+ * @ingroup services_group
+ */
+GRASSROOTS_SERVICE_API bool IsServiceDescriptionCachingEnabled (const struct Service *service_p);
+
+
+/**
+ * Get a copy of the cached description of a Service. If the description
+ * was cached with a different configuration to config_p, it is invalidated.
+ *
+ * @param service_name_s The name of the Service.
+ * @param config_p The Service's current configuration. This can be <code>NULL</code>.
+ * @return A copy of the cached description which the caller is responsible
+ * for freeing with json_decref () or <code>NULL</code> if there isn't a
+ * current one.
+ * @ingroup services_group
+ */
+GRASSROOTS_SERVICE_API json_t *GetCachedServiceDescription (const char *service_name_s, const json_t *config_p);
+
+
+/**
+ * Cache the description of a Service. If another description has already
+ * been cached for the Service, that one is kept.
+ *
+ * @param service_name_s The name of the Service.
+ * @param config_p The configuration that the description was built from.
+ * This can be <code>NULL</code> and is copied so the caller keeps ownership of it.
+ * @param description_p The description to cache. This is copied so the
+ * caller keeps ownership of it.
+ * @return <code>true</code> if the Service has a cached description,
+ * <code>false</code> otherwise.
+ * @ingroup services_group
+ */
+GRASSROOTS_SERVICE_API bool CacheServiceDescription (const char *service_name_s, const json_t *config_p, const json_t *description_p);
+
+
+/**
+ * Remove the cached description of a Service, e.g. when its Parameters
+ * have changed, so that it will be built afresh the next time that it
+ * is needed.
+ *
+ * @param service_name_s The name of the Service.
+ * @ingroup services_group
+ */
+GRASSROOTS_SERVICE_API void InvalidateServiceDescription (const char *service_name_s);
+
+
+/**
+ * Free all of the cached Service descriptions. This should be called
+ * when the Grassroots Server is shutting down.
+ *
+ * @ingroup services_group
+ */
+GRASSROOTS_SERVICE_API void FreeServiceDescriptions (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef SERVICE_DESCRIPTION_CACHE_H */
@@ -32,9 +32,11 @@
 #include "grassroots_service_library.h"
 #include "operation.h"
 #include "jansson.h"
+#include "json_writer.h"
 #include "linked_list.h"
 #include "memory_allocations.h"
 #include "linked_service.h"
+#include "streams.h"
 
 
 #include "uuid_defs.h"
@@ -158,6 +160,14 @@ typedef struct ServiceJob
 	 * you need to check its type
 	 */
 	char *sj_type_s;
+
+	/**
+	 * The correlation id of the request that started this ServiceJob
+	 * or an empty string if there wasn't one.
+	 *
+	 * @see SetLogCorrelationId
+	 */
+	char sj_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE];
 } ServiceJob;
 
 
@@ -443,6 +453,31 @@ GRASSROOTS_SERVICE_API bool SetServiceJobURL (ServiceJob *job_p, const char * co
 GRASSROOTS_SERVICE_API bool SetServiceJobName (ServiceJob *job_p, const char * const name_s);
 
 
+/**
+ * @brief Set the correlation id of a ServiceJob.
+ *
+ * This is called when a ServiceJob is initialised to store the correlation id
+ * of the request that is currently being processed by the calling thread.
+ *
+ * @param job_p The ServiceJob to alter.
+ * @param id_s The correlation id to set or <code>NULL</code> to clear it.
+ * This is copied so it does not need to stay in scope.
+ * @memberof ServiceJob
+ * @see SetLogCorrelationId
+ */
+GRASSROOTS_SERVICE_API void SetServiceJobCorrelationId (ServiceJob *job_p, const char * const id_s);
+
+
+/**
+ * @brief Get the correlation id of a ServiceJob.
+ *
+ * @param job_p The ServiceJob to query.
+ * @return The correlation id or <code>NULL</code> if it doesn't have one.
+ * @memberof ServiceJob
+ */
+GRASSROOTS_SERVICE_API const char *GetServiceJobCorrelationId (const ServiceJob *job_p);
+
+
 /**
  * @brief Allocate a ServiceJobSet.
  *
@@ -564,6 +599,41 @@ GRASSROOTS_SERVICE_API json_t *GetServiceJobStatusAsJSON (ServiceJob *job_p, boo
 GRASSROOTS_SERVICE_API bool ProcessServiceJobSet (ServiceJobSet *jobs_p, json_t *res_p);
 
 
+/**
+ * @brief Write a ServiceJob as JSON.
+ *
+ * The JSON comes from GetServiceJobAsJSON () so the two always match. That
+ * only refers to the job's results rather than copying them, and they are
+ * streamed to the JSONWriter without being dumped to an intermediate string.
+ *
+ * @param job_p The ServiceJob to write.
+ * @param writer_p The JSONWriter to write the ServiceJob to.
+ * @param omit_results_flag If this is <code>true</code> then just the minimal status information for
+ * the ServiceJob will be written. If it is <code>false</code> then the job results will be included too if possible.
+ * @return <code>true</code> if the ServiceJob was written successfully, <code>false</code>
+ * otherwise. If the ServiceJob couldn't be converted to JSON, nothing will have been
+ * written for it.
+ * @memberof ServiceJob
+ */
+GRASSROOTS_SERVICE_API bool WriteServiceJobAsJSON (ServiceJob *job_p, JSONWriter *writer_p, bool omit_results_flag);
+
+
+/**
+ * Process all ServiceJobs within a ServiceJobSet, writing them as a JSON array.
+ *
+ * This is the streaming equivalent of ProcessServiceJobSet () and the array
+ * holds the same entries that ProcessServiceJobSet () would append, since
+ * both get each entry in the same way.
+ *
+ * @param jobs_p The ServiceJobSet to process.
+ * @param writer_p The JSONWriter to write the array to.
+ * @return <code>true</code> if all ServiceJobs within the ServiceJobSet
+ * were processed successfully, <code>false</code> otherwise.
+ * @memberof ServiceJobSet
+ */
+GRASSROOTS_SERVICE_API bool WriteServiceJobSetAsJSON (ServiceJobSet *jobs_p, JSONWriter *writer_p);
+
+
 /**
  * @brief Create a ServiceJob from a json_t object.
  *
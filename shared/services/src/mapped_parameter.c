@@ -158,7 +158,7 @@ bool SetMappedStringParameterValue (MappedParameter *mapped_param_p, ParameterSe
 
 	if (strcmp (mapped_param_p -> mp_output_param_s, S_MAPPED_PARAM_THIS_VALUE_S) == 0)
 		{
-			Parameter *param_p = GetParameterFromParameterSetByName (params_p, value_s);
+			Parameter *param_p = GetWritableParameterFromParameterSet (params_p, value_s);
 
 			if (param_p)
 				{
@@ -190,7 +190,7 @@ bool SetMappedStringParameterValue (MappedParameter *mapped_param_p, ParameterSe
 		}		/* if (strcmp (mapped_param_p -> mp_output_param_s, S_MAPPED_PARAM_THIS_VALUE_S) == 0) */
 	else
 		{
-			Parameter *param_p = GetParameterFromParameterSetByName (params_p, mapped_param_p -> mp_output_param_s);
+			Parameter *param_p = GetWritableParameterFromParameterSet (params_p, mapped_param_p -> mp_output_param_s);
 
 			if (param_p)
 				{
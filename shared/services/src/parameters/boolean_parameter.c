@@ -184,7 +184,7 @@ bool IsBooleanParameter (const Parameter *param_p)
 bool GetCurrentBooleanParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const bool **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
@@ -251,7 +251,7 @@ bool GetCharParameterBounds (const CharParameter *param_p, char *min_p, char *ma
 }
 
 
-bool IsCharParameter (Parameter *param_p)
+bool IsCharParameter (const Parameter *param_p)
 {
 	bool char_param_flag = false;
 
@@ -272,7 +272,7 @@ bool IsCharParameter (Parameter *param_p)
 bool GetCurrentCharParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const char **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
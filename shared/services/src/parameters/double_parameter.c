@@ -241,7 +241,7 @@ bool IsDoubleParameter (const Parameter *param_p)
 bool GetCurrentDoubleParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const double64 **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
@@ -180,7 +180,7 @@ bool SetJSONParameterDefaultValue (JSONParameter *param_p, const json_t *value_p
 }
 
 
-bool IsJSONParameter (Parameter *param_p)
+bool IsJSONParameter (const Parameter *param_p)
 {
 	bool json_param_flag = false;
 
@@ -202,7 +202,7 @@ bool IsJSONParameter (Parameter *param_p)
 bool GetCurrentJSONParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const json_t **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
@@ -13,6 +13,7 @@
  ** See the License for the specific language governing permissions and
  ** limitations under the License.
  */
+#include <ctype.h>
 #include <math.h>
 #include <stddef.h>
 #include <string.h>
@@ -24,6 +25,7 @@
 #include "math_utils.h"
 #include "string_utils.h"
 #include "string_hash_table.h"
+#include "string_intern.h"
 #include "parameter_set.h"
 #include "service.h"
 #include "schema_version.h"
@@ -108,9 +110,9 @@ static bool AddParameterVisibilityToJSON (const Parameter * const param_p, json_
 
 static bool CopyBaseParamaeter (const Parameter *src_p, Parameter *dest_p);
 
+static const char *InternParameterName (const char *name_s);
+
 
-static bool GetParameterTypeFromJSON (const json_t * const json_p, ParameterType *param_type_p);
-
 static bool GetParameterLevelFromJSON (const json_t * const json_p, ParameterLevel *level_p);
 
 static bool InitParameterStoreFromJSON (const json_t *root_p, HashTable *store_p);
@@ -641,7 +643,7 @@ void ClearParameter (Parameter *param_p)
 
 	if (param_p -> pa_name_s)
 		{
-			FreeCopiedString (param_p -> pa_name_s);
+			ReleaseInternedString (param_p -> pa_name_s);
 		}
 
 	if (param_p -> pa_display_name_s)
@@ -673,7 +675,7 @@ void FreeParameter (Parameter *param_p)
 
 Parameter *CloneParameter (const Parameter * const src_p, const ServiceData *data_p)
 {
-	Parameter *dest_p = src_p -> pa_clone_fn (src_p, data_p);
+	Parameter *dest_p = (src_p -> pa_clone_fn) ? src_p -> pa_clone_fn (src_p, data_p) : NULL;
 
 	if (dest_p)
 		{
@@ -692,7 +694,6 @@ Parameter *CloneParameter (const Parameter * const src_p, const ServiceData *dat
 static bool CopyBaseParamaeter (const Parameter *src_p, Parameter *dest_p)
 {
 	bool success_flag = true;
-	LinkedList *dest_options_p = NULL;
 
 	if (success_flag)
 		{
@@ -712,44 +713,64 @@ static bool CopyBaseParamaeter (const Parameter *src_p, Parameter *dest_p)
 
 					if (dest_store_p)
 						{
-							char *dest_name_s = NULL;
+							char *dest_display_name_s = NULL;
 
-							if (CloneValidString (src_p -> pa_name_s, &dest_name_s))
+							if (CloneValidString (src_p -> pa_display_name_s, &dest_display_name_s))
 								{
-									char *dest_display_name_s = NULL;
+									char *dest_description_s = NULL;
 
-									if (CloneValidString (src_p -> pa_display_name_s, &dest_display_name_s))
+									if (CloneValidString (src_p -> pa_description_s, &dest_description_s))
 										{
-											char *dest_description_s = NULL;
+											/* Parameter names are interned so the copy can share the name */
+											if (dest_p -> pa_name_s)
+												{
+													ReleaseInternedString (dest_p -> pa_name_s);
+												}
 
-											if (CloneValidString (src_p -> pa_description_s, &dest_description_s))
+											/*
+											 * The type-specific clone function will have already set these
+											 * and its own copies of any options, so only replace the strings
+											 * and store.
+											 */
+											if (dest_p -> pa_display_name_s)
 												{
-													dest_p -> pa_type = src_p -> pa_type;
-													dest_p -> pa_name_s = dest_name_s;
-													dest_p -> pa_display_name_s = dest_display_name_s;
-													dest_p -> pa_description_s = dest_description_s;
-													dest_p -> pa_options_p = dest_options_p;
-													dest_p -> pa_level = src_p -> pa_level;
-													dest_p -> pa_visible_flag = src_p -> pa_visible_flag;
-													dest_p -> pa_refresh_service_flag = src_p -> pa_refresh_service_flag;
-													dest_p -> pa_required_flag = src_p -> pa_required_flag;
+													FreeCopiedString (dest_p -> pa_display_name_s);
+												}
 
-													dest_p -> pa_clear_fn = src_p -> pa_clear_fn;
-													dest_p -> pa_add_values_to_json_fn = src_p -> pa_add_values_to_json_fn;
-													dest_p -> pa_clone_fn = src_p -> pa_clone_fn;
+											if (dest_p -> pa_description_s)
+												{
+													FreeCopiedString (dest_p -> pa_description_s);
+												}
+
+											if (dest_p -> pa_store_p)
+												{
+													FreeHashTable (dest_p -> pa_store_p);
+												}
 
+											dest_p -> pa_type = src_p -> pa_type;
+											dest_p -> pa_name_s = (src_p -> pa_name_s) ? RetainInternedString (src_p -> pa_name_s) : NULL;
+											dest_p -> pa_display_name_s = dest_display_name_s;
+											dest_p -> pa_description_s = dest_description_s;
+											dest_p -> pa_level = src_p -> pa_level;
+											dest_p -> pa_visible_flag = src_p -> pa_visible_flag;
+											dest_p -> pa_refresh_service_flag = src_p -> pa_refresh_service_flag;
+											dest_p -> pa_required_flag = src_p -> pa_required_flag;
 
-													dest_p -> pa_group_p = src_p -> pa_group_p;
-													dest_p -> pa_store_p = src_p -> pa_store_p;
+											dest_p -> pa_clear_fn = src_p -> pa_clear_fn;
+											dest_p -> pa_add_values_to_json_fn = src_p -> pa_add_values_to_json_fn;
+											dest_p -> pa_clone_fn = src_p -> pa_clone_fn;
 
-													return true;
-												}		/* if (CloneValidString (src_p -> pa_description_s, &dest_description_s)) */
 
-											FreeCopiedString (dest_display_name_s);
-										}		/* if (CloneValidString (src_p -> pa_display_name_s, &dest_display_name_s)) */
+											dest_p -> pa_group_p = src_p -> pa_group_p;
+											dest_p -> pa_store_p = dest_store_p;
+
+											return true;
+										}		/* if (CloneValidString (src_p -> pa_description_s, &dest_description_s)) */
+
+									FreeCopiedString (dest_display_name_s);
+								}		/* if (CloneValidString (src_p -> pa_display_name_s, &dest_display_name_s)) */
 
-									FreeCopiedString (dest_name_s);
-								}		/* if (CloneValidString (src_p -> pa_name_s, &dest_name_s)) */
+							FreeHashTable (dest_store_p);
 
 						}		/* if (dest_store_p) */
 
@@ -763,7 +784,7 @@ static bool CopyBaseParamaeter (const Parameter *src_p, Parameter *dest_p)
 
 ParameterNode *AllocateParameterNode (Parameter *param_p)
 {
-	ParameterNode *node_p = (ParameterNode *) AllocMemory (sizeof (ParameterNode));
+	ParameterNode *node_p = (ParameterNode *) AllocListNodeMemory (sizeof (ParameterNode));
 
 	if (node_p)
 		{
@@ -771,6 +792,7 @@ ParameterNode *AllocateParameterNode (Parameter *param_p)
 			node_p -> pn_node.ln_next_p = NULL;
 
 			node_p -> pn_parameter_p = param_p;
+			node_p -> pn_shared_flag = false;
 		}		/* if (node_p) */
 
 	return node_p;
@@ -781,12 +803,12 @@ void FreeParameterNode (ListItem *node_p)
 {
 	ParameterNode *param_node_p = (ParameterNode *) node_p;
 
-	if (param_node_p -> pn_parameter_p)
+	if ((param_node_p -> pn_parameter_p) && (!param_node_p -> pn_shared_flag))
 		{
 			FreeParameter (param_node_p -> pn_parameter_p);
 		}
 
-	FreeMemory (param_node_p);
+	FreeListNodeMemory (param_node_p);
 }
 
 
@@ -2200,7 +2222,7 @@ static bool GetParameterLevelFromJSON (const json_t * const json_p, ParameterLev
 }
 
 
-static bool GetParameterTypeFromJSON (const json_t * const json_p, ParameterType *param_type_p)
+bool GetParameterTypeFromJSON (const json_t * const json_p, ParameterType *param_type_p)
 {
 	bool success_flag = false;
 
@@ -2708,7 +2730,7 @@ static bool GetParameterStringFromConfig (const json_t *service_config_p, const
 static bool InitParameterWithoutCallbacks (Parameter *param_p, const struct ServiceData *service_data_p, ParameterType type, const char * const name_s,
 																					 const char * const display_name_s, const char * const description_s, ParameterLevel level)
 {
-	char *new_name_s = CopyToNewString (name_s, 0, true);
+	const char *new_name_s = InternParameterName (name_s);
 
 	if (new_name_s)
 		{
@@ -2794,7 +2816,7 @@ static bool InitParameterWithoutCallbacks (Parameter *param_p, const struct Serv
 
 				}		/* if (success_flag) */
 
-			FreeCopiedString (new_name_s);
+			ReleaseInternedString (new_name_s);
 		}		/* if (new_name_s) */
 
 	return false;
@@ -2817,3 +2839,30 @@ LinkedList *GetParameterStringMultiOptions (Parameter *param_p)
 }
 
 
+
+/*
+ * Parameter names have always had any surrounding whitespace trimmed so only
+ * make a temporary trimmed copy when there is some to remove.
+ */
+static const char *InternParameterName (const char *name_s)
+{
+	const char *interned_s = NULL;
+	const size_t l = strlen (name_s);
+
+	if ((l > 0) && (isspace (name_s [0]) || isspace (name_s [l - 1])))
+		{
+			char *trimmed_s = CopyToNewString (name_s, 0, true);
+
+			if (trimmed_s)
+				{
+					interned_s = InternString (trimmed_s);
+					FreeCopiedString (trimmed_s);
+				}
+		}
+	else
+		{
+			interned_s = InternString (name_s);
+		}
+
+	return interned_s;
+}
@@ -43,12 +43,16 @@ static bool AddRepeatableLabelParamsToJSON (const ParameterGroup * const group_p
 
 static bool SetRepeatableLabelParamsFromJSON (ParameterGroup * const group_p, const json_t *json_p);
 
+static void FreeGroupParameterNode (ListItem *node_p);
+
+static ParameterNode *FindParameterNodeInParameterGroup (const ParameterGroup * const group_p, const char * const name_s);
+
 
 
 
 ParameterGroupNode *AllocateParameterGroupNode (ParameterGroup *group_p)
 {
-	ParameterGroupNode *param_group_node_p = (ParameterGroupNode *) AllocMemory (sizeof (ParameterGroupNode));
+	ParameterGroupNode *param_group_node_p = (ParameterGroupNode *) AllocListNodeMemory (sizeof (ParameterGroupNode));
 
 	if (param_group_node_p)
 		{
@@ -69,7 +73,7 @@ void FreeParameterGroupNode (ListItem *node_p)
 	ParameterGroupNode *param_group_node_p = (ParameterGroupNode *) node_p;
 
 	FreeParameterGroup (param_group_node_p -> pgn_param_group_p);
-	FreeMemory (param_group_node_p);
+	FreeListNodeMemory (param_group_node_p);
 }
 
 
@@ -89,11 +93,11 @@ ParameterGroup *AllocateParameterGroup (const char *name_s, const bool repeatabl
 					 * freed. So all we need to do on this LinkedList
 					 * is free the memory allocated for the nodes.
 					 */
-					LinkedList *params_p = AllocateLinkedList (NULL);
+					LinkedList *params_p = AllocateLinkedList (FreeGroupParameterNode);
 
 					if (params_p)
 						{
-							LinkedList *repeatable_label_params_p = AllocateLinkedList (NULL);
+							LinkedList *repeatable_label_params_p = AllocateLinkedList (FreeGroupParameterNode);
 
 							if (repeatable_label_params_p)
 								{
@@ -111,6 +115,7 @@ ParameterGroup *AllocateParameterGroup (const char *name_s, const bool repeatabl
 											param_group_p -> pg_repeatable_flag = repeatable_flag;
 											param_group_p -> pg_current_repeatable_group_index = 0;
 											param_group_p -> pg_service_data_p = service_data_p;
+										param_group_p -> pg_param_set_p = NULL;
 											param_group_p -> pg_repeatable_label_params_p = repeatable_label_params_p;
 
 											if (service_data_p)
@@ -212,8 +217,23 @@ bool ReplaceParameterInParameterGroup (ParameterGroup *param_group_p, Parameter
 					node_p -> pn_parameter_p = new_param_p;
 					new_param_p -> pa_group_p = param_group_p;
 
+					/* The Parameter might be one of the labels for a repeatable group too */
+					node_p = (ParameterNode *) (param_group_p -> pg_repeatable_label_params_p -> ll_head_p);
+
+					while (node_p)
+						{
+							if (old_param_p == node_p -> pn_parameter_p)
+								{
+									node_p -> pn_parameter_p = new_param_p;
+								}
+
+							node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
+						}
+
 					return true;
 				}
+
+			node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
 		}
 
 	return false;
@@ -504,6 +524,7 @@ bool AddParameterGroupChild (ParameterGroup *parent_group_p, ParameterGroup *chi
 	if (node_p)
 		{
 			LinkedListAddTail (parent_group_p -> pg_child_groups_p, & (node_p -> pgn_node));
+			child_group_p -> pg_param_set_p = parent_group_p -> pg_param_set_p;
 			success_flag = true;
 		}
 
@@ -611,23 +632,37 @@ bool RemoveParameterGroupChild (ParameterGroup *parent_group_p, ParameterGroup *
 
 ParameterNode *GetParameterNodeFromParameterGroupByName (const ParameterGroup * const group_p, const char * const name_s)
 {
-	ParameterNode *node_p = (ParameterNode *) (group_p -> pg_params_p -> ll_head_p);
+	ParameterNode *node_p = FindParameterNodeInParameterGroup (group_p, name_s);
 
-	while (node_p)
+	if (node_p && (group_p -> pg_param_set_p))
 		{
+			/*
+			 * If the ParameterSet shares this Parameter with a ParameterSetTemplate,
+			 * get it to make a copy that can be changed.
+			 */
 			Parameter *param_p = node_p -> pn_parameter_p;
+			const ParameterNode *set_node_p = FindParameterNodeInParameterSet (group_p -> pg_param_set_p, param_p -> pa_name_s);
 
-			if (strcmp (param_p -> pa_name_s, name_s) == 0)
-				{
-					return node_p;
-				}
-			else
+			if (set_node_p && (set_node_p -> pn_shared_flag) && (set_node_p -> pn_parameter_p == param_p))
 				{
-					node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
+					Parameter *copied_param_p = GetWritableParameterFromParameterNode (group_p -> pg_param_set_p, (ParameterNode *) set_node_p);
+
+					if (copied_param_p)
+						{
+							/* The ParameterSet only updates its top-level groups so make sure that this one has the copy too */
+							if (node_p -> pn_parameter_p == param_p)
+								{
+									ReplaceParameterInParameterGroup ((ParameterGroup *) group_p, param_p, copied_param_p);
+								}
+						}
+					else
+						{
+							node_p = NULL;
+						}
 				}
-		}		/* while (node_p) */
+		}
 
-	return NULL;
+	return node_p;
 }
 
 
@@ -698,6 +733,29 @@ bool AddRepeatableParameterGroupLabelParam (ParameterGroup *group_p, Parameter *
 
 
 
+static ParameterNode *FindParameterNodeInParameterGroup (const ParameterGroup * const group_p, const char * const name_s)
+{
+	ParameterNode *node_p = (ParameterNode *) (group_p -> pg_params_p -> ll_head_p);
+
+	while (node_p)
+		{
+			Parameter *param_p = node_p -> pn_parameter_p;
+
+			/* Interned names match by pointer before falling back to comparing the strings */
+			if ((param_p -> pa_name_s == name_s) || (strcmp (param_p -> pa_name_s, name_s) == 0))
+				{
+					return node_p;
+				}
+			else
+				{
+					node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
+				}
+		}		/* while (node_p) */
+
+	return NULL;
+}
+
+
 static bool AddRepeatableLabelParamsToJSON (const ParameterGroup * const group_p, json_t *json_p)
 {
 	if (group_p -> pg_repeatable_label_params_p -> ll_size > 0)
@@ -810,3 +868,16 @@ static bool SetRepeatableLabelParamsFromJSON (ParameterGroup * const group_p, co
 	return success_flag;
 }
 
+
+
+/*
+ * The Parameters on a ParameterGroup's lists belong to its ParameterSet
+ * so only the nodes themselves are freed here.
+ */
+static void FreeGroupParameterNode (ListItem *node_p)
+{
+	ParameterNode *param_node_p = (ParameterNode *) node_p;
+
+	param_node_p -> pn_parameter_p = NULL;
+	FreeParameterNode (node_p);
+}
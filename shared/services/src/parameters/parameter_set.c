@@ -42,6 +42,26 @@
 
 static bool AddAllParametersToParameterSetJSON (const Parameter *param_p, void *data_p);
 
+static void FreeParameterSetInArena (void *params_p);
+
+static bool AddParameterNodeToParameterSet (ParameterSet *params_p, ParameterNode *node_p);
+
+static bool MakeSharedParameterWritable (ParameterSet *params_p, ParameterNode *node_p);
+
+static void ReplaceSharedParameterInParameterGroup (ParameterSet *params_p, const Parameter *shared_param_p, Parameter *new_param_p);
+
+static bool BuildParameterSetNameIndex (ParameterSet *params_p);
+
+static void RebuildParameterSetNameIndex (ParameterSet *params_p);
+
+static void SetParameterGroupParameterSet (ParameterGroup *group_p, ParameterSet *params_p);
+
+static bool AddParameterNodeToNameIndex (ParameterSet *params_p, ParameterNode *node_p);
+
+static void RemoveParameterNodeFromNameIndex (ParameterSet *params_p, ParameterNode *node_p);
+
+static ParameterNode *FindParameterNodeInList (const ParameterSet * const params_p, const char * const name_s, const ParameterNode *node_to_skip_p);
+
 
 /****************************************/
 /********** PUBLIC FUNCTIONS ************/
@@ -66,6 +86,7 @@ ParameterSet *AllocateParameterSet (const char *name_s, const char *description_
 							set_p -> ps_description_s = description_s;
 							set_p -> ps_grouped_params_p = groups_list_p;
 							set_p -> ps_current_level = PL_ALL;
+							set_p -> ps_name_index_p = NULL;
 
 							return set_p;
 						}
@@ -93,6 +114,11 @@ void FreeParameterSet (ParameterSet *params_p)
 			FreeLinkedList (params_p -> ps_grouped_params_p);
 		}
 
+	if (params_p -> ps_name_index_p)
+		{
+			FreeHashMap (params_p -> ps_name_index_p);
+		}
+
 
 	FreeMemory (params_p);
 }
@@ -106,14 +132,52 @@ bool AddParameterToParameterSet (ParameterSet *params_p, Parameter *param_p)
 
 	if (node_p)
 		{
-			LinkedListAddTail (params_p -> ps_params_p, (ListItem *) node_p);
-			success_flag = true;
+			success_flag = AddParameterNodeToParameterSet (params_p, node_p);
 		}		/* if (node_p) */
 
 	return success_flag;
 }
 
 
+bool AddSharedParameterToParameterSet (ParameterSet *params_p, Parameter *param_p)
+{
+	bool success_flag = false;
+	ParameterNode *node_p = AllocateParameterNode (param_p);
+
+	if (node_p)
+		{
+			node_p -> pn_shared_flag = true;
+			success_flag = AddParameterNodeToParameterSet (params_p, node_p);
+		}		/* if (node_p) */
+
+	return success_flag;
+}
+
+
+Parameter *GetWritableParameterFromParameterSet (ParameterSet *params_p, const char * const name_s)
+{
+	ParameterNode *node_p = FindParameterNodeInParameterSet (params_p, name_s);
+
+	if (node_p)
+		{
+			return GetWritableParameterFromParameterNode (params_p, node_p);
+		}
+
+	return NULL;
+}
+
+
+Parameter *GetWritableParameterFromParameterNode (ParameterSet *params_p, ParameterNode *node_p)
+{
+	if ((!node_p -> pn_shared_flag) || MakeSharedParameterWritable (params_p, node_p))
+		{
+			return node_p -> pn_parameter_p;
+		}
+
+	return NULL;
+}
+
+
 static bool AddAllParametersToParameterSetJSON (const Parameter * UNUSED_PARAM (param_p), void * UNUSED_PARAM (data_p))
 {
 	return true;
@@ -123,26 +187,49 @@ static bool AddAllParametersToParameterSetJSON (const Parameter * UNUSED_PARAM (
 bool ReplaceParameterInParameterSet (ParameterSet *params_p, Parameter *old_param_p, Parameter *new_param_p, const bool free_old_param_flag)
 {
 	bool success_flag = false;
-	ParameterNode *param_node_p = GetParameterNodeFromParameterSetByName (params_p, old_param_p -> pa_name_s);
+	ParameterNode *param_node_p = FindParameterNodeInParameterSet (params_p, old_param_p -> pa_name_s);
+
+	/* The index is keyed by the old name and since renames are rare, just rebuild it */
+	const bool rebuild_index_flag = (params_p -> ps_name_index_p) && (new_param_p -> pa_name_s != old_param_p -> pa_name_s);
+
+	if (param_node_p && (param_node_p -> pn_shared_flag))
+		{
+			/*
+			 * The old Parameter and its group belong to a ParameterSetTemplate
+			 * so leave them alone and just stop sharing it.
+			 */
+			ReplaceSharedParameterInParameterGroup (params_p, old_param_p, new_param_p);
+
+			param_node_p -> pn_parameter_p = new_param_p;
+			param_node_p -> pn_shared_flag = false;
+
+			if (rebuild_index_flag)
+				{
+					RebuildParameterSetNameIndex (params_p);
+				}
 
-	if (param_node_p)
+			success_flag = true;
+		}
+	else if (param_node_p)
 		{
 			ParameterGroup *old_group_p = old_param_p -> pa_group_p;
 
-			if (old_group_p)
+			if ((!old_group_p) || ReplaceParameterInParameterGroup (old_group_p, old_param_p, new_param_p))
 				{
-					if (ReplaceParameterInParameterGroup (old_group_p, old_param_p, new_param_p))
-						{
-							param_node_p -> pn_parameter_p = new_param_p;
+					param_node_p -> pn_parameter_p = new_param_p;
 
-							if (free_old_param_flag)
-								{
-									FreeParameter (old_param_p);
-								}
+					/* Do this whilst the old name is still valid as the index refers to it */
+					if (rebuild_index_flag)
+						{
+							RebuildParameterSetNameIndex (params_p);
+						}
 
-							success_flag = true;
+					if (free_old_param_flag)
+						{
+							FreeParameter (old_param_p);
 						}
 
+					success_flag = true;
 				}
 
 		}
@@ -307,25 +394,49 @@ json_t *GetParameterSetSelectionAsJSON (const ParameterSet * const param_set_p,
 }
 
 
-ParameterNode *GetParameterNodeFromParameterSetByName (const ParameterSet * const params_p, const char * const name_s)
+ParameterNode *FindParameterNodeInParameterSet (const ParameterSet * const params_p, const char * const name_s)
 {
-	ParameterNode *node_p = (ParameterNode *) (params_p -> ps_params_p -> ll_head_p);
+	if (params_p -> ps_name_index_p)
+		{
+			return (ParameterNode *) GetFromHashMap (params_p -> ps_name_index_p, name_s);
+		}
 
-	while (node_p)
+	return FindParameterNodeInList (params_p, name_s, NULL);
+}
+
+
+const Parameter *FindParameterInParameterSet (const ParameterSet * const params_p, const char * const name_s)
+{
+	const ParameterNode *node_p = FindParameterNodeInParameterSet (params_p, name_s);
+
+	if (node_p)
 		{
-			Parameter *param_p = node_p -> pn_parameter_p;
+			return node_p -> pn_parameter_p;
+		}
 
-			if (strcmp (param_p -> pa_name_s, name_s) == 0)
-				{
-					return node_p;
-				}
-			else
+	return NULL;
+}
+
+
+/*
+ * The public accessors hand out Parameters that callers can change, so
+ * any that are shared with a ParameterSetTemplate are copied first. That
+ * changes which Parameter the ParameterSet holds rather than anything
+ * that the caller could see, so params_p stays const for them.
+ */
+ParameterNode *GetParameterNodeFromParameterSetByName (const ParameterSet * const params_p, const char * const name_s)
+{
+	ParameterNode *node_p = FindParameterNodeInParameterSet (params_p, name_s);
+
+	if (node_p && (node_p -> pn_shared_flag))
+		{
+			if (!MakeSharedParameterWritable ((ParameterSet *) params_p, node_p))
 				{
-					node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
+					node_p = NULL;
 				}
-		}		/* while (node_p) */
+		}
 
-	return NULL;
+	return node_p;
 }
 
 
@@ -342,6 +453,23 @@ Parameter *GetParameterFromParameterSetByName (const ParameterSet * const params
 }
 
 
+Parameter *GetParameterFromParameterSetByGroupAndName (const ParameterSet * const params_p, const ParameterGroup * const group_p, const char * const name_s)
+{
+	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+
+	if (param_p && (param_p -> pa_group_p != group_p))
+		{
+			/*
+			 * Another group has a Parameter with the same name
+			 * so check the requested group itself.
+			 */
+			param_p = group_p ? GetParameterFromParameterGroupByName (group_p, name_s) : NULL;
+		}
+
+	return param_p;
+}
+
+
 bool AddParameterGroupToParameterSet (ParameterSet *param_set_p, ParameterGroup *group_p)
 {
 	bool success_flag = false;
@@ -350,6 +478,7 @@ bool AddParameterGroupToParameterSet (ParameterSet *param_set_p, ParameterGroup
 	if (param_group_node_p)
 		{
 			LinkedListAddTail (param_set_p -> ps_grouped_params_p, & (param_group_node_p -> pgn_node));
+			SetParameterGroupParameterSet (group_p, param_set_p);
 			success_flag = true;
 		}
 
@@ -575,6 +704,24 @@ ParameterSet *CreateParameterSetFromJSON (const json_t * const op_p, Service *se
 }
 
 
+ParameterSet *CreateParameterSetFromJSONInArena (const json_t * const json_p, Service *service_p, const bool concise_flag, MemoryArena *arena_p)
+{
+	ParameterSet *params_p = CreateParameterSetFromJSON (json_p, service_p, concise_flag);
+
+	if (params_p)
+		{
+			if (!AddMemoryArenaCleanup (arena_p, FreeParameterSetInArena, params_p))
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add ParameterSet \"%s\" to MemoryArena", params_p -> ps_name_s ? params_p -> ps_name_s : "");
+					FreeParameterSet (params_p);
+					params_p = NULL;
+				}
+		}
+
+	return params_p;
+}
+
+
 ParameterSetNode *AllocateParameterSetNode (ParameterSet *params_p)
 {
 	ParameterSetNode *node_p = AllocMemory (sizeof (ParameterSetNode));
@@ -609,12 +756,18 @@ void FreeParameterSetNode (ListItem *node_p)
 Parameter *DetachParameterByName (ParameterSet *params_p, const char * const name_s)
 {
 	Parameter *param_p = NULL;
-	ParameterNode *node_p = GetParameterNodeFromParameterSetByName (params_p, name_s);
+	ParameterNode *node_p = FindParameterNodeInParameterSet (params_p, name_s);
 
-	if (node_p)
+	/* The caller will own the Parameter so it can't be one that is shared */
+	if (node_p && ((!node_p -> pn_shared_flag) || MakeSharedParameterWritable (params_p, node_p)))
 		{
 			param_p = node_p -> pn_parameter_p;
 
+			if (params_p -> ps_name_index_p)
+				{
+					RemoveParameterNodeFromNameIndex (params_p, node_p);
+				}
+
 			LinkedListRemove (params_p -> ps_params_p, (ListItem * const) node_p);
 
 			node_p -> pn_parameter_p = NULL;
@@ -677,3 +830,219 @@ uint32 GetParameterSetSize (const ParameterSet * const param_set_p)
 /********** STATIC FUNCTIONS ************/
 /****************************************/
 
+
+static void FreeParameterSetInArena (void *params_p)
+{
+	FreeParameterSet ((ParameterSet *) params_p);
+}
+
+
+static bool BuildParameterSetNameIndex (ParameterSet *params_p)
+{
+	const uint32 num_params = params_p -> ps_params_p -> ll_size;
+
+	params_p -> ps_name_index_p = AllocateHashMap (num_params << 1, 75, HMKT_STRING, MF_SHADOW_USE, MF_SHADOW_USE);
+
+	if (params_p -> ps_name_index_p)
+		{
+			ParameterNode *node_p = (ParameterNode *) (params_p -> ps_params_p -> ll_head_p);
+
+			while (node_p)
+				{
+					if (AddParameterNodeToNameIndex (params_p, node_p))
+						{
+							node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
+						}
+					else
+						{
+							FreeHashMap (params_p -> ps_name_index_p);
+							params_p -> ps_name_index_p = NULL;
+
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to index " UINT32_FMT " parameters for \"%s\"", num_params, params_p -> ps_name_s ? params_p -> ps_name_s : "");
+							return false;
+						}
+				}
+
+			return true;
+		}
+
+	return false;
+}
+
+
+static void SetParameterGroupParameterSet (ParameterGroup *group_p, ParameterSet *params_p)
+{
+	ParameterGroupNode *child_node_p = (ParameterGroupNode *) (group_p -> pg_child_groups_p -> ll_head_p);
+
+	group_p -> pg_param_set_p = params_p;
+
+	while (child_node_p)
+		{
+			SetParameterGroupParameterSet (child_node_p -> pgn_param_group_p, params_p);
+			child_node_p = (ParameterGroupNode *) (child_node_p -> pgn_node.ln_next_p);
+		}
+}
+
+
+static void RebuildParameterSetNameIndex (ParameterSet *params_p)
+{
+	FreeHashMap (params_p -> ps_name_index_p);
+	params_p -> ps_name_index_p = NULL;
+
+	BuildParameterSetNameIndex (params_p);
+}
+
+
+/*
+ * Only the first Parameter with any given name is indexed so that
+ * the results match a search of the list.
+ */
+static bool AddParameterNodeToNameIndex (ParameterSet *params_p, ParameterNode *node_p)
+{
+	const char *name_s = node_p -> pn_parameter_p -> pa_name_s;
+
+	if (IsKeyInHashMap (params_p -> ps_name_index_p, name_s))
+		{
+			return true;
+		}
+
+	return PutInHashMap (params_p -> ps_name_index_p, name_s, node_p);
+}
+
+
+static void RemoveParameterNodeFromNameIndex (ParameterSet *params_p, ParameterNode *node_p)
+{
+	const char *name_s = node_p -> pn_parameter_p -> pa_name_s;
+
+	if (GetFromHashMap (params_p -> ps_name_index_p, name_s) == node_p)
+		{
+			ParameterNode *next_match_p = FindParameterNodeInList (params_p, name_s, node_p);
+
+			RemoveFromHashMap (params_p -> ps_name_index_p, name_s);
+
+			if (next_match_p)
+				{
+					if (!PutInHashMap (params_p -> ps_name_index_p, name_s, next_match_p))
+						{
+							FreeHashMap (params_p -> ps_name_index_p);
+							params_p -> ps_name_index_p = NULL;
+						}
+				}
+		}
+}
+
+
+/*
+ * Parameter names are interned so callers that pass another Parameter's
+ * name match by pointer without needing to compare the strings.
+ */
+static ParameterNode *FindParameterNodeInList (const ParameterSet * const params_p, const char * const name_s, const ParameterNode *node_to_skip_p)
+{
+	ParameterNode *node_p = (ParameterNode *) (params_p -> ps_params_p -> ll_head_p);
+
+	while (node_p)
+		{
+			const char *param_name_s = node_p -> pn_parameter_p -> pa_name_s;
+
+			if ((node_p != node_to_skip_p) && ((param_name_s == name_s) || (strcmp (param_name_s, name_s) == 0)))
+				{
+					return node_p;
+				}
+			else
+				{
+					node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
+				}
+		}		/* while (node_p) */
+
+	return NULL;
+}
+
+
+static bool AddParameterNodeToParameterSet (ParameterSet *params_p, ParameterNode *node_p)
+{
+	LinkedListAddTail (params_p -> ps_params_p, (ListItem *) node_p);
+
+	/*
+	 * The index is only an accelerator, so if it can't be
+	 * updated, drop it and go back to searching the list.
+	 */
+	if (params_p -> ps_name_index_p)
+		{
+			if (!AddParameterNodeToNameIndex (params_p, node_p))
+				{
+					FreeHashMap (params_p -> ps_name_index_p);
+					params_p -> ps_name_index_p = NULL;
+				}
+		}
+	else if (params_p -> ps_params_p -> ll_size >= PARAMETER_SET_INDEX_THRESHOLD)
+		{
+			BuildParameterSetNameIndex (params_p);
+		}
+
+	return true;
+}
+
+
+/*
+ * Replace a Parameter borrowed from a ParameterSetTemplate with a copy
+ * that this ParameterSet owns. Types without a clone function are
+ * copied via their full JSON definitions.
+ */
+static bool MakeSharedParameterWritable (ParameterSet *params_p, ParameterNode *node_p)
+{
+	const Parameter *src_p = node_p -> pn_parameter_p;
+	Parameter *dest_p = CloneParameter (src_p, NULL);
+
+	if (!dest_p)
+		{
+			SchemaVersion sv;
+			json_t *param_json_p;
+
+			sv.sv_major = CURRENT_SCHEMA_VERSION_MAJOR;
+			sv.sv_minor = CURRENT_SCHEMA_VERSION_MINOR;
+			sv.sv_version_s = NULL;
+
+			param_json_p = GetParameterAsJSON (src_p, &sv, true);
+
+			if (param_json_p)
+				{
+					dest_p = CreateParameterFromJSON (param_json_p, NULL, false);
+					json_decref (param_json_p);
+				}
+		}
+
+	if (dest_p)
+		{
+			ReplaceSharedParameterInParameterGroup (params_p, src_p, dest_p);
+
+			node_p -> pn_parameter_p = dest_p;
+			node_p -> pn_shared_flag = false;
+
+			return true;
+		}
+
+	PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to copy shared parameter \"%s\"", src_p -> pa_name_s);
+
+	return false;
+}
+
+
+/*
+ * A shared Parameter's pa_group_p is the ParameterSetTemplate's group, so
+ * put its replacement into this ParameterSet's own group of the same name.
+ */
+static void ReplaceSharedParameterInParameterGroup (ParameterSet *params_p, const Parameter *shared_param_p, Parameter *new_param_p)
+{
+	const ParameterGroup *shared_group_p = shared_param_p -> pa_group_p;
+
+	if (shared_group_p)
+		{
+			ParameterGroup *group_p = GetParameterGroupFromParameterSetByGroupName (params_p, shared_group_p -> pg_name_s);
+
+			if (!(group_p && ReplaceParameterInParameterGroup (group_p, (Parameter *) shared_param_p, new_param_p)))
+				{
+					/* This ParameterSet doesn't have the Parameter in a group of its own */
+					new_param_p -> pa_group_p = shared_param_p -> pa_group_p;
+				}
+		}
+}
@@ -0,0 +1,615 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * parameter_set_template.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <string.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+#include "parameter_set_template.h"
+#include "hash_map.h"
+#include "memory_allocations.h"
+#include "schema_keys.h"
+#include "schema_version.h"
+#include "service.h"
+#include "streams.h"
+#include "string_utils.h"
+
+
+#ifdef _WIN32
+	static SRWLOCK s_templates_lock = SRWLOCK_INIT;
+	#define LockTemplates() AcquireSRWLockExclusive (&s_templates_lock)
+	#define UnlockTemplates() ReleaseSRWLockExclusive (&s_templates_lock)
+#else
+	static pthread_mutex_t s_templates_lock = PTHREAD_MUTEX_INITIALIZER;
+	#define LockTemplates() pthread_mutex_lock (&s_templates_lock)
+	#define UnlockTemplates() pthread_mutex_unlock (&s_templates_lock)
+#endif
+
+
+/* The cached ParameterSetTemplates keyed by Service name */
+static HashMap *s_templates_p = NULL;
+
+
+static bool ApplyRequestParameter (ParameterSet *params_p, json_t *param_json_p, Service *service_p, const bool concise_flag);
+
+static Parameter *CreateRequestParameter (json_t *param_json_p, Service *service_p, const bool concise_flag);
+
+static bool AddTemplateParameterGroups (ParameterSet *params_p, const ParameterSet *defaults_p, Service *service_p);
+
+static bool AddSharedParametersToList (LinkedList *dest_p, const LinkedList *src_p);
+
+static void AddRequestParameterGroups (ParameterSet *params_p, const json_t *param_set_json_p, Service *service_p);
+
+static void FreeCachedParameterSetTemplate (void *template_p);
+
+static bool IsParameterSetCachingEnabled (const Service *service_p);
+
+static bool IsParameterCurrentValueUnchanged (const Parameter *param_p, const json_t *value_p);
+
+static void ClearParameterGroupsServiceData (LinkedList *groups_p);
+
+
+ParameterSetTemplate *AllocateParameterSetTemplate (Service *service_p)
+{
+	ParameterSetTemplate *template_p = NULL;
+	const char *service_name_s = GetServiceName (service_p);
+	ParameterSet *service_params_p = GetServiceParameters (service_p, NULL, NULL);
+
+	if (service_params_p)
+		{
+			json_t *op_json_p = json_object ();
+
+			if (op_json_p)
+				{
+					/* The JSON is only read back in here so use the current schema */
+					SchemaVersion sv;
+					json_t *param_set_json_p;
+
+					sv.sv_major = CURRENT_SCHEMA_VERSION_MAJOR;
+					sv.sv_minor = CURRENT_SCHEMA_VERSION_MINOR;
+					sv.sv_version_s = NULL;
+
+					param_set_json_p = GetParameterSetAsJSON (service_params_p, &sv, true);
+
+					if (param_set_json_p)
+						{
+							if (json_object_set_new (op_json_p, PARAM_SET_KEY_S, param_set_json_p) == 0)
+								{
+									/*
+									 * Rebuild the Parameters from their full definitions so that
+									 * they don't depend upon anything owned by this Service. The
+									 * Service is still needed for its custom Parameter types.
+									 */
+									ParameterSet *params_p = CreateParameterSetFromJSON (op_json_p, service_p, false);
+
+									if (params_p)
+										{
+											char *copied_name_s = EasyCopyToNewString (service_name_s);
+
+											if (copied_name_s)
+												{
+													template_p = (ParameterSetTemplate *) AllocMemory (sizeof (ParameterSetTemplate));
+
+													if (template_p)
+														{
+															params_p -> ps_name_s = copied_name_s;
+
+															/* The template outlives the Service so its groups can't keep its ServiceData */
+															ClearParameterGroupsServiceData (params_p -> ps_grouped_params_p);
+
+															template_p -> pst_params_p = params_p;
+															template_p -> pst_service_name_s = copied_name_s;
+
+															/* Requests can still be run without the validator */
+															template_p -> pst_validator_p = AllocateParameterValidator (params_p);
+														}
+													else
+														{
+															FreeCopiedString (copied_name_s);
+														}
+												}
+
+											if (!template_p)
+												{
+													FreeParameterSet (params_p);
+												}
+										}		/* if (params_p) */
+
+								}
+							else
+								{
+									json_decref (param_set_json_p);
+								}
+						}		/* if (param_set_json_p) */
+
+					json_decref (op_json_p);
+				}		/* if (op_json_p) */
+
+			ReleaseServiceParameters (service_p, service_params_p);
+		}		/* if (service_params_p) */
+
+	if (!template_p)
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to create ParameterSetTemplate for \"%s\"", service_name_s);
+		}
+
+	return template_p;
+}
+
+
+void FreeParameterSetTemplate (ParameterSetTemplate *template_p)
+{
+	if (template_p -> pst_validator_p)
+		{
+			FreeParameterValidator (template_p -> pst_validator_p);
+		}
+
+	FreeParameterSet (template_p -> pst_params_p);
+	FreeCopiedString (template_p -> pst_service_name_s);
+	FreeMemory (template_p);
+}
+
+
+ParameterSet *CreateParameterSetFromTemplate (const ParameterSetTemplate * const template_p, const json_t * const json_p, Service *service_p, const bool concise_flag)
+{
+	const ParameterSet *defaults_p = template_p -> pst_params_p;
+	ParameterSet *params_p = AllocateParameterSet (defaults_p -> ps_name_s, defaults_p -> ps_description_s);
+
+	if (params_p)
+		{
+			bool success_flag = true;
+			ParameterNode *node_p = (ParameterNode *) (defaults_p -> ps_params_p -> ll_head_p);
+
+			params_p -> ps_current_level = defaults_p -> ps_current_level;
+
+			while (node_p && success_flag)
+				{
+					success_flag = AddSharedParameterToParameterSet (params_p, node_p -> pn_parameter_p);
+					node_p = (ParameterNode *) (node_p -> pn_node.ln_next_p);
+				}
+
+			if (success_flag)
+				{
+					success_flag = AddTemplateParameterGroups (params_p, defaults_p, service_p);
+				}
+
+			if (success_flag && json_p)
+				{
+					const json_t *param_set_json_p = json_object_get (json_p, PARAM_SET_KEY_S);
+
+					if (param_set_json_p)
+						{
+							const char *level_s = GetJSONString (param_set_json_p, PARAM_LEVEL_S);
+							json_t *params_json_p = json_object_get (param_set_json_p, PARAM_SET_PARAMS_S);
+
+							if (level_s)
+								{
+									ParameterLevel level;
+
+									if (GetParameterLevelFromString (level_s, &level))
+										{
+											params_p -> ps_current_level = level;
+										}
+								}
+
+							if (params_json_p && json_is_array (params_json_p))
+								{
+									size_t i;
+									json_t *param_json_p;
+
+									json_array_foreach (params_json_p, i, param_json_p)
+										{
+											if (!ApplyRequestParameter (params_p, param_json_p, service_p, concise_flag))
+												{
+													PrintJSONToErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, param_json_p, "Failed to apply parameter to template for \"%s\"", template_p -> pst_service_name_s);
+													success_flag = false;
+													break;
+												}
+										}
+								}
+
+							if (success_flag)
+								{
+									AddRequestParameterGroups (params_p, param_set_json_p, service_p);
+								}
+						}		/* if (param_set_json_p) */
+
+				}		/* if (success_flag && json_p) */
+
+			if (success_flag)
+				{
+					return params_p;
+				}
+
+			FreeParameterSet (params_p);
+		}		/* if (params_p) */
+
+	return NULL;
+}
+
+
+const ParameterSetTemplate *GetServiceParameterSetTemplate (Service *service_p)
+{
+	ParameterSetTemplate *template_p = NULL;
+
+	if (IsParameterSetCachingEnabled (service_p))
+		{
+			const char *service_name_s = GetServiceName (service_p);
+			bool have_cache_flag = false;
+
+			LockTemplates ();
+
+			if (!s_templates_p)
+				{
+					s_templates_p = AllocateHashMap (32, 75, HMKT_STRING, MF_DEEP_COPY, MF_SHALLOW_COPY);
+
+					if (s_templates_p)
+						{
+							SetHashMapValueFunctions (s_templates_p, NULL, FreeCachedParameterSetTemplate);
+						}
+				}
+
+			if (s_templates_p)
+				{
+					template_p = (ParameterSetTemplate *) GetFromHashMap (s_templates_p, service_name_s);
+					have_cache_flag = true;
+				}
+
+			UnlockTemplates ();
+
+			if ((!template_p) && have_cache_flag)
+				{
+					/*
+					 * Build the template without holding the lock since getting the
+					 * Service's Parameters may be slow. If another thread gets there
+					 * first, use its template and discard ours.
+					 */
+					ParameterSetTemplate *new_template_p = AllocateParameterSetTemplate (service_p);
+
+					if (new_template_p)
+						{
+							LockTemplates ();
+
+							template_p = s_templates_p ? (ParameterSetTemplate *) GetFromHashMap (s_templates_p, service_name_s) : NULL;
+
+							if ((!template_p) && s_templates_p)
+								{
+									if (PutInHashMap (s_templates_p, service_name_s, new_template_p))
+										{
+											template_p = new_template_p;
+											new_template_p = NULL;
+										}
+								}
+
+							UnlockTemplates ();
+
+							if (new_template_p)
+								{
+									FreeParameterSetTemplate (new_template_p);
+								}
+						}
+				}
+		}
+
+	return template_p;
+}
+
+
+void FreeParameterSetTemplates (void)
+{
+	LockTemplates ();
+
+	if (s_templates_p)
+		{
+			FreeHashMap (s_templates_p);
+			s_templates_p = NULL;
+		}
+
+	UnlockTemplates ();
+}
+
+
+/*
+ * Parameters that are in the template just have their current values set on a
+ * private copy if they differ from the template's values, anything else is
+ * created from the request as it would be by CreateParameterSetFromJSON ().
+ */
+static bool ApplyRequestParameter (ParameterSet *params_p, json_t *param_json_p, Service *service_p, const bool concise_flag)
+{
+	bool success_flag = false;
+	const char *name_s = GetJSONString (param_json_p, PARAM_NAME_S);
+
+	if (name_s)
+		{
+			ParameterNode *node_p = FindParameterNodeInParameterSet (params_p, name_s);
+
+			if (node_p)
+				{
+					const json_t *value_p = json_object_get (param_json_p, PARAM_CURRENT_VALUE_S);
+
+					if ((!value_p) || (node_p -> pn_shared_flag && IsParameterCurrentValueUnchanged (node_p -> pn_parameter_p, value_p)))
+						{
+							/* The request keeps the default value */
+							success_flag = true;
+						}
+					else
+						{
+							Parameter *param_p = GetWritableParameterFromParameterSet (params_p, name_s);
+
+							if (param_p)
+								{
+									success_flag = SetParameterCurrentValueFromJSON (param_p, value_p);
+								}
+
+							if (!success_flag)
+								{
+									Parameter *request_param_p = CreateRequestParameter (param_json_p, service_p, concise_flag);
+
+									if (request_param_p)
+										{
+											/* This swaps request_param_p into this ParameterSet's group too */
+											if (ReplaceParameterInParameterSet (params_p, node_p -> pn_parameter_p, request_param_p, true))
+												{
+													success_flag = true;
+												}
+											else
+												{
+													FreeParameter (request_param_p);
+												}
+										}
+								}
+						}
+				}
+			else
+				{
+					Parameter *param_p = CreateRequestParameter (param_json_p, service_p, concise_flag);
+
+					if (param_p)
+						{
+							if (AddParameterToParameterSet (params_p, param_p))
+								{
+									success_flag = true;
+								}
+							else
+								{
+									FreeParameter (param_p);
+								}
+						}
+				}
+		}		/* if (name_s) */
+
+	return success_flag;
+}
+
+
+static Parameter *CreateRequestParameter (json_t *param_json_p, Service *service_p, const bool concise_flag)
+{
+	if (service_p && (service_p -> se_custom_parameter_decoder_fn))
+		{
+			return service_p -> se_custom_parameter_decoder_fn (service_p, param_json_p, concise_flag);
+		}
+	else
+		{
+			return CreateParameterFromJSON (param_json_p, service_p, concise_flag);
+		}
+}
+
+
+/*
+ * Give the ParameterSet its own copies of the template's groups. These list
+ * the shared Parameters without changing their pa_group_p, which is still the
+ * template's group, and GetWritableParameterFromParameterSet () swaps any
+ * copies that are made into these groups in place of the shared Parameters.
+ */
+static bool AddTemplateParameterGroups (ParameterSet *params_p, const ParameterSet *defaults_p, Service *service_p)
+{
+	bool success_flag = true;
+	const ParameterGroupNode *group_node_p = (const ParameterGroupNode *) (defaults_p -> ps_grouped_params_p -> ll_head_p);
+
+	while (group_node_p && success_flag)
+		{
+			const ParameterGroup *template_group_p = group_node_p -> pgn_param_group_p;
+			ParameterGroup *group_p = CreateAndAddParameterGroupToParameterSet (template_group_p -> pg_name_s, template_group_p -> pg_repeatable_flag, service_p ? service_p -> se_data_p : NULL, params_p);
+
+			if (group_p)
+				{
+					group_p -> pg_visible_flag = template_group_p -> pg_visible_flag;
+					group_p -> pg_full_display_flag = template_group_p -> pg_full_display_flag;
+					group_p -> pg_vertical_layout_flag = template_group_p -> pg_vertical_layout_flag;
+
+					success_flag = AddSharedParametersToList (group_p -> pg_params_p, template_group_p -> pg_params_p)
+						&& AddSharedParametersToList (group_p -> pg_repeatable_label_params_p, template_group_p -> pg_repeatable_label_params_p);
+				}
+			else
+				{
+					success_flag = false;
+				}
+
+			group_node_p = (const ParameterGroupNode *) (group_node_p -> pgn_node.ln_next_p);
+		}
+
+	return success_flag;
+}
+
+
+static bool AddSharedParametersToList (LinkedList *dest_p, const LinkedList *src_p)
+{
+	const ParameterNode *src_node_p = (const ParameterNode *) (src_p -> ll_head_p);
+
+	while (src_node_p)
+		{
+			ParameterNode *dest_node_p = AllocateParameterNode (src_node_p -> pn_parameter_p);
+
+			if (dest_node_p)
+				{
+					LinkedListAddTail (dest_p, & (dest_node_p -> pn_node));
+				}
+			else
+				{
+					return false;
+				}
+
+			src_node_p = (const ParameterNode *) (src_node_p -> pn_node.ln_next_p);
+		}
+
+	return true;
+}
+
+
+/*
+ * Put any Parameters from the request that aren't in a group yet into the
+ * groups that the request lists, as CreateParameterSetFromJSON () does.
+ */
+static void AddRequestParameterGroups (ParameterSet *params_p, const json_t *param_set_json_p, Service *service_p)
+{
+	const json_t *groups_json_p = json_object_get (param_set_json_p, PARAM_SET_GROUPS_S);
+	const json_t *params_json_p = json_object_get (param_set_json_p, PARAM_SET_PARAMS_S);
+
+	if (groups_json_p && json_is_array (groups_json_p) && params_json_p && json_is_array (params_json_p))
+		{
+			size_t i;
+			const json_t *group_json_p;
+
+			json_array_foreach (groups_json_p, i, group_json_p)
+				{
+					const char *group_name_s = GetJSONString (group_json_p, PARAM_GROUP_NAME_S);
+
+					if (group_name_s)
+						{
+							ParameterGroup *group_p = GetParameterGroupFromParameterSetByGroupName (params_p, group_name_s);
+
+							if (!group_p)
+								{
+									bool repeatable_flag = false;
+
+									GetJSONBoolean (group_json_p, PARAM_GROUP_REPEATABLE_S, &repeatable_flag);
+
+									group_p = CreateAndAddParameterGroupToParameterSet (group_name_s, repeatable_flag, service_p ? service_p -> se_data_p : NULL, params_p);
+								}
+
+							if (group_p)
+								{
+									bool visible_flag = true;
+									size_t j;
+									const json_t *param_json_p;
+
+									json_array_foreach (params_json_p, j, param_json_p)
+										{
+											const char *param_group_name_s = GetJSONString (param_json_p, PARAM_GROUP_S);
+
+											if ((param_group_name_s) && (strcmp (param_group_name_s, group_name_s) == 0))
+												{
+													const char *param_name_s = GetJSONString (param_json_p, PARAM_NAME_S);
+													ParameterNode *node_p = param_name_s ? FindParameterNodeInParameterSet (params_p, param_name_s) : NULL;
+
+													if (node_p && (! (node_p -> pn_parameter_p -> pa_group_p)))
+														{
+															/* Adding it to the group sets its pa_group_p so it can't stay shared */
+															Parameter *param_p = GetWritableParameterFromParameterSet (params_p, param_name_s);
+
+															if (! (param_p && AddParameterToParameterGroup (group_p, param_p)))
+																{
+																	PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to add parameter \"%s\" to group \"%s\"", param_name_s, group_name_s);
+																}
+														}
+												}
+										}
+
+									if (GetJSONBoolean (group_json_p, PARAM_GROUP_VISIBLE_S, &visible_flag))
+										{
+											group_p -> pg_visible_flag = visible_flag;
+										}
+								}
+							else
+								{
+									PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to create parameter group \"%s\"", group_name_s);
+								}
+						}		/* if (group_name_s) */
+
+				}		/* json_array_foreach (groups_json_p, i, group_json_p) */
+		}
+}
+
+
+static void FreeCachedParameterSetTemplate (void *template_p)
+{
+	FreeParameterSetTemplate ((ParameterSetTemplate *) template_p);
+}
+
+
+static bool IsParameterSetCachingEnabled (const Service *service_p)
+{
+	bool cache_flag = false;
+
+	if ((service_p -> se_data_p) && (service_p -> se_data_p -> sd_config_p))
+		{
+			GetJSONBoolean (service_p -> se_data_p -> sd_config_p, SERVICE_CACHE_PARAMETERS_S, &cache_flag);
+		}
+
+	return cache_flag;
+}
+
+
+/*
+ * Clients usually send back every Parameter whether they have changed it
+ * or not, so only those whose values differ need their own copies.
+ */
+static bool IsParameterCurrentValueUnchanged (const Parameter *param_p, const json_t *value_p)
+{
+	bool same_flag = false;
+	json_t *current_json_p = json_object ();
+
+	if (current_json_p)
+		{
+			if (param_p -> pa_add_values_to_json_fn (param_p, current_json_p, false))
+				{
+					const json_t *current_value_p = json_object_get (current_json_p, PARAM_CURRENT_VALUE_S);
+
+					if (current_value_p)
+						{
+							same_flag = (json_equal ((json_t *) current_value_p, (json_t *) value_p) == 1);
+						}
+				}
+
+			json_decref (current_json_p);
+		}
+
+	return same_flag;
+}
+
+
+static void ClearParameterGroupsServiceData (LinkedList *groups_p)
+{
+	ParameterGroupNode *node_p = (ParameterGroupNode *) (groups_p -> ll_head_p);
+
+	while (node_p)
+		{
+			node_p -> pgn_param_group_p -> pg_service_data_p = NULL;
+			ClearParameterGroupsServiceData (node_p -> pgn_param_group_p -> pg_child_groups_p);
+
+			node_p = (ParameterGroupNode *) (node_p -> pgn_node.ln_next_p);
+		}
+}
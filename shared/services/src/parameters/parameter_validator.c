@@ -0,0 +1,822 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * parameter_validator.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parameter_validator.h"
+#include "char_parameter.h"
+#include "double_parameter.h"
+#include "memory_allocations.h"
+#include "signed_int_parameter.h"
+#include "streams.h"
+#include "string_parameter.h"
+#include "string_utils.h"
+#include "unsigned_int_parameter.h"
+
+
+static const char * const S_REQUIRED_ERROR_S = "A value is required";
+static const char * const S_WRONG_TYPE_ERROR_S = "The value is of the wrong type";
+static const char * const S_BELOW_MINIMUM_ERROR_S = "The value is less than the minimum allowed";
+static const char * const S_ABOVE_MAXIMUM_ERROR_S = "The value is greater than the maximum allowed";
+static const char * const S_NOT_AN_OPTION_ERROR_S = "The value is not one of the allowed options";
+
+
+/*
+ * The kinds of value that constraints can be checked against. Integers
+ * hold unsigned, signed and char values.
+ */
+typedef enum ConstraintKind
+{
+	CK_INTEGER,
+	CK_REAL,
+	CK_STRING,
+	CK_OTHER
+} ConstraintKind;
+
+
+typedef union ConstraintValue
+{
+	int64 cv_integer;
+
+	double64 cv_real;
+
+	char *cv_string_s;
+} ConstraintValue;
+
+
+typedef struct ParameterConstraint
+{
+	/* The interned Parameter name */
+	const char *pc_name_s;
+
+	ParameterType pc_type;
+
+	ConstraintKind pc_kind;
+
+	bool pc_required_flag;
+
+	bool pc_has_min_flag;
+
+	bool pc_has_max_flag;
+
+	ConstraintValue pc_min;
+
+	ConstraintValue pc_max;
+
+	/* The allowed values sorted for binary searching, or NULL if any value is allowed */
+	Vector *pc_options_p;
+} ParameterConstraint;
+
+
+static ConstraintKind GetConstraintKind (const Parameter *param_p);
+
+static bool CompileParameterConstraint (const Parameter *param_p, ParameterConstraint *constraint_p);
+
+static bool CompileParameterOptions (const Parameter *param_p, ParameterConstraint *constraint_p);
+
+static void ClearParameterConstraint (ParameterConstraint *constraint_p);
+
+static const ParameterConstraint *FindParameterConstraint (const ParameterValidator *validator_p, const char *name_s);
+
+static const char *CheckParameterValue (const ParameterConstraint *constraint_p, const Parameter *param_p);
+
+static bool GetIntegerValue (const Parameter *param_p, int64 *value_p);
+
+static uint32 CheckMissingParameters (const ParameterValidator *validator_p, const ParameterSet *params_p, Vector *errors_p);
+
+static bool AddValidationError (Vector *errors_p, const char *param_s, const ParameterType param_type, const char *error_s);
+
+static int CompareParameterConstraints (const void *v1_p, const void *v2_p);
+
+static int CompareInt64s (const void *v1_p, const void *v2_p);
+
+static int CompareDouble64s (const void *v1_p, const void *v2_p);
+
+static int CompareStrings (const void *v1_p, const void *v2_p);
+
+static void FreeOptionString (void *value_p);
+
+
+ParameterValidator *AllocateParameterValidator (const ParameterSet * const params_p)
+{
+	ParameterValidator *validator_p = (ParameterValidator *) AllocMemory (sizeof (ParameterValidator));
+
+	if (validator_p)
+		{
+			const uint32 num_params = params_p -> ps_params_p -> ll_size;
+			bool success_flag = true;
+
+			validator_p -> pv_constraints_p = NULL;
+			validator_p -> pv_num_constraints = 0;
+			validator_p -> pv_num_required = 0;
+
+			if (num_params > 0)
+				{
+					validator_p -> pv_constraints_p = (ParameterConstraint *) AllocMemoryArray (num_params, sizeof (ParameterConstraint));
+
+					if (validator_p -> pv_constraints_p)
+						{
+							const ParameterNode *node_p = (const ParameterNode *) (params_p -> ps_params_p -> ll_head_p);
+
+							while (node_p && success_flag)
+								{
+									ParameterConstraint *constraint_p = (validator_p -> pv_constraints_p) + (validator_p -> pv_num_constraints);
+
+									if (CompileParameterConstraint (node_p -> pn_parameter_p, constraint_p))
+										{
+											/* Only keep the Parameters that have something to check */
+											if ((constraint_p -> pc_required_flag) || (constraint_p -> pc_has_min_flag) || (constraint_p -> pc_has_max_flag) || (constraint_p -> pc_options_p))
+												{
+													if (constraint_p -> pc_required_flag)
+														{
+															++ (validator_p -> pv_num_required);
+														}
+
+													++ (validator_p -> pv_num_constraints);
+												}
+											else
+												{
+													ClearParameterConstraint (constraint_p);
+												}
+										}
+									else
+										{
+											PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to compile the constraints for \"%s\"", node_p -> pn_parameter_p -> pa_name_s);
+											success_flag = false;
+										}
+
+									node_p = (const ParameterNode *) (node_p -> pn_node.ln_next_p);
+								}
+
+							if (success_flag)
+								{
+									qsort (validator_p -> pv_constraints_p, validator_p -> pv_num_constraints, sizeof (ParameterConstraint), CompareParameterConstraints);
+								}
+						}
+					else
+						{
+							success_flag = false;
+						}
+				}
+
+			if (success_flag)
+				{
+					return validator_p;
+				}
+
+			FreeParameterValidator (validator_p);
+		}		/* if (validator_p) */
+
+	PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate ParameterValidator for \"%s\"", params_p -> ps_name_s ? params_p -> ps_name_s : "");
+
+	return NULL;
+}
+
+
+void FreeParameterValidator (ParameterValidator *validator_p)
+{
+	if (validator_p -> pv_constraints_p)
+		{
+			uint32 i;
+
+			for (i = 0; i < validator_p -> pv_num_constraints; ++ i)
+				{
+					ClearParameterConstraint ((validator_p -> pv_constraints_p) + i);
+				}
+
+			FreeMemory (validator_p -> pv_constraints_p);
+		}
+
+	FreeMemory (validator_p);
+}
+
+
+uint32 ValidateParameterSet (const ParameterValidator * const validator_p, const ParameterSet * const params_p, Vector *errors_p)
+{
+	uint32 num_errors = 0;
+
+	if (validator_p -> pv_num_constraints > 0)
+		{
+			uint32 num_required = 0;
+			const ParameterNode *node_p = (const ParameterNode *) (params_p -> ps_params_p -> ll_head_p);
+
+			while (node_p && ((num_errors == 0) || errors_p))
+				{
+					const Parameter *param_p = node_p -> pn_parameter_p;
+					const ParameterConstraint *constraint_p = FindParameterConstraint (validator_p, param_p -> pa_name_s);
+
+					if (constraint_p)
+						{
+							const char *error_s = CheckParameterValue (constraint_p, param_p);
+
+							if (constraint_p -> pc_required_flag)
+								{
+									++ num_required;
+								}
+
+							if (error_s)
+								{
+									++ num_errors;
+
+									if (errors_p)
+										{
+											AddValidationError (errors_p, param_p -> pa_name_s, param_p -> pa_type, error_s);
+										}
+								}
+						}
+
+					node_p = (const ParameterNode *) (node_p -> pn_node.ln_next_p);
+				}
+
+			/*
+			 * Any required Parameters that weren't seen are missing from the
+			 * ParameterSet altogether.
+			 */
+			if ((num_required < validator_p -> pv_num_required) && ((num_errors == 0) || errors_p))
+				{
+					num_errors += CheckMissingParameters (validator_p, params_p, errors_p);
+				}
+		}
+
+	return num_errors;
+}
+
+
+static ConstraintKind GetConstraintKind (const Parameter *param_p)
+{
+	ConstraintKind kind = CK_OTHER;
+
+	if (IsUnsignedIntParameter (param_p) || IsSignedIntParameter (param_p) || IsCharParameter ((Parameter *) param_p))
+		{
+			kind = CK_INTEGER;
+		}
+	else if (IsDoubleParameter (param_p))
+		{
+			kind = CK_REAL;
+		}
+	else if (IsStringParameter (param_p))
+		{
+			kind = CK_STRING;
+		}
+
+	return kind;
+}
+
+
+static bool CompileParameterConstraint (const Parameter *param_p, ParameterConstraint *constraint_p)
+{
+	bool success_flag = true;
+
+	memset (constraint_p, 0, sizeof (ParameterConstraint));
+
+	constraint_p -> pc_name_s = param_p -> pa_name_s;
+	constraint_p -> pc_type = param_p -> pa_type;
+	constraint_p -> pc_kind = GetConstraintKind (param_p);
+
+	switch (constraint_p -> pc_kind)
+		{
+			case CK_INTEGER:
+				{
+					constraint_p -> pc_required_flag = param_p -> pa_required_flag;
+
+					if (IsUnsignedIntParameter (param_p))
+						{
+							const uint32 *min_p = NULL;
+							const uint32 *max_p = NULL;
+
+							GetUnsignedIntParameterBounds ((const UnsignedIntParameter *) param_p, &min_p, &max_p);
+
+							if (min_p)
+								{
+									constraint_p -> pc_min.cv_integer = *min_p;
+									constraint_p -> pc_has_min_flag = true;
+								}
+
+							if (max_p)
+								{
+									constraint_p -> pc_max.cv_integer = *max_p;
+									constraint_p -> pc_has_max_flag = true;
+								}
+						}
+					else if (IsSignedIntParameter (param_p))
+						{
+							const int32 *min_p = NULL;
+							const int32 *max_p = NULL;
+
+							GetSignedIntParameterBounds ((const SignedIntParameter *) param_p, &min_p, &max_p);
+
+							if (min_p)
+								{
+									constraint_p -> pc_min.cv_integer = *min_p;
+									constraint_p -> pc_has_min_flag = true;
+								}
+
+							if (max_p)
+								{
+									constraint_p -> pc_max.cv_integer = *max_p;
+									constraint_p -> pc_has_max_flag = true;
+								}
+						}
+					else
+						{
+							const CharParameter *char_param_p = (const CharParameter *) param_p;
+
+							if (char_param_p -> cp_min_value_p)
+								{
+									constraint_p -> pc_min.cv_integer = * (char_param_p -> cp_min_value_p);
+									constraint_p -> pc_has_min_flag = true;
+								}
+
+							if (char_param_p -> cp_max_value_p)
+								{
+									constraint_p -> pc_max.cv_integer = * (char_param_p -> cp_max_value_p);
+									constraint_p -> pc_has_max_flag = true;
+								}
+						}
+				}
+				break;
+
+			case CK_REAL:
+				{
+					const DoubleParameter *double_param_p = (const DoubleParameter *) param_p;
+
+					constraint_p -> pc_required_flag = param_p -> pa_required_flag;
+
+					if (double_param_p -> dp_min_value_p)
+						{
+							constraint_p -> pc_min.cv_real = * (double_param_p -> dp_min_value_p);
+							constraint_p -> pc_has_min_flag = true;
+						}
+
+					if (double_param_p -> dp_max_value_p)
+						{
+							constraint_p -> pc_max.cv_real = * (double_param_p -> dp_max_value_p);
+							constraint_p -> pc_has_max_flag = true;
+						}
+				}
+				break;
+
+			case CK_STRING:
+				{
+					const StringParameter *string_param_p = (const StringParameter *) param_p;
+
+					constraint_p -> pc_required_flag = param_p -> pa_required_flag;
+
+					if (string_param_p -> sp_min_value_s)
+						{
+							constraint_p -> pc_min.cv_string_s = EasyCopyToNewString (string_param_p -> sp_min_value_s);
+
+							if (constraint_p -> pc_min.cv_string_s)
+								{
+									constraint_p -> pc_has_min_flag = true;
+								}
+							else
+								{
+									success_flag = false;
+								}
+						}
+
+					if (success_flag && (string_param_p -> sp_max_value_s))
+						{
+							constraint_p -> pc_max.cv_string_s = EasyCopyToNewString (string_param_p -> sp_max_value_s);
+
+							if (constraint_p -> pc_max.cv_string_s)
+								{
+									constraint_p -> pc_has_max_flag = true;
+								}
+							else
+								{
+									success_flag = false;
+								}
+						}
+				}
+				break;
+
+			default:
+				/* Whether other types of value are empty isn't known so there's nothing to check */
+				break;
+		}
+
+	if (success_flag && (param_p -> pa_options_p) && (param_p -> pa_options_p -> ll_size > 0))
+		{
+			success_flag = CompileParameterOptions (param_p, constraint_p);
+		}
+
+	if (!success_flag)
+		{
+			ClearParameterConstraint (constraint_p);
+		}
+
+	return success_flag;
+}
+
+
+static bool CompileParameterOptions (const Parameter *param_p, ParameterConstraint *constraint_p)
+{
+	bool success_flag = true;
+	const uint32 num_options = param_p -> pa_options_p -> ll_size;
+	int (*compare_fn) (const void *v1_p, const void *v2_p) = NULL;
+
+	if (IsUnsignedIntParameter (param_p))
+		{
+			constraint_p -> pc_options_p = AllocateVector (sizeof (int64), num_options, NULL);
+
+			if (constraint_p -> pc_options_p)
+				{
+					const UnsignedIntParameterOptionNode *node_p = (const UnsignedIntParameterOptionNode *) (param_p -> pa_options_p -> ll_head_p);
+
+					while (node_p && success_flag)
+						{
+							const int64 value = node_p -> uipon_option_p -> uipo_value;
+
+							success_flag = AppendToVector (constraint_p -> pc_options_p, &value);
+							node_p = (const UnsignedIntParameterOptionNode *) (node_p -> uipon_node.ln_next_p);
+						}
+
+					compare_fn = CompareInt64s;
+				}
+		}
+	else if (IsSignedIntParameter (param_p))
+		{
+			constraint_p -> pc_options_p = AllocateVector (sizeof (int64), num_options, NULL);
+
+			if (constraint_p -> pc_options_p)
+				{
+					const SignedIntParameterOptionNode *node_p = (const SignedIntParameterOptionNode *) (param_p -> pa_options_p -> ll_head_p);
+
+					while (node_p && success_flag)
+						{
+							const int64 value = node_p -> sipon_option_p -> sipo_value;
+
+							success_flag = AppendToVector (constraint_p -> pc_options_p, &value);
+							node_p = (const SignedIntParameterOptionNode *) (node_p -> sipon_node.ln_next_p);
+						}
+
+					compare_fn = CompareInt64s;
+				}
+		}
+	else if (IsDoubleParameter (param_p))
+		{
+			constraint_p -> pc_options_p = AllocateVector (sizeof (double64), num_options, NULL);
+
+			if (constraint_p -> pc_options_p)
+				{
+					const DoubleParameterOptionNode *node_p = (const DoubleParameterOptionNode *) (param_p -> pa_options_p -> ll_head_p);
+
+					while (node_p && success_flag)
+						{
+							success_flag = AppendDoubleToVector (constraint_p -> pc_options_p, node_p -> dpon_option_p -> dpo_value);
+							node_p = (const DoubleParameterOptionNode *) (node_p -> dpon_node.ln_next_p);
+						}
+
+					compare_fn = CompareDouble64s;
+				}
+		}
+	else if (IsStringParameter (param_p))
+		{
+			constraint_p -> pc_options_p = AllocatePointerVector (num_options, FreeOptionString);
+
+			if (constraint_p -> pc_options_p)
+				{
+					const StringParameterOptionNode *node_p = (const StringParameterOptionNode *) (param_p -> pa_options_p -> ll_head_p);
+
+					while (node_p && success_flag)
+						{
+							char *value_s = EasyCopyToNewString (node_p -> spon_option_p -> spo_value_s);
+
+							success_flag = false;
+
+							if (value_s)
+								{
+									if (AppendPointerToVector (constraint_p -> pc_options_p, value_s))
+										{
+											success_flag = true;
+										}
+									else
+										{
+											FreeCopiedString (value_s);
+										}
+								}
+
+							node_p = (const StringParameterOptionNode *) (node_p -> spon_node.ln_next_p);
+						}
+
+					compare_fn = CompareStrings;
+				}
+		}
+	else
+		{
+			/* Options for any other types are only used as hints for clients */
+			return true;
+		}
+
+	if (constraint_p -> pc_options_p)
+		{
+			if (success_flag)
+				{
+					SortVector (constraint_p -> pc_options_p, compare_fn);
+				}
+		}
+	else
+		{
+			success_flag = false;
+		}
+
+	return success_flag;
+}
+
+
+static void ClearParameterConstraint (ParameterConstraint *constraint_p)
+{
+	if (constraint_p -> pc_kind == CK_STRING)
+		{
+			if (constraint_p -> pc_min.cv_string_s)
+				{
+					FreeCopiedString (constraint_p -> pc_min.cv_string_s);
+					constraint_p -> pc_min.cv_string_s = NULL;
+				}
+
+			if (constraint_p -> pc_max.cv_string_s)
+				{
+					FreeCopiedString (constraint_p -> pc_max.cv_string_s);
+					constraint_p -> pc_max.cv_string_s = NULL;
+				}
+		}
+
+	if (constraint_p -> pc_options_p)
+		{
+			FreeVector (constraint_p -> pc_options_p);
+			constraint_p -> pc_options_p = NULL;
+		}
+}
+
+
+static const ParameterConstraint *FindParameterConstraint (const ParameterValidator *validator_p, const char *name_s)
+{
+	uint32 low = 0;
+	uint32 high = validator_p -> pv_num_constraints;
+
+	while (low < high)
+		{
+			const uint32 mid = low + ((high - low) >> 1);
+			const ParameterConstraint *constraint_p = (validator_p -> pv_constraints_p) + mid;
+
+			if (constraint_p -> pc_name_s == name_s)
+				{
+					return constraint_p;
+				}
+			else if ((uintptr_t) name_s < (uintptr_t) (constraint_p -> pc_name_s))
+				{
+					high = mid;
+				}
+			else
+				{
+					low = mid + 1;
+				}
+		}
+
+	return NULL;
+}
+
+
+static const char *CheckParameterValue (const ParameterConstraint *constraint_p, const Parameter *param_p)
+{
+	if (GetConstraintKind (param_p) != constraint_p -> pc_kind)
+		{
+			return S_WRONG_TYPE_ERROR_S;
+		}
+
+	switch (constraint_p -> pc_kind)
+		{
+			case CK_INTEGER:
+				{
+					int64 value;
+
+					if (GetIntegerValue (param_p, &value))
+						{
+							if ((constraint_p -> pc_has_min_flag) && (value < constraint_p -> pc_min.cv_integer))
+								{
+									return S_BELOW_MINIMUM_ERROR_S;
+								}
+
+							if ((constraint_p -> pc_has_max_flag) && (value > constraint_p -> pc_max.cv_integer))
+								{
+									return S_ABOVE_MAXIMUM_ERROR_S;
+								}
+
+							if ((constraint_p -> pc_options_p) && (!BinarySearchVector (constraint_p -> pc_options_p, &value, CompareInt64s, NULL)))
+								{
+									return S_NOT_AN_OPTION_ERROR_S;
+								}
+						}
+					else if (constraint_p -> pc_required_flag)
+						{
+							return S_REQUIRED_ERROR_S;
+						}
+				}
+				break;
+
+			case CK_REAL:
+				{
+					const double64 *value_p = GetDoubleParameterCurrentValue ((const DoubleParameter *) param_p);
+
+					if (value_p)
+						{
+							if ((constraint_p -> pc_has_min_flag) && (*value_p < constraint_p -> pc_min.cv_real))
+								{
+									return S_BELOW_MINIMUM_ERROR_S;
+								}
+
+							if ((constraint_p -> pc_has_max_flag) && (*value_p > constraint_p -> pc_max.cv_real))
+								{
+									return S_ABOVE_MAXIMUM_ERROR_S;
+								}
+
+							if ((constraint_p -> pc_options_p) && (!BinarySearchVector (constraint_p -> pc_options_p, value_p, CompareDouble64s, NULL)))
+								{
+									return S_NOT_AN_OPTION_ERROR_S;
+								}
+						}
+					else if (constraint_p -> pc_required_flag)
+						{
+							return S_REQUIRED_ERROR_S;
+						}
+				}
+				break;
+
+			case CK_STRING:
+				{
+					const char *value_s = GetStringParameterCurrentValue ((const StringParameter *) param_p);
+
+					if (!IsStringEmpty (value_s))
+						{
+							if ((constraint_p -> pc_has_min_flag) && (strcmp (value_s, constraint_p -> pc_min.cv_string_s) < 0))
+								{
+									return S_BELOW_MINIMUM_ERROR_S;
+								}
+
+							if ((constraint_p -> pc_has_max_flag) && (strcmp (value_s, constraint_p -> pc_max.cv_string_s) > 0))
+								{
+									return S_ABOVE_MAXIMUM_ERROR_S;
+								}
+
+							if ((constraint_p -> pc_options_p) && (!BinarySearchVector (constraint_p -> pc_options_p, &value_s, CompareStrings, NULL)))
+								{
+									return S_NOT_AN_OPTION_ERROR_S;
+								}
+						}
+					else if (constraint_p -> pc_required_flag)
+						{
+							return S_REQUIRED_ERROR_S;
+						}
+				}
+				break;
+
+			default:
+				break;
+		}
+
+	return NULL;
+}
+
+
+static bool GetIntegerValue (const Parameter *param_p, int64 *value_p)
+{
+	bool got_value_flag = false;
+
+	if (IsUnsignedIntParameter (param_p))
+		{
+			const uint32 *current_value_p = GetUnsignedIntParameterCurrentValue ((const UnsignedIntParameter *) param_p);
+
+			if (current_value_p)
+				{
+					*value_p = *current_value_p;
+					got_value_flag = true;
+				}
+		}
+	else if (IsSignedIntParameter (param_p))
+		{
+			const int32 *current_value_p = GetSignedIntParameterCurrentValue ((const SignedIntParameter *) param_p);
+
+			if (current_value_p)
+				{
+					*value_p = *current_value_p;
+					got_value_flag = true;
+				}
+		}
+	else
+		{
+			const char *current_value_p = GetCharParameterCurrentValue ((const CharParameter *) param_p);
+
+			if (current_value_p)
+				{
+					*value_p = *current_value_p;
+					got_value_flag = true;
+				}
+		}
+
+	return got_value_flag;
+}
+
+
+static uint32 CheckMissingParameters (const ParameterValidator *validator_p, const ParameterSet *params_p, Vector *errors_p)
+{
+	uint32 num_errors = 0;
+	uint32 i;
+
+	for (i = 0; i < validator_p -> pv_num_constraints; ++ i)
+		{
+			const ParameterConstraint *constraint_p = (validator_p -> pv_constraints_p) + i;
+
+			if ((constraint_p -> pc_required_flag) && (!FindParameterInParameterSet (params_p, constraint_p -> pc_name_s)))
+				{
+					++ num_errors;
+
+					if (errors_p)
+						{
+							AddValidationError (errors_p, constraint_p -> pc_name_s, constraint_p -> pc_type, S_REQUIRED_ERROR_S);
+						}
+					else
+						{
+							break;
+						}
+				}
+		}
+
+	return num_errors;
+}
+
+
+static bool AddValidationError (Vector *errors_p, const char *param_s, const ParameterType param_type, const char *error_s)
+{
+	ParameterValidationError error;
+
+	error.pve_param_s = param_s;
+	error.pve_type = param_type;
+	error.pve_error_s = error_s;
+
+	return AppendToVector (errors_p, &error);
+}
+
+
+/*
+ * The constraints are sorted by the addresses of the interned names
+ * since that is what lookups compare.
+ */
+static int CompareParameterConstraints (const void *v1_p, const void *v2_p)
+{
+	const uintptr_t name1 = (uintptr_t) (((const ParameterConstraint *) v1_p) -> pc_name_s);
+	const uintptr_t name2 = (uintptr_t) (((const ParameterConstraint *) v2_p) -> pc_name_s);
+
+	return (name1 < name2) ? -1 : ((name1 > name2) ? 1 : 0);
+}
+
+
+static int CompareInt64s (const void *v1_p, const void *v2_p)
+{
+	const int64 i = * ((const int64 *) v1_p);
+	const int64 j = * ((const int64 *) v2_p);
+
+	return (i < j) ? -1 : ((i > j) ? 1 : 0);
+}
+
+
+static int CompareDouble64s (const void *v1_p, const void *v2_p)
+{
+	const double64 d1 = * ((const double64 *) v1_p);
+	const double64 d2 = * ((const double64 *) v2_p);
+
+	return (d1 < d2) ? -1 : ((d1 > d2) ? 1 : 0);
+}
+
+
+static int CompareStrings (const void *v1_p, const void *v2_p)
+{
+	return strcmp (* ((const char * const *) v1_p), * ((const char * const *) v2_p));
+}
+
+
+static void FreeOptionString (void *value_p)
+{
+	FreeCopiedString ((char *) value_p);
+}
@@ -0,0 +1,180 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * parameter_validator_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests that a ParameterValidator accepts the default values of a
+ *  ParameterSet and catches values that are out of bounds, aren't one
+ *  of the allowed options or are required but missing.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "parameter_validator.h"
+#include "double_parameter.h"
+#include "signed_int_parameter.h"
+#include "string_parameter.h"
+#include "unit_test.h"
+
+
+/*
+ * The defaults are all valid.
+ */
+static ParameterSet *GetTestParameterSet (void)
+{
+	ParameterSet *params_p = AllocateParameterSet ("validator test", "Parameters for testing the ParameterValidator");
+
+	if (params_p)
+		{
+			const int32 count = 5;
+			const double64 score = 0.5;
+			const double64 min_score = 0.0;
+			Parameter *param_p;
+			bool success_flag = false;
+
+			if ((param_p = EasyCreateAndAddSignedIntParameterToParameterSet (NULL, params_p, NULL, PT_SIGNED_INT, "count", "Count", "A bounded integer", &count, PL_ALL)) != NULL)
+				{
+					param_p -> pa_required_flag = true;
+
+					if (SetSignedIntParameterBounds ((SignedIntParameter *) param_p, 1, 10))
+						{
+							if ((param_p = EasyCreateAndAddDoubleParameterToParameterSet (NULL, params_p, NULL, PT_SIGNED_REAL, "score", "Score", "A real with a minimum", &score, PL_ALL)) != NULL)
+								{
+									if (SetDoubleParameterMinimumValue ((DoubleParameter *) param_p, &min_score))
+										{
+											if ((param_p = EasyCreateAndAddStringParameterToParameterSet (NULL, params_p, NULL, PT_STRING, "mode", "Mode", "A string with options", "fast", PL_ALL)) != NULL)
+												{
+													if (CreateAndAddStringParameterOption (param_p, "fast", "Fast") && CreateAndAddStringParameterOption (param_p, "slow", "Slow"))
+														{
+															if ((param_p = EasyCreateAndAddStringParameterToParameterSet (NULL, params_p, NULL, PT_STRING, "name", "Name", "A required string", "test", PL_ALL)) != NULL)
+																{
+																	param_p -> pa_required_flag = true;
+																	success_flag = true;
+																}
+														}
+												}
+										}
+								}
+						}
+				}
+
+			if (success_flag)
+				{
+					return params_p;
+				}
+
+			FreeParameterSet (params_p);
+		}
+
+	return NULL;
+}
+
+
+static bool HasValidationError (const Vector *errors_p, const char *param_s)
+{
+	uint32 i;
+
+	for (i = 0; i < GetVectorSize (errors_p); ++ i)
+		{
+			const ParameterValidationError *error_p = (const ParameterValidationError *) GetVectorElement (errors_p, i);
+
+			if (strcmp (error_p -> pve_param_s, param_s) == 0)
+				{
+					return true;
+				}
+		}
+
+	return false;
+}
+
+
+static void TestValidator (void)
+{
+	ParameterSet *defaults_p = GetTestParameterSet ();
+	ParameterValidator *validator_p = defaults_p ? AllocateParameterValidator (defaults_p) : NULL;
+
+	if (validator_p)
+		{
+			ParameterSet *params_p = GetTestParameterSet ();
+
+			Check (ValidateParameterSet (validator_p, defaults_p, NULL) == 0, "accept the default values");
+
+			if (params_p)
+				{
+					Vector *errors_p = AllocateVector (sizeof (ParameterValidationError), 4, NULL);
+					const int32 count = 20;
+					const double64 score = -1.0;
+
+					SetSignedIntParameterCurrentValue ((SignedIntParameter *) GetWritableParameterFromParameterSet (params_p, "count"), &count);
+					Check (ValidateParameterSet (validator_p, params_p, NULL) == 1, "reject a value above the maximum");
+
+					SetDoubleParameterCurrentValue ((DoubleParameter *) GetWritableParameterFromParameterSet (params_p, "score"), &score);
+					SetStringParameterCurrentValue ((StringParameter *) GetWritableParameterFromParameterSet (params_p, "mode"), "medium");
+					SetStringParameterCurrentValue ((StringParameter *) GetWritableParameterFromParameterSet (params_p, "name"), NULL);
+
+					Check (ValidateParameterSet (validator_p, params_p, NULL) == 1, "stop at the first failure without an errors list");
+
+					if (errors_p)
+						{
+							Check ((ValidateParameterSet (validator_p, params_p, errors_p) == 4) && (GetVectorSize (errors_p) == 4), "report every failure");
+							Check (HasValidationError (errors_p, "count") && HasValidationError (errors_p, "score") && HasValidationError (errors_p, "mode") && HasValidationError (errors_p, "name"), "name each failing parameter");
+
+							FreeVector (errors_p);
+						}
+
+					FreeParameterSet (params_p);
+				}
+
+			params_p = GetTestParameterSet ();
+
+			if (params_p)
+				{
+					Parameter *param_p = DetachParameterByName (params_p, "name");
+
+					if (param_p)
+						{
+							FreeParameter (param_p);
+						}
+
+					Check (ValidateParameterSet (validator_p, params_p, NULL) == 1, "reject a missing required parameter");
+
+					FreeParameterSet (params_p);
+				}
+
+			FreeParameterValidator (validator_p);
+		}
+	else
+		{
+			Check (false, "allocate ParameterValidator");
+		}
+
+	if (defaults_p)
+		{
+			FreeParameterSet (defaults_p);
+		}
+}
+
+
+int main (void)
+{
+	TestValidator ();
+
+	return GetTestResult ();
+}
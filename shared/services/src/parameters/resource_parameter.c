@@ -213,7 +213,7 @@ bool IsResourceParameter (const Parameter *param_p)
 bool GetCurrentResourceParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const DataResource **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
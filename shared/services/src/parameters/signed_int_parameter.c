@@ -324,7 +324,7 @@ bool IsSignedIntParameter (const Parameter *param_p)
 bool GetCurrentSignedIntParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const int32 **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
@@ -418,7 +418,7 @@ void FreeSignedIntParameterOption (SignedIntParameterOption *option_p)
 
 SignedIntParameterOptionNode *AllocateSignedIntParameterOptionNode (SignedIntParameterOption *option_p)
 {
-	SignedIntParameterOptionNode *node_p = (SignedIntParameterOptionNode *) AllocMemory (sizeof (SignedIntParameterOptionNode));
+	SignedIntParameterOptionNode *node_p = (SignedIntParameterOptionNode *) AllocListNodeMemory (sizeof (SignedIntParameterOptionNode));
 
 	if (node_p)
 		{
@@ -440,7 +440,7 @@ void FreeSignedIntParameterOptionNode (ListItem *item_p)
 	SignedIntParameterOptionNode *node_p = (SignedIntParameterOptionNode *) item_p;
 
 	FreeSignedIntParameterOption (node_p -> sipon_option_p);
-	FreeMemory (node_p);
+	FreeListNodeMemory (node_p);
 }
 
 
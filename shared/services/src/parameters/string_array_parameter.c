@@ -331,20 +331,20 @@ char *GetStringArrayParameterCurrentValuesAsFlattenedString (const StringArrayPa
 const char **GetStringArrayValuesForParameter (ParameterSet *param_set_p, const char *param_s, size_t *num_entries_p)
 {
 	const char **values_ss = NULL;
-	Parameter *param_p = GetParameterFromParameterSetByName (param_set_p, param_s);
+	const Parameter *param_p = FindParameterInParameterSet (param_set_p, param_s);
 
 	if (param_p)
 		{
 			if (IsStringArrayParameter (param_p))
 				{
-					StringArrayParameter *sa_param_p = (StringArrayParameter *) param_p;
+					const StringArrayParameter *sa_param_p = (const StringArrayParameter *) param_p;
 
 					values_ss = GetStringArrayParameterCurrentValues (sa_param_p);
 					*num_entries_p = GetNumberOfStringArrayCurrentParameterValues (sa_param_p);
 				}
 			else if (IsStringParameter (param_p))
 				{
-					StringParameter *st_param_p = (StringParameter *) param_p;
+					const StringParameter *st_param_p = (const StringParameter *) param_p;
 					const char *value_s = GetStringParameterCurrentValue (st_param_p);
 
 					values_ss = &value_s;
@@ -369,7 +369,7 @@ const char **GetStringArrayValuesForParameter (ParameterSet *param_set_p, const
 bool GetCurrentStringArrayParameterValuesFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const char ***values_ppp, size_t *num_entries_p)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
@@ -332,7 +332,7 @@ void FreeStringParameterOption (StringParameterOption *option_p)
 
 StringParameterOptionNode *AllocateStringParameterOptionNode (StringParameterOption *option_p)
 {
-	StringParameterOptionNode *node_p = (StringParameterOptionNode *) AllocMemory (sizeof (StringParameterOptionNode));
+	StringParameterOptionNode *node_p = (StringParameterOptionNode *) AllocListNodeMemory (sizeof (StringParameterOptionNode));
 
 	if (node_p)
 		{
@@ -354,7 +354,7 @@ void FreeStringParameterOptionNode (ListItem *item_p)
 	StringParameterOptionNode *node_p = (StringParameterOptionNode *) item_p;
 
 	FreeStringParameterOption (node_p -> spon_option_p);
-	FreeMemory (node_p);
+	FreeListNodeMemory (node_p);
 }
 
 
@@ -384,7 +384,7 @@ bool IsStringParameter (const Parameter *param_p)
 bool GetCurrentStringParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const char **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
@@ -789,7 +789,8 @@ static Parameter *CloneStringParameter (const Parameter *param_p, const ServiceD
 	const char *min_value_s = NULL;
 	const char *max_value_s = NULL;
 
-	if (GetStringParameterBounds (src_p, &min_value_s, &max_value_s))
+	/* Unbounded parameters are copied with NULL bounds */
+	if ((!IsStringParameterBounded (src_p)) || GetStringParameterBounds (src_p, &min_value_s, &max_value_s))
 		{
 			StringParameter *dest_param_p = AllocateStringParameter (service_data_p, param_p -> pa_type, param_p -> pa_name_s, param_p -> pa_display_name_s, param_p -> pa_description_s, default_value_s, current_value_s, param_p -> pa_level);
 
@@ -816,10 +817,10 @@ static Parameter *CloneStringParameter (const Parameter *param_p, const ServiceD
 				}		/* if (dest_param_p) */
 			else
 				{
-					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "AllocateStringParameter failed for copying \"%s\"", dest_param_p -> sp_base_param.pa_name_s);
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "AllocateStringParameter failed for copying \"%s\"", param_p -> pa_name_s);
 				}
 
-		}		/* if (GetStringParameterBounds (src_p, &min_value_s, &max_value_s)) */
+		}		/* if ((!IsStringParameterBounded (src_p)) || GetStringParameterBounds (src_p, &min_value_s, &max_value_s)) */
 	else
 		{
 			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "GetStringParameterBounds failed for copying \"%s\"", param_p -> pa_name_s);
@@ -843,7 +844,7 @@ bool CopyStringParameterOptions (const Parameter *src_p, Parameter *dest_p, cons
 	bool success_flag = true;
 	const LinkedList *src_options_p = src_p -> pa_options_p;
 
-	if (clear_existing_dest_options_flag)
+	if (clear_existing_dest_options_flag && (dest_p -> pa_options_p))
 		{
 			ClearLinkedList (dest_p -> pa_options_p);
 		}
@@ -275,7 +275,7 @@ bool GetTimeParameterBounds (const TimeParameter *param_p, struct tm *min_p, str
 
 
 
-bool IsTimeParameter (Parameter *param_p)
+bool IsTimeParameter (const Parameter *param_p)
 {
 	bool time_param_flag = false;
 
@@ -296,7 +296,7 @@ bool IsTimeParameter (Parameter *param_p)
 bool GetCurrentTimeParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const struct tm **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
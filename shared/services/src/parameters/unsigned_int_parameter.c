@@ -328,7 +328,7 @@ bool IsUnsignedIntParameter (const Parameter *param_p)
 bool GetCurrentUnsignedIntParameterValueFromParameterSet (const ParameterSet * const params_p, const char * const name_s, const uint32 **value_pp)
 {
 	bool success_flag = false;
-	Parameter *param_p = GetParameterFromParameterSetByName (params_p, name_s);
+	const Parameter *param_p = FindParameterInParameterSet (params_p, name_s);
 
 	if (param_p)
 		{
@@ -424,7 +424,7 @@ void FreeUnsignedIntParameterOption (UnsignedIntParameterOption *option_p)
 
 UnsignedIntParameterOptionNode *AllocateUnsignedIntParameterOptionNode (UnsignedIntParameterOption *option_p)
 {
-	UnsignedIntParameterOptionNode *node_p = (UnsignedIntParameterOptionNode *) AllocMemory (sizeof (UnsignedIntParameterOptionNode));
+	UnsignedIntParameterOptionNode *node_p = (UnsignedIntParameterOptionNode *) AllocListNodeMemory (sizeof (UnsignedIntParameterOptionNode));
 
 	if (node_p)
 		{
@@ -446,7 +446,7 @@ void FreeUnsignedIntParameterOptionNode (ListItem *item_p)
 	UnsignedIntParameterOptionNode *node_p = (UnsignedIntParameterOptionNode *) item_p;
 
 	FreeUnsignedIntParameterOption (node_p -> uipon_option_p);
-	FreeMemory (node_p);
+	FreeListNodeMemory (node_p);
 }
 
 
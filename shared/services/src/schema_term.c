@@ -179,7 +179,7 @@ SchemaTermNode *AllocateSchemaTermNodeByParts (const char *url_s, const char *na
 
 SchemaTermNode *AllocateSchemaTermNode (SchemaTerm *term_p)
 {
-	SchemaTermNode *node_p = (SchemaTermNode *) AllocMemory (sizeof (SchemaTermNode));
+	SchemaTermNode *node_p = (SchemaTermNode *) AllocListNodeMemory (sizeof (SchemaTermNode));
 
 	if (node_p)
 		{
@@ -198,7 +198,7 @@ void FreeSchemaTermNode (ListItem *node_p)
 	SchemaTermNode *term_node_p = (SchemaTermNode *) node_p;
 
 	FreeSchemaTerm (term_node_p -> stn_term_p);
-	FreeMemory (node_p);
+	FreeListNodeMemory (node_p);
 }
 
 
@@ -36,6 +36,8 @@
 #include "service_job.h"
 #include "provider.h"
 #include "uuid_util.h"
+#include "parameter_set_template.h"
+#include "service_description_cache.h"
 
 #ifdef _DEBUG
 #define SERVICE_DEBUG	(STM_LEVEL_INFO)
@@ -295,7 +297,7 @@ void ReleaseServiceData (ServiceData *data_p)
 
 ServiceNode *AllocateServiceNode (Service *service_p)
 {
-	ServiceNode *node_p = (ServiceNode *) AllocMemory (sizeof (ServiceNode));
+	ServiceNode *node_p = (ServiceNode *) AllocListNodeMemory (sizeof (ServiceNode));
 
 	if (node_p)
 		{
@@ -334,7 +336,7 @@ void FreeServiceNode (ListItem * const node_p)
 				}
 		}
 
-	FreeMemory (service_node_p);
+	FreeListNodeMemory (service_node_p);
 }
 
 
@@ -746,7 +748,28 @@ static json_t *GetServiceProcessRequest (const char * const service_name_s, cons
 
 json_t *GetServiceAsJSON (Service * const service_p, DataResource *resource_p, User *user_p, const bool add_id_flag)
 {
-	json_t *root_p = GetBaseServiceDataAsJSON (service_p, user_p);
+	json_t *root_p = NULL;
+
+	/*
+	 * Any UUID, DataResource or paired Services make the description
+	 * specific to this request so only the plain description is cached
+	 * and it is built without the User so that it can be shared.
+	 */
+	const bool cache_flag = (!add_id_flag) && (!resource_p) && (service_p -> se_paired_services.ll_size == 0) && IsServiceDescriptionCachingEnabled (service_p);
+
+	if (cache_flag)
+		{
+			root_p = GetCachedServiceDescription (GetServiceName (service_p), service_p -> se_data_p -> sd_config_p);
+
+			if (root_p)
+				{
+					return root_p;
+				}
+
+			user_p = NULL;
+		}
+
+	root_p = GetBaseServiceDataAsJSON (service_p, user_p);
 
 	if (root_p)
 		{
@@ -823,6 +846,11 @@ json_t *GetServiceAsJSON (Service * const service_p, DataResource *resource_p, U
 
 			if (success_flag)
 				{
+					if (cache_flag)
+						{
+							CacheServiceDescription (GetServiceName (service_p), service_p -> se_data_p -> sd_config_p, root_p);
+						}
+
 					return root_p;
 				}
 
@@ -1444,7 +1472,16 @@ static bool AddOperationInformationURIToJSON (Service * const service_p, json_t
 static bool AddServiceParameterSetToJSON (Service * const service_p, json_t *root_p, const SchemaVersion * const sv_p, const bool full_definition_flag, DataResource *resource_p, User *user_p)
 {
 	bool success_flag = false;
-	ParameterSet *param_set_p = GetServiceParameters (service_p, resource_p, user_p);
+	const ParameterSetTemplate *template_p = NULL;
+	ParameterSet *param_set_p = NULL;
+
+	/* The cached defaults can only be used if nothing specific has been asked for */
+	if ((!resource_p) && (!user_p))
+		{
+			template_p = GetServiceParameterSetTemplate (service_p);
+		}
+
+	param_set_p = template_p ? template_p -> pst_params_p : GetServiceParameters (service_p, resource_p, user_p);
 
 	if (param_set_p)
 		{
@@ -1462,8 +1499,10 @@ static bool AddServiceParameterSetToJSON (Service * const service_p, json_t *roo
 						}
 				}
 
-			/* could set this to be cached ... */
-			ReleaseServiceParameters (service_p, param_set_p);
+			if (!template_p)
+				{
+					ReleaseServiceParameters (service_p, param_set_p);
+				}
 		}
 
 #if SERVICE_DEBUG >= STM_LEVEL_FINER
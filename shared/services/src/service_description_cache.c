@@ -0,0 +1,204 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * service_description_cache.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+#include "service_description_cache.h"
+#include "hash_map.h"
+#include "json_util.h"
+#include "schema_keys.h"
+#include "service.h"
+#include "streams.h"
+
+
+#ifdef _WIN32
+	static SRWLOCK s_descriptions_lock = SRWLOCK_INIT;
+	#define LockDescriptions() AcquireSRWLockExclusive (&s_descriptions_lock)
+	#define UnlockDescriptions() ReleaseSRWLockExclusive (&s_descriptions_lock)
+#else
+	static pthread_mutex_t s_descriptions_lock = PTHREAD_MUTEX_INITIALIZER;
+	#define LockDescriptions() pthread_mutex_lock (&s_descriptions_lock)
+	#define UnlockDescriptions() pthread_mutex_unlock (&s_descriptions_lock)
+#endif
+
+
+/*
+ * The cached Service descriptions keyed by Service name. Each entry is
+ * an object holding the description along with the configuration that
+ * it was built from, so a reference to both can be taken in one go.
+ */
+static HashMap *s_descriptions_p = NULL;
+
+static const char * const S_DESCRIPTION_S = "description";
+
+static const char * const S_CONFIG_S = "config";
+
+
+static void FreeCachedServiceDescription (void *description_p);
+
+
+
+bool IsServiceDescriptionCachingEnabled (const Service *service_p)
+{
+	bool cache_flag = false;
+
+	if ((service_p -> se_data_p) && (service_p -> se_data_p -> sd_config_p))
+		{
+			GetJSONBoolean (service_p -> se_data_p -> sd_config_p, SERVICE_CACHE_DESCRIPTION_S, &cache_flag);
+		}
+
+	return cache_flag;
+}
+
+
+json_t *GetCachedServiceDescription (const char *service_name_s, const json_t *config_p)
+{
+	json_t *copied_description_p = NULL;
+	json_t *entry_p = NULL;
+
+	/*
+	 * Only take a reference whilst the lock is held. The cached entries are
+	 * never changed, only replaced, so they can be read and copied after
+	 * the lock has been released without holding up any other requests.
+	 */
+	LockDescriptions ();
+
+	if (s_descriptions_p)
+		{
+			entry_p = json_incref ((json_t *) GetFromHashMap (s_descriptions_p, service_name_s));
+		}
+
+	UnlockDescriptions ();
+
+	if (entry_p)
+		{
+			const json_t *cached_config_p = json_object_get (entry_p, S_CONFIG_S);
+
+			/* A missing configuration is cached as null */
+			if (json_equal ((json_t *) cached_config_p, config_p ? (json_t *) config_p : json_null ()))
+				{
+					/* Callers are free to change the description that they get back so give them their own copy */
+					copied_description_p = json_deep_copy (json_object_get (entry_p, S_DESCRIPTION_S));
+
+					if (!copied_description_p)
+						{
+							PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to copy cached description for \"%s\"", service_name_s);
+						}
+				}
+			else
+				{
+					/* The Service's configuration has changed since its description was cached */
+					InvalidateServiceDescription (service_name_s);
+				}
+
+			json_decref (entry_p);
+		}
+
+	return copied_description_p;
+}
+
+
+bool CacheServiceDescription (const char *service_name_s, const json_t *config_p, const json_t *description_p)
+{
+	bool success_flag = false;
+	json_t *entry_p = json_pack ("{s:o,s:o}", S_DESCRIPTION_S, json_deep_copy (description_p), S_CONFIG_S, config_p ? json_deep_copy (config_p) : json_null ());
+
+	if (entry_p)
+		{
+			LockDescriptions ();
+
+			if (!s_descriptions_p)
+				{
+					s_descriptions_p = AllocateHashMap (64, 75, HMKT_STRING, MF_DEEP_COPY, MF_SHALLOW_COPY);
+
+					if (s_descriptions_p)
+						{
+							SetHashMapValueFunctions (s_descriptions_p, NULL, FreeCachedServiceDescription);
+						}
+				}
+
+			if (s_descriptions_p)
+				{
+					if (IsKeyInHashMap (s_descriptions_p, service_name_s))
+						{
+							/* Another thread got there first so keep its description */
+							success_flag = true;
+						}
+					else if (PutInHashMap (s_descriptions_p, service_name_s, entry_p))
+						{
+							entry_p = NULL;
+							success_flag = true;
+						}
+				}
+
+			UnlockDescriptions ();
+
+			if (entry_p)
+				{
+					json_decref (entry_p);
+				}
+		}		/* if (entry_p) */
+
+	if (!success_flag)
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to cache description for \"%s\"", service_name_s);
+		}
+
+	return success_flag;
+}
+
+
+void InvalidateServiceDescription (const char *service_name_s)
+{
+	LockDescriptions ();
+
+	if (s_descriptions_p)
+		{
+			RemoveFromHashMap (s_descriptions_p, service_name_s);
+		}
+
+	UnlockDescriptions ();
+}
+
+
+void FreeServiceDescriptions (void)
+{
+	LockDescriptions ();
+
+	if (s_descriptions_p)
+		{
+			FreeHashMap (s_descriptions_p);
+			s_descriptions_p = NULL;
+		}
+
+	UnlockDescriptions ();
+}
+
+
+static void FreeCachedServiceDescription (void *description_p)
+{
+	json_decref ((json_t *) description_p);
+}
@@ -0,0 +1,215 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * service_description_cache_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests that cached Service descriptions are copied out, are invalidated
+ *  when the Service's configuration changes and can be read by many
+ *  threads whilst they are being replaced.
+ *
+ *  Usage: service_description_cache_test
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "jansson.h"
+
+#include "service_description_cache.h"
+#include "unit_test.h"
+
+
+#define NUM_READERS (8)
+
+#define NUM_READS (2000)
+
+#define NUM_PARAMETERS (200)
+
+
+static const char * const S_SERVICE_NAME_S = "cache test service";
+
+static json_t *s_descriptions_p [2] = { NULL, NULL };
+
+static json_t *s_configs_p [2] = { NULL, NULL };
+
+
+/*
+ * A large description with a marker so that the two versions can be told apart.
+ */
+static json_t *GetDescription (const int version)
+{
+	json_t *description_p = json_pack ("{s:s,s:i,s:[]}", "name", S_SERVICE_NAME_S, "version", version, "parameters");
+
+	if (description_p)
+		{
+			json_t *params_p = json_object_get (description_p, "parameters");
+			int i;
+
+			for (i = 0; i < NUM_PARAMETERS; ++ i)
+				{
+					json_array_append_new (params_p, json_pack ("{s:i,s:s,s:[s,s,s]}", "index", i, "description", "A parameter with enough text to make copying it take a while", "options", "one", "two", "three"));
+				}
+		}
+
+	return description_p;
+}
+
+
+static void TestCaching (void)
+{
+	json_t *description_p;
+
+	Check (GetCachedServiceDescription (S_SERVICE_NAME_S, s_configs_p [0]) == NULL, "miss before anything is cached");
+	Check (CacheServiceDescription (S_SERVICE_NAME_S, s_configs_p [0], s_descriptions_p [0]), "cache a description");
+
+	description_p = GetCachedServiceDescription (S_SERVICE_NAME_S, s_configs_p [0]);
+	Check ((description_p != NULL) && (description_p != s_descriptions_p [0]) && json_equal (description_p, s_descriptions_p [0]), "get back a copy of the description");
+
+	if (description_p)
+		{
+			json_object_set_new (description_p, "version", json_integer (99));
+			json_decref (description_p);
+
+			description_p = GetCachedServiceDescription (S_SERVICE_NAME_S, s_configs_p [0]);
+			Check ((description_p != NULL) && json_equal (description_p, s_descriptions_p [0]), "changing the copy leaves the cached description alone");
+
+			if (description_p)
+				{
+					json_decref (description_p);
+				}
+		}
+
+	Check (CacheServiceDescription (S_SERVICE_NAME_S, s_configs_p [0], s_descriptions_p [1]), "cache a second description");
+	description_p = GetCachedServiceDescription (S_SERVICE_NAME_S, s_configs_p [0]);
+	Check ((description_p != NULL) && json_equal (description_p, s_descriptions_p [0]), "keep the first description");
+
+	if (description_p)
+		{
+			json_decref (description_p);
+		}
+
+	Check (GetCachedServiceDescription (S_SERVICE_NAME_S, s_configs_p [1]) == NULL, "miss when the configuration has changed");
+	Check (GetCachedServiceDescription (S_SERVICE_NAME_S, s_configs_p [0]) == NULL, "invalidate the description when the configuration has changed");
+
+	Check (CacheServiceDescription (S_SERVICE_NAME_S, NULL, s_descriptions_p [1]), "cache a description without a configuration");
+	description_p = GetCachedServiceDescription (S_SERVICE_NAME_S, NULL);
+	Check ((description_p != NULL) && json_equal (description_p, s_descriptions_p [1]), "get a description cached without a configuration");
+
+	if (description_p)
+		{
+			json_decref (description_p);
+		}
+
+	InvalidateServiceDescription (S_SERVICE_NAME_S);
+	Check (GetCachedServiceDescription (S_SERVICE_NAME_S, NULL) == NULL, "miss after invalidating the description");
+
+	FreeServiceDescriptions ();
+}
+
+
+static void *RunReader (void *data_p)
+{
+	bool *valid_flag_p = (bool *) data_p;
+	int i;
+
+	for (i = 0; i < NUM_READS; ++ i)
+		{
+			const int version = i & 1;
+			json_t *description_p = GetCachedServiceDescription (S_SERVICE_NAME_S, s_configs_p [version]);
+
+			if (description_p)
+				{
+					if (!json_equal (description_p, s_descriptions_p [version]))
+						{
+							*valid_flag_p = false;
+						}
+
+					json_decref (description_p);
+				}
+			else
+				{
+					CacheServiceDescription (S_SERVICE_NAME_S, s_configs_p [version], s_descriptions_p [version]);
+				}
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Readers ask for alternate configurations so the description is
+ * continually invalidated and replaced whilst others are copying it.
+ */
+static void TestConcurrentReaders (void)
+{
+	pthread_t readers [NUM_READERS];
+	bool valid_flags [NUM_READERS];
+	bool valid_flag = true;
+	int i;
+
+	for (i = 0; i < NUM_READERS; ++ i)
+		{
+			valid_flags [i] = true;
+			pthread_create (readers + i, NULL, RunReader, valid_flags + i);
+		}
+
+	for (i = 0; i < NUM_READERS; ++ i)
+		{
+			pthread_join (readers [i], NULL);
+
+			if (!valid_flags [i])
+				{
+					valid_flag = false;
+				}
+		}
+
+	Check (valid_flag, "match the requested configuration whilst descriptions are being replaced");
+
+	FreeServiceDescriptions ();
+}
+
+
+int main (void)
+{
+	int i;
+
+	s_descriptions_p [0] = GetDescription (0);
+	s_descriptions_p [1] = GetDescription (1);
+	s_configs_p [0] = json_pack ("{s:b,s:s}", "cache_description", 1, "database", "first");
+	s_configs_p [1] = json_pack ("{s:b,s:s}", "cache_description", 1, "database", "second");
+
+	if (s_descriptions_p [0] && s_descriptions_p [1] && s_configs_p [0] && s_configs_p [1])
+		{
+			TestCaching ();
+			TestConcurrentReaders ();
+		}
+	else
+		{
+			Check (false, "create the test descriptions");
+		}
+
+	for (i = 0; i < 2; ++ i)
+		{
+			json_decref (s_descriptions_p [i]);
+			json_decref (s_configs_p [i]);
+		}
+
+	return GetTestResult ();
+}
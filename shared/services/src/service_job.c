@@ -40,6 +40,8 @@ static bool AddValidJSON (json_t *parent_p, const char * const key_s, json_t *ch
 
 static bool AddStatusToServiceJobJSON (ServiceJob *job_p, json_t *value_p);
 
+static json_t *GetServiceJobSetEntryAsJSON (ServiceJob *job_p);
+
 
 static bool AddLinkedServicesToServiceJobJSON (ServiceJob *job_p, json_t *value_p);
 
@@ -124,6 +126,9 @@ bool InitServiceJob (ServiceJob *job_p, Service *service_p, const char *job_name
 
 	job_p -> sj_service_p = service_p;
 
+	/* Tie the job's log messages back to the request that started it */
+	SetServiceJobCorrelationId (job_p, GetLogCorrelationId ());
+
 	if (id_p)
 		{
 			PrintLog (STM_LEVEL_INFO, __FILE__, __LINE__, "InitServiceJob () for \"%s\" with name \"%s\" calling uuid_copy", GetServiceName (service_p), job_name_s ? job_name_s : "NULL");
@@ -468,6 +473,26 @@ bool SetServiceJobName (ServiceJob *job_p, const char * const name_s)
 }
 
 
+void SetServiceJobCorrelationId (ServiceJob *job_p, const char * const id_s)
+{
+	if (id_s)
+		{
+			strncpy (job_p -> sj_correlation_id_s, id_s, LOG_CORRELATION_ID_BUFFER_SIZE - 1);
+			job_p -> sj_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE - 1] = '\0';
+		}
+	else
+		{
+			* (job_p -> sj_correlation_id_s) = '\0';
+		}
+}
+
+
+const char *GetServiceJobCorrelationId (const ServiceJob *job_p)
+{
+	return (* (job_p -> sj_correlation_id_s) != '\0') ? job_p -> sj_correlation_id_s : NULL;
+}
+
+
 bool SetServiceJobDescription (ServiceJob *job_p, const char * const description_s)
 {
 	bool success_flag = ReplaceStringValue (& (job_p -> sj_description_s), description_s);
@@ -582,7 +607,7 @@ uint32 GetServiceJobSetSize (const ServiceJobSet * const jobs_p)
 
 ServiceJobNode *AllocateServiceJobNode (ServiceJob *job_p)
 {
-	ServiceJobNode *node_p = (ServiceJobNode *) AllocMemory (sizeof (ServiceJobNode));
+	ServiceJobNode *node_p = (ServiceJobNode *) AllocListNodeMemory (sizeof (ServiceJobNode));
 
 	if (node_p)
 		{
@@ -604,7 +629,7 @@ void FreeServiceJobNode (ListItem *node_p)
 			FreeServiceJob (service_job_node_p -> sjn_job_p);
 		}
 
-	FreeMemory (service_job_node_p);
+	FreeListNodeMemory (service_job_node_p);
 }
 
 
@@ -621,6 +646,8 @@ ServiceJobNode *FindServiceJobNodeByUUIDInServiceJobSet (const ServiceJobSet *jo
 						{
 							return node_p;
 						}
+
+					node_p = (ServiceJobNode *) (node_p -> sjn_node.ln_next_p);
 				}
 		}
 
@@ -966,8 +993,14 @@ bool InitServiceJobFromJSON (ServiceJob *job_p, const json_t *job_json_p, Servic
 																		{
 																			if (CopyValidJSON (job_json_p, JOB_ERRORS_S, & (job_p -> sj_errors_p)))
 																				{
+																					const char *correlation_id_s = GetJSONString (job_json_p, JOB_CORRELATION_ID_S);
+
 																					SetServiceJobStatus (job_p, status);
 
+																					if (correlation_id_s)
+																						{
+																							SetServiceJobCorrelationId (job_p, correlation_id_s);
+																						}
 
 																					success_flag = true;
 																				}
@@ -1187,7 +1220,7 @@ json_t *GetServiceJobAsJSON (ServiceJob *job_p, bool omit_results_flag)
 																{
 																	if (AddValidJSONString (job_json_p, JOB_DESCRIPTION_S, job_p -> sj_description_s))
 																		{
-																			if (AddValidJSONString (job_json_p, JOB_URL_S, job_p -> sj_url_s))
+																			if ((AddValidJSONString (job_json_p, JOB_URL_S, job_p -> sj_url_s)) && (AddValidJSONString (job_json_p, JOB_CORRELATION_ID_S, GetServiceJobCorrelationId (job_p))))
 																				{
 																					if ((job_p -> sj_status == OS_SUCCEEDED) || (job_p -> sj_status == OS_PARTIALLY_SUCCEEDED))
 																						{
@@ -1299,22 +1332,12 @@ bool ProcessServiceJobSet (ServiceJobSet *jobs_p, json_t *res_p)
 		{
 			ServiceJob *job_p = node_p -> sjn_job_p;
 
-			json_t *job_json_p = NULL;
-			const OperationStatus job_status = GetServiceJobStatus (job_p);
+			json_t *job_json_p = GetServiceJobSetEntryAsJSON (job_p);
 
 #if SERVICE_JOB_DEBUG >= STM_LEVEL_FINE
-			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Job " UINT32_FMT ": status: %d", i, job_status);
+			PrintLog (STM_LEVEL_FINE, __FILE__, __LINE__, "Job " UINT32_FMT ": status: %d", i, GetCachedServiceJobStatus (job_p));
 #endif
 
-			if ((job_status == OS_SUCCEEDED) || (job_status == OS_PARTIALLY_SUCCEEDED))
-				{
-					job_json_p = GetServiceJobAsJSON (job_p, false);
-				}
-			else
-				{
-					job_json_p = GetServiceJobStatusAsJSON (job_p, true);
-				}
-
 			if (job_json_p)
 				{
 #if SERVICE_JOB_DEBUG >= STM_LEVEL_FINE
@@ -1377,6 +1400,81 @@ bool ProcessServiceJobSet (ServiceJobSet *jobs_p, json_t *res_p)
 }
 
 
+bool WriteServiceJobAsJSON (ServiceJob *job_p, JSONWriter *writer_p, bool omit_results_flag)
+{
+	bool success_flag = false;
+
+	/*
+	 * The new object only holds references to the job's errors, metadata
+	 * and results, so the results are streamed straight from the job's
+	 * own tree rather than being copied.
+	 */
+	json_t *job_json_p = GetServiceJobAsJSON (job_p, omit_results_flag);
+
+	if (job_json_p)
+		{
+			success_flag = AddJSONToJSONWriter (writer_p, job_json_p);
+			json_decref (job_json_p);
+		}
+
+	return success_flag;
+}
+
+
+bool WriteServiceJobSetAsJSON (ServiceJobSet *jobs_p, JSONWriter *writer_p)
+{
+	ServiceJobNode *node_p = (ServiceJobNode *) (jobs_p -> sjs_jobs_p -> ll_head_p);
+
+	if (!OpenJSONWriterArray (writer_p))
+		{
+			return false;
+		}
+
+	while (node_p)
+		{
+			ServiceJob *job_p = node_p -> sjn_job_p;
+			json_t *job_json_p = GetServiceJobSetEntryAsJSON (job_p);
+			bool written_flag = false;
+
+			if (job_json_p)
+				{
+					written_flag = AddJSONToJSONWriter (writer_p, job_json_p);
+					json_decref (job_json_p);
+				}
+
+			if (!written_flag)
+				{
+					char uuid_s [UUID_STRING_BUFFER_SIZE];
+
+					ConvertUUIDToString (job_p -> sj_id, uuid_s);
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to write json response for job %s", uuid_s);
+				}
+
+			node_p = (ServiceJobNode *) (node_p -> sjn_node.ln_next_p);
+		}		/* while (node_p) */
+
+	return CloseJSONWriterArray (writer_p);
+}
+
+
+/*
+ * Get the entry for a ServiceJob in the response for its ServiceJobSet:
+ * the full job with its results if it has finished successfully and
+ * just its status otherwise.
+ */
+static json_t *GetServiceJobSetEntryAsJSON (ServiceJob *job_p)
+{
+	const OperationStatus job_status = GetServiceJobStatus (job_p);
+
+	if ((job_status == OS_SUCCEEDED) || (job_status == OS_PARTIALLY_SUCCEEDED))
+		{
+			return GetServiceJobAsJSON (job_p, false);
+		}
+
+	return GetServiceJobStatusAsJSON (job_p, true);
+}
+
+
 OperationStatus GetCachedServiceJobStatus (const ServiceJob *job_p)
 {
 	return job_p -> sj_status;
@@ -0,0 +1,228 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * service_job_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests that WriteServiceJobAsJSON () and WriteServiceJobSetAsJSON ()
+ *  write exactly what json_dumps () gives for GetServiceJobAsJSON () and
+ *  ProcessServiceJobSet () on jobs that succeeded, partially succeeded
+ *  and failed.
+ *
+ *  Usage: service_job_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jansson.h"
+
+#include "json_writer.h"
+#include "service.h"
+#include "service_job.h"
+#include "unit_test.h"
+
+
+#define NUM_RESULTS (100)
+
+/* Small enough that the results are passed to the sink in many pieces */
+#define CHUNK_SIZE (64)
+
+
+static const char *GetTestServiceName (const Service * UNUSED_PARAM (service_p))
+{
+	return "job test service";
+}
+
+
+static ServiceJob *CreateJob (Service *service_p, const char *name_s, const OperationStatus status)
+{
+	ServiceJob *job_p = CreateAndAddServiceJobToService (service_p, name_s, "a job to write", NULL, NULL, NULL);
+
+	if (job_p)
+		{
+			bool success_flag = true;
+
+			if ((status == OS_SUCCEEDED) || (status == OS_PARTIALLY_SUCCEEDED))
+				{
+					uint32 i;
+
+					for (i = 0; success_flag && (i < NUM_RESULTS); ++ i)
+						{
+							success_flag = AddResultToServiceJob (job_p, json_pack ("{s:i,s:s,s:f}", "row", i, "hit", "ACGT\t\"quoted\"\n", "score", i * 0.5));
+						}
+				}
+			else
+				{
+					success_flag = AddGeneralErrorMessageToServiceJob (job_p, "the job failed");
+				}
+
+			if (success_flag)
+				{
+					SetServiceJobStatus (job_p, status);
+					return job_p;
+				}
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Check that a JSONWriter wrote the same as json_dumps () gives
+ * for a value and then free the value.
+ */
+static bool IsSameAsDump (ByteBuffer *buffer_p, json_t *value_p)
+{
+	bool same_flag = false;
+
+	if (value_p)
+		{
+			char *dump_s = json_dumps (value_p, JSON_COMPACT | JSON_PRESERVE_ORDER);
+
+			if (dump_s)
+				{
+					same_flag = (strcmp (dump_s, GetByteBufferData (buffer_p)) == 0);
+
+					if (!same_flag)
+						{
+							printf ("expected:\n%s\ngot:\n%s\n", dump_s, GetByteBufferData (buffer_p));
+						}
+
+					free (dump_s);
+				}
+
+			json_decref (value_p);
+		}
+
+	return same_flag;
+}
+
+
+static void TestWriteServiceJob (ServiceJob *job_p, const bool omit_results_flag, const char *description_s)
+{
+	ByteBuffer *buffer_p = AllocateByteBuffer (1024);
+
+	if (buffer_p)
+		{
+			JSONWriter *writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, JSON_COMPACT | JSON_PRESERVE_ORDER, CHUNK_SIZE);
+
+			if (writer_p)
+				{
+					bool written_flag = WriteServiceJobAsJSON (job_p, writer_p, omit_results_flag) && FlushJSONWriter (writer_p);
+
+					Check (written_flag && IsSameAsDump (buffer_p, GetServiceJobAsJSON (job_p, omit_results_flag)), description_s);
+
+					FreeJSONWriter (writer_p);
+				}
+			else
+				{
+					Check (false, "allocate the JSONWriter");
+				}
+
+			FreeByteBuffer (buffer_p);
+		}
+	else
+		{
+			Check (false, "allocate the ByteBuffer");
+		}
+}
+
+
+static void TestWriteServiceJobSet (ServiceJobSet *jobs_p)
+{
+	ByteBuffer *buffer_p = AllocateByteBuffer (1024);
+	json_t *res_p = json_array ();
+
+	if (buffer_p && res_p)
+		{
+			JSONWriter *writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, JSON_COMPACT | JSON_PRESERVE_ORDER, CHUNK_SIZE);
+
+			if (writer_p)
+				{
+					bool written_flag = WriteServiceJobSetAsJSON (jobs_p, writer_p) && FlushJSONWriter (writer_p);
+
+					Check (written_flag && ProcessServiceJobSet (jobs_p, res_p) && (json_array_size (res_p) == GetServiceJobSetSize (jobs_p)) && IsSameAsDump (buffer_p, res_p), "write a ServiceJobSet the same as ProcessServiceJobSet ()");
+					res_p = NULL;
+
+					FreeJSONWriter (writer_p);
+				}
+			else
+				{
+					Check (false, "allocate the JSONWriter");
+				}
+		}
+	else
+		{
+			Check (false, "allocate the ByteBuffer and results array");
+		}
+
+	if (res_p)
+		{
+			json_decref (res_p);
+		}
+
+	if (buffer_p)
+		{
+			FreeByteBuffer (buffer_p);
+		}
+}
+
+
+int main (void)
+{
+	Service service;
+	ServiceJobSet *jobs_p;
+
+	memset (&service, 0, sizeof (service));
+	service.se_get_service_name_fn = GetTestServiceName;
+
+	jobs_p = AllocateServiceJobSet (&service);
+
+	if (jobs_p)
+		{
+			ServiceJob *succeeded_job_p = CreateJob (&service, "succeeded job", OS_SUCCEEDED);
+			ServiceJob *partial_job_p = CreateJob (&service, "partially succeeded job", OS_PARTIALLY_SUCCEEDED);
+			ServiceJob *failed_job_p = CreateJob (&service, "failed job", OS_FAILED);
+
+			if (succeeded_job_p && partial_job_p && failed_job_p)
+				{
+					SetServiceJobURL (succeeded_job_p, "https://grassroots.tools/jobs/1");
+
+					TestWriteServiceJob (succeeded_job_p, false, "write a succeeded ServiceJob the same as GetServiceJobAsJSON ()");
+					TestWriteServiceJob (succeeded_job_p, true, "write a succeeded ServiceJob without its results the same as GetServiceJobAsJSON ()");
+					TestWriteServiceJob (partial_job_p, false, "write a partially succeeded ServiceJob the same as GetServiceJobAsJSON ()");
+					TestWriteServiceJob (failed_job_p, false, "write a failed ServiceJob the same as GetServiceJobAsJSON ()");
+
+					TestWriteServiceJobSet (jobs_p);
+				}
+			else
+				{
+					Check (false, "create the test ServiceJobs");
+				}
+
+			FreeServiceJobSet (jobs_p);
+		}
+	else
+		{
+			Check (false, "allocate the ServiceJobSet");
+		}
+
+	return GetTestResult ();
+}
@@ -118,6 +118,16 @@ extern "C"
 GRASSROOTS_USERS_API User *AllocateUser (bson_oid_t *id_p, const char *email_s, const char *forename_s, const char *surname_s, const char *org_s, const char *orcid_s);
 
 
+/**
+ * Make a deep copy of a User.
+ *
+ * @param user_p The User to copy.
+ * @return A newly-allocated copy of the User or <code>NULL</code> upon error.
+ * @memberof User
+ */
+GRASSROOTS_USERS_API User *CopyUser (const User *user_p);
+
+
 /**
  * Free a User.
  *
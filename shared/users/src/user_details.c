@@ -110,6 +110,38 @@ User *AllocateUser (bson_oid_t *id_p, const char *email_s, const char *forename_
 }
 
 
+User *CopyUser (const User *user_p)
+{
+	User *copied_user_p;
+	bson_oid_t *id_p = NULL;
+
+	if (user_p -> us_id_p)
+		{
+			id_p = CopyBSONOid (user_p -> us_id_p);
+
+			if (!id_p)
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to copy id for \"%s\"", user_p -> us_email_s);
+					return NULL;
+				}
+		}
+
+	copied_user_p = AllocateUser (id_p, user_p -> us_email_s, user_p -> us_forename_s, user_p -> us_surname_s, user_p -> us_org_s, user_p -> us_orcid_s);
+
+	if (!copied_user_p)
+		{
+			if (id_p)
+				{
+					FreeBSONOid (id_p);
+				}
+
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to copy user \"%s\"", user_p -> us_email_s);
+		}
+
+	return copied_user_p;
+}
+
+
 void FreeUser (User *user_p)
 {
 	FreeBSONOid (user_p -> us_id_p);
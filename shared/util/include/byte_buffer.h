@@ -69,11 +69,13 @@ GRASSROOTS_UTIL_API void FreeByteBuffer (ByteBuffer *buffer_p);
 
 
 /**
- * Resize a ByteBuffer.
- * The content of the data buffer will be preserved.
+ * Resize a ByteBuffer to an exact size.
+ * The content of the data buffer will be preserved. If new_size is not
+ * greater than the size of the stored data, the data will be truncated
+ * to leave room for a terminating null character.
  *
  * @param buffer_p The ByteBuffer to resize.
- * @param new_size The new size of the ByteBuffer's data.
+ * @param new_size The new size of the ByteBuffer's data. This must be greater than 0.
  * @return <code>true</code> if the resize was successful <code>false</code>
  * upon failure. If the call failed, the contents of the data buffer are preserved.
  * @memberof ByteBuffer
@@ -83,10 +85,12 @@ GRASSROOTS_UTIL_API bool ResizeByteBuffer (ByteBuffer *buffer_p, size_t new_size
 
 /**
  * Increase the size of a ByteBuffer's data buffer.
- * The content of the data buffer will be preserved.
+ * The content of the data buffer will be preserved. The buffer's
+ * capacity is at least doubled, so repeatedly extending a ByteBuffer
+ * by small amounts takes amortised linear time.
  *
  * @param buffer_p The ByteBuffer to resize.
- * @param increment The amount to increase the ByteBuffer's data buffer.
+ * @param increment The minimum amount to increase the ByteBuffer's data buffer by.
  * @return <code>true</code> if the resize was successful <code>false</code>
  * upon failure. If the call failed, the contents of the data buffer are preserved.
  * @memberof ByteBuffer
@@ -94,8 +98,48 @@ GRASSROOTS_UTIL_API bool ResizeByteBuffer (ByteBuffer *buffer_p, size_t new_size
 GRASSROOTS_UTIL_API bool ExtendByteBuffer (ByteBuffer *buffer_p, size_t increment);
 
 
+/**
+ * Make sure that a ByteBuffer's data buffer is at least a given size.
+ * This can be used to avoid repeated reallocations when the final size
+ * of the data is known in advance.
+ *
+ * @param buffer_p The ByteBuffer to reserve the space in.
+ * @param capacity The minimum size, in bytes, of the ByteBuffer's data buffer.
+ * @return <code>true</code> if the ByteBuffer has the required capacity, <code>false</code>
+ * upon failure. If the call failed, the contents of the data buffer are preserved.
+ * @memberof ByteBuffer
+ */
+GRASSROOTS_UTIL_API bool ReserveByteBuffer (ByteBuffer *buffer_p, size_t capacity);
+
+
+/**
+ * Release any unused space at the end of a ByteBuffer's data buffer.
+ * Space for the terminating null character is kept.
+ *
+ * @param buffer_p The ByteBuffer to shrink.
+ * @return <code>true</code> if the ByteBuffer was shrunk successfully or didn't
+ * need shrinking, <code>false</code> upon failure. If the call failed, the
+ * contents of the data buffer are preserved.
+ * @memberof ByteBuffer
+ */
+GRASSROOTS_UTIL_API bool ShrinkByteBufferToFit (ByteBuffer *buffer_p);
+
+
+/**
+ * Get the total size of a ByteBuffer's data buffer including
+ * the space that hasn't been used yet.
+ *
+ * @param buffer_p The ByteBuffer to get the capacity of.
+ * @return The capacity of the ByteBuffer in bytes.
+ * @memberof ByteBuffer
+ */
+GRASSROOTS_UTIL_API size_t GetByteBufferCapacity (const ByteBuffer * const buffer_p);
+
+
 /**
  * Append some data to a ByteBuffer's data buffer.
+ * The data buffer grows geometrically as needed and the
+ * data is always followed by a terminating null character.
  *
  * @param buffer_p The ByteBuffer whose data buffer the new data will be appended to.
  * @param data_p The data to append.
@@ -200,6 +244,21 @@ GRASSROOTS_UTIL_API char *DetachByteBufferData (ByteBuffer * const buffer_p);
 
 
 
+/**
+ * Take ownership of the data stored in a ByteBuffer without copying it.
+ * The ByteBuffer is left empty and can continue to be used.
+ *
+ * @param buffer_p The ByteBuffer to get the data from.
+ * @param length_p If this is not <code>NULL</code>, the length of the data
+ * will be stored here.
+ * @return The data as valid c-style string which must be freed with FreeMemory (),
+ * or <code>NULL</code> upon error in which case the ByteBuffer is unaltered.
+ * @memberof ByteBuffer
+ */
+GRASSROOTS_UTIL_API char *TakeByteBufferData (ByteBuffer *buffer_p, size_t *length_p);
+
+
+
 /**
  * Remove data from the end of a byte buffer
  *
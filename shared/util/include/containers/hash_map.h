@@ -0,0 +1,302 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * hash_map.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A HashMap is an open-addressing hash table that uses Robin Hood
+ * probing. Each entry caches the full hash of its key along with how
+ * far it is from its home slot, so lookups can compare hashes before
+ * keys and can stop as soon as they pass the point where the key would
+ * have been stored. Entries are removed by shifting the rest of their
+ * probe chain back a slot, so deletions never leave tombstones behind
+ * and lookups stay fast however many removals have taken place.
+ *
+ * String, pointer and uuid keys are handled directly by the HashMap
+ * without going through function pointers.
+ */
+
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+
+#include "typedefs.h"
+#include "memory_allocations.h"
+#include "grassroots_util_library.h"
+
+
+/**
+ * The different types of key that a HashMap can use.
+ *
+ * @ingroup utility_group
+ */
+typedef enum HashMapKeyType
+{
+	/** The keys are null-terminated strings. */
+	HMKT_STRING,
+
+	/** The keys are compared by their addresses only. */
+	HMKT_POINTER,
+
+	/** The keys point to the UUID_RAW_SIZE bytes of a uuid_t. */
+	HMKT_UUID,
+
+	/** The keys use the functions set by SetHashMapKeyFunctions (). */
+	HMKT_CUSTOM
+} HashMapKeyType;
+
+
+/**
+ * A single slot in a HashMap.
+ *
+ * @ingroup utility_group
+ */
+typedef struct HashMapEntry
+{
+	/** The key. */
+	const void *hme_key_p;
+
+	/** The value. */
+	void *hme_value_p;
+
+	/** The cached hash of the key. This is 0 if the slot is empty. */
+	uint32 hme_hash;
+
+	/** How many slots this entry is from the slot that its hash maps to. */
+	uint32 hme_distance;
+} HashMapEntry;
+
+
+/**
+ * An open-addressing hash table using Robin Hood probing.
+ *
+ * @ingroup utility_group
+ */
+typedef struct HashMap
+{
+	/** @privatesection */
+	HashMapEntry *hm_entries_p;
+
+	/* This is always a power of 2 */
+	uint32 hm_capacity;
+
+	uint32 hm_size;
+
+	uint32 hm_load_limit;
+
+	uint8 hm_load_percentage;
+
+	HashMapKeyType hm_key_type;
+
+	MEM_FLAG hm_key_mem;
+
+	MEM_FLAG hm_value_mem;
+
+	uint32 (*hm_hash_key_fn) (const void *key_p);
+
+	bool (*hm_compare_keys_fn) (const void *key0_p, const void *key1_p);
+
+	void *(*hm_copy_key_fn) (const void *key_p);
+
+	void (*hm_free_key_fn) (void *key_p);
+
+	void *(*hm_copy_value_fn) (const void *value_p);
+
+	void (*hm_free_value_fn) (void *value_p);
+} HashMap;
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Allocate a HashMap.
+ *
+ * @param initial_capacity The number of entries to initially make room for.
+ * @param load_percentage How full, as a percentage, the HashMap can become before
+ * it is extended. This is clamped to between 10 and 95.
+ * @param key_type The type of keys that the HashMap will use.
+ * @param key_mem How the HashMap stores the keys. For MF_DEEP_COPY, string and uuid
+ * keys are copied, for MF_SHALLOW_COPY the HashMap takes ownership of the keys and
+ * for MF_SHADOW_USE the keys must stay valid for as long as they are in the HashMap.
+ * Pointer keys are never copied or freed.
+ * @param value_mem How the HashMap stores the values. MF_DEEP_COPY requires a copy
+ * function to be set with SetHashMapValueFunctions ().
+ * @return The new HashMap or <code>NULL</code> upon error.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API HashMap *AllocateHashMap (const uint32 initial_capacity, const uint8 load_percentage, const HashMapKeyType key_type, const MEM_FLAG key_mem, const MEM_FLAG value_mem);
+
+
+/**
+ * Free a HashMap along with any keys and values that it owns.
+ *
+ * @param map_p The HashMap to free.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API void FreeHashMap (HashMap *map_p);
+
+
+/**
+ * Remove all of the entries from a HashMap, freeing any keys and values that
+ * it owns. The capacity of the HashMap is kept.
+ *
+ * @param map_p The HashMap to clear.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API void ClearHashMap (HashMap *map_p);
+
+
+/**
+ * Set the functions used for the keys of a HashMap of HMKT_CUSTOM keys. This must be
+ * called before any entries are added.
+ *
+ * @param map_p The HashMap to set the functions for.
+ * @param hash_key_fn The function to hash a key.
+ * @param compare_keys_fn The function to check whether two keys are equal.
+ * @param copy_key_fn The function to copy a key if the HashMap uses MF_DEEP_COPY for its keys.
+ * This can be <code>NULL</code> otherwise.
+ * @param free_key_fn The function to free a key that the HashMap owns. If this is <code>NULL</code>,
+ * FreeMemory () will be used.
+ * @return <code>true</code> if the functions were set successfully, <code>false</code> if
+ * the HashMap does not use HMKT_CUSTOM keys or already has entries.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API bool SetHashMapKeyFunctions (HashMap *map_p, uint32 (*hash_key_fn) (const void *key_p), bool (*compare_keys_fn) (const void *key0_p, const void *key1_p), void *(*copy_key_fn) (const void *key_p), void (*free_key_fn) (void *key_p));
+
+
+/**
+ * Set the functions used for the values of a HashMap.
+ *
+ * @param map_p The HashMap to set the functions for.
+ * @param copy_value_fn The function to copy a value if the HashMap uses MF_DEEP_COPY for
+ * its values.
+ * @param free_value_fn The function to free a value that the HashMap owns. If this is <code>NULL</code>,
+ * FreeMemory () will be used.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API void SetHashMapValueFunctions (HashMap *map_p, void *(*copy_value_fn) (const void *value_p), void (*free_value_fn) (void *value_p));
+
+
+/**
+ * Add a key-value pair to a HashMap. If the key is already in the HashMap,
+ * its value will be replaced.
+ *
+ * @param map_p The HashMap to add the key-value pair to.
+ * @param key_p The key.
+ * @param value_p The value.
+ * @return <code>true</code> if the key-value pair was added successfully, <code>false</code>
+ * otherwise.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API bool PutInHashMap (HashMap *map_p, const void *key_p, const void *value_p);
+
+
+/**
+ * Get the value for a given key from a HashMap.
+ *
+ * @param map_p The HashMap to search.
+ * @param key_p The key.
+ * @return The value or <code>NULL</code> if the key is not in the HashMap.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API void *GetFromHashMap (const HashMap *map_p, const void *key_p);
+
+
+/**
+ * Check whether a HashMap has an entry for a given key.
+ *
+ * @param map_p The HashMap to search.
+ * @param key_p The key.
+ * @return <code>true</code> if the key is in the HashMap, <code>false</code> otherwise.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API bool IsKeyInHashMap (const HashMap *map_p, const void *key_p);
+
+
+/**
+ * Remove the entry for a given key from a HashMap, freeing the key and value
+ * if the HashMap owns them. If the key is not in the HashMap, this does nothing.
+ *
+ * @param map_p The HashMap to remove the entry from.
+ * @param key_p The key.
+ * @return <code>true</code> if an entry was removed, <code>false</code> otherwise.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API bool RemoveFromHashMap (HashMap *map_p, const void *key_p);
+
+
+/**
+ * Get the number of entries in a HashMap.
+ *
+ * @param map_p The HashMap.
+ * @return The number of entries.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API uint32 GetHashMapSize (const HashMap *map_p);
+
+
+/**
+ * Make sure that a HashMap can hold a given number of entries without
+ * needing to be extended.
+ *
+ * @param map_p The HashMap.
+ * @param num_entries The number of entries to make room for.
+ * @return <code>true</code> if the HashMap has enough room, <code>false</code> if
+ * it could not be extended.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API bool ReserveHashMap (HashMap *map_p, const uint32 num_entries);
+
+
+/**
+ * Step through the entries of a HashMap. The entries are returned in
+ * no particular order and the HashMap must not be altered during the iteration.
+ *
+ * @param map_p The HashMap to iterate over.
+ * @param index_p The position to continue from. This should be set to 0 before the first call.
+ * @param key_pp If this is not <code>NULL</code>, the key of the next entry will be stored here.
+ * @param value_pp If this is not <code>NULL</code>, the value of the next entry will be stored here.
+ * @return <code>true</code> if there was another entry, <code>false</code> if the iteration has
+ * finished.
+ * @memberof HashMap
+ */
+GRASSROOTS_UTIL_API bool GetNextHashMapEntry (const HashMap *map_p, uint32 *index_p, const void **key_pp, void **value_pp);
+
+
+/**
+ * The hash function that a HashMap uses for string keys.
+ *
+ * @param key_p The string to hash.
+ * @return The hash value.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API uint32 HashMapStringHash (const void *key_p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef HASH_MAP_H */
@@ -22,6 +22,7 @@
 #define STRING_HASH_TABLE_H
 
 #include "hash_table.h"
+#include "hash_map.h"
 #include "grassroots_util_library.h"
 
 #ifdef __cplusplus
@@ -56,6 +57,20 @@ GRASSROOTS_UTIL_API HashTable *GetHashTableOfStrings (const uint32 initial_capac
 GRASSROOTS_UTIL_API HashTable *GetHashTableOfStringInts (const uint32 initial_capacity, const uint8 load_percentage);
 
 
+/**
+ * Create a HashMap where both the keys and values are strings. The HashMap
+ * makes its own copies of the keys and values that are added to it.
+ *
+ * @param initial_capacity The number of entries to initially make room for.
+ * @param load_percentage The percentage value for how full the HashMap should
+ * be allowed to become before it is extended.
+ * @return The HashMap or <code>NULL</code> is there was an error.
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API HashMap *GetHashMapOfStrings (const uint32 initial_capacity, const uint8 load_percentage);
+
+
 /**
  * Compare the keys of two StringHashBuckets.
  *
@@ -0,0 +1,328 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * vector.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A Vector is a growable array that stores its elements contiguously
+ * by value. Walking through it touches consecutive memory rather than
+ * chasing pointers from node to node, and it can be sorted and binary
+ * searched in place, which makes it a better fit than a LinkedList for
+ * collections that are mostly iterated or looked up.
+ *
+ * Elements keep their relative order when others are inserted or
+ * removed, so index-based iteration is stable. Typed accessors for
+ * pointers, integers and doubles are declared at the end of this file.
+ */
+
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include <stddef.h>
+
+#include "typedefs.h"
+#include "grassroots_util_library.h"
+
+
+/**
+ * A growable array of fixed-size elements.
+ *
+ * @ingroup utility_group
+ */
+typedef struct Vector
+{
+	/** @privatesection */
+	char *ve_data_p;
+
+	size_t ve_element_size;
+
+	uint32 ve_size;
+
+	uint32 ve_capacity;
+
+	/*
+	 * For Vectors of pointers, this is called with each pointer, otherwise
+	 * it is called with the address of each element.
+	 */
+	void (*ve_free_element_fn) (void *element_p);
+
+	bool ve_pointers_flag;
+} Vector;
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Allocate a Vector.
+ *
+ * @param element_size The size of each element in bytes.
+ * @param initial_capacity The number of elements to initially make room for.
+ * @param free_element_fn If this is not <code>NULL</code>, it is called with the
+ * address of each element when it is removed from the Vector so that any resources
+ * that the element owns can be released.
+ * @return The new Vector or <code>NULL</code> upon error.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API Vector *AllocateVector (const size_t element_size, const uint32 initial_capacity, void (*free_element_fn) (void *element_p));
+
+
+/**
+ * Allocate a Vector that stores pointers.
+ *
+ * @param initial_capacity The number of pointers to initially make room for.
+ * @param free_pointer_fn If this is not <code>NULL</code>, it is called with each
+ * pointer when it is removed from the Vector, e.g. FreeParameter.
+ * @return The new Vector or <code>NULL</code> upon error.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API Vector *AllocatePointerVector (const uint32 initial_capacity, void (*free_pointer_fn) (void *value_p));
+
+
+/**
+ * Initialise a Vector that is embedded in another structure.
+ *
+ * @param vector_p The Vector to initialise.
+ * @param element_size The size of each element in bytes.
+ * @param free_element_fn The function to release each element. This can be <code>NULL</code>.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void InitVector (Vector *vector_p, const size_t element_size, void (*free_element_fn) (void *element_p));
+
+
+/**
+ * Free a Vector and all of its elements.
+ *
+ * @param vector_p The Vector to free.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void FreeVector (Vector *vector_p);
+
+
+/**
+ * Remove all of the elements from a Vector. The Vector keeps its storage
+ * so that it can be refilled without reallocating.
+ *
+ * @param vector_p The Vector to clear.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void ClearVector (Vector *vector_p);
+
+
+/**
+ * Make sure that a Vector can hold a given number of elements without
+ * needing to grow.
+ *
+ * @param vector_p The Vector.
+ * @param capacity The number of elements to make room for.
+ * @return <code>true</code> if the Vector has room for the given number of
+ * elements, <code>false</code> upon error.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool ReserveVector (Vector *vector_p, const uint32 capacity);
+
+
+/**
+ * Add an element to the end of a Vector.
+ *
+ * @param vector_p The Vector.
+ * @param element_p The address of the element to copy into the Vector.
+ * @return <code>true</code> if the element was added successfully, <code>false</code> otherwise.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool AppendToVector (Vector *vector_p, const void *element_p);
+
+
+/**
+ * Add an array of elements to the end of a Vector in a single operation.
+ *
+ * @param vector_p The Vector.
+ * @param elements_p The array of elements to copy into the Vector.
+ * @param num_elements The number of elements in the array.
+ * @return <code>true</code> if the elements were added successfully, <code>false</code> otherwise.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool AppendArrayToVector (Vector *vector_p, const void *elements_p, const uint32 num_elements);
+
+
+/**
+ * Insert an element into a Vector. The elements after it move up one place.
+ *
+ * @param vector_p The Vector.
+ * @param index The index that the new element will have. If this is the size
+ * of the Vector, the element is appended.
+ * @param element_p The address of the element to copy into the Vector.
+ * @return <code>true</code> if the element was inserted successfully, <code>false</code> otherwise.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool InsertIntoVector (Vector *vector_p, const uint32 index, const void *element_p);
+
+
+/**
+ * Remove an element from a Vector, freeing it if the Vector has a free function.
+ * The elements after it move down one place so their order is kept.
+ *
+ * @param vector_p The Vector.
+ * @param index The index of the element to remove.
+ * @return <code>true</code> if the element was removed, <code>false</code> if
+ * the index was out of range.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool RemoveFromVector (Vector *vector_p, const uint32 index);
+
+
+/**
+ * Get the address of an element in a Vector. This stays valid until the
+ * Vector is next changed.
+ *
+ * @param vector_p The Vector.
+ * @param index The index of the element.
+ * @return The address of the element or <code>NULL</code> if the index is out of range.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void *GetVectorElement (const Vector *vector_p, const uint32 index);
+
+
+/**
+ * Iterate through the elements of a Vector in order.
+ *
+ * @param vector_p The Vector.
+ * @param index_p The index to start from. This should be set to 0 before the
+ * first call and is updated on each call.
+ * @return The address of the next element or <code>NULL</code> when there
+ * are no more elements.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void *GetNextVectorElement (const Vector *vector_p, uint32 *index_p);
+
+
+/**
+ * Sort the elements of a Vector in place.
+ *
+ * @param vector_p The Vector.
+ * @param compare_fn The function used to compare two elements. It is called
+ * with the addresses of the elements and returns a negative value, zero or a
+ * positive value in the same way as for qsort ().
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void SortVector (Vector *vector_p, int (*compare_fn) (const void *v1_p, const void *v2_p));
+
+
+/**
+ * Binary search a sorted Vector.
+ *
+ * @param vector_p The Vector which must be sorted according to compare_fn.
+ * @param key_p The address of a value to search for.
+ * @param compare_fn The function used to sort the Vector.
+ * @param index_p If this is not <code>NULL</code>, it is set to the index of the
+ * matching element or, if there is no match, the index at which the key would
+ * be inserted to keep the Vector sorted.
+ * @return The address of the matching element or <code>NULL</code> if there isn't one.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void *BinarySearchVector (const Vector *vector_p, const void *key_p, int (*compare_fn) (const void *v1_p, const void *v2_p), uint32 *index_p);
+
+
+/**
+ * Get the number of elements in a Vector.
+ *
+ * @param vector_p The Vector.
+ * @return The number of elements.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API uint32 GetVectorSize (const Vector *vector_p);
+
+
+/**
+ * Add a pointer to the end of a Vector created with AllocatePointerVector ().
+ *
+ * @param vector_p The Vector.
+ * @param value_p The pointer to add.
+ * @return <code>true</code> if the pointer was added successfully, <code>false</code> otherwise.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool AppendPointerToVector (Vector *vector_p, void *value_p);
+
+
+/**
+ * Get a pointer from a Vector created with AllocatePointerVector ().
+ *
+ * @param vector_p The Vector.
+ * @param index The index of the pointer.
+ * @return The pointer or <code>NULL</code> if the index is out of range.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API void *GetPointerFromVector (const Vector *vector_p, const uint32 index);
+
+
+/**
+ * Add an int32 to the end of a Vector of int32s.
+ *
+ * @param vector_p The Vector.
+ * @param value The value to add.
+ * @return <code>true</code> if the value was added successfully, <code>false</code> otherwise.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool AppendInt32ToVector (Vector *vector_p, const int32 value);
+
+
+/**
+ * Get an int32 from a Vector of int32s.
+ *
+ * @param vector_p The Vector.
+ * @param index The index of the value which must be in range.
+ * @return The value.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API int32 GetInt32FromVector (const Vector *vector_p, const uint32 index);
+
+
+/**
+ * Add a double to the end of a Vector of doubles.
+ *
+ * @param vector_p The Vector.
+ * @param value The value to add.
+ * @return <code>true</code> if the value was added successfully, <code>false</code> otherwise.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API bool AppendDoubleToVector (Vector *vector_p, const double value);
+
+
+/**
+ * Get a double from a Vector of doubles.
+ *
+ * @param vector_p The Vector.
+ * @param index The index of the value which must be in range.
+ * @return The value.
+ * @memberof Vector
+ */
+GRASSROOTS_UTIL_API double GetDoubleFromVector (const Vector *vector_p, const uint32 index);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef VECTOR_H */
@@ -0,0 +1,188 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * async_output_stream.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * An AsyncOutputStream moves the cost of writing log messages off of the
+ * threads that produce them. Each message is formatted straight into a
+ * slot of a fixed-size ring buffer that any number of threads can add to
+ * without taking a lock, and a single writer thread copies the pending
+ * messages out in batches with one write and flush per batch.
+ *
+ * Messages above the stream's level are discarded before they are
+ * formatted. If the ring buffer is full, new messages are dropped rather
+ * than blocking the caller, and the number dropped is counted and
+ * reported in the output.
+ */
+
+#ifndef ASYNC_OUTPUT_STREAM_H
+#define ASYNC_OUTPUT_STREAM_H
+
+#include <pthread.h>
+
+#include "grassroots_util_library.h"
+#include "streams.h"
+
+
+/**
+ * The number of messages that an AsyncOutputStream can hold
+ * if no size is given.
+ *
+ * @ingroup utility_group
+ */
+#define ASYNC_OUTPUT_STREAM_DEFAULT_NUM_SLOTS (4096)
+
+
+/**
+ * The maximum length of a single message, including the filename
+ * and line number prefix. Longer messages are truncated.
+ *
+ * @ingroup utility_group
+ */
+#define ASYNC_OUTPUT_STREAM_MESSAGE_SIZE (512)
+
+
+struct AsyncLogSlot;
+
+
+/**
+ * @brief An OutputStream that writes to a file from a background thread.
+ *
+ * @extends OutputStream
+ *
+ * @ingroup utility_group
+ */
+typedef struct AsyncOutputStream
+{
+	/** The base OutputStream */
+	OutputStream aos_stream;
+
+	/**
+	 * The least severe level to write. Messages with a level greater
+	 * than this are ignored, apart from those at STM_LEVEL_ALL.
+	 */
+	uint32 aos_level;
+
+	/** @privatesection */
+	FILE *aos_out_f;
+
+	bool aos_close_on_exit_flag;
+
+	struct AsyncLogSlot *aos_slots_p;
+
+	/* This is always a power of 2 */
+	uint32 aos_num_slots;
+
+	/* Claimed by the producing threads */
+	uint64 aos_enqueue_pos;
+
+	/* Only changed by the writer thread */
+	uint64 aos_dequeue_pos;
+
+	/* The position up to which messages have been written and flushed */
+	uint64 aos_flushed_pos;
+
+	uint64 aos_num_written;
+
+	uint64 aos_num_dropped;
+
+	uint64 aos_num_filtered;
+
+	bool aos_stop_flag;
+
+	bool aos_writer_waiting_flag;
+
+	pthread_t aos_writer_thread;
+
+	pthread_mutex_t aos_mutex;
+
+	pthread_cond_t aos_cond;
+} AsyncOutputStream;
+
+
+/**
+ * @brief The counters for an AsyncOutputStream.
+ *
+ * @ingroup utility_group
+ */
+typedef struct AsyncOutputStreamStats
+{
+	/** The number of messages written to the file. */
+	uint64 aoss_num_written;
+
+	/** The number of messages dropped because the ring buffer was full. */
+	uint64 aoss_num_dropped;
+
+	/** The number of messages ignored because of their level. */
+	uint64 aoss_num_filtered;
+} AsyncOutputStreamStats;
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * @brief Allocate an AsyncOutputStream and start its writer thread.
+ *
+ * @param filename_s The filename to write to. If this is <code>NULL</code> or cannot
+ * be opened for writing, default_f is used instead.
+ * @param default_f The FILE to write to if filename_s isn't used, e.g. stdout or stderr.
+ * @param level The least severe level of message to write, e.g. STM_LEVEL_INFO.
+ * @param num_slots The number of messages that can be waiting to be written. This is
+ * rounded up to a power of 2 and if it is 0, ASYNC_OUTPUT_STREAM_DEFAULT_NUM_SLOTS is used.
+ * @return A newly-allocated AsyncOutputStream or <code>NULL</code> on error.
+ * @memberof AsyncOutputStream
+ * @see DeallocateAsyncOutputStream
+ */
+GRASSROOTS_UTIL_API OutputStream *AllocateAsyncOutputStream (const char * const filename_s, FILE *default_f, const uint32 level, const uint32 num_slots);
+
+
+/**
+ * @brief Free an AsyncOutputStream.
+ *
+ * Any waiting messages are written before the writer thread is stopped.
+ *
+ * @param stream_p The AsyncOutputStream to free.
+ * @memberof AsyncOutputStream
+ */
+GRASSROOTS_UTIL_API void DeallocateAsyncOutputStream (OutputStream *stream_p);
+
+
+/**
+ * @brief Get the counters for an AsyncOutputStream.
+ *
+ * @param stream_p The AsyncOutputStream.
+ * @param stats_p The AsyncOutputStreamStats to fill in.
+ * @memberof AsyncOutputStream
+ */
+GRASSROOTS_UTIL_API void GetAsyncOutputStreamStats (const OutputStream *stream_p, AsyncOutputStreamStats *stats_p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* ASYNC_OUTPUT_STREAM_H */
@@ -0,0 +1,120 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * json_output_stream.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A JSONOutputStream writes each message as a single line holding one
+ * compact JSON object, e.g.
+ *
+ * {"time":"2018-10-18T09:15:02.391Z","level":"warning","file":"service.c","line":123,"correlation_id":"...","message":"..."}
+ *
+ * so that the log can be parsed and the lines for a given request picked
+ * out by their correlation id. Any JSON payloads from PrintJSONToLog and
+ * PrintJSONToErrors are embedded compactly under the "payload" key, with
+ * large payloads being sampled to keep the volume of the log down.
+ */
+
+#ifndef JSON_OUTPUT_STREAM_H
+#define JSON_OUTPUT_STREAM_H
+
+#include "grassroots_util_library.h"
+#include "streams.h"
+
+
+/**
+ * @brief An OutputStream that writes one compact JSON object per message.
+ *
+ * @extends OutputStream
+ *
+ * @ingroup utility_group
+ */
+typedef struct JSONOutputStream
+{
+	/** The base OutputStream */
+	OutputStream jos_stream;
+
+	/**
+	 * The least severe level to write. Messages with a level greater
+	 * than this are ignored, apart from those at STM_LEVEL_ALL.
+	 */
+	uint32 jos_level;
+
+	/**
+	 * Payloads that take up more than this number of bytes are only
+	 * written for one in every jos_payload_sample_rate messages. If
+	 * this is 0, every payload is written.
+	 */
+	uint32 jos_max_payload_size;
+
+	/**
+	 * Write one in this many large payloads. The others are replaced by
+	 * their size. If this is 0, no large payloads are written.
+	 */
+	uint32 jos_payload_sample_rate;
+
+	/** @privatesection */
+	FILE *jos_out_f;
+
+	bool jos_close_on_exit_flag;
+
+	uint64 jos_num_large_payloads;
+} JSONOutputStream;
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * @brief Allocate a JSONOutputStream.
+ *
+ * @param filename_s The filename to append to. If this is <code>NULL</code> or cannot
+ * be opened for appending, default_f is used instead.
+ * @param default_f The FILE to write to if filename_s isn't used, e.g. stdout or stderr.
+ * @param level The least severe level of message to write, e.g. STM_LEVEL_INFO.
+ * @param max_payload_size The size in bytes above which payloads are sampled or 0 to
+ * write all of them.
+ * @param payload_sample_rate Write one in this many large payloads.
+ * @return A newly-allocated JSONOutputStream or <code>NULL</code> on error.
+ * @memberof JSONOutputStream
+ * @see DeallocateJSONOutputStream
+ */
+GRASSROOTS_UTIL_API OutputStream *AllocateJSONOutputStream (const char * const filename_s, FILE *default_f, const uint32 level, const uint32 max_payload_size, const uint32 payload_sample_rate);
+
+
+/**
+ * @brief Free a JSONOutputStream.
+ *
+ * @param stream_p The JSONOutputStream to free.
+ * @memberof JSONOutputStream
+ */
+GRASSROOTS_UTIL_API void DeallocateJSONOutputStream (OutputStream *stream_p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* JSON_OUTPUT_STREAM_H */
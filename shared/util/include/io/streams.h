@@ -92,9 +92,19 @@
 #define STM_LEVEL_ALL		(0xFFFFFFFF)
 
 
+/**
+ * The size of the buffer used to hold a correlation id, including
+ * the terminating '\0'.
+ *
+ * @ingroup utility_group
+ */
+#define LOG_CORRELATION_ID_BUFFER_SIZE (64)
+
+
 
 /******** FORWARD DECLARATION ******/
 struct OutputStream;
+struct json_t;
 
 
 /**
@@ -129,6 +139,23 @@ typedef struct OutputStream
 	 */
 	bool (*st_flush_fn) (struct OutputStream *stream_p);
 
+	/**
+	 * Print a message along with a JSON payload to an OutputStream that
+	 * writes structured output. This can be <code>NULL</code>, in which
+	 * case the payload is printed as text after the message.
+	 *
+	 * @param stream_p The OutputStream to print to.
+	 * @param level The level of the message.
+	 * @param json_p The JSON payload to print. This can be <code>NULL</code>.
+	 * @param message_s The message to print. This can include the standard
+	 * printf format specifiers.
+	 * @param args Any arguments to match against the format specifiers.
+	 * @return If successful, the total number of characters written. If this
+	 * is negative then an error has occurred.
+	 * @see PrintJSONToLog
+	 */
+	int (*st_print_json_fn) (struct OutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const struct json_t *json_p, const char *message_s, va_list args);
+
 	/**
 	 * Callback function to free the OutputStream if it needs any custom behaviour.
 	 *
@@ -330,6 +357,50 @@ GRASSROOTS_UTIL_API bool FlushLog (void);
 GRASSROOTS_UTIL_API bool FlushErrors (void);
 
 
+/**
+ * Get the stream level for its name, e.g. "warning" for STM_LEVEL_WARNING.
+ *
+ * @param level_s The name of the level. This is one of "none", "severe", "warning",
+ * "info", "fine", "finer", "finest" or "all".
+ * @param level_p Where the level will be stored.
+ * @return <code>true</code> if the name was recognised, <code>false</code> otherwise.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API bool GetStreamLevelFromString (const char * const level_s, uint32 *level_p);
+
+
+/**
+ * Get the name of a stream level, e.g. "warning" for STM_LEVEL_WARNING.
+ *
+ * @param level The level.
+ * @return The name of the level or "all" if it is not one of the named levels.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API const char *GetStreamLevelAsString (const uint32 level);
+
+
+/**
+ * Set the correlation id that ties together all of the messages logged
+ * by the current thread whilst it works on a given request. The id is
+ * copied so it is per-thread and doesn't need to outlive this call.
+ *
+ * @param id_s The correlation id or <code>NULL</code> to clear it. Ids
+ * that need more than LOG_CORRELATION_ID_BUFFER_SIZE bytes are truncated.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void SetLogCorrelationId (const char * const id_s);
+
+
+/**
+ * Get the correlation id for the current thread.
+ *
+ * @return The correlation id or <code>NULL</code> if one has not been set.
+ * @see SetLogCorrelationId
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API const char *GetLogCorrelationId (void);
+
+
 #ifdef __cplusplus
 }
 #endif
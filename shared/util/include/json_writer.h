@@ -0,0 +1,269 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * json_writer.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A JSONWriter serialises JSON a piece at a time rather than building a
+ * complete jansson tree and dumping it to a string. The output is gathered
+ * into a fixed-size chunk which is passed to a sink function, e.g. one that
+ * appends to a ByteBuffer or a RopeBuffer or writes to a socket, each time
+ * that it fills up. Existing jansson values can be written into the middle
+ * of the output too and they are streamed through the same chunk, so a
+ * large result never needs to be held as a single string.
+ *
+ * The output is byte-for-byte the same as json_dumps () gives for the
+ * equivalent tree when the same flags are used, with the exception of
+ * JSON_INDENT which is not supported. JSON_SORT_KEYS only applies to the
+ * jansson values that are written, since the keys that are added directly
+ * are written in the order that they are added.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+
+#include "jansson.h"
+
+#include "grassroots_util_library.h"
+#include "byte_buffer.h"
+#include "typedefs.h"
+
+
+/**
+ * The default size, in bytes, of the chunks that a JSONWriter passes
+ * to its sink.
+ *
+ * @ingroup utility_group
+ */
+#define JSON_WRITER_DEFAULT_CHUNK_SIZE (16384)
+
+
+/**
+ * A function that a JSONWriter passes its output to. This has the same
+ * signature as json_dump_callback_t so RopeBufferJSONDumpCallback () and
+ * the like can be used as sinks too.
+ *
+ * @param data_s The data to write. This is not <code>NULL</code>-terminated.
+ * @param size The length, in bytes, of the data.
+ * @param sink_data_p The custom data that was passed to AllocateJSONWriter ().
+ * @return 0 on success, -1 on error.
+ * @ingroup utility_group
+ */
+typedef int (*JSONWriterSink) (const char *data_s, size_t size, void *sink_data_p);
+
+
+/**
+ * @brief A serialiser that streams JSON to a sink.
+ *
+ * @ingroup utility_group
+ */
+typedef struct JSONWriter JSONWriter;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Allocate a JSONWriter.
+ *
+ * @param sink_fn The function that the output will be passed to.
+ * @param sink_data_p The custom data to pass to sink_fn.
+ * @param flags The jansson encoding flags to use, e.g. JSON_COMPACT.
+ * @param chunk_size The most data that will be held before it is passed
+ * to sink_fn. If this is 0, JSON_WRITER_DEFAULT_CHUNK_SIZE will be used.
+ * @return The newly-allocated JSONWriter or <code>NULL</code> on error.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API JSONWriter *AllocateJSONWriter (JSONWriterSink sink_fn, void *sink_data_p, const size_t flags, const size_t chunk_size);
+
+
+/**
+ * Free a JSONWriter. Any output that has not been flushed is discarded.
+ *
+ * @param writer_p The JSONWriter to free.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API void FreeJSONWriter (JSONWriter *writer_p);
+
+
+/**
+ * Pass any output that the JSONWriter is holding on to its sink.
+ *
+ * @param writer_p The JSONWriter to flush.
+ * @return <code>true</code> if all of the output so far has been written
+ * successfully, <code>false</code> if the JSONWriter has failed.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool FlushJSONWriter (JSONWriter *writer_p);
+
+
+/**
+ * Check whether a JSONWriter has written a complete value, i.e. its top-level
+ * value has been written and every object and array has been closed.
+ *
+ * @param writer_p The JSONWriter to check.
+ * @return <code>true</code> if the value is complete, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool IsJSONWriterComplete (const JSONWriter *writer_p);
+
+
+/**
+ * Start writing a JSON object.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool OpenJSONWriterObject (JSONWriter *writer_p);
+
+
+/**
+ * Finish writing the current JSON object.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool CloseJSONWriterObject (JSONWriter *writer_p);
+
+
+/**
+ * Start writing a JSON array.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool OpenJSONWriterArray (JSONWriter *writer_p);
+
+
+/**
+ * Finish writing the current JSON array.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool CloseJSONWriterArray (JSONWriter *writer_p);
+
+
+/**
+ * Write the key for the next value in the current JSON object.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @param key_s The key to write.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool AddKeyToJSONWriter (JSONWriter *writer_p, const char *key_s);
+
+
+/**
+ * Write a string value.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @param value_s The UTF-8 string to write.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool AddStringToJSONWriter (JSONWriter *writer_p, const char *value_s);
+
+
+/**
+ * Write an integer value.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @param value The value to write.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool AddIntegerToJSONWriter (JSONWriter *writer_p, const json_int_t value);
+
+
+/**
+ * Write a real value.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @param value The value to write. This must be finite.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool AddRealToJSONWriter (JSONWriter *writer_p, const double value);
+
+
+/**
+ * Write a boolean value.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @param value The value to write.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool AddBooleanToJSONWriter (JSONWriter *writer_p, const bool value);
+
+
+/**
+ * Write a null value.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool AddNullToJSONWriter (JSONWriter *writer_p);
+
+
+/**
+ * Write a jansson value. This is streamed through the JSONWriter's chunk
+ * so no string copy of it is made.
+ *
+ * @param writer_p The JSONWriter to use.
+ * @param value_p The value to write.
+ * @return <code>true</code> if successful, <code>false</code> otherwise.
+ * @memberof JSONWriter
+ */
+GRASSROOTS_UTIL_API bool AddJSONToJSONWriter (JSONWriter *writer_p, const json_t *value_p);
+
+
+/**
+ * A JSONWriterSink that appends the output to a ByteBuffer.
+ *
+ * @param data_s The data to append.
+ * @param size The length, in bytes, of the data.
+ * @param buffer_p The ByteBuffer to append the data to.
+ * @return 0 on success, -1 on error.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API int ByteBufferJSONWriterSink (const char *data_s, size_t size, void *buffer_p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* JSON_WRITER_H */
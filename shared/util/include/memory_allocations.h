@@ -126,6 +126,34 @@ typedef enum MEM_FLAG
 #endif
 
 
+/*
+ * Uncomment this to allocate the nodes of the LinkedLists in the
+ * Grassroots containers from the thread-caching node pool rather
+ * than with AllocMemory ().
+ */
+/* #define USE_POOLED_LIST_NODES */
+
+#ifdef USE_POOLED_LIST_NODES
+	#include "node_pool.h"
+	#define AllocListNodeMemory(x)	AllocatePoolNode(x)
+	#define FreeListNodeMemory(x)	FreePoolNode(x)
+	#define BeginListNodeRelease()	BeginPoolNodeRelease()
+	#define EndListNodeRelease()	EndPoolNodeRelease()
+#else
+	/** Allocate the memory for a ListItem of x bytes */
+	#define AllocListNodeMemory(x)	AllocMemory(x)
+
+	/** Free the memory for a ListItem allocated with AllocListNodeMemory () */
+	#define FreeListNodeMemory(x)	FreeMemory(x)
+
+	/** Mark the start of freeing all of the nodes in a LinkedList */
+	#define BeginListNodeRelease()	do {} while (0)
+
+	/** Mark the end of freeing all of the nodes in a LinkedList */
+	#define EndListNodeRelease()	do {} while (0)
+#endif
+
+
 struct MappedMemory;
 
 
@@ -0,0 +1,215 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * memory_arena.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A MemoryArena hands out memory from large chunks by simply moving a
+ * pointer along, and everything that it has handed out is released in a
+ * single operation when the arena is reset or freed. Objects that need more
+ * than their memory releasing, such as a ParameterSet, can register a
+ * cleanup function with the arena so that their lifetimes are tied to it.
+ *
+ * Each thread also has a request arena which is used for the transient data
+ * created whilst a server request is processed.
+ */
+
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+#include <stddef.h>
+
+#include "typedefs.h"
+#include "grassroots_util_library.h"
+
+
+/**
+ * The default size, in bytes, of each chunk of memory that a MemoryArena
+ * allocates from.
+ *
+ * @ingroup utility_group
+ */
+#define MEMORY_ARENA_DEFAULT_CHUNK_SIZE (16384)
+
+
+/* forward declarations */
+struct MemoryArenaChunk;
+struct MemoryArenaCleanup;
+
+
+/**
+ * Counters for the activity of a MemoryArena.
+ *
+ * @ingroup utility_group
+ */
+typedef struct MemoryArenaStatistics
+{
+	/** The number of allocations made from the arena since it was last reset. */
+	uint32 mas_num_allocations;
+
+	/** The number of bytes handed out since it was last reset. */
+	size_t mas_num_bytes;
+
+	/** The number of chunks that the arena currently has. */
+	uint32 mas_num_chunks;
+
+	/** The number of cleanup functions currently registered. */
+	uint32 mas_num_cleanups;
+} MemoryArenaStatistics;
+
+
+/**
+ * A region of memory that is freed all at once.
+ *
+ * @ingroup utility_group
+ */
+typedef struct MemoryArena
+{
+	/** The chunk that allocations are currently made from. */
+	struct MemoryArenaChunk *ma_current_chunk_p;
+
+	/** The cleanup functions, most recently added first. */
+	struct MemoryArenaCleanup *ma_cleanups_p;
+
+	/** The size of each new chunk. */
+	size_t ma_chunk_size;
+
+	/** The arena's counters. */
+	MemoryArenaStatistics ma_stats;
+} MemoryArena;
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Allocate a MemoryArena.
+ *
+ * @param chunk_size The size, in bytes, of each chunk that the arena allocates.
+ * If this is 0, MEMORY_ARENA_DEFAULT_CHUNK_SIZE is used.
+ * @return The new MemoryArena or <code>NULL</code> upon error.
+ * @memberof MemoryArena
+ */
+GRASSROOTS_UTIL_API MemoryArena *AllocateMemoryArena (const size_t chunk_size);
+
+
+/**
+ * Run a MemoryArena's cleanup functions and free it along with all of the
+ * memory that it has handed out.
+ *
+ * @param arena_p The MemoryArena to free.
+ * @memberof MemoryArena
+ */
+GRASSROOTS_UTIL_API void FreeMemoryArena (MemoryArena *arena_p);
+
+
+/**
+ * Run a MemoryArena's cleanup functions and release all of the memory that
+ * it has handed out so that it can be reused. The arena keeps its first
+ * chunk so the next round of allocations does not need to go to the heap.
+ *
+ * @param arena_p The MemoryArena to reset.
+ * @memberof MemoryArena
+ */
+GRASSROOTS_UTIL_API void ResetMemoryArena (MemoryArena *arena_p);
+
+
+/**
+ * Allocate some memory from a MemoryArena. The memory is suitably
+ * aligned for any type and stays valid until the arena is reset or freed.
+ * It must not be passed to FreeMemory ().
+ *
+ * @param arena_p The MemoryArena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return The memory or <code>NULL</code> upon error.
+ * @memberof MemoryArena
+ */
+GRASSROOTS_UTIL_API void *AllocateFromMemoryArena (MemoryArena *arena_p, const size_t size);
+
+
+/**
+ * Register a function to be called when a MemoryArena is reset or freed.
+ * Cleanup functions are called in the reverse order to that in which
+ * they were added.
+ *
+ * @param arena_p The MemoryArena.
+ * @param cleanup_fn The function to call.
+ * @param data_p The value to pass to cleanup_fn.
+ * @return <code>true</code> if the function was registered successfully,
+ * <code>false</code> otherwise in which case the caller is still responsible
+ * for data_p.
+ * @memberof MemoryArena
+ */
+GRASSROOTS_UTIL_API bool AddMemoryArenaCleanup (MemoryArena *arena_p, void (*cleanup_fn) (void *data_p), void *data_p);
+
+
+/**
+ * Get the current statistics for a MemoryArena.
+ *
+ * @param arena_p The MemoryArena.
+ * @param stats_p The MemoryArenaStatistics to fill in.
+ * @memberof MemoryArena
+ */
+GRASSROOTS_UTIL_API void GetMemoryArenaStatistics (const MemoryArena *arena_p, MemoryArenaStatistics *stats_p);
+
+
+/**
+ * Get the MemoryArena that the calling thread is using for the request
+ * that it is currently processing.
+ *
+ * @return The MemoryArena or <code>NULL</code> if the calling thread is
+ * not processing a request.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API MemoryArena *GetCurrentMemoryArena (void);
+
+
+/**
+ * Start using the calling thread's request arena. Each thread keeps its
+ * own arena which is reused from one request to the next. Calls can be
+ * nested and only the outermost call to EndRequestMemoryArena () releases
+ * the arena's contents.
+ *
+ * @return The request MemoryArena or <code>NULL</code> upon error.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API MemoryArena *BeginRequestMemoryArena (void);
+
+
+/**
+ * Finish with the calling thread's request arena. For the outermost call,
+ * this resets the arena, which releases everything that was allocated
+ * from it during the request.
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void EndRequestMemoryArena (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef MEMORY_ARENA_H */
@@ -0,0 +1,299 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * metrics.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * Process-wide request metrics. Each MetricTimer is identified by a family,
+ * such as "operation" or "mongodb", and a label within that family, such as
+ * the name of a Service. It keeps a count of the calls, how many of them
+ * failed and a latency histogram in microseconds.
+ *
+ * The histograms are log-linear in the style of HdrHistogram: every power
+ * of two is split into METRICS_NUM_SUB_BUCKETS equal buckets, so any value
+ * is recorded with a relative error of at most 1 / METRICS_NUM_SUB_BUCKETS
+ * and a percentile can be read back to the same precision.
+ *
+ * Recording only uses atomic increments so it can be called from any thread
+ * without locking. The MetricTimers live in a fixed-size table and are never
+ * freed, so the pointers returned by GetMetricTimer () stay valid for the
+ * lifetime of the process.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "jansson.h"
+
+#include "typedefs.h"
+#include "grassroots_util_library.h"
+
+
+/**
+ * The number of buckets that each power of two is split into.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_NUM_SUB_BUCKETS (16)
+
+
+/**
+ * The base 2 logarithm of METRICS_NUM_SUB_BUCKETS.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_SUB_BUCKET_BITS (4)
+
+
+/**
+ * The largest duration in microseconds, about 19 hours, that
+ * can be recorded. Longer durations are clamped to this.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_MAX_VALUE ((((uint64) 1) << 36) - 1)
+
+
+/**
+ * The total number of buckets needed to cover values
+ * from 0 up to METRICS_MAX_VALUE.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_NUM_BUCKETS ((36 - METRICS_SUB_BUCKET_BITS + 1) * METRICS_NUM_SUB_BUCKETS)
+
+
+/**
+ * The maximum number of distinct family and label pairs. Any
+ * further ones are counted by GetNumberOfDroppedMetrics () instead.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_MAX_NUM_TIMERS (256)
+
+
+/**
+ * The buffer size for a family name. Longer names are truncated.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_FAMILY_SIZE (32)
+
+
+/**
+ * The buffer size for a label. Longer labels are truncated.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_LABEL_SIZE (96)
+
+
+/**
+ * The family for the top-level Operations handled by a Server.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_OPERATION_S "operation"
+
+
+/**
+ * The family for the running of individual Services.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_SERVICE_S "service"
+
+
+/**
+ * The family for calls to other Servers.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_REMOTE_CALL_S "remote_call"
+
+
+/**
+ * The family for MongoDB calls.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_MONGODB_S "mongodb"
+
+
+/**
+ * The family for SQLite calls.
+ *
+ * @ingroup utility_group
+ */
+#define METRICS_SQLITE_S "sqlite"
+
+
+/**
+ * @brief The counts and latency histogram for a given family and label.
+ *
+ * @ingroup utility_group
+ */
+typedef struct MetricTimer
+{
+	/** The family that this MetricTimer belongs to. */
+	char mt_family_s [METRICS_FAMILY_SIZE];
+
+	/** The label for this MetricTimer within its family. */
+	char mt_label_s [METRICS_LABEL_SIZE];
+
+	/** The number of recorded calls. */
+	uint64 mt_count;
+
+	/** The number of recorded calls that failed. */
+	uint64 mt_num_errors;
+
+	/** The sum of all of the recorded durations in microseconds. */
+	uint64 mt_sum;
+
+	/** The longest recorded duration in microseconds. */
+	uint64 mt_max;
+
+	/** The number of recorded durations that fell into each bucket. */
+	uint64 mt_buckets [METRICS_NUM_BUCKETS];
+
+	/** @privatesection */
+	uint32 mt_state;
+} MetricTimer;
+
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * @brief Get the current time from a monotonic clock.
+ *
+ * @return The time in microseconds from an arbitrary starting point.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API uint64 GetMetricsTime (void);
+
+
+/**
+ * @brief Record a call that started at the given time and has just finished.
+ *
+ * @param family_s The family for the call, e.g. METRICS_SERVICE_S.
+ * @param label_s The label for the call within its family, e.g. the Service name.
+ * @param start_time The value of GetMetricsTime () when the call started.
+ * @param success_flag <code>true</code> if the call succeeded, <code>false</code>
+ * if it should be counted as an error.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void RecordMetric (const char *family_s, const char *label_s, const uint64 start_time, const bool success_flag);
+
+
+/**
+ * @brief Record a call that took the given time.
+ *
+ * @param family_s The family for the call.
+ * @param label_s The label for the call within its family.
+ * @param duration The duration of the call in microseconds.
+ * @param success_flag <code>true</code> if the call succeeded, <code>false</code>
+ * if it should be counted as an error.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void RecordMetricDuration (const char *family_s, const char *label_s, const uint64 duration, const bool success_flag);
+
+
+/**
+ * @brief Get the MetricTimer for a given family and label, creating it if needed.
+ *
+ * @param family_s The family.
+ * @param label_s The label.
+ * @return The MetricTimer or <code>NULL</code> if there is no room for any more.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API MetricTimer *GetMetricTimer (const char *family_s, const char *label_s);
+
+
+/**
+ * @brief Get a percentile of the durations recorded by a MetricTimer.
+ *
+ * @param timer_p The MetricTimer.
+ * @param percentile The percentile to get, from 0 to 100, e.g. 99.9.
+ * @return The highest value, in microseconds, that falls into the same bucket
+ * as the requested percentile, capped at the longest recorded duration, or 0
+ * if nothing has been recorded.
+ * @memberof MetricTimer
+ */
+GRASSROOTS_UTIL_API uint64 GetMetricTimerPercentile (const MetricTimer *timer_p, const double percentile);
+
+
+/**
+ * @brief Get the number of calls that couldn't be recorded because
+ * METRICS_MAX_NUM_TIMERS had already been reached.
+ *
+ * @return The number of dropped calls.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API uint64 GetNumberOfDroppedMetrics (void);
+
+
+/**
+ * @brief Get all of the recorded metrics as JSON.
+ *
+ * The result is an object keyed by family, each of which is an object
+ * keyed by label holding the count, number of errors, mean, maximum and
+ * 50th, 90th, 99th and 99.9th percentile durations in microseconds.
+ *
+ * @return The newly-allocated JSON or <code>NULL</code> upon error.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API json_t *GetMetricsAsJSON (void);
+
+
+/**
+ * @brief Get all of the recorded metrics in the Prometheus text exposition format.
+ *
+ * Each family is written as a histogram named grassroots_<family>_duration_seconds
+ * along with a grassroots_<family>_errors_total counter, with the label stored
+ * under "name".
+ *
+ * @return The newly-allocated text which should be freed with FreeMetricsText ()
+ * or <code>NULL</code> upon error.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API char *GetMetricsAsPrometheusText (void);
+
+
+/**
+ * @brief Free the text from GetMetricsAsPrometheusText ().
+ *
+ * @param text_s The text to free.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void FreeMetricsText (char *text_s);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* METRICS_H */
@@ -0,0 +1,124 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * node_pool.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A pool allocator for small fixed-size objects such as LinkedList nodes.
+ * Requests are rounded up to one of a set of size classes and are carved
+ * out of large slabs. Freed blocks go onto a cache that belongs to the
+ * calling thread so most allocations and frees need no locking. When a
+ * thread's cache grows too large, a batch of blocks is moved to a shared
+ * depot in a single operation, and threads refill their caches from it.
+ *
+ * This is used through the AllocListNodeMemory () and FreeListNodeMemory ()
+ * macros in memory_allocations.h when USE_POOLED_LIST_NODES is defined.
+ */
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <stddef.h>
+
+#include "typedefs.h"
+#include "grassroots_util_library.h"
+
+
+/**
+ * The largest object, in bytes, that is allocated from the pool. Larger
+ * requests are passed to AllocMemory ().
+ *
+ * @ingroup utility_group
+ */
+#define NODE_POOL_MAX_SIZE (256)
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Allocate a block of memory from the node pool.
+ *
+ * @param size The size of the block in bytes.
+ * @return The block or <code>NULL</code> upon error. This must be freed
+ * with FreePoolNode () and its contents are not initialised.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void *AllocatePoolNode (const size_t size);
+
+
+/**
+ * Return a block to the node pool.
+ *
+ * @param node_p The block to free. This must have come from AllocatePoolNode ().
+ * If this is <code>NULL</code>, nothing is done.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void FreePoolNode (void *node_p);
+
+
+/**
+ * Start a batch of frees, such as when a whole LinkedList is being freed.
+ * Until the matching call to EndPoolNodeRelease (), freed blocks are just put
+ * back on the calling thread's cache and any surplus is moved to the shared
+ * depot in one go at the end. Batches can be nested.
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void BeginPoolNodeRelease (void);
+
+
+/**
+ * Finish a batch of frees started by BeginPoolNodeRelease ().
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void EndPoolNodeRelease (void);
+
+
+/**
+ * Move all of the blocks cached by the calling thread to the shared depot
+ * so that other threads can use them.
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void FlushPoolNodeCache (void);
+
+
+/**
+ * Free all of the memory used by the node pool. This must only be called
+ * at shutdown once every block has been freed and no other threads are
+ * using the pool.
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void FreeNodePools (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef NODE_POOL_H */
@@ -79,6 +79,18 @@ typedef enum Operation {
 	 */
 	OP_GET_SERVICE_INFO,
 
+	/**
+	 * Get the counts, error rates and latency histograms of the
+	 * Operations, Services and backend calls on a Server.
+	 */
+	OP_GET_SERVER_METRICS,
+
+	/**
+	 * Run every Service that can search for the keyword given in the
+	 * request's "query" value and return their combined results.
+	 */
+	OP_RUN_KEYWORD_SERVICES,
+
 	/** The number of available Operations. */
 	OP_NUM_OPERATIONS
 } Operation;
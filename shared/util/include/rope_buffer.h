@@ -0,0 +1,286 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * rope_buffer.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A RopeBuffer stores its data as a sequence of fragments rather than
+ * in one contiguous block. Small appends are copied into fixed-size
+ * chunks that the RopeBuffer owns, while large blocks of data can be
+ * added without copying them at all. When the RopeBuffer is sent, the
+ * fragments can be passed directly to writev () or read out in pieces
+ * by a curl read callback, so a large message never needs to be held
+ * in a single allocation.
+ */
+
+#ifndef ROPE_BUFFER_H
+#define ROPE_BUFFER_H
+
+#include <stddef.h>
+
+#include "jansson.h"
+
+#include "grassroots_util_library.h"
+#include "memory_allocations.h"
+#include "typedefs.h"
+
+
+/**
+ * The default size, in bytes, of the chunks that a RopeBuffer copies
+ * appended data into.
+ *
+ * @ingroup utility_group
+ */
+#define ROPE_BUFFER_DEFAULT_CHUNK_SIZE (65536)
+
+
+/**
+ * A single piece of the data stored in a RopeBuffer.
+ *
+ * @ingroup utility_group
+ */
+typedef struct RopeFragment
+{
+	/** @privatesection */
+	char *rf_data_p;
+
+	/** The number of bytes of rf_data_p that are in use. */
+	size_t rf_length;
+
+	/**
+	 * The size of rf_data_p if it is a chunk that appended data
+	 * can be copied into, 0 otherwise.
+	 */
+	size_t rf_capacity;
+
+	/** Should rf_data_p be freed when the RopeBuffer is freed or reset? */
+	bool rf_owned_flag;
+} RopeFragment;
+
+
+/**
+ * A buffer made up of a sequence of fragments.
+ *
+ * @ingroup utility_group
+ */
+typedef struct RopeBuffer
+{
+	/** @privatesection */
+	RopeFragment *rb_fragments_p;
+	size_t rb_num_fragments;
+	size_t rb_max_num_fragments;
+
+	size_t rb_chunk_size;
+	size_t rb_size;
+
+	/* The position that ReadFromRopeBuffer () will continue from */
+	size_t rb_read_fragment;
+	size_t rb_read_offset;
+} RopeBuffer;
+
+
+/** @publicsection */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * Allocate a RopeBuffer.
+ *
+ * @param chunk_size The size of the chunks that appended data is copied into.
+ * If this is 0, ROPE_BUFFER_DEFAULT_CHUNK_SIZE will be used.
+ * @return The newly-allocated RopeBuffer or <code>NULL</code> on error.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API RopeBuffer *AllocateRopeBuffer (size_t chunk_size);
+
+
+/**
+ * Free a RopeBuffer along with all of the fragments that it owns.
+ *
+ * @param buffer_p The RopeBuffer to free.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API void FreeRopeBuffer (RopeBuffer *buffer_p);
+
+
+/**
+ * Remove all of the data from a RopeBuffer. The fragments that it owns are freed
+ * apart from the first chunk which is kept for reuse.
+ *
+ * @param buffer_p The RopeBuffer to reset.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API void ResetRopeBuffer (RopeBuffer *buffer_p);
+
+
+/**
+ * Copy some data onto the end of a RopeBuffer.
+ *
+ * @param buffer_p The RopeBuffer to append the data to.
+ * @param data_p The data to append.
+ * @param data_length The length, in bytes, of the data to append.
+ * @return <code>true</code> if the append was successful <code>false</code>
+ * upon failure.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API bool AppendToRopeBuffer (RopeBuffer *buffer_p, const void *data_p, const size_t data_length);
+
+
+/**
+ * Copy a string onto the end of a RopeBuffer.
+ *
+ * @param buffer_p The RopeBuffer to append the string to.
+ * @param value_s The string to append.
+ * @return <code>true</code> if the append was successful <code>false</code>
+ * upon failure.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API bool AppendStringToRopeBuffer (RopeBuffer *buffer_p, const char * const value_s);
+
+
+/**
+ * Add a block of data to the end of a RopeBuffer without copying it.
+ *
+ * @param buffer_p The RopeBuffer to add the data to.
+ * @param data_p The data to add.
+ * @param data_length The length, in bytes, of the data.
+ * @param mem If this is MF_SHADOW_USE, the caller keeps ownership of data_p
+ * and it must stay valid until the RopeBuffer has been reset or freed. If this
+ * is MF_SHALLOW_COPY, the RopeBuffer will take ownership of data_p and free it with
+ * FreeMemory (). If this is MF_DEEP_COPY, the data will be copied as
+ * AppendToRopeBuffer () does.
+ * @return <code>true</code> if the data was added successfully <code>false</code>
+ * upon failure. If this fails and mem is MF_SHALLOW_COPY, the caller still owns data_p.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API bool AddFragmentToRopeBuffer (RopeBuffer *buffer_p, char *data_p, const size_t data_length, const MEM_FLAG mem);
+
+
+/**
+ * Get the total number of bytes stored in a RopeBuffer.
+ *
+ * @param buffer_p The RopeBuffer to get the size of.
+ * @return The size of the data in bytes.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API size_t GetRopeBufferSize (const RopeBuffer * const buffer_p);
+
+
+/**
+ * Get the number of fragments that make up a RopeBuffer.
+ *
+ * @param buffer_p The RopeBuffer to query.
+ * @return The number of fragments.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API size_t GetRopeBufferNumFragments (const RopeBuffer * const buffer_p);
+
+
+/**
+ * Get one of the fragments that make up a RopeBuffer.
+ *
+ * @param buffer_p The RopeBuffer to get the fragment from.
+ * @param index The index of the fragment to get.
+ * @param length_p Where the length of the fragment will be stored.
+ * @return The fragment's data or <code>NULL</code> if the index is
+ * out of range.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API const char *GetRopeBufferFragment (const RopeBuffer * const buffer_p, const size_t index, size_t *length_p);
+
+
+/**
+ * Copy the next part of a RopeBuffer's data into a block of memory. Each call
+ * continues from where the previous one finished which makes this suitable
+ * for use in a curl read callback.
+ *
+ * @param buffer_p The RopeBuffer to read from.
+ * @param dest_p The memory to copy the data to.
+ * @param max_length The maximum number of bytes to copy.
+ * @return The number of bytes copied. This will be 0 once all of the data has
+ * been read.
+ * @see RewindRopeBuffer
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API size_t ReadFromRopeBuffer (RopeBuffer *buffer_p, void *dest_p, const size_t max_length);
+
+
+/**
+ * Set the position that ReadFromRopeBuffer () reads from back to the start
+ * of the RopeBuffer.
+ *
+ * @param buffer_p The RopeBuffer to rewind.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API void RewindRopeBuffer (RopeBuffer *buffer_p);
+
+
+/**
+ * Copy all of a RopeBuffer's data into a single string.
+ *
+ * @param buffer_p The RopeBuffer to copy the data from.
+ * @return The newly-allocated string which should be freed with FreeCopiedString ()
+ * or <code>NULL</code> upon error.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API char *GetRopeBufferAsString (const RopeBuffer * const buffer_p);
+
+
+/**
+ * A callback function for json_dump_callback () that appends the output to
+ * a RopeBuffer.
+ *
+ * @param data_s The output from jansson.
+ * @param size The length of data_s.
+ * @param buffer_p The RopeBuffer to append the output to.
+ * @return 0 upon success, -1 upon error.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API int RopeBufferJSONDumpCallback (const char *data_s, size_t size, void *buffer_p);
+
+
+/**
+ * Serialise a JSON value and append it to a RopeBuffer. The JSON is written
+ * in pieces as it is serialised so the whole document is never held in a
+ * single string.
+ *
+ * @param buffer_p The RopeBuffer to append the JSON to.
+ * @param json_p The JSON value to serialise.
+ * @param flags The jansson encoding flags to use.
+ * @return <code>true</code> if the JSON was appended successfully <code>false</code>
+ * upon failure.
+ * @memberof RopeBuffer
+ */
+GRASSROOTS_UTIL_API bool AppendJSONToRopeBuffer (RopeBuffer *buffer_p, const json_t *json_p, const size_t flags);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif		/* #ifndef ROPE_BUFFER_H */
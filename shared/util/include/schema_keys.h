@@ -251,11 +251,130 @@ SCHEMA_KEYS_PREFIX const char *CONTEXT_URL_STATS_ONTOLOGY_S SCHEMA_KEYS_VAL("htt
 	/* Start of doxygen member group */
 	/**@{*/
 	SCHEMA_KEYS_PREFIX const char *SERVERS_MANAGER_S SCHEMA_KEYS_VAL("servers_manager");
+
+	/**
+	 * The key for the Server's logging configuration. This is an object
+	 * that can contain the other LOGGING_ keys.
+	 */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_S SCHEMA_KEYS_VAL("logging");
+
+	/**
+	 * If this is true, log and error messages are written by a
+	 * background thread rather than by the threads that produce them.
+	 */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_ASYNC_S SCHEMA_KEYS_VAL("async");
+
+	/** The file to write log messages to. */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_LOG_FILE_S SCHEMA_KEYS_VAL("log_file");
+
+	/** The file to write error messages to. */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_ERRORS_FILE_S SCHEMA_KEYS_VAL("errors_file");
+
+	/** The least severe level of message to write, e.g. "info". */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_LEVEL_S SCHEMA_KEYS_VAL("level");
+
+	/** The number of messages that can be waiting to be written. */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_BUFFER_SIZE_S SCHEMA_KEYS_VAL("buffer_size");
+
+	/**
+	 * The format to write messages in. If this is LOGGING_FORMAT_JSON_S, each
+	 * message is written as a single line of compact JSON, otherwise
+	 * messages are written as plain text.
+	 */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_FORMAT_S SCHEMA_KEYS_VAL("format");
+
+	/** The value of LOGGING_FORMAT_S for structured JSON logging. */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_FORMAT_JSON_S SCHEMA_KEYS_VAL("json");
+
+	/**
+	 * For JSON logging, the size in bytes above which JSON payloads
+	 * are sampled rather than always being written.
+	 */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_MAX_PAYLOAD_SIZE_S SCHEMA_KEYS_VAL("max_payload_size");
+
+	/** For JSON logging, write one in this many of the payloads that are sampled. */
+	SCHEMA_KEYS_PREFIX const char *LOGGING_PAYLOAD_SAMPLE_RATE_S SCHEMA_KEYS_VAL("payload_sample_rate");
+
+	/** The key for the request metrics in the response to a get_server_metrics request. */
+	SCHEMA_KEYS_PREFIX const char *METRICS_S SCHEMA_KEYS_VAL("metrics");
+
+	/**
+	 * The format to get the request metrics in. If this is METRICS_FORMAT_PROMETHEUS_S,
+	 * the metrics are returned as Prometheus text under the same key, otherwise
+	 * they are returned as JSON under METRICS_S.
+	 */
+	SCHEMA_KEYS_PREFIX const char *METRICS_FORMAT_S SCHEMA_KEYS_VAL("format");
+
+	/** The value of METRICS_FORMAT_S for the Prometheus text exposition format. */
+	SCHEMA_KEYS_PREFIX const char *METRICS_FORMAT_PROMETHEUS_S SCHEMA_KEYS_VAL("prometheus");
+
+	/** The number of calls that weren't recorded as there were too many distinct metrics. */
+	SCHEMA_KEYS_PREFIX const char *METRICS_DROPPED_S SCHEMA_KEYS_VAL("dropped_metrics");
+
+	/**
+	 * The W3C traceparent value for the trace that a request is part of. A Server
+	 * adds this to the requests that it sends to its paired Servers so that they
+	 * carry on the same trace.
+	 */
+	SCHEMA_KEYS_PREFIX const char *TRACE_PARENT_S SCHEMA_KEYS_VAL("traceparent");
+
+	/** The key for the tracing configuration in the Server's config. */
+	SCHEMA_KEYS_PREFIX const char *TRACING_S SCHEMA_KEYS_VAL("tracing");
+
+	/** The file to write the OpenTelemetry JSON trace spans to. */
+	SCHEMA_KEYS_PREFIX const char *TRACING_FILE_S SCHEMA_KEYS_VAL("file");
+
+	/** The service.name that identifies this Server in the traces. */
+	SCHEMA_KEYS_PREFIX const char *TRACING_SERVICE_NAME_S SCHEMA_KEYS_VAL("service_name");
+
+	/** The key for the keyword search configuration in the Server's config. */
+	SCHEMA_KEYS_PREFIX const char *KEYWORD_SEARCH_S SCHEMA_KEYS_VAL("keyword_search");
+
+	/** The most Services that a keyword search will run at the same time. */
+	SCHEMA_KEYS_PREFIX const char *KEYWORD_SEARCH_MAX_WORKERS_S SCHEMA_KEYS_VAL("max_workers");
+
+	/** The time in milliseconds that a keyword search will wait for its Services to finish. */
+	SCHEMA_KEYS_PREFIX const char *KEYWORD_SEARCH_TIMEOUT_S SCHEMA_KEYS_VAL("timeout");
+
+	/**
+	 * The key for the names of the Services that hadn't finished by the time
+	 * that a keyword search stopped waiting for them. Their results are not
+	 * included in the response.
+	 */
+	SCHEMA_KEYS_PREFIX const char *KEYWORD_SEARCH_INCOMPLETE_SERVICES_S SCHEMA_KEYS_VAL("incomplete_services");
+
+	/** The key for the request coalescing configuration in the Server's config. */
+	SCHEMA_KEYS_PREFIX const char *REQUEST_COALESCING_S SCHEMA_KEYS_VAL("request_coalescing");
+
+	/** The names of the Operations whose identical concurrent requests share a response. */
+	SCHEMA_KEYS_PREFIX const char *REQUEST_COALESCING_OPERATIONS_S SCHEMA_KEYS_VAL("operations");
+
+	/** The time in milliseconds to keep a shared response for after its request has finished. */
+	SCHEMA_KEYS_PREFIX const char *REQUEST_COALESCING_TTL_S SCHEMA_KEYS_VAL("ttl");
+
+	/** The key for the configuration of the Server's RawConnectionServer, which is only started if this is present. */
+	SCHEMA_KEYS_PREFIX const char *RAW_CONNECTION_SERVER_CONFIG_S SCHEMA_KEYS_VAL("raw_connection_server");
+
+	/** The port that the RawConnectionServer listens on. */
+	SCHEMA_KEYS_PREFIX const char *RAW_CONNECTION_SERVER_PORT_S SCHEMA_KEYS_VAL("port");
+
+	/** The number of threads that the RawConnectionServer uses to serve its connections. */
+	SCHEMA_KEYS_PREFIX const char *RAW_CONNECTION_SERVER_NUM_THREADS_S SCHEMA_KEYS_VAL("num_threads");
+
+	/** The number of threads that the RawConnectionServer uses to run requests. */
+	SCHEMA_KEYS_PREFIX const char *RAW_CONNECTION_SERVER_NUM_HANDLER_THREADS_S SCHEMA_KEYS_VAL("num_handler_threads");
 	SCHEMA_KEYS_PREFIX const char *SERVERS_S SCHEMA_KEYS_VAL("servers");
 	SCHEMA_KEYS_PREFIX const char *SERVER_UUID_S SCHEMA_KEYS_VAL("server_uuid");
 	SCHEMA_KEYS_PREFIX const char *SERVER_NAME_S SCHEMA_KEYS_VAL("server_name");
 	SCHEMA_KEYS_PREFIX const char *SERVER_CONNECTION_TYPE_S SCHEMA_KEYS_VAL("server_connection");
 	SCHEMA_KEYS_PREFIX const char *SERVER_URI_S SCHEMA_KEYS_VAL("server_uri");
+
+	/**
+	 * The encodings, in the same form as an Accept-Encoding header, that an
+	 * external server accepts for compressed request bodies before it has
+	 * said so itself.
+	 */
+	SCHEMA_KEYS_PREFIX const char *SERVER_ACCEPT_ENCODING_S SCHEMA_KEYS_VAL("server_accept_encoding");
 	/* End of doxygen member group */
 	/**@}*/
 
@@ -350,6 +469,20 @@ SCHEMA_KEYS_PREFIX const char *CONTEXT_URL_STATS_ONTOLOGY_S SCHEMA_KEYS_VAL("htt
 
 	SCHEMA_KEYS_PREFIX const char *SERVICE_RUN_MODE_S SCHEMA_KEYS_VAL("run_mode");
 
+	/**
+	 * If this is set to true in a Service's configuration, its default
+	 * ParameterSet is built once and cached as a ParameterSetTemplate.
+	 */
+	SCHEMA_KEYS_PREFIX const char *SERVICE_CACHE_PARAMETERS_S SCHEMA_KEYS_VAL("cache_parameters");
+
+	/**
+	 * If this is set to true in a Service's configuration, its description
+	 * for listing the available Services is built once and then cached. This
+	 * should only be used by Services whose Parameters don't depend upon the
+	 * User or DataResource.
+	 */
+	SCHEMA_KEYS_PREFIX const char *SERVICE_CACHE_DESCRIPTION_S SCHEMA_KEYS_VAL("cache_description");
+
 
 	/* End of doxygen member group */
 	/**@}*/
@@ -423,6 +556,12 @@ SCHEMA_KEYS_PREFIX const char *CONTEXT_URL_STATS_ONTOLOGY_S SCHEMA_KEYS_VAL("htt
 	SCHEMA_KEYS_PREFIX const char *JOB_REMOTE_S  SCHEMA_KEYS_VAL("remote_job");
 	SCHEMA_KEYS_PREFIX const char *JOB_TYPE_S  SCHEMA_KEYS_VAL("job_type");
 
+	/**
+	 * The JSON key for the correlation id of the request that started a ServiceJob,
+	 * which is used to tie together the log messages for the job.
+	 */
+	SCHEMA_KEYS_PREFIX const char *JOB_CORRELATION_ID_S  SCHEMA_KEYS_VAL("correlation_id");
+
 	/* End of doxygen member group */
 	/**@}*/
 
@@ -744,6 +883,15 @@ SCHEMA_KEYS_PREFIX const char *CONTEXT_URL_STATS_ONTOLOGY_S SCHEMA_KEYS_VAL("htt
 	SCHEMA_KEYS_PREFIX const char *DRMAA_ARGS_S SCHEMA_KEYS_VAL("args");
 	SCHEMA_KEYS_PREFIX const char *DRMAA_NUM_CORES_S SCHEMA_KEYS_VAL("num_cores");
 	SCHEMA_KEYS_PREFIX const char *DRMAA_MEM_USAGE_S SCHEMA_KEYS_VAL("mem");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_FINAL_STATUS_S SCHEMA_KEYS_VAL("final_status");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_S SCHEMA_KEYS_VAL("array");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_START_S SCHEMA_KEYS_VAL("start");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_END_S SCHEMA_KEYS_VAL("end");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_STEP_S SCHEMA_KEYS_VAL("step");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_TASK_ID_PREFIX_S SCHEMA_KEYS_VAL("task_id_prefix");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_TASK_ID_SUFFIX_S SCHEMA_KEYS_VAL("task_id_suffix");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_TASK_IDS_S SCHEMA_KEYS_VAL("task_ids");
+	SCHEMA_KEYS_PREFIX const char *DRMAA_ARRAY_TASK_FINAL_STATUSES_S SCHEMA_KEYS_VAL("task_final_statuses");
 	/* End of doxygen member group */
 	/**@}*/
 
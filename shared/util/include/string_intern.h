@@ -0,0 +1,151 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * string_intern.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * A global, thread-safe pool of interned strings. Interning a string
+ * returns a canonical, immutable copy of it so that every caller that
+ * interns the same value gets the same pointer. Interned strings can
+ * then be compared with == rather than strcmp () and any number of
+ * owners can share a single allocation. Each interned string is
+ * reference-counted and is freed when its last owner releases it.
+ */
+
+#ifndef STRING_INTERN_H
+#define STRING_INTERN_H
+
+#include "typedefs.h"
+#include "grassroots_util_library.h"
+
+
+/**
+ * Counters for the activity of the string interning pool.
+ *
+ * @ingroup utility_group
+ */
+typedef struct StringInternPoolStatistics
+{
+	/** The number of distinct strings currently in the pool. */
+	uint32 sips_num_strings;
+
+	/** The number of calls to InternString () and RetainInternedString (). */
+	uint64 sips_num_interns;
+
+	/** The number of times that an interned string was reused rather than allocated. */
+	uint64 sips_num_hits;
+
+	/** The number of strings that have been allocated by the pool. */
+	uint64 sips_num_allocations;
+} StringInternPoolStatistics;
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * Get the canonical interned copy of a string, adding it to the pool if
+ * it is not already there. Each successful call must be matched by a call
+ * to ReleaseInternedString ().
+ *
+ * @param value_s The string to intern.
+ * @return The interned string or <code>NULL</code> upon error. This
+ * must not be altered or freed with FreeCopiedString ().
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API const char *InternString (const char *value_s);
+
+
+/**
+ * Take another reference to a string that has already been interned. This
+ * is cheaper than calling InternString () again as no lookup is needed.
+ *
+ * @param interned_s The interned string.
+ * @return interned_s.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API const char *RetainInternedString (const char *interned_s);
+
+
+/**
+ * Release a reference to an interned string. When the last reference is
+ * released, the string is removed from the pool and freed.
+ *
+ * @param interned_s The interned string. If this is <code>NULL</code>, this
+ * does nothing.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void ReleaseInternedString (const char *interned_s);
+
+
+/**
+ * Find the interned copy of a string without adding it to the pool or
+ * taking a reference to it. This allows a string that has come from a
+ * request to be matched against interned strings with pointer comparisons.
+ * Unless the caller already holds a reference to the returned string, it
+ * should only be compared against other interned strings and not read.
+ *
+ * @param value_s The string to search for.
+ * @return The interned string or <code>NULL</code> if the string is not in the
+ * pool, in which case it can't be equal to any interned string.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API const char *FindInternedString (const char *value_s);
+
+
+/**
+ * Check whether a string came from the interning pool.
+ *
+ * @param value_s The string to check.
+ * @return <code>true</code> if the string is interned, <code>false</code> otherwise.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API bool IsInternedString (const char *value_s);
+
+
+/**
+ * Get the current statistics for the string interning pool.
+ *
+ * @param stats_p The StringInternPoolStatistics to fill in.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void GetStringInternPoolStatistics (StringInternPoolStatistics *stats_p);
+
+
+/**
+ * Free all of the strings in the interning pool regardless of how many
+ * references they have. This should only be called at shutdown once nothing
+ * will use any interned strings again.
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void FreeStringInternPool (void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* #ifndef STRING_INTERN_H */
@@ -31,6 +31,7 @@
 #include "typedefs.h"
 #include "grassroots_util_library.h"
 #include "linked_list.h"
+#include "memory_arena.h"
 
 
 #ifdef __cplusplus
@@ -379,6 +380,33 @@ GRASSROOTS_UTIL_API char *GetFileContentsAsStringByFilename (const char *filenam
 GRASSROOTS_UTIL_API char *ConcatenateVarargsStrings (const char *value_s, ...);
 
 
+/**
+ * Copy a string into a MemoryArena.
+ *
+ * @param arena_p The MemoryArena to allocate the copy from.
+ * @param src_s The string to copy.
+ * @return The copied string or <code>NULL</code> upon failure. This
+ * is released along with the rest of the MemoryArena and must not be freed
+ * with FreeCopiedString().
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API char *CopyToArenaString (MemoryArena *arena_p, const char * const src_s);
+
+
+/**
+ * Concatenate a va_list of strings into a MemoryArena.
+ *
+ * @param arena_p The MemoryArena to allocate the new string from.
+ * @param value_s The varargs-style array of <code>NULL</code> terminated strings to append. The final entry
+ * in this varargs-array must be a <code>NULL</code>.
+ * @return The new string or <code>NULL</code> upon failure. This is released
+ * along with the rest of the MemoryArena and must not be freed with FreeCopiedString().
+ * @see ConcatenateVarargsStrings
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API char *ConcatenateVarargsStringsInArena (MemoryArena *arena_p, const char *value_s, ...);
+
+
 
 
 
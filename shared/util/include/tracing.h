@@ -0,0 +1,287 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * tracing.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * Distributed tracing of requests. A Span records a named piece of work,
+ * such as handling a request or calling another Server, along with when it
+ * started and finished. Each thread has a current trace context and a new
+ * Span becomes a child of it, so the Spans for a request form a tree with
+ * a single trace id.
+ *
+ * The trace context is passed to other Servers as a W3C traceparent value,
+ * e.g. "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", and a
+ * Server that receives one carries on the same trace. Finished Spans are
+ * written to a file, one line per Span, in the OpenTelemetry OTLP/JSON
+ * format so they can be loaded by any OpenTelemetry collector or viewer.
+ * The file is flushed at most once a second rather than after every Span.
+ *
+ * Until InitTracing () has been called, StartSpan () returns NULL and the
+ * other calls do nothing, so the instrumentation costs almost nothing when
+ * tracing is turned off.
+ */
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include "jansson.h"
+
+#include "typedefs.h"
+#include "grassroots_util_library.h"
+
+
+/**
+ * The number of bytes in a trace id.
+ *
+ * @ingroup utility_group
+ */
+#define TRACE_ID_SIZE (16)
+
+
+/**
+ * The number of bytes in a span id.
+ *
+ * @ingroup utility_group
+ */
+#define SPAN_ID_SIZE (8)
+
+
+/**
+ * The buffer size needed for a traceparent value including its terminating
+ * <code>'\0'</code>.
+ *
+ * @ingroup utility_group
+ */
+#define TRACE_PARENT_BUFFER_SIZE (56)
+
+
+/**
+ * The name of the HTTP header that a traceparent value is sent in.
+ *
+ * @ingroup utility_group
+ */
+#define TRACE_PARENT_HEADER_S "traceparent"
+
+
+/**
+ * The buffer size for a Span's name. Longer names are truncated.
+ *
+ * @ingroup utility_group
+ */
+#define SPAN_NAME_SIZE (128)
+
+
+/**
+ * @brief The kinds of Span, using the same values as OpenTelemetry.
+ *
+ * @ingroup utility_group
+ */
+typedef enum SpanKind
+{
+	/** Work done within a Server, e.g. running a Service. */
+	SK_INTERNAL = 1,
+
+	/** The handling of a request that a Server has received. */
+	SK_SERVER = 2,
+
+	/** A call made to another Server or a database. */
+	SK_CLIENT = 3
+} SpanKind;
+
+
+/**
+ * @brief The ids that identify a Span within a trace.
+ *
+ * @ingroup utility_group
+ */
+typedef struct TraceContext
+{
+	/** The id shared by every Span in the trace. */
+	uint8 tc_trace_id [TRACE_ID_SIZE];
+
+	/** The id of the Span. */
+	uint8 tc_span_id [SPAN_ID_SIZE];
+
+	/** Is this TraceContext set? */
+	bool tc_valid_flag;
+} TraceContext;
+
+
+/**
+ * @brief A piece of work within a trace.
+ *
+ * @ingroup utility_group
+ */
+typedef struct Span
+{
+	/** The name of the Span. */
+	char sp_name_s [SPAN_NAME_SIZE];
+
+	/** The kind of Span. */
+	SpanKind sp_kind;
+
+	/** The ids of this Span. */
+	TraceContext sp_context;
+
+	/**
+	 * The trace context that was current when this Span was started.
+	 * If this is valid, its span id is this Span's parent and it becomes
+	 * current again when this Span ends.
+	 */
+	TraceContext sp_parent_context;
+
+	/** The time the Span started, in nanoseconds since the Unix epoch. */
+	uint64 sp_start_time;
+
+	/** The OTLP attributes for the Span. */
+	json_t *sp_attributes_p;
+} Span;
+
+
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+
+/**
+ * @brief Start writing Spans to a file.
+ *
+ * @param filename_s The file to append the Spans to.
+ * @param service_name_s The service.name resource attribute that identifies
+ * this Server in the traces.
+ * @return <code>true</code> if tracing was started successfully, <code>false</code> otherwise.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API bool InitTracing (const char *filename_s, const char *service_name_s);
+
+
+/**
+ * @brief Stop tracing and close the file that the Spans are written to.
+ *
+ * Any Spans that are still running when this is called are not written.
+ * This is safe to call whilst other threads are still ending Spans.
+ *
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void ExitTracing (void);
+
+
+/**
+ * @brief Is tracing turned on?
+ *
+ * @return <code>true</code> if InitTracing () has been called successfully.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API bool IsTracingEnabled (void);
+
+
+/**
+ * @brief Start a Span as a child of the calling thread's current trace
+ * context, or as the root of a new trace if there isn't one, and make it
+ * the current trace context.
+ *
+ * @param name_s The name of the Span.
+ * @param kind The kind of Span.
+ * @return The new Span or <code>NULL</code> if tracing is off or upon error.
+ * @memberof Span
+ */
+GRASSROOTS_UTIL_API Span *StartSpan (const char *name_s, const SpanKind kind);
+
+
+/**
+ * @brief Add a string attribute to a Span.
+ *
+ * @param span_p The Span to add the attribute to. This can be <code>NULL</code>
+ * in which case nothing is done.
+ * @param key_s The attribute key, e.g. "server.address".
+ * @param value_s The attribute value.
+ * @return <code>true</code> if the attribute was added successfully or span_p
+ * is <code>NULL</code>, <code>false</code> otherwise.
+ * @memberof Span
+ */
+GRASSROOTS_UTIL_API bool AddSpanAttribute (Span *span_p, const char *key_s, const char *value_s);
+
+
+/**
+ * @brief End a Span, write it out and make its parent the calling thread's
+ * current trace context again.
+ *
+ * Spans must be ended on the thread that started them and in the reverse
+ * order to which they were started.
+ *
+ * @param span_p The Span to end. This can be <code>NULL</code> in which case
+ * nothing is done.
+ * @param success_flag <code>false</code> if the Span's status should be set to error.
+ * @memberof Span
+ */
+GRASSROOTS_UTIL_API void EndSpan (Span *span_p, const bool success_flag);
+
+
+/**
+ * @brief Write a Span, as a child of the calling thread's current trace
+ * context, for some work that has already finished.
+ *
+ * This is for short calls, such as database operations, that are already
+ * being timed with GetMetricsTime ().
+ *
+ * @param name_s The name of the Span.
+ * @param kind The kind of Span.
+ * @param start_time The value of GetMetricsTime () when the work started.
+ * @param success_flag <code>false</code> if the Span's status should be set to error.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API void RecordCompletedSpan (const char *name_s, const SpanKind kind, const uint64 start_time, const bool success_flag);
+
+
+/**
+ * @brief Get the calling thread's current trace context as a traceparent value.
+ *
+ * @param buffer_s The buffer, at least TRACE_PARENT_BUFFER_SIZE bytes in size,
+ * to write the value to.
+ * @return <code>true</code> if there is a current trace context and it was
+ * written to buffer_s, <code>false</code> otherwise.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API bool GetTraceParent (char *buffer_s);
+
+
+/**
+ * @brief Set the calling thread's current trace context from a traceparent value
+ * so that its subsequent Spans continue the given trace.
+ *
+ * @param traceparent_s The traceparent value or <code>NULL</code> to clear the
+ * current trace context.
+ * @return <code>true</code> if the value was valid or <code>NULL</code>,
+ * <code>false</code> otherwise in which case the current trace context is cleared.
+ * @ingroup utility_group
+ */
+GRASSROOTS_UTIL_API bool SetTraceParent (const char *traceparent_s);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* TRACING_H */
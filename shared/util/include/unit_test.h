@@ -0,0 +1,77 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/**
+ * @file
+ * @brief
+ */
+/*
+ * unit_test.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ * The checks shared by the standalone *_test programs. Each test program
+ * is a single source file so this is included by exactly one translation
+ * unit and everything in it is static.
+ */
+
+#ifndef UNIT_TEST_H
+#define UNIT_TEST_H
+
+#include <stdio.h>
+
+#include "typedefs.h"
+
+
+/*
+ * The number of checks that have failed so far.
+ */
+static int s_num_failures = 0;
+
+
+/**
+ * Print the result of a check and count it if it failed.
+ *
+ * @param condition_flag <code>true</code> if the check passed.
+ * @param description_s What was checked.
+ */
+static void Check (const bool condition_flag, const char *description_s)
+{
+	printf ("%s: %s\n", condition_flag ? "ok" : "FAILED", description_s);
+
+	if (!condition_flag)
+		{
+			++ s_num_failures;
+		}
+}
+
+
+/**
+ * Print the overall result of the checks.
+ *
+ * @return The exit code for the test program: 0 if every check passed,
+ * 1 otherwise.
+ */
+static int GetTestResult (void)
+{
+	puts (s_num_failures == 0 ? "PASSED" : "FAILED");
+
+	return (s_num_failures == 0) ? 0 : 1;
+}
+
+
+#endif	/* UNIT_TEST_H */
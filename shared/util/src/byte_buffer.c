@@ -21,6 +21,13 @@
 #include "string_utils.h"
 
 
+/** The smallest capacity that a ByteBuffer will grow to */
+#define S_MIN_CAPACITY (64)
+
+
+static bool GrowByteBuffer (ByteBuffer *buffer_p, size_t min_size);
+
+
 ByteBuffer *AllocateByteBuffer (size_t initial_size)
 {
 	char *data_p = (char *) AllocMemoryArray (initial_size, sizeof (char));
@@ -58,35 +65,76 @@ void FreeByteBuffer (ByteBuffer *buffer_p)
 
 bool ExtendByteBuffer (ByteBuffer *buffer_p, size_t increment)
 {
-	return ResizeByteBuffer (buffer_p, (buffer_p -> bb_size) + increment);
+	return GrowByteBuffer (buffer_p, (buffer_p -> bb_size) + increment);
 }
 
 
 bool ResizeByteBuffer (ByteBuffer *buffer_p, size_t new_size)
 {
 	bool success_flag = false;
-		
-	char *new_data_p = (char *) AllocMemoryArray (new_size, sizeof (char));
-	
-	if (new_data_p)
+
+	if (new_size > 0)
 		{
-			if (new_size > buffer_p -> bb_current_index)
+			char *new_data_p = (char *) ReallocMemory (buffer_p -> bb_data_p, new_size, buffer_p -> bb_size);
+
+			if (new_data_p)
 				{
-					memcpy (new_data_p, buffer_p -> bb_data_p, buffer_p -> bb_current_index);
+					/* Keep the unused space zeroed as AllocateByteBuffer () does */
+					if (new_size > buffer_p -> bb_size)
+						{
+							memset (new_data_p + (buffer_p -> bb_size), 0, new_size - (buffer_p -> bb_size));
+						}
+					else if (new_size <= buffer_p -> bb_current_index)
+						{
+							/* The data has been truncated so leave room for the terminator */
+							buffer_p -> bb_current_index = new_size - 1;
+							* (new_data_p + (buffer_p -> bb_current_index)) = '\0';
+						}
+
+					buffer_p -> bb_data_p = new_data_p;
+					buffer_p -> bb_size = new_size;
+
+					success_flag = true;
 				}
-				
-			FreeMemory (buffer_p -> bb_data_p);			
+		}
 
-			buffer_p -> bb_data_p = new_data_p;
-			buffer_p -> bb_size = new_size;
-			
-			success_flag = true;
+	return success_flag;
+}
+
+
+bool ReserveByteBuffer (ByteBuffer *buffer_p, size_t capacity)
+{
+	bool success_flag = true;
+
+	if (capacity > buffer_p -> bb_size)
+		{
+			success_flag = ResizeByteBuffer (buffer_p, capacity);
 		}
-	
+
 	return success_flag;
 }
 
 
+bool ShrinkByteBufferToFit (ByteBuffer *buffer_p)
+{
+	bool success_flag = true;
+	const size_t required_size = (buffer_p -> bb_current_index) + 1;
+
+	if (buffer_p -> bb_size > required_size)
+		{
+			success_flag = ResizeByteBuffer (buffer_p, required_size);
+		}
+
+	return success_flag;
+}
+
+
+size_t GetByteBufferCapacity (const ByteBuffer * const buffer_p)
+{
+	return buffer_p -> bb_size;
+}
+
+
 void RemoveFromByteBuffer (ByteBuffer *buffer_p, size_t size)
 {
 	if (buffer_p -> bb_current_index > size)
@@ -114,7 +162,7 @@ bool AppendToByteBuffer (ByteBuffer *buffer_p, const void *data_p, const size_t
 	
 	if (space_remaining <= data_length)
 		{
-			success_flag = ResizeByteBuffer (buffer_p, (buffer_p -> bb_size) + data_length - space_remaining + 1);
+			success_flag = GrowByteBuffer (buffer_p, (buffer_p -> bb_current_index) + data_length + 1);
 		}
 		
 	if (success_flag)
@@ -123,6 +171,9 @@ bool AppendToByteBuffer (ByteBuffer *buffer_p, const void *data_p, const size_t
 			
 			memcpy (current_data_p, data_p, data_length);			
 			buffer_p -> bb_current_index += data_length;
+
+			/* There is always room for this as we made sure there was more space than data_length */
+			* (current_data_p + data_length) = '\0';
 		}
 		
 	return success_flag;
@@ -206,9 +257,62 @@ char *DetachByteBufferData (ByteBuffer * const buffer_p)
 }
 
 
+char *TakeByteBufferData (ByteBuffer *buffer_p, size_t *length_p)
+{
+	char *new_data_p = (char *) AllocMemoryArray (S_MIN_CAPACITY, sizeof (char));
+
+	if (new_data_p)
+		{
+			char *value_s = buffer_p -> bb_data_p;
+
+			if (length_p)
+				{
+					*length_p = buffer_p -> bb_current_index;
+				}
+
+			buffer_p -> bb_data_p = new_data_p;
+			buffer_p -> bb_size = S_MIN_CAPACITY;
+			buffer_p -> bb_current_index = 0;
+
+			return value_s;
+		}
+
+	return NULL;
+}
+
+
 void ReplaceCharsInByteBuffer (ByteBuffer *buffer_p, char old_data, char new_data)
 {
 	ReplaceChars (buffer_p -> bb_data_p, old_data, new_data);
 }
 
 
+/*
+ * Make sure that the buffer can hold at least min_size bytes. The capacity
+ * is at least doubled each time so that a sequence of appends takes
+ * amortised linear time rather than copying all of the data on each one.
+ */
+static bool GrowByteBuffer (ByteBuffer *buffer_p, size_t min_size)
+{
+	bool success_flag = true;
+
+	if (min_size > buffer_p -> bb_size)
+		{
+			size_t new_size = (buffer_p -> bb_size) << 1;
+
+			if (new_size < S_MIN_CAPACITY)
+				{
+					new_size = S_MIN_CAPACITY;
+				}
+
+			/* Check for overflow as well as the doubled size not being enough */
+			if ((new_size < min_size) || (new_size < buffer_p -> bb_size))
+				{
+					new_size = min_size;
+				}
+
+			success_flag = ResizeByteBuffer (buffer_p, new_size);
+		}
+
+	return success_flag;
+}
@@ -0,0 +1,146 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * byte_buffer_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for ByteBuffer along with a microbenchmark that appends
+ *  many small chunks to check that growth takes linear time.
+ *
+ *  Usage: byte_buffer_test [<number of appends>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "byte_buffer.h"
+#include "memory_allocations.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_APPENDS (10000000)
+
+
+static double GetElapsedSeconds (const struct timespec *start_p)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start_p -> tv_sec) + ((now.tv_nsec - start_p -> tv_nsec) / 1e9);
+}
+
+
+static void TestCapacity (void)
+{
+	ByteBuffer *buffer_p = AllocateByteBuffer (4);
+
+	if (buffer_p)
+		{
+			char *data_s;
+			size_t l = 0;
+
+			Check (AppendStringsToByteBuffer (buffer_p, "hello", " ", "world", NULL), "append strings");
+			Check (strcmp (GetByteBufferData (buffer_p), "hello world") == 0, "appended data is correct");
+			Check (GetByteBufferCapacity (buffer_p) > GetByteBufferSize (buffer_p), "there is room for the terminator");
+
+			RemoveFromByteBuffer (buffer_p, 6);
+			Check (AppendStringToByteBuffer (buffer_p, "!"), "append after remove");
+			Check (strcmp (GetByteBufferData (buffer_p), "hello!") == 0, "data after remove is terminated");
+
+			Check (ReserveByteBuffer (buffer_p, 4096), "reserve");
+			Check (GetByteBufferCapacity (buffer_p) == 4096, "reserve sets the capacity");
+			Check (strcmp (GetByteBufferData (buffer_p), "hello!") == 0, "reserve keeps the data");
+
+			Check (ShrinkByteBufferToFit (buffer_p), "shrink to fit");
+			Check (GetByteBufferCapacity (buffer_p) == 7, "shrink leaves room for the terminator only");
+			Check (strcmp (GetByteBufferData (buffer_p), "hello!") == 0, "shrink keeps the data");
+
+			Check (ResizeByteBuffer (buffer_p, 4), "resize smaller than the data");
+			Check (strcmp (GetByteBufferData (buffer_p), "hel") == 0, "resize truncates the data");
+
+			data_s = TakeByteBufferData (buffer_p, &l);
+			Check ((data_s != NULL) && (strcmp (data_s, "hel") == 0) && (l == 3), "take the data");
+			Check (GetByteBufferSize (buffer_p) == 0, "buffer is empty after taking the data");
+
+			if (data_s)
+				{
+					FreeMemory (data_s);
+				}
+
+			Check (AppendStringToByteBuffer (buffer_p, "again"), "append after taking the data");
+			Check (strcmp (GetByteBufferData (buffer_p), "again") == 0, "buffer is reusable after taking the data");
+
+			FreeByteBuffer (buffer_p);
+		}
+	else
+		{
+			Check (false, "allocate buffer");
+		}
+}
+
+
+static void RunBenchmark (const size_t num_appends)
+{
+	ByteBuffer *buffer_p = AllocateByteBuffer (1);
+
+	if (buffer_p)
+		{
+			const char chunk_s [] = "abcdefgh";
+			const size_t chunk_length = sizeof (chunk_s) - 1;
+			struct timespec start;
+			size_t num_resizes = 0;
+			size_t capacity = GetByteBufferCapacity (buffer_p);
+			bool success_flag = true;
+			size_t i;
+
+			clock_gettime (CLOCK_MONOTONIC, &start);
+
+			for (i = 0; (i < num_appends) && success_flag; ++ i)
+				{
+					success_flag = AppendToByteBuffer (buffer_p, chunk_s, chunk_length);
+
+					if (GetByteBufferCapacity (buffer_p) != capacity)
+						{
+							capacity = GetByteBufferCapacity (buffer_p);
+							++ num_resizes;
+						}
+				}
+
+			printf ("appended %zu chunks of %zu bytes in %.3f s with %zu resizes\n", num_appends, chunk_length, GetElapsedSeconds (&start), num_resizes);
+
+			Check (success_flag, "all appends succeed");
+			Check (GetByteBufferSize (buffer_p) == num_appends * chunk_length, "buffer has all of the data");
+			Check (num_resizes < 64, "growth is geometric");
+
+			FreeByteBuffer (buffer_p);
+		}
+}
+
+
+int main (int argc, char *argv [])
+{
+	const size_t num_appends = (argc > 1) ? (size_t) atol (argv [1]) : DEFAULT_NUM_APPENDS;
+
+	TestCapacity ();
+	RunBenchmark (num_appends);
+
+	return GetTestResult ();
+}
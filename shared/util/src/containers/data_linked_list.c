@@ -16,7 +16,7 @@ DataListNode *AllocateDataListNode (const char *data_p, const size_t data_size)
 
 	if (copied_data_p)
 		{
-			DataListNode *node_p = (DataListNode *) AllocMemory (sizeof (DataListNode));
+			DataListNode *node_p = (DataListNode *) AllocListNodeMemory (sizeof (DataListNode));
 
 			if (node_p)
 				{
@@ -47,7 +47,7 @@ void FreeDataListNode (ListItem * const node_p)
 			FreeMemory (data_node_p -> dln_data_p);
 		}
 
-	FreeMemory (data_node_p);
+	FreeListNodeMemory (data_node_p);
 }
 
 
@@ -11,7 +11,7 @@
 
 DoubleListNode *AllocateDoubleListNode (const double64 value)
 {
-	DoubleListNode *node_p = (DoubleListNode *) AllocMemory (sizeof (DoubleListNode));
+	DoubleListNode *node_p = (DoubleListNode *) AllocListNodeMemory (sizeof (DoubleListNode));
 
 	if (node_p)
 		{
@@ -28,7 +28,7 @@ void FreeDoubleListNode (ListItem * const node_p)
 {
 	DoubleListNode *double_node_p = (DoubleListNode *) node_p;
 
-	FreeMemory (double_node_p);
+	FreeListNodeMemory (double_node_p);
 }
 
 
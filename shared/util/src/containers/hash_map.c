@@ -0,0 +1,713 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * hash_map.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hash_map.h"
+#include "string_utils.h"
+#include "streams.h"
+#include "uuid_defs.h"
+
+
+/** The smallest number of slots that a HashMap will have */
+#define S_MIN_CAPACITY (8)
+
+#define S_MIN_LOAD_PERCENTAGE (10)
+
+#define S_MAX_LOAD_PERCENTAGE (95)
+
+
+static bool ResizeHashMap (HashMap *map_p, const uint32 new_capacity);
+
+static uint32 GetCapacityForNumEntries (const uint32 num_entries, const uint8 load_percentage);
+
+static void InsertEntry (HashMapEntry *entries_p, const uint32 mask, uint32 index, HashMapEntry entry);
+
+static HashMapEntry *FindEntry (const HashMap *map_p, const void *key_p, const uint32 hash);
+
+static bool GetKeyToStore (const HashMap *map_p, const void *key_p, const void **stored_key_pp);
+
+static bool GetValueToStore (const HashMap *map_p, const void *value_p, void **stored_value_pp);
+
+static void FreeEntry (const HashMap *map_p, HashMapEntry *entry_p);
+
+
+/*
+ * Scramble the bits of a hash so that the low bits, which are used to
+ * choose the home slot, depend on all of the bits of the input.
+ */
+static inline uint32 MixHash (uint32 h)
+{
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+
+	return h;
+}
+
+
+static inline uint32 HashPointer (const void *key_p)
+{
+	uint64 x = (uint64) (uintptr_t) key_p;
+
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33;
+
+	return (uint32) x;
+}
+
+
+static inline uint32 HashBytes (const void *key_p, size_t length)
+{
+	const unsigned char *c_p = (const unsigned char *) key_p;
+	uint32 h = 2166136261U;
+
+	while (length > 0)
+		{
+			h ^= *c_p;
+			h *= 16777619U;
+
+			++ c_p;
+			-- length;
+		}
+
+	return h;
+}
+
+
+/*
+ * Get the hash for a key. 0 is used to mark empty slots so it is never
+ * returned.
+ */
+static inline uint32 HashKey (const HashMap *map_p, const void *key_p)
+{
+	uint32 h;
+
+	switch (map_p -> hm_key_type)
+		{
+			case HMKT_STRING:
+				h = HashMapStringHash (key_p);
+				break;
+
+			case HMKT_POINTER:
+				h = HashPointer (key_p);
+				break;
+
+			case HMKT_UUID:
+				h = HashBytes (key_p, UUID_RAW_SIZE);
+				break;
+
+			case HMKT_CUSTOM:
+			default:
+				h = map_p -> hm_hash_key_fn (key_p);
+				break;
+		}
+
+	h = MixHash (h);
+
+	return (h != 0) ? h : 1;
+}
+
+
+static inline bool AreKeysEqual (const HashMap *map_p, const void *key0_p, const void *key1_p)
+{
+	switch (map_p -> hm_key_type)
+		{
+			case HMKT_STRING:
+				return (strcmp ((const char *) key0_p, (const char *) key1_p) == 0);
+
+			case HMKT_POINTER:
+				return (key0_p == key1_p);
+
+			case HMKT_UUID:
+				return (memcmp (key0_p, key1_p, UUID_RAW_SIZE) == 0);
+
+			case HMKT_CUSTOM:
+			default:
+				return map_p -> hm_compare_keys_fn (key0_p, key1_p);
+		}
+}
+
+
+uint32 HashMapStringHash (const void *key_p)
+{
+	const unsigned char *c_p = (const unsigned char *) key_p;
+	uint32 h = 2166136261U;
+
+	while (*c_p)
+		{
+			h ^= *c_p;
+			h *= 16777619U;
+
+			++ c_p;
+		}
+
+	return h;
+}
+
+
+HashMap *AllocateHashMap (const uint32 initial_capacity, const uint8 load_percentage, const HashMapKeyType key_type, const MEM_FLAG key_mem, const MEM_FLAG value_mem)
+{
+	HashMap *map_p = (HashMap *) AllocMemory (sizeof (HashMap));
+
+	if (map_p)
+		{
+			uint8 load = load_percentage;
+			uint32 capacity;
+
+			if (load < S_MIN_LOAD_PERCENTAGE)
+				{
+					load = S_MIN_LOAD_PERCENTAGE;
+				}
+			else if (load > S_MAX_LOAD_PERCENTAGE)
+				{
+					load = S_MAX_LOAD_PERCENTAGE;
+				}
+
+			capacity = GetCapacityForNumEntries (initial_capacity, load);
+
+			map_p -> hm_entries_p = (HashMapEntry *) AllocMemoryArray (capacity, sizeof (HashMapEntry));
+
+			if (map_p -> hm_entries_p)
+				{
+					map_p -> hm_capacity = capacity;
+					map_p -> hm_size = 0;
+					map_p -> hm_load_percentage = load;
+					map_p -> hm_load_limit = (uint32) (((uint64) capacity * load) / 100);
+					map_p -> hm_key_type = key_type;
+					map_p -> hm_key_mem = key_mem;
+					map_p -> hm_value_mem = value_mem;
+					map_p -> hm_hash_key_fn = NULL;
+					map_p -> hm_compare_keys_fn = NULL;
+					map_p -> hm_copy_key_fn = NULL;
+					map_p -> hm_free_key_fn = NULL;
+					map_p -> hm_copy_value_fn = NULL;
+					map_p -> hm_free_value_fn = NULL;
+
+					return map_p;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate " UINT32_FMT " entries for HashMap", capacity);
+				}
+
+			FreeMemory (map_p);
+		}
+
+	return NULL;
+}
+
+
+void FreeHashMap (HashMap *map_p)
+{
+	ClearHashMap (map_p);
+
+	FreeMemory (map_p -> hm_entries_p);
+	FreeMemory (map_p);
+}
+
+
+void ClearHashMap (HashMap *map_p)
+{
+	HashMapEntry *entry_p = map_p -> hm_entries_p;
+	uint32 i;
+
+	for (i = map_p -> hm_capacity; i > 0; -- i, ++ entry_p)
+		{
+			if (entry_p -> hme_hash != 0)
+				{
+					FreeEntry (map_p, entry_p);
+				}
+		}
+
+	memset (map_p -> hm_entries_p, 0, (map_p -> hm_capacity) * sizeof (HashMapEntry));
+	map_p -> hm_size = 0;
+}
+
+
+bool SetHashMapKeyFunctions (HashMap *map_p, uint32 (*hash_key_fn) (const void *key_p), bool (*compare_keys_fn) (const void *key0_p, const void *key1_p), void *(*copy_key_fn) (const void *key_p), void (*free_key_fn) (void *key_p))
+{
+	bool success_flag = false;
+
+	if ((map_p -> hm_key_type == HMKT_CUSTOM) && (map_p -> hm_size == 0))
+		{
+			if (hash_key_fn && compare_keys_fn)
+				{
+					map_p -> hm_hash_key_fn = hash_key_fn;
+					map_p -> hm_compare_keys_fn = compare_keys_fn;
+					map_p -> hm_copy_key_fn = copy_key_fn;
+					map_p -> hm_free_key_fn = free_key_fn;
+
+					success_flag = true;
+				}
+		}
+
+	if (!success_flag)
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Cannot set the key functions for this HashMap");
+		}
+
+	return success_flag;
+}
+
+
+void SetHashMapValueFunctions (HashMap *map_p, void *(*copy_value_fn) (const void *value_p), void (*free_value_fn) (void *value_p))
+{
+	map_p -> hm_copy_value_fn = copy_value_fn;
+	map_p -> hm_free_value_fn = free_value_fn;
+}
+
+
+bool PutInHashMap (HashMap *map_p, const void *key_p, const void *value_p)
+{
+	bool success_flag = false;
+	void *stored_value_p = NULL;
+
+	if ((map_p -> hm_key_type == HMKT_CUSTOM) && (! (map_p -> hm_hash_key_fn)))
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "HashMap has no functions set for its keys");
+			return false;
+		}
+
+	if (map_p -> hm_size >= map_p -> hm_load_limit)
+		{
+			if (!ResizeHashMap (map_p, (map_p -> hm_capacity) << 1))
+				{
+					return false;
+				}
+		}
+
+	if (GetValueToStore (map_p, value_p, &stored_value_p))
+		{
+			const uint32 hash = HashKey (map_p, key_p);
+			const uint32 mask = (map_p -> hm_capacity) - 1;
+			HashMapEntry *entries_p = map_p -> hm_entries_p;
+			uint32 i = hash & mask;
+			uint32 distance = 0;
+			bool looping = true;
+
+			/*
+			 * Walk along the probe chain until we either find the key or reach
+			 * the slot where Robin Hood ordering says that it would have to be.
+			 */
+			while (looping)
+				{
+					HashMapEntry *entry_p = entries_p + i;
+
+					if ((entry_p -> hme_hash == 0) || (entry_p -> hme_distance < distance))
+						{
+							HashMapEntry entry;
+
+							if (GetKeyToStore (map_p, key_p, & (entry.hme_key_p)))
+								{
+									entry.hme_value_p = stored_value_p;
+									entry.hme_hash = hash;
+									entry.hme_distance = distance;
+
+									InsertEntry (entries_p, mask, i, entry);
+									++ (map_p -> hm_size);
+
+									success_flag = true;
+								}
+
+							looping = false;
+						}
+					else if ((entry_p -> hme_hash == hash) && (AreKeysEqual (map_p, entry_p -> hme_key_p, key_p)))
+						{
+							/* Replace the existing value */
+							if ((map_p -> hm_value_mem == MF_DEEP_COPY) || (map_p -> hm_value_mem == MF_SHALLOW_COPY))
+								{
+									if ((entry_p -> hme_value_p) && (entry_p -> hme_value_p != stored_value_p))
+										{
+											if (map_p -> hm_free_value_fn)
+												{
+													map_p -> hm_free_value_fn (entry_p -> hme_value_p);
+												}
+											else
+												{
+													FreeMemory (entry_p -> hme_value_p);
+												}
+										}
+								}
+
+							entry_p -> hme_value_p = stored_value_p;
+
+							success_flag = true;
+							looping = false;
+						}
+					else
+						{
+							i = (i + 1) & mask;
+							++ distance;
+						}
+
+				}		/* while (looping) */
+
+			if ((!success_flag) && (map_p -> hm_value_mem == MF_DEEP_COPY) && stored_value_p)
+				{
+					if (map_p -> hm_free_value_fn)
+						{
+							map_p -> hm_free_value_fn (stored_value_p);
+						}
+					else
+						{
+							FreeMemory (stored_value_p);
+						}
+				}
+
+		}		/* if (GetValueToStore (map_p, value_p, &stored_value_p)) */
+
+	return success_flag;
+}
+
+
+void *GetFromHashMap (const HashMap *map_p, const void *key_p)
+{
+	const HashMapEntry *entry_p = FindEntry (map_p, key_p, HashKey (map_p, key_p));
+
+	return entry_p ? entry_p -> hme_value_p : NULL;
+}
+
+
+bool IsKeyInHashMap (const HashMap *map_p, const void *key_p)
+{
+	return (FindEntry (map_p, key_p, HashKey (map_p, key_p)) != NULL);
+}
+
+
+bool RemoveFromHashMap (HashMap *map_p, const void *key_p)
+{
+	HashMapEntry *entry_p = FindEntry (map_p, key_p, HashKey (map_p, key_p));
+
+	if (entry_p)
+		{
+			const uint32 mask = (map_p -> hm_capacity) - 1;
+			HashMapEntry *entries_p = map_p -> hm_entries_p;
+			uint32 i = (uint32) (entry_p - entries_p);
+			uint32 j = (i + 1) & mask;
+
+			FreeEntry (map_p, entry_p);
+
+			/*
+			 * Rather than leaving a tombstone, shift each of the following entries
+			 * that are away from their home slots back by one until we reach an
+			 * empty slot or an entry that is already in its home slot.
+			 */
+			while ((entries_p [j].hme_hash != 0) && (entries_p [j].hme_distance > 0))
+				{
+					entries_p [i] = entries_p [j];
+					-- (entries_p [i].hme_distance);
+
+					i = j;
+					j = (j + 1) & mask;
+				}
+
+			memset (entries_p + i, 0, sizeof (HashMapEntry));
+			-- (map_p -> hm_size);
+
+			return true;
+		}
+
+	return false;
+}
+
+
+uint32 GetHashMapSize (const HashMap *map_p)
+{
+	return map_p -> hm_size;
+}
+
+
+bool ReserveHashMap (HashMap *map_p, const uint32 num_entries)
+{
+	bool success_flag = true;
+
+	if (num_entries > map_p -> hm_load_limit)
+		{
+			success_flag = ResizeHashMap (map_p, GetCapacityForNumEntries (num_entries, map_p -> hm_load_percentage));
+		}
+
+	return success_flag;
+}
+
+
+bool GetNextHashMapEntry (const HashMap *map_p, uint32 *index_p, const void **key_pp, void **value_pp)
+{
+	uint32 i = *index_p;
+	const HashMapEntry *entry_p = (map_p -> hm_entries_p) + i;
+
+	while (i < map_p -> hm_capacity)
+		{
+			if (entry_p -> hme_hash != 0)
+				{
+					if (key_pp)
+						{
+							*key_pp = entry_p -> hme_key_p;
+						}
+
+					if (value_pp)
+						{
+							*value_pp = entry_p -> hme_value_p;
+						}
+
+					*index_p = i + 1;
+					return true;
+				}
+
+			++ entry_p;
+			++ i;
+		}
+
+	*index_p = i;
+	return false;
+}
+
+
+static uint32 GetCapacityForNumEntries (const uint32 num_entries, const uint8 load_percentage)
+{
+	uint32 capacity = S_MIN_CAPACITY;
+
+	while ((((uint64) capacity * load_percentage) / 100) < num_entries)
+		{
+			capacity <<= 1;
+		}
+
+	return capacity;
+}
+
+
+static bool ResizeHashMap (HashMap *map_p, const uint32 new_capacity)
+{
+	HashMapEntry *new_entries_p = (HashMapEntry *) AllocMemoryArray (new_capacity, sizeof (HashMapEntry));
+
+	if (new_entries_p)
+		{
+			const uint32 mask = new_capacity - 1;
+			HashMapEntry *entry_p = map_p -> hm_entries_p;
+			uint32 i;
+
+			/* The hashes are cached so the keys don't need to be rehashed */
+			for (i = map_p -> hm_capacity; i > 0; -- i, ++ entry_p)
+				{
+					if (entry_p -> hme_hash != 0)
+						{
+							HashMapEntry entry = *entry_p;
+
+							entry.hme_distance = 0;
+							InsertEntry (new_entries_p, mask, entry.hme_hash & mask, entry);
+						}
+				}
+
+			FreeMemory (map_p -> hm_entries_p);
+
+			map_p -> hm_entries_p = new_entries_p;
+			map_p -> hm_capacity = new_capacity;
+			map_p -> hm_load_limit = (uint32) (((uint64) new_capacity * (map_p -> hm_load_percentage)) / 100);
+
+			return true;
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to extend HashMap to " UINT32_FMT " entries", new_capacity);
+		}
+
+	return false;
+}
+
+
+/*
+ * Put an entry, whose key is not already in the table, at the given slot
+ * displacing any richer entries further along the probe chain.
+ */
+static void InsertEntry (HashMapEntry *entries_p, const uint32 mask, uint32 index, HashMapEntry entry)
+{
+	for (;;)
+		{
+			HashMapEntry *slot_p = entries_p + index;
+
+			if (slot_p -> hme_hash == 0)
+				{
+					*slot_p = entry;
+					return;
+				}
+
+			if (slot_p -> hme_distance < entry.hme_distance)
+				{
+					HashMapEntry displaced = *slot_p;
+
+					*slot_p = entry;
+					entry = displaced;
+				}
+
+			index = (index + 1) & mask;
+			++ (entry.hme_distance);
+		}
+}
+
+
+static HashMapEntry *FindEntry (const HashMap *map_p, const void *key_p, const uint32 hash)
+{
+	const uint32 mask = (map_p -> hm_capacity) - 1;
+	HashMapEntry *entries_p = map_p -> hm_entries_p;
+	uint32 i = hash & mask;
+	uint32 distance = 0;
+
+	/*
+	 * Once we reach an entry that is closer to its home slot than we are
+	 * to ours, the key can't be further along the chain.
+	 */
+	while ((entries_p [i].hme_hash != 0) && (distance <= entries_p [i].hme_distance))
+		{
+			if ((entries_p [i].hme_hash == hash) && (AreKeysEqual (map_p, entries_p [i].hme_key_p, key_p)))
+				{
+					return entries_p + i;
+				}
+
+			i = (i + 1) & mask;
+			++ distance;
+		}
+
+	return NULL;
+}
+
+
+static bool GetKeyToStore (const HashMap *map_p, const void *key_p, const void **stored_key_pp)
+{
+	bool success_flag = true;
+
+	if ((map_p -> hm_key_mem == MF_DEEP_COPY) && (map_p -> hm_key_type != HMKT_POINTER))
+		{
+			void *copied_key_p = NULL;
+
+			switch (map_p -> hm_key_type)
+				{
+					case HMKT_STRING:
+						copied_key_p = EasyCopyToNewString ((const char *) key_p);
+						break;
+
+					case HMKT_UUID:
+						copied_key_p = AllocMemory (UUID_RAW_SIZE);
+
+						if (copied_key_p)
+							{
+								memcpy (copied_key_p, key_p, UUID_RAW_SIZE);
+							}
+						break;
+
+					case HMKT_CUSTOM:
+					default:
+						if (map_p -> hm_copy_key_fn)
+							{
+								copied_key_p = map_p -> hm_copy_key_fn (key_p);
+							}
+						break;
+				}
+
+			if (copied_key_p)
+				{
+					*stored_key_pp = copied_key_p;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to copy key for HashMap");
+					success_flag = false;
+				}
+		}
+	else
+		{
+			*stored_key_pp = key_p;
+		}
+
+	return success_flag;
+}
+
+
+static bool GetValueToStore (const HashMap *map_p, const void *value_p, void **stored_value_pp)
+{
+	bool success_flag = true;
+
+	if ((map_p -> hm_value_mem == MF_DEEP_COPY) && value_p)
+		{
+			if (map_p -> hm_copy_value_fn)
+				{
+					*stored_value_pp = map_p -> hm_copy_value_fn (value_p);
+
+					if (! (*stored_value_pp))
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to copy value for HashMap");
+							success_flag = false;
+						}
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "HashMap has no function to copy its values");
+					success_flag = false;
+				}
+		}
+	else
+		{
+			*stored_value_pp = (void *) value_p;
+		}
+
+	return success_flag;
+}
+
+
+static void FreeEntry (const HashMap *map_p, HashMapEntry *entry_p)
+{
+	if (((map_p -> hm_key_mem == MF_DEEP_COPY) || (map_p -> hm_key_mem == MF_SHALLOW_COPY)) && (map_p -> hm_key_type != HMKT_POINTER))
+		{
+			void *key_p = (void *) (entry_p -> hme_key_p);
+
+			if (map_p -> hm_free_key_fn)
+				{
+					map_p -> hm_free_key_fn (key_p);
+				}
+			else if ((map_p -> hm_key_type == HMKT_STRING) && (map_p -> hm_key_mem == MF_DEEP_COPY))
+				{
+					FreeCopiedString ((char *) key_p);
+				}
+			else
+				{
+					FreeMemory (key_p);
+				}
+		}
+
+	if (((map_p -> hm_value_mem == MF_DEEP_COPY) || (map_p -> hm_value_mem == MF_SHALLOW_COPY)) && (entry_p -> hme_value_p))
+		{
+			if (map_p -> hm_free_value_fn)
+				{
+					map_p -> hm_free_value_fn (entry_p -> hme_value_p);
+				}
+			else
+				{
+					FreeMemory (entry_p -> hme_value_p);
+				}
+		}
+
+	entry_p -> hme_key_p = NULL;
+	entry_p -> hme_value_p = NULL;
+}
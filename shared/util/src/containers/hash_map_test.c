@@ -0,0 +1,319 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * hash_map_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for HashMap along with a benchmark that runs the same mix of
+ *  inserts, lookups and deletes against a HashTable and a HashMap of
+ *  strings, both kept at a high load factor.
+ *
+ *  Usage: hash_map_test [<number of keys> [<number of operations>]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash_map.h"
+#include "string_hash_table.h"
+#include "string_utils.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_KEYS (20000)
+
+#define DEFAULT_NUM_OPERATIONS (200000)
+
+#define LOAD_PERCENTAGE (90)
+
+
+static double GetElapsedSeconds (const struct timespec *start_p)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start_p -> tv_sec) + ((now.tv_nsec - start_p -> tv_nsec) / 1e9);
+}
+
+
+static void TestStrings (void)
+{
+	HashMap *map_p = GetHashMapOfStrings (4, 75);
+
+	if (map_p)
+		{
+			char key_s [32];
+			bool success_flag = true;
+			uint32 i;
+			uint32 count = 0;
+			const void *key_p;
+			void *value_p;
+
+			for (i = 0; (i < 1000) && success_flag; ++ i)
+				{
+					sprintf (key_s, "key_%u", i);
+					success_flag = PutInHashMap (map_p, key_s, key_s);
+				}
+
+			Check (success_flag && (GetHashMapSize (map_p) == 1000), "insert strings");
+
+			Check (PutInHashMap (map_p, "key_7", "seven") && (GetHashMapSize (map_p) == 1000), "replace a value");
+			Check (strcmp ((const char *) GetFromHashMap (map_p, "key_7"), "seven") == 0, "get the replaced value");
+
+			for (i = 0; i < 1000; i += 2)
+				{
+					sprintf (key_s, "key_%u", i);
+					success_flag = RemoveFromHashMap (map_p, key_s) && success_flag;
+				}
+
+			Check (success_flag && (GetHashMapSize (map_p) == 500), "remove every other key");
+			Check (!RemoveFromHashMap (map_p, "key_0"), "removing a missing key fails");
+
+			for (i = 1; (i < 1000) && success_flag; i += 2)
+				{
+					const char *found_s;
+
+					sprintf (key_s, "key_%u", i);
+					found_s = (const char *) GetFromHashMap (map_p, key_s);
+
+					success_flag = (found_s != NULL) && ((i == 7) || (strcmp (found_s, key_s) == 0));
+				}
+
+			Check (success_flag, "remaining keys are found after removals");
+			Check (!IsKeyInHashMap (map_p, "key_10"), "removed keys are not found");
+
+			i = 0;
+			while (GetNextHashMapEntry (map_p, &i, &key_p, &value_p))
+				{
+					++ count;
+				}
+
+			Check (count == 500, "iterate over the entries");
+
+			ClearHashMap (map_p);
+			Check ((GetHashMapSize (map_p) == 0) && !IsKeyInHashMap (map_p, "key_1"), "clear");
+
+			FreeHashMap (map_p);
+		}
+	else
+		{
+			Check (false, "allocate HashMap of strings");
+		}
+}
+
+
+static void TestPointersAndUUIDs (void)
+{
+	HashMap *map_p = AllocateHashMap (0, 75, HMKT_POINTER, MF_SHADOW_USE, MF_SHADOW_USE);
+
+	if (map_p)
+		{
+			int values [100];
+			bool success_flag = true;
+			int i;
+
+			for (i = 0; (i < 100) && success_flag; ++ i)
+				{
+					success_flag = PutInHashMap (map_p, values + i, values + i);
+				}
+
+			for (i = 0; (i < 100) && success_flag; ++ i)
+				{
+					success_flag = (GetFromHashMap (map_p, values + i) == values + i);
+				}
+
+			Check (success_flag, "pointer keys");
+			FreeHashMap (map_p);
+		}
+
+	map_p = AllocateHashMap (0, 75, HMKT_UUID, MF_DEEP_COPY, MF_SHADOW_USE);
+
+	if (map_p)
+		{
+			unsigned char id [16];
+			bool success_flag = true;
+			int i;
+
+			memset (id, 0, sizeof (id));
+
+			for (i = 0; (i < 100) && success_flag; ++ i)
+				{
+					id [15] = (unsigned char) i;
+					success_flag = PutInHashMap (map_p, id, map_p);
+				}
+
+			/* The keys were copied so changing our id doesn't affect them */
+			id [15] = 42;
+			id [0] = 1;
+			Check (success_flag && !IsKeyInHashMap (map_p, id), "uuid keys are copied");
+
+			id [0] = 0;
+			Check (RemoveFromHashMap (map_p, id) && (GetHashMapSize (map_p) == 99), "remove uuid key");
+
+			FreeHashMap (map_p);
+		}
+}
+
+
+/*
+ * Run a mix of 50% lookups, 25% inserts and 25% deletes on keys chosen at
+ * random from a fixed set, so the table stays about half full of live keys
+ * while going through a great many deletions.
+ */
+static void RunBenchmark (const uint32 num_keys, const uint32 num_operations)
+{
+	char **keys_pp = (char **) AllocMemoryArray (num_keys, sizeof (char *));
+	uint32 *ops_p = (uint32 *) AllocMemoryArray (num_operations, sizeof (uint32));
+
+	if (keys_pp && ops_p)
+		{
+			HashTable *table_p = GetHashTableOfStrings (num_keys, LOAD_PERCENTAGE);
+			HashMap *map_p = GetHashMapOfStrings (num_keys, LOAD_PERCENTAGE);
+			uint32 i;
+
+			srand (1);
+
+			for (i = 0; i < num_keys; ++ i)
+				{
+					char key_s [32];
+
+					sprintf (key_s, "accession_%u", i);
+					keys_pp [i] = EasyCopyToNewString (key_s);
+				}
+
+			for (i = 0; i < num_operations; ++ i)
+				{
+					ops_p [i] = (uint32) rand ();
+				}
+
+			if (table_p && map_p)
+				{
+					struct timespec start;
+					double table_time;
+					double map_time;
+					uint32 table_hits = 0;
+					uint32 map_hits = 0;
+
+					for (i = 0; i < num_keys / 2; ++ i)
+						{
+							PutInHashTable (table_p, keys_pp [i], keys_pp [i]);
+							PutInHashMap (map_p, keys_pp [i], keys_pp [i]);
+						}
+
+					clock_gettime (CLOCK_MONOTONIC, &start);
+
+					for (i = 0; i < num_operations; ++ i)
+						{
+							const char *key_s = keys_pp [(ops_p [i] >> 2) % num_keys];
+
+							switch (ops_p [i] & 3)
+								{
+									case 0:
+										PutInHashTable (table_p, key_s, key_s);
+										break;
+
+									case 1:
+										RemoveFromHashTable (table_p, key_s);
+										break;
+
+									default:
+										if (GetFromHashTable (table_p, key_s))
+											{
+												++ table_hits;
+											}
+										break;
+								}
+						}
+
+					table_time = GetElapsedSeconds (&start);
+
+					clock_gettime (CLOCK_MONOTONIC, &start);
+
+					for (i = 0; i < num_operations; ++ i)
+						{
+							const char *key_s = keys_pp [(ops_p [i] >> 2) % num_keys];
+
+							switch (ops_p [i] & 3)
+								{
+									case 0:
+										PutInHashMap (map_p, key_s, key_s);
+										break;
+
+									case 1:
+										RemoveFromHashMap (map_p, key_s);
+										break;
+
+									default:
+										if (GetFromHashMap (map_p, key_s))
+											{
+												++ map_hits;
+											}
+										break;
+								}
+						}
+
+					map_time = GetElapsedSeconds (&start);
+
+					printf ("%u operations on %u keys at %d%% load: HashTable %.3f s, HashMap %.3f s\n", num_operations, num_keys, LOAD_PERCENTAGE, table_time, map_time);
+
+					Check (table_hits == map_hits, "both tables find the same keys");
+					Check (GetHashTableSize (table_p) == GetHashMapSize (map_p), "both tables have the same size");
+				}
+
+			if (table_p)
+				{
+					FreeHashTable (table_p);
+				}
+
+			if (map_p)
+				{
+					FreeHashMap (map_p);
+				}
+
+			for (i = 0; i < num_keys; ++ i)
+				{
+					FreeCopiedString (keys_pp [i]);
+				}
+		}
+
+	if (keys_pp)
+		{
+			FreeMemory (keys_pp);
+		}
+
+	if (ops_p)
+		{
+			FreeMemory (ops_p);
+		}
+}
+
+
+int main (int argc, char *argv [])
+{
+	const uint32 num_keys = (argc > 1) ? (uint32) atol (argv [1]) : DEFAULT_NUM_KEYS;
+	const uint32 num_operations = (argc > 2) ? (uint32) atol (argv [2]) : DEFAULT_NUM_OPERATIONS;
+
+	TestStrings ();
+	TestPointersAndUUIDs ();
+	RunBenchmark (num_keys, num_operations);
+
+	return GetTestResult ();
+}
@@ -11,7 +11,7 @@
 
 IntListNode *AllocateIntListNode (const int32 value)
 {
-	IntListNode *node_p = (IntListNode *) AllocMemory (sizeof (IntListNode));
+	IntListNode *node_p = (IntListNode *) AllocListNodeMemory (sizeof (IntListNode));
 
 	if (node_p)
 		{
@@ -28,7 +28,7 @@ void FreeIntListNode (ListItem * const node_p)
 {
 	IntListNode *int_node_p = (IntListNode *) node_p;
 
-	FreeMemory (int_node_p);
+	FreeListNodeMemory (int_node_p);
 }
 
 
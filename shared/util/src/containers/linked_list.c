@@ -102,6 +102,8 @@ void ClearLinkedList (LinkedList * const list_p)
 			free_node_fn_p = (void (*) (ListItem *)) FreeNode;
 		}
 
+	BeginListNodeRelease ();
+
 	while (this_node_p != NULL)
 		{
 			next_node_p = this_node_p -> ln_next_p;
@@ -111,6 +113,8 @@ void ClearLinkedList (LinkedList * const list_p)
 			this_node_p = next_node_p;
 		}
 
+	EndListNodeRelease ();
+
 	list_p -> ll_head_p = NULL;
 	list_p -> ll_tail_p = NULL;
 	list_p -> ll_size = 0;
@@ -20,6 +20,7 @@
 #include "memory_allocations.h"
 
 #include "hash_table.h"
+#include "hash_map.h"
 #include "string_hash_table.h"
 #include "string_utils.h"
 
@@ -44,6 +45,12 @@ static void PrintStringIntHashBucket (const HashBucket * const bucket_p, OutputS
 static bool SaveStringIntHashBucket (const HashBucket * const bucket_p, FILE *out_f);
 
 
+static void *CopyStringValue (const void *value_p);
+
+
+static void FreeStringValue (void *value_p);
+
+
 
 
 /**
@@ -69,6 +76,20 @@ HashTable *GetHashTableOfStringInts (const uint32 initial_capacity, const uint8
 
 
 
+HashMap *GetHashMapOfStrings (const uint32 initial_capacity, const uint8 load_percentage)
+{
+	HashMap *map_p = AllocateHashMap (initial_capacity, load_percentage, HMKT_STRING, MF_DEEP_COPY, MF_DEEP_COPY);
+
+	if (map_p)
+		{
+			SetHashMapValueFunctions (map_p, CopyStringValue, FreeStringValue);
+		}
+
+	return map_p;
+}
+
+
+
 /** Function for filling a HashBucket */
 static bool FillStringHashBucket (HashBucket * const bucket_p, const void * const key_p, const void * const value_p)
 {
@@ -201,3 +222,15 @@ static bool SaveStringIntHashBucket (const HashBucket * const bucket_p, FILE *ou
 {
 	return (fprintf (out_f, "%s = " UINT32_FMT "\n", (const char * const) (bucket_p -> hb_key_p), * ((const int * const) (bucket_p -> hb_value_p))) > 0);
 }
+
+
+static void *CopyStringValue (const void *value_p)
+{
+	return EasyCopyToNewString ((const char *) value_p);
+}
+
+
+static void FreeStringValue (void *value_p)
+{
+	FreeCopiedString ((char *) value_p);
+}
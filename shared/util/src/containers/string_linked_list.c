@@ -29,7 +29,7 @@ LinkedList *AllocateStringLinkedList (void)
 
 StringListNode *AllocateStringListNode (const char * const value_s, const MEM_FLAG mem_flag)
 {
-	StringListNode *node_p = (StringListNode *) AllocMemory (sizeof (StringListNode));
+	StringListNode *node_p = (StringListNode *) AllocListNodeMemory (sizeof (StringListNode));
 
 	if (node_p)
 		{
@@ -38,7 +38,7 @@ StringListNode *AllocateStringListNode (const char * const value_s, const MEM_FL
 					return node_p;
 				}
 
-			FreeMemory (node_p);
+			FreeListNodeMemory (node_p);
 		}
 
 	return NULL;
@@ -61,11 +61,6 @@ bool InitStringListNode (StringListNode *node_p, const char * const value_s, con
 						node_p -> sln_string_flag = mem_flag;
 						success_flag = true;
 					}
-				else
-					{
-						FreeMemory (node_p);
-						node_p = NULL;
-					}
 				break;
 
 			case MF_SHALLOW_COPY:
@@ -92,7 +87,7 @@ void FreeStringListNode (ListItem * const node_p)
 
 	ClearStringListNode (str_node_p);
 
-	FreeMemory (str_node_p);
+	FreeListNodeMemory (str_node_p);
 }
 
 
@@ -0,0 +1,368 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * vector.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector.h"
+#include "memory_allocations.h"
+#include "streams.h"
+
+
+#define S_MIN_CAPACITY (8)
+
+
+static bool GrowVector (Vector *vector_p, const uint32 num_extra_elements);
+
+static void FreeVectorElements (Vector *vector_p, const uint32 from, const uint32 to);
+
+
+Vector *AllocateVector (const size_t element_size, const uint32 initial_capacity, void (*free_element_fn) (void *element_p))
+{
+	Vector *vector_p = (Vector *) AllocMemory (sizeof (Vector));
+
+	if (vector_p)
+		{
+			InitVector (vector_p, element_size, free_element_fn);
+
+			if ((initial_capacity == 0) || ReserveVector (vector_p, initial_capacity))
+				{
+					return vector_p;
+				}
+
+			FreeMemory (vector_p);
+		}
+
+	PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate Vector");
+
+	return NULL;
+}
+
+
+Vector *AllocatePointerVector (const uint32 initial_capacity, void (*free_pointer_fn) (void *value_p))
+{
+	Vector *vector_p = AllocateVector (sizeof (void *), initial_capacity, free_pointer_fn);
+
+	if (vector_p)
+		{
+			vector_p -> ve_pointers_flag = true;
+		}
+
+	return vector_p;
+}
+
+
+void InitVector (Vector *vector_p, const size_t element_size, void (*free_element_fn) (void *element_p))
+{
+	vector_p -> ve_data_p = NULL;
+	vector_p -> ve_element_size = element_size;
+	vector_p -> ve_size = 0;
+	vector_p -> ve_capacity = 0;
+	vector_p -> ve_free_element_fn = free_element_fn;
+	vector_p -> ve_pointers_flag = false;
+}
+
+
+void FreeVector (Vector *vector_p)
+{
+	ClearVector (vector_p);
+
+	if (vector_p -> ve_data_p)
+		{
+			FreeMemory (vector_p -> ve_data_p);
+		}
+
+	FreeMemory (vector_p);
+}
+
+
+void ClearVector (Vector *vector_p)
+{
+	FreeVectorElements (vector_p, 0, vector_p -> ve_size);
+	vector_p -> ve_size = 0;
+}
+
+
+bool ReserveVector (Vector *vector_p, const uint32 capacity)
+{
+	if (capacity > vector_p -> ve_capacity)
+		{
+			char *data_p = (char *) ReallocMemory (vector_p -> ve_data_p, capacity * (vector_p -> ve_element_size), (vector_p -> ve_capacity) * (vector_p -> ve_element_size));
+
+			if (data_p)
+				{
+					vector_p -> ve_data_p = data_p;
+					vector_p -> ve_capacity = capacity;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to reserve %u elements for Vector", capacity);
+					return false;
+				}
+		}
+
+	return true;
+}
+
+
+bool AppendToVector (Vector *vector_p, const void *element_p)
+{
+	if ((vector_p -> ve_size < vector_p -> ve_capacity) || GrowVector (vector_p, 1))
+		{
+			memcpy (vector_p -> ve_data_p + ((vector_p -> ve_size) * (vector_p -> ve_element_size)), element_p, vector_p -> ve_element_size);
+			++ (vector_p -> ve_size);
+
+			return true;
+		}
+
+	return false;
+}
+
+
+bool AppendArrayToVector (Vector *vector_p, const void *elements_p, const uint32 num_elements)
+{
+	if ((vector_p -> ve_size + num_elements <= vector_p -> ve_capacity) || GrowVector (vector_p, num_elements))
+		{
+			memcpy (vector_p -> ve_data_p + ((vector_p -> ve_size) * (vector_p -> ve_element_size)), elements_p, num_elements * (vector_p -> ve_element_size));
+			vector_p -> ve_size += num_elements;
+
+			return true;
+		}
+
+	return false;
+}
+
+
+bool InsertIntoVector (Vector *vector_p, const uint32 index, const void *element_p)
+{
+	if (index <= vector_p -> ve_size)
+		{
+			if ((vector_p -> ve_size < vector_p -> ve_capacity) || GrowVector (vector_p, 1))
+				{
+					const size_t element_size = vector_p -> ve_element_size;
+					char *dest_p = vector_p -> ve_data_p + (index * element_size);
+
+					memmove (dest_p + element_size, dest_p, ((vector_p -> ve_size) - index) * element_size);
+					memcpy (dest_p, element_p, element_size);
+					++ (vector_p -> ve_size);
+
+					return true;
+				}
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Can't insert at %u in Vector of size %u", index, vector_p -> ve_size);
+		}
+
+	return false;
+}
+
+
+bool RemoveFromVector (Vector *vector_p, const uint32 index)
+{
+	if (index < vector_p -> ve_size)
+		{
+			const size_t element_size = vector_p -> ve_element_size;
+			char *dest_p = vector_p -> ve_data_p + (index * element_size);
+
+			FreeVectorElements (vector_p, index, index + 1);
+
+			-- (vector_p -> ve_size);
+			memmove (dest_p, dest_p + element_size, ((vector_p -> ve_size) - index) * element_size);
+
+			return true;
+		}
+
+	return false;
+}
+
+
+void *GetVectorElement (const Vector *vector_p, const uint32 index)
+{
+	return (index < vector_p -> ve_size) ? vector_p -> ve_data_p + (index * (vector_p -> ve_element_size)) : NULL;
+}
+
+
+void *GetNextVectorElement (const Vector *vector_p, uint32 *index_p)
+{
+	void *element_p = GetVectorElement (vector_p, *index_p);
+
+	if (element_p)
+		{
+			++ (*index_p);
+		}
+
+	return element_p;
+}
+
+
+void SortVector (Vector *vector_p, int (*compare_fn) (const void *v1_p, const void *v2_p))
+{
+	if (vector_p -> ve_size > 1)
+		{
+			qsort (vector_p -> ve_data_p, vector_p -> ve_size, vector_p -> ve_element_size, compare_fn);
+		}
+}
+
+
+void *BinarySearchVector (const Vector *vector_p, const void *key_p, int (*compare_fn) (const void *v1_p, const void *v2_p), uint32 *index_p)
+{
+	const size_t element_size = vector_p -> ve_element_size;
+	uint32 low = 0;
+	uint32 high = vector_p -> ve_size;
+
+	while (low < high)
+		{
+			const uint32 mid = low + ((high - low) >> 1);
+			char *element_p = vector_p -> ve_data_p + (mid * element_size);
+			const int res = compare_fn (key_p, element_p);
+
+			if (res == 0)
+				{
+					if (index_p)
+						{
+							*index_p = mid;
+						}
+
+					return element_p;
+				}
+			else if (res < 0)
+				{
+					high = mid;
+				}
+			else
+				{
+					low = mid + 1;
+				}
+		}
+
+	if (index_p)
+		{
+			*index_p = low;
+		}
+
+	return NULL;
+}
+
+
+uint32 GetVectorSize (const Vector *vector_p)
+{
+	return vector_p -> ve_size;
+}
+
+
+bool AppendPointerToVector (Vector *vector_p, void *value_p)
+{
+	return AppendToVector (vector_p, &value_p);
+}
+
+
+void *GetPointerFromVector (const Vector *vector_p, const uint32 index)
+{
+	void **value_pp = (void **) GetVectorElement (vector_p, index);
+
+	return value_pp ? *value_pp : NULL;
+}
+
+
+bool AppendInt32ToVector (Vector *vector_p, const int32 value)
+{
+	return AppendToVector (vector_p, &value);
+}
+
+
+int32 GetInt32FromVector (const Vector *vector_p, const uint32 index)
+{
+	return ((const int32 *) (vector_p -> ve_data_p)) [index];
+}
+
+
+bool AppendDoubleToVector (Vector *vector_p, const double value)
+{
+	return AppendToVector (vector_p, &value);
+}
+
+
+double GetDoubleFromVector (const Vector *vector_p, const uint32 index)
+{
+	return ((const double *) (vector_p -> ve_data_p)) [index];
+}
+
+
+/*
+ * Grow the Vector geometrically so that appending n elements one at a
+ * time takes amortised constant time per element.
+ */
+static bool GrowVector (Vector *vector_p, const uint32 num_extra_elements)
+{
+	const uint32 required_capacity = vector_p -> ve_size + num_extra_elements;
+	/*
+	 * Start from at least S_MIN_CAPACITY since growing by half
+	 * of a capacity of 1 would never increase it.
+	 */
+	uint32 new_capacity = (vector_p -> ve_capacity > S_MIN_CAPACITY) ? vector_p -> ve_capacity : S_MIN_CAPACITY;
+
+	while (new_capacity < required_capacity)
+		{
+			const uint32 increment = new_capacity >> 1;
+
+			if (new_capacity <= UINT32_MAX - increment)
+				{
+					new_capacity += increment;
+				}
+			else
+				{
+					new_capacity = required_capacity;
+				}
+		}
+
+	return ReserveVector (vector_p, new_capacity);
+}
+
+
+static void FreeVectorElements (Vector *vector_p, const uint32 from, const uint32 to)
+{
+	if (vector_p -> ve_free_element_fn)
+		{
+			uint32 i;
+
+			for (i = from; i < to; ++ i)
+				{
+					void *element_p = vector_p -> ve_data_p + (i * (vector_p -> ve_element_size));
+
+					if (vector_p -> ve_pointers_flag)
+						{
+							void *value_p = * ((void **) element_p);
+
+							if (value_p)
+								{
+									vector_p -> ve_free_element_fn (value_p);
+								}
+						}
+					else
+						{
+							vector_p -> ve_free_element_fn (element_p);
+						}
+				}
+		}
+}
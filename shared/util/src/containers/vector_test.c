@@ -0,0 +1,283 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * vector_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the Vector container and a benchmark comparing it against
+ *  a LinkedList of IntListNodes for building, iterating, sorting and
+ *  searching the same set of integers.
+ *
+ *  Usage: vector_test [<number of values> [<number of lookups>]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vector.h"
+#include "int_linked_list.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_VALUES (500000)
+
+#define DEFAULT_NUM_LOOKUPS (100)
+
+
+static int s_num_freed = 0;
+
+
+static double GetTime (void)
+{
+	struct timespec t;
+
+	clock_gettime (CLOCK_MONOTONIC, &t);
+
+	return t.tv_sec + (t.tv_nsec / 1.0e9);
+}
+
+
+static int CompareInt32s (const void *v1_p, const void *v2_p)
+{
+	const int32 i = * ((const int32 *) v1_p);
+	const int32 j = * ((const int32 *) v2_p);
+
+	return (i < j) ? -1 : ((i > j) ? 1 : 0);
+}
+
+
+static int CompareIntListNodes (const void *v1_p, const void *v2_p)
+{
+	const IntListNode *node1_p = * ((const IntListNode * const *) v1_p);
+	const IntListNode *node2_p = * ((const IntListNode * const *) v2_p);
+
+	return CompareInt32s (& (node1_p -> iln_value), & (node2_p -> iln_value));
+}
+
+
+static void CountFree (void *value_p)
+{
+	++ s_num_freed;
+	free (value_p);
+}
+
+
+static void TestVector (void)
+{
+	Vector *vector_p = AllocateVector (sizeof (int32), 0, NULL);
+
+	if (vector_p)
+		{
+			const int32 values [] = { 5, 1, 4, 2, 3 };
+			const int32 missing = 0;
+			uint32 index = 0;
+			int32 *value_p;
+			bool success_flag = true;
+			int32 expected = 1;
+
+			Check (AppendArrayToVector (vector_p, values, 5) && (GetVectorSize (vector_p) == 5), "bulk append");
+
+			SortVector (vector_p, CompareInt32s);
+
+			while ((value_p = (int32 *) GetNextVectorElement (vector_p, &index)) != NULL)
+				{
+					if (*value_p != expected)
+						{
+							success_flag = false;
+						}
+
+					++ expected;
+				}
+
+			Check (success_flag && (index == 5), "sort and iterate in order");
+
+			value_p = (int32 *) BinarySearchVector (vector_p, values + 2, CompareInt32s, &index);
+			Check ((value_p != NULL) && (*value_p == 4) && (index == 3), "find a value");
+
+			value_p = (int32 *) BinarySearchVector (vector_p, &missing, CompareInt32s, &index);
+			Check ((value_p == NULL) && (index == 0), "get the insertion point of a missing value");
+
+			Check (InsertIntoVector (vector_p, index, &missing) && (GetInt32FromVector (vector_p, 0) == 0) && (GetInt32FromVector (vector_p, 1) == 1), "insert a value");
+
+			Check (RemoveFromVector (vector_p, 2) && (GetVectorSize (vector_p) == 5) && (GetInt32FromVector (vector_p, 2) == 3), "remove a value and keep the order");
+			Check (!RemoveFromVector (vector_p, 5), "don't remove out of range");
+
+			FreeVector (vector_p);
+		}
+
+	vector_p = AllocateVector (sizeof (int32), 1, NULL);
+
+	if (vector_p)
+		{
+			int32 i;
+			bool success_flag = true;
+
+			for (i = 0; i < 20; ++ i)
+				{
+					if (!AppendToVector (vector_p, &i))
+						{
+							success_flag = false;
+						}
+				}
+
+			Check (success_flag && (GetVectorSize (vector_p) == 20) && (GetInt32FromVector (vector_p, 19) == 19), "grow from a capacity of 1");
+
+			FreeVector (vector_p);
+		}
+
+	vector_p = AllocatePointerVector (2, CountFree);
+
+	if (vector_p)
+		{
+			int i;
+
+			for (i = 0; i < 100; ++ i)
+				{
+					AppendPointerToVector (vector_p, malloc (8));
+				}
+
+			RemoveFromVector (vector_p, 0);
+			Check ((s_num_freed == 1) && (GetPointerFromVector (vector_p, 99) == NULL), "free a removed pointer");
+
+			FreeVector (vector_p);
+			Check (s_num_freed == 100, "free the pointers with the vector");
+		}
+}
+
+
+static void RunBenchmark (const uint32 num_values, const uint32 num_lookups)
+{
+	LinkedList *list_p = AllocateIntLinkedList ();
+	Vector *vector_p = AllocateVector (sizeof (int32), 0, NULL);
+
+	if (list_p && vector_p)
+		{
+			int64 list_sum = 0;
+			int64 vector_sum = 0;
+			uint32 list_hits = 0;
+			uint32 vector_hits = 0;
+			double list_times [4];
+			double vector_times [4];
+			const IntListNode *node_p;
+			double start;
+			uint32 i;
+
+			srand (1);
+
+			start = GetTime ();
+			for (i = 0; i < num_values; ++ i)
+				{
+					AddIntegerToIntLinkedList (list_p, rand ());
+				}
+			list_times [0] = GetTime () - start;
+
+			srand (1);
+
+			start = GetTime ();
+			for (i = 0; i < num_values; ++ i)
+				{
+					AppendInt32ToVector (vector_p, rand ());
+				}
+			vector_times [0] = GetTime () - start;
+
+			start = GetTime ();
+			for (node_p = (const IntListNode *) (list_p -> ll_head_p); node_p; node_p = (const IntListNode *) (node_p -> iln_node.ln_next_p))
+				{
+					list_sum += node_p -> iln_value;
+				}
+			list_times [1] = GetTime () - start;
+
+			start = GetTime ();
+			for (i = 0; i < num_values; ++ i)
+				{
+					vector_sum += GetInt32FromVector (vector_p, i);
+				}
+			vector_times [1] = GetTime () - start;
+
+			start = GetTime ();
+			LinkedListSort (list_p, CompareIntListNodes);
+			list_times [2] = GetTime () - start;
+
+			start = GetTime ();
+			SortVector (vector_p, CompareInt32s);
+			vector_times [2] = GetTime () - start;
+
+			/* Searching a LinkedList means walking it, however it is sorted */
+			start = GetTime ();
+			for (i = 0; i < num_lookups; ++ i)
+				{
+					const int32 key = GetInt32FromVector (vector_p, (i * 7919) % num_values);
+
+					for (node_p = (const IntListNode *) (list_p -> ll_head_p); node_p; node_p = (const IntListNode *) (node_p -> iln_node.ln_next_p))
+						{
+							if (node_p -> iln_value == key)
+								{
+									++ list_hits;
+									break;
+								}
+						}
+				}
+			list_times [3] = GetTime () - start;
+
+			start = GetTime ();
+			for (i = 0; i < num_lookups; ++ i)
+				{
+					const int32 key = GetInt32FromVector (vector_p, (i * 7919) % num_values);
+
+					if (BinarySearchVector (vector_p, &key, CompareInt32s, NULL))
+						{
+							++ vector_hits;
+						}
+				}
+			vector_times [3] = GetTime () - start;
+
+			Check (list_sum == vector_sum, "the list and vector hold the same values");
+			Check (list_hits == vector_hits, "the list and vector find the same values");
+
+			printf ("%u values, %u lookups\n", num_values, num_lookups);
+			printf ("             LinkedList     Vector\n");
+			printf ("append      %10.4f s %10.4f s\n", list_times [0], vector_times [0]);
+			printf ("iterate     %10.4f s %10.4f s\n", list_times [1], vector_times [1]);
+			printf ("sort        %10.4f s %10.4f s\n", list_times [2], vector_times [2]);
+			printf ("search      %10.4f s %10.4f s\n", list_times [3], vector_times [3]);
+		}
+
+	if (list_p)
+		{
+			FreeLinkedList (list_p);
+		}
+
+	if (vector_p)
+		{
+			FreeVector (vector_p);
+		}
+}
+
+
+int main (int argc, char *argv [])
+{
+	const uint32 num_values = (argc > 1) ? (uint32) atoi (argv [1]) : DEFAULT_NUM_VALUES;
+	const uint32 num_lookups = (argc > 2) ? (uint32) atoi (argv [2]) : DEFAULT_NUM_LOOKUPS;
+
+	TestVector ();
+	RunBenchmark (num_values, num_lookups);
+
+	return GetTestResult ();
+}
@@ -353,8 +353,61 @@ void RemoveFromHashTable (HashTable * const hash_table_p, const void * const key
 
 	if (bucket_p)
 		{
+			const uint32 capacity = hash_table_p -> ht_capacity;
+			HashBucket *buckets_p = hash_table_p -> ht_buckets_p;
+			uint32 i = (uint32) (bucket_p - buckets_p);
+			uint32 j = i;
+
 			hash_table_p -> ht_free_bucket_fn (bucket_p);
 			-- (hash_table_p -> ht_size);
+
+			/*
+			 * Emptying the bucket would cut off any keys further along the same
+			 * probe sequence, so move back each following key that can no longer
+			 * be reached from its home bucket.
+			 */
+			for (;;)
+				{
+					HashBucket *next_bucket_p;
+					uint32 home;
+					bool move_flag;
+
+					if (++ j == capacity)
+						{
+							j = 0;
+						}
+
+					next_bucket_p = buckets_p + j;
+
+					if (!IsValidHashBucket (next_bucket_p))
+						{
+							break;
+						}
+
+					home = (next_bucket_p -> hb_hashed_key) % capacity;
+
+					/* Can the key stay where it is, i.e. is its home in (i, j] cyclically? */
+					if (i <= j)
+						{
+							move_flag = (home <= i) || (home > j);
+						}
+					else
+						{
+							move_flag = (home <= i) && (home > j);
+						}
+
+					if (move_flag)
+						{
+							buckets_p [i].hb_hashed_key = next_bucket_p -> hb_hashed_key;
+							buckets_p [i].hb_key_p = next_bucket_p -> hb_key_p;
+							buckets_p [i].hb_value_p = next_bucket_p -> hb_value_p;
+
+							next_bucket_p -> hb_key_p = NULL;
+							next_bucket_p -> hb_value_p = NULL;
+
+							i = j;
+						}
+				}
 		}
 }
 
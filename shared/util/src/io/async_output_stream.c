@@ -0,0 +1,472 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * async_output_stream.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "async_output_stream.h"
+#include "memory_allocations.h"
+
+
+/* How much the writer thread copies out before each write */
+#define S_BATCH_SIZE (64 * 1024)
+
+/* How long the writer thread sleeps for when there's nothing to write */
+#define S_IDLE_WAIT_MS (100)
+
+/*
+ * How long the writer thread waits after being woken so that it picks up
+ * a batch of messages rather than paying for a write per message.
+ */
+#define S_BATCH_WAIT_MS (1)
+
+
+/*
+ * A slot's sequence number says whose turn it is. When it equals the
+ * position that a producer has claimed, the slot is free to fill. Once
+ * filled it is set to position + 1 for the writer thread and, once
+ * emptied, it is advanced by the number of slots ready for the next lap.
+ */
+typedef struct AsyncLogSlot
+{
+	uint64 als_sequence;
+
+	uint32 als_length;
+
+	char als_message_s [ASYNC_OUTPUT_STREAM_MESSAGE_SIZE];
+} AsyncLogSlot;
+
+
+/*********************************************/
+/************ STATIC PROTOTYTPES *************/
+/*********************************************/
+
+static int PrintToAsyncStream (OutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const char *message_s, va_list args);
+
+static bool FlushAsyncStream (OutputStream *stream_p);
+
+static void *RunAsyncWriter (void *data_p);
+
+static bool WriteBatch (AsyncOutputStream *stream_p, const char *batch_s, const size_t length);
+
+static bool HasPendingMessage (AsyncOutputStream *stream_p);
+
+static void WakeWriter (AsyncOutputStream *stream_p);
+
+static void WaitMilliseconds (const uint32 ms);
+
+static uint32 GetNumSlots (const uint32 num_slots);
+
+
+OutputStream *AllocateAsyncOutputStream (const char * const filename_s, FILE *default_f, const uint32 level, const uint32 num_slots)
+{
+	AsyncOutputStream *aos_p = (AsyncOutputStream *) AllocMemory (sizeof (AsyncOutputStream));
+
+	if (aos_p)
+		{
+			const uint32 n = GetNumSlots (num_slots);
+
+			aos_p -> aos_slots_p = (AsyncLogSlot *) AllocMemoryArray (n, sizeof (AsyncLogSlot));
+
+			if (aos_p -> aos_slots_p)
+				{
+					uint32 i;
+
+					for (i = 0; i < n; ++ i)
+						{
+							aos_p -> aos_slots_p [i].als_sequence = i;
+						}
+
+					aos_p -> aos_num_slots = n;
+					aos_p -> aos_level = level;
+					aos_p -> aos_enqueue_pos = 0;
+					aos_p -> aos_dequeue_pos = 0;
+					aos_p -> aos_flushed_pos = 0;
+					aos_p -> aos_num_written = 0;
+					aos_p -> aos_num_dropped = 0;
+					aos_p -> aos_num_filtered = 0;
+					aos_p -> aos_stop_flag = false;
+					aos_p -> aos_writer_waiting_flag = false;
+
+					aos_p -> aos_out_f = NULL;
+					aos_p -> aos_close_on_exit_flag = false;
+
+					if (filename_s)
+						{
+							aos_p -> aos_out_f = fopen (filename_s, "a");
+						}
+
+					if (aos_p -> aos_out_f)
+						{
+							aos_p -> aos_close_on_exit_flag = true;
+						}
+					else
+						{
+							aos_p -> aos_out_f = default_f ? default_f : stdout;
+						}
+
+					aos_p -> aos_stream.st_print_fn = PrintToAsyncStream;
+					aos_p -> aos_stream.st_flush_fn = FlushAsyncStream;
+					aos_p -> aos_stream.st_print_json_fn = NULL;
+					aos_p -> aos_stream.st_free_stream_fn = DeallocateAsyncOutputStream;
+
+					if (pthread_mutex_init (& (aos_p -> aos_mutex), NULL) == 0)
+						{
+							if (pthread_cond_init (& (aos_p -> aos_cond), NULL) == 0)
+								{
+									if (pthread_create (& (aos_p -> aos_writer_thread), NULL, RunAsyncWriter, aos_p) == 0)
+										{
+											return (& (aos_p -> aos_stream));
+										}
+									else
+										{
+											fprintf (stderr, "Failed to start writer thread for async output stream\n");
+										}
+
+									pthread_cond_destroy (& (aos_p -> aos_cond));
+								}
+
+							pthread_mutex_destroy (& (aos_p -> aos_mutex));
+						}
+
+					if (aos_p -> aos_close_on_exit_flag)
+						{
+							fclose (aos_p -> aos_out_f);
+						}
+
+					FreeMemory (aos_p -> aos_slots_p);
+				}		/* if (aos_p -> aos_slots_p) */
+
+			FreeMemory (aos_p);
+		}		/* if (aos_p) */
+
+	return NULL;
+}
+
+
+void DeallocateAsyncOutputStream (OutputStream *stream_p)
+{
+	AsyncOutputStream *aos_p = (AsyncOutputStream *) stream_p;
+
+	__atomic_store_n (& (aos_p -> aos_stop_flag), true, __ATOMIC_SEQ_CST);
+	WakeWriter (aos_p);
+
+	/* The writer thread empties the ring buffer before it exits */
+	pthread_join (aos_p -> aos_writer_thread, NULL);
+
+	pthread_cond_destroy (& (aos_p -> aos_cond));
+	pthread_mutex_destroy (& (aos_p -> aos_mutex));
+
+	if (aos_p -> aos_close_on_exit_flag)
+		{
+			if (fclose (aos_p -> aos_out_f) != 0)
+				{
+					fprintf (stderr, "failed to close output stream\n");
+				}
+		}
+
+	FreeMemory (aos_p -> aos_slots_p);
+	FreeMemory (aos_p);
+}
+
+
+void GetAsyncOutputStreamStats (const OutputStream *stream_p, AsyncOutputStreamStats *stats_p)
+{
+	AsyncOutputStream *aos_p = (AsyncOutputStream *) stream_p;
+
+	stats_p -> aoss_num_written = __atomic_load_n (& (aos_p -> aos_num_written), __ATOMIC_RELAXED);
+	stats_p -> aoss_num_dropped = __atomic_load_n (& (aos_p -> aos_num_dropped), __ATOMIC_RELAXED);
+	stats_p -> aoss_num_filtered = __atomic_load_n (& (aos_p -> aos_num_filtered), __ATOMIC_RELAXED);
+}
+
+
+static int PrintToAsyncStream (OutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const char *message_s, va_list args)
+{
+	AsyncOutputStream *aos_p = (AsyncOutputStream *) stream_p;
+	const uint64 mask = (aos_p -> aos_num_slots) - 1;
+	AsyncLogSlot *slot_p = NULL;
+	uint64 pos;
+	int res;
+
+	/* Check the level before doing any formatting */
+	if ((level != STM_LEVEL_ALL) && (level > aos_p -> aos_level))
+		{
+			__atomic_add_fetch (& (aos_p -> aos_num_filtered), 1, __ATOMIC_RELAXED);
+			return 0;
+		}
+
+	pos = __atomic_load_n (& (aos_p -> aos_enqueue_pos), __ATOMIC_RELAXED);
+
+	while (!slot_p)
+		{
+			AsyncLogSlot *candidate_p = (aos_p -> aos_slots_p) + (pos & mask);
+			const uint64 seq = __atomic_load_n (& (candidate_p -> als_sequence), __ATOMIC_ACQUIRE);
+			const int64 diff = (int64) (seq - pos);
+
+			if (diff == 0)
+				{
+					/* On failure, pos is updated to the current position */
+					if (__atomic_compare_exchange_n (& (aos_p -> aos_enqueue_pos), &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+						{
+							slot_p = candidate_p;
+						}
+				}
+			else if (diff < 0)
+				{
+					/* The ring buffer is full so drop the message rather than wait */
+					__atomic_add_fetch (& (aos_p -> aos_num_dropped), 1, __ATOMIC_RELAXED);
+					return 0;
+				}
+			else
+				{
+					pos = __atomic_load_n (& (aos_p -> aos_enqueue_pos), __ATOMIC_RELAXED);
+				}
+		}
+
+	res = snprintf (slot_p -> als_message_s, ASYNC_OUTPUT_STREAM_MESSAGE_SIZE, "%s:%d ", filename_s, line_number);
+
+	if ((res >= 0) && (res < ASYNC_OUTPUT_STREAM_MESSAGE_SIZE))
+		{
+			const int message_res = vsnprintf ((slot_p -> als_message_s) + res, ASYNC_OUTPUT_STREAM_MESSAGE_SIZE - res, message_s, args);
+
+			res = (message_res >= 0) ? res + message_res : message_res;
+		}
+
+	if (res >= ASYNC_OUTPUT_STREAM_MESSAGE_SIZE)
+		{
+			/* Keep the truncated message on its own line */
+			slot_p -> als_length = ASYNC_OUTPUT_STREAM_MESSAGE_SIZE - 1;
+			slot_p -> als_message_s [ASYNC_OUTPUT_STREAM_MESSAGE_SIZE - 2] = '\n';
+		}
+	else if (res >= 0)
+		{
+			slot_p -> als_length = (uint32) res;
+		}
+	else
+		{
+			/* The slot has been claimed so it still has to be handed on */
+			slot_p -> als_length = 0;
+		}
+
+	__atomic_store_n (& (slot_p -> als_sequence), pos + 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n (& (aos_p -> aos_writer_waiting_flag), __ATOMIC_SEQ_CST))
+		{
+			WakeWriter (aos_p);
+		}
+
+	return res;
+}
+
+
+static bool FlushAsyncStream (OutputStream *stream_p)
+{
+	AsyncOutputStream *aos_p = (AsyncOutputStream *) stream_p;
+	const uint64 target_pos = __atomic_load_n (& (aos_p -> aos_enqueue_pos), __ATOMIC_ACQUIRE);
+
+	WakeWriter (aos_p);
+
+	while (__atomic_load_n (& (aos_p -> aos_flushed_pos), __ATOMIC_ACQUIRE) < target_pos)
+		{
+			WaitMilliseconds (1);
+		}
+
+	return true;
+}
+
+
+static void *RunAsyncWriter (void *data_p)
+{
+	AsyncOutputStream *aos_p = (AsyncOutputStream *) data_p;
+	const uint64 mask = (aos_p -> aos_num_slots) - 1;
+	char *batch_s = (char *) AllocMemory (S_BATCH_SIZE);
+	uint64 num_reported_dropped = 0;
+	bool stop_flag = false;
+
+	if (!batch_s)
+		{
+			fprintf (stderr, "Failed to allocate batch buffer for async output stream\n");
+		}
+
+	while (!stop_flag)
+		{
+			size_t batch_length = 0;
+			uint64 num_dropped;
+			uint64 num_messages = 0;
+			AsyncLogSlot *slot_p;
+
+			/*
+			 * Read the stop flag before draining so that anything added before
+			 * the stream was freed gets written on the final pass.
+			 */
+			stop_flag = __atomic_load_n (& (aos_p -> aos_stop_flag), __ATOMIC_SEQ_CST);
+
+			slot_p = (aos_p -> aos_slots_p) + ((aos_p -> aos_dequeue_pos) & mask);
+
+			while (__atomic_load_n (& (slot_p -> als_sequence), __ATOMIC_ACQUIRE) == (aos_p -> aos_dequeue_pos) + 1)
+				{
+					if (batch_s)
+						{
+							if (batch_length + (slot_p -> als_length) > S_BATCH_SIZE)
+								{
+									WriteBatch (aos_p, batch_s, batch_length);
+									batch_length = 0;
+								}
+
+							memcpy (batch_s + batch_length, slot_p -> als_message_s, slot_p -> als_length);
+							batch_length += slot_p -> als_length;
+						}
+					else
+						{
+							fwrite (slot_p -> als_message_s, 1, slot_p -> als_length, aos_p -> aos_out_f);
+						}
+
+					__atomic_store_n (& (slot_p -> als_sequence), (aos_p -> aos_dequeue_pos) + (aos_p -> aos_num_slots), __ATOMIC_RELEASE);
+					++ (aos_p -> aos_dequeue_pos);
+					++ num_messages;
+
+					slot_p = (aos_p -> aos_slots_p) + ((aos_p -> aos_dequeue_pos) & mask);
+				}
+
+			num_dropped = __atomic_load_n (& (aos_p -> aos_num_dropped), __ATOMIC_RELAXED);
+
+			if (num_messages > 0)
+				{
+					if (batch_length > 0)
+						{
+							WriteBatch (aos_p, batch_s, batch_length);
+						}
+
+					if (num_dropped > num_reported_dropped)
+						{
+							fprintf (aos_p -> aos_out_f, "%s:%d %llu log messages were dropped\n", __FILE__, __LINE__, (unsigned long long) (num_dropped - num_reported_dropped));
+							num_reported_dropped = num_dropped;
+						}
+
+					fflush (aos_p -> aos_out_f);
+
+					__atomic_add_fetch (& (aos_p -> aos_num_written), num_messages, __ATOMIC_RELAXED);
+					__atomic_store_n (& (aos_p -> aos_flushed_pos), aos_p -> aos_dequeue_pos, __ATOMIC_RELEASE);
+				}
+			else if (!stop_flag)
+				{
+					/*
+					 * Tell the producers that we're about to sleep and check again
+					 * so that a message added in between isn't left waiting.
+					 */
+					pthread_mutex_lock (& (aos_p -> aos_mutex));
+					__atomic_store_n (& (aos_p -> aos_writer_waiting_flag), true, __ATOMIC_SEQ_CST);
+
+					if ((!HasPendingMessage (aos_p)) && (!__atomic_load_n (& (aos_p -> aos_stop_flag), __ATOMIC_SEQ_CST)))
+						{
+							bool woken_flag;
+							struct timespec until;
+
+							clock_gettime (CLOCK_REALTIME, &until);
+							until.tv_nsec += S_IDLE_WAIT_MS * 1000000L;
+
+							if (until.tv_nsec >= 1000000000L)
+								{
+									until.tv_sec += until.tv_nsec / 1000000000L;
+									until.tv_nsec %= 1000000000L;
+								}
+
+							woken_flag = (pthread_cond_timedwait (& (aos_p -> aos_cond), & (aos_p -> aos_mutex), &until) == 0);
+
+							__atomic_store_n (& (aos_p -> aos_writer_waiting_flag), false, __ATOMIC_SEQ_CST);
+							pthread_mutex_unlock (& (aos_p -> aos_mutex));
+
+							if (woken_flag && (!__atomic_load_n (& (aos_p -> aos_stop_flag), __ATOMIC_SEQ_CST)))
+								{
+									WaitMilliseconds (S_BATCH_WAIT_MS);
+								}
+						}
+					else
+						{
+							__atomic_store_n (& (aos_p -> aos_writer_waiting_flag), false, __ATOMIC_SEQ_CST);
+							pthread_mutex_unlock (& (aos_p -> aos_mutex));
+						}
+				}
+		}		/* while (!stop_flag) */
+
+	if (batch_s)
+		{
+			FreeMemory (batch_s);
+		}
+
+	return NULL;
+}
+
+
+static bool WriteBatch (AsyncOutputStream *stream_p, const char *batch_s, const size_t length)
+{
+	return (fwrite (batch_s, 1, length, stream_p -> aos_out_f) == length);
+}
+
+
+static bool HasPendingMessage (AsyncOutputStream *stream_p)
+{
+	const AsyncLogSlot *slot_p = (stream_p -> aos_slots_p) + ((stream_p -> aos_dequeue_pos) & ((stream_p -> aos_num_slots) - 1));
+
+	return (__atomic_load_n (& (slot_p -> als_sequence), __ATOMIC_SEQ_CST) == (stream_p -> aos_dequeue_pos) + 1);
+}
+
+
+static void WakeWriter (AsyncOutputStream *stream_p)
+{
+	pthread_mutex_lock (& (stream_p -> aos_mutex));
+	pthread_cond_signal (& (stream_p -> aos_cond));
+	pthread_mutex_unlock (& (stream_p -> aos_mutex));
+}
+
+
+static void WaitMilliseconds (const uint32 ms)
+{
+	struct timespec t;
+
+	t.tv_sec = ms / 1000;
+	t.tv_nsec = (ms % 1000) * 1000000L;
+
+	while ((nanosleep (&t, &t) != 0) && (errno == EINTR))
+		{
+		}
+}
+
+
+static uint32 GetNumSlots (const uint32 num_slots)
+{
+	uint32 n = 2;
+
+	if (num_slots == 0)
+		{
+			return ASYNC_OUTPUT_STREAM_DEFAULT_NUM_SLOTS;
+		}
+
+	while ((n < num_slots) && (n < 0x80000000))
+		{
+			n <<= 1;
+		}
+
+	return n;
+}
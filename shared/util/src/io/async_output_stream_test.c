@@ -0,0 +1,279 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * async_output_stream_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the AsyncOutputStream and a benchmark comparing how long
+ *  threads spend logging to a temporary file through it and through a
+ *  FileOutputStream.
+ *
+ *  Usage: async_output_stream_test [<number of threads> [<messages per thread> [<number of slots>]]]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "async_output_stream.h"
+#include "file_output_stream.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_THREADS (8)
+
+#define DEFAULT_NUM_MESSAGES (100000)
+
+#define MAX_NUM_THREADS (64)
+
+
+typedef struct LoggingThread
+{
+	OutputStream *lt_stream_p;
+
+	uint32 lt_index;
+
+	uint32 lt_num_messages;
+
+	double lt_time;
+} LoggingThread;
+
+
+static double GetTime (void)
+{
+	struct timespec t;
+
+	clock_gettime (CLOCK_MONOTONIC, &t);
+
+	return t.tv_sec + (t.tv_nsec / 1.0e9);
+}
+
+
+static int Print (OutputStream *stream_p, const uint32 level, const char *message_s, ...)
+{
+	int res;
+	va_list args;
+
+	va_start (args, message_s);
+	res = stream_p -> st_print_fn (stream_p, level, __FILE__, __LINE__, message_s, args);
+	va_end (args);
+
+	return res;
+}
+
+
+static uint32 CountLines (const char *filename_s, const char *match_s)
+{
+	uint32 num_lines = 0;
+	FILE *in_f = fopen (filename_s, "r");
+
+	if (in_f)
+		{
+			char line_s [1024];
+
+			while (fgets (line_s, sizeof (line_s), in_f))
+				{
+					if (strstr (line_s, match_s))
+						{
+							++ num_lines;
+						}
+				}
+
+			fclose (in_f);
+		}
+
+	return num_lines;
+}
+
+
+static void *RunLoggingThread (void *data_p)
+{
+	LoggingThread *thread_p = (LoggingThread *) data_p;
+	const double start = GetTime ();
+	uint32 i;
+
+	for (i = 0; i < thread_p -> lt_num_messages; ++ i)
+		{
+			Print (thread_p -> lt_stream_p, STM_LEVEL_INFO, "thread %u message %u of %u\n", thread_p -> lt_index, i, thread_p -> lt_num_messages);
+		}
+
+	thread_p -> lt_time = GetTime () - start;
+
+	return NULL;
+}
+
+
+/*
+ * Get the longest time that any of the threads spent logging
+ */
+static double RunLoggingThreads (OutputStream *stream_p, const uint32 num_threads, const uint32 num_messages)
+{
+	pthread_t threads [MAX_NUM_THREADS];
+	LoggingThread details [MAX_NUM_THREADS];
+	double max_time = 0.0;
+	uint32 i;
+
+	for (i = 0; i < num_threads; ++ i)
+		{
+			details [i].lt_stream_p = stream_p;
+			details [i].lt_index = i;
+			details [i].lt_num_messages = num_messages;
+			details [i].lt_time = 0.0;
+
+			pthread_create (threads + i, NULL, RunLoggingThread, details + i);
+		}
+
+	for (i = 0; i < num_threads; ++ i)
+		{
+			pthread_join (threads [i], NULL);
+
+			if (details [i].lt_time > max_time)
+				{
+					max_time = details [i].lt_time;
+				}
+		}
+
+	return max_time;
+}
+
+
+static void TestAsyncOutputStream (const char *filename_s)
+{
+	OutputStream *stream_p = AllocateAsyncOutputStream (filename_s, NULL, STM_LEVEL_INFO, 64);
+
+	if (stream_p)
+		{
+			AsyncOutputStreamStats stats;
+			char long_message_s [2 * ASYNC_OUTPUT_STREAM_MESSAGE_SIZE];
+
+			Print (stream_p, STM_LEVEL_WARNING, "first %s\n", "message");
+			Print (stream_p, STM_LEVEL_FINE, "filtered %s\n", "message");
+
+			memset (long_message_s, 'x', sizeof (long_message_s) - 1);
+			long_message_s [sizeof (long_message_s) - 1] = '\0';
+			Print (stream_p, STM_LEVEL_ALL, "long %s\n", long_message_s);
+
+			Check (FlushOutputStream (stream_p), "flush");
+			Check (CountLines (filename_s, "first message") == 1, "write a message");
+			Check (CountLines (filename_s, "filtered message") == 0, "filter by level");
+			Check (CountLines (filename_s, "long xxx") == 1, "truncate a long message onto one line");
+
+			GetAsyncOutputStreamStats (stream_p, &stats);
+			Check ((stats.aoss_num_written == 2) && (stats.aoss_num_filtered == 1) && (stats.aoss_num_dropped == 0), "count the messages");
+
+			FreeOutputStream (stream_p);
+		}
+	else
+		{
+			Check (false, "allocate stream");
+		}
+
+	/* A tiny ring buffer must drop rather than block or lose count */
+	stream_p = AllocateAsyncOutputStream (filename_s, NULL, STM_LEVEL_ALL, 2);
+
+	if (stream_p)
+		{
+			const uint32 num_threads = 4;
+			const uint32 num_messages = 10000;
+			AsyncOutputStreamStats stats;
+
+			RunLoggingThreads (stream_p, num_threads, num_messages);
+			FlushOutputStream (stream_p);
+
+			GetAsyncOutputStreamStats (stream_p, &stats);
+			Check (stats.aoss_num_written + stats.aoss_num_dropped == num_threads * num_messages, "account for every message when the buffer is full");
+
+			FreeOutputStream (stream_p);
+
+			Check (CountLines (filename_s, "thread ") == stats.aoss_num_written, "write every message that wasn't dropped");
+		}
+	else
+		{
+			Check (false, "allocate small stream");
+		}
+}
+
+
+static void RunBenchmark (const char *filename_s, const uint32 num_threads, const uint32 num_messages, const uint32 num_slots)
+{
+	OutputStream *stream_p = AllocateFileOutputStream (filename_s);
+
+	if (stream_p)
+		{
+			const double file_time = RunLoggingThreads (stream_p, num_threads, num_messages);
+			double async_time;
+			double drain_time;
+			AsyncOutputStreamStats stats;
+
+			FreeOutputStream (stream_p);
+			unlink (filename_s);
+
+			stream_p = AllocateAsyncOutputStream (filename_s, NULL, STM_LEVEL_ALL, num_slots);
+
+			if (stream_p)
+				{
+					async_time = RunLoggingThreads (stream_p, num_threads, num_messages);
+
+					drain_time = GetTime ();
+					FlushOutputStream (stream_p);
+					drain_time = GetTime () - drain_time;
+
+					GetAsyncOutputStreamStats (stream_p, &stats);
+
+					printf ("%u threads, %u messages each, %u slots\n", num_threads, num_messages, ((AsyncOutputStream *) stream_p) -> aos_num_slots);
+					printf ("FileOutputStream  %10.4f s\n", file_time);
+					printf ("AsyncOutputStream %10.4f s, then %.4f s to drain, %llu written, %llu dropped\n", async_time, drain_time, (unsigned long long) stats.aoss_num_written, (unsigned long long) stats.aoss_num_dropped);
+
+					FreeOutputStream (stream_p);
+				}
+		}
+}
+
+
+int main (int argc, char *argv [])
+{
+	uint32 num_threads = (argc > 1) ? (uint32) atoi (argv [1]) : DEFAULT_NUM_THREADS;
+	const uint32 num_messages = (argc > 2) ? (uint32) atoi (argv [2]) : DEFAULT_NUM_MESSAGES;
+	const uint32 num_slots = (argc > 3) ? (uint32) atoi (argv [3]) : 0;
+	char filename_s [] = "/tmp/async_output_stream_testXXXXXX";
+	const int fd = mkstemp (filename_s);
+
+	if (fd == -1)
+		{
+			puts ("FAILED: couldn't create temporary file");
+			return 1;
+		}
+
+	close (fd);
+
+	if (num_threads > MAX_NUM_THREADS)
+		{
+			num_threads = MAX_NUM_THREADS;
+		}
+
+	TestAsyncOutputStream (filename_s);
+	unlink (filename_s);
+
+	RunBenchmark (filename_s, num_threads, num_messages, num_slots);
+	unlink (filename_s);
+
+	return GetTestResult ();
+}
@@ -58,6 +58,7 @@ OutputStream *AllocateFileOutputStream (const char * const filename_s)
 
 			fos_p -> fos_stream.st_print_fn = PrintToFileStream;
 			fos_p -> fos_stream.st_flush_fn = FlushFileStream;
+			fos_p -> fos_stream.st_print_json_fn = NULL;
 			fos_p -> fos_stream.st_free_stream_fn = DeallocateFileOutputStream;
 
 			return ((OutputStream *) fos_p);
@@ -0,0 +1,447 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * json_output_stream.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jansson.h"
+
+#include "json_output_stream.h"
+#include "memory_allocations.h"
+
+
+#ifdef _WIN32
+	#include <windows.h>
+
+	#define INCREMENT_COUNTER(x) ((uint64) InterlockedIncrement64 ((LONG64 volatile *) (x)))
+	#define GET_UTC_TIME(t, tm) (gmtime_s ((tm), (t)) == 0)
+#else
+	#define INCREMENT_COUNTER(x) (__atomic_add_fetch ((x), 1, __ATOMIC_RELAXED))
+	#define GET_UTC_TIME(t, tm) (gmtime_r ((t), (tm)) != NULL)
+#endif
+
+
+/* Most lines fit in this without needing to go to the heap */
+#define S_LINE_STACK_SIZE (1024)
+
+
+/*
+ * A line of output that starts off in a stack buffer and
+ * moves to the heap if it outgrows it.
+ */
+typedef struct JSONLine
+{
+	char *jl_buffer_s;
+
+	size_t jl_length;
+
+	size_t jl_capacity;
+
+	bool jl_valid_flag;
+
+	char jl_stack_s [S_LINE_STACK_SIZE];
+} JSONLine;
+
+
+/*********************************************/
+/************ STATIC PROTOTYTPES *************/
+/*********************************************/
+
+static int PrintToJSONStream (OutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const char *message_s, va_list args);
+
+static int PrintJSONToJSONStream (OutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const struct json_t *json_p, const char *message_s, va_list args);
+
+static bool FlushJSONStream (OutputStream *stream_p);
+
+static int WriteJSONLine (JSONOutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const json_t *json_p, const char *message_s, va_list args);
+
+static void InitJSONLine (JSONLine *line_p);
+
+static void ClearJSONLine (JSONLine *line_p);
+
+static void AppendToJSONLine (JSONLine *line_p, const char *value_s, const size_t length);
+
+static void AppendStringToJSONLine (JSONLine *line_p, const char *value_s);
+
+static void AppendEscapedStringToJSONLine (JSONLine *line_p, const char *value_s);
+
+static void AppendTimeToJSONLine (JSONLine *line_p);
+
+static bool ShouldWritePayload (JSONOutputStream *stream_p, const size_t payload_size);
+
+
+OutputStream *AllocateJSONOutputStream (const char * const filename_s, FILE *default_f, const uint32 level, const uint32 max_payload_size, const uint32 payload_sample_rate)
+{
+	JSONOutputStream *jos_p = (JSONOutputStream *) AllocMemory (sizeof (JSONOutputStream));
+
+	if (jos_p)
+		{
+			jos_p -> jos_out_f = NULL;
+			jos_p -> jos_close_on_exit_flag = false;
+
+			if (filename_s)
+				{
+					/* Append so that restarting the server doesn't lose the existing log */
+					jos_p -> jos_out_f = fopen (filename_s, "a");
+				}
+
+			if (jos_p -> jos_out_f)
+				{
+					jos_p -> jos_close_on_exit_flag = true;
+				}
+			else
+				{
+					jos_p -> jos_out_f = default_f ? default_f : stdout;
+				}
+
+			jos_p -> jos_level = level;
+			jos_p -> jos_max_payload_size = max_payload_size;
+			jos_p -> jos_payload_sample_rate = payload_sample_rate;
+			jos_p -> jos_num_large_payloads = 0;
+
+			jos_p -> jos_stream.st_print_fn = PrintToJSONStream;
+			jos_p -> jos_stream.st_flush_fn = FlushJSONStream;
+			jos_p -> jos_stream.st_print_json_fn = PrintJSONToJSONStream;
+			jos_p -> jos_stream.st_free_stream_fn = DeallocateJSONOutputStream;
+
+			return (& (jos_p -> jos_stream));
+		}
+
+	return NULL;
+}
+
+
+void DeallocateJSONOutputStream (OutputStream *stream_p)
+{
+	JSONOutputStream *jos_p = (JSONOutputStream *) stream_p;
+
+	if (jos_p -> jos_close_on_exit_flag)
+		{
+			if (fclose (jos_p -> jos_out_f) != 0)
+				{
+					fprintf (stderr, "failed to close output stream\n");
+				}
+		}
+	else
+		{
+			fflush (jos_p -> jos_out_f);
+		}
+
+	FreeMemory (jos_p);
+}
+
+
+static int PrintToJSONStream (OutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const char *message_s, va_list args)
+{
+	return WriteJSONLine ((JSONOutputStream *) stream_p, level, filename_s, line_number, NULL, message_s, args);
+}
+
+
+static int PrintJSONToJSONStream (OutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const struct json_t *json_p, const char *message_s, va_list args)
+{
+	return WriteJSONLine ((JSONOutputStream *) stream_p, level, filename_s, line_number, json_p, message_s, args);
+}
+
+
+static bool FlushJSONStream (OutputStream *stream_p)
+{
+	return (fflush (((JSONOutputStream *) stream_p) -> jos_out_f) == 0);
+}
+
+
+static int WriteJSONLine (JSONOutputStream *stream_p, const uint32 level, const char * const filename_s, const int line_number, const json_t *json_p, const char *message_s, va_list args)
+{
+	JSONLine line;
+	char number_s [48];
+	char message_buffer_s [S_LINE_STACK_SIZE];
+	char *formatted_s = message_buffer_s;
+	const char *correlation_id_s;
+	va_list copied_args;
+	int res;
+
+	/* Check the level before doing any formatting */
+	if ((level != STM_LEVEL_ALL) && (level > stream_p -> jos_level))
+		{
+			return 0;
+		}
+
+	va_copy (copied_args, args);
+	res = vsnprintf (message_buffer_s, S_LINE_STACK_SIZE, message_s, copied_args);
+	va_end (copied_args);
+
+	if (res >= S_LINE_STACK_SIZE)
+		{
+			formatted_s = (char *) AllocMemory (res + 1);
+
+			if (formatted_s)
+				{
+					vsnprintf (formatted_s, res + 1, message_s, args);
+				}
+			else
+				{
+					/* Fall back to the truncated message */
+					formatted_s = message_buffer_s;
+				}
+		}
+	else if (res < 0)
+		{
+			*message_buffer_s = '\0';
+		}
+
+	InitJSONLine (&line);
+
+	AppendStringToJSONLine (&line, "{\"time\":\"");
+	AppendTimeToJSONLine (&line);
+
+	AppendStringToJSONLine (&line, "\",\"level\":\"");
+	AppendStringToJSONLine (&line, GetStreamLevelAsString (level));
+
+	AppendStringToJSONLine (&line, "\",\"file\":");
+	AppendEscapedStringToJSONLine (&line, filename_s ? filename_s : "");
+
+	snprintf (number_s, sizeof (number_s), ",\"line\":%d", line_number);
+	AppendStringToJSONLine (&line, number_s);
+
+	if ((correlation_id_s = GetLogCorrelationId ()) != NULL)
+		{
+			AppendStringToJSONLine (&line, ",\"correlation_id\":");
+			AppendEscapedStringToJSONLine (&line, correlation_id_s);
+		}
+
+	AppendStringToJSONLine (&line, ",\"message\":");
+	AppendEscapedStringToJSONLine (&line, formatted_s);
+
+	if (formatted_s != message_buffer_s)
+		{
+			FreeMemory (formatted_s);
+		}
+
+	if (json_p)
+		{
+			char *json_s = json_dumps (json_p, JSON_COMPACT | JSON_PRESERVE_ORDER | JSON_ENCODE_ANY);
+
+			if (json_s)
+				{
+					const size_t payload_size = strlen (json_s);
+
+					if (ShouldWritePayload (stream_p, payload_size))
+						{
+							AppendStringToJSONLine (&line, ",\"payload\":");
+							AppendToJSONLine (&line, json_s, payload_size);
+						}
+					else
+						{
+							snprintf (number_s, sizeof (number_s), ",\"payload_size\":%lu", (unsigned long) payload_size);
+							AppendStringToJSONLine (&line, number_s);
+						}
+
+					free (json_s);
+				}
+		}
+
+	AppendStringToJSONLine (&line, "}\n");
+
+	if (line.jl_valid_flag)
+		{
+			/* A single write keeps the line whole when several threads are logging */
+			res = (fwrite (line.jl_buffer_s, 1, line.jl_length, stream_p -> jos_out_f) == line.jl_length) ? (int) line.jl_length : -1;
+		}
+	else
+		{
+			res = -1;
+		}
+
+	ClearJSONLine (&line);
+
+	return res;
+}
+
+
+static bool ShouldWritePayload (JSONOutputStream *stream_p, const size_t payload_size)
+{
+	bool write_flag = true;
+
+	if ((stream_p -> jos_max_payload_size > 0) && (payload_size > stream_p -> jos_max_payload_size))
+		{
+			if (stream_p -> jos_payload_sample_rate > 0)
+				{
+					const uint64 count = INCREMENT_COUNTER (& (stream_p -> jos_num_large_payloads));
+
+					/* Write the first large payload and then every nth one after it */
+					write_flag = (((count - 1) % (stream_p -> jos_payload_sample_rate)) == 0);
+				}
+			else
+				{
+					write_flag = false;
+				}
+		}
+
+	return write_flag;
+}
+
+
+static void InitJSONLine (JSONLine *line_p)
+{
+	line_p -> jl_buffer_s = line_p -> jl_stack_s;
+	line_p -> jl_length = 0;
+	line_p -> jl_capacity = S_LINE_STACK_SIZE;
+	line_p -> jl_valid_flag = true;
+}
+
+
+static void ClearJSONLine (JSONLine *line_p)
+{
+	if (line_p -> jl_buffer_s != line_p -> jl_stack_s)
+		{
+			FreeMemory (line_p -> jl_buffer_s);
+		}
+
+	InitJSONLine (line_p);
+}
+
+
+static void AppendToJSONLine (JSONLine *line_p, const char *value_s, const size_t length)
+{
+	if (line_p -> jl_valid_flag)
+		{
+			if (line_p -> jl_length + length > line_p -> jl_capacity)
+				{
+					size_t new_capacity = (line_p -> jl_capacity) << 1;
+					char *new_buffer_s;
+
+					while (new_capacity < line_p -> jl_length + length)
+						{
+							new_capacity <<= 1;
+						}
+
+					new_buffer_s = (char *) AllocMemory (new_capacity);
+
+					if (new_buffer_s)
+						{
+							memcpy (new_buffer_s, line_p -> jl_buffer_s, line_p -> jl_length);
+
+							if (line_p -> jl_buffer_s != line_p -> jl_stack_s)
+								{
+									FreeMemory (line_p -> jl_buffer_s);
+								}
+
+							line_p -> jl_buffer_s = new_buffer_s;
+							line_p -> jl_capacity = new_capacity;
+						}
+					else
+						{
+							line_p -> jl_valid_flag = false;
+							return;
+						}
+				}
+
+			memcpy ((line_p -> jl_buffer_s) + (line_p -> jl_length), value_s, length);
+			line_p -> jl_length += length;
+		}
+}
+
+
+static void AppendStringToJSONLine (JSONLine *line_p, const char *value_s)
+{
+	AppendToJSONLine (line_p, value_s, strlen (value_s));
+}
+
+
+static void AppendEscapedStringToJSONLine (JSONLine *line_p, const char *value_s)
+{
+	const char *start_s = value_s;
+	const char *c_p = value_s;
+	size_t length = strlen (value_s);
+
+	/* Drop any trailing newlines as each message has a line of its own */
+	while ((length > 0) && ((value_s [length - 1] == '\n') || (value_s [length - 1] == '\r')))
+		{
+			-- length;
+		}
+
+	AppendToJSONLine (line_p, "\"", 1);
+
+	while (c_p < value_s + length)
+		{
+			const unsigned char c = (unsigned char) *c_p;
+
+			if ((c < 0x20) || (c == '"') || (c == '\\'))
+				{
+					char escaped_s [8];
+
+					AppendToJSONLine (line_p, start_s, c_p - start_s);
+
+					switch (c)
+						{
+							case '"':
+								AppendToJSONLine (line_p, "\\\"", 2);
+								break;
+
+							case '\\':
+								AppendToJSONLine (line_p, "\\\\", 2);
+								break;
+
+							case '\n':
+								AppendToJSONLine (line_p, "\\n", 2);
+								break;
+
+							case '\r':
+								AppendToJSONLine (line_p, "\\r", 2);
+								break;
+
+							case '\t':
+								AppendToJSONLine (line_p, "\\t", 2);
+								break;
+
+							default:
+								snprintf (escaped_s, sizeof (escaped_s), "\\u%04x", c);
+								AppendToJSONLine (line_p, escaped_s, 6);
+								break;
+						}
+
+					start_s = c_p + 1;
+				}
+
+			++ c_p;
+		}
+
+	AppendToJSONLine (line_p, start_s, c_p - start_s);
+	AppendToJSONLine (line_p, "\"", 1);
+}
+
+
+static void AppendTimeToJSONLine (JSONLine *line_p)
+{
+	struct timespec now;
+	struct tm utc;
+	char time_s [32];
+
+	if ((timespec_get (&now, TIME_UTC) == TIME_UTC) && (GET_UTC_TIME (& (now.tv_sec), &utc)))
+		{
+			const size_t length = strftime (time_s, sizeof (time_s), "%Y-%m-%dT%H:%M:%S", &utc);
+
+			snprintf (time_s + length, sizeof (time_s) - length, ".%03ldZ", (long) (now.tv_nsec / 1000000));
+			AppendStringToJSONLine (line_p, time_s);
+		}
+}
@@ -0,0 +1,371 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * json_output_stream_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the JSONOutputStream. Several threads log under their own
+ *  correlation ids and the output file is then parsed back to check that
+ *  every line is a valid JSON object with the right id, that large payloads
+ *  are sampled and how its size compares with the plain text output.
+ *
+ *  Usage: json_output_stream_test [<number of threads> [<messages per thread>]]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "jansson.h"
+
+#include "json_output_stream.h"
+#include "file_output_stream.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_THREADS (4)
+
+#define DEFAULT_NUM_MESSAGES (1000)
+
+#define MAX_NUM_THREADS (64)
+
+/* Payloads bigger than this are sampled */
+#define MAX_PAYLOAD_SIZE (256)
+
+/* Write one in this many of the large payloads */
+#define PAYLOAD_SAMPLE_RATE (10)
+
+/* Every this many messages has a payload and every other one of those is large */
+#define PAYLOAD_INTERVAL (10)
+
+
+typedef struct LoggingThread
+{
+	OutputStream *lt_stream_p;
+
+	uint32 lt_index;
+
+	uint32 lt_num_messages;
+
+	json_t *lt_small_payload_p;
+
+	json_t *lt_large_payload_p;
+
+	/* Print the payloads as indented text as PrintJSONToLog does for plain streams */
+	bool lt_text_flag;
+} LoggingThread;
+
+
+static int Print (OutputStream *stream_p, const uint32 level, const json_t *json_p, const char *message_s, ...)
+{
+	int res;
+	va_list args;
+
+	va_start (args, message_s);
+
+	if (stream_p -> st_print_json_fn)
+		{
+			res = stream_p -> st_print_json_fn (stream_p, level, __FILE__, __LINE__, json_p, message_s, args);
+		}
+	else
+		{
+			res = stream_p -> st_print_fn (stream_p, level, __FILE__, __LINE__, message_s, args);
+		}
+
+	va_end (args);
+
+	return res;
+}
+
+
+static void PrintPayloadAsText (OutputStream *stream_p, const json_t *json_p)
+{
+	char *json_s = json_dumps (json_p, JSON_INDENT (2) | JSON_PRESERVE_ORDER);
+
+	if (json_s)
+		{
+			Print (stream_p, STM_LEVEL_INFO, NULL, "%s\n", json_s);
+			free (json_s);
+		}
+}
+
+
+static void *RunLoggingThread (void *data_p)
+{
+	LoggingThread *thread_p = (LoggingThread *) data_p;
+	char id_s [LOG_CORRELATION_ID_BUFFER_SIZE];
+	uint32 i;
+
+	snprintf (id_s, sizeof (id_s), "request-%u", thread_p -> lt_index);
+	SetLogCorrelationId (id_s);
+
+	for (i = 0; i < thread_p -> lt_num_messages; ++ i)
+		{
+			const json_t *payload_p = NULL;
+
+			if ((i % PAYLOAD_INTERVAL) == 0)
+				{
+					payload_p = ((i / PAYLOAD_INTERVAL) % 2) ? thread_p -> lt_large_payload_p : thread_p -> lt_small_payload_p;
+				}
+
+			if (thread_p -> lt_text_flag)
+				{
+					Print (thread_p -> lt_stream_p, STM_LEVEL_INFO, NULL, "thread %u message %u with \"quotes\"\tand a tab\n", thread_p -> lt_index, i);
+
+					if (payload_p)
+						{
+							PrintPayloadAsText (thread_p -> lt_stream_p, payload_p);
+						}
+				}
+			else
+				{
+					Print (thread_p -> lt_stream_p, STM_LEVEL_INFO, payload_p, "thread %u message %u with \"quotes\"\tand a tab\n", thread_p -> lt_index, i);
+				}
+
+			/* This should be filtered out */
+			Print (thread_p -> lt_stream_p, STM_LEVEL_FINEST, NULL, "thread %u finest message %u\n", thread_p -> lt_index, i);
+		}
+
+	SetLogCorrelationId (NULL);
+
+	return NULL;
+}
+
+
+static void RunLoggingThreads (OutputStream *stream_p, const uint32 num_threads, const uint32 num_messages, json_t *small_payload_p, json_t *large_payload_p, const bool text_flag)
+{
+	pthread_t threads [MAX_NUM_THREADS];
+	LoggingThread details [MAX_NUM_THREADS];
+	uint32 i;
+
+	for (i = 0; i < num_threads; ++ i)
+		{
+			details [i].lt_stream_p = stream_p;
+			details [i].lt_index = i;
+			details [i].lt_num_messages = num_messages;
+			details [i].lt_small_payload_p = small_payload_p;
+			details [i].lt_large_payload_p = large_payload_p;
+			details [i].lt_text_flag = text_flag;
+
+			pthread_create (threads + i, NULL, RunLoggingThread, details + i);
+		}
+
+	for (i = 0; i < num_threads; ++ i)
+		{
+			pthread_join (threads [i], NULL);
+		}
+}
+
+
+static long GetFileSize (const char *filename_s)
+{
+	struct stat st;
+
+	return (stat (filename_s, &st) == 0) ? (long) st.st_size : -1;
+}
+
+
+static void CheckOutput (const char *filename_s, const uint32 num_threads, const uint32 num_messages)
+{
+	FILE *in_f = fopen (filename_s, "r");
+
+	if (in_f)
+		{
+			size_t line_size = 1 << 16;
+			char *line_s = (char *) malloc (line_size);
+			uint32 num_lines = 0;
+			uint32 num_invalid = 0;
+			uint32 num_wrong_ids = 0;
+			uint32 num_large_written = 0;
+			uint32 num_large_sampled = 0;
+			uint32 num_small_written = 0;
+
+			while (fgets (line_s, line_size, in_f))
+				{
+					json_error_t error;
+					json_t *line_p = json_loads (line_s, 0, &error);
+
+					++ num_lines;
+
+					if (line_p && json_is_object (line_p))
+						{
+							const char *id_s = json_string_value (json_object_get (line_p, "correlation_id"));
+							const char *message_s = json_string_value (json_object_get (line_p, "message"));
+							const json_t *payload_p = json_object_get (line_p, "payload");
+							unsigned int thread_index;
+							unsigned int message_index;
+							char expected_id_s [LOG_CORRELATION_ID_BUFFER_SIZE];
+
+							if (message_s && id_s && (sscanf (message_s, "thread %u message %u", &thread_index, &message_index) == 2))
+								{
+									snprintf (expected_id_s, sizeof (expected_id_s), "request-%u", thread_index);
+
+									if (strcmp (id_s, expected_id_s) != 0)
+										{
+											++ num_wrong_ids;
+										}
+								}
+							else
+								{
+									++ num_wrong_ids;
+								}
+
+							if (payload_p)
+								{
+									if (json_object_get (payload_p, "large"))
+										{
+											++ num_large_written;
+										}
+									else
+										{
+											++ num_small_written;
+										}
+								}
+							else if (json_object_get (line_p, "payload_size"))
+								{
+									++ num_large_sampled;
+								}
+
+							json_decref (line_p);
+						}
+					else
+						{
+							++ num_invalid;
+						}
+				}
+
+			fclose (in_f);
+			free (line_s);
+
+			{
+				const uint32 num_payloads = (num_messages + PAYLOAD_INTERVAL - 1) / PAYLOAD_INTERVAL;
+				const uint32 num_large = num_threads * (num_payloads / 2);
+				const uint32 num_small = num_threads * (num_payloads - (num_payloads / 2));
+
+				Check (num_lines == num_threads * num_messages, "write one line per message and filter by level");
+				Check (num_invalid == 0, "write every line as valid JSON");
+				Check (num_wrong_ids == 0, "tag every line with its thread's correlation id");
+				Check (num_small_written == num_small, "write every small payload");
+				Check (num_large_written + num_large_sampled == num_large, "account for every large payload");
+				Check (num_large_written == (num_large + PAYLOAD_SAMPLE_RATE - 1) / PAYLOAD_SAMPLE_RATE, "sample the large payloads");
+			}
+		}
+	else
+		{
+			Check (false, "open output file");
+		}
+}
+
+
+static json_t *GetPayload (const uint32 num_entries, const bool large_flag)
+{
+	json_t *payload_p = json_object ();
+
+	if (payload_p)
+		{
+			json_t *values_p = json_array ();
+
+			if (values_p)
+				{
+					uint32 i;
+
+					for (i = 0; i < num_entries; ++ i)
+						{
+							json_t *value_p = json_object ();
+
+							json_object_set_new (value_p, "index", json_integer (i));
+							json_object_set_new (value_p, "name", json_string ("a value"));
+							json_array_append_new (values_p, value_p);
+						}
+
+					json_object_set_new (payload_p, "values", values_p);
+				}
+
+			if (large_flag)
+				{
+					json_object_set_new (payload_p, "large", json_true ());
+				}
+		}
+
+	return payload_p;
+}
+
+
+int main (int argc, char *argv [])
+{
+	uint32 num_threads = (argc > 1) ? (uint32) atoi (argv [1]) : DEFAULT_NUM_THREADS;
+	const uint32 num_messages = (argc > 2) ? (uint32) atoi (argv [2]) : DEFAULT_NUM_MESSAGES;
+	char filename_s [] = "/tmp/json_output_stream_testXXXXXX";
+	const int fd = mkstemp (filename_s);
+	json_t *small_payload_p = GetPayload (2, false);
+	json_t *large_payload_p = GetPayload (100, true);
+	OutputStream *stream_p;
+
+	if (fd == -1)
+		{
+			puts ("FAILED: couldn't create temporary file");
+			return 1;
+		}
+
+	close (fd);
+
+	if (num_threads > MAX_NUM_THREADS)
+		{
+			num_threads = MAX_NUM_THREADS;
+		}
+
+	stream_p = AllocateJSONOutputStream (filename_s, NULL, STM_LEVEL_INFO, MAX_PAYLOAD_SIZE, PAYLOAD_SAMPLE_RATE);
+
+	if (stream_p)
+		{
+			long json_size;
+
+			RunLoggingThreads (stream_p, num_threads, num_messages, small_payload_p, large_payload_p, false);
+			FreeOutputStream (stream_p);
+
+			json_size = GetFileSize (filename_s);
+			CheckOutput (filename_s, num_threads, num_messages);
+
+			/* Compare against the plain text output with indented payloads */
+			stream_p = AllocateFileOutputStream (filename_s);
+
+			if (stream_p)
+				{
+					RunLoggingThreads (stream_p, num_threads, num_messages, small_payload_p, large_payload_p, true);
+					FreeOutputStream (stream_p);
+
+					printf ("%u threads, %u messages each\n", num_threads, num_messages);
+					printf ("FileOutputStream with indented payloads %10ld bytes\n", GetFileSize (filename_s));
+					printf ("JSONOutputStream                        %10ld bytes\n", json_size);
+				}
+		}
+	else
+		{
+			Check (false, "allocate stream");
+		}
+
+	unlink (filename_s);
+
+	json_decref (small_payload_p);
+	json_decref (large_payload_p);
+
+	return GetTestResult ();
+}
@@ -14,14 +14,28 @@
 ** limitations under the License.
 */
 #include <stdarg.h>
+#include <string.h>
 
 #include "streams.h"
 #include "file_output_stream.h"
 
 
+#ifdef _MSC_VER
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
+
 static OutputStream *s_log_stream_p = NULL;
 static OutputStream *s_error_stream_p = NULL;
 
+static THREAD_LOCAL char s_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE] = { '\0' };
+
+
+static const char * const S_LEVEL_NAMES_SS [] = { "none", "severe", "warning", "info", "fine", "finer", "finest", "all", NULL };
+static const uint32 S_LEVELS [] = { STM_LEVEL_NONE, STM_LEVEL_SEVERE, STM_LEVEL_WARNING, STM_LEVEL_INFO, STM_LEVEL_FINE, STM_LEVEL_FINER, STM_LEVEL_FINEST, STM_LEVEL_ALL };
+
 
 
 bool InitDefaultOutputStream (void)
@@ -193,7 +207,7 @@ int PrintLogVarArgs (const uint32 level, const char * const filename_s, const in
 
 	if (s_log_stream_p)
 		{
-			result = s_log_stream_p -> st_print_fn (s_error_stream_p, level, filename_s, line_number, message_s, args);
+			result = s_log_stream_p -> st_print_fn (s_log_stream_p, level, filename_s, line_number, message_s, args);
 		}
 	else
 		{
@@ -205,6 +219,23 @@ int PrintLogVarArgs (const uint32 level, const char * const filename_s, const in
 
 
 
+OutputStream *GetLogOutput (void)
+{
+	return s_log_stream_p;
+}
+
+
+OutputStream *GetErrorsOutput (void)
+{
+	return s_error_stream_p;
+}
+
+
+bool FlushOutputStream (OutputStream *stream_p)
+{
+	return stream_p -> st_flush_fn (stream_p);
+}
+
 
 bool FlushLog (void)
 {
@@ -231,3 +262,56 @@ bool FlushErrors (void)
 
 	return success_flag;
 }
+
+
+bool GetStreamLevelFromString (const char * const level_s, uint32 *level_p)
+{
+	uint32 i;
+
+	for (i = 0; S_LEVEL_NAMES_SS [i]; ++ i)
+		{
+			if (strcmp (level_s, S_LEVEL_NAMES_SS [i]) == 0)
+				{
+					*level_p = S_LEVELS [i];
+					return true;
+				}
+		}
+
+	return false;
+}
+
+
+const char *GetStreamLevelAsString (const uint32 level)
+{
+	uint32 i;
+
+	for (i = 0; S_LEVEL_NAMES_SS [i]; ++ i)
+		{
+			if (S_LEVELS [i] == level)
+				{
+					return S_LEVEL_NAMES_SS [i];
+				}
+		}
+
+	return "all";
+}
+
+
+void SetLogCorrelationId (const char * const id_s)
+{
+	if (id_s)
+		{
+			strncpy (s_correlation_id_s, id_s, LOG_CORRELATION_ID_BUFFER_SIZE - 1);
+			s_correlation_id_s [LOG_CORRELATION_ID_BUFFER_SIZE - 1] = '\0';
+		}
+	else
+		{
+			*s_correlation_id_s = '\0';
+		}
+}
+
+
+const char *GetLogCorrelationId (void)
+{
+	return (*s_correlation_id_s != '\0') ? s_correlation_id_s : NULL;
+}
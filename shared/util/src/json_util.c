@@ -1025,21 +1025,33 @@ int PrintJSONToErrors (const uint32 level, const char *filename_s, const int lin
 	int result = -1;
 	va_list args;
 
-	va_start (args, message_s);
+	OutputStream *stream_p = GetErrorsOutput ();
 
-	result = PrintErrorsVarArgs (level, filename_s, line_number, message_s, args);
+	va_start (args, message_s);
 
-	if (json_p)
+	if (stream_p && (stream_p -> st_print_json_fn))
+		{
+			/* Structured streams write the message and payload as a single entry */
+			result = stream_p -> st_print_json_fn (stream_p, level, filename_s, line_number, json_p, message_s, args);
+		}
+	else
 		{
-			char *json_s = json_dumps (json_p, JSON_INDENT (2) | JSON_PRESERVE_ORDER);
+			result = PrintErrorsVarArgs (level, filename_s, line_number, message_s, args);
 
-			if (json_s)
+			if (json_p)
 				{
-					PrintErrors (level, filename_s, line_number, "%s", json_s);
-					free (json_s);
+					char *json_s = json_dumps (json_p, JSON_INDENT (2) | JSON_PRESERVE_ORDER);
+
+					if (json_s)
+						{
+							PrintErrors (level, filename_s, line_number, "%s", json_s);
+							free (json_s);
+						}
 				}
 		}
 
+	va_end (args);
+
 	return result;
 }
 
@@ -1049,21 +1061,33 @@ int PrintJSONToLog (const uint32 level, const char *filename_s, const int line_n
 	int result = -1;
 	va_list args;
 
-	va_start (args, message_s);
+	OutputStream *stream_p = GetLogOutput ();
 
-	result = PrintLogVarArgs (level, filename_s, line_number, message_s, args);
+	va_start (args, message_s);
 
-	if (json_p)
+	if (stream_p && (stream_p -> st_print_json_fn))
+		{
+			/* Structured streams write the message and payload as a single entry */
+			result = stream_p -> st_print_json_fn (stream_p, level, filename_s, line_number, json_p, message_s, args);
+		}
+	else
 		{
-			char *json_s = json_dumps (json_p, JSON_INDENT (2) | JSON_PRESERVE_ORDER);
+			result = PrintLogVarArgs (level, filename_s, line_number, message_s, args);
 
-			if (json_s)
+			if (json_p)
 				{
-					PrintLog (level, filename_s, line_number, "%s", json_s);
-					free (json_s);
+					char *json_s = json_dumps (json_p, JSON_INDENT (2) | JSON_PRESERVE_ORDER);
+
+					if (json_s)
+						{
+							PrintLog (level, filename_s, line_number, "%s", json_s);
+							free (json_s);
+						}
 				}
 		}
 
+	va_end (args);
+
 	return result;
 }
 
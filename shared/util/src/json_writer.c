@@ -0,0 +1,680 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * json_writer.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "json_writer.h"
+#include "memory_allocations.h"
+#include "streams.h"
+
+
+/* The number of nested objects and arrays to allow for before growing */
+#define S_INITIAL_MAX_DEPTH (16)
+
+
+/*
+ * An object or array that is being written.
+ */
+typedef struct JSONWriterLevel
+{
+	bool jwl_object_flag;
+
+	/* For an object, has a key been written that still needs its value? */
+	bool jwl_key_flag;
+
+	uint32 jwl_num_entries;
+} JSONWriterLevel;
+
+
+struct JSONWriter
+{
+	JSONWriterSink jw_sink_fn;
+
+	void *jw_sink_data_p;
+
+	size_t jw_flags;
+
+	char *jw_chunk_p;
+
+	size_t jw_chunk_size;
+
+	size_t jw_chunk_length;
+
+	JSONWriterLevel *jw_levels_p;
+
+	uint32 jw_depth;
+
+	uint32 jw_max_depth;
+
+	/* Has the top-level value been started? */
+	bool jw_started_flag;
+
+	/* Once anything has gone wrong, the output can't be trusted */
+	bool jw_failed_flag;
+};
+
+
+static bool WriteToJSONWriter (JSONWriter *writer_p, const char *data_s, const size_t size);
+
+static int JSONWriterDumpCallback (const char *data_s, size_t size, void *writer_p);
+
+static bool StartJSONWriterValue (JSONWriter *writer_p);
+
+static bool PushJSONWriterLevel (JSONWriter *writer_p, const bool object_flag);
+
+static bool PopJSONWriterLevel (JSONWriter *writer_p, const bool object_flag);
+
+static bool WriteEscapedString (JSONWriter *writer_p, const char *value_s);
+
+static int32 GetUTF8Codepoint (const unsigned char *value_p, size_t *length_p);
+
+static bool SetJSONWriterFailed (JSONWriter *writer_p, const char *reason_s);
+
+
+
+JSONWriter *AllocateJSONWriter (JSONWriterSink sink_fn, void *sink_data_p, const size_t flags, const size_t chunk_size)
+{
+	JSONWriter *writer_p = (JSONWriter *) AllocMemory (sizeof (JSONWriter));
+
+	if (writer_p)
+		{
+			memset (writer_p, 0, sizeof (JSONWriter));
+
+			writer_p -> jw_chunk_size = (chunk_size > 0) ? chunk_size : JSON_WRITER_DEFAULT_CHUNK_SIZE;
+			writer_p -> jw_chunk_p = (char *) AllocMemory (writer_p -> jw_chunk_size);
+
+			if (writer_p -> jw_chunk_p)
+				{
+					writer_p -> jw_levels_p = (JSONWriterLevel *) AllocMemoryArray (S_INITIAL_MAX_DEPTH, sizeof (JSONWriterLevel));
+
+					if (writer_p -> jw_levels_p)
+						{
+							writer_p -> jw_max_depth = S_INITIAL_MAX_DEPTH;
+							writer_p -> jw_sink_fn = sink_fn;
+							writer_p -> jw_sink_data_p = sink_data_p;
+
+							if (JSON_INDENT (flags) != 0)
+								{
+									PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "JSONWriter doesn't support JSON_INDENT, it will be ignored");
+								}
+
+							/*
+							 * Any value can be written at any level so JSON_ENCODE_ANY is always
+							 * needed when handing jansson values to json_dump_callback ().
+							 */
+							writer_p -> jw_flags = (flags & ~ ((size_t) JSON_INDENT (0x1F))) | JSON_ENCODE_ANY;
+
+							return writer_p;
+						}
+
+					FreeMemory (writer_p -> jw_chunk_p);
+				}
+
+			FreeMemory (writer_p);
+		}
+
+	PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate JSONWriter");
+
+	return NULL;
+}
+
+
+void FreeJSONWriter (JSONWriter *writer_p)
+{
+	FreeMemory (writer_p -> jw_levels_p);
+	FreeMemory (writer_p -> jw_chunk_p);
+	FreeMemory (writer_p);
+}
+
+
+bool FlushJSONWriter (JSONWriter *writer_p)
+{
+	if ((writer_p -> jw_chunk_length > 0) && (!writer_p -> jw_failed_flag))
+		{
+			if (writer_p -> jw_sink_fn (writer_p -> jw_chunk_p, writer_p -> jw_chunk_length, writer_p -> jw_sink_data_p) == 0)
+				{
+					writer_p -> jw_chunk_length = 0;
+				}
+			else
+				{
+					SetJSONWriterFailed (writer_p, "sink failed");
+				}
+		}
+
+	return !writer_p -> jw_failed_flag;
+}
+
+
+bool IsJSONWriterComplete (const JSONWriter *writer_p)
+{
+	return ((writer_p -> jw_started_flag) && (writer_p -> jw_depth == 0) && (!writer_p -> jw_failed_flag));
+}
+
+
+bool OpenJSONWriterObject (JSONWriter *writer_p)
+{
+	return (StartJSONWriterValue (writer_p) && WriteToJSONWriter (writer_p, "{", 1) && PushJSONWriterLevel (writer_p, true));
+}
+
+
+bool CloseJSONWriterObject (JSONWriter *writer_p)
+{
+	return (PopJSONWriterLevel (writer_p, true) && WriteToJSONWriter (writer_p, "}", 1));
+}
+
+
+bool OpenJSONWriterArray (JSONWriter *writer_p)
+{
+	return (StartJSONWriterValue (writer_p) && WriteToJSONWriter (writer_p, "[", 1) && PushJSONWriterLevel (writer_p, false));
+}
+
+
+bool CloseJSONWriterArray (JSONWriter *writer_p)
+{
+	return (PopJSONWriterLevel (writer_p, false) && WriteToJSONWriter (writer_p, "]", 1));
+}
+
+
+bool AddKeyToJSONWriter (JSONWriter *writer_p, const char *key_s)
+{
+	JSONWriterLevel *level_p;
+
+	if (writer_p -> jw_failed_flag)
+		{
+			return false;
+		}
+
+	if (writer_p -> jw_depth == 0)
+		{
+			return SetJSONWriterFailed (writer_p, "key written outside of an object");
+		}
+
+	level_p = (writer_p -> jw_levels_p) + (writer_p -> jw_depth - 1);
+
+	if ((!level_p -> jwl_object_flag) || (level_p -> jwl_key_flag))
+		{
+			return SetJSONWriterFailed (writer_p, "key written where a value was expected");
+		}
+
+	if (!key_s)
+		{
+			return SetJSONWriterFailed (writer_p, "NULL key");
+		}
+
+	/* Use the same separators as jansson */
+	if (level_p -> jwl_num_entries > 0)
+		{
+			if ((writer_p -> jw_flags) & JSON_COMPACT)
+				{
+					WriteToJSONWriter (writer_p, ",", 1);
+				}
+			else
+				{
+					WriteToJSONWriter (writer_p, ", ", 2);
+				}
+		}
+
+	if (WriteEscapedString (writer_p, key_s))
+		{
+			if ((writer_p -> jw_flags) & JSON_COMPACT)
+				{
+					WriteToJSONWriter (writer_p, ":", 1);
+				}
+			else
+				{
+					WriteToJSONWriter (writer_p, ": ", 2);
+				}
+
+			level_p -> jwl_key_flag = true;
+			++ (level_p -> jwl_num_entries);
+		}
+
+	return !writer_p -> jw_failed_flag;
+}
+
+
+bool AddStringToJSONWriter (JSONWriter *writer_p, const char *value_s)
+{
+	if (!value_s)
+		{
+			return SetJSONWriterFailed (writer_p, "NULL string");
+		}
+
+	return (StartJSONWriterValue (writer_p) && WriteEscapedString (writer_p, value_s));
+}
+
+
+bool AddIntegerToJSONWriter (JSONWriter *writer_p, const json_int_t value)
+{
+	if (StartJSONWriterValue (writer_p))
+		{
+			char buffer_s [32];
+			const int length = snprintf (buffer_s, sizeof (buffer_s), "%" JSON_INTEGER_FORMAT, value);
+
+			if ((length > 0) && ((size_t) length < sizeof (buffer_s)))
+				{
+					return WriteToJSONWriter (writer_p, buffer_s, length);
+				}
+
+			return SetJSONWriterFailed (writer_p, "failed to format integer");
+		}
+
+	return false;
+}
+
+
+bool AddRealToJSONWriter (JSONWriter *writer_p, const double value)
+{
+	/*
+	 * Let jansson format the value so that the precision and the
+	 * trailing ".0" for whole numbers are the same as json_dumps ().
+	 */
+	json_t *value_p = json_real (value);
+
+	if (value_p)
+		{
+			const bool success_flag = AddJSONToJSONWriter (writer_p, value_p);
+
+			json_decref (value_p);
+
+			return success_flag;
+		}
+
+	return SetJSONWriterFailed (writer_p, "non-finite real");
+}
+
+
+bool AddBooleanToJSONWriter (JSONWriter *writer_p, const bool value)
+{
+	return (StartJSONWriterValue (writer_p) && (value ? WriteToJSONWriter (writer_p, "true", 4) : WriteToJSONWriter (writer_p, "false", 5)));
+}
+
+
+bool AddNullToJSONWriter (JSONWriter *writer_p)
+{
+	return (StartJSONWriterValue (writer_p) && WriteToJSONWriter (writer_p, "null", 4));
+}
+
+
+bool AddJSONToJSONWriter (JSONWriter *writer_p, const json_t *value_p)
+{
+	if (!value_p)
+		{
+			return SetJSONWriterFailed (writer_p, "NULL json value");
+		}
+
+	if (StartJSONWriterValue (writer_p))
+		{
+			if (json_dump_callback (value_p, JSONWriterDumpCallback, writer_p, writer_p -> jw_flags) != 0)
+				{
+					SetJSONWriterFailed (writer_p, "failed to serialise json value");
+				}
+		}
+
+	return !writer_p -> jw_failed_flag;
+}
+
+
+int ByteBufferJSONWriterSink (const char *data_s, size_t size, void *buffer_p)
+{
+	return AppendToByteBuffer ((ByteBuffer *) buffer_p, data_s, size) ? 0 : -1;
+}
+
+
+/*
+ * Add some output to the chunk, passing the chunk to the sink
+ * whenever it fills up.
+ */
+static bool WriteToJSONWriter (JSONWriter *writer_p, const char *data_s, const size_t size)
+{
+	if (writer_p -> jw_failed_flag)
+		{
+			return false;
+		}
+
+	if (size > (writer_p -> jw_chunk_size) - (writer_p -> jw_chunk_length))
+		{
+			if (!FlushJSONWriter (writer_p))
+				{
+					return false;
+				}
+
+			/* There's no point copying data that would fill the chunk on its own */
+			if (size >= writer_p -> jw_chunk_size)
+				{
+					if (writer_p -> jw_sink_fn (data_s, size, writer_p -> jw_sink_data_p) != 0)
+						{
+							return SetJSONWriterFailed (writer_p, "sink failed");
+						}
+
+					return true;
+				}
+		}
+
+	memcpy ((writer_p -> jw_chunk_p) + (writer_p -> jw_chunk_length), data_s, size);
+	writer_p -> jw_chunk_length += size;
+
+	return true;
+}
+
+
+static int JSONWriterDumpCallback (const char *data_s, size_t size, void *writer_p)
+{
+	return WriteToJSONWriter ((JSONWriter *) writer_p, data_s, size) ? 0 : -1;
+}
+
+
+/*
+ * Check that a value is allowed at the current position and write any
+ * separator that is needed before it.
+ */
+static bool StartJSONWriterValue (JSONWriter *writer_p)
+{
+	if (writer_p -> jw_failed_flag)
+		{
+			return false;
+		}
+
+	if (writer_p -> jw_depth == 0)
+		{
+			if (writer_p -> jw_started_flag)
+				{
+					return SetJSONWriterFailed (writer_p, "top-level value has already been written");
+				}
+
+			writer_p -> jw_started_flag = true;
+		}
+	else
+		{
+			JSONWriterLevel *level_p = (writer_p -> jw_levels_p) + (writer_p -> jw_depth - 1);
+
+			if (level_p -> jwl_object_flag)
+				{
+					if (!level_p -> jwl_key_flag)
+						{
+							return SetJSONWriterFailed (writer_p, "object value written without a key");
+						}
+
+					level_p -> jwl_key_flag = false;
+				}
+			else
+				{
+					if (level_p -> jwl_num_entries > 0)
+						{
+							if ((writer_p -> jw_flags) & JSON_COMPACT)
+								{
+									WriteToJSONWriter (writer_p, ",", 1);
+								}
+							else
+								{
+									WriteToJSONWriter (writer_p, ", ", 2);
+								}
+						}
+
+					++ (level_p -> jwl_num_entries);
+				}
+		}
+
+	return !writer_p -> jw_failed_flag;
+}
+
+
+static bool PushJSONWriterLevel (JSONWriter *writer_p, const bool object_flag)
+{
+	JSONWriterLevel *level_p;
+
+	if (writer_p -> jw_depth == writer_p -> jw_max_depth)
+		{
+			const uint32 new_max = (writer_p -> jw_max_depth) << 1;
+			JSONWriterLevel *levels_p = (JSONWriterLevel *) ReallocMemory (writer_p -> jw_levels_p, new_max * sizeof (JSONWriterLevel), (writer_p -> jw_max_depth) * sizeof (JSONWriterLevel));
+
+			if (!levels_p)
+				{
+					return SetJSONWriterFailed (writer_p, "failed to allocate nesting level");
+				}
+
+			writer_p -> jw_levels_p = levels_p;
+			writer_p -> jw_max_depth = new_max;
+		}
+
+	level_p = (writer_p -> jw_levels_p) + (writer_p -> jw_depth);
+	level_p -> jwl_object_flag = object_flag;
+	level_p -> jwl_key_flag = false;
+	level_p -> jwl_num_entries = 0;
+
+	++ (writer_p -> jw_depth);
+
+	return true;
+}
+
+
+static bool PopJSONWriterLevel (JSONWriter *writer_p, const bool object_flag)
+{
+	const JSONWriterLevel *level_p;
+
+	if (writer_p -> jw_failed_flag)
+		{
+			return false;
+		}
+
+	if (writer_p -> jw_depth == 0)
+		{
+			return SetJSONWriterFailed (writer_p, "nothing to close");
+		}
+
+	level_p = (writer_p -> jw_levels_p) + (writer_p -> jw_depth - 1);
+
+	if (level_p -> jwl_object_flag != object_flag)
+		{
+			return SetJSONWriterFailed (writer_p, object_flag ? "closing an array as an object" : "closing an object as an array");
+		}
+
+	if (level_p -> jwl_key_flag)
+		{
+			return SetJSONWriterFailed (writer_p, "closing an object whose last key has no value");
+		}
+
+	-- (writer_p -> jw_depth);
+
+	return true;
+}
+
+
+/*
+ * Write a string with the same escaping that jansson uses. Runs of
+ * characters that don't need escaping are written in one go.
+ */
+static bool WriteEscapedString (JSONWriter *writer_p, const char *value_s)
+{
+	const unsigned char *value_p = (const unsigned char *) value_s;
+	const unsigned char *run_p = value_p;
+	const bool ascii_flag = (((writer_p -> jw_flags) & JSON_ENSURE_ASCII) != 0);
+	const bool slash_flag = (((writer_p -> jw_flags) & JSON_ESCAPE_SLASH) != 0);
+
+	WriteToJSONWriter (writer_p, "\"", 1);
+
+	while ((*value_p != '\0') && (!writer_p -> jw_failed_flag))
+		{
+			size_t length = 1;
+			int32 codepoint = *value_p;
+
+			if (codepoint >= 0x80)
+				{
+					codepoint = GetUTF8Codepoint (value_p, &length);
+
+					if (codepoint < 0)
+						{
+							return SetJSONWriterFailed (writer_p, "invalid UTF-8 string");
+						}
+				}
+
+			if ((codepoint == '\\') || (codepoint == '"') || (codepoint < 0x20) || (slash_flag && (codepoint == '/')) || (ascii_flag && (codepoint > 0x7F)))
+				{
+					char seq_s [16];
+					const char *escaped_s = seq_s;
+					size_t escaped_length = 2;
+
+					if (value_p > run_p)
+						{
+							WriteToJSONWriter (writer_p, (const char *) run_p, value_p - run_p);
+						}
+
+					switch (codepoint)
+						{
+							case '\\':
+								escaped_s = "\\\\";
+								break;
+
+							case '"':
+								escaped_s = "\\\"";
+								break;
+
+							case '\b':
+								escaped_s = "\\b";
+								break;
+
+							case '\f':
+								escaped_s = "\\f";
+								break;
+
+							case '\n':
+								escaped_s = "\\n";
+								break;
+
+							case '\r':
+								escaped_s = "\\r";
+								break;
+
+							case '\t':
+								escaped_s = "\\t";
+								break;
+
+							case '/':
+								escaped_s = "\\/";
+								break;
+
+							default:
+								if (codepoint < 0x10000)
+									{
+										snprintf (seq_s, sizeof (seq_s), "\\u%04X", (unsigned int) codepoint);
+										escaped_length = 6;
+									}
+								else
+									{
+										/* Outside of the BMP, so use a UTF-16 surrogate pair */
+										const int32 offset = codepoint - 0x10000;
+
+										snprintf (seq_s, sizeof (seq_s), "\\u%04X\\u%04X", (unsigned int) (0xD800 | ((offset & 0xFFC00) >> 10)), (unsigned int) (0xDC00 | (offset & 0x003FF)));
+										escaped_length = 12;
+									}
+								break;
+						}
+
+					WriteToJSONWriter (writer_p, escaped_s, escaped_length);
+
+					value_p += length;
+					run_p = value_p;
+				}
+			else
+				{
+					value_p += length;
+				}
+		}		/* while ((*value_p != '\0') && (!writer_p -> jw_failed_flag)) */
+
+	if (value_p > run_p)
+		{
+			WriteToJSONWriter (writer_p, (const char *) run_p, value_p - run_p);
+		}
+
+	WriteToJSONWriter (writer_p, "\"", 1);
+
+	return !writer_p -> jw_failed_flag;
+}
+
+
+/*
+ * Decode a multi-byte UTF-8 sequence, rejecting the same invalid sequences
+ * that jansson does: overlong encodings, surrogates and values above U+10FFFF.
+ * This returns -1 if the sequence is invalid.
+ */
+static int32 GetUTF8Codepoint (const unsigned char *value_p, size_t *length_p)
+{
+	const unsigned char first = *value_p;
+	int32 codepoint;
+	size_t length;
+	size_t i;
+
+	if ((first >= 0xC2) && (first <= 0xDF))
+		{
+			length = 2;
+			codepoint = first & 0x1F;
+		}
+	else if ((first >= 0xE0) && (first <= 0xEF))
+		{
+			length = 3;
+			codepoint = first & 0x0F;
+		}
+	else if ((first >= 0xF0) && (first <= 0xF4))
+		{
+			length = 4;
+			codepoint = first & 0x07;
+		}
+	else
+		{
+			return -1;
+		}
+
+	/* A terminating '\0' fails this test too so we can't read past the end */
+	for (i = 1; i < length; ++ i)
+		{
+			const unsigned char c = value_p [i];
+
+			if ((c < 0x80) || (c > 0xBF))
+				{
+					return -1;
+				}
+
+			codepoint = (codepoint << 6) | (c & 0x3F);
+		}
+
+	if (((length == 3) && (codepoint < 0x800)) || ((length == 4) && (codepoint < 0x10000)) || (codepoint > 0x10FFFF) || ((codepoint >= 0xD800) && (codepoint <= 0xDFFF)))
+		{
+			return -1;
+		}
+
+	*length_p = length;
+
+	return codepoint;
+}
+
+
+static bool SetJSONWriterFailed (JSONWriter *writer_p, const char *reason_s)
+{
+	if (!writer_p -> jw_failed_flag)
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "JSONWriter failed: %s", reason_s);
+			writer_p -> jw_failed_flag = true;
+		}
+
+	return false;
+}
@@ -0,0 +1,311 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * json_writer_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests that a JSONWriter gives exactly the same output as json_dumps ()
+ *  along with a benchmark that writes a large synthetic tabular result,
+ *  comparing building a jansson tree and dumping it against streaming
+ *  the rows straight out through a JSONWriter.
+ *
+ *  Usage: json_writer_test [<number of rows>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "json_writer.h"
+#include "byte_buffer.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_ROWS (200000)
+
+
+/*
+ * A sink that just counts what it is given, standing in for a socket.
+ */
+typedef struct CountingSink
+{
+	size_t cs_total;
+
+	size_t cs_largest_write;
+
+	struct timespec cs_start;
+
+	double cs_first_write_time;
+} CountingSink;
+
+
+static double GetElapsedSeconds (const struct timespec *start_p)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start_p -> tv_sec) + ((now.tv_nsec - start_p -> tv_nsec) / 1e9);
+}
+
+
+static int CountingSinkCallback (const char * UNUSED_PARAM (data_s), size_t size, void *data_p)
+{
+	CountingSink *sink_p = (CountingSink *) data_p;
+
+	if (sink_p -> cs_total == 0)
+		{
+			sink_p -> cs_first_write_time = GetElapsedSeconds (& (sink_p -> cs_start));
+		}
+
+	sink_p -> cs_total += size;
+
+	if (size > sink_p -> cs_largest_write)
+		{
+			sink_p -> cs_largest_write = size;
+		}
+
+	return 0;
+}
+
+
+/*
+ * Check that the output in buffer_p matches json_dumps () for value_p.
+ */
+static bool IsSameAsDump (ByteBuffer *buffer_p, const json_t *value_p, const size_t flags)
+{
+	bool same_flag = false;
+	char *dump_s = json_dumps (value_p, flags | JSON_ENCODE_ANY);
+
+	if (dump_s)
+		{
+			const size_t length = strlen (dump_s);
+
+			if ((length == GetByteBufferSize (buffer_p)) && (memcmp (dump_s, GetByteBufferData (buffer_p), length) == 0))
+				{
+					same_flag = true;
+				}
+			else
+				{
+					printf ("expected: %s\ngot:      %.*s\n", dump_s, (int) GetByteBufferSize (buffer_p), GetByteBufferData (buffer_p));
+				}
+
+			free (dump_s);
+		}
+
+	return same_flag;
+}
+
+
+static void TestStrings (void)
+{
+	const char *values_ss [] = { "", "plain", "quote \" backslash \\ slash /", "\b\f\n\r\t\x01\x1f", "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x8c\xbe", NULL };
+	const size_t flags [] = { 0, JSON_COMPACT, JSON_ENSURE_ASCII, JSON_ESCAPE_SLASH };
+	bool same_flag = true;
+	size_t i;
+
+	for (i = 0; i < sizeof (flags) / sizeof (flags [0]); ++ i)
+		{
+			const char **value_ss;
+
+			for (value_ss = values_ss; *value_ss; ++ value_ss)
+				{
+					ByteBuffer *buffer_p = AllocateByteBuffer (64);
+					JSONWriter *writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, flags [i], 4);
+					json_t *value_p = json_string (*value_ss);
+
+					if (!(AddStringToJSONWriter (writer_p, *value_ss) && FlushJSONWriter (writer_p) && IsSameAsDump (buffer_p, value_p, flags [i])))
+						{
+							same_flag = false;
+						}
+
+					json_decref (value_p);
+					FreeJSONWriter (writer_p);
+					FreeByteBuffer (buffer_p);
+				}
+		}
+
+	Check (same_flag, "escape strings as jansson does");
+}
+
+
+static bool WriteDocument (JSONWriter *writer_p, const json_t *embedded_p)
+{
+	return (OpenJSONWriterObject (writer_p)
+		&& AddKeyToJSONWriter (writer_p, "service_name") && AddStringToJSONWriter (writer_p, "BlastN")
+		&& AddKeyToJSONWriter (writer_p, "status") && AddIntegerToJSONWriter (writer_p, -3)
+		&& AddKeyToJSONWriter (writer_p, "score") && AddRealToJSONWriter (writer_p, 2.5)
+		&& AddKeyToJSONWriter (writer_p, "whole") && AddRealToJSONWriter (writer_p, 4.0)
+		&& AddKeyToJSONWriter (writer_p, "empty object") && OpenJSONWriterObject (writer_p) && CloseJSONWriterObject (writer_p)
+		&& AddKeyToJSONWriter (writer_p, "flags") && OpenJSONWriterArray (writer_p)
+		&& AddBooleanToJSONWriter (writer_p, true) && AddBooleanToJSONWriter (writer_p, false) && AddNullToJSONWriter (writer_p)
+		&& OpenJSONWriterArray (writer_p) && CloseJSONWriterArray (writer_p)
+		&& CloseJSONWriterArray (writer_p)
+		&& AddKeyToJSONWriter (writer_p, "results") && AddJSONToJSONWriter (writer_p, embedded_p)
+		&& CloseJSONWriterObject (writer_p)
+		&& FlushJSONWriter (writer_p));
+}
+
+
+static void TestDocument (void)
+{
+	json_t *embedded_p = json_pack ("[{s:s, s:[i, f, b, n], s:{}}, s]", "title", "hit \"1\"", "data", 42, 0.125, 1, "more", "tail");
+	json_t *expected_p = json_pack ("{s:s, s:i, s:f, s:f, s:{}, s:[b, b, n, []], s:O}", "service_name", "BlastN", "status", -3, "score", 2.5, "whole", 4.0, "empty object", "flags", 1, 0, "results", embedded_p);
+	const size_t flags [] = { 0, JSON_COMPACT, JSON_COMPACT | JSON_ENSURE_ASCII | JSON_ESCAPE_SLASH };
+	size_t i;
+
+	for (i = 0; i < sizeof (flags) / sizeof (flags [0]); ++ i)
+		{
+			ByteBuffer *buffer_p = AllocateByteBuffer (64);
+			JSONWriter *writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, flags [i], 8);
+			char description_s [64];
+
+			snprintf (description_s, sizeof (description_s), "match json_dumps () with flags 0x%zx", flags [i]);
+
+			Check (WriteDocument (writer_p, embedded_p) && IsJSONWriterComplete (writer_p) && IsSameAsDump (buffer_p, expected_p, flags [i]), description_s);
+
+			FreeJSONWriter (writer_p);
+			FreeByteBuffer (buffer_p);
+		}
+
+	json_decref (expected_p);
+	json_decref (embedded_p);
+}
+
+
+static void TestErrors (void)
+{
+	ByteBuffer *buffer_p = AllocateByteBuffer (64);
+	JSONWriter *writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, 0, 0);
+
+	Check (OpenJSONWriterObject (writer_p) && !IsJSONWriterComplete (writer_p), "report an unfinished value as incomplete");
+	Check (!AddStringToJSONWriter (writer_p, "no key"), "reject an object value without a key");
+	Check (!AddKeyToJSONWriter (writer_p, "key"), "stay failed after an error");
+	FreeJSONWriter (writer_p);
+
+	writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, 0, 0);
+	Check (OpenJSONWriterArray (writer_p) && !CloseJSONWriterObject (writer_p), "reject closing an array as an object");
+	FreeJSONWriter (writer_p);
+
+	writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, 0, 0);
+	Check (!AddStringToJSONWriter (writer_p, "bad \xc0\xaf utf-8"), "reject invalid UTF-8");
+	FreeJSONWriter (writer_p);
+
+	writer_p = AllocateJSONWriter (ByteBufferJSONWriterSink, buffer_p, 0, 0);
+	Check (AddNullToJSONWriter (writer_p) && !AddNullToJSONWriter (writer_p), "reject a second top-level value");
+	FreeJSONWriter (writer_p);
+
+	FreeByteBuffer (buffer_p);
+}
+
+
+/*
+ * A synthetic tabular result such as a large BLAST hit table.
+ */
+static json_t *GetRowAsJSON (const int i)
+{
+	char id_s [32];
+
+	snprintf (id_s, sizeof (id_s), "scaffold_%d", i);
+
+	return json_pack ("{s:s, s:i, s:i, s:f, s:s}", "subject", id_s, "start", i * 10, "stop", i * 10 + 250, "evalue", 1.0 / (i + 1), "strand", (i & 1) ? "plus" : "minus");
+}
+
+
+static void RunBenchmark (const int num_rows)
+{
+	struct timespec start;
+	double tree_time;
+	double tree_first_byte_time;
+	size_t tree_size = 0;
+	CountingSink sink;
+	JSONWriter *writer_p;
+	json_t *rows_p = json_array ();
+	int i;
+
+	printf ("\nWriting a result of %d rows\n", num_rows);
+
+	/* Build the whole tree, dump it and then send the string */
+	clock_gettime (CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < num_rows; ++ i)
+		{
+			json_array_append_new (rows_p, GetRowAsJSON (i));
+		}
+
+	{
+		char *dump_s = json_dumps (rows_p, JSON_COMPACT);
+
+		tree_first_byte_time = GetElapsedSeconds (&start);
+
+		if (dump_s)
+			{
+				tree_size = strlen (dump_s);
+				free (dump_s);
+			}
+	}
+
+	tree_time = GetElapsedSeconds (&start);
+	json_decref (rows_p);
+
+	/* Stream each row as it is generated */
+	memset (&sink, 0, sizeof (sink));
+	clock_gettime (CLOCK_MONOTONIC, & (sink.cs_start));
+	writer_p = AllocateJSONWriter (CountingSinkCallback, &sink, JSON_COMPACT, 0);
+
+	if (writer_p)
+		{
+			bool success_flag = OpenJSONWriterArray (writer_p);
+
+			for (i = 0; (i < num_rows) && success_flag; ++ i)
+				{
+					json_t *row_p = GetRowAsJSON (i);
+
+					success_flag = AddJSONToJSONWriter (writer_p, row_p);
+					json_decref (row_p);
+				}
+
+			success_flag = success_flag && CloseJSONWriterArray (writer_p) && FlushJSONWriter (writer_p);
+
+			printf ("tree + json_dumps (): %.3fs, first byte after %.3fs, %zu bytes held at once\n", tree_time, tree_first_byte_time, tree_size);
+			printf ("JSONWriter:           %.3fs, first byte after %.3fs, %zu bytes held at once\n", GetElapsedSeconds (& (sink.cs_start)), sink.cs_first_write_time, sink.cs_largest_write);
+
+			Check (success_flag && (sink.cs_total == tree_size), "stream the same number of bytes as json_dumps ()");
+			Check (sink.cs_largest_write <= JSON_WRITER_DEFAULT_CHUNK_SIZE, "never hold more than one chunk");
+
+			FreeJSONWriter (writer_p);
+		}
+	else
+		{
+			Check (false, "allocate JSONWriter");
+		}
+}
+
+
+int main (int argc, char *argv [])
+{
+	const int num_rows = (argc > 1) ? atoi (argv [1]) : DEFAULT_NUM_ROWS;
+
+	TestStrings ();
+	TestDocument ();
+	TestErrors ();
+	RunBenchmark (num_rows);
+
+	return GetTestResult ();
+}
@@ -0,0 +1,349 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * memory_arena.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <string.h>
+
+#ifndef _WIN32
+	#include <pthread.h>
+#endif
+
+#include "memory_arena.h"
+#include "memory_allocations.h"
+#include "streams.h"
+
+
+#ifdef _MSC_VER
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
+
+/** Every allocation is rounded up to a multiple of this many bytes */
+#define S_ALIGNMENT (16)
+
+#define S_ALIGN(x) (((x) + (S_ALIGNMENT - 1)) & ~((size_t) (S_ALIGNMENT - 1)))
+
+
+typedef struct MemoryArenaChunk
+{
+	struct MemoryArenaChunk *mac_next_p;
+	size_t mac_size;
+	size_t mac_used;
+	double mac_align;
+} MemoryArenaChunk;
+
+
+typedef struct MemoryArenaCleanup
+{
+	struct MemoryArenaCleanup *mac_next_p;
+	void (*mac_cleanup_fn) (void *data_p);
+	void *mac_data_p;
+} MemoryArenaCleanup;
+
+
+#define S_CHUNK_HEADER_SIZE (S_ALIGN (sizeof (MemoryArenaChunk)))
+
+
+static THREAD_LOCAL MemoryArena *s_request_arena_p = NULL;
+
+static THREAD_LOCAL uint32 s_request_depth = 0;
+
+
+#ifndef _WIN32
+static pthread_key_t s_request_arena_key;
+static pthread_once_t s_request_arena_key_once = PTHREAD_ONCE_INIT;
+
+static void CreateRequestArenaKey (void);
+
+static void FreeRequestMemoryArena (void *arena_p);
+#endif
+
+
+static MemoryArenaChunk *AllocateMemoryArenaChunk (const size_t size);
+
+static void RunMemoryArenaCleanups (MemoryArena *arena_p);
+
+
+MemoryArena *AllocateMemoryArena (const size_t chunk_size)
+{
+	MemoryArena *arena_p = (MemoryArena *) AllocMemory (sizeof (MemoryArena));
+
+	if (arena_p)
+		{
+			arena_p -> ma_current_chunk_p = NULL;
+			arena_p -> ma_cleanups_p = NULL;
+			arena_p -> ma_chunk_size = (chunk_size > 0) ? S_ALIGN (chunk_size) : MEMORY_ARENA_DEFAULT_CHUNK_SIZE;
+			memset (& (arena_p -> ma_stats), 0, sizeof (MemoryArenaStatistics));
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate MemoryArena");
+		}
+
+	return arena_p;
+}
+
+
+void FreeMemoryArena (MemoryArena *arena_p)
+{
+	MemoryArenaChunk *chunk_p;
+
+	RunMemoryArenaCleanups (arena_p);
+
+	chunk_p = arena_p -> ma_current_chunk_p;
+
+	while (chunk_p)
+		{
+			MemoryArenaChunk *next_p = chunk_p -> mac_next_p;
+
+			FreeMemory (chunk_p);
+			chunk_p = next_p;
+		}
+
+	FreeMemory (arena_p);
+}
+
+
+void ResetMemoryArena (MemoryArena *arena_p)
+{
+	MemoryArenaChunk *chunk_p;
+	MemoryArenaChunk *kept_chunk_p = NULL;
+
+	RunMemoryArenaCleanups (arena_p);
+
+	chunk_p = arena_p -> ma_current_chunk_p;
+
+	/* Keep a single standard-sized chunk for the next round of allocations */
+	while (chunk_p)
+		{
+			MemoryArenaChunk *next_p = chunk_p -> mac_next_p;
+
+			if ((!kept_chunk_p) && (chunk_p -> mac_size == arena_p -> ma_chunk_size))
+				{
+					kept_chunk_p = chunk_p;
+					kept_chunk_p -> mac_next_p = NULL;
+					kept_chunk_p -> mac_used = 0;
+				}
+			else
+				{
+					FreeMemory (chunk_p);
+				}
+
+			chunk_p = next_p;
+		}
+
+	arena_p -> ma_current_chunk_p = kept_chunk_p;
+
+	memset (& (arena_p -> ma_stats), 0, sizeof (MemoryArenaStatistics));
+
+	if (kept_chunk_p)
+		{
+			arena_p -> ma_stats.mas_num_chunks = 1;
+		}
+}
+
+
+void *AllocateFromMemoryArena (MemoryArena *arena_p, const size_t size)
+{
+	const size_t aligned_size = S_ALIGN (size > 0 ? size : 1);
+	MemoryArenaChunk *chunk_p = arena_p -> ma_current_chunk_p;
+	void *mem_p = NULL;
+
+	if ((!chunk_p) || (chunk_p -> mac_used + aligned_size > chunk_p -> mac_size))
+		{
+			if (aligned_size > (arena_p -> ma_chunk_size / 4))
+				{
+					/*
+					 * Give big allocations a chunk of their own and put it behind
+					 * the current chunk so that the latter's free space isn't wasted.
+					 */
+					MemoryArenaChunk *large_chunk_p = AllocateMemoryArenaChunk (aligned_size);
+
+					if (large_chunk_p)
+						{
+							large_chunk_p -> mac_used = aligned_size;
+
+							if (chunk_p)
+								{
+									large_chunk_p -> mac_next_p = chunk_p -> mac_next_p;
+									chunk_p -> mac_next_p = large_chunk_p;
+								}
+							else
+								{
+									arena_p -> ma_current_chunk_p = large_chunk_p;
+								}
+
+							++ (arena_p -> ma_stats.mas_num_chunks);
+							mem_p = ((char *) large_chunk_p) + S_CHUNK_HEADER_SIZE;
+						}
+
+					chunk_p = NULL;
+				}
+			else
+				{
+					chunk_p = AllocateMemoryArenaChunk (arena_p -> ma_chunk_size);
+
+					if (chunk_p)
+						{
+							chunk_p -> mac_next_p = arena_p -> ma_current_chunk_p;
+							arena_p -> ma_current_chunk_p = chunk_p;
+							++ (arena_p -> ma_stats.mas_num_chunks);
+						}
+				}
+		}
+
+	if (chunk_p)
+		{
+			mem_p = ((char *) chunk_p) + S_CHUNK_HEADER_SIZE + chunk_p -> mac_used;
+			chunk_p -> mac_used += aligned_size;
+		}
+
+	if (mem_p)
+		{
+			++ (arena_p -> ma_stats.mas_num_allocations);
+			arena_p -> ma_stats.mas_num_bytes += aligned_size;
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate " SIZET_FMT " bytes from MemoryArena", size);
+		}
+
+	return mem_p;
+}
+
+
+bool AddMemoryArenaCleanup (MemoryArena *arena_p, void (*cleanup_fn) (void *data_p), void *data_p)
+{
+	MemoryArenaCleanup *cleanup_p = (MemoryArenaCleanup *) AllocateFromMemoryArena (arena_p, sizeof (MemoryArenaCleanup));
+
+	if (cleanup_p)
+		{
+			cleanup_p -> mac_cleanup_fn = cleanup_fn;
+			cleanup_p -> mac_data_p = data_p;
+			cleanup_p -> mac_next_p = arena_p -> ma_cleanups_p;
+			arena_p -> ma_cleanups_p = cleanup_p;
+
+			++ (arena_p -> ma_stats.mas_num_cleanups);
+
+			return true;
+		}
+
+	return false;
+}
+
+
+void GetMemoryArenaStatistics (const MemoryArena *arena_p, MemoryArenaStatistics *stats_p)
+{
+	*stats_p = arena_p -> ma_stats;
+}
+
+
+MemoryArena *GetCurrentMemoryArena (void)
+{
+	return (s_request_depth > 0) ? s_request_arena_p : NULL;
+}
+
+
+MemoryArena *BeginRequestMemoryArena (void)
+{
+	if (!s_request_arena_p)
+		{
+			s_request_arena_p = AllocateMemoryArena (0);
+
+			if (s_request_arena_p)
+				{
+					#ifndef _WIN32
+					/* Make sure that the arena is freed when its thread exits */
+					pthread_once (&s_request_arena_key_once, CreateRequestArenaKey);
+					pthread_setspecific (s_request_arena_key, s_request_arena_p);
+					#endif
+				}
+			else
+				{
+					return NULL;
+				}
+		}
+
+	++ s_request_depth;
+
+	return s_request_arena_p;
+}
+
+
+void EndRequestMemoryArena (void)
+{
+	if (s_request_depth > 0)
+		{
+			if (-- s_request_depth == 0)
+				{
+					ResetMemoryArena (s_request_arena_p);
+				}
+		}
+}
+
+
+static MemoryArenaChunk *AllocateMemoryArenaChunk (const size_t size)
+{
+	MemoryArenaChunk *chunk_p = (MemoryArenaChunk *) AllocMemory (S_CHUNK_HEADER_SIZE + size);
+
+	if (chunk_p)
+		{
+			chunk_p -> mac_next_p = NULL;
+			chunk_p -> mac_size = size;
+			chunk_p -> mac_used = 0;
+		}
+
+	return chunk_p;
+}
+
+
+static void RunMemoryArenaCleanups (MemoryArena *arena_p)
+{
+	/*
+	 * A cleanup function may itself allocate from the arena or add
+	 * further cleanups, so keep going until there are none left.
+	 */
+	while (arena_p -> ma_cleanups_p)
+		{
+			MemoryArenaCleanup *cleanup_p = arena_p -> ma_cleanups_p;
+
+			arena_p -> ma_cleanups_p = cleanup_p -> mac_next_p;
+			cleanup_p -> mac_cleanup_fn (cleanup_p -> mac_data_p);
+		}
+}
+
+
+#ifndef _WIN32
+
+static void CreateRequestArenaKey (void)
+{
+	pthread_key_create (&s_request_arena_key, FreeRequestMemoryArena);
+}
+
+
+static void FreeRequestMemoryArena (void *arena_p)
+{
+	FreeMemoryArena ((MemoryArena *) arena_p);
+}
+
+#endif
@@ -0,0 +1,201 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * memory_arena_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for MemoryArenas and a benchmark that simulates the transient
+ *  strings built whilst processing requests, first with individual heap
+ *  allocations and then with the per-thread request arena.
+ *
+ *  Usage: memory_arena_test [<number of requests> [<strings per request>]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "memory_arena.h"
+#include "string_utils.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_REQUESTS (20000)
+
+#define DEFAULT_NUM_STRINGS (64)
+
+
+static int s_num_cleanups = 0;
+
+
+static double GetTime (void)
+{
+	struct timespec t;
+
+	clock_gettime (CLOCK_MONOTONIC, &t);
+
+	return t.tv_sec + (t.tv_nsec / 1.0e9);
+}
+
+
+static void CountCleanup (void *data_p)
+{
+	int *order_p = (int *) data_p;
+
+	/* Cleanups run newest first */
+	if (*order_p == s_num_cleanups)
+		{
+			++ s_num_cleanups;
+		}
+}
+
+
+static void TestArena (void)
+{
+	MemoryArena *arena_p = AllocateMemoryArena (1024);
+
+	if (arena_p)
+		{
+			MemoryArenaStatistics stats;
+			char *value_s = ConcatenateVarargsStringsInArena (arena_p, "service", ": ", "BLAST", NULL);
+			char *copy_s = CopyToArenaString (arena_p, "input_file");
+			void *large_p = AllocateFromMemoryArena (arena_p, 4096);
+			void *small_p = AllocateFromMemoryArena (arena_p, 3);
+			int orders [2] = { 1, 0 };
+
+			Check ((value_s != NULL) && (strcmp (value_s, "service: BLAST") == 0), "concatenate strings in an arena");
+			Check ((copy_s != NULL) && (strcmp (copy_s, "input_file") == 0), "copy a string into an arena");
+			Check ((large_p != NULL) && (small_p != NULL), "allocate blocks larger and smaller than a chunk");
+			Check ((((size_t) small_p) % 16) == 0, "allocations are aligned");
+
+			memset (large_p, 0, 4096);
+
+			AddMemoryArenaCleanup (arena_p, CountCleanup, orders);
+			AddMemoryArenaCleanup (arena_p, CountCleanup, orders + 1);
+
+			GetMemoryArenaStatistics (arena_p, &stats);
+			Check ((stats.mas_num_allocations == 6) && (stats.mas_num_chunks == 2) && (stats.mas_num_cleanups == 2), "arena statistics");
+
+			ResetMemoryArena (arena_p);
+
+			Check (s_num_cleanups == 2, "cleanups run in reverse order when the arena is reset");
+
+			GetMemoryArenaStatistics (arena_p, &stats);
+			Check ((stats.mas_num_allocations == 0) && (stats.mas_num_chunks == 1), "reset keeps a single chunk");
+
+			FreeMemoryArena (arena_p);
+		}
+	else
+		{
+			Check (false, "allocate an arena");
+		}
+
+	Check (GetCurrentMemoryArena () == NULL, "no current arena outside of a request");
+
+	if (BeginRequestMemoryArena ())
+		{
+			MemoryArena *arena_p = GetCurrentMemoryArena ();
+
+			BeginRequestMemoryArena ();
+			CopyToArenaString (arena_p, "nested");
+			EndRequestMemoryArena ();
+
+			Check (arena_p -> ma_stats.mas_num_allocations == 1, "nested requests share the arena");
+
+			EndRequestMemoryArena ();
+
+			Check ((GetCurrentMemoryArena () == NULL) && (arena_p -> ma_stats.mas_num_allocations == 0), "the outermost request releases the arena");
+		}
+	else
+		{
+			Check (false, "begin a request arena");
+		}
+}
+
+
+static void RunBenchmark (const uint32 num_requests, const uint32 num_strings)
+{
+	char **values_ss = (char **) calloc (num_strings, sizeof (char *));
+
+	if (values_ss)
+		{
+			double heap_time;
+			double arena_time;
+			uint32 arena_chunks = 0;
+			uint32 i;
+			uint32 j;
+			double start = GetTime ();
+
+			for (i = 0; i < num_requests; ++ i)
+				{
+					for (j = 0; j < num_strings; ++ j)
+						{
+							values_ss [j] = ConcatenateVarargsStrings ("config", "/", "service_name_", "parameter", NULL);
+						}
+
+					for (j = 0; j < num_strings; ++ j)
+						{
+							FreeCopiedString (values_ss [j]);
+						}
+				}
+
+			heap_time = GetTime () - start;
+			start = GetTime ();
+
+			for (i = 0; i < num_requests; ++ i)
+				{
+					MemoryArena *arena_p = BeginRequestMemoryArena ();
+
+					for (j = 0; j < num_strings; ++ j)
+						{
+							values_ss [j] = ConcatenateVarargsStringsInArena (arena_p, "config", "/", "service_name_", "parameter", NULL);
+						}
+
+					if (i == 0)
+						{
+							arena_chunks = arena_p -> ma_stats.mas_num_chunks;
+						}
+
+					EndRequestMemoryArena ();
+				}
+
+			arena_time = GetTime () - start;
+
+			/*
+			 * ConcatenateVarargsStrings () makes two heap allocations per string,
+			 * one for its ByteBuffer and one for the buffer's data.
+			 */
+			printf ("%u requests x %u strings: heap %.3f s (%u allocations per request), arena %.3f s (%u chunks allocated by the first request and reused after)\n",
+				num_requests, num_strings, heap_time, 2 * num_strings, arena_time, arena_chunks);
+
+			free (values_ss);
+		}
+}
+
+
+int main (int argc, char *argv [])
+{
+	const uint32 num_requests = (argc > 1) ? (uint32) atoi (argv [1]) : DEFAULT_NUM_REQUESTS;
+	const uint32 num_strings = (argc > 2) ? (uint32) atoi (argv [2]) : DEFAULT_NUM_STRINGS;
+
+	TestArena ();
+	RunBenchmark (num_requests, num_strings);
+
+	return GetTestResult ();
+}
@@ -0,0 +1,634 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * metrics.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "metrics.h"
+#include "byte_buffer.h"
+#include "memory_allocations.h"
+#include "streams.h"
+
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <intrin.h>
+
+	#define ATOMIC_ADD(x, v) (InterlockedExchangeAdd64 ((LONG64 volatile *) (x), (LONG64) (v)))
+	#define ATOMIC_LOAD(x) ((uint64) InterlockedCompareExchange64 ((LONG64 volatile *) (x), 0, 0))
+	#define ATOMIC_LOAD_STATE(x) ((uint32) InterlockedCompareExchange ((LONG volatile *) (x), 0, 0))
+	#define ATOMIC_CLAIM_STATE(x, from, to) (InterlockedCompareExchange ((LONG volatile *) (x), (LONG) (to), (LONG) (from)) == (LONG) (from))
+	#define ATOMIC_STORE_STATE(x, v) (InterlockedExchange ((LONG volatile *) (x), (LONG) (v)))
+#else
+	#define ATOMIC_ADD(x, v) (__atomic_add_fetch ((x), (v), __ATOMIC_RELAXED))
+	#define ATOMIC_LOAD(x) (__atomic_load_n ((x), __ATOMIC_RELAXED))
+	#define ATOMIC_LOAD_STATE(x) (__atomic_load_n ((x), __ATOMIC_ACQUIRE))
+	#define ATOMIC_CLAIM_STATE(x, from, to) (__atomic_compare_exchange_n ((x), & (uint32) { (from) }, (to), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	#define ATOMIC_STORE_STATE(x, v) (__atomic_store_n ((x), (v), __ATOMIC_RELEASE))
+#endif
+
+
+/* The states of the entries in s_timers */
+#define S_TIMER_EMPTY (0)
+#define S_TIMER_CLAIMED (1)
+#define S_TIMER_READY (2)
+
+
+/* Values below this are recorded exactly, one per bucket */
+#define S_LINEAR_LIMIT (2 * METRICS_NUM_SUB_BUCKETS)
+
+
+/* The upper bounds, in seconds, of the Prometheus histogram buckets */
+static const double S_PROMETHEUS_BOUNDS_A [] =
+{
+	0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0, 300.0
+};
+
+
+static MetricTimer s_timers [METRICS_MAX_NUM_TIMERS];
+
+static uint64 s_num_dropped = 0;
+
+
+static uint32 GetBucketIndex (uint64 value);
+
+static uint64 GetBucketHighestValue (const uint32 index);
+
+static uint32 HashKey (const char *family_s, const char *label_s);
+
+static bool DoesTimerMatch (const MetricTimer *timer_p, const char *family_s, const char *label_s);
+
+static void UpdateMaximum (uint64 *max_p, const uint64 value);
+
+static uint64 GetBucketCounts (const MetricTimer *timer_p, uint64 *counts_p);
+
+static json_t *GetMetricTimerAsJSON (const MetricTimer *timer_p);
+
+static bool AddFamilyAsPrometheusText (ByteBuffer *buffer_p, const uint32 first_index);
+
+static bool AddPrometheusTimer (ByteBuffer *buffer_p, const MetricTimer *timer_p);
+
+static bool AppendFormattedToByteBuffer (ByteBuffer *buffer_p, const char *format_s, ...);
+
+static void EscapePrometheusLabel (const char *value_s, char *buffer_s, const size_t buffer_size);
+
+
+
+uint64 GetMetricsTime (void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceCounter (&counter);
+	QueryPerformanceFrequency (&frequency);
+
+	return ((uint64) (counter.QuadPart / frequency.QuadPart)) * 1000000 + ((uint64) (counter.QuadPart % frequency.QuadPart)) * 1000000 / frequency.QuadPart;
+#else
+	struct timespec t;
+
+	clock_gettime (CLOCK_MONOTONIC, &t);
+
+	return ((uint64) t.tv_sec) * 1000000 + ((uint64) t.tv_nsec) / 1000;
+#endif
+}
+
+
+void RecordMetric (const char *family_s, const char *label_s, const uint64 start_time, const bool success_flag)
+{
+	const uint64 end_time = GetMetricsTime ();
+
+	RecordMetricDuration (family_s, label_s, (end_time > start_time) ? end_time - start_time : 0, success_flag);
+}
+
+
+void RecordMetricDuration (const char *family_s, const char *label_s, const uint64 duration, const bool success_flag)
+{
+	MetricTimer *timer_p = GetMetricTimer (family_s, label_s);
+
+	if (timer_p)
+		{
+			const uint64 value = (duration > METRICS_MAX_VALUE) ? METRICS_MAX_VALUE : duration;
+
+			ATOMIC_ADD (timer_p -> mt_buckets + GetBucketIndex (value), 1);
+			ATOMIC_ADD (& (timer_p -> mt_sum), value);
+			ATOMIC_ADD (& (timer_p -> mt_count), 1);
+
+			if (!success_flag)
+				{
+					ATOMIC_ADD (& (timer_p -> mt_num_errors), 1);
+				}
+
+			UpdateMaximum (& (timer_p -> mt_max), value);
+		}
+	else
+		{
+			ATOMIC_ADD (&s_num_dropped, 1);
+		}
+}
+
+
+MetricTimer *GetMetricTimer (const char *family_s, const char *label_s)
+{
+	const uint32 start_index = HashKey (family_s, label_s) % METRICS_MAX_NUM_TIMERS;
+	uint32 i;
+
+	/*
+	 * Open addressing with linear probing. Entries are only ever added so a
+	 * lookup can stop at the first empty one. An entry is claimed with a
+	 * compare-and-swap before its names are filled in and only compared
+	 * once it has been marked as ready.
+	 */
+	for (i = 0; i < METRICS_MAX_NUM_TIMERS; ++ i)
+		{
+			MetricTimer *timer_p = s_timers + ((start_index + i) % METRICS_MAX_NUM_TIMERS);
+			uint32 state = ATOMIC_LOAD_STATE (& (timer_p -> mt_state));
+
+			if (state == S_TIMER_EMPTY)
+				{
+					if (ATOMIC_CLAIM_STATE (& (timer_p -> mt_state), S_TIMER_EMPTY, S_TIMER_CLAIMED))
+						{
+							strncpy (timer_p -> mt_family_s, family_s, METRICS_FAMILY_SIZE - 1);
+							strncpy (timer_p -> mt_label_s, label_s, METRICS_LABEL_SIZE - 1);
+							ATOMIC_STORE_STATE (& (timer_p -> mt_state), S_TIMER_READY);
+
+							return timer_p;
+						}
+
+					state = ATOMIC_LOAD_STATE (& (timer_p -> mt_state));
+				}
+
+			/* Another thread is filling this entry in so wait for it */
+			while (state == S_TIMER_CLAIMED)
+				{
+					state = ATOMIC_LOAD_STATE (& (timer_p -> mt_state));
+				}
+
+			if (DoesTimerMatch (timer_p, family_s, label_s))
+				{
+					return timer_p;
+				}
+		}
+
+	return NULL;
+}
+
+
+uint64 GetMetricTimerPercentile (const MetricTimer *timer_p, const double percentile)
+{
+	uint64 counts [METRICS_NUM_BUCKETS];
+	const uint64 total = GetBucketCounts (timer_p, counts);
+
+	if (total > 0)
+		{
+			/* The rank of the requested value, counting from 1 */
+			uint64 rank = (uint64) ((percentile / 100.0) * total + 0.5);
+			uint64 seen = 0;
+			uint32 i;
+
+			if (rank < 1)
+				{
+					rank = 1;
+				}
+			else if (rank > total)
+				{
+					rank = total;
+				}
+
+			for (i = 0; i < METRICS_NUM_BUCKETS; ++ i)
+				{
+					seen += counts [i];
+
+					if (seen >= rank)
+						{
+							const uint64 value = GetBucketHighestValue (i);
+							const uint64 max_value = ATOMIC_LOAD (& (timer_p -> mt_max));
+
+							/* The top bucket can extend beyond anything that was recorded */
+							return (value < max_value) ? value : max_value;
+						}
+				}
+		}
+
+	return 0;
+}
+
+
+uint64 GetNumberOfDroppedMetrics (void)
+{
+	return ATOMIC_LOAD (&s_num_dropped);
+}
+
+
+json_t *GetMetricsAsJSON (void)
+{
+	json_t *metrics_p = json_object ();
+
+	if (metrics_p)
+		{
+			uint32 i;
+
+			for (i = 0; i < METRICS_MAX_NUM_TIMERS; ++ i)
+				{
+					const MetricTimer *timer_p = s_timers + i;
+
+					if (ATOMIC_LOAD_STATE (& (timer_p -> mt_state)) == S_TIMER_READY)
+						{
+							json_t *family_p = json_object_get (metrics_p, timer_p -> mt_family_s);
+
+							if (!family_p)
+								{
+									family_p = json_object ();
+
+									if (family_p)
+										{
+											if (json_object_set_new (metrics_p, timer_p -> mt_family_s, family_p) != 0)
+												{
+													family_p = NULL;
+												}
+										}
+								}
+
+							if (family_p)
+								{
+									json_t *timer_json_p = GetMetricTimerAsJSON (timer_p);
+
+									if (timer_json_p)
+										{
+											if (json_object_set_new (family_p, timer_p -> mt_label_s, timer_json_p) != 0)
+												{
+													PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to add metrics for \"%s\" \"%s\"", timer_p -> mt_family_s, timer_p -> mt_label_s);
+												}
+										}
+
+								}		/* if (family_p) */
+
+						}		/* if (ATOMIC_LOAD_STATE (& (timer_p -> mt_state)) == S_TIMER_READY) */
+
+				}		/* for (i = 0; i < METRICS_MAX_NUM_TIMERS; ++ i) */
+
+		}		/* if (metrics_p) */
+
+	return metrics_p;
+}
+
+
+char *GetMetricsAsPrometheusText (void)
+{
+	char *text_s = NULL;
+	ByteBuffer *buffer_p = AllocateByteBuffer (4096);
+
+	if (buffer_p)
+		{
+			bool success_flag = true;
+			uint32 i;
+
+			for (i = 0; (i < METRICS_MAX_NUM_TIMERS) && success_flag; ++ i)
+				{
+					const MetricTimer *timer_p = s_timers + i;
+
+					if (ATOMIC_LOAD_STATE (& (timer_p -> mt_state)) == S_TIMER_READY)
+						{
+							bool seen_flag = false;
+							uint32 j;
+
+							/* Only write each family once, at its first MetricTimer */
+							for (j = 0; (j < i) && (!seen_flag); ++ j)
+								{
+									if ((ATOMIC_LOAD_STATE (& (s_timers [j].mt_state)) == S_TIMER_READY) && (strcmp (s_timers [j].mt_family_s, timer_p -> mt_family_s) == 0))
+										{
+											seen_flag = true;
+										}
+								}
+
+							if (!seen_flag)
+								{
+									success_flag = AddFamilyAsPrometheusText (buffer_p, i);
+								}
+						}
+				}
+
+			if (success_flag)
+				{
+					success_flag = AppendFormattedToByteBuffer (buffer_p, "# HELP grassroots_metrics_dropped_total Calls that were not recorded as there were too many distinct metrics.\n"
+						"# TYPE grassroots_metrics_dropped_total counter\n"
+						"grassroots_metrics_dropped_total %llu\n", (unsigned long long) GetNumberOfDroppedMetrics ());
+				}
+
+			if (success_flag)
+				{
+					text_s = TakeByteBufferData (buffer_p, NULL);
+				}
+
+			FreeByteBuffer (buffer_p);
+		}		/* if (buffer_p) */
+
+	return text_s;
+}
+
+
+void FreeMetricsText (char *text_s)
+{
+	FreeMemory (text_s);
+}
+
+
+static uint32 GetBucketIndex (uint64 value)
+{
+	uint32 index;
+
+	if (value < S_LINEAR_LIMIT)
+		{
+			index = (uint32) value;
+		}
+	else
+		{
+			uint32 shift;
+
+#ifdef _WIN32
+			unsigned long msb;
+
+			_BitScanReverse64 (&msb, value);
+#else
+			const uint32 msb = 63 - __builtin_clzll (value);
+#endif
+
+			/*
+			 * Keep the top METRICS_SUB_BUCKET_BITS + 1 bits of the value, the
+			 * leading one of which picks the power of two and the rest of which
+			 * pick the sub-bucket within it.
+			 */
+			shift = ((uint32) msb) - METRICS_SUB_BUCKET_BITS;
+			index = shift * METRICS_NUM_SUB_BUCKETS + (uint32) (value >> shift);
+		}
+
+	return index;
+}
+
+
+static uint64 GetBucketHighestValue (const uint32 index)
+{
+	if (index < S_LINEAR_LIMIT)
+		{
+			return index;
+		}
+	else
+		{
+			const uint32 shift = (index / METRICS_NUM_SUB_BUCKETS) - 1;
+			const uint64 sub_bucket = index - shift * METRICS_NUM_SUB_BUCKETS;
+
+			return ((sub_bucket + 1) << shift) - 1;
+		}
+}
+
+
+/*
+ * FNV-1a over the parts of the names that fit into a MetricTimer
+ */
+static uint32 HashKey (const char *family_s, const char *label_s)
+{
+	uint32 hash = 2166136261U;
+	size_t i;
+
+	for (i = 0; (i < METRICS_FAMILY_SIZE - 1) && (family_s [i] != '\0'); ++ i)
+		{
+			hash = (hash ^ (unsigned char) family_s [i]) * 16777619U;
+		}
+
+	hash = (hash ^ 0xFF) * 16777619U;
+
+	for (i = 0; (i < METRICS_LABEL_SIZE - 1) && (label_s [i] != '\0'); ++ i)
+		{
+			hash = (hash ^ (unsigned char) label_s [i]) * 16777619U;
+		}
+
+	return hash;
+}
+
+
+static bool DoesTimerMatch (const MetricTimer *timer_p, const char *family_s, const char *label_s)
+{
+	return ((strncmp (timer_p -> mt_family_s, family_s, METRICS_FAMILY_SIZE - 1) == 0) && (strncmp (timer_p -> mt_label_s, label_s, METRICS_LABEL_SIZE - 1) == 0));
+}
+
+
+static void UpdateMaximum (uint64 *max_p, const uint64 value)
+{
+	uint64 current_max = ATOMIC_LOAD (max_p);
+
+	while (value > current_max)
+		{
+#ifdef _WIN32
+			const uint64 previous_max = (uint64) InterlockedCompareExchange64 ((LONG64 volatile *) max_p, (LONG64) value, (LONG64) current_max);
+
+			if (previous_max == current_max)
+				{
+					return;
+				}
+
+			current_max = previous_max;
+#else
+			if (__atomic_compare_exchange_n (max_p, &current_max, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				{
+					return;
+				}
+#endif
+		}
+}
+
+
+/*
+ * Take a snapshot of the bucket counts and return their total, which
+ * can differ slightly from mt_count whilst calls are being recorded.
+ */
+static uint64 GetBucketCounts (const MetricTimer *timer_p, uint64 *counts_p)
+{
+	uint64 total = 0;
+	uint32 i;
+
+	for (i = 0; i < METRICS_NUM_BUCKETS; ++ i)
+		{
+			counts_p [i] = ATOMIC_LOAD (timer_p -> mt_buckets + i);
+			total += counts_p [i];
+		}
+
+	return total;
+}
+
+
+static json_t *GetMetricTimerAsJSON (const MetricTimer *timer_p)
+{
+	const uint64 count = ATOMIC_LOAD (& (timer_p -> mt_count));
+	const uint64 sum = ATOMIC_LOAD (& (timer_p -> mt_sum));
+
+	return json_pack ("{s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I}",
+		"count", (json_int_t) count,
+		"errors", (json_int_t) ATOMIC_LOAD (& (timer_p -> mt_num_errors)),
+		"mean_us", (json_int_t) ((count > 0) ? sum / count : 0),
+		"max_us", (json_int_t) ATOMIC_LOAD (& (timer_p -> mt_max)),
+		"p50_us", (json_int_t) GetMetricTimerPercentile (timer_p, 50.0),
+		"p90_us", (json_int_t) GetMetricTimerPercentile (timer_p, 90.0),
+		"p99_us", (json_int_t) GetMetricTimerPercentile (timer_p, 99.0),
+		"p999_us", (json_int_t) GetMetricTimerPercentile (timer_p, 99.9));
+}
+
+
+static bool AddFamilyAsPrometheusText (ByteBuffer *buffer_p, const uint32 first_index)
+{
+	const char *family_s = s_timers [first_index].mt_family_s;
+	bool success_flag = AppendFormattedToByteBuffer (buffer_p, "# HELP grassroots_%s_duration_seconds The time taken by %s calls.\n"
+		"# TYPE grassroots_%s_duration_seconds histogram\n", family_s, family_s, family_s);
+	uint32 i;
+
+	for (i = first_index; (i < METRICS_MAX_NUM_TIMERS) && success_flag; ++ i)
+		{
+			const MetricTimer *timer_p = s_timers + i;
+
+			if ((ATOMIC_LOAD_STATE (& (timer_p -> mt_state)) == S_TIMER_READY) && (strcmp (timer_p -> mt_family_s, family_s) == 0))
+				{
+					success_flag = AddPrometheusTimer (buffer_p, timer_p);
+				}
+		}
+
+	if (success_flag)
+		{
+			success_flag = AppendFormattedToByteBuffer (buffer_p, "# HELP grassroots_%s_errors_total The number of %s calls that failed.\n"
+				"# TYPE grassroots_%s_errors_total counter\n", family_s, family_s, family_s);
+
+			for (i = first_index; (i < METRICS_MAX_NUM_TIMERS) && success_flag; ++ i)
+				{
+					const MetricTimer *timer_p = s_timers + i;
+
+					if ((ATOMIC_LOAD_STATE (& (timer_p -> mt_state)) == S_TIMER_READY) && (strcmp (timer_p -> mt_family_s, family_s) == 0))
+						{
+							char label_s [2 * METRICS_LABEL_SIZE];
+
+							EscapePrometheusLabel (timer_p -> mt_label_s, label_s, sizeof (label_s));
+							success_flag = AppendFormattedToByteBuffer (buffer_p, "grassroots_%s_errors_total{name=\"%s\"} %llu\n", family_s, label_s, (unsigned long long) ATOMIC_LOAD (& (timer_p -> mt_num_errors)));
+						}
+				}
+		}
+
+	return success_flag;
+}
+
+
+static bool AddPrometheusTimer (ByteBuffer *buffer_p, const MetricTimer *timer_p)
+{
+	uint64 counts [METRICS_NUM_BUCKETS];
+	const uint64 total = GetBucketCounts (timer_p, counts);
+	const size_t num_bounds = sizeof (S_PROMETHEUS_BOUNDS_A) / sizeof (S_PROMETHEUS_BOUNDS_A [0]);
+	const char *family_s = timer_p -> mt_family_s;
+	char label_s [2 * METRICS_LABEL_SIZE];
+	bool success_flag = true;
+	uint64 cumulative_count = 0;
+	uint32 bucket_index = 0;
+	size_t i;
+
+	EscapePrometheusLabel (timer_p -> mt_label_s, label_s, sizeof (label_s));
+
+	/*
+	 * Each of our buckets is counted towards the first Prometheus bound
+	 * that its highest value fits under, so the counts are accurate to
+	 * within the width of the bucket that straddles each bound.
+	 */
+	for (i = 0; (i < num_bounds) && success_flag; ++ i)
+		{
+			const uint64 bound = (uint64) (S_PROMETHEUS_BOUNDS_A [i] * 1000000.0);
+
+			while ((bucket_index < METRICS_NUM_BUCKETS) && (GetBucketHighestValue (bucket_index) <= bound))
+				{
+					cumulative_count += counts [bucket_index];
+					++ bucket_index;
+				}
+
+			success_flag = AppendFormattedToByteBuffer (buffer_p, "grassroots_%s_duration_seconds_bucket{name=\"%s\",le=\"%g\"} %llu\n", family_s, label_s, S_PROMETHEUS_BOUNDS_A [i], (unsigned long long) cumulative_count);
+		}
+
+	if (success_flag)
+		{
+			success_flag = AppendFormattedToByteBuffer (buffer_p, "grassroots_%s_duration_seconds_bucket{name=\"%s\",le=\"+Inf\"} %llu\n"
+				"grassroots_%s_duration_seconds_sum{name=\"%s\"} %.6f\n"
+				"grassroots_%s_duration_seconds_count{name=\"%s\"} %llu\n",
+				family_s, label_s, (unsigned long long) total,
+				family_s, label_s, ATOMIC_LOAD (& (timer_p -> mt_sum)) / 1000000.0,
+				family_s, label_s, (unsigned long long) total);
+		}
+
+	return success_flag;
+}
+
+
+static bool AppendFormattedToByteBuffer (ByteBuffer *buffer_p, const char *format_s, ...)
+{
+	char line_s [1024];
+	bool success_flag = false;
+	int res;
+	va_list args;
+
+	va_start (args, format_s);
+	res = vsnprintf (line_s, sizeof (line_s), format_s, args);
+	va_end (args);
+
+	if ((res >= 0) && (((size_t) res) < sizeof (line_s)))
+		{
+			success_flag = AppendStringToByteBuffer (buffer_p, line_s);
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Metrics line too long for buffer");
+		}
+
+	return success_flag;
+}
+
+
+static void EscapePrometheusLabel (const char *value_s, char *buffer_s, const size_t buffer_size)
+{
+	size_t i = 0;
+
+	while ((*value_s != '\0') && (i + 2 < buffer_size))
+		{
+			const char c = *value_s;
+
+			if ((c == '\\') || (c == '"'))
+				{
+					buffer_s [i ++] = '\\';
+					buffer_s [i ++] = c;
+				}
+			else if (c == '\n')
+				{
+					buffer_s [i ++] = '\\';
+					buffer_s [i ++] = 'n';
+				}
+			else
+				{
+					buffer_s [i ++] = c;
+				}
+
+			++ value_s;
+		}
+
+	buffer_s [i] = '\0';
+}
@@ -0,0 +1,286 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * metrics_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the metrics histograms. Synthetic durations with known
+ *  percentiles are recorded and read back, several threads record into
+ *  the same MetricTimer to check that nothing is lost, and some genuinely
+ *  timed sleeps are checked against their expected durations.
+ *
+ *  Usage: metrics_test [<number of threads> [<calls per thread>]]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "metrics.h"
+#include "memory_allocations.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_THREADS (4)
+
+#define DEFAULT_NUM_CALLS (100000)
+
+#define MAX_NUM_THREADS (64)
+
+
+typedef struct RecordingThread
+{
+	uint32 rt_num_calls;
+
+	double rt_time;
+} RecordingThread;
+
+
+/*
+ * Is the value from the histogram within the precision of the
+ * buckets of the exact value?
+ */
+static bool IsClose (const uint64 value, const uint64 expected)
+{
+	const uint64 tolerance = expected / METRICS_NUM_SUB_BUCKETS + 1;
+
+	return (value + tolerance >= expected) && (value <= expected + tolerance);
+}
+
+
+static void TestPercentiles (void)
+{
+	MetricTimer *timer_p;
+	uint64 i;
+
+	/* Uniform from 1 to 10000 so the nth percentile is 100 * n */
+	for (i = 1; i <= 10000; ++ i)
+		{
+			RecordMetricDuration ("test", "uniform", i, (i % 100) != 0);
+		}
+
+	timer_p = GetMetricTimer ("test", "uniform");
+
+	Check (timer_p != NULL, "get timer");
+
+	if (timer_p)
+		{
+			Check (timer_p -> mt_count == 10000, "count the calls");
+			Check (timer_p -> mt_num_errors == 100, "count the errors");
+			Check (timer_p -> mt_max == 10000, "record the maximum");
+			Check (timer_p -> mt_sum == 50005000, "record the sum");
+			Check (IsClose (GetMetricTimerPercentile (timer_p, 50.0), 5000), "get the median");
+			Check (IsClose (GetMetricTimerPercentile (timer_p, 90.0), 9000), "get the 90th percentile");
+			Check (IsClose (GetMetricTimerPercentile (timer_p, 99.0), 9900), "get the 99th percentile");
+			Check (IsClose (GetMetricTimerPercentile (timer_p, 100.0), 10000), "get the 100th percentile");
+			Check (GetMetricTimerPercentile (timer_p, 0.0) == 1, "get the minimum");
+		}
+
+	/* A long tail: 990 fast calls and 10 slow ones */
+	for (i = 0; i < 1000; ++ i)
+		{
+			RecordMetricDuration ("test", "tail", (i < 990) ? 200 : 2000000, true);
+		}
+
+	timer_p = GetMetricTimer ("test", "tail");
+
+	if (timer_p)
+		{
+			Check (IsClose (GetMetricTimerPercentile (timer_p, 50.0), 200), "get the median with a long tail");
+			Check (IsClose (GetMetricTimerPercentile (timer_p, 99.0), 200), "keep the 99th percentile below the tail");
+			Check (IsClose (GetMetricTimerPercentile (timer_p, 99.9), 2000000), "find the tail");
+		}
+
+	/* Small values are exact and huge ones are clamped */
+	RecordMetricDuration ("test", "limits", 0, true);
+	RecordMetricDuration ("test", "limits", METRICS_MAX_VALUE * 4, true);
+	timer_p = GetMetricTimer ("test", "limits");
+
+	if (timer_p)
+		{
+			Check (GetMetricTimerPercentile (timer_p, 50.0) == 0, "record zero exactly");
+			Check (GetMetricTimerPercentile (timer_p, 100.0) == METRICS_MAX_VALUE, "clamp huge values");
+		}
+
+	Check (GetMetricTimerPercentile (GetMetricTimer ("test", "empty"), 50.0) == 0, "handle an empty timer");
+}
+
+
+static void TestTimedCalls (void)
+{
+	MetricTimer *timer_p;
+	uint32 i;
+
+	for (i = 0; i < 5; ++ i)
+		{
+			const uint64 start_time = GetMetricsTime ();
+
+			usleep (20000);
+			RecordMetric ("test", "sleep", start_time, true);
+		}
+
+	timer_p = GetMetricTimer ("test", "sleep");
+
+	if (timer_p)
+		{
+			const uint64 median = GetMetricTimerPercentile (timer_p, 50.0);
+
+			printf ("20 ms sleeps: median %llu us, max %llu us\n", (unsigned long long) median, (unsigned long long) timer_p -> mt_max);
+			Check ((median >= 20000) && (median < 200000), "time real calls");
+		}
+}
+
+
+static void TestTable (void)
+{
+	char label_s [METRICS_LABEL_SIZE * 2];
+	MetricTimer *first_p;
+	uint32 i;
+
+	/* Labels that only differ after the truncation point share a timer */
+	memset (label_s, 'x', sizeof (label_s) - 1);
+	label_s [sizeof (label_s) - 1] = '\0';
+	first_p = GetMetricTimer ("test", label_s);
+	label_s [sizeof (label_s) - 2] = 'y';
+	Check ((first_p != NULL) && (GetMetricTimer ("test", label_s) == first_p), "truncate long labels");
+
+	Check (GetMetricTimer ("test", "a") != GetMetricTimer ("other", "a"), "keep families apart");
+
+	/* Fill the table up and check that the extra calls are counted as dropped */
+	for (i = 0; i < METRICS_MAX_NUM_TIMERS + 10; ++ i)
+		{
+			snprintf (label_s, sizeof (label_s), "label %u", i);
+			RecordMetricDuration ("fill", label_s, 1, true);
+		}
+
+	Check (GetNumberOfDroppedMetrics () > 0, "count dropped calls when the table is full");
+	Check (GetMetricTimer ("test", "uniform") != NULL, "find existing timers when the table is full");
+}
+
+
+static void TestExport (void)
+{
+	json_t *metrics_p = GetMetricsAsJSON ();
+	char *text_s = GetMetricsAsPrometheusText ();
+
+	if (metrics_p)
+		{
+			const json_t *uniform_p = json_object_get (json_object_get (metrics_p, "test"), "uniform");
+
+			Check (json_integer_value (json_object_get (uniform_p, "count")) == 10000, "export the count as JSON");
+			Check (IsClose (json_integer_value (json_object_get (uniform_p, "p99_us")), 9900), "export the percentiles as JSON");
+
+			json_decref (metrics_p);
+		}
+	else
+		{
+			Check (false, "get metrics as JSON");
+		}
+
+	if (text_s)
+		{
+			Check (strstr (text_s, "# TYPE grassroots_test_duration_seconds histogram\n") != NULL, "export the histogram type");
+			Check (strstr (text_s, "grassroots_test_duration_seconds_count{name=\"uniform\"} 10000\n") != NULL, "export the count");
+			Check (strstr (text_s, "grassroots_test_duration_seconds_bucket{name=\"uniform\",le=\"+Inf\"} 10000\n") != NULL, "export the +Inf bucket");
+			Check (strstr (text_s, "grassroots_test_duration_seconds_bucket{name=\"tail\",le=\"0.001\"} 990\n") != NULL, "export the cumulative buckets");
+			Check (strstr (text_s, "grassroots_test_errors_total{name=\"uniform\"} 100\n") != NULL, "export the errors");
+
+			FreeMetricsText (text_s);
+		}
+	else
+		{
+			Check (false, "get metrics as Prometheus text");
+		}
+}
+
+
+static void *RunRecordingThread (void *data_p)
+{
+	RecordingThread *thread_p = (RecordingThread *) data_p;
+	const uint64 start_time = GetMetricsTime ();
+	uint32 i;
+
+	for (i = 0; i < thread_p -> rt_num_calls; ++ i)
+		{
+			RecordMetricDuration ("threads", "shared", 1 + (i % 1000), true);
+		}
+
+	thread_p -> rt_time = (GetMetricsTime () - start_time) / 1.0e6;
+
+	return NULL;
+}
+
+
+static void TestThreads (const uint32 num_threads, const uint32 num_calls)
+{
+	pthread_t threads [MAX_NUM_THREADS];
+	RecordingThread details [MAX_NUM_THREADS];
+	MetricTimer *timer_p;
+	double max_time = 0.0;
+	uint32 i;
+
+	for (i = 0; i < num_threads; ++ i)
+		{
+			details [i].rt_num_calls = num_calls;
+			details [i].rt_time = 0.0;
+
+			pthread_create (threads + i, NULL, RunRecordingThread, details + i);
+		}
+
+	for (i = 0; i < num_threads; ++ i)
+		{
+			pthread_join (threads [i], NULL);
+
+			if (details [i].rt_time > max_time)
+				{
+					max_time = details [i].rt_time;
+				}
+		}
+
+	timer_p = GetMetricTimer ("threads", "shared");
+
+	if (timer_p)
+		{
+			Check (timer_p -> mt_count == ((uint64) num_threads) * num_calls, "count every call from every thread");
+			Check (timer_p -> mt_max == 1000, "record the maximum from every thread");
+		}
+
+	printf ("%u threads, %u calls each: %.4f s, %.1f ns per call\n", num_threads, num_calls, max_time, (max_time * 1.0e9) / num_calls);
+}
+
+
+int main (int argc, char *argv [])
+{
+	uint32 num_threads = (argc > 1) ? (uint32) atoi (argv [1]) : DEFAULT_NUM_THREADS;
+	const uint32 num_calls = (argc > 2) ? (uint32) atoi (argv [2]) : DEFAULT_NUM_CALLS;
+
+	if (num_threads > MAX_NUM_THREADS)
+		{
+			num_threads = MAX_NUM_THREADS;
+		}
+
+	TestPercentiles ();
+	TestTimedCalls ();
+	TestThreads (num_threads, num_calls);
+	TestExport ();
+	TestTable ();
+
+	return GetTestResult ();
+}
@@ -0,0 +1,390 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * node_pool.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+#include "node_pool.h"
+#include "memory_allocations.h"
+#include "streams.h"
+
+
+#ifdef _MSC_VER
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
+
+/** The size classes are multiples of this many bytes */
+#define S_CLASS_GRANULARITY (16)
+
+#define S_NUM_CLASSES (NODE_POOL_MAX_SIZE / S_CLASS_GRANULARITY)
+
+/** The class stored in the header of blocks that came straight from the heap */
+#define S_LARGE_CLASS (S_NUM_CLASSES)
+
+/** The size of each slab that blocks are carved from */
+#define S_SLAB_SIZE (65536)
+
+/** The number of blocks that are moved between a thread's cache and the depot at a time */
+#define S_BATCH_SIZE (128)
+
+/** When a thread caches more than this many blocks of a class, a batch is moved to the depot */
+#define S_MAX_CACHED_BLOCKS (4 * S_BATCH_SIZE)
+
+
+/*
+ * Every block starts with this header. While the block is in use it holds
+ * its size class and while it is free it links the block into a free list.
+ * It is the size of a pointer so the caller's memory stays suitably aligned
+ * for the pointers and doubles that list nodes contain.
+ */
+typedef union PoolBlock
+{
+	size_t pb_class;
+	union PoolBlock *pb_next_p;
+	double pb_align;
+} PoolBlock;
+
+
+typedef struct FreeList
+{
+	PoolBlock *fl_head_p;
+	size_t fl_num_blocks;
+} FreeList;
+
+
+typedef struct Slab
+{
+	struct Slab *sl_next_p;
+	double sl_align;
+} Slab;
+
+
+typedef struct ThreadCache
+{
+	FreeList tc_lists [S_NUM_CLASSES];
+	uint32 tc_release_depth;
+	bool tc_registered_flag;
+} ThreadCache;
+
+
+static THREAD_LOCAL ThreadCache s_cache;
+
+static FreeList s_depot [S_NUM_CLASSES];
+
+static Slab *s_slabs_p = NULL;
+
+
+#ifdef _WIN32
+	static SRWLOCK s_depot_lock = SRWLOCK_INIT;
+	#define LockDepot() AcquireSRWLockExclusive (&s_depot_lock)
+	#define UnlockDepot() ReleaseSRWLockExclusive (&s_depot_lock)
+#else
+	static pthread_mutex_t s_depot_lock = PTHREAD_MUTEX_INITIALIZER;
+	#define LockDepot() pthread_mutex_lock (&s_depot_lock)
+	#define UnlockDepot() pthread_mutex_unlock (&s_depot_lock)
+
+	static pthread_key_t s_cache_key;
+	static pthread_once_t s_cache_key_once = PTHREAD_ONCE_INIT;
+
+	static void CreateCacheKey (void);
+
+	static void ReleaseThreadCache (void *cache_p);
+#endif
+
+
+static bool RefillCache (FreeList *list_p, const size_t class_index);
+
+static void TrimCache (FreeList *list_p, const size_t class_index, const size_t max_num_blocks);
+
+static void RegisterThreadCache (void);
+
+
+void *AllocatePoolNode (const size_t size)
+{
+	PoolBlock *block_p = NULL;
+
+	if (size <= NODE_POOL_MAX_SIZE)
+		{
+			const size_t class_index = (size > 0) ? (size - 1) / S_CLASS_GRANULARITY : 0;
+			FreeList *list_p = s_cache.tc_lists + class_index;
+
+			if ((list_p -> fl_head_p) || RefillCache (list_p, class_index))
+				{
+					block_p = list_p -> fl_head_p;
+					list_p -> fl_head_p = block_p -> pb_next_p;
+					-- (list_p -> fl_num_blocks);
+
+					block_p -> pb_class = class_index;
+				}
+		}
+	else
+		{
+			block_p = (PoolBlock *) AllocMemory (sizeof (PoolBlock) + size);
+
+			if (block_p)
+				{
+					block_p -> pb_class = S_LARGE_CLASS;
+				}
+		}
+
+	return block_p ? block_p + 1 : NULL;
+}
+
+
+void FreePoolNode (void *node_p)
+{
+	if (node_p)
+		{
+			PoolBlock *block_p = ((PoolBlock *) node_p) - 1;
+			const size_t class_index = block_p -> pb_class;
+
+			if (class_index < S_NUM_CLASSES)
+				{
+					FreeList *list_p = s_cache.tc_lists + class_index;
+
+					block_p -> pb_next_p = list_p -> fl_head_p;
+					list_p -> fl_head_p = block_p;
+					++ (list_p -> fl_num_blocks);
+
+					if ((list_p -> fl_num_blocks > S_MAX_CACHED_BLOCKS) && (s_cache.tc_release_depth == 0))
+						{
+							TrimCache (list_p, class_index, S_MAX_CACHED_BLOCKS - S_BATCH_SIZE);
+						}
+				}
+			else
+				{
+					FreeMemory (block_p);
+				}
+		}
+}
+
+
+void BeginPoolNodeRelease (void)
+{
+	++ (s_cache.tc_release_depth);
+}
+
+
+void EndPoolNodeRelease (void)
+{
+	if (s_cache.tc_release_depth > 0)
+		{
+			if (-- (s_cache.tc_release_depth) == 0)
+				{
+					size_t i;
+
+					for (i = 0; i < S_NUM_CLASSES; ++ i)
+						{
+							FreeList *list_p = s_cache.tc_lists + i;
+
+							if (list_p -> fl_num_blocks > S_MAX_CACHED_BLOCKS)
+								{
+									TrimCache (list_p, i, S_MAX_CACHED_BLOCKS - S_BATCH_SIZE);
+								}
+						}
+				}
+		}
+}
+
+
+void FlushPoolNodeCache (void)
+{
+	size_t i;
+
+	for (i = 0; i < S_NUM_CLASSES; ++ i)
+		{
+			TrimCache (s_cache.tc_lists + i, i, 0);
+		}
+}
+
+
+void FreeNodePools (void)
+{
+	Slab *slab_p;
+
+	LockDepot ();
+
+	slab_p = s_slabs_p;
+
+	while (slab_p)
+		{
+			Slab *next_p = slab_p -> sl_next_p;
+
+			FreeMemory (slab_p);
+			slab_p = next_p;
+		}
+
+	s_slabs_p = NULL;
+	memset (s_depot, 0, sizeof (s_depot));
+
+	UnlockDepot ();
+
+	memset (s_cache.tc_lists, 0, sizeof (s_cache.tc_lists));
+}
+
+
+/*
+ * Get a batch of blocks for an empty thread cache, either from the depot
+ * or, if that has none, by carving up a new slab.
+ */
+static bool RefillCache (FreeList *list_p, const size_t class_index)
+{
+	FreeList *depot_p = s_depot + class_index;
+
+	if (!s_cache.tc_registered_flag)
+		{
+			RegisterThreadCache ();
+		}
+
+	LockDepot ();
+
+	if (depot_p -> fl_head_p)
+		{
+			PoolBlock *last_p = depot_p -> fl_head_p;
+			size_t n = 1;
+
+			while ((n < S_BATCH_SIZE) && (last_p -> pb_next_p))
+				{
+					last_p = last_p -> pb_next_p;
+					++ n;
+				}
+
+			list_p -> fl_head_p = depot_p -> fl_head_p;
+			list_p -> fl_num_blocks = n;
+
+			depot_p -> fl_head_p = last_p -> pb_next_p;
+			depot_p -> fl_num_blocks -= n;
+
+			last_p -> pb_next_p = NULL;
+		}
+	else
+		{
+			Slab *slab_p = (Slab *) AllocMemory (S_SLAB_SIZE);
+
+			if (slab_p)
+				{
+					const size_t block_size = sizeof (PoolBlock) + ((class_index + 1) * S_CLASS_GRANULARITY);
+					char *block_p = (char *) (slab_p + 1);
+					const char *end_p = ((const char *) slab_p) + S_SLAB_SIZE - block_size;
+					PoolBlock *head_p = NULL;
+					size_t n = 0;
+
+					slab_p -> sl_next_p = s_slabs_p;
+					s_slabs_p = slab_p;
+
+					while (block_p <= end_p)
+						{
+							PoolBlock *pool_block_p = (PoolBlock *) block_p;
+
+							pool_block_p -> pb_next_p = head_p;
+							head_p = pool_block_p;
+
+							block_p += block_size;
+							++ n;
+						}
+
+					list_p -> fl_head_p = head_p;
+					list_p -> fl_num_blocks = n;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate slab for node pool");
+				}
+		}
+
+	UnlockDepot ();
+
+	return (list_p -> fl_head_p != NULL);
+}
+
+
+/*
+ * Move blocks from a thread cache to the depot until the cache has no more
+ * than max_num_blocks left.
+ */
+static void TrimCache (FreeList *list_p, const size_t class_index, const size_t max_num_blocks)
+{
+	if (list_p -> fl_num_blocks > max_num_blocks)
+		{
+			const size_t n = (list_p -> fl_num_blocks) - max_num_blocks;
+			PoolBlock *first_p = list_p -> fl_head_p;
+			PoolBlock *last_p = first_p;
+			FreeList *depot_p = s_depot + class_index;
+			size_t i;
+
+			for (i = 1; i < n; ++ i)
+				{
+					last_p = last_p -> pb_next_p;
+				}
+
+			list_p -> fl_head_p = last_p -> pb_next_p;
+			list_p -> fl_num_blocks = max_num_blocks;
+
+			LockDepot ();
+
+			last_p -> pb_next_p = depot_p -> fl_head_p;
+			depot_p -> fl_head_p = first_p;
+			depot_p -> fl_num_blocks += n;
+
+			UnlockDepot ();
+		}
+}
+
+
+/*
+ * Make sure that the blocks cached by a thread go back to the depot when
+ * the thread exits rather than being lost.
+ */
+static void RegisterThreadCache (void)
+{
+#ifndef _WIN32
+	pthread_once (&s_cache_key_once, CreateCacheKey);
+	pthread_setspecific (s_cache_key, &s_cache);
+#endif
+
+	s_cache.tc_registered_flag = true;
+}
+
+
+#ifndef _WIN32
+
+static void CreateCacheKey (void)
+{
+	pthread_key_create (&s_cache_key, ReleaseThreadCache);
+}
+
+
+static void ReleaseThreadCache (void * UNUSED_PARAM (cache_p))
+{
+	FlushPoolNodeCache ();
+}
+
+#endif
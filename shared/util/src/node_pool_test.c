@@ -0,0 +1,290 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * node_pool_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests and a microbenchmark for the node pool. Large LinkedLists are
+ *  built and freed with nodes from malloc () and from the pool, and then
+ *  a number of threads do the same at once, freeing some of their nodes
+ *  on other threads, to check that no block is ever handed out twice.
+ *
+ *  Usage: node_pool_test [<number of nodes> [<number of threads>]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "node_pool.h"
+#include "linked_list.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_NODES (1000000)
+
+#define DEFAULT_NUM_THREADS (8)
+
+#define NUM_ROUNDS (5)
+
+
+typedef struct TestNode
+{
+	ListItem tn_node;
+	uint32 tn_owner;
+	uint32 tn_value;
+} TestNode;
+
+
+typedef struct ThreadData
+{
+	uint32 td_id;
+	uint32 td_num_nodes;
+	LinkedList td_handoff;
+	bool td_success_flag;
+} ThreadData;
+
+
+static double GetTime (void)
+{
+	struct timespec t;
+
+	clock_gettime (CLOCK_MONOTONIC, &t);
+
+	return t.tv_sec + (t.tv_nsec / 1.0e9);
+}
+
+
+static void FreeHeapNode (ListItem *node_p)
+{
+	free (node_p);
+}
+
+
+static void FreePooledNode (ListItem *node_p)
+{
+	FreePoolNode (node_p);
+}
+
+
+static double BuildAndFreeList (const uint32 num_nodes, void *(*alloc_fn) (size_t), void (*free_fn) (ListItem *node_p))
+{
+	double total = 0.0;
+	int i;
+
+	for (i = 0; i < NUM_ROUNDS; ++ i)
+		{
+			const double start = GetTime ();
+			LinkedList *list_p = AllocateLinkedList (free_fn);
+			uint32 j;
+
+			for (j = 0; j < num_nodes; ++ j)
+				{
+					TestNode *node_p = (TestNode *) alloc_fn (sizeof (TestNode));
+
+					node_p -> tn_node.ln_prev_p = NULL;
+					node_p -> tn_node.ln_next_p = NULL;
+					node_p -> tn_value = j;
+					LinkedListAddTail (list_p, & (node_p -> tn_node));
+				}
+
+			FreeLinkedList (list_p);
+
+			total += GetTime () - start;
+		}
+
+	return total;
+}
+
+
+static void TestPool (void)
+{
+	void *small_p = AllocatePoolNode (1);
+	void *large_p = AllocatePoolNode (NODE_POOL_MAX_SIZE + 1);
+	void *nodes_p [1000];
+	bool success_flag = true;
+	int i;
+
+	Check ((small_p != NULL) && (((size_t) small_p) % sizeof (void *) == 0), "allocate an aligned small node");
+	Check (large_p != NULL, "allocate a node bigger than the pool's limit");
+
+	memset (large_p, 0xFF, NODE_POOL_MAX_SIZE + 1);
+
+	FreePoolNode (small_p);
+	FreePoolNode (large_p);
+	FreePoolNode (NULL);
+
+	for (i = 0; i < 1000; ++ i)
+		{
+			nodes_p [i] = AllocatePoolNode (48);
+			memset (nodes_p [i], i & 0xFF, 48);
+		}
+
+	for (i = 0; i < 1000; ++ i)
+		{
+			const unsigned char *value_p = (const unsigned char *) nodes_p [i];
+			int j;
+
+			for (j = 0; j < 48; ++ j)
+				{
+					if (value_p [j] != (i & 0xFF))
+						{
+							success_flag = false;
+						}
+				}
+
+			FreePoolNode (nodes_p [i]);
+		}
+
+	Check (success_flag, "nodes don't overlap");
+}
+
+
+static void *RunThread (void *data_p)
+{
+	ThreadData *thread_data_p = (ThreadData *) data_p;
+	int i;
+
+	thread_data_p -> td_success_flag = true;
+
+	for (i = 0; i < NUM_ROUNDS; ++ i)
+		{
+			LinkedList *list_p = AllocateLinkedList (FreePooledNode);
+			TestNode *node_p;
+			uint32 j;
+
+			for (j = 0; j < thread_data_p -> td_num_nodes; ++ j)
+				{
+					node_p = (TestNode *) AllocatePoolNode (sizeof (TestNode));
+
+					node_p -> tn_node.ln_prev_p = NULL;
+					node_p -> tn_node.ln_next_p = NULL;
+					node_p -> tn_owner = thread_data_p -> td_id;
+					node_p -> tn_value = j;
+
+					/* Give every tenth node to the main thread to free */
+					if (j % 10 == 0)
+						{
+							LinkedListAddTail (& (thread_data_p -> td_handoff), & (node_p -> tn_node));
+						}
+					else
+						{
+							LinkedListAddTail (list_p, & (node_p -> tn_node));
+						}
+				}
+
+			j = 0;
+			node_p = (TestNode *) (list_p -> ll_head_p);
+
+			while (node_p)
+				{
+					if (j % 10 == 0)
+						{
+							++ j;
+						}
+
+					if ((node_p -> tn_owner != thread_data_p -> td_id) || (node_p -> tn_value != j))
+						{
+							thread_data_p -> td_success_flag = false;
+						}
+
+					++ j;
+					node_p = (TestNode *) (node_p -> tn_node.ln_next_p);
+				}
+
+			FreeLinkedList (list_p);
+		}
+
+	return NULL;
+}
+
+
+static void TestThreads (const uint32 num_nodes, const uint32 num_threads)
+{
+	pthread_t *threads_p = (pthread_t *) calloc (num_threads, sizeof (pthread_t));
+	ThreadData *data_p = (ThreadData *) calloc (num_threads, sizeof (ThreadData));
+
+	if (threads_p && data_p)
+		{
+			bool success_flag = true;
+			double start;
+			uint32 i;
+
+			for (i = 0; i < num_threads; ++ i)
+				{
+					data_p [i].td_id = i;
+					data_p [i].td_num_nodes = num_nodes / num_threads;
+					InitLinkedList (& (data_p [i].td_handoff));
+					SetLinkedListFreeNodeFunction (& (data_p [i].td_handoff), FreePooledNode);
+				}
+
+			start = GetTime ();
+
+			for (i = 0; i < num_threads; ++ i)
+				{
+					pthread_create (threads_p + i, NULL, RunThread, data_p + i);
+				}
+
+			for (i = 0; i < num_threads; ++ i)
+				{
+					pthread_join (threads_p [i], NULL);
+
+					if (!data_p [i].td_success_flag)
+						{
+							success_flag = false;
+						}
+				}
+
+			printf ("%u threads: %.3f s\n", num_threads, GetTime () - start);
+
+			Check (success_flag, "threads never share a node");
+
+			for (i = 0; i < num_threads; ++ i)
+				{
+					ClearLinkedList (& (data_p [i].td_handoff));
+				}
+		}
+
+	free (threads_p);
+	free (data_p);
+}
+
+
+int main (int argc, char *argv [])
+{
+	const uint32 num_nodes = (argc > 1) ? (uint32) atoi (argv [1]) : DEFAULT_NUM_NODES;
+	const uint32 num_threads = (argc > 2) ? (uint32) atoi (argv [2]) : DEFAULT_NUM_THREADS;
+	double heap_time;
+	double pool_time;
+
+	TestPool ();
+
+	heap_time = BuildAndFreeList (num_nodes, malloc, FreeHeapNode);
+	pool_time = BuildAndFreeList (num_nodes, AllocatePoolNode, FreePooledNode);
+
+	printf ("%u nodes x %d rounds: malloc %.3f s, pool %.3f s\n", num_nodes, NUM_ROUNDS, heap_time, pool_time);
+
+	TestThreads (num_nodes, num_threads);
+
+	FlushPoolNodeCache ();
+	FreeNodePools ();
+
+	return GetTestResult ();
+}
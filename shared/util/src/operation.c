@@ -50,7 +50,9 @@ static const char *S_OPERATIONS_SS [OP_NUM_OPERATIONS] =
 	"get_service_results",
 	"get_resource",
 	"get_server_status",
-	"get_service_info"
+	"get_service_info",
+	"get_server_metrics",
+	"run_keyword_services"
 };
 
 
@@ -0,0 +1,341 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * rope_buffer.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <string.h>
+
+#include "rope_buffer.h"
+#include "string_utils.h"
+#include "streams.h"
+
+
+/** The number of fragments that a RopeBuffer initially has room for */
+#define S_INITIAL_NUM_FRAGMENTS (16)
+
+
+static RopeFragment *AddRopeFragment (RopeBuffer *buffer_p);
+
+static void ClearRopeFragment (RopeFragment *fragment_p);
+
+
+RopeBuffer *AllocateRopeBuffer (size_t chunk_size)
+{
+	RopeFragment *fragments_p = (RopeFragment *) AllocMemoryArray (S_INITIAL_NUM_FRAGMENTS, sizeof (RopeFragment));
+
+	if (fragments_p)
+		{
+			RopeBuffer *buffer_p = (RopeBuffer *) AllocMemory (sizeof (RopeBuffer));
+
+			if (buffer_p)
+				{
+					buffer_p -> rb_fragments_p = fragments_p;
+					buffer_p -> rb_num_fragments = 0;
+					buffer_p -> rb_max_num_fragments = S_INITIAL_NUM_FRAGMENTS;
+					buffer_p -> rb_chunk_size = (chunk_size > 0) ? chunk_size : ROPE_BUFFER_DEFAULT_CHUNK_SIZE;
+					buffer_p -> rb_size = 0;
+					buffer_p -> rb_read_fragment = 0;
+					buffer_p -> rb_read_offset = 0;
+
+					return buffer_p;
+				}
+
+			FreeMemory (fragments_p);
+		}
+
+	return NULL;
+}
+
+
+void FreeRopeBuffer (RopeBuffer *buffer_p)
+{
+	size_t i;
+
+	for (i = 0; i < buffer_p -> rb_num_fragments; ++ i)
+		{
+			ClearRopeFragment ((buffer_p -> rb_fragments_p) + i);
+		}
+
+	FreeMemory (buffer_p -> rb_fragments_p);
+	FreeMemory (buffer_p);
+}
+
+
+void ResetRopeBuffer (RopeBuffer *buffer_p)
+{
+	RopeFragment *fragment_p = buffer_p -> rb_fragments_p;
+	const size_t num_fragments = buffer_p -> rb_num_fragments;
+	size_t i = 0;
+
+	/* Keep the first chunk, if there is one, to save reallocating it */
+	if ((num_fragments > 0) && (fragment_p -> rf_capacity > 0))
+		{
+			fragment_p -> rf_length = 0;
+			i = 1;
+		}
+
+	buffer_p -> rb_num_fragments = i;
+
+	for ( ; i < num_fragments; ++ i)
+		{
+			ClearRopeFragment (fragment_p + i);
+		}
+
+	buffer_p -> rb_size = 0;
+	RewindRopeBuffer (buffer_p);
+}
+
+
+bool AppendToRopeBuffer (RopeBuffer *buffer_p, const void *data_p, const size_t data_length)
+{
+	const char *src_p = (const char *) data_p;
+	size_t remaining = data_length;
+	RopeFragment *fragment_p = (buffer_p -> rb_num_fragments > 0) ? (buffer_p -> rb_fragments_p) + (buffer_p -> rb_num_fragments - 1) : NULL;
+
+	while (remaining > 0)
+		{
+			size_t space = fragment_p ? (fragment_p -> rf_capacity) - (fragment_p -> rf_length) : 0;
+
+			if (space == 0)
+				{
+					/* Start a new chunk */
+					char *chunk_p = (char *) AllocMemory (buffer_p -> rb_chunk_size);
+
+					if (!chunk_p)
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate chunk of " SIZET_FMT " bytes for RopeBuffer", buffer_p -> rb_chunk_size);
+							return false;
+						}
+
+					fragment_p = AddRopeFragment (buffer_p);
+
+					if (!fragment_p)
+						{
+							FreeMemory (chunk_p);
+							return false;
+						}
+
+					fragment_p -> rf_data_p = chunk_p;
+					fragment_p -> rf_capacity = buffer_p -> rb_chunk_size;
+					fragment_p -> rf_owned_flag = true;
+
+					space = buffer_p -> rb_chunk_size;
+				}
+
+			if (space > remaining)
+				{
+					space = remaining;
+				}
+
+			memcpy ((fragment_p -> rf_data_p) + (fragment_p -> rf_length), src_p, space);
+			fragment_p -> rf_length += space;
+			buffer_p -> rb_size += space;
+
+			src_p += space;
+			remaining -= space;
+		}
+
+	return true;
+}
+
+
+bool AppendStringToRopeBuffer (RopeBuffer *buffer_p, const char * const value_s)
+{
+	return AppendToRopeBuffer (buffer_p, value_s, strlen (value_s));
+}
+
+
+bool AddFragmentToRopeBuffer (RopeBuffer *buffer_p, char *data_p, const size_t data_length, const MEM_FLAG mem)
+{
+	bool success_flag = false;
+
+	if ((mem == MF_SHADOW_USE) || (mem == MF_SHALLOW_COPY))
+		{
+			RopeFragment *fragment_p = AddRopeFragment (buffer_p);
+
+			if (fragment_p)
+				{
+					fragment_p -> rf_data_p = data_p;
+					fragment_p -> rf_length = data_length;
+
+					/* Nothing can be appended to this fragment */
+					fragment_p -> rf_capacity = 0;
+					fragment_p -> rf_owned_flag = (mem == MF_SHALLOW_COPY);
+
+					buffer_p -> rb_size += data_length;
+					success_flag = true;
+				}
+		}
+	else
+		{
+			success_flag = AppendToRopeBuffer (buffer_p, data_p, data_length);
+		}
+
+	return success_flag;
+}
+
+
+size_t GetRopeBufferSize (const RopeBuffer * const buffer_p)
+{
+	return buffer_p -> rb_size;
+}
+
+
+size_t GetRopeBufferNumFragments (const RopeBuffer * const buffer_p)
+{
+	return buffer_p -> rb_num_fragments;
+}
+
+
+const char *GetRopeBufferFragment (const RopeBuffer * const buffer_p, const size_t index, size_t *length_p)
+{
+	if (index < buffer_p -> rb_num_fragments)
+		{
+			const RopeFragment *fragment_p = (buffer_p -> rb_fragments_p) + index;
+
+			*length_p = fragment_p -> rf_length;
+			return fragment_p -> rf_data_p;
+		}
+
+	*length_p = 0;
+	return NULL;
+}
+
+
+size_t ReadFromRopeBuffer (RopeBuffer *buffer_p, void *dest_p, const size_t max_length)
+{
+	char *out_p = (char *) dest_p;
+	size_t num_copied = 0;
+
+	while ((num_copied < max_length) && (buffer_p -> rb_read_fragment < buffer_p -> rb_num_fragments))
+		{
+			const RopeFragment *fragment_p = (buffer_p -> rb_fragments_p) + (buffer_p -> rb_read_fragment);
+			size_t l = (fragment_p -> rf_length) - (buffer_p -> rb_read_offset);
+
+			if (l > max_length - num_copied)
+				{
+					l = max_length - num_copied;
+				}
+
+			memcpy (out_p + num_copied, (fragment_p -> rf_data_p) + (buffer_p -> rb_read_offset), l);
+			num_copied += l;
+			buffer_p -> rb_read_offset += l;
+
+			if (buffer_p -> rb_read_offset == fragment_p -> rf_length)
+				{
+					++ (buffer_p -> rb_read_fragment);
+					buffer_p -> rb_read_offset = 0;
+				}
+		}
+
+	return num_copied;
+}
+
+
+void RewindRopeBuffer (RopeBuffer *buffer_p)
+{
+	buffer_p -> rb_read_fragment = 0;
+	buffer_p -> rb_read_offset = 0;
+}
+
+
+char *GetRopeBufferAsString (const RopeBuffer * const buffer_p)
+{
+	char *value_s = (char *) AllocMemory ((buffer_p -> rb_size) + 1);
+
+	if (value_s)
+		{
+			char *dest_p = value_s;
+			size_t i;
+
+			for (i = 0; i < buffer_p -> rb_num_fragments; ++ i)
+				{
+					const RopeFragment *fragment_p = (buffer_p -> rb_fragments_p) + i;
+
+					memcpy (dest_p, fragment_p -> rf_data_p, fragment_p -> rf_length);
+					dest_p += fragment_p -> rf_length;
+				}
+
+			*dest_p = '\0';
+		}
+
+	return value_s;
+}
+
+
+int RopeBufferJSONDumpCallback (const char *data_s, size_t size, void *buffer_p)
+{
+	return AppendToRopeBuffer ((RopeBuffer *) buffer_p, data_s, size) ? 0 : -1;
+}
+
+
+bool AppendJSONToRopeBuffer (RopeBuffer *buffer_p, const json_t *json_p, const size_t flags)
+{
+	bool success_flag = false;
+
+	if (json_dump_callback (json_p, RopeBufferJSONDumpCallback, buffer_p, flags) == 0)
+		{
+			success_flag = true;
+		}
+	else
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to serialise JSON to RopeBuffer");
+		}
+
+	return success_flag;
+}
+
+
+static RopeFragment *AddRopeFragment (RopeBuffer *buffer_p)
+{
+	RopeFragment *fragment_p;
+
+	if (buffer_p -> rb_num_fragments == buffer_p -> rb_max_num_fragments)
+		{
+			const size_t new_max = (buffer_p -> rb_max_num_fragments) << 1;
+			RopeFragment *fragments_p = (RopeFragment *) ReallocMemory (buffer_p -> rb_fragments_p, new_max * sizeof (RopeFragment), (buffer_p -> rb_max_num_fragments) * sizeof (RopeFragment));
+
+			if (!fragments_p)
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to increase RopeBuffer to " SIZET_FMT " fragments", new_max);
+					return NULL;
+				}
+
+			buffer_p -> rb_fragments_p = fragments_p;
+			buffer_p -> rb_max_num_fragments = new_max;
+		}
+
+	fragment_p = (buffer_p -> rb_fragments_p) + (buffer_p -> rb_num_fragments);
+	memset (fragment_p, 0, sizeof (RopeFragment));
+	++ (buffer_p -> rb_num_fragments);
+
+	return fragment_p;
+}
+
+
+static void ClearRopeFragment (RopeFragment *fragment_p)
+{
+	if (fragment_p -> rf_owned_flag)
+		{
+			FreeMemory (fragment_p -> rf_data_p);
+		}
+
+	memset (fragment_p, 0, sizeof (RopeFragment));
+}
@@ -0,0 +1,377 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * rope_buffer_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for RopeBuffer along with a benchmark that sends a large JSON
+ *  document over a local socket pair, comparing json_dumps () and send ()
+ *  against serialising into a RopeBuffer and sending it with writev ().
+ *
+ *  Usage: rope_buffer_test [<number of records>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "rope_buffer.h"
+#include "string_utils.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_RECORDS (100000)
+
+#define NUM_ITERATIONS (10)
+
+
+static double GetElapsedSeconds (const struct timespec *start_p)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start_p -> tv_sec) + ((now.tv_nsec - start_p -> tv_nsec) / 1e9);
+}
+
+
+static void TestFragments (void)
+{
+	RopeBuffer *buffer_p = AllocateRopeBuffer (4);
+
+	if (buffer_p)
+		{
+			char borrowed_s [] = "borrowed";
+			char *owned_s = EasyCopyToNewString ("owned");
+			char *value_s;
+			char dest [5];
+			size_t l;
+
+			Check (AppendStringToRopeBuffer (buffer_p, "hello world"), "append across chunks");
+			Check (GetRopeBufferNumFragments (buffer_p) == 3, "append is split into chunks");
+
+			Check (AddFragmentToRopeBuffer (buffer_p, borrowed_s, strlen (borrowed_s), MF_SHADOW_USE), "add borrowed fragment");
+			Check (AddFragmentToRopeBuffer (buffer_p, owned_s, strlen (owned_s), MF_SHALLOW_COPY), "add owned fragment");
+			Check (AppendStringToRopeBuffer (buffer_p, "!"), "append after fragments");
+
+			Check (GetRopeBufferSize (buffer_p) == strlen ("hello worldborrowedowned!"), "size is correct");
+			Check (GetRopeBufferFragment (buffer_p, 3, &l) == borrowed_s, "borrowed fragment isn't copied");
+
+			value_s = GetRopeBufferAsString (buffer_p);
+			Check ((value_s != NULL) && (strcmp (value_s, "hello worldborrowedowned!") == 0), "flattened data is correct");
+
+			if (value_s)
+				{
+					char *read_s = (char *) AllocMemory (GetRopeBufferSize (buffer_p) + 1);
+
+					if (read_s)
+						{
+							size_t total = 0;
+
+							while ((l = ReadFromRopeBuffer (buffer_p, dest, sizeof (dest))) > 0)
+								{
+									memcpy (read_s + total, dest, l);
+									total += l;
+								}
+
+							read_s [total] = '\0';
+							Check (strcmp (read_s, value_s) == 0, "reading in small pieces gets all of the data");
+
+							RewindRopeBuffer (buffer_p);
+							Check (ReadFromRopeBuffer (buffer_p, dest, 5) == 5 && (strncmp (dest, "hello", 5) == 0), "rewind goes back to the start");
+
+							FreeMemory (read_s);
+						}
+
+					FreeCopiedString (value_s);
+				}
+
+			ResetRopeBuffer (buffer_p);
+			Check (GetRopeBufferSize (buffer_p) == 0, "reset empties the buffer");
+			Check (AppendStringToRopeBuffer (buffer_p, "abc") && (GetRopeBufferNumFragments (buffer_p) == 1), "first chunk is reused after reset");
+
+			FreeRopeBuffer (buffer_p);
+		}
+	else
+		{
+			Check (false, "allocate RopeBuffer");
+		}
+}
+
+
+static json_t *GetTestDocument (const int num_records)
+{
+	json_t *records_p = json_array ();
+
+	if (records_p)
+		{
+			int i;
+
+			for (i = 0; i < num_records; ++ i)
+				{
+					json_t *record_p = json_pack ("{s:i,s:s,s:f,s:[i,i,i]}", "id", i, "name", "Triticum aestivum", "score", i * 0.5, "positions", i, i + 1, i + 2);
+
+					if (!record_p || (json_array_append_new (records_p, record_p) != 0))
+						{
+							json_decref (records_p);
+							return NULL;
+						}
+				}
+		}
+
+	return records_p;
+}
+
+
+/* Read and discard everything from the other end of the socket pair */
+static void *DrainSocket (void *data_p)
+{
+	int fd = * ((int *) data_p);
+	char buffer [65536];
+	size_t *total_p = (size_t *) AllocMemory (sizeof (size_t));
+	ssize_t l;
+
+	*total_p = 0;
+
+	while ((l = read (fd, buffer, sizeof (buffer))) > 0)
+		{
+			*total_p += l;
+		}
+
+	return total_p;
+}
+
+
+static bool WriteAll (const int fd, const char *data_p, size_t length)
+{
+	while (length > 0)
+		{
+			ssize_t l = write (fd, data_p, length);
+
+			if (l <= 0)
+				{
+					return false;
+				}
+
+			data_p += l;
+			length -= l;
+		}
+
+	return true;
+}
+
+
+static bool WriteRopeBuffer (const int fd, const RopeBuffer *buffer_p)
+{
+	const size_t num_fragments = GetRopeBufferNumFragments (buffer_p);
+	size_t i = 0;
+
+	while (i < num_fragments)
+		{
+			struct iovec vecs [64];
+			int num_vecs = 0;
+			size_t expected = 0;
+			ssize_t l;
+
+			for ( ; (i < num_fragments) && (num_vecs < 64); ++ i, ++ num_vecs)
+				{
+					vecs [num_vecs].iov_base = (void *) GetRopeBufferFragment (buffer_p, i, & (vecs [num_vecs].iov_len));
+					expected += vecs [num_vecs].iov_len;
+				}
+
+			l = writev (fd, vecs, num_vecs);
+
+			/* Finish any partially-written batch the slow way */
+			if ((l >= 0) && ((size_t) l < expected))
+				{
+					int j;
+					size_t skip = (size_t) l;
+
+					for (j = 0; j < num_vecs; ++ j)
+						{
+							if (skip >= vecs [j].iov_len)
+								{
+									skip -= vecs [j].iov_len;
+								}
+							else
+								{
+									if (!WriteAll (fd, ((const char *) vecs [j].iov_base) + skip, vecs [j].iov_len - skip))
+										{
+											return false;
+										}
+
+									skip = 0;
+								}
+						}
+				}
+			else if (l < 0)
+				{
+					return false;
+				}
+		}
+
+	return true;
+}
+
+
+static void RunBenchmark (const int num_records)
+{
+	json_t *doc_p = GetTestDocument (num_records);
+
+	if (doc_p)
+		{
+			int fds [2];
+
+			if (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) == 0)
+				{
+					pthread_t reader;
+
+					if (pthread_create (&reader, NULL, DrainSocket, & (fds [1])) == 0)
+						{
+							struct timespec start;
+							size_t expected = 0;
+							size_t *total_p = NULL;
+							double dumps_time;
+							double rope_time;
+							bool success_flag = true;
+							int i;
+
+							clock_gettime (CLOCK_MONOTONIC, &start);
+
+							for (i = 0; (i < NUM_ITERATIONS) && success_flag; ++ i)
+								{
+									char *doc_s = json_dumps (doc_p, 0);
+
+									if (doc_s)
+										{
+											expected += strlen (doc_s);
+											success_flag = WriteAll (fds [0], doc_s, strlen (doc_s));
+											free (doc_s);
+										}
+									else
+										{
+											success_flag = false;
+										}
+								}
+
+							dumps_time = GetElapsedSeconds (&start);
+							Check (success_flag, "json_dumps () and send");
+
+							clock_gettime (CLOCK_MONOTONIC, &start);
+
+							for (i = 0; (i < NUM_ITERATIONS) && success_flag; ++ i)
+								{
+									RopeBuffer *buffer_p = AllocateRopeBuffer (0);
+
+									if (buffer_p)
+										{
+											if (AppendJSONToRopeBuffer (buffer_p, doc_p, 0))
+												{
+													expected += GetRopeBufferSize (buffer_p);
+													success_flag = WriteRopeBuffer (fds [0], buffer_p);
+												}
+											else
+												{
+													success_flag = false;
+												}
+
+											FreeRopeBuffer (buffer_p);
+										}
+									else
+										{
+											success_flag = false;
+										}
+								}
+
+							rope_time = GetElapsedSeconds (&start);
+							Check (success_flag, "RopeBuffer and writev");
+
+							shutdown (fds [0], SHUT_WR);
+							pthread_join (reader, (void **) &total_p);
+
+							Check ((total_p != NULL) && (*total_p == expected), "all of the data is received");
+
+							printf ("%d x %d records: json_dumps () %.3f s, RopeBuffer %.3f s\n", NUM_ITERATIONS, num_records, dumps_time, rope_time);
+
+							if (total_p)
+								{
+									FreeMemory (total_p);
+								}
+						}
+
+					close (fds [0]);
+					close (fds [1]);
+				}
+
+			json_decref (doc_p);
+		}
+}
+
+
+static void TestJSONDump (void)
+{
+	json_t *doc_p = GetTestDocument (1000);
+
+	if (doc_p)
+		{
+			RopeBuffer *buffer_p = AllocateRopeBuffer (1024);
+
+			if (buffer_p)
+				{
+					char *expected_s = json_dumps (doc_p, JSON_INDENT (2));
+
+					Check (AppendJSONToRopeBuffer (buffer_p, doc_p, JSON_INDENT (2)), "dump JSON to RopeBuffer");
+
+					if (expected_s)
+						{
+							char *value_s = GetRopeBufferAsString (buffer_p);
+
+							Check ((value_s != NULL) && (strcmp (value_s, expected_s) == 0), "RopeBuffer matches json_dumps ()");
+
+							if (value_s)
+								{
+									FreeCopiedString (value_s);
+								}
+
+							free (expected_s);
+						}
+
+					FreeRopeBuffer (buffer_p);
+				}
+
+			json_decref (doc_p);
+		}
+}
+
+
+int main (int argc, char *argv [])
+{
+	const int num_records = (argc > 1) ? atoi (argv [1]) : DEFAULT_NUM_RECORDS;
+
+	TestFragments ();
+	TestJSONDump ();
+	RunBenchmark (num_records);
+
+	return GetTestResult ();
+}
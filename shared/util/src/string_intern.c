@@ -0,0 +1,256 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * string_intern.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+#include "string_intern.h"
+#include "hash_map.h"
+#include "memory_allocations.h"
+#include "string_utils.h"
+#include "streams.h"
+
+
+/*
+ * An interned string is stored directly after its reference count so
+ * that the handle given to callers can be turned back into its entry
+ * without a lookup.
+ */
+typedef struct InternedString
+{
+	uint32 is_ref_count;
+	char is_value_s [1];
+} InternedString;
+
+
+#define S_INITIAL_POOL_SIZE (1024)
+
+
+#ifdef _WIN32
+	static SRWLOCK s_pool_lock = SRWLOCK_INIT;
+	#define LockPool() AcquireSRWLockExclusive (&s_pool_lock)
+	#define UnlockPool() ReleaseSRWLockExclusive (&s_pool_lock)
+#else
+	static pthread_mutex_t s_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+	#define LockPool() pthread_mutex_lock (&s_pool_lock)
+	#define UnlockPool() pthread_mutex_unlock (&s_pool_lock)
+#endif
+
+
+static HashMap *s_pool_p = NULL;
+
+static StringInternPoolStatistics s_stats;
+
+
+static InternedString *GetInternedStringEntry (const char *interned_s);
+
+static bool CompareInternedKeys (const void *key0_p, const void *key1_p);
+
+static bool InitPool (void);
+
+
+const char *InternString (const char *value_s)
+{
+	const char *interned_s = NULL;
+
+	LockPool ();
+
+	if (InitPool ())
+		{
+			InternedString *entry_p = (InternedString *) GetFromHashMap (s_pool_p, value_s);
+
+			++ (s_stats.sips_num_interns);
+
+			if (entry_p)
+				{
+					++ (entry_p -> is_ref_count);
+					++ (s_stats.sips_num_hits);
+
+					interned_s = entry_p -> is_value_s;
+				}
+			else
+				{
+					const size_t l = strlen (value_s);
+
+					entry_p = (InternedString *) AllocMemory (offsetof (InternedString, is_value_s) + l + 1);
+
+					if (entry_p)
+						{
+							entry_p -> is_ref_count = 1;
+							memcpy (entry_p -> is_value_s, value_s, l + 1);
+
+							if (PutInHashMap (s_pool_p, entry_p -> is_value_s, entry_p))
+								{
+									++ (s_stats.sips_num_strings);
+									++ (s_stats.sips_num_allocations);
+
+									interned_s = entry_p -> is_value_s;
+								}
+							else
+								{
+									PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to add \"%s\" to string pool", value_s);
+									FreeMemory (entry_p);
+								}
+						}
+					else
+						{
+							PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate interned string for \"%s\"", value_s);
+						}
+				}
+
+		}		/* if (InitPool ()) */
+
+	UnlockPool ();
+
+	return interned_s;
+}
+
+
+const char *RetainInternedString (const char *interned_s)
+{
+	InternedString *entry_p = GetInternedStringEntry (interned_s);
+
+	LockPool ();
+
+	++ (entry_p -> is_ref_count);
+	++ (s_stats.sips_num_interns);
+	++ (s_stats.sips_num_hits);
+
+	UnlockPool ();
+
+	return interned_s;
+}
+
+
+void ReleaseInternedString (const char *interned_s)
+{
+	if (interned_s)
+		{
+			InternedString *entry_p = GetInternedStringEntry (interned_s);
+
+			LockPool ();
+
+			if (-- (entry_p -> is_ref_count) == 0)
+				{
+					/* This frees entry_p too */
+					RemoveFromHashMap (s_pool_p, interned_s);
+					-- (s_stats.sips_num_strings);
+				}
+
+			UnlockPool ();
+		}
+}
+
+
+const char *FindInternedString (const char *value_s)
+{
+	const char *interned_s = NULL;
+
+	LockPool ();
+
+	if (s_pool_p)
+		{
+			const InternedString *entry_p = (const InternedString *) GetFromHashMap (s_pool_p, value_s);
+
+			if (entry_p)
+				{
+					interned_s = entry_p -> is_value_s;
+				}
+		}
+
+	UnlockPool ();
+
+	return interned_s;
+}
+
+
+bool IsInternedString (const char *value_s)
+{
+	return ((value_s != NULL) && (FindInternedString (value_s) == value_s));
+}
+
+
+void GetStringInternPoolStatistics (StringInternPoolStatistics *stats_p)
+{
+	LockPool ();
+	*stats_p = s_stats;
+	UnlockPool ();
+}
+
+
+void FreeStringInternPool (void)
+{
+	LockPool ();
+
+	if (s_pool_p)
+		{
+			FreeHashMap (s_pool_p);
+			s_pool_p = NULL;
+		}
+
+	memset (&s_stats, 0, sizeof (s_stats));
+
+	UnlockPool ();
+}
+
+
+static InternedString *GetInternedStringEntry (const char *interned_s)
+{
+	return (InternedString *) (interned_s - offsetof (InternedString, is_value_s));
+}
+
+
+static bool CompareInternedKeys (const void *key0_p, const void *key1_p)
+{
+	return (strcmp ((const char *) key0_p, (const char *) key1_p) == 0);
+}
+
+
+/* This must be called with the pool locked */
+static bool InitPool (void)
+{
+	if (!s_pool_p)
+		{
+			/*
+			 * The keys point into the InternedStrings that are stored as the values
+			 * so the map only needs to free the values.
+			 */
+			s_pool_p = AllocateHashMap (S_INITIAL_POOL_SIZE, 75, HMKT_CUSTOM, MF_SHADOW_USE, MF_SHALLOW_COPY);
+
+			if (s_pool_p)
+				{
+					SetHashMapKeyFunctions (s_pool_p, HashString, CompareInternedKeys, NULL, NULL);
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to allocate string pool");
+				}
+		}
+
+	return (s_pool_p != NULL);
+}
@@ -0,0 +1,181 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * string_intern_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the string interning pool. A number of threads intern
+ *  and release the same set of names at once, after which the pool's
+ *  counters show how many allocations interning saved.
+ *
+ *  Usage: string_intern_test [<number of threads>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "string_intern.h"
+#include "unit_test.h"
+
+
+#define DEFAULT_NUM_THREADS (8)
+
+#define NUM_NAMES (64)
+
+#define NUM_ROUNDS (2000)
+
+
+static char s_names [NUM_NAMES][32];
+
+
+static void TestInterning (void)
+{
+	char name_s [] = "input_file";
+	const char *first_s = InternString (name_s);
+	const char *second_s = InternString ("input_file");
+
+	Check ((first_s != NULL) && (first_s == second_s), "the same value gives the same pointer");
+	Check (first_s != name_s, "the interned string is a copy");
+	Check (IsInternedString (first_s) && !IsInternedString (name_s), "interned strings are recognised");
+	Check (FindInternedString ("input_file") == first_s, "find an interned string");
+	Check (FindInternedString ("output_file") == NULL, "find a string that isn't interned");
+
+	Check (RetainInternedString (first_s) == first_s, "retain an interned string");
+
+	ReleaseInternedString (first_s);
+	ReleaseInternedString (second_s);
+	Check (FindInternedString ("input_file") == first_s, "the string stays while it has references");
+
+	ReleaseInternedString (first_s);
+	Check (FindInternedString ("input_file") == NULL, "the string is freed with its last reference");
+}
+
+
+static void *InternNames (void *data_p)
+{
+	const char **interned_pp = (const char **) data_p;
+	int i;
+	int j;
+
+	for (i = 0; i < NUM_ROUNDS; ++ i)
+		{
+			for (j = 0; j < NUM_NAMES; ++ j)
+				{
+					const char *value_s = InternString (s_names [j]);
+
+					if (value_s)
+						{
+							/*
+							 * Keep the ones from the first round, as a Parameter
+							 * would hold its name, and release the rest
+							 */
+							if (i == 0)
+								{
+									interned_pp [j] = value_s;
+								}
+							else
+								{
+									ReleaseInternedString (value_s);
+								}
+						}
+				}
+		}
+
+	return NULL;
+}
+
+
+static void TestThreads (const int num_threads)
+{
+	pthread_t *threads_p = (pthread_t *) calloc (num_threads, sizeof (pthread_t));
+	const char **interned_pp = (const char **) calloc (num_threads * NUM_NAMES, sizeof (const char *));
+
+	if (threads_p && interned_pp)
+		{
+			StringInternPoolStatistics stats;
+			bool success_flag = true;
+			int i;
+			int j;
+
+			/* Start with empty counters */
+			FreeStringInternPool ();
+
+			for (i = 0; i < NUM_NAMES; ++ i)
+				{
+					sprintf (s_names [i], "parameter_name_%d", i);
+				}
+
+			for (i = 0; i < num_threads; ++ i)
+				{
+					pthread_create (threads_p + i, NULL, InternNames, interned_pp + (i * NUM_NAMES));
+				}
+
+			for (i = 0; i < num_threads; ++ i)
+				{
+					pthread_join (threads_p [i], NULL);
+				}
+
+			for (j = 0; j < NUM_NAMES; ++ j)
+				{
+					for (i = 0; i < num_threads; ++ i)
+						{
+							const char *value_s = interned_pp [(i * NUM_NAMES) + j];
+
+							if ((value_s != interned_pp [j]) || (strcmp (value_s, s_names [j]) != 0))
+								{
+									success_flag = false;
+								}
+						}
+				}
+
+			Check (success_flag, "every thread gets the same pointers");
+
+			GetStringInternPoolStatistics (&stats);
+			Check (stats.sips_num_strings == NUM_NAMES, "the pool holds one copy of each name");
+			Check (stats.sips_num_allocations == NUM_NAMES, "each name is only allocated once");
+
+			printf ("%d threads: %llu interns, %llu reused, %llu allocations\n", num_threads,
+				(unsigned long long) stats.sips_num_interns, (unsigned long long) stats.sips_num_hits, (unsigned long long) stats.sips_num_allocations);
+
+			for (i = 0; i < num_threads * NUM_NAMES; ++ i)
+				{
+					ReleaseInternedString (interned_pp [i]);
+				}
+
+			GetStringInternPoolStatistics (&stats);
+			Check (stats.sips_num_strings == 0, "all of the names are freed once released");
+		}
+
+	free (threads_p);
+	free (interned_pp);
+}
+
+
+int main (int argc, char *argv [])
+{
+	const int num_threads = (argc > 1) ? atoi (argv [1]) : DEFAULT_NUM_THREADS;
+
+	TestInterning ();
+	TestThreads (num_threads);
+
+	FreeStringInternPool ();
+
+	return GetTestResult ();
+}
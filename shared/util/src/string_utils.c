@@ -1023,6 +1023,66 @@ char *ConcatenateVarargsStrings (const char *value_s, ...)
 }
 
 
+char *CopyToArenaString (MemoryArena *arena_p, const char * const src_s)
+{
+	const size_t l = strlen (src_s) + 1;
+	char *dest_s = (char *) AllocateFromMemoryArena (arena_p, l);
+
+	if (dest_s)
+		{
+			memcpy (dest_s, src_s, l);
+		}
+
+	return dest_s;
+}
+
+
+char *ConcatenateVarargsStringsInArena (MemoryArena *arena_p, const char *value_s, ...)
+{
+	char *result_s = NULL;
+	const char *arg_s = value_s;
+	size_t l = 1;
+	va_list args;
+
+	/* Get the total length first so that only one allocation is needed */
+	va_start (args, value_s);
+
+	while (arg_s)
+		{
+			l += strlen (arg_s);
+			arg_s = va_arg (args, const char *);
+		}
+
+	va_end (args);
+
+	result_s = (char *) AllocateFromMemoryArena (arena_p, l);
+
+	if (result_s)
+		{
+			char *dest_p = result_s;
+
+			va_start (args, value_s);
+			arg_s = value_s;
+
+			while (arg_s)
+				{
+					const size_t arg_length = strlen (arg_s);
+
+					memcpy (dest_p, arg_s, arg_length);
+					dest_p += arg_length;
+
+					arg_s = va_arg (args, const char *);
+				}
+
+			va_end (args);
+
+			*dest_p = '\0';
+		}
+
+	return result_s;
+}
+
+
 char *GetFileContentsAsString (FILE *input_f)
 {
 	char *data_s = NULL;
@@ -0,0 +1,678 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * tracing.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tracing.h"
+#include "metrics.h"
+#include "memory_allocations.h"
+#include "streams.h"
+
+
+#ifdef _MSC_VER
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
+
+#ifdef _WIN32
+	#include <windows.h>
+
+	#define INCREMENT_COUNTER(x) ((uint64) InterlockedIncrement64 ((LONG64 volatile *) (x)))
+
+	#define LOCK_TRACE_FILE() (AcquireSRWLockExclusive (&s_trace_lock))
+	#define UNLOCK_TRACE_FILE() (ReleaseSRWLockExclusive (&s_trace_lock))
+#else
+	#include <pthread.h>
+
+	#define INCREMENT_COUNTER(x) (__atomic_add_fetch ((x), 1, __ATOMIC_RELAXED))
+
+	#define LOCK_TRACE_FILE() (pthread_mutex_lock (&s_trace_lock))
+	#define UNLOCK_TRACE_FILE() (pthread_mutex_unlock (&s_trace_lock))
+#endif
+
+
+/* The OTLP status codes */
+#define S_STATUS_OK (1)
+#define S_STATUS_ERROR (2)
+
+
+/* The instrumentation scope that every Span is written under */
+static const char * const S_SCOPE_NAME_S = "grassroots";
+
+static const char * const S_LINE_END_S = "]}]}]}\n";
+
+/* The longest time, in microseconds, that written Spans are buffered for */
+static const uint64 S_FLUSH_INTERVAL = 1000000;
+
+
+/*
+ * s_trace_f, s_line_start_s and s_last_flush_time are only changed or
+ * written through whilst s_trace_lock is held, so that ExitTracing ()
+ * can't close the file underneath a thread that is writing a Span.
+ */
+#ifdef _WIN32
+	static SRWLOCK s_trace_lock = SRWLOCK_INIT;
+#else
+	static pthread_mutex_t s_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static FILE *s_trace_f = NULL;
+
+static uint64 s_last_flush_time = 0;
+
+/*
+ * Everything in each line before the Span itself, i.e. the resource
+ * and scope, which is the same for every Span.
+ */
+static char *s_line_start_s = NULL;
+
+static size_t s_line_start_length = 0;
+
+static uint64 s_num_seeds = 0;
+
+static THREAD_LOCAL TraceContext s_current_context;
+
+static THREAD_LOCAL uint64 s_random_state = 0;
+
+
+
+static uint64 GetNextRandomValue (void);
+
+static void GenerateId (uint8 *id_p, const size_t size);
+
+static uint64 GetWallClockTime (void);
+
+static void ConvertIdToHex (const uint8 *id_p, const size_t size, char *buffer_s);
+
+static bool ConvertHexToId (const char *hex_s, uint8 *id_p, const size_t size);
+
+static bool IsIdValid (const uint8 *id_p, const size_t size);
+
+static char *GetLineStart (const char *service_name_s);
+
+static json_t *GetSpanAsJSON (const char *name_s, const SpanKind kind, const TraceContext *context_p, const TraceContext *parent_context_p, const uint64 start_time, const uint64 end_time, json_t *attributes_p, const bool success_flag);
+
+static bool SetTimeValue (json_t *json_p, const char *key_s, const uint64 value);
+
+static void WriteSpan (json_t *span_p);
+
+
+
+bool InitTracing (const char *filename_s, const char *service_name_s)
+{
+	char *line_start_s;
+
+	ExitTracing ();
+
+	line_start_s = GetLineStart (service_name_s);
+
+	if (line_start_s)
+		{
+			FILE *trace_f = fopen (filename_s, "a");
+
+			if (trace_f)
+				{
+					LOCK_TRACE_FILE ();
+
+					s_line_start_s = line_start_s;
+					s_line_start_length = strlen (line_start_s);
+					s_last_flush_time = GetMetricsTime ();
+					s_trace_f = trace_f;
+
+					UNLOCK_TRACE_FILE ();
+
+					return true;
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to open \"%s\" to write traces to", filename_s);
+				}
+
+			FreeMemory (line_start_s);
+		}
+
+	return false;
+}
+
+
+void ExitTracing (void)
+{
+	FILE *trace_f;
+	char *line_start_s;
+
+	LOCK_TRACE_FILE ();
+
+	trace_f = s_trace_f;
+	line_start_s = s_line_start_s;
+
+	s_trace_f = NULL;
+	s_line_start_s = NULL;
+	s_line_start_length = 0;
+
+	UNLOCK_TRACE_FILE ();
+
+	if (trace_f)
+		{
+			fclose (trace_f);
+		}
+
+	if (line_start_s)
+		{
+			FreeMemory (line_start_s);
+		}
+}
+
+
+bool IsTracingEnabled (void)
+{
+	return (s_trace_f != NULL);
+}
+
+
+Span *StartSpan (const char *name_s, const SpanKind kind)
+{
+	Span *span_p = NULL;
+
+	if (s_trace_f)
+		{
+			span_p = (Span *) AllocMemory (sizeof (Span));
+
+			if (span_p)
+				{
+					strncpy (span_p -> sp_name_s, name_s, SPAN_NAME_SIZE - 1);
+					span_p -> sp_name_s [SPAN_NAME_SIZE - 1] = '\0';
+					span_p -> sp_kind = kind;
+					span_p -> sp_parent_context = s_current_context;
+					span_p -> sp_attributes_p = NULL;
+
+					if (s_current_context.tc_valid_flag)
+						{
+							memcpy (span_p -> sp_context.tc_trace_id, s_current_context.tc_trace_id, TRACE_ID_SIZE);
+						}
+					else
+						{
+							GenerateId (span_p -> sp_context.tc_trace_id, TRACE_ID_SIZE);
+						}
+
+					GenerateId (span_p -> sp_context.tc_span_id, SPAN_ID_SIZE);
+					span_p -> sp_context.tc_valid_flag = true;
+
+					s_current_context = span_p -> sp_context;
+
+					span_p -> sp_start_time = GetWallClockTime ();
+				}
+			else
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to allocate span \"%s\"", name_s);
+				}
+
+		}		/* if (s_trace_f) */
+
+	return span_p;
+}
+
+
+bool AddSpanAttribute (Span *span_p, const char *key_s, const char *value_s)
+{
+	bool success_flag = true;
+
+	if (span_p && value_s)
+		{
+			json_t *attribute_p = json_pack ("{s:s,s:{s:s}}", "key", key_s, "value", "stringValue", value_s);
+
+			success_flag = false;
+
+			if (attribute_p)
+				{
+					if (!span_p -> sp_attributes_p)
+						{
+							span_p -> sp_attributes_p = json_array ();
+						}
+
+					if ((span_p -> sp_attributes_p) && (json_array_append_new (span_p -> sp_attributes_p, attribute_p) == 0))
+						{
+							success_flag = true;
+						}
+					else
+						{
+							json_decref (attribute_p);
+						}
+				}
+
+			if (!success_flag)
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to add attribute \"%s\" to span \"%s\"", key_s, span_p -> sp_name_s);
+				}
+
+		}		/* if (span_p && value_s) */
+
+	return success_flag;
+}
+
+
+void EndSpan (Span *span_p, const bool success_flag)
+{
+	if (span_p)
+		{
+			if (s_trace_f)
+				{
+					json_t *span_json_p = GetSpanAsJSON (span_p -> sp_name_s, span_p -> sp_kind, & (span_p -> sp_context), & (span_p -> sp_parent_context), span_p -> sp_start_time, GetWallClockTime (), span_p -> sp_attributes_p, success_flag);
+
+					if (span_json_p)
+						{
+							WriteSpan (span_json_p);
+							json_decref (span_json_p);
+						}
+				}
+
+			s_current_context = span_p -> sp_parent_context;
+
+			if (span_p -> sp_attributes_p)
+				{
+					json_decref (span_p -> sp_attributes_p);
+				}
+
+			FreeMemory (span_p);
+		}		/* if (span_p) */
+}
+
+
+void RecordCompletedSpan (const char *name_s, const SpanKind kind, const uint64 start_time, const bool success_flag)
+{
+	if (s_trace_f)
+		{
+			TraceContext context;
+			const uint64 end_time = GetWallClockTime ();
+			const uint64 now = GetMetricsTime ();
+			const uint64 duration = (now > start_time) ? (now - start_time) * 1000 : 0;
+			json_t *span_json_p;
+
+			if (s_current_context.tc_valid_flag)
+				{
+					memcpy (context.tc_trace_id, s_current_context.tc_trace_id, TRACE_ID_SIZE);
+				}
+			else
+				{
+					GenerateId (context.tc_trace_id, TRACE_ID_SIZE);
+				}
+
+			GenerateId (context.tc_span_id, SPAN_ID_SIZE);
+			context.tc_valid_flag = true;
+
+			span_json_p = GetSpanAsJSON (name_s, kind, &context, &s_current_context, (end_time > duration) ? end_time - duration : 0, end_time, NULL, success_flag);
+
+			if (span_json_p)
+				{
+					WriteSpan (span_json_p);
+					json_decref (span_json_p);
+				}
+
+		}		/* if (s_trace_f) */
+}
+
+
+bool GetTraceParent (char *buffer_s)
+{
+	if (s_current_context.tc_valid_flag)
+		{
+			memcpy (buffer_s, "00-", 3);
+			ConvertIdToHex (s_current_context.tc_trace_id, TRACE_ID_SIZE, buffer_s + 3);
+			buffer_s [3 + 2 * TRACE_ID_SIZE] = '-';
+			ConvertIdToHex (s_current_context.tc_span_id, SPAN_ID_SIZE, buffer_s + 4 + 2 * TRACE_ID_SIZE);
+			strcpy (buffer_s + 4 + 2 * (TRACE_ID_SIZE + SPAN_ID_SIZE), "-01");
+
+			return true;
+		}
+
+	return false;
+}
+
+
+bool SetTraceParent (const char *traceparent_s)
+{
+	bool success_flag = true;
+
+	memset (&s_current_context, 0, sizeof (s_current_context));
+
+	if (traceparent_s)
+		{
+			const size_t trace_id_offset = 3;
+			const size_t span_id_offset = trace_id_offset + 2 * TRACE_ID_SIZE + 1;
+			const size_t flags_offset = span_id_offset + 2 * SPAN_ID_SIZE + 1;
+			const size_t length = strlen (traceparent_s);
+
+			success_flag = false;
+
+			/*
+			 * version "-" trace-id "-" parent-id "-" trace-flags, where version
+			 * "ff" is forbidden and later versions may append further fields.
+			 */
+			if ((length >= flags_offset + 2) && (traceparent_s [2] == '-') && (traceparent_s [span_id_offset - 1] == '-') && (traceparent_s [flags_offset - 1] == '-')
+					&& (strncmp (traceparent_s, "ff", 2) != 0))
+				{
+					const bool valid_length_flag = (strncmp (traceparent_s, "00", 2) == 0) ? (length == flags_offset + 2) : ((length == flags_offset + 2) || (traceparent_s [flags_offset + 2] == '-'));
+
+					if (valid_length_flag)
+						{
+							uint8 version;
+							uint8 flags;
+
+							if (ConvertHexToId (traceparent_s, &version, 1) && ConvertHexToId (traceparent_s + flags_offset, &flags, 1)
+									&& ConvertHexToId (traceparent_s + trace_id_offset, s_current_context.tc_trace_id, TRACE_ID_SIZE)
+									&& ConvertHexToId (traceparent_s + span_id_offset, s_current_context.tc_span_id, SPAN_ID_SIZE)
+									&& IsIdValid (s_current_context.tc_trace_id, TRACE_ID_SIZE) && IsIdValid (s_current_context.tc_span_id, SPAN_ID_SIZE))
+								{
+									s_current_context.tc_valid_flag = true;
+									success_flag = true;
+								}
+							else
+								{
+									memset (&s_current_context, 0, sizeof (s_current_context));
+								}
+						}
+				}
+
+			if (!success_flag)
+				{
+					PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Ignoring invalid traceparent \"%s\"", traceparent_s);
+				}
+
+		}		/* if (traceparent_s) */
+
+	return success_flag;
+}
+
+
+/*
+ * splitmix64, seeded separately for each thread
+ */
+static uint64 GetNextRandomValue (void)
+{
+	uint64 z;
+
+	if (s_random_state == 0)
+		{
+			s_random_state = GetWallClockTime () ^ (GetMetricsTime () << 20) ^ ((uint64) (size_t) &s_random_state) ^ (INCREMENT_COUNTER (&s_num_seeds) * 0x9E3779B97F4A7C15ULL);
+		}
+
+	z = (s_random_state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+	return z ^ (z >> 31);
+}
+
+
+static void GenerateId (uint8 *id_p, const size_t size)
+{
+	do
+		{
+			size_t i;
+
+			for (i = 0; i < size; i += sizeof (uint64))
+				{
+					const uint64 value = GetNextRandomValue ();
+					const size_t num_bytes = (size - i < sizeof (uint64)) ? size - i : sizeof (uint64);
+
+					memcpy (id_p + i, &value, num_bytes);
+				}
+		}
+	while (!IsIdValid (id_p, size));
+}
+
+
+static uint64 GetWallClockTime (void)
+{
+#ifdef _WIN32
+	FILETIME t;
+	ULARGE_INTEGER value;
+
+	/* 100ns intervals since 1601 */
+	GetSystemTimePreciseAsFileTime (&t);
+	value.LowPart = t.dwLowDateTime;
+	value.HighPart = t.dwHighDateTime;
+
+	return (value.QuadPart - 116444736000000000ULL) * 100;
+#else
+	struct timespec t;
+
+	clock_gettime (CLOCK_REALTIME, &t);
+
+	return ((uint64) t.tv_sec) * 1000000000 + ((uint64) t.tv_nsec);
+#endif
+}
+
+
+static void ConvertIdToHex (const uint8 *id_p, const size_t size, char *buffer_s)
+{
+	static const char * const hex_digits_s = "0123456789abcdef";
+	size_t i;
+
+	for (i = 0; i < size; ++ i)
+		{
+			*buffer_s = hex_digits_s [id_p [i] >> 4];
+			++ buffer_s;
+			*buffer_s = hex_digits_s [id_p [i] & 0xF];
+			++ buffer_s;
+		}
+
+	*buffer_s = '\0';
+}
+
+
+/*
+ * W3C trace context only allows lower case hex digits
+ */
+static bool ConvertHexToId (const char *hex_s, uint8 *id_p, const size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < 2 * size; ++ i)
+		{
+			const char c = hex_s [i];
+			uint8 value;
+
+			if ((c >= '0') && (c <= '9'))
+				{
+					value = (uint8) (c - '0');
+				}
+			else if ((c >= 'a') && (c <= 'f'))
+				{
+					value = (uint8) (c - 'a' + 10);
+				}
+			else
+				{
+					return false;
+				}
+
+			if (i & 1)
+				{
+					id_p [i / 2] |= value;
+				}
+			else
+				{
+					id_p [i / 2] = (uint8) (value << 4);
+				}
+		}
+
+	return true;
+}
+
+
+/*
+ * Ids of all zeroes are invalid
+ */
+static bool IsIdValid (const uint8 *id_p, const size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; ++ i)
+		{
+			if (id_p [i] != 0)
+				{
+					return true;
+				}
+		}
+
+	return false;
+}
+
+
+static char *GetLineStart (const char *service_name_s)
+{
+	char *line_start_s = NULL;
+	json_t *resource_p = json_pack ("{s:[{s:s,s:{s:s}}]}", "attributes", "key", "service.name", "value", "stringValue", service_name_s ? service_name_s : S_SCOPE_NAME_S);
+
+	if (resource_p)
+		{
+			char *resource_s = json_dumps (resource_p, JSON_COMPACT | JSON_PRESERVE_ORDER);
+
+			if (resource_s)
+				{
+					static const char * const prefix_s = "{\"resourceSpans\":[{\"resource\":";
+					static const char * const scope_s = ",\"scopeSpans\":[{\"scope\":{\"name\":\"";
+					static const char * const spans_s = "\"},\"spans\":[";
+					const size_t length = strlen (prefix_s) + strlen (resource_s) + strlen (scope_s) + strlen (S_SCOPE_NAME_S) + strlen (spans_s);
+
+					line_start_s = (char *) AllocMemory (length + 1);
+
+					if (line_start_s)
+						{
+							snprintf (line_start_s, length + 1, "%s%s%s%s%s", prefix_s, resource_s, scope_s, S_SCOPE_NAME_S, spans_s);
+						}
+
+					free (resource_s);
+				}
+
+			json_decref (resource_p);
+		}		/* if (resource_p) */
+
+	if (!line_start_s)
+		{
+			PrintErrors (STM_LEVEL_SEVERE, __FILE__, __LINE__, "Failed to create trace resource for \"%s\"", service_name_s ? service_name_s : S_SCOPE_NAME_S);
+		}
+
+	return line_start_s;
+}
+
+
+static json_t *GetSpanAsJSON (const char *name_s, const SpanKind kind, const TraceContext *context_p, const TraceContext *parent_context_p, const uint64 start_time, const uint64 end_time, json_t *attributes_p, const bool success_flag)
+{
+	char trace_id_s [2 * TRACE_ID_SIZE + 1];
+	char span_id_s [2 * SPAN_ID_SIZE + 1];
+	json_t *span_p;
+
+	ConvertIdToHex (context_p -> tc_trace_id, TRACE_ID_SIZE, trace_id_s);
+	ConvertIdToHex (context_p -> tc_span_id, SPAN_ID_SIZE, span_id_s);
+
+	span_p = json_pack ("{s:s,s:s,s:s,s:i}", "traceId", trace_id_s, "spanId", span_id_s, "name", name_s, "kind", (int) kind);
+
+	if (span_p)
+		{
+			bool valid_flag = true;
+
+			if (parent_context_p -> tc_valid_flag)
+				{
+					char parent_id_s [2 * SPAN_ID_SIZE + 1];
+
+					ConvertIdToHex (parent_context_p -> tc_span_id, SPAN_ID_SIZE, parent_id_s);
+
+					if (json_object_set_new (span_p, "parentSpanId", json_string (parent_id_s)) != 0)
+						{
+							valid_flag = false;
+						}
+				}
+
+			/* OTLP/JSON writes 64-bit integers as strings */
+			if (valid_flag && SetTimeValue (span_p, "startTimeUnixNano", start_time) && SetTimeValue (span_p, "endTimeUnixNano", end_time))
+				{
+					if ((!attributes_p) || (json_object_set (span_p, "attributes", attributes_p) == 0))
+						{
+							if (json_object_set_new (span_p, "status", json_pack ("{s:i}", "code", success_flag ? S_STATUS_OK : S_STATUS_ERROR)) == 0)
+								{
+									return span_p;
+								}
+						}
+				}
+
+			json_decref (span_p);
+		}		/* if (span_p) */
+
+	PrintErrors (STM_LEVEL_WARNING, __FILE__, __LINE__, "Failed to create JSON for span \"%s\"", name_s);
+
+	return NULL;
+}
+
+
+static bool SetTimeValue (json_t *json_p, const char *key_s, const uint64 value)
+{
+	char value_s [32];
+
+	snprintf (value_s, sizeof (value_s), "%llu", (unsigned long long) value);
+
+	return (json_object_set_new (json_p, key_s, json_string (value_s)) == 0);
+}
+
+
+/*
+ * The Span is serialised before the lock is taken so the lock only
+ * covers copying the line into the FILE's buffer. Rather than flushing
+ * after every Span, which would make each request wait on a write to
+ * disk, the file is flushed at most once every S_FLUSH_INTERVAL so that
+ * the traces from running Servers can still be followed.
+ */
+static void WriteSpan (json_t *span_p)
+{
+	char *span_s = json_dumps (span_p, JSON_COMPACT | JSON_PRESERVE_ORDER);
+
+	if (span_s)
+		{
+			const size_t span_length = strlen (span_s);
+			const uint64 now = GetMetricsTime ();
+
+			LOCK_TRACE_FILE ();
+
+			/* Tracing may have been stopped since the Span was started */
+			if (s_trace_f)
+				{
+					fwrite (s_line_start_s, 1, s_line_start_length, s_trace_f);
+					fwrite (span_s, 1, span_length, s_trace_f);
+					fputs (S_LINE_END_S, s_trace_f);
+
+					if (now >= s_last_flush_time + S_FLUSH_INTERVAL)
+						{
+							fflush (s_trace_f);
+							s_last_flush_time = now;
+						}
+				}
+
+			UNLOCK_TRACE_FILE ();
+
+			/* This was allocated by jansson */
+			free (span_s);
+		}		/* if (span_s) */
+}
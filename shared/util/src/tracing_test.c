@@ -0,0 +1,389 @@
+/*
+** Copyright 2014-2018 The Earlham Institute
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+/*
+ * tracing_test.c
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ *
+ *  Tests for the tracing Spans. A request is traced through nested Spans,
+ *  a remote call is passed to a second thread standing in for a paired
+ *  Server via its traceparent value, and the written file is then parsed
+ *  back to check the parent links and that everything shares one trace.
+ *  Tracing is also stopped whilst other threads are still writing Spans.
+ *
+ *  Usage: tracing_test
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "jansson.h"
+
+#include "tracing.h"
+#include "metrics.h"
+#include "unit_test.h"
+
+
+#define MAX_NUM_SPANS (16)
+
+#define NUM_WRITER_THREADS (4)
+
+#define NUM_WRITER_SPANS (20000)
+
+
+typedef struct WrittenSpan
+{
+	char ws_name_s [SPAN_NAME_SIZE];
+
+	char ws_trace_id_s [2 * TRACE_ID_SIZE + 1];
+
+	char ws_span_id_s [2 * SPAN_ID_SIZE + 1];
+
+	char ws_parent_id_s [2 * SPAN_ID_SIZE + 1];
+
+	int ws_kind;
+
+	int ws_status;
+
+	unsigned long long ws_start_time;
+
+	unsigned long long ws_end_time;
+
+	char ws_service_name_s [64];
+} WrittenSpan;
+
+
+static void CopyJSONString (const json_t *json_p, const char *key_s, char *buffer_s, const size_t buffer_size)
+{
+	const char *value_s = json_string_value (json_object_get (json_p, key_s));
+
+	snprintf (buffer_s, buffer_size, "%s", value_s ? value_s : "");
+}
+
+
+static uint32 ReadSpans (const char *filename_s, WrittenSpan *spans_p)
+{
+	uint32 num_spans = 0;
+	FILE *in_f = fopen (filename_s, "r");
+
+	if (in_f)
+		{
+			char line_s [4096];
+
+			while ((num_spans < MAX_NUM_SPANS) && fgets (line_s, sizeof (line_s), in_f))
+				{
+					json_error_t error;
+					json_t *line_p = json_loads (line_s, 0, &error);
+
+					if (line_p)
+						{
+							/* One ExportTraceServiceRequest per line */
+							const json_t *resource_spans_p = json_array_get (json_object_get (line_p, "resourceSpans"), 0);
+							const json_t *resource_attribute_p = json_array_get (json_object_get (json_object_get (resource_spans_p, "resource"), "attributes"), 0);
+							const json_t *scope_spans_p = json_array_get (json_object_get (resource_spans_p, "scopeSpans"), 0);
+							const json_t *span_p = json_array_get (json_object_get (scope_spans_p, "spans"), 0);
+
+							if (span_p)
+								{
+									WrittenSpan *written_span_p = spans_p + num_spans;
+
+									CopyJSONString (span_p, "name", written_span_p -> ws_name_s, sizeof (written_span_p -> ws_name_s));
+									CopyJSONString (span_p, "traceId", written_span_p -> ws_trace_id_s, sizeof (written_span_p -> ws_trace_id_s));
+									CopyJSONString (span_p, "spanId", written_span_p -> ws_span_id_s, sizeof (written_span_p -> ws_span_id_s));
+									CopyJSONString (span_p, "parentSpanId", written_span_p -> ws_parent_id_s, sizeof (written_span_p -> ws_parent_id_s));
+									CopyJSONString (json_object_get (resource_attribute_p, "value"), "stringValue", written_span_p -> ws_service_name_s, sizeof (written_span_p -> ws_service_name_s));
+
+									written_span_p -> ws_kind = (int) json_integer_value (json_object_get (span_p, "kind"));
+									written_span_p -> ws_status = (int) json_integer_value (json_object_get (json_object_get (span_p, "status"), "code"));
+									written_span_p -> ws_start_time = strtoull (json_string_value (json_object_get (span_p, "startTimeUnixNano")), NULL, 10);
+									written_span_p -> ws_end_time = strtoull (json_string_value (json_object_get (span_p, "endTimeUnixNano")), NULL, 10);
+
+									++ num_spans;
+								}
+
+							json_decref (line_p);
+						}
+					else
+						{
+							Check (false, "write every span as valid JSON");
+						}
+				}
+
+			fclose (in_f);
+		}
+
+	return num_spans;
+}
+
+
+static const WrittenSpan *FindSpan (const WrittenSpan *spans_p, const uint32 num_spans, const char *name_s)
+{
+	uint32 i;
+
+	for (i = 0; i < num_spans; ++ i)
+		{
+			if (strcmp (spans_p [i].ws_name_s, name_s) == 0)
+				{
+					return spans_p + i;
+				}
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Stand in for a paired Server that receives the traceparent
+ * value in a request and handles it on its own thread.
+ */
+static void *RunPairedServer (void *data_p)
+{
+	const char *traceparent_s = (const char *) data_p;
+	Span *span_p;
+
+	SetTraceParent (traceparent_s);
+
+	span_p = StartSpan ("paired request", SK_SERVER);
+	EndSpan (span_p, true);
+
+	SetTraceParent (NULL);
+
+	return NULL;
+}
+
+
+/*
+ * Keep writing Spans so that tracing is stopped part way through.
+ */
+static void *RunSpanWriter (void * UNUSED_PARAM (data_p))
+{
+	int i;
+
+	for (i = 0; i < NUM_WRITER_SPANS; ++ i)
+		{
+			Span *span_p = StartSpan ("writer", SK_INTERNAL);
+
+			AddSpanAttribute (span_p, "grassroots.iteration", "value");
+			EndSpan (span_p, true);
+		}
+
+	return NULL;
+}
+
+
+/*
+ * Every line that was written must be complete.
+ */
+static bool AreLinesComplete (const char *filename_s, uint32 *num_lines_p)
+{
+	bool complete_flag = false;
+	FILE *in_f = fopen (filename_s, "r");
+
+	*num_lines_p = 0;
+
+	if (in_f)
+		{
+			char line_s [2048];
+
+			complete_flag = true;
+
+			while (fgets (line_s, sizeof (line_s), in_f))
+				{
+					const size_t length = strlen (line_s);
+
+					if ((length < 7) || (strcmp (line_s + length - 7, "]}]}]}\n") != 0))
+						{
+							complete_flag = false;
+						}
+
+					++ (*num_lines_p);
+				}
+
+			fclose (in_f);
+		}
+
+	return complete_flag;
+}
+
+
+static void TestExitWhilstWriting (const char *filename_s)
+{
+	FILE *out_f = fopen (filename_s, "w");
+
+	/* Start from an empty file */
+	if (out_f)
+		{
+			fclose (out_f);
+		}
+
+	if (InitTracing (filename_s, "test server"))
+		{
+			pthread_t writers [NUM_WRITER_THREADS];
+			uint32 num_lines;
+			int i;
+
+			for (i = 0; i < NUM_WRITER_THREADS; ++ i)
+				{
+					pthread_create (writers + i, NULL, RunSpanWriter, NULL);
+				}
+
+			usleep (20000);
+			ExitTracing ();
+
+			for (i = 0; i < NUM_WRITER_THREADS; ++ i)
+				{
+					pthread_join (writers [i], NULL);
+				}
+
+			Check (!IsTracingEnabled (), "stop tracing whilst other threads are writing spans");
+			Check (AreLinesComplete (filename_s, &num_lines) && (num_lines > 0), "write only complete lines up to the point that tracing stopped");
+		}
+	else
+		{
+			Check (false, "start tracing for concurrent writers");
+		}
+}
+
+
+static void TestTraceParent (void)
+{
+	char buffer_s [TRACE_PARENT_BUFFER_SIZE];
+	const char *valid_s = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01";
+
+	Check (SetTraceParent (valid_s), "accept a valid traceparent");
+	Check (GetTraceParent (buffer_s) && (strcmp (buffer_s, valid_s) == 0), "write back the same traceparent");
+
+	Check (!SetTraceParent ("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7"), "reject a short traceparent");
+	Check (!GetTraceParent (buffer_s), "clear the context for an invalid traceparent");
+	Check (!SetTraceParent ("00-00000000000000000000000000000000-00f067aa0ba902b7-01"), "reject an all zero trace id");
+	Check (!SetTraceParent ("00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01"), "reject upper case hex");
+	Check (!SetTraceParent ("ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"), "reject version ff");
+	Check (!SetTraceParent ("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-extra"), "reject extra fields for version 00");
+	Check (SetTraceParent ("01-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-extra"), "accept extra fields for later versions");
+
+	Check (SetTraceParent (NULL) && !GetTraceParent (buffer_s), "clear the context");
+}
+
+
+static void TestSpans (const char *filename_s)
+{
+	WrittenSpan spans [MAX_NUM_SPANS];
+	char buffer_s [TRACE_PARENT_BUFFER_SIZE];
+	Span *request_p;
+	uint32 num_spans;
+
+	Check (!IsTracingEnabled () && (StartSpan ("ignored", SK_INTERNAL) == NULL), "do nothing until tracing is started");
+	Check (InitTracing (filename_s, "test server"), "start tracing");
+
+	request_p = StartSpan ("request", SK_SERVER);
+	Check (request_p != NULL, "start a span");
+
+	if (request_p)
+		{
+			Span *service_p = StartSpan ("run service", SK_INTERNAL);
+			Span *remote_p;
+			pthread_t paired_server;
+			const uint64 start_time = GetMetricsTime ();
+
+			AddSpanAttribute (service_p, "grassroots.service", "BLAST");
+
+			usleep (1000);
+			RecordCompletedSpan ("mongodb fields.find", SK_CLIENT, start_time, false);
+
+			remote_p = StartSpan ("remote call", SK_CLIENT);
+			Check (GetTraceParent (buffer_s), "get the traceparent for a remote call");
+
+			pthread_create (&paired_server, NULL, RunPairedServer, buffer_s);
+			pthread_join (paired_server, NULL);
+
+			EndSpan (remote_p, true);
+			EndSpan (service_p, true);
+			EndSpan (request_p, true);
+		}
+
+	Check (!GetTraceParent (buffer_s), "restore the empty context once every span has ended");
+
+	ExitTracing ();
+
+	num_spans = ReadSpans (filename_s, spans);
+	Check (num_spans == 5, "write every span");
+
+	if (num_spans == 5)
+		{
+			const WrittenSpan *request_span_p = FindSpan (spans, num_spans, "request");
+			const WrittenSpan *service_span_p = FindSpan (spans, num_spans, "run service");
+			const WrittenSpan *db_span_p = FindSpan (spans, num_spans, "mongodb fields.find");
+			const WrittenSpan *remote_span_p = FindSpan (spans, num_spans, "remote call");
+			const WrittenSpan *paired_span_p = FindSpan (spans, num_spans, "paired request");
+
+			if (request_span_p && service_span_p && db_span_p && remote_span_p && paired_span_p)
+				{
+					uint32 i;
+					bool same_trace_flag = true;
+
+					for (i = 1; i < num_spans; ++ i)
+						{
+							if (strcmp (spans [i].ws_trace_id_s, spans [0].ws_trace_id_s) != 0)
+								{
+									same_trace_flag = false;
+								}
+						}
+
+					Check (same_trace_flag, "share one trace id across the local and paired spans");
+					Check (* (request_span_p -> ws_parent_id_s) == '\0', "write the request as the root span");
+					Check (strcmp (service_span_p -> ws_parent_id_s, request_span_p -> ws_span_id_s) == 0, "nest the service run in the request");
+					Check (strcmp (db_span_p -> ws_parent_id_s, service_span_p -> ws_span_id_s) == 0, "nest the database call in the service run");
+					Check (strcmp (remote_span_p -> ws_parent_id_s, service_span_p -> ws_span_id_s) == 0, "nest the remote call in the service run");
+					Check (strcmp (paired_span_p -> ws_parent_id_s, remote_span_p -> ws_span_id_s) == 0, "continue the trace on the paired server");
+					Check ((request_span_p -> ws_kind == SK_SERVER) && (remote_span_p -> ws_kind == SK_CLIENT), "write the span kinds");
+					Check ((db_span_p -> ws_status == 2) && (request_span_p -> ws_status == 1), "write the span statuses");
+					Check (db_span_p -> ws_end_time - db_span_p -> ws_start_time >= 1000000, "time completed spans");
+					Check ((request_span_p -> ws_start_time <= service_span_p -> ws_start_time) && (request_span_p -> ws_end_time >= service_span_p -> ws_end_time), "contain the child spans within their parents");
+					Check (strcmp (request_span_p -> ws_service_name_s, "test server") == 0, "write the service name");
+				}
+			else
+				{
+					Check (false, "find every span");
+				}
+		}
+}
+
+
+int main (int UNUSED_PARAM (argc), char ** UNUSED_PARAM (argv))
+{
+	char filename_s [] = "/tmp/tracing_testXXXXXX";
+	const int fd = mkstemp (filename_s);
+
+	if (fd == -1)
+		{
+			puts ("FAILED: couldn't create temporary file");
+			return 1;
+		}
+
+	close (fd);
+
+	TestTraceParent ();
+	TestSpans (filename_s);
+	TestExitWhilstWriting (filename_s);
+
+	unlink (filename_s);
+
+	return GetTestResult ();
+}